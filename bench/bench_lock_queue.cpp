@@ -0,0 +1,53 @@
+// bench_lock_queue.cpp
+// LockQueue 微基准：单线程 Push + Pop 往返、多线程争用 (每个线程先 Push 再 Pop)、
+// 有界队列，以及 PushBatch 摊薄加锁
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "util.h"
+
+static void BM_LockQueuePushPop(benchmark::State &state) {
+    LockQueue<int> queue;
+    int out = 0;
+    for (auto _ : state) {
+        queue.Push(1);
+        queue.Pop(out);
+    }
+    benchmark::DoNotOptimize(out);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LockQueuePushPop);
+
+// 所有线程共享一个队列；每次 Pop 之前本线程都 Push 过，不会永久阻塞
+static void BM_LockQueueContended(benchmark::State &state) {
+    static LockQueue<int> *queue = nullptr;
+    if (state.thread_index() == 0) queue = new LockQueue<int>(static_cast<size_t>(state.range(0)));
+    int out = 0;
+    for (auto _ : state) {
+        queue->Push(1);
+        queue->Pop(out);
+    }
+    benchmark::DoNotOptimize(out);
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        delete queue;
+        queue = nullptr;
+    }
+}
+// 参数为容量：0 无界；8 为有界队列 (每次 Pop 额外通知 m_not_full)
+BENCHMARK(BM_LockQueueContended)->Arg(0)->Arg(8)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+
+static void BM_LockQueuePushBatch(benchmark::State &state) {
+    LockQueue<int> queue;
+    const int batch = static_cast<int>(state.range(0));
+    int out = 0;
+    for (auto _ : state) {
+        std::vector<int> items(static_cast<size_t>(batch), 1);
+        queue.PushBatch(std::move(items));
+        for (int i = 0; i < batch; ++i) queue.Pop(out);
+    }
+    benchmark::DoNotOptimize(out);
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_LockQueuePushBatch)->Arg(1)->Arg(16)->Arg(128);
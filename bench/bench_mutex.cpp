@@ -0,0 +1,109 @@
+// bench_mutex.cpp
+// 锁原语争用微基准：1 ~ 8 个线程争用同一把锁 (空临界区 / 短临界区)，比较 std::mutex、Mutex、Spinlock、
+// CASLock、AdaptiveMutex；读多写少的元数据读取比较 RWMutex 读锁与 SeqLock (另有一个写者线程持续更新)
+// (FiberMutex 依赖调度器，见 bench_runtime.cpp)
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "mutex.h"
+
+struct StdMutex {
+    typedef monsoon::ScopedLockImpl<StdMutex> Lock;
+    void lock() { mutex.lock(); }
+    void unlock() { mutex.unlock(); }
+    std::mutex mutex;
+};
+
+// 参数为临界区内的 pause 次数 (0 为空临界区)
+template <class MutexT>
+static void BM_LockContended(benchmark::State &state) {
+    static MutexT mutex;
+    static int64_t counter = 0;
+    const int64_t work = state.range(0);
+    for (auto _ : state) {
+        typename MutexT::Lock lock(mutex);
+        ++counter;
+        for (int64_t i = 0; i < work; ++i) monsoon::CpuRelax();
+    }
+    benchmark::DoNotOptimize(counter);
+    state.SetItemsProcessed(state.iterations());
+}
+
+#define LOCK_BENCHMARK(type) \
+    BENCHMARK_TEMPLATE(BM_LockContended, type)->Arg(0)->Arg(50)->ThreadRange(1, 8)->UseRealTime()
+
+LOCK_BENCHMARK(StdMutex);
+LOCK_BENCHMARK(monsoon::Mutex);
+LOCK_BENCHMARK(monsoon::Spinlock);
+LOCK_BENCHMARK(monsoon::CASLock);
+LOCK_BENCHMARK(monsoon::AdaptiveMutex);
+
+struct RaftMeta {
+    uint64_t term;
+    int32_t leader_id;
+    uint64_t commit_index;
+};
+
+// 读者线程读取 {term, leader_id, commit_index}；第 0 个线程额外启动一个每 10us 更新一次的写者
+template <class Reader>
+static void RunMetaReaders(benchmark::State &state, Reader &&read, std::function<void(uint64_t)> write) {
+    static std::atomic<bool> stop{false};
+    static std::thread *writer = nullptr;
+    if (state.thread_index() == 0) {
+        stop = false;
+        writer = new std::thread([write]() {
+            uint64_t term = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                write(++term);
+                std::this_thread::sleep_for(std::chrono::microseconds(10));
+            }
+        });
+    }
+    uint64_t sum = 0;
+    for (auto _ : state) {
+        sum += read().term;
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        stop = true;
+        writer->join();
+        delete writer;
+        writer = nullptr;
+    }
+}
+
+static void BM_MetaReadRWMutex(benchmark::State &state) {
+    static monsoon::RWMutex mutex;
+    static RaftMeta meta{};
+    RunMetaReaders(state,
+        []() {
+            monsoon::RWMutex::ReadLock lock(mutex);
+            return meta;
+        },
+        [](uint64_t term) {
+            monsoon::RWMutex::WriteLock lock(mutex);
+            meta.term = term;
+            meta.commit_index = term;
+        });
+}
+BENCHMARK(BM_MetaReadRWMutex)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_MetaReadSeqLock(benchmark::State &state) {
+    static monsoon::SeqLock<RaftMeta> meta;
+    RunMetaReaders(state,
+        []() { return meta.load(); },
+        [](uint64_t term) {
+            meta.update([term](RaftMeta &m) {
+                m.term = term;
+                m.commit_index = term;
+            });
+        });
+}
+BENCHMARK(BM_MetaReadSeqLock)->ThreadRange(1, 8)->UseRealTime();
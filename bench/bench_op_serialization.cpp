@@ -0,0 +1,70 @@
+// bench_op_serialization.cpp
+// Op 编解码微基准：紧凑二进制编码 / 零拷贝解码 (OpView) / boost text_oarchive，value 长度 16B ~ 4KB
+// (test/common_test/bench_op_codec.cpp 是不依赖 Google Benchmark 的冒烟版本)
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "util.h"
+
+static Op MakeOp(size_t value_size) {
+    Op op;
+    op.Operation = "Put";
+    op.Key = "user:00012345";
+    op.Value = std::string(value_size, 'v');
+    op.ClientId = "4242";
+    op.RequestId = 100;
+    return op;
+}
+
+static void BM_OpEncodeBinary(benchmark::State &state) {
+    Op op = MakeOp(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        ++op.RequestId;
+        std::string out = op.asString();
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(op.asString().size()));
+}
+BENCHMARK(BM_OpEncodeBinary)->Arg(16)->Arg(256)->Arg(4096);
+
+static void BM_OpDecodeBinary(benchmark::State &state) {
+    std::string payload = MakeOp(static_cast<size_t>(state.range(0))).asString();
+    Op out;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(out.parseFromString(payload));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(payload.size()));
+}
+BENCHMARK(BM_OpDecodeBinary)->Arg(16)->Arg(256)->Arg(4096);
+
+// apply 路径：只解出指向 payload 的 string_view，不拷贝 key / value
+static void BM_OpDecodeView(benchmark::State &state) {
+    std::string payload = MakeOp(static_cast<size_t>(state.range(0))).asString();
+    for (auto _ : state) {
+        OpView view;
+        benchmark::DoNotOptimize(DecodeOpView(payload, &view));
+        benchmark::DoNotOptimize(view.Value.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(payload.size()));
+}
+BENCHMARK(BM_OpDecodeView)->Arg(16)->Arg(256)->Arg(4096);
+
+static void BM_OpEncodeBoost(benchmark::State &state) {
+    Op op = MakeOp(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        ++op.RequestId;
+        std::string out = op.asBoostString();
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(BM_OpEncodeBoost)->Arg(16)->Arg(256)->Arg(4096);
+
+static void BM_OpDecodeBoost(benchmark::State &state) {
+    std::string payload = MakeOp(static_cast<size_t>(state.range(0))).asBoostString();
+    Op out;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(out.parseFromBoostString(payload));
+    }
+}
+BENCHMARK(BM_OpDecodeBoost)->Arg(16)->Arg(256)->Arg(4096);
@@ -0,0 +1,98 @@
+// bench_rpc_framing.cpp
+// RPC 帧编解码微基准：[Varint32: header_size] + [RpcHeader] + [Args]
+// 编码与 RpcConnection::SendRequest 相同 (整帧一次序列化进复用的缓冲区)，解码走 RpcProvider::PeekRequest
+#include <benchmark/benchmark.h>
+#include <muduo/net/Buffer.h>
+
+#include <cstring>
+#include <string>
+
+#include "google/protobuf/io/coded_stream.h"
+#include "rpcheader.pb.h"
+#include "rpcprovider.h"
+
+// 暴露 RpcProvider 的 PeekRequest (同 test_rpc_protocol.cpp)
+class RpcFramingBench : public RpcProvider {
+ public:
+    using RequestFrame = RpcProvider::RequestFrame;
+
+    explicit RpcFramingBench(const Config &c) : RpcProvider(c) {}
+
+    bool Peek(muduo::net::Buffer *buffer, RequestFrame &frame) { return PeekRequest(buffer, frame); }
+};
+
+// 编码一帧到 out (容量跨调用复用)
+static void EncodeFrame(uint64_t request_id, const std::string &args, std::string *out) {
+    RPC::RpcHeader header;
+    header.set_service_name("raftRpc");
+    header.set_method_name("AppendEntries");
+    header.set_args_size(args.size());
+    header.set_request_id(request_id);
+    size_t header_size = header.ByteSizeLong();
+    size_t varint_size = google::protobuf::io::CodedOutputStream::VarintSize32(static_cast<uint32_t>(header_size));
+    out->resize(varint_size + header_size + args.size());
+    uint8_t *p = reinterpret_cast<uint8_t *>(&(*out)[0]);
+    p = google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(static_cast<uint32_t>(header_size), p);
+    header.SerializeToArray(p, static_cast<int>(header_size));
+    p += header_size;
+    std::memcpy(p, args.data(), args.size());
+}
+
+static void BM_RpcFrameEncode(benchmark::State &state) {
+    std::string args(static_cast<size_t>(state.range(0)), 'a');
+    std::string frame;
+    uint64_t request_id = 0;
+    for (auto _ : state) {
+        EncodeFrame(++request_id, args, &frame);
+        benchmark::DoNotOptimize(frame.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(frame.size()));
+}
+BENCHMARK(BM_RpcFrameEncode)->Arg(64)->Arg(1024)->Arg(16384);
+
+// 每轮把一帧写入读缓冲区 (模拟收包) 再解析、消费
+static void BM_RpcFramePeek(benchmark::State &state) {
+    RpcProvider::Config config;
+    config.port = 1234;
+    RpcFramingBench provider(config);
+    std::string args(static_cast<size_t>(state.range(0)), 'a');
+    std::string frame;
+    EncodeFrame(1, args, &frame);
+    muduo::net::Buffer buffer;
+    RpcFramingBench::RequestFrame parsed;
+    for (auto _ : state) {
+        buffer.append(frame.data(), frame.size());
+        if (!provider.Peek(&buffer, parsed)) {
+            state.SkipWithError("PeekRequest failed");
+            break;
+        }
+        benchmark::DoNotOptimize(parsed.args_data);
+        buffer.retrieve(parsed.frame_size);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(frame.size()));
+}
+BENCHMARK(BM_RpcFramePeek)->Arg(64)->Arg(1024)->Arg(16384);
+
+// 一次收到多帧 (粘包)：OnMessage 循环里连续 Peek
+static void BM_RpcFramePeekCoalesced(benchmark::State &state) {
+    const int kFrames = 32;
+    RpcProvider::Config config;
+    config.port = 1234;
+    RpcFramingBench provider(config);
+    std::string args(static_cast<size_t>(state.range(0)), 'a');
+    std::string frame;
+    EncodeFrame(1, args, &frame);
+    std::string burst;
+    for (int i = 0; i < kFrames; ++i) burst += frame;
+    muduo::net::Buffer buffer;
+    RpcFramingBench::RequestFrame parsed;
+    for (auto _ : state) {
+        buffer.append(burst.data(), burst.size());
+        while (provider.Peek(&buffer, parsed)) {
+            benchmark::DoNotOptimize(parsed.args_data);
+            buffer.retrieve(parsed.frame_size);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kFrames);
+}
+BENCHMARK(BM_RpcFramePeekCoalesced)->Arg(64)->Arg(1024);
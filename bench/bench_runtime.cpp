@@ -0,0 +1,128 @@
+// bench_runtime.cpp
+// 协程运行时微基准：Fiber resume / yield 往返、调度器外部提交与调度线程内派生、TimerManager 添加 / 取消、
+// 调度线程上的协程争用 FiberMutex 与 Mutex
+// (test/runtime_test/bench_fiber_switch.cpp、bench_scheduler.cpp 是对应的独立版本)
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "fiber.h"
+#include "mutex.h"
+#include "scheduler.h"
+#include "timer.h"
+
+// 每轮 resume + yield 是两次切换
+static void BM_FiberSwitch(benchmark::State &state) {
+    monsoon::Fiber::GetThis();  // 初始化线程主协程
+    bool stop = false;
+    monsoon::Fiber::ptr fiber(new monsoon::Fiber([&stop]() {
+        while (!stop) monsoon::Fiber::GetThis()->yield();
+    }, 0, false));
+    fiber->resume();  // 预热：触发栈的缺页
+    for (auto _ : state) {
+        fiber->resume();
+    }
+    stop = true;
+    fiber->resume();
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_FiberSwitch);
+
+static void WaitDone(const std::atomic<int64_t> &done, int64_t expected) {
+    while (done.load(std::memory_order_acquire) < expected) std::this_thread::yield();
+}
+
+// 调度器外的线程提交短任务 (走信箱分散到各线程)；参数为调度线程数
+static void BM_SchedulerExternalSubmit(benchmark::State &state) {
+    monsoon::Scheduler sc(static_cast<size_t>(state.range(0)), false, "bench_external");
+    sc.start();
+    std::atomic<int64_t> done{0};
+    int64_t submitted = 0;
+    for (auto _ : state) {
+        sc.schedule([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+        ++submitted;
+    }
+    WaitDone(done, submitted);
+    sc.stop();
+    state.SetItemsProcessed(submitted);
+}
+BENCHMARK(BM_SchedulerExternalSubmit)->Arg(1)->Arg(4)->UseRealTime();
+
+// 调度线程内的根任务派生子任务 (进入本线程的窃取队列，其余线程靠窃取分担)；每轮派生 1000 个
+static void BM_SchedulerSpawnAndSteal(benchmark::State &state) {
+    const int64_t kBatch = 1000;
+    monsoon::Scheduler sc(static_cast<size_t>(state.range(0)), false, "bench_steal");
+    sc.start();
+    std::atomic<int64_t> done{0};
+    int64_t expected = 0;
+    for (auto _ : state) {
+        expected += kBatch;
+        sc.schedule([&done, kBatch]() {
+            monsoon::Scheduler *self = monsoon::Scheduler::GetThisScheduler();
+            for (int64_t i = 0; i < kBatch; ++i) {
+                self->schedule([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+            }
+        });
+        WaitDone(done, expected);
+    }
+    sc.stop();
+    state.SetItemsProcessed(expected);
+}
+BENCHMARK(BM_SchedulerSpawnAndSteal)->Arg(1)->Arg(4)->UseRealTime();
+
+class BenchTimerManager : public monsoon::TimerManager {
+ protected:
+    void OnTimerInsertedAtFront() override {}
+};
+
+// 添加后立即取消 (RPC 超时定时器的典型生命周期)；参数为常驻的其他定时器数
+static void BM_TimerAddCancel(benchmark::State &state) {
+    BenchTimerManager manager;
+    std::vector<monsoon::Timer::ptr> resident;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        resident.push_back(manager.addTimer(60000 + static_cast<uint64_t>(i % 1000), []() {}));
+    }
+    for (auto _ : state) {
+        monsoon::Timer::ptr timer = manager.addTimer(1000, []() {});
+        benchmark::DoNotOptimize(timer->cancel());
+    }
+    for (auto &t : resident) t->cancel();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TimerAddCancel)->Arg(0)->Arg(10000);
+
+// 每轮向调度器提交 kTasks 个协程，每个协程加锁 kIters 次 (临界区内 50 次 pause)；参数为调度线程数。
+// Mutex 竞争时挂起整个调度线程，FiberMutex 只挂起协程，调度线程转去运行其他协程
+template <class MutexT>
+static void BM_SchedulerLockContended(benchmark::State &state) {
+    const int64_t kTasks = 64;
+    const int64_t kIters = 100;
+    monsoon::Scheduler sc(static_cast<size_t>(state.range(0)), false, "bench_lock");
+    sc.start();
+    MutexT mutex;
+    int64_t counter = 0;
+    std::atomic<int64_t> done{0};
+    int64_t expected = 0;
+    for (auto _ : state) {
+        expected += kTasks;
+        for (int64_t t = 0; t < kTasks; ++t) {
+            sc.schedule([&]() {
+                for (int64_t i = 0; i < kIters; ++i) {
+                    typename MutexT::Lock lock(mutex);
+                    ++counter;
+                    for (int spin = 0; spin < 50; ++spin) monsoon::CpuRelax();
+                }
+                done.fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+        WaitDone(done, expected);
+    }
+    sc.stop();
+    benchmark::DoNotOptimize(counter);
+    state.SetItemsProcessed(expected * kIters);
+}
+BENCHMARK_TEMPLATE(BM_SchedulerLockContended, monsoon::Mutex)->Arg(1)->Arg(4)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_SchedulerLockContended, monsoon::FiberMutex)->Arg(1)->Arg(4)->UseRealTime();
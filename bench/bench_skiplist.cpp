@@ -0,0 +1,111 @@
+// bench_skiplist.cpp
+// SkipList 微基准：插入 / 点查 / 范围扫描，1 / 4 / 8 线程
+// 规模从 1M key 起按 10 倍递增，上限由环境变量 BENCH_SKIPLIST_MAX_KEYS 决定 (默认 1M；100M 约需 20GB 内存)
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "skipList.h"
+
+using StringSkipList = SkipList<std::string, std::string>;
+
+static const int kMaxLevel = 24;  // 足够 2^24 以上的规模保持 O(log n)
+static const size_t kValueSize = 100;
+
+static std::string KeyOf(uint64_t i) {
+    char buf[24];
+    std::snprintf(buf, sizeof(buf), "key%016llu", static_cast<unsigned long long>(i));
+    return buf;
+}
+
+static int64_t MaxKeys() {
+    const char *env = std::getenv("BENCH_SKIPLIST_MAX_KEYS");
+    int64_t n = env ? std::atoll(env) : 0;
+    return n > 0 ? n : 1000000;
+}
+
+static void KeyCounts(benchmark::internal::Benchmark *b) {
+    // 上限小于 1M 时只跑这一个规模 (调试用)
+    for (int64_t n = std::min<int64_t>(1000000, MaxKeys()); n <= MaxKeys(); n *= 10) b->Arg(n);
+}
+
+// 每种规模只装载一次，各基准 (以及多线程的各线程) 共享
+static StringSkipList *Populated(int64_t n) {
+    static std::mutex mutex;
+    static std::map<int64_t, std::unique_ptr<StringSkipList>> lists;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &list = lists[n];
+    if (!list) {
+        list.reset(new StringSkipList(kMaxLevel));
+        std::string value(kValueSize, 'v');
+        for (int64_t i = 0; i < n; ++i) list->insert_element(KeyOf(static_cast<uint64_t>(i)), value);
+    }
+    return list.get();
+}
+
+static uint64_t NextRandom(uint64_t &state) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
+}
+
+// 在 n 个 key 的表里插入新 key (与已有 key 交错)，结束后删掉，共享的表保持原样
+static void BM_SkipListInsert(benchmark::State &state) {
+    StringSkipList *list = Populated(state.range(0));
+    std::string value(kValueSize, 'v');
+    std::vector<std::string> inserted;
+    uint64_t rng = 0x9E3779B97F4A7C15ULL * (static_cast<uint64_t>(state.thread_index()) + 1);
+    uint64_t seq = 0;
+    for (auto _ : state) {
+        // 在随机的已有 key 后面加后缀：新 key 落在表中的随机位置
+        std::string key = KeyOf(NextRandom(rng) % static_cast<uint64_t>(state.range(0)));
+        key += '#';
+        key += std::to_string(state.thread_index());
+        key += ':';
+        key += std::to_string(seq++);
+        benchmark::DoNotOptimize(list->insert_element(key, value));
+        inserted.push_back(std::move(key));
+    }
+    for (const std::string &key : inserted) list->delete_element(key);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SkipListInsert)->Apply(KeyCounts)->Threads(1)->Threads(4)->Threads(8)->UseRealTime();
+
+static void BM_SkipListSearch(benchmark::State &state) {
+    StringSkipList *list = Populated(state.range(0));
+    uint64_t rng = 0x9E3779B97F4A7C15ULL * (static_cast<uint64_t>(state.thread_index()) + 1);
+    std::vector<std::string> keys;
+    for (int i = 0; i < 4096; ++i) keys.push_back(KeyOf(NextRandom(rng) % static_cast<uint64_t>(state.range(0))));
+    std::string value;
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(list->search_element(keys[i++ & 4095], value));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SkipListSearch)->Apply(KeyCounts)->Threads(1)->Threads(4)->Threads(8)->UseRealTime();
+
+// 从随机位置扫描 100 条
+static void BM_SkipListScan(benchmark::State &state) {
+    StringSkipList *list = Populated(state.range(0));
+    uint64_t rng = 0x9E3779B97F4A7C15ULL * (static_cast<uint64_t>(state.thread_index()) + 1);
+    std::vector<std::string> keys;
+    for (int i = 0; i < 4096; ++i) keys.push_back(KeyOf(NextRandom(rng) % static_cast<uint64_t>(state.range(0))));
+    std::vector<std::pair<std::string, std::string>> out;
+    size_t i = 0;
+    for (auto _ : state) {
+        out.clear();
+        list->scan(keys[i++ & 4095], 100, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * 100);
+}
+BENCHMARK(BM_SkipListScan)->Apply(KeyCounts)->Threads(1)->Threads(4)->Threads(8)->UseRealTime();
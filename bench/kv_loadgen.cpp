@@ -0,0 +1,270 @@
+// kv_loadgen.cpp
+// YCSB 风格的 KV 压测工具：开环 (按目标速率、修正 coordinated omission) 或闭环，
+// 后端可以是进程内的 SkipList (只测存储引擎) 或通过 gRPC 访问的整个集群 (客户端 -> Raft -> apply)
+//
+// 用法示例：
+//   kv_loadgen --backend=skiplist --workload=A --records=1000000 --threads=8 --duration=30
+//   kv_loadgen --backend=grpc --targets=127.0.0.1:50051,127.0.0.1:50052 --load --workload=B --rate=20000 --threads=32
+#include <grpcpp/grpcpp.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "kv.grpc.pb.h"
+#include "skipList.h"
+#include "ycsb.h"
+
+using namespace ycsb;
+
+// 进程内存储引擎
+class SkipListBackend : public KvBackend {
+ public:
+    SkipListBackend() : list_(18) {}
+
+    bool Read(const std::string &key, std::string *value) override {
+        list_.search_element(key, *value);
+        return true;
+    }
+    bool Update(const std::string &key, const std::string &value) override {
+        list_.insert_set_element(key, value);
+        return true;
+    }
+    bool Scan(const std::string &start_key, int count) override {
+        std::vector<std::pair<std::string, std::string>> out;
+        list_.scan(start_key, count, out);
+        return true;
+    }
+
+ private:
+    SkipList<std::string, std::string> list_;
+};
+
+/**
+ * @brief 通过 kv::KVStorageService 访问集群
+ * @details 写请求和线性一致读只有 Leader 能回答：收到 ERR_NOT_LEADER 时换下一个地址重试，
+ * 并把它记为后续请求的首选 (所有线程共享)，最多把所有地址各试一次。
+ */
+class GrpcBackend : public KvBackend {
+ public:
+    GrpcBackend(const std::vector<std::string> &targets, std::chrono::milliseconds timeout)
+        : timeout_(timeout), client_id_(std::random_device{}() | (uint64_t{std::random_device{}()} << 32)) {
+        for (const std::string &target : targets) {
+            stubs_.push_back(kv::KVStorageService::NewStub(
+                grpc::CreateChannel(target, grpc::InsecureChannelCredentials())));
+        }
+    }
+
+    bool Read(const std::string &key, std::string *value) override {
+        kv::GetRequest req;
+        req.set_key(key);
+        return WithLeader([&](kv::KVStorageService::Stub *stub, grpc::ClientContext *ctx) {
+            kv::GetResponse resp;
+            grpc::Status st = stub->Get(ctx, req, &resp);
+            if (st.ok() && resp.error().code() == kv::OK) *value = resp.value();
+            return Outcome(st, resp.error().code());
+        });
+    }
+
+    bool Update(const std::string &key, const std::string &value) override {
+        kv::PutRequest req;
+        req.set_key(key);
+        req.set_value(value);
+        req.set_client_id(client_id_);
+        req.set_req_id(next_req_id_.fetch_add(1, std::memory_order_relaxed));
+        return WithLeader([&](kv::KVStorageService::Stub *stub, grpc::ClientContext *ctx) {
+            kv::PutResponse resp;
+            grpc::Status st = stub->Put(ctx, req, &resp);
+            return Outcome(st, resp.error().code());
+        });
+    }
+
+    bool Scan(const std::string &start_key, int count) override {
+        kv::ScanRequest req;
+        req.set_start_key(start_key);
+        req.set_limit(static_cast<uint32_t>(count));
+        return WithLeader([&](kv::KVStorageService::Stub *stub, grpc::ClientContext *ctx) {
+            kv::ScanResponse resp;
+            grpc::Status st = stub->Scan(ctx, req, &resp);
+            return Outcome(st, resp.error().code());
+        });
+    }
+
+ private:
+    enum class Result { kOk, kNotLeader, kFailed };
+
+    static Result Outcome(const grpc::Status &st, kv::ErrorCode code) {
+        if (!st.ok()) return Result::kFailed;
+        if (code == kv::OK || code == kv::ERR_KEY_NOT_FOUND) return Result::kOk;
+        return code == kv::ERR_NOT_LEADER ? Result::kNotLeader : Result::kFailed;
+    }
+
+    template <typename Call>
+    bool WithLeader(Call &&call) {
+        size_t first = leader_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < stubs_.size(); ++i) {
+            size_t idx = (first + i) % stubs_.size();
+            grpc::ClientContext ctx;
+            ctx.set_deadline(std::chrono::system_clock::now() + timeout_);
+            Result r = call(stubs_[idx].get(), &ctx);
+            if (r == Result::kOk) {
+                if (idx != first) leader_.store(idx, std::memory_order_relaxed);
+                return true;
+            }
+            if (r == Result::kFailed) return false;
+        }
+        return false;
+    }
+
+    std::vector<std::unique_ptr<kv::KVStorageService::Stub>> stubs_;
+    std::atomic<size_t> leader_{0};
+    std::chrono::milliseconds timeout_;
+    uint64_t client_id_;
+    std::atomic<uint64_t> next_req_id_{1};
+};
+
+struct Flags {
+    std::string backend = "skiplist";
+    std::string targets = "127.0.0.1:50051";
+    std::string workload = "A";
+    std::string distribution;  // 空：使用负载的默认分布
+    uint64_t records = 100000;
+    int threads = 4;
+    int load_threads = 8;
+    double rate = 0;
+    bool poisson = false;
+    double duration = 10;
+    uint64_t max_ops = 0;
+    size_t value_size = 100;
+    int scan_length = 100;
+    int timeout_ms = 1000;
+    bool load = false;  // grpc 后端是否先装载数据 (skiplist 后端总是装载)
+};
+
+static void Usage(const char *prog) {
+    std::fprintf(stderr,
+                 "usage: %s [options]\n"
+                 "  --backend=skiplist|grpc     被压测的对象 (默认 skiplist)\n"
+                 "  --targets=host:port,...     grpc 后端的节点地址\n"
+                 "  --workload=A..F             YCSB core workload (默认 A)\n"
+                 "  --distribution=zipfian|uniform|latest\n"
+                 "  --records=N                 预先装载的 key 数 (默认 100000)\n"
+                 "  --threads=N                 压测线程数 (默认 4)\n"
+                 "  --load-threads=N            装载线程数 (默认 8)\n"
+                 "  --rate=OPS                  开环目标速率 (所有线程合计，0 为闭环，默认 0)\n"
+                 "  --poisson                   开环时请求间隔服从指数分布\n"
+                 "  --duration=SECONDS          压测时长 (默认 10)\n"
+                 "  --max-ops=N                 每个线程最多发出的请求数\n"
+                 "  --value-size=BYTES          value 长度 (默认 100)\n"
+                 "  --scan-length=N             最长扫描条数 (默认 100)\n"
+                 "  --timeout-ms=MS             grpc 请求超时 (默认 1000)\n"
+                 "  --load                      grpc 后端先装载 records 条数据\n",
+                 prog);
+}
+
+static bool ParseFlags(int argc, char **argv, Flags *f) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0) return false;
+        size_t eq = arg.find('=');
+        std::string name = arg.substr(2, eq == std::string::npos ? std::string::npos : eq - 2);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        try {
+            if (name == "backend") f->backend = value;
+            else if (name == "targets") f->targets = value;
+            else if (name == "workload") f->workload = value;
+            else if (name == "distribution") f->distribution = value;
+            else if (name == "records") f->records = std::stoull(value);
+            else if (name == "threads") f->threads = std::stoi(value);
+            else if (name == "load-threads") f->load_threads = std::stoi(value);
+            else if (name == "rate") f->rate = std::stod(value);
+            else if (name == "poisson") f->poisson = true;
+            else if (name == "duration") f->duration = std::stod(value);
+            else if (name == "max-ops") f->max_ops = std::stoull(value);
+            else if (name == "value-size") f->value_size = std::stoul(value);
+            else if (name == "scan-length") f->scan_length = std::stoi(value);
+            else if (name == "timeout-ms") f->timeout_ms = std::stoi(value);
+            else if (name == "load") f->load = true;
+            else return false;
+        } catch (const std::exception &) {
+            std::fprintf(stderr, "invalid value for --%s: %s\n", name.c_str(), value.c_str());
+            return false;
+        }
+    }
+    return f->threads > 0 && f->load_threads > 0 && f->duration > 0 && f->workload.size() == 1;
+}
+
+int main(int argc, char **argv) {
+    Flags flags;
+    if (!ParseFlags(argc, argv, &flags)) {
+        Usage(argv[0]);
+        return 2;
+    }
+
+    WorkloadSpec spec;
+    if (!WorkloadSpec::Preset(flags.workload[0], &spec)) {
+        std::fprintf(stderr, "unknown workload: %s\n", flags.workload.c_str());
+        return 2;
+    }
+    spec.max_scan_length = flags.scan_length;
+    if (flags.distribution == "uniform") spec.distribution = Distribution::kUniform;
+    else if (flags.distribution == "zipfian") spec.distribution = Distribution::kZipfian;
+    else if (flags.distribution == "latest") spec.distribution = Distribution::kLatest;
+    else if (!flags.distribution.empty()) {
+        std::fprintf(stderr, "unknown distribution: %s\n", flags.distribution.c_str());
+        return 2;
+    }
+
+    std::unique_ptr<KvBackend> backend;
+    bool load = flags.load;
+    if (flags.backend == "skiplist") {
+        backend.reset(new SkipListBackend());
+        load = true;
+    } else if (flags.backend == "grpc") {
+        std::vector<std::string> targets;
+        std::stringstream ss(flags.targets);
+        for (std::string t; std::getline(ss, t, ',');) {
+            if (!t.empty()) targets.push_back(t);
+        }
+        if (targets.empty()) {
+            std::fprintf(stderr, "--targets is empty\n");
+            return 2;
+        }
+        backend.reset(new GrpcBackend(targets, std::chrono::milliseconds(flags.timeout_ms)));
+    } else {
+        std::fprintf(stderr, "unknown backend: %s\n", flags.backend.c_str());
+        return 2;
+    }
+
+    if (load) {
+        auto start = std::chrono::steady_clock::now();
+        LoadRecords(backend.get(), flags.records, flags.value_size, flags.load_threads);
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("[LOAD] records=%llu time=%.2fs throughput=%.1f ops/s\n",
+                    static_cast<unsigned long long>(flags.records), secs, secs > 0 ? flags.records / secs : 0.0);
+    }
+
+    RunOptions opts;
+    opts.threads = flags.threads;
+    opts.rate = flags.rate;
+    opts.poisson = flags.poisson;
+    opts.duration = std::chrono::milliseconds(static_cast<int64_t>(flags.duration * 1000));
+    opts.max_ops = flags.max_ops;
+    opts.value_size = flags.value_size;
+    opts.seed = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+
+    std::printf("[RUN] backend=%s workload=%c threads=%d mode=%s\n", flags.backend.c_str(), spec.name, opts.threads,
+                opts.rate > 0 ? (opts.poisson ? "open-loop (poisson)" : "open-loop") : "closed-loop");
+    KeySpace keys(flags.records);
+    LatencyRecorder recorder;
+    RunResult result = RunWorkload(backend.get(), spec, &keys, opts, &recorder);
+    PrintReport(stdout, result, opts, recorder);
+    return 0;
+}
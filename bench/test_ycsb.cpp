@@ -0,0 +1,225 @@
+// test_ycsb.cpp
+// YCSB 负载模型：zipfian 分布的范围与倾斜、六种负载的操作比例、latest 分布偏向新 key、
+// 开环压测的请求节奏，以及服务卡顿时 corrected 延迟能反映 coordinated omission
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ycsb.h"
+
+using namespace ycsb;
+
+// 内存 map 加可选的一次卡顿
+class FakeBackend : public KvBackend {
+ public:
+    bool Read(const std::string &key, std::string *value) override {
+        MaybeStall();
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = data_.find(key);
+        if (it != data_.end()) *value = it->second;
+        return true;
+    }
+    bool Update(const std::string &key, const std::string &value) override {
+        MaybeStall();
+        std::lock_guard<std::mutex> lock(mutex_);
+        data_[key] = value;
+        return true;
+    }
+    bool Scan(const std::string &start_key, int count) override {
+        MaybeStall();
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = data_.lower_bound(start_key);
+        for (int i = 0; i < count && it != data_.end(); ++i) ++it;
+        return true;
+    }
+
+    size_t Size() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return data_.size();
+    }
+
+    // 第 n 个请求 (从 1 开始) 卡住 d
+    void StallAt(uint64_t n, std::chrono::milliseconds d) {
+        stall_at_ = n;
+        stall_ = d;
+    }
+
+ private:
+    void MaybeStall() {
+        if (++calls_ == stall_at_) std::this_thread::sleep_for(stall_);
+    }
+
+    std::mutex mutex_;
+    std::map<std::string, std::string> data_;
+    std::atomic<uint64_t> calls_{0};
+    uint64_t stall_at_ = 0;
+    std::chrono::milliseconds stall_{0};
+};
+
+static void TestZipfian() {
+    std::cout << "[Test] zipfian range and skew... ";
+    const uint64_t kItems = 10000;
+    const int kSamples = 200000;
+    ZipfianGenerator zipf(kItems);
+    Random rng(42);
+    std::vector<int> hits(kItems, 0);
+    for (int i = 0; i < kSamples; ++i) {
+        uint64_t v = zipf.Next(rng);
+        assert(v < kItems);
+        ++hits[v];
+    }
+    // theta = 0.99：编号 0 约占 1 / zeta(10000) ≈ 10%，且前几名按排名递减
+    assert(hits[0] > kSamples * 0.07 && hits[0] < kSamples * 0.14);
+    assert(hits[0] > hits[1] && hits[1] > hits[5] && hits[5] > hits[100]);
+    int top100 = 0;
+    for (int i = 0; i < 100; ++i) top100 += hits[i];
+    assert(top100 > kSamples / 2);
+
+    // 扩大范围后能取到新的编号
+    zipf.Resize(kItems * 2);
+    assert(zipf.Items() == kItems * 2);
+    bool beyond = false;
+    for (int i = 0; i < kSamples && !beyond; ++i) beyond = zipf.Next(rng) >= kItems;
+    assert(beyond);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestWorkloadMix() {
+    std::cout << "[Test] workload A-F operation mix... ";
+    WorkloadSpec spec;
+    assert(!WorkloadSpec::Preset('G', &spec));
+    const char *letters = "ABCDEF";
+    for (const char *p = letters; *p; ++p) {
+        assert(WorkloadSpec::Preset(*p, &spec));
+        assert(spec.name == *p);
+        double sum = spec.read + spec.update + spec.insert + spec.scan + spec.read_modify_write;
+        assert(sum > 0.999 && sum < 1.001);
+
+        KeySpace keys(1000);
+        OpChooser chooser(spec, &keys, 7);
+        const int kSamples = 100000;
+        int counts[static_cast<size_t>(OpType::kCount)] = {};
+        for (int i = 0; i < kSamples; ++i) {
+            ++counts[static_cast<size_t>(chooser.NextOp())];
+            assert(chooser.NextKeyNum() < 1000);
+        }
+        auto near = [&](OpType op, double expected) {
+            double got = static_cast<double>(counts[static_cast<size_t>(op)]) / kSamples;
+            return got > expected - 0.01 && got < expected + 0.01;
+        };
+        assert(near(OpType::kRead, spec.read));
+        assert(near(OpType::kUpdate, spec.update));
+        assert(near(OpType::kInsert, spec.insert));
+        assert(near(OpType::kScan, spec.scan));
+        assert(near(OpType::kReadModifyWrite, spec.read_modify_write));
+    }
+    assert(WorkloadSpec::Preset('d', &spec) && spec.distribution == Distribution::kLatest);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestLatestDistribution() {
+    std::cout << "[Test] latest distribution favours new keys... ";
+    WorkloadSpec spec;
+    assert(WorkloadSpec::Preset('D', &spec));
+    KeySpace keys(1000);
+    OpChooser chooser(spec, &keys, 3);
+    int newest = 0;
+    for (int i = 0; i < 10000; ++i) newest += chooser.NextKeyNum() >= 990 ? 1 : 0;
+    assert(newest > 3000);
+
+    // 插入确认之后，最热的 key 随之变成新插入的 key
+    for (int i = 0; i < 100; ++i) keys.Acknowledge(keys.NextInsert());
+    assert(keys.Loaded() == 1100);
+    int inserted = 0;
+    for (int i = 0; i < 10000; ++i) {
+        uint64_t k = chooser.NextKeyNum();
+        assert(k < 1100);
+        inserted += k >= 1000 ? 1 : 0;
+    }
+    assert(inserted > 5000);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestLoadAndClosedLoop() {
+    std::cout << "[Test] load phase and closed-loop run... ";
+    FakeBackend backend;
+    LoadRecords(&backend, 500, 16, 4);
+    assert(backend.Size() == 500);
+
+    WorkloadSpec spec;
+    assert(WorkloadSpec::Preset('E', &spec));
+    KeySpace keys(500);
+    RunOptions opts;
+    opts.threads = 2;
+    opts.max_ops = 1000;
+    opts.duration = std::chrono::seconds(30);
+    LatencyRecorder recorder;
+    RunResult result = RunWorkload(&backend, spec, &keys, opts, &recorder);
+    assert(result.ops == 2000);
+    uint64_t scans = recorder.Of(OpType::kScan).corrected.Collect().count;
+    uint64_t inserts = recorder.Of(OpType::kInsert).corrected.Collect().count;
+    assert(scans + inserts == 2000 && inserts > 0);
+    assert(backend.Size() == 500 + inserts);
+    assert(keys.Loaded() == 500 + inserts);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestOpenLoopPacing() {
+    std::cout << "[Test] open-loop pacing... ";
+    FakeBackend backend;
+    WorkloadSpec spec;
+    assert(WorkloadSpec::Preset('C', &spec));
+    KeySpace keys(100);
+    RunOptions opts;
+    opts.threads = 2;
+    opts.rate = 1000;
+    opts.duration = std::chrono::milliseconds(300);
+    LatencyRecorder recorder;
+    RunResult result = RunWorkload(&backend, spec, &keys, opts, &recorder);
+    // 300ms * 1000 ops/s，开环不会超发
+    assert(result.ops >= 250 && result.ops <= 300);
+    assert(result.seconds >= 0.25);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestCoordinatedOmission() {
+    std::cout << "[Test] corrected latency covers requests queued behind a stall... ";
+    FakeBackend backend;
+    backend.StallAt(100, std::chrono::milliseconds(100));
+    WorkloadSpec spec;
+    assert(WorkloadSpec::Preset('C', &spec));
+    KeySpace keys(100);
+    RunOptions opts;
+    opts.threads = 1;
+    opts.rate = 2000;
+    opts.max_ops = 1000;
+    opts.duration = std::chrono::seconds(30);
+    LatencyRecorder recorder;
+    RunResult result = RunWorkload(&backend, spec, &keys, opts, &recorder);
+    assert(result.ops == 1000);
+
+    MetricHistogram::Snapshot corrected = recorder.Of(OpType::kRead).corrected.Collect();
+    MetricHistogram::Snapshot service = recorder.Of(OpType::kRead).service.Collect();
+    assert(corrected.count == 1000 && service.count == 1000);
+    // 卡顿的 100ms 内本该发出约 200 个请求：它们的 corrected 延迟都被拉长，service 只有一个慢请求
+    assert(corrected.Percentile(0.9) > 10 * 1000 * 1000);
+    assert(service.Percentile(0.99) < 10 * 1000 * 1000);
+    assert(service.Percentile(1.0) >= 100 * 1000 * 1000 * 7 / 8);
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    TestZipfian();
+    TestWorkloadMix();
+    TestLatestDistribution();
+    TestLoadAndClosedLoop();
+    TestOpenLoopPacing();
+    TestCoordinatedOmission();
+    std::cout << "All ycsb workload tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,420 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "metrics.h"
+
+/**
+ * @file ycsb.h
+ * @brief YCSB 风格的负载模型与开环 (open-loop) 压测驱动，kv_loadgen 与其测试共用
+ * @details
+ * 1. 负载：A~F 六种标准混合 (读 / 更新 / 插入 / 扫描 / 读-改-写 的比例)，key 分布为 uniform、
+ *    scrambled zipfian (热点打散到整个 key 空间) 或 latest (越新插入的 key 越热，workload D)；
+ * 2. 开环：每个线程按目标速率预先排好每个请求的 "计划发出时间"，请求被阻塞时后续请求的计划时间照常流逝，
+ *    延迟从计划时间算起 (corrected)，避免闭环压测的 coordinated omission：服务卡顿 1 秒时闭环只记录到
+ *    一个慢请求，开环会记录到这 1 秒内本该发出的所有请求都变慢了。同时记录从实际发出算起的服务时间 (service)；
+ * 3. 闭环：rate 为 0 时每个线程背靠背发请求，计划时间即实际发出时间，两种延迟相同。
+ *
+ * 延迟直方图复用 MetricHistogram (单位纳秒，分位数为桶上界，相对误差 < 12.5%)。
+ */
+
+namespace ycsb {
+
+enum class OpType { kRead = 0, kUpdate, kInsert, kScan, kReadModifyWrite, kCount };
+
+inline const char *OpName(OpType op) {
+    switch (op) {
+        case OpType::kRead: return "READ";
+        case OpType::kUpdate: return "UPDATE";
+        case OpType::kInsert: return "INSERT";
+        case OpType::kScan: return "SCAN";
+        case OpType::kReadModifyWrite: return "READ-MODIFY-WRITE";
+        default: return "UNKNOWN";
+    }
+}
+
+enum class Distribution { kUniform, kZipfian, kLatest };
+
+// FNV-1a 64：把 key 编号打散，顺序插入的 key 不会在有序结构里挤在一起
+inline uint64_t FnvHash64(uint64_t v) {
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (int i = 0; i < 8; ++i) {
+        h ^= v & 0xFF;
+        h *= 0x100000001B3ULL;
+        v >>= 8;
+    }
+    return h;
+}
+
+// key 编号 -> key："user" + 20 位十进制的哈希值
+inline std::string KeyOf(uint64_t keynum) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "user%020" PRIu64, FnvHash64(keynum));
+    return buf;
+}
+
+// xorshift64*，每个线程一个
+class Random {
+ public:
+    explicit Random(uint64_t seed) : state_(seed != 0 ? seed : 0x9E3779B97F4A7C15ULL) {}
+
+    uint64_t Next() {
+        state_ ^= state_ >> 12;
+        state_ ^= state_ << 25;
+        state_ ^= state_ >> 27;
+        return state_ * 0x2545F4914F6CDD1DULL;
+    }
+    // [0, 1)
+    double NextDouble() { return static_cast<double>(Next() >> 11) * (1.0 / 9007199254740992.0); }
+    // [0, n)
+    uint64_t Uniform(uint64_t n) { return n == 0 ? 0 : Next() % n; }
+
+ private:
+    uint64_t state_;
+};
+
+/**
+ * @brief Zipfian 分布 [0, items)，编号 0 最热 (Gray et al. "Quickly Generating Billion-Record
+ * Synthetic Databases" 的算法，与 YCSB 的 ZipfianGenerator 相同)
+ * @details 构造时计算 zeta(items) 是 O(items)；Resize 只增量累加新增部分，workload D/E 插入新 key 后
+ * 用它扩大范围。
+ */
+class ZipfianGenerator {
+ public:
+    static constexpr double kZipfianConstant = 0.99;
+
+    explicit ZipfianGenerator(uint64_t items, double theta = kZipfianConstant)
+        : theta_(theta), zeta2_(Zeta(0, 2, theta, 0)) {
+        items_ = std::max<uint64_t>(items, 1);
+        zetan_ = Zeta(0, items_, theta_, 0);
+        Recompute();
+    }
+
+    uint64_t Items() const { return items_; }
+
+    void Resize(uint64_t items) {
+        if (items <= items_) return;
+        zetan_ = Zeta(items_, items, theta_, zetan_);
+        items_ = items;
+        Recompute();
+    }
+
+    uint64_t Next(Random &rng) const {
+        double u = rng.NextDouble();
+        double uz = u * zetan_;
+        if (uz < 1.0) return 0;
+        if (uz < 1.0 + std::pow(0.5, theta_)) return 1;
+        uint64_t v = static_cast<uint64_t>(static_cast<double>(items_) * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+        return std::min(v, items_ - 1);
+    }
+
+ private:
+    // sum_{i = from + 1}^{to} 1 / i^theta，在 initial 上累加
+    static double Zeta(uint64_t from, uint64_t to, double theta, double initial) {
+        double sum = initial;
+        for (uint64_t i = from; i < to; ++i) sum += 1.0 / std::pow(static_cast<double>(i + 1), theta);
+        return sum;
+    }
+
+    void Recompute() {
+        alpha_ = 1.0 / (1.0 - theta_);
+        eta_ = (1.0 - std::pow(2.0 / static_cast<double>(items_), 1.0 - theta_)) / (1.0 - zeta2_ / zetan_);
+    }
+
+    double theta_;
+    double zeta2_;
+    uint64_t items_ = 1;
+    double zetan_ = 0;
+    double alpha_ = 0;
+    double eta_ = 0;
+};
+
+/**
+ * @brief 一种负载：各操作的比例 (之和为 1) 与 key 分布
+ */
+struct WorkloadSpec {
+    char name = 'A';
+    double read = 0;
+    double update = 0;
+    double insert = 0;
+    double scan = 0;
+    double read_modify_write = 0;
+    Distribution distribution = Distribution::kZipfian;
+    int max_scan_length = 100;  // 扫描长度在 [1, max_scan_length] 均匀分布
+
+    // YCSB core workloads；未知的字母返回 false
+    static bool Preset(char letter, WorkloadSpec *spec) {
+        WorkloadSpec w;
+        w.name = static_cast<char>(std::toupper(static_cast<unsigned char>(letter)));
+        switch (w.name) {
+            case 'A': w.read = 0.5; w.update = 0.5; break;            // 更新密集
+            case 'B': w.read = 0.95; w.update = 0.05; break;          // 读为主
+            case 'C': w.read = 1.0; break;                            // 只读
+            case 'D': w.read = 0.95; w.insert = 0.05; w.distribution = Distribution::kLatest; break;  // 读最新
+            case 'E': w.scan = 0.95; w.insert = 0.05; break;          // 短范围扫描
+            case 'F': w.read = 0.5; w.read_modify_write = 0.5; break; // 读-改-写
+            default: return false;
+        }
+        *spec = w;
+        return true;
+    }
+};
+
+/**
+ * @brief 所有线程共享的 key 空间：[0, Loaded()) 已存在，插入从 NextInsert() 取新编号
+ */
+class KeySpace {
+ public:
+    explicit KeySpace(uint64_t record_count) : next_insert_(record_count), acknowledged_(record_count) {}
+
+    uint64_t NextInsert() { return next_insert_.fetch_add(1, std::memory_order_relaxed); }
+    // 插入成功后调用，读只选择已确认的编号；多线程乱序完成时取最大值，偶尔读到尚未写完的 key 只是读不到
+    void Acknowledge(uint64_t keynum) {
+        uint64_t cur = acknowledged_.load(std::memory_order_relaxed);
+        while (keynum + 1 > cur &&
+               !acknowledged_.compare_exchange_weak(cur, keynum + 1, std::memory_order_relaxed)) {
+        }
+    }
+    uint64_t Loaded() const { return acknowledged_.load(std::memory_order_relaxed); }
+
+ private:
+    std::atomic<uint64_t> next_insert_;
+    std::atomic<uint64_t> acknowledged_;
+};
+
+/**
+ * @brief 单个线程的操作生成器：按比例选操作，按分布选 key
+ */
+class OpChooser {
+ public:
+    OpChooser(const WorkloadSpec &spec, KeySpace *keys, uint64_t seed)
+        : spec_(spec), keys_(keys), rng_(seed), zipf_(std::max<uint64_t>(keys->Loaded(), 1)) {}
+
+    OpType NextOp() {
+        double r = rng_.NextDouble();
+        if ((r -= spec_.read) < 0) return OpType::kRead;
+        if ((r -= spec_.update) < 0) return OpType::kUpdate;
+        if ((r -= spec_.insert) < 0) return OpType::kInsert;
+        if ((r -= spec_.scan) < 0) return OpType::kScan;
+        if (spec_.read_modify_write > 0) return OpType::kReadModifyWrite;
+        return OpType::kRead;
+    }
+
+    // 已存在的 key 的编号
+    uint64_t NextKeyNum() {
+        uint64_t n = std::max<uint64_t>(keys_->Loaded(), 1);
+        switch (spec_.distribution) {
+            case Distribution::kUniform:
+                return rng_.Uniform(n);
+            case Distribution::kLatest:
+                zipf_.Resize(n);
+                return n - 1 - zipf_.Next(rng_);
+            case Distribution::kZipfian:
+            default:
+                // scrambled：热点分散在整个 key 空间，而不是集中在最早插入的几个 key
+                zipf_.Resize(n);
+                return FnvHash64(zipf_.Next(rng_)) % n;
+        }
+    }
+
+    int NextScanLength() { return 1 + static_cast<int>(rng_.Uniform(std::max(spec_.max_scan_length, 1))); }
+
+    Random &Rng() { return rng_; }
+
+ private:
+    WorkloadSpec spec_;
+    KeySpace *keys_;
+    Random rng_;
+    ZipfianGenerator zipf_;
+};
+
+/**
+ * @brief 被压测的 KV 接口 (所有线程共享同一个对象，实现必须线程安全)
+ * 返回 false 表示请求失败 (网络错误 / 服务端错误)；读不到 key 不算失败
+ */
+class KvBackend {
+ public:
+    virtual ~KvBackend() = default;
+    virtual bool Read(const std::string &key, std::string *value) = 0;
+    virtual bool Update(const std::string &key, const std::string &value) = 0;
+    virtual bool Insert(const std::string &key, const std::string &value) { return Update(key, value); }
+    virtual bool Scan(const std::string &start_key, int count) = 0;
+};
+
+/**
+ * @brief 每种操作两份延迟直方图 (纳秒)：corrected 从计划发出时间算起，service 从实际发出算起
+ */
+class LatencyRecorder {
+ public:
+    struct PerOp {
+        MetricHistogram corrected;
+        MetricHistogram service;
+        std::atomic<uint64_t> failed{0};
+    };
+
+    void Record(OpType op, std::chrono::steady_clock::time_point intended, std::chrono::steady_clock::time_point sent,
+                std::chrono::steady_clock::time_point done, bool ok) {
+        PerOp &p = ops_[static_cast<size_t>(op)];
+        p.corrected.Record(Nanos(done - intended));
+        p.service.Record(Nanos(done - sent));
+        if (!ok) p.failed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const PerOp &Of(OpType op) const { return ops_[static_cast<size_t>(op)]; }
+
+ private:
+    static uint64_t Nanos(std::chrono::steady_clock::duration d) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+        return ns > 0 ? static_cast<uint64_t>(ns) : 0;
+    }
+
+    PerOp ops_[static_cast<size_t>(OpType::kCount)];
+};
+
+struct RunOptions {
+    int threads = 1;
+    double rate = 0;                        // 所有线程合计的目标速率 (ops/s)，0 为闭环
+    bool poisson = false;                   // 开环时请求间隔服从指数分布 (默认等间隔)
+    std::chrono::milliseconds duration{10000};
+    uint64_t max_ops = 0;                   // 每个线程最多发出的请求数，0 表示只受 duration 限制
+    size_t value_size = 100;
+    uint64_t seed = 1;
+};
+
+struct RunResult {
+    uint64_t ops = 0;
+    double seconds = 0;
+};
+
+// 开始压测前装载 [0, record_count) 的 key，按线程分片
+inline void LoadRecords(KvBackend *backend, uint64_t record_count, size_t value_size, int threads) {
+    threads = std::max(threads, 1);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([=] {
+            std::string value(value_size, static_cast<char>('a' + t % 26));
+            for (uint64_t k = static_cast<uint64_t>(t); k < record_count; k += static_cast<uint64_t>(threads)) {
+                backend->Insert(KeyOf(k), value);
+            }
+        });
+    }
+    for (auto &w : workers) w.join();
+}
+
+/**
+ * @brief 运行负载直到 duration 到期 (或每个线程发完 max_ops)，延迟写入 recorder
+ */
+inline RunResult RunWorkload(KvBackend *backend, const WorkloadSpec &spec, KeySpace *keys, const RunOptions &opts,
+                             LatencyRecorder *recorder) {
+    using Clock = std::chrono::steady_clock;
+    const int threads = std::max(opts.threads, 1);
+    // 每个线程的平均请求间隔
+    const double interval_ns = opts.rate > 0 ? 1e9 * threads / opts.rate : 0;
+    std::atomic<uint64_t> total_ops{0};
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point deadline = start + opts.duration;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            OpChooser chooser(spec, keys, opts.seed * 0x9E3779B97F4A7C15ULL + static_cast<uint64_t>(t) + 1);
+            std::string value(opts.value_size, 'x');
+            std::string read_buf;
+            // 各线程错开起点，避免所有线程在同一时刻发请求
+            double next_ns = interval_ns * t / threads;
+            uint64_t issued = 0;
+            while (opts.max_ops == 0 || issued < opts.max_ops) {
+                Clock::time_point intended;
+                if (interval_ns > 0) {
+                    intended = start + std::chrono::nanoseconds(static_cast<int64_t>(next_ns));
+                    double gap = opts.poisson ? -std::log(1.0 - chooser.Rng().NextDouble()) * interval_ns : interval_ns;
+                    next_ns += gap;
+                    if (intended >= deadline) break;
+                    // 还没到计划时间：远的睡眠，近的让出 CPU 自旋；落后时不等待，直接追赶
+                    Clock::time_point now = Clock::now();
+                    if (intended - now > std::chrono::microseconds(200)) {
+                        std::this_thread::sleep_until(intended - std::chrono::microseconds(100));
+                    }
+                    while (Clock::now() < intended) std::this_thread::yield();
+                } else {
+                    intended = Clock::now();
+                    if (intended >= deadline) break;
+                }
+
+                OpType op = chooser.NextOp();
+                value[0] = static_cast<char>('a' + issued % 26);
+                Clock::time_point sent = Clock::now();
+                bool ok = true;
+                switch (op) {
+                    case OpType::kRead:
+                        ok = backend->Read(KeyOf(chooser.NextKeyNum()), &read_buf);
+                        break;
+                    case OpType::kUpdate:
+                        ok = backend->Update(KeyOf(chooser.NextKeyNum()), value);
+                        break;
+                    case OpType::kInsert: {
+                        uint64_t keynum = keys->NextInsert();
+                        ok = backend->Insert(KeyOf(keynum), value);
+                        if (ok) keys->Acknowledge(keynum);
+                        break;
+                    }
+                    case OpType::kScan:
+                        ok = backend->Scan(KeyOf(chooser.NextKeyNum()), chooser.NextScanLength());
+                        break;
+                    case OpType::kReadModifyWrite: {
+                        std::string key = KeyOf(chooser.NextKeyNum());
+                        ok = backend->Read(key, &read_buf) && backend->Update(key, value);
+                        break;
+                    }
+                    default:
+                        break;
+                }
+                recorder->Record(op, intended, sent, Clock::now(), ok);
+                ++issued;
+            }
+            total_ops.fetch_add(issued, std::memory_order_relaxed);
+        });
+    }
+    for (auto &w : workers) w.join();
+
+    RunResult result;
+    result.ops = total_ops.load();
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return result;
+}
+
+// 人类可读的报告：每种操作一行，延迟单位微秒
+inline void PrintReport(FILE *out, const RunResult &result, const RunOptions &opts, const LatencyRecorder &recorder) {
+    std::fprintf(out, "[OVERALL] ops=%" PRIu64 " time=%.2fs throughput=%.1f ops/s target=%s\n", result.ops,
+                 result.seconds, result.seconds > 0 ? result.ops / result.seconds : 0.0,
+                 opts.rate > 0 ? (std::to_string(static_cast<uint64_t>(opts.rate)) + " ops/s").c_str() : "closed-loop");
+    std::fprintf(out, "%-18s %10s %8s | %-44s | %-44s\n", "op", "count", "failed",
+                 "corrected(us) p50 / p90 / p99 / p99.9 / max", "service(us) p50 / p90 / p99 / p99.9 / max");
+    auto fmt = [](const MetricHistogram::Snapshot &s) {
+        char buf[96];
+        std::snprintf(buf, sizeof(buf), "%.1f / %.1f / %.1f / %.1f / %.1f", s.Percentile(0.5) / 1e3,
+                      s.Percentile(0.9) / 1e3, s.Percentile(0.99) / 1e3, s.Percentile(0.999) / 1e3,
+                      s.Percentile(1.0) / 1e3);
+        return std::string(buf);
+    };
+    for (size_t i = 0; i < static_cast<size_t>(OpType::kCount); ++i) {
+        const LatencyRecorder::PerOp &p = recorder.Of(static_cast<OpType>(i));
+        MetricHistogram::Snapshot corrected = p.corrected.Collect();
+        if (corrected.count == 0) continue;
+        MetricHistogram::Snapshot service = p.service.Collect();
+        std::fprintf(out, "%-18s %10" PRIu64 " %8" PRIu64 " | %-44s | %-44s\n", OpName(static_cast<OpType>(i)),
+                     corrected.count, p.failed.load(), fmt(corrected).c_str(), fmt(service).c_str());
+    }
+}
+
+}  // namespace ycsb
@@ -0,0 +1,509 @@
+#include "include/binlog.h"
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <ctime>
+
+using binlog_detail::ArgType;
+
+const char *BinLogLevelName(BinLogLevel level) {
+  switch (level) {
+    case BinLogLevel::kTrace: return "trace";
+    case BinLogLevel::kDebug: return "debug";
+    case BinLogLevel::kInfo: return "info";
+    case BinLogLevel::kWarn: return "warning";
+    case BinLogLevel::kError: return "error";
+    case BinLogLevel::kCritical: return "critical";
+    case BinLogLevel::kOff: return "off";
+  }
+  return "unknown";
+}
+
+// ============================================================================
+// 线程缓冲区
+// ============================================================================
+
+namespace {
+
+// 记录头，后面紧跟参数区；整条记录按 8 字节对齐
+struct RecordHeader {
+  uint32_t size;  // 含头部与对齐填充；最高位为 1 表示环尾的填充 (此时只有这 4 个字节有意义)
+  uint32_t tid;
+  const BinLogSite *site;
+  uint64_t wall_ns;
+};
+static_assert(sizeof(RecordHeader) == 24, "RecordHeader layout");
+
+constexpr uint32_t kPaddingFlag = 1u << 31;
+
+inline size_t Align8(size_t n) { return (n + 7) & ~static_cast<size_t>(7); }
+
+uint32_t CurrentTid() {
+  thread_local uint32_t tid = static_cast<uint32_t>(::syscall(SYS_gettid));
+  return tid;
+}
+
+uint64_t WallNanos() {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::system_clock::now().time_since_epoch())
+                                   .count());
+}
+
+// 同步模式 (未 Start) 的参数区
+thread_local std::vector<char> t_scratch;
+thread_local const BinLogSite *t_sync_site = nullptr;
+
+}  // namespace
+
+/**
+ * @brief 单生产者单消费者的字节环
+ * @details head 只由 owner 线程推进，tail 只由 Drain 推进，都是单调递增的字节偏移 (取模 capacity 定位)。
+ * 一条记录必须连续存放：环尾剩余空间不够时写一个填充标记，从头开始。
+ */
+struct BinLogger::Buffer {
+  explicit Buffer(size_t cap) : data(new char[cap]), capacity(cap) {}
+
+  std::unique_ptr<char[]> data;
+  const size_t capacity;  // 2 的幂
+  alignas(64) std::atomic<uint64_t> head{0};
+  uint64_t pending_head = 0;  // BeginRecord 预留到的位置 (owner 独占)
+  uint64_t cached_tail = 0;
+  alignas(64) std::atomic<uint64_t> tail{0};
+  std::atomic<bool> owned{true};
+};
+
+BinLogger::Buffer *BinLogger::LocalBuffer() {
+  struct Holder {
+    Buffer *buffer = nullptr;
+    ~Holder() {
+      if (buffer) buffer->owned.store(false, std::memory_order_release);
+    }
+  };
+  thread_local Holder holder;
+  if (holder.buffer) return holder.buffer;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto &buffer : buffers_) {
+    bool expected = false;
+    if (buffer->owned.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+      holder.buffer = buffer.get();
+      return holder.buffer;
+    }
+  }
+  buffers_.emplace_back(new Buffer(buffer_bytes_.load(std::memory_order_relaxed)));
+  holder.buffer = buffers_.back().get();
+  return holder.buffer;
+}
+
+char *BinLogger::BeginRecord(const BinLogSite &site, size_t args_size) {
+  if (!running_.load(std::memory_order_acquire)) {
+    t_sync_site = &site;
+    t_scratch.assign(std::max<size_t>(args_size, 1), 0);
+    return t_scratch.data();
+  }
+  t_sync_site = nullptr;
+  Buffer *b = LocalBuffer();
+  size_t need = Align8(sizeof(RecordHeader) + args_size);
+  if (need > b->capacity / 2) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  uint64_t head = b->head.load(std::memory_order_relaxed);
+  size_t offset = static_cast<size_t>(head & (b->capacity - 1));
+  size_t to_end = b->capacity - offset;
+  size_t skip = to_end < need ? to_end : 0;
+  if (head + skip + need - b->cached_tail > b->capacity) {
+    b->cached_tail = b->tail.load(std::memory_order_acquire);
+    if (head + skip + need - b->cached_tail > b->capacity) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+  }
+  if (skip) {
+    uint32_t marker = kPaddingFlag | static_cast<uint32_t>(skip);
+    std::memcpy(b->data.get() + offset, &marker, sizeof(marker));
+    head += skip;
+    offset = 0;
+  }
+  char *record = b->data.get() + offset;
+  // 末尾的对齐填充清零：解码遇到 0 即停止
+  std::memset(record + need - 8, 0, 8);
+  RecordHeader header{static_cast<uint32_t>(need), CurrentTid(), &site, WallNanos()};
+  std::memcpy(record, &header, sizeof(header));
+  b->pending_head = head + need;
+  return record + sizeof(RecordHeader);
+}
+
+void BinLogger::EndRecord() {
+  if (t_sync_site) {
+    BinLogRecord record;
+    record.site = t_sync_site;
+    record.wall_ns = WallNanos();
+    record.tid = CurrentTid();
+    record.message = Format(*t_sync_site, t_scratch.data(), t_scratch.size());
+    t_sync_site = nullptr;
+    Emit(record);
+    return;
+  }
+  Buffer *b = LocalBuffer();
+  uint64_t head = b->pending_head;
+  b->head.store(head, std::memory_order_release);
+  // 过半时提前唤醒后台线程 (每轮最多通知一次)
+  if (head - b->cached_tail > b->capacity / 2 && !wake_.load(std::memory_order_relaxed) &&
+      !wake_.exchange(true, std::memory_order_relaxed)) {
+    cv_.notify_one();
+  }
+}
+
+// ============================================================================
+// 后台线程
+// ============================================================================
+
+static size_t RoundUpPow2(size_t n) {
+  size_t cap = 4096;
+  while (cap < n) cap <<= 1;
+  return cap;
+}
+
+bool BinLogger::Start(size_t buffer_bytes, std::chrono::milliseconds interval,
+                      std::function<void()> on_thread_start) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (thread_.joinable()) return false;
+  buffer_bytes_.store(RoundUpPow2(buffer_bytes), std::memory_order_relaxed);
+  interval_ = std::max(interval, std::chrono::milliseconds(1));
+  stop_ = false;
+  thread_ = std::thread(&BinLogger::Run, this, std::move(on_thread_start));
+  running_.store(true, std::memory_order_release);
+  return true;
+}
+
+void BinLogger::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!thread_.joinable()) return;
+    running_.store(false, std::memory_order_release);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+  // 收尾：停止前已在写的记录
+  Drain();
+  std::lock_guard<std::mutex> lock(mutex_);
+  flush_done_ = flush_requested_;
+  flushed_cv_.notify_all();
+}
+
+BinLogger::BinLogger() = default;
+
+BinLogger::~BinLogger() { Stop(); }
+
+void BinLogger::Flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!thread_.joinable() || stop_) return;
+  uint64_t target = ++flush_requested_;
+  cv_.notify_one();
+  flushed_cv_.wait(lock, [&]() { return flush_done_ >= target; });
+}
+
+void BinLogger::Run(std::function<void()> on_thread_start) {
+  if (on_thread_start) on_thread_start();
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_.wait_for(lock, interval_, [this]() {
+      return stop_ || flush_requested_ > flush_done_ || wake_.load(std::memory_order_relaxed);
+    });
+    wake_.store(false, std::memory_order_relaxed);
+    bool stopping = stop_;
+    uint64_t target = flush_requested_;
+    lock.unlock();
+    Drain();
+    lock.lock();
+    flush_done_ = std::max(flush_done_, target);
+    flushed_cv_.notify_all();
+    if (stopping) return;
+  }
+}
+
+size_t BinLogger::Drain() {
+  static constexpr BinLogSite kDroppedSite{BinLogLevel::kWarn, false, __FILE__, __LINE__,
+                                           "binlog: {} messages dropped (thread buffer full)"};
+  std::lock_guard<std::mutex> drain_lock(drain_mutex_);
+  std::vector<Buffer *> buffers;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &buffer : buffers_) buffers.push_back(buffer.get());
+  }
+
+  std::vector<BinLogRecord> records;
+  for (Buffer *b : buffers) {
+    uint64_t tail = b->tail.load(std::memory_order_relaxed);
+    uint64_t head = b->head.load(std::memory_order_acquire);
+    while (tail < head) {
+      const char *record = b->data.get() + (tail & (b->capacity - 1));
+      uint32_t size;
+      std::memcpy(&size, record, sizeof(size));
+      if (size & kPaddingFlag) {
+        tail += size & ~kPaddingFlag;
+        continue;
+      }
+      RecordHeader header;
+      std::memcpy(&header, record, sizeof(header));
+      BinLogRecord out;
+      out.site = header.site;
+      out.wall_ns = header.wall_ns;
+      out.tid = header.tid;
+      out.message = Format(*header.site, record + sizeof(RecordHeader), header.size - sizeof(RecordHeader));
+      records.push_back(std::move(out));
+      tail += header.size;
+    }
+    // 格式化完才归还空间
+    b->tail.store(tail, std::memory_order_release);
+  }
+
+  // 各线程内已按时间有序，合并成全局时间序
+  std::stable_sort(records.begin(), records.end(),
+                   [](const BinLogRecord &a, const BinLogRecord &b) { return a.wall_ns < b.wall_ns; });
+  uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+  if (dropped > reported_dropped_) {
+    BinLogRecord warn;
+    warn.site = &kDroppedSite;
+    warn.wall_ns = WallNanos();
+    warn.tid = CurrentTid();
+    warn.message = "binlog: " + std::to_string(dropped - reported_dropped_) + " messages dropped (thread buffer full)";
+    records.push_back(std::move(warn));
+    reported_dropped_ = dropped;
+  }
+  for (const BinLogRecord &record : records) Emit(record);
+  return records.size();
+}
+
+// ============================================================================
+// 输出
+// ============================================================================
+
+void BinLogger::SetSink(Sink sink) {
+  std::lock_guard<std::mutex> lock(sink_mutex_);
+  sink_ = std::move(sink);
+}
+
+void BinLogger::Emit(const BinLogRecord &record) {
+  std::lock_guard<std::mutex> lock(sink_mutex_);
+  if (sink_) {
+    sink_(record);
+    return;
+  }
+  // 默认：[2024-01-01 12:00:00.123] [info] message
+  time_t secs = static_cast<time_t>(record.wall_ns / 1000000000ULL);
+  unsigned millis = static_cast<unsigned>(record.wall_ns / 1000000ULL % 1000);
+  tm t;
+  localtime_r(&secs, &t);
+  char ts[32];
+  std::strftime(ts, sizeof(ts), "%Y-%m-%d %H:%M:%S", &t);
+  std::fprintf(stdout, "[%s.%03u] [%s] %s\n", ts, millis, BinLogLevelName(record.site->level), record.message.c_str());
+}
+
+// ============================================================================
+// 格式化
+// ============================================================================
+
+namespace {
+
+struct DecodedArg {
+  ArgType type;
+  int64_t i = 0;
+  uint64_t u = 0;
+  double d = 0;
+  std::string s;
+};
+
+std::vector<DecodedArg> Decode(const char *p, size_t len) {
+  std::vector<DecodedArg> args;
+  const char *end = p + len;
+  while (p < end && *p != 0) {
+    DecodedArg arg;
+    arg.type = static_cast<ArgType>(*p++);
+    size_t need = arg.type == ArgType::kBool || arg.type == ArgType::kChar ? 1
+                  : arg.type == ArgType::kStr                             ? sizeof(uint32_t)
+                                                                          : 8;
+    if (static_cast<size_t>(end - p) < need) break;
+    switch (arg.type) {
+      case ArgType::kInt: std::memcpy(&arg.i, p, 8); break;
+      case ArgType::kUint:
+      case ArgType::kPtr: std::memcpy(&arg.u, p, 8); break;
+      case ArgType::kDouble: std::memcpy(&arg.d, p, 8); break;
+      case ArgType::kBool: arg.u = static_cast<uint8_t>(*p); break;
+      case ArgType::kChar: arg.i = *p; break;
+      case ArgType::kStr: {
+        uint32_t n;
+        std::memcpy(&n, p, sizeof(n));
+        if (static_cast<size_t>(end - p - sizeof(n)) < n) return args;
+        arg.s.assign(p + sizeof(n), n);
+        p += n;
+        break;
+      }
+      default: return args;
+    }
+    p += need;
+    args.push_back(std::move(arg));
+  }
+  return args;
+}
+
+template <typename T>
+void AppendPrintf(std::string *out, const std::string &spec, T value) {
+  char buf[128];
+  int n = std::snprintf(buf, sizeof(buf), spec.c_str(), value);
+  if (n < 0) return;
+  if (static_cast<size_t>(n) < sizeof(buf)) {
+    out->append(buf, static_cast<size_t>(n));
+    return;
+  }
+  std::string big(static_cast<size_t>(n) + 1, '\0');
+  std::snprintf(&big[0], big.size(), spec.c_str(), value);
+  out->append(big.data(), static_cast<size_t>(n));
+}
+
+bool IsFloatConv(char c) { return c != 0 && std::strchr("fFeEgGaA", c) != nullptr; }
+bool IsIntConv(char c) { return c != 0 && std::strchr("diuoxX", c) != nullptr; }
+
+/**
+ * @brief 按一个转换说明输出参数
+ * @param flags printf 的标志、宽度与精度 (如 "-08.3")
+ * @param conv 转换字符；0 表示按参数类型的默认格式 ({} 占位)
+ * @details 参数类型与转换字符不匹配时按参数本身的类型输出，不会像 printf 那样读错参数
+ */
+void AppendArg(std::string *out, const DecodedArg &arg, const std::string &flags, char conv) {
+  std::string spec = "%" + flags;
+  switch (arg.type) {
+    case ArgType::kBool:
+      if (conv == 0 || conv == 's') {
+        AppendPrintf(out, spec + "s", arg.u ? "true" : "false");
+        return;
+      }
+      // 其余按整数处理
+      [[fallthrough]];
+    case ArgType::kInt:
+    case ArgType::kUint:
+    case ArgType::kChar: {
+      bool is_signed = arg.type == ArgType::kInt || arg.type == ArgType::kChar;
+      int64_t sv = arg.type == ArgType::kBool ? static_cast<int64_t>(arg.u) : arg.i;
+      uint64_t uv = is_signed ? static_cast<uint64_t>(sv) : arg.u;
+      if (conv == 'c' || (conv == 0 && arg.type == ArgType::kChar)) {
+        AppendPrintf(out, spec + "c", static_cast<int>(is_signed ? sv : static_cast<int64_t>(uv)));
+      } else if (IsFloatConv(conv)) {
+        AppendPrintf(out, spec + conv, is_signed ? static_cast<double>(sv) : static_cast<double>(uv));
+      } else if (conv == 'x' || conv == 'X' || conv == 'o' || conv == 'u' || (!is_signed && !IsIntConv(conv))) {
+        char c = (conv == 'x' || conv == 'X' || conv == 'o') ? conv : 'u';
+        AppendPrintf(out, spec + "ll" + c, static_cast<unsigned long long>(uv));
+      } else {
+        AppendPrintf(out, spec + "lld", static_cast<long long>(is_signed ? sv : static_cast<int64_t>(uv)));
+      }
+      return;
+    }
+    case ArgType::kDouble:
+      AppendPrintf(out, spec + (IsFloatConv(conv) ? conv : 'g'), arg.d);
+      return;
+    case ArgType::kPtr:
+      AppendPrintf(out, spec + "p", reinterpret_cast<void *>(static_cast<uintptr_t>(arg.u)));
+      return;
+    case ArgType::kStr:
+      AppendPrintf(out, spec + "s", arg.s.c_str());
+      return;
+  }
+}
+
+// 读 printf 的 "[-+ #0]*[width][.precision]"，返回停下的位置
+const char *ParseFlags(const char *p, std::string *flags) {
+  while (*p && std::strchr("-+ #0", *p)) flags->push_back(*p++);
+  while (*p >= '0' && *p <= '9') flags->push_back(*p++);
+  if (*p == '.') {
+    flags->push_back(*p++);
+    while (*p >= '0' && *p <= '9') flags->push_back(*p++);
+  }
+  return p;
+}
+
+// printf 风格：%[flags][width][.precision][length]conv
+std::string FormatPrintf(const char *fmt, const std::vector<DecodedArg> &args) {
+  std::string out;
+  size_t next = 0;
+  for (const char *p = fmt; *p;) {
+    if (*p != '%') {
+      out.push_back(*p++);
+      continue;
+    }
+    const char *start = p++;
+    if (*p == '%') {
+      out.push_back('%');
+      ++p;
+      continue;
+    }
+    std::string flags;
+    p = ParseFlags(p, &flags);
+    while (*p && std::strchr("hlLqjzt", *p)) ++p;  // 长度修饰符：参数已按 64 位保存
+    char conv = *p;
+    if (conv == 0 || next >= args.size()) {
+      out.append(start, conv ? p + 1 - start : p - start);
+      if (conv) ++p;
+      continue;
+    }
+    ++p;
+    AppendArg(&out, args[next++], flags, conv == 'i' ? 'd' : conv);
+  }
+  return out;
+}
+
+// {} 风格：{} / {:spec}，spec = [<>^][+ ][#][0][width][.precision][type]；{{ }} 转义
+std::string FormatBraces(const char *fmt, const std::vector<DecodedArg> &args) {
+  std::string out;
+  size_t next = 0;
+  for (const char *p = fmt; *p;) {
+    if (*p == '}' && p[1] == '}') {
+      out.push_back('}');
+      p += 2;
+      continue;
+    }
+    if (*p != '{') {
+      out.push_back(*p++);
+      continue;
+    }
+    if (p[1] == '{') {
+      out.push_back('{');
+      p += 2;
+      continue;
+    }
+    const char *close = std::strchr(p, '}');
+    if (!close || next >= args.size()) {
+      // 没有对应的参数：原样输出
+      const char *stop = close ? close + 1 : p + std::strlen(p);
+      out.append(p, stop);
+      p = stop;
+      continue;
+    }
+    std::string flags;
+    char conv = 0;
+    const char *colon = static_cast<const char *>(std::memchr(p, ':', close - p));
+    if (colon) {
+      const char *q = colon + 1;
+      if (q < close && std::strchr("<>^", *q)) {
+        if (*q == '<') flags.push_back('-');
+        ++q;
+      }
+      std::string spec(q, close);
+      const char *s = ParseFlags(spec.c_str(), &flags);
+      if (*s && s[1] == 0) conv = *s;
+    }
+    AppendArg(&out, args[next++], flags, conv);
+    p = close + 1;
+  }
+  return out;
+}
+
+}  // namespace
+
+std::string BinLogger::Format(const BinLogSite &site, const char *args, size_t len) {
+  std::vector<DecodedArg> decoded = Decode(args, len);
+  return site.printf_style ? FormatPrintf(site.fmt, decoded) : FormatBraces(site.fmt, decoded);
+}
@@ -0,0 +1,324 @@
+#include "include/cpu_topology.h"
+
+#include <dirent.h>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <tuple>
+
+// ============================================================================
+// CPU 列表
+// ============================================================================
+
+bool ParseCpuList(const std::string &text, std::vector<int> *cpus) {
+  std::set<int> out;
+  size_t pos = 0;
+  std::string s;
+  for (char c : text) {
+    if (c != ' ' && c != '\n' && c != '\t') s.push_back(c);
+  }
+  if (s.empty()) return false;
+  while (pos <= s.size()) {
+    size_t comma = s.find(',', pos);
+    std::string item = s.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+    if (item.empty()) return false;
+    size_t dash = item.find('-');
+    char *end = nullptr;
+    long lo = std::strtol(item.c_str(), &end, 10);
+    if (end == item.c_str() || lo < 0) return false;
+    long hi = lo;
+    if (dash != std::string::npos) {
+      if (static_cast<size_t>(end - item.c_str()) != dash) return false;
+      const char *rest = item.c_str() + dash + 1;
+      hi = std::strtol(rest, &end, 10);
+      if (end == rest || hi < lo) return false;
+    }
+    if (*end != '\0' || hi >= CPU_SETSIZE) return false;
+    for (long c = lo; c <= hi; ++c) out.insert(static_cast<int>(c));
+    if (comma == std::string::npos) break;
+    pos = comma + 1;
+  }
+  cpus->assign(out.begin(), out.end());
+  return true;
+}
+
+std::string FormatCpuList(const std::vector<int> &cpus) {
+  std::vector<int> sorted(cpus);
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+  std::string out;
+  for (size_t i = 0; i < sorted.size();) {
+    size_t j = i;
+    while (j + 1 < sorted.size() && sorted[j + 1] == sorted[j] + 1) ++j;
+    if (!out.empty()) out += ',';
+    out += std::to_string(sorted[i]);
+    if (j > i) out += '-' + std::to_string(sorted[j]);
+    i = j + 1;
+  }
+  return out;
+}
+
+// ============================================================================
+// CpuTopology
+// ============================================================================
+
+static bool ReadFile(const std::string &path, std::string *out) {
+  std::ifstream in(path);
+  if (!in) return false;
+  std::getline(in, *out);
+  return true;
+}
+
+CpuTopology CpuTopology::Detect(const std::string &root) {
+  std::vector<std::vector<int>> nodes;
+  if (DIR *dir = ::opendir((root + "/node").c_str())) {
+    while (dirent *entry = ::readdir(dir)) {
+      std::string name = entry->d_name;
+      if (name.size() <= 4 || name.compare(0, 4, "node") != 0 ||
+          name.find_first_not_of("0123456789", 4) != std::string::npos) {
+        continue;
+      }
+      int node = std::atoi(name.c_str() + 4);
+      std::string text;
+      std::vector<int> cpus;
+      // 没有 CPU 的 node (纯内存 node) cpulist 为空行
+      if (!ReadFile(root + "/node/" + name + "/cpulist", &text)) continue;
+      if (!text.empty() && !ParseCpuList(text, &cpus)) continue;
+      if (static_cast<int>(nodes.size()) <= node) nodes.resize(node + 1);
+      nodes[node] = cpus;
+    }
+    ::closedir(dir);
+  }
+  bool any = std::any_of(nodes.begin(), nodes.end(), [](const std::vector<int> &c) { return !c.empty(); });
+  if (!any) {
+    // 没有 NUMA 信息 (容器里没挂 sysfs、内核未开启 NUMA)：所有在线 CPU 视为一个 node
+    std::string text;
+    std::vector<int> cpus;
+    if (!ReadFile(root + "/cpu/online", &text) || !ParseCpuList(text, &cpus)) {
+      long n = ::sysconf(_SC_NPROCESSORS_ONLN);
+      for (long i = 0; i < std::max(1L, n); ++i) cpus.push_back(static_cast<int>(i));
+    }
+    nodes.assign(1, cpus);
+  }
+  return CpuTopology(std::move(nodes));
+}
+
+CpuTopology::CpuTopology(std::vector<std::vector<int>> node_cpus) : node_cpus_(std::move(node_cpus)) {
+  if (node_cpus_.empty()) node_cpus_.resize(1);
+  for (size_t node = 0; node < node_cpus_.size(); ++node) {
+    std::vector<int> &cpus = node_cpus_[node];
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    for (int cpu : cpus) {
+      cpu_node_[cpu] = static_cast<int>(node);
+      all_cpus_.push_back(cpu);
+    }
+  }
+  std::sort(all_cpus_.begin(), all_cpus_.end());
+}
+
+const std::vector<int> &CpuTopology::NodeCpus(int node) const {
+  static const std::vector<int> kEmpty;
+  if (node < 0 || node >= NumNodes()) return kEmpty;
+  return node_cpus_[node];
+}
+
+int CpuTopology::NodeOfCpu(int cpu) const {
+  auto it = cpu_node_.find(cpu);
+  return it == cpu_node_.end() ? -1 : it->second;
+}
+
+// ============================================================================
+// ThreadPlacement
+// ============================================================================
+
+const std::vector<std::string> &ThreadPlacement::Groups() {
+  static const std::vector<std::string> groups = {kPlacementRaft, kPlacementApply, kPlacementLog,
+                                                  kPlacementRpcIo, kPlacementRpcWorker, kPlacementRpcClient,
+                                                  kPlacementGrpc, kPlacementRuntime};
+  return groups;
+}
+
+// 前一半 / 后一半 (至少一个核；只有一个核时两边相同)
+static std::pair<std::vector<int>, std::vector<int>> SplitHalf(const std::vector<int> &cpus) {
+  if (cpus.size() <= 1) return {cpus, cpus};
+  size_t first = (cpus.size() + 1) / 2;
+  return {std::vector<int>(cpus.begin(), cpus.begin() + first), std::vector<int>(cpus.begin() + first, cpus.end())};
+}
+
+std::map<std::string, std::vector<int>> ThreadPlacement::AutoLayout(const CpuTopology &topology) {
+  std::vector<int> raft_side;
+  std::vector<int> io_side;
+  for (int node = 0; node < topology.NumNodes(); ++node) {
+    const std::vector<int> &cpus = topology.NodeCpus(node);
+    if (cpus.empty()) continue;
+    if (raft_side.empty()) {
+      raft_side = cpus;
+    } else {
+      io_side.insert(io_side.end(), cpus.begin(), cpus.end());
+    }
+  }
+  if (io_side.empty()) {
+    // 单 node：对半分
+    std::tie(raft_side, io_side) = SplitHalf(raft_side);
+  }
+  auto raft = SplitHalf(raft_side);
+  auto io = SplitHalf(io_side);
+
+  std::map<std::string, std::vector<int>> layout;
+  layout[kPlacementRaft] = raft.first;
+  layout[kPlacementApply] = raft.second;
+  layout[kPlacementLog] = raft.second;
+  layout[kPlacementRpcIo] = io.first;
+  layout[kPlacementRpcClient] = io.first;
+  layout[kPlacementGrpc] = io.first;
+  layout[kPlacementRpcWorker] = io.second;
+  layout[kPlacementRuntime] = io.second;
+  return layout;
+}
+
+bool ThreadPlacement::Configure(const CpuTopology &topology, const std::map<std::string, std::string> &specs,
+                                std::string *error) {
+  std::map<std::string, std::vector<int>> groups = AutoLayout(topology);
+  for (const auto &kv : specs) {
+    const std::string &group = kv.first;
+    const std::string &spec = kv.second;
+    if (std::find(Groups().begin(), Groups().end(), group) == Groups().end()) {
+      if (error) *error = "unknown thread group: " + group;
+      return false;
+    }
+    std::vector<int> cpus;
+    if (spec.compare(0, 4, "node") == 0) {
+      char *end = nullptr;
+      long node = std::strtol(spec.c_str() + 4, &end, 10);
+      if (end == spec.c_str() + 4 || *end != '\0' || node < 0 || node >= topology.NumNodes() ||
+          topology.NodeCpus(static_cast<int>(node)).empty()) {
+        if (error) *error = "invalid node for " + group + ": " + spec;
+        return false;
+      }
+      cpus = topology.NodeCpus(static_cast<int>(node));
+    } else if (!ParseCpuList(spec, &cpus)) {
+      if (error) *error = "invalid cpu list for " + group + ": " + spec;
+      return false;
+    }
+    for (int cpu : cpus) {
+      if (topology.NodeOfCpu(cpu) < 0) {
+        if (error) *error = "cpu " + std::to_string(cpu) + " of " + group + " is not online";
+        return false;
+      }
+    }
+    groups[group] = cpus;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  groups_ = std::move(groups);
+  topology_ = topology;
+  enabled_ = true;
+  return true;
+}
+
+void ThreadPlacement::Disable() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  enabled_ = false;
+  groups_.clear();
+}
+
+bool ThreadPlacement::Enabled() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return enabled_;
+}
+
+std::vector<int> ThreadPlacement::Cpus(const std::string &group) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!enabled_) return {};
+  auto it = groups_.find(group);
+  return it == groups_.end() ? std::vector<int>() : it->second;
+}
+
+bool ThreadPlacement::Isolated() const {
+  std::vector<int> raft = Cpus(kPlacementRaft);
+  if (raft.empty()) return false;
+  for (const char *io : {kPlacementRpcIo, kPlacementRpcClient, kPlacementGrpc}) {
+    for (int cpu : Cpus(io)) {
+      if (std::find(raft.begin(), raft.end(), cpu) != raft.end()) return false;
+    }
+  }
+  return true;
+}
+
+std::string ThreadPlacement::Describe() const {
+  std::string out;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!enabled_) return out;
+  for (const std::string &group : Groups()) {
+    auto it = groups_.find(group);
+    if (it == groups_.end() || it->second.empty()) continue;
+    const std::vector<int> &cpus = it->second;
+    std::set<int> nodes;
+    for (int cpu : cpus) nodes.insert(topology_.NodeOfCpu(cpu));
+    std::vector<int> node_list(nodes.begin(), nodes.end());
+    out += group + ": " + FormatCpuList(cpus) + " (node " + FormatCpuList(node_list) + ")\n";
+  }
+  return out;
+}
+
+bool ThreadPlacement::PinCurrentThread(const std::string &group, int index) const {
+  std::vector<int> cpus = Cpus(group);
+  if (cpus.empty()) return false;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (index >= 0) {
+    CPU_SET(cpus[static_cast<size_t>(index) % cpus.size()], &set);
+  } else {
+    for (int cpu : cpus) CPU_SET(cpu, &set);
+  }
+  return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+}
+
+// ============================================================================
+// 本地内存
+// ============================================================================
+
+int CurrentNumaNode() {
+  int cpu = ::sched_getcpu();
+  int node = cpu >= 0 ? CpuTopology::GetInstance().NodeOfCpu(cpu) : -1;
+  return node >= 0 ? node : 0;
+}
+
+bool BindToNode(void *addr, size_t len, int node) {
+  const CpuTopology &topology = CpuTopology::GetInstance();
+  if (topology.NumNodes() <= 1 || node < 0 || node >= topology.NumNodes() || !addr || len == 0) return false;
+  constexpr size_t kBits = 8 * sizeof(unsigned long);
+  std::vector<unsigned long> mask(static_cast<size_t>(node) / kBits + 1, 0);
+  mask[static_cast<size_t>(node) / kBits] |= 1UL << (static_cast<size_t>(node) % kBits);
+  // 用 syscall 而不是 libnuma：不引入额外依赖；PREFERRED 在本地 node 内存不足时回退到其他 node
+  long rc = ::syscall(SYS_mbind, addr, len, MPOL_PREFERRED, mask.data(), mask.size() * kBits + 1, 0);
+  return rc == 0;
+}
+
+static size_t PageRound(size_t len) {
+  size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+  return (len + page - 1) / page * page;
+}
+
+void *AllocOnNode(size_t len, int node) {
+  if (len == 0) return nullptr;
+  size_t size = PageRound(len);
+  void *addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED) return nullptr;
+  // 在第一次写之前设置策略，缺页时才真正在 node 上分配
+  if (node >= 0) BindToNode(addr, size, node);
+  return addr;
+}
+
+void FreeOnNode(void *addr, size_t len) {
+  if (addr && len > 0) ::munmap(addr, PageRound(len));
+}
@@ -0,0 +1,293 @@
+#ifndef BINLOG_H
+#define BINLOG_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @file binlog.h
+ * @brief 热路径日志：调用线程只把参数按二进制拷进本线程的无锁缓冲区，格式化推迟到后台线程
+ * @details
+ * 1. 编译期过滤：低于 BINLOG_ACTIVE_LEVEL 的 BLOG_* 调用展开为 if constexpr (false)，参数不求值、不生成代码；
+ *    DPrintf (util.h) 另受 config.h 的 Debug 控制；
+ * 2. 运行期过滤：SetLevel，被过滤的调用只多一次 relaxed load，同样不求值参数；
+ * 3. 记录：每个调用点一个静态的 BinLogSite (级别、文件、行号、格式串)，记录里只有它的指针、时间戳、线程号和参数。
+ *    整数 / 浮点 / 指针按值保存，字符串拷贝内容 (最多 kMaxStringArg 字节)。
+ *    每个线程一个单生产者单消费者的字节环，写满时丢弃并计数，从不阻塞调用线程；
+ * 4. 输出：后台线程每 interval (或某个缓冲区过半时被唤醒) 取走所有线程的记录，按时间戳合并、格式化后交给 sink。
+ *    MprpcApplication 把 sink 接到 spdlog 的 sinks 上，和 LOG_* 写进同一个文件；
+ * 5. 格式串：BLOG_* 用 "{}" 占位 (与 LOG_* 相同，支持 {:x} {:08d} {:.2f} 等 printf 能表达的格式)，
+ *    DPrintf 用 printf 的 "%d %s"。格式串必须是字符串字面量 (记录只保存指针)。
+ *
+ * 未 Start 时 (单元测试、工具程序) 在调用线程上同步格式化并交给 sink，默认 sink 写 stdout。
+ */
+
+#define BINLOG_LEVEL_TRACE 0
+#define BINLOG_LEVEL_DEBUG 1
+#define BINLOG_LEVEL_INFO 2
+#define BINLOG_LEVEL_WARN 3
+#define BINLOG_LEVEL_ERROR 4
+#define BINLOG_LEVEL_CRITICAL 5
+#define BINLOG_LEVEL_OFF 6
+
+// 编译期级别：与 SPDLOG_ACTIVE_LEVEL 一样默认全部编译，发布构建可以 -DBINLOG_ACTIVE_LEVEL=BINLOG_LEVEL_INFO
+#ifndef BINLOG_ACTIVE_LEVEL
+#define BINLOG_ACTIVE_LEVEL BINLOG_LEVEL_TRACE
+#endif
+
+// 取值与 spdlog::level::level_enum 相同
+enum class BinLogLevel : uint8_t {
+  kTrace = BINLOG_LEVEL_TRACE,
+  kDebug = BINLOG_LEVEL_DEBUG,
+  kInfo = BINLOG_LEVEL_INFO,
+  kWarn = BINLOG_LEVEL_WARN,
+  kError = BINLOG_LEVEL_ERROR,
+  kCritical = BINLOG_LEVEL_CRITICAL,
+  kOff = BINLOG_LEVEL_OFF,
+};
+
+const char *BinLogLevelName(BinLogLevel level);
+
+// 调用点的静态信息：每个 BLOG_* 展开处一个 static constexpr 实例
+struct BinLogSite {
+  BinLogLevel level;
+  bool printf_style;  // true：格式串用 %d / %s (DPrintf)；false：用 {} (BLOG_*)
+  const char *file;
+  int line;
+  const char *fmt;
+};
+
+// 交给 sink 的一条日志
+struct BinLogRecord {
+  const BinLogSite *site = nullptr;
+  uint64_t wall_ns = 0;  // system_clock，记录时刻 (不是格式化时刻)
+  uint32_t tid = 0;      // 写入线程的 gettid
+  std::string message;   // 格式化后的正文
+};
+
+namespace binlog_detail {
+
+// 0 保留给对齐填充：解码遇到 0 即结束
+enum class ArgType : uint8_t { kInt = 1, kUint, kDouble, kBool, kChar, kPtr, kStr };
+
+constexpr size_t kMaxStringArg = 1024;  // 单个字符串参数最多保留的字节数，超出截断
+
+template <typename T>
+inline char *Put(char *p, ArgType type, const T &value) {
+  *p++ = static_cast<char>(type);
+  std::memcpy(p, &value, sizeof(T));
+  return p + sizeof(T);
+}
+
+inline size_t StrSize(const char *s, size_t len) { return 1 + sizeof(uint32_t) + (s ? len : 6); }
+
+inline char *PutStr(char *p, const char *s, size_t len) {
+  if (!s) {
+    s = "(null)";
+    len = 6;
+  }
+  uint32_t n = static_cast<uint32_t>(len);
+  p = Put(p, ArgType::kStr, n);
+  std::memcpy(p, s, len);
+  return p + len;
+}
+
+inline size_t CStrLen(const char *s) { return s ? ::strnlen(s, kMaxStringArg) : 0; }
+
+// 每种参数类型的编码：Size 为编码后的字节数，Encode 写入并返回下一个位置
+template <typename T, typename Enable = void>
+struct Arg {
+  static_assert(sizeof(T) == 0, "BLOG_* 只支持整数、浮点、bool、char、枚举、指针和字符串参数");
+};
+
+template <>
+struct Arg<bool> {
+  static size_t Size(bool) { return 2; }
+  static char *Encode(char *p, bool v) { return Put(p, ArgType::kBool, static_cast<uint8_t>(v)); }
+};
+
+template <>
+struct Arg<char> {
+  static size_t Size(char) { return 2; }
+  static char *Encode(char *p, char v) { return Put(p, ArgType::kChar, v); }
+};
+
+template <typename T>
+struct Arg<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value &&
+                                      !std::is_same<T, char>::value>::type> {
+  static size_t Size(T) { return 9; }
+  static char *Encode(char *p, T v) {
+    if (std::is_signed<T>::value) return Put(p, ArgType::kInt, static_cast<int64_t>(v));
+    return Put(p, ArgType::kUint, static_cast<uint64_t>(v));
+  }
+};
+
+template <typename T>
+struct Arg<T, typename std::enable_if<std::is_enum<T>::value>::type> {
+  using Under = typename std::underlying_type<T>::type;
+  static size_t Size(T) { return 9; }
+  static char *Encode(char *p, T v) { return Arg<Under>::Encode(p, static_cast<Under>(v)); }
+};
+
+template <typename T>
+struct Arg<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+  static size_t Size(T) { return 9; }
+  static char *Encode(char *p, T v) { return Put(p, ArgType::kDouble, static_cast<double>(v)); }
+};
+
+template <typename T>
+struct Arg<T *> {
+  static size_t Size(const T *) { return 9; }
+  static char *Encode(char *p, const T *v) { return Put(p, ArgType::kPtr, reinterpret_cast<uintptr_t>(v)); }
+};
+
+template <>
+struct Arg<const char *> {
+  static size_t Size(const char *s) { return StrSize(s, CStrLen(s)); }
+  static char *Encode(char *p, const char *s) { return PutStr(p, s, CStrLen(s)); }
+};
+
+template <>
+struct Arg<char *> : Arg<const char *> {};
+
+template <>
+struct Arg<std::string_view> {
+  static size_t Size(std::string_view s) { return StrSize(s.data(), std::min(s.size(), kMaxStringArg)); }
+  static char *Encode(char *p, std::string_view s) {
+    return PutStr(p, s.data() ? s.data() : "", std::min(s.size(), kMaxStringArg));
+  }
+};
+
+template <>
+struct Arg<std::string> : Arg<std::string_view> {};
+
+template <typename T>
+using ArgOf = Arg<typename std::decay<T>::type>;
+
+}  // namespace binlog_detail
+
+class BinLogger {
+ public:
+  using Sink = std::function<void(const BinLogRecord &)>;
+
+  static BinLogger &GetInstance() {
+    static BinLogger instance;
+    return instance;
+  }
+
+  void SetLevel(BinLogLevel level) { level_.store(static_cast<uint8_t>(level), std::memory_order_relaxed); }
+  BinLogLevel Level() const { return static_cast<BinLogLevel>(level_.load(std::memory_order_relaxed)); }
+  bool ShouldLog(BinLogLevel level) const {
+    return static_cast<uint8_t>(level) >= level_.load(std::memory_order_relaxed);
+  }
+
+  // 替换输出目标 (空表示默认的 stdout)；sink 总是串行调用
+  void SetSink(Sink sink);
+
+  /**
+   * @brief 启动后台格式化线程
+   * @param buffer_bytes 每个线程缓冲区的大小 (向上取整到 2 的幂，已建好的缓冲区保持原大小)
+   * @param interval 后台线程的最长等待时间 (决定日志出现在文件里的延迟)
+   * @param on_thread_start 在后台线程上先执行一次 (例如绑核)
+   * @return 已启动时返回 false
+   */
+  bool Start(size_t buffer_bytes, std::chrono::milliseconds interval,
+             std::function<void()> on_thread_start = nullptr);
+
+  // 停止后台线程并写出已提交的记录；之后的调用回到同步模式
+  void Stop();
+
+  bool Running() const { return running_.load(std::memory_order_acquire); }
+
+  // 等到调用之前提交的记录都交给了 sink (未启动时立即返回)
+  void Flush();
+
+  // 因缓冲区满丢弃的条数 (累计)
+  uint64_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  // 写一条记录 (由 BLOG_* / DPrintf 调用，级别已检查过)
+  template <typename... Args>
+  void Log(const BinLogSite &site, const Args &...args) {
+    size_t size = (size_t{0} + ... + binlog_detail::ArgOf<Args>::Size(args));
+    char *p = BeginRecord(site, size);
+    if (!p) return;
+    ((p = binlog_detail::ArgOf<Args>::Encode(p, args)), ...);
+    (void)p;
+    EndRecord();
+  }
+
+  // 按 site 的格式串把二进制参数格式化成正文 (后台线程调用，测试也可直接用)
+  static std::string Format(const BinLogSite &site, const char *args, size_t len);
+
+ private:
+  struct Buffer;
+
+  BinLogger();
+  ~BinLogger();
+
+  // 预留 args_size 字节的参数区；缓冲区满时返回 nullptr (此时不调用 EndRecord)
+  char *BeginRecord(const BinLogSite &site, size_t args_size);
+  // 发布记录 (同步模式下直接格式化输出)
+  void EndRecord();
+
+  Buffer *LocalBuffer();
+  void Run(std::function<void()> on_thread_start);
+  // 取走所有缓冲区中已提交的记录并交给 sink，返回条数
+  size_t Drain();
+  void Emit(const BinLogRecord &record);
+
+  std::atomic<uint8_t> level_{static_cast<uint8_t>(BinLogLevel::kTrace)};
+  std::atomic<bool> running_{false};
+  std::atomic<bool> wake_{false};  // 有缓冲区过半，后台线程提前醒来
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<size_t> buffer_bytes_{0};
+
+  std::mutex mutex_;  // buffers_、后台线程的启停与 Flush
+  std::condition_variable cv_;
+  std::condition_variable flushed_cv_;
+  std::vector<std::unique_ptr<Buffer>> buffers_;  // 只增不减：线程退出后由新线程复用
+  std::thread thread_;
+  std::chrono::milliseconds interval_{0};
+  bool stop_ = false;
+  uint64_t flush_requested_ = 0;
+  uint64_t flush_done_ = 0;
+
+  std::mutex drain_mutex_;  // Drain 串行 (后台线程与 Stop 的收尾)
+  uint64_t reported_dropped_ = 0;
+
+  std::mutex sink_mutex_;
+  Sink sink_;
+};
+
+// 记一条日志：编译期低于 BINLOG_ACTIVE_LEVEL 时整条去掉，运行期低于 SetLevel 时不求值参数
+#define BINLOG_LOG(level, printf_style, fmt, ...)                                                  \
+  do {                                                                                             \
+    if constexpr (static_cast<int>(level) >= BINLOG_ACTIVE_LEVEL) {                                \
+      if (BinLogger::GetInstance().ShouldLog(level)) {                                             \
+        static constexpr BinLogSite binlog_site_{level, printf_style, __FILE__, __LINE__, fmt};    \
+        BinLogger::GetInstance().Log(binlog_site_, ##__VA_ARGS__);                                 \
+      }                                                                                            \
+    }                                                                                              \
+  } while (0)
+
+#define BLOG_TRACE(fmt, ...) BINLOG_LOG(BinLogLevel::kTrace, false, fmt, ##__VA_ARGS__)
+#define BLOG_DEBUG(fmt, ...) BINLOG_LOG(BinLogLevel::kDebug, false, fmt, ##__VA_ARGS__)
+#define BLOG_INFO(fmt, ...) BINLOG_LOG(BinLogLevel::kInfo, false, fmt, ##__VA_ARGS__)
+#define BLOG_WARN(fmt, ...) BINLOG_LOG(BinLogLevel::kWarn, false, fmt, ##__VA_ARGS__)
+#define BLOG_ERROR(fmt, ...) BINLOG_LOG(BinLogLevel::kError, false, fmt, ##__VA_ARGS__)
+#define BLOG_CRITICAL(fmt, ...) BINLOG_LOG(BinLogLevel::kCritical, false, fmt, ##__VA_ARGS__)
+
+#endif  // BINLOG_H
@@ -5,16 +5,75 @@ const bool Debug = true;
 
 const int debugMul = 1;  // 时间单位：time.Millisecond，不同网络环境rpc速度不同，因此需要乘以一个系数
 const int HeartBeatTimeout = 25 * debugMul;  // 心跳时间一般要比选举超时小一个数量级
-const int ApplyInterval = 10 * debugMul;     //	日志应用间隔时长
+const int ApplyInterval = 10 * debugMul;     //	日志应用间隔时长 (旧的轮询式 apply；ApplyPipeline 由 commit 推进直接唤醒)
 
 const int minRandomizedElectionTime = 300 * debugMul;  // ms  最小选举超时时间
 const int maxRandomizedElectionTime = 500 * debugMul;  // ms  最大选举超时时间
 
 const int CONSENSUS_TIMEOUT = 500 * debugMul;  // ms
 
+// apply 流水线：一批最多取多少条已提交日志交给状态机 (一次 SkipList 写锁)
+
+const int APPLY_BATCH_MAX_ENTRIES = 256;
+const int APPLY_BATCH_MAX_BYTES = 4 * 1024 * 1024;
+
+// 提交合并：leader 把并发到达的客户端写合并进一条日志
+
+const int PROPOSAL_BATCH_MAX_OPS = 128;                 // 一条合并日志最多的客户端命令数
+const int PROPOSAL_BATCH_MAX_BYTES = 1024 * 1024;       // 一条合并日志最多的字节数
+const int PROPOSAL_MAX_LINGER_US = 200;                 // 高负载时最多为凑批等待多久；低负载时不等待
+
+// 请求追踪：根 span 的采样率 (0 关闭；rpc.ini 的 trace.sample_rate 可覆盖)
+
+const double TRACE_SAMPLE_RATE = 0.0;
+
 // 协程相关设置
 
 const int FIBER_THREAD_NUM = 1;              // 协程库中线程池大小
 const bool FIBER_USE_CALLER_THREAD = false;  // 是否使用caller_thread执行调度任务
 
+// Raft RPC 相关设置
+
+const int RAFT_RPC_CQ_NUM = 4;                  // 异步 RPC 的 CompletionQueue / Poller 线程数，0 表示按 CPU 核数
+const bool RAFT_RPC_RESUME_ON_CALLER = true;    // RPC 完成后回到发起协程所在的 IOManager 线程执行回调
+
+// 投票 / 日志复制 / 心跳的自适应超时：clamp(该 peer 最近的 p99 * 倍数, 下限, 上限)
+const int RAFT_RPC_TIMEOUT_MS = 100;                              // 该 peer 样本不足时的超时
+const int RAFT_RPC_MIN_TIMEOUT_MS = 20;
+const int RAFT_RPC_MAX_TIMEOUT_MS = minRandomizedElectionTime / 2;  // 一次超时不能吃掉整个选举超时
+const double RAFT_RPC_TIMEOUT_P99_MULTIPLIER = 3.0;
+
+// 线性一致性读 (ReadIndex) 相关设置
+
+const bool RAFT_LEASE_READ = false;               // 领导人租约读：租约内不再发心跳确认 (依赖各节点时钟频率偏差有界)
+const int RAFT_LEASE_CLOCK_DRIFT_MS = HeartBeatTimeout * 2;  // 租约 = 最小选举超时 - 该余量
+
+// 选举与领导权转移
+
+const bool RAFT_PRE_VOTE = true;        // 正式选举前先预投票：分区节点回来时不会抬高任期、打断现任领导人
+const bool RAFT_CHECK_QUORUM = true;    // 领导人一个选举超时内收不到多数派回复即退位；follower 在领导人存活期间拒绝投票
+const int RAFT_TRANSFER_TIMEOUT_MS = maxRandomizedElectionTime;  // 领导权转移未在该时间内完成则放弃，恢复接受写
+
+// 成员变更
+
+const int RAFT_LEARNER_CATCHUP_ENTRIES = 128;  // learner 落后领导人不超过该条数才允许提升为 voter
+
+// Multi-Raft 区间分裂与负载均衡
+
+const int RANGE_SPLIT_MAX_MB = 64;                    // 区间数据 (SkipList arena) 超过该大小时分裂
+const int RANGE_SPLIT_MAX_QPS = 5000;                 // 区间读写 QPS 持续超过该值时分裂 (热点区间)
+const int RANGE_SPLIT_MIN_INTERVAL_MS = 60 * 1000;    // 同一区间两次分裂的最小间隔，防止抖动
+const int RANGE_LOAD_HALF_LIFE_MS = 10 * 1000;        // QPS 指数滑动平均的半衰期
+const int RANGE_LOAD_REPORT_INTERVAL_MS = 10 * 1000;  // 负载上报 ZooKeeper 的周期
+const double REBALANCE_TOLERANCE = 0.2;               // 节点负载超过集群均值 20% 才迁移
+
+// 线程与 NUMA 放置 (见 cpu_topology.h)
+
+const bool PLACEMENT_ENABLE = false;  // 默认不绑核；开启后未配置 placement.<group> 的线程组按 AutoLayout 分配
+
+// 二进制异步日志 (BLOG_* / DPrintf，见 binlog.h)
+
+const int BINLOG_BUFFER_KB = 1024;         // 每个线程的缓冲区大小，写满时丢弃 (不阻塞调用线程)
+const int BINLOG_FLUSH_INTERVAL_MS = 50;   // 后台线程格式化并写出的最长间隔
+
 #endif  // CONFIG_H
\ No newline at end of file
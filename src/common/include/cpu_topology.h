@@ -0,0 +1,135 @@
+#ifndef CPU_TOPOLOGY_H
+#define CPU_TOPOLOGY_H
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @file cpu_topology.h
+ * @brief CPU / NUMA 拓扑与线程组放置：每组线程绑定到指定的核，线程私有的内存在本地 node 上分配
+ * @details
+ * 1. 拓扑：启动时读 /sys/devices/system/node/node<N>/cpulist，没有 NUMA 信息时视为一个 node；
+ * 2. 线程组：按职责划分 (见下面的 kPlacement* 常量)，每组一个 CPU 集合，由配置 placement.<group> 指定
+ *    ("0-3,8" 形式的 CPU 列表，或 "node1" 表示该 node 的全部 CPU)，未配置的组按 AutoLayout 分配；
+ *    Raft 领导人的工作 (提案批处理、复制、WAL) 与客户端 IO 不共享核心，Isolated() 检查这一点；
+ * 3. 绑定：线程启动时调用 PinCurrentThread。带 index 时每个线程独占组内一个核 (reactor / 调度线程)，
+ *    不带 index 时在组内浮动 (同组有多个职责不同的线程)。未开启 (默认) 时是空操作，行为与之前相同；
+ * 4. 内存：Linux 默认 first-touch，绑核之后线程自己分配的内存已在本地 node。BindToLocalNode /
+ *    AllocOnNode 用于 "先分配、后使用" 或由其他线程分配的结构 (协程栈、调度器的线程上下文)。
+ *    只有一个 node 时都退化为普通的 mmap。
+ */
+
+// 线程组
+constexpr const char *kPlacementRaft = "raft";            // ProposalBatcher / ReplicationPipeline / RaftWal
+constexpr const char *kPlacementApply = "apply";          // ApplyPipeline
+constexpr const char *kPlacementLog = "log";              // spdlog 异步线程池
+constexpr const char *kPlacementRpcIo = "rpc_io";         // RpcProvider 的 muduo IO 线程 (客户端 IO)
+constexpr const char *kPlacementRpcWorker = "rpc_worker"; // RpcProvider 的业务线程池
+constexpr const char *kPlacementRpcClient = "rpc_client"; // RpcConnection 的接收 reactor
+constexpr const char *kPlacementGrpc = "grpc";            // gRPC 服务端线程 (继承启动线程的亲和性)
+constexpr const char *kPlacementRuntime = "runtime";      // 其余 monsoon 调度器
+
+// "0-3,8,10-11" <-> {0,1,2,3,8,10,11}；输出升序去重，格式错误返回 false
+bool ParseCpuList(const std::string &text, std::vector<int> *cpus);
+std::string FormatCpuList(const std::vector<int> &cpus);
+
+class CpuTopology {
+ public:
+  // 本机拓扑 (首次调用时探测)
+  static const CpuTopology &GetInstance() {
+    static CpuTopology instance = Detect();
+    return instance;
+  }
+
+  // 从 sysfs 探测；root 可指向测试构造的目录
+  static CpuTopology Detect(const std::string &root = "/sys/devices/system");
+
+  // 每个 node 的 CPU 列表 (node 编号 = 下标，空 node 保留位置)
+  explicit CpuTopology(std::vector<std::vector<int>> node_cpus);
+
+  int NumNodes() const { return static_cast<int>(node_cpus_.size()); }
+  const std::vector<int> &NodeCpus(int node) const;
+  const std::vector<int> &AllCpus() const { return all_cpus_; }
+  // 不认识的 CPU 返回 -1
+  int NodeOfCpu(int cpu) const;
+
+ private:
+  std::vector<std::vector<int>> node_cpus_;
+  std::vector<int> all_cpus_;
+  std::map<int, int> cpu_node_;
+};
+
+class ThreadPlacement {
+ public:
+  static ThreadPlacement &GetInstance() {
+    static ThreadPlacement instance;
+    return instance;
+  }
+
+  // 所有线程组
+  static const std::vector<std::string> &Groups();
+
+  /**
+   * @brief 配置各组的 CPU 集合 (进程启动、创建线程之前调用一次)
+   * @param specs group -> spec，spec 为 CPU 列表或 "node<N>"；未出现的组由 AutoLayout 补齐
+   * @param error 失败原因 (未知的组、格式错误、CPU 不在拓扑内)
+   * @return 失败时不改变已有配置
+   */
+  bool Configure(const CpuTopology &topology, const std::map<std::string, std::string> &specs,
+                 std::string *error = nullptr);
+
+  // 关闭放置：之后的 Pin 都是空操作 (已绑定的线程不受影响)
+  void Disable();
+  bool Enabled() const;
+
+  // 组的 CPU 集合；未开启或未知的组返回空
+  std::vector<int> Cpus(const std::string &group) const;
+
+  // Raft 组与客户端 IO 组 (rpc_io / rpc_client / grpc) 没有共享的核
+  bool Isolated() const;
+
+  // 每组一行 "group: cpus (node N)"，启动日志用
+  std::string Describe() const;
+
+  /**
+   * @brief 把当前线程绑定到组内
+   * @param index >= 0 时绑定到组内第 index % size 个核，< 0 时允许在整组内浮动
+   * @return 成功绑定返回 true；未开启、组为空或系统调用失败返回 false
+   */
+  bool PinCurrentThread(const std::string &group, int index = -1) const;
+
+  /**
+   * @brief 默认布局：Raft 侧与客户端 IO 侧不相交
+   * @details 多 node 时 node 0 是 Raft 侧 (raft / apply / log)，其余 node 是 IO 侧
+   * (rpc_io / rpc_client / grpc / rpc_worker / runtime)；单 node 时前一半核是 Raft 侧、后一半是 IO 侧。
+   * Raft 侧前一半给 raft，其余给 apply 与 log；IO 侧前一半给 rpc_io / rpc_client / grpc，其余给
+   * rpc_worker / runtime。只有一个核时所有组共享它 (此时 Isolated() 为 false)。
+   */
+  static std::map<std::string, std::vector<int>> AutoLayout(const CpuTopology &topology);
+
+ private:
+  ThreadPlacement() = default;
+
+  mutable std::mutex mutex_;
+  bool enabled_ = false;
+  std::map<std::string, std::vector<int>> groups_;
+  CpuTopology topology_{std::vector<std::vector<int>>()};  // Configure 时使用的拓扑 (Describe 用)
+};
+
+// 当前线程所在的 NUMA node (按 sched_getcpu 查拓扑)；拿不到时返回 0
+int CurrentNumaNode();
+
+// 把 [addr, addr + len) 优先放在 node 上 (mbind MPOL_PREFERRED，addr 需页对齐)；单 node 或失败时返回 false
+bool BindToNode(void *addr, size_t len, int node);
+
+// 把 [addr, addr + len) 优先放在当前线程所在的 node 上
+inline bool BindToLocalNode(void *addr, size_t len) { return BindToNode(addr, len, CurrentNumaNode()); }
+
+// 在 node 上分配 len 字节 (向上取整到页，内容为 0)；node < 0 时不指定。失败返回 nullptr
+void *AllocOnNode(size_t len, int node);
+void FreeOnNode(void *addr, size_t len);
+
+#endif  // CPU_TOPOLOGY_H
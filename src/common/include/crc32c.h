@@ -0,0 +1,76 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @file crc32c.h
+ * @brief CRC-32C (Castagnoli) 校验
+ * @details
+ * 用于 WAL 等落盘记录的完整性校验 (检测撕裂写与静默损坏)。
+ * x86-64 上运行时检测 SSE4.2，命中时用 crc32 指令每次处理 8 字节；否则走查表实现，两者结果一致。
+ */
+
+namespace crc32c_detail {
+
+struct Table {
+  uint32_t t[256];
+  Table() {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; ++k) c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : (c >> 1);
+      t[i] = c;
+    }
+  }
+};
+
+inline uint32_t ExtendPortable(uint32_t crc, const char *data, size_t n) {
+  static const Table table;
+  const unsigned char *p = reinterpret_cast<const unsigned char *>(data);
+  for (size_t i = 0; i < n; ++i) crc = table.t[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+  return crc;
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+__attribute__((target("sse4.2"))) inline uint32_t ExtendSse42(uint32_t crc, const char *data, size_t n) {
+  uint64_t c = crc;
+  while (n >= 8) {
+    uint64_t v;
+    memcpy(&v, data, 8);
+    c = __builtin_ia32_crc32di(c, v);
+    data += 8;
+    n -= 8;
+  }
+  uint32_t c32 = static_cast<uint32_t>(c);
+  while (n > 0) {
+    c32 = __builtin_ia32_crc32qi(c32, static_cast<unsigned char>(*data));
+    ++data;
+    --n;
+  }
+  return c32;
+}
+
+inline bool HasSse42() {
+  static const bool has = __builtin_cpu_supports("sse4.2");
+  return has;
+}
+#endif
+
+}  // namespace crc32c_detail
+
+/**
+ * @brief 在 crc (上一段数据的 Crc32c 结果) 的基础上继续计算 data 的 CRC-32C
+ */
+inline uint32_t Crc32cExtend(uint32_t crc, const char *data, size_t n) {
+  crc = ~crc;
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  if (crc32c_detail::HasSse42()) return ~crc32c_detail::ExtendSse42(crc, data, n);
+#endif
+  return ~crc32c_detail::ExtendPortable(crc, data, n);
+}
+
+inline uint32_t Crc32c(const char *data, size_t n) { return Crc32cExtend(0, data, n); }
+
+#endif  // CRC32C_H
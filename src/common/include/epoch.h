@@ -0,0 +1,209 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 基于 epoch 的内存回收 (Epoch-Based Reclamation, EBR)
+ * @details
+ * 无锁数据结构里，节点被摘链后仍可能有读线程持有它的裸指针，不能立即 delete。
+ * EBR 的做法：
+ * 1. 读/写线程进入临界区前 pin 住当前全局 epoch (EpochGuard)；
+ * 2. 摘链后的节点调用 retire() 挂到本线程的回收袋里，记录退休时的 epoch；
+ * 3. 只有当所有处于临界区的线程都观察到了当前全局 epoch，全局 epoch 才能 +1；
+ * 4. 退休 epoch 为 e 的对象，在全局 epoch >= e + 2 时一定没有线程还能访问它，可安全释放。
+ *
+ * 约束：retire() 的对象必须已经对新进入临界区的线程不可达 (已完成物理摘链)。
+ */
+class EpochManager {
+ public:
+  using Deleter = void (*)(void *);
+
+  static EpochManager &GetInstance() {
+    static EpochManager instance;
+    return instance;
+  }
+
+  // 进入临界区 (可重入)
+  void pin() {
+    ThreadRecord *rec = local_record();
+    if (rec->nest++ == 0) {
+      uint64_t e = global_epoch_.load(std::memory_order_relaxed);
+      rec->state.store((e << 1) | 1, std::memory_order_relaxed);
+      // 与 try_advance 中对 state 的读取配对：保证之后对共享指针的读取不会被重排到 pin 之前
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+  }
+
+  // 离开临界区
+  void unpin() {
+    ThreadRecord *rec = local_record();
+    if (--rec->nest == 0) {
+      rec->state.store(0, std::memory_order_release);
+    }
+  }
+
+  /**
+   * @brief 延迟释放一个已摘链的对象
+   * @param ptr 待释放对象
+   * @param deleter 释放函数，在宽限期结束后由某个线程调用
+   */
+  void retire(void *ptr, Deleter deleter) {
+    ThreadRecord *rec = local_record();
+    rec->bag.push_back({ptr, deleter, global_epoch_.load(std::memory_order_acquire)});
+    if (rec->bag.size() >= kCollectThreshold) {
+      try_advance();
+      collect(rec);
+    }
+  }
+
+  // 便捷模板：按类型 delete
+  template <typename T>
+  void retire(T *ptr) {
+    retire(static_cast<void *>(ptr), [](void *p) { delete static_cast<T *>(p); });
+  }
+
+  uint64_t epoch() const { return global_epoch_.load(std::memory_order_acquire); }
+
+  // 尝试推进并回收本线程可回收的对象 (测试或空闲时调用)
+  void flush() {
+    try_advance();
+    collect(local_record());
+  }
+
+ private:
+  struct RetiredItem {
+    void *ptr;
+    Deleter deleter;
+    uint64_t epoch;
+  };
+
+  // 每个线程一条记录，记录只追加不删除；线程退出后记录被标记为空闲，供新线程复用
+  struct ThreadRecord {
+    std::atomic<uint64_t> state{0};   // (epoch << 1) | active
+    std::atomic<bool> in_use{false};
+    ThreadRecord *next = nullptr;
+    int nest = 0;                     // 仅所属线程访问
+    std::vector<RetiredItem> bag;     // 仅所属线程访问
+  };
+
+  // 线程退出时归还记录，把未回收的对象交给全局孤儿袋
+  struct RecordHolder {
+    ThreadRecord *rec = nullptr;
+    ~RecordHolder() {
+      if (rec == nullptr) return;
+      EpochManager &mgr = EpochManager::GetInstance();
+      {
+        std::lock_guard<std::mutex> lock(mgr.orphan_mutex_);
+        mgr.orphans_.insert(mgr.orphans_.end(), rec->bag.begin(), rec->bag.end());
+      }
+      rec->bag.clear();
+      rec->state.store(0, std::memory_order_release);
+      rec->in_use.store(false, std::memory_order_release);
+    }
+  };
+
+  static constexpr size_t kCollectThreshold = 64;
+
+  EpochManager() = default;
+
+  // 进程退出时已无并发访问者，全部释放
+  ~EpochManager() {
+    ThreadRecord *rec = records_.load(std::memory_order_acquire);
+    while (rec != nullptr) {
+      for (auto &item : rec->bag) item.deleter(item.ptr);
+      ThreadRecord *next = rec->next;
+      delete rec;
+      rec = next;
+    }
+    for (auto &item : orphans_) item.deleter(item.ptr);
+  }
+
+  EpochManager(const EpochManager &) = delete;
+  EpochManager &operator=(const EpochManager &) = delete;
+
+  ThreadRecord *local_record() {
+    static thread_local RecordHolder holder;
+    if (holder.rec == nullptr) {
+      holder.rec = acquire_record();
+    }
+    return holder.rec;
+  }
+
+  ThreadRecord *acquire_record() {
+    // 优先复用已退出线程留下的记录
+    for (ThreadRecord *rec = records_.load(std::memory_order_acquire); rec != nullptr; rec = rec->next) {
+      bool expected = false;
+      if (!rec->in_use.load(std::memory_order_relaxed) &&
+          rec->in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+        return rec;
+      }
+    }
+    ThreadRecord *rec = new ThreadRecord();
+    rec->in_use.store(true, std::memory_order_relaxed);
+    ThreadRecord *head = records_.load(std::memory_order_relaxed);
+    do {
+      rec->next = head;
+    } while (!records_.compare_exchange_weak(head, rec, std::memory_order_release, std::memory_order_relaxed));
+    return rec;
+  }
+
+  // 所有活跃线程都已观察到当前 epoch 时，推进全局 epoch
+  bool try_advance() {
+    uint64_t e = global_epoch_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (ThreadRecord *rec = records_.load(std::memory_order_acquire); rec != nullptr; rec = rec->next) {
+      uint64_t s = rec->state.load(std::memory_order_acquire);
+      if ((s & 1) && (s >> 1) != e) {
+        return false;
+      }
+    }
+    return global_epoch_.compare_exchange_strong(e, e + 1, std::memory_order_acq_rel);
+  }
+
+  void collect(ThreadRecord *rec) {
+    uint64_t e = global_epoch_.load(std::memory_order_acquire);
+    collect_bag(rec->bag, e);
+
+    std::unique_lock<std::mutex> lock(orphan_mutex_, std::try_to_lock);
+    if (lock.owns_lock() && !orphans_.empty()) {
+      collect_bag(orphans_, e);
+    }
+  }
+
+  static void collect_bag(std::vector<RetiredItem> &bag, uint64_t e) {
+    size_t kept = 0;
+    for (size_t i = 0; i < bag.size(); ++i) {
+      if (bag[i].epoch + 2 <= e) {
+        bag[i].deleter(bag[i].ptr);
+      } else {
+        bag[kept++] = bag[i];
+      }
+    }
+    bag.resize(kept);
+  }
+
+  std::atomic<uint64_t> global_epoch_{0};
+  std::atomic<ThreadRecord *> records_{nullptr};
+
+  std::mutex orphan_mutex_;
+  std::vector<RetiredItem> orphans_;
+};
+
+/**
+ * @brief RAII 临界区守卫：构造时 pin，析构时 unpin
+ */
+class EpochGuard {
+ public:
+  EpochGuard() { EpochManager::GetInstance().pin(); }
+  ~EpochGuard() { EpochManager::GetInstance().unpin(); }
+
+  EpochGuard(const EpochGuard &) = delete;
+  EpochGuard &operator=(const EpochGuard &) = delete;
+};
+
+#endif  // EPOCH_H
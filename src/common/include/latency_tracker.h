@@ -0,0 +1,129 @@
+#ifndef LATENCY_TRACKER_H
+#define LATENCY_TRACKER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @file latency_tracker.h
+ * @brief 单个对端 (endpoint) 的 RPC 延迟统计：EWMA + 衰减直方图
+ * @details
+ * 固定超时对快慢不一的对端都不合适：太长时一个卡住的副本会把尾延迟拉到超时上限，
+ * 太短时慢而健康的对端会被频繁误判超时。这里按对端记录成功调用的往返时间：
+ * - EWMA (alpha = 1/8，同 TCP SRTT) 反映当前的典型延迟；
+ * - 对数分桶直方图 (每个 2 的幂分 4 个子桶，相对误差 < 25%) 给出 p95 / p99，
+ *   每记录 kDecayEvery 个样本所有桶减半，分布跟随最近几千次调用，对端变慢后几秒内就能反映出来。
+ *
+ * Record 只做几次 relaxed 原子操作，可以在 IO 线程里直接调用；读取是近似值 (各桶不是同一时刻的快照)，
+ * 用于推导超时 / 对冲时机足够。
+ */
+
+// 由延迟分布推导超时：clamp(p99 * multiplier, min_ms, max_ms)，样本不足时用 default_ms
+struct AdaptiveTimeoutOptions {
+  int default_ms = 5000;
+  int min_ms = 50;
+  int max_ms = 5000;
+  double multiplier = 3.0;
+  uint64_t min_samples = 32;
+};
+
+class LatencyTracker {
+ public:
+  static constexpr size_t kBuckets = 104;       // 覆盖 0 ~ 2^26 us (约 67s)，更大的样本计入最后一个桶
+  static constexpr uint64_t kDecayEvery = 1024;
+
+  void Record(std::chrono::microseconds latency) {
+    uint64_t us = static_cast<uint64_t>(std::max<int64_t>(0, latency.count()));
+    buckets_[BucketOf(us)].fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t old = ewma_us_.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+      next = (old == 0) ? std::max<uint64_t>(us, 1) : old - old / 8 + us / 8;
+    } while (!ewma_us_.compare_exchange_weak(old, next, std::memory_order_relaxed));
+
+    total_.fetch_add(1, std::memory_order_relaxed);
+    if (since_decay_.fetch_add(1, std::memory_order_relaxed) + 1 == kDecayEvery) {
+      since_decay_.store(0, std::memory_order_relaxed);
+      Decay();
+    }
+  }
+
+  uint64_t EwmaMicros() const { return ewma_us_.load(std::memory_order_relaxed); }
+
+  // 当前窗口 (衰减后) 的样本数
+  uint64_t Samples() const {
+    uint64_t n = 0;
+    for (const auto &b : buckets_) n += b.load(std::memory_order_relaxed);
+    return n;
+  }
+
+  // 累计记录过的样本数
+  uint64_t TotalSamples() const { return total_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief 分位数 (us)，返回所在桶的上界，偏保守；没有样本时返回 0
+   */
+  uint64_t PercentileMicros(double q) const {
+    uint64_t counts[kBuckets];
+    uint64_t n = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+      counts[i] = buckets_[i].load(std::memory_order_relaxed);
+      n += counts[i];
+    }
+    if (n == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(std::ceil(std::min(1.0, std::max(0.0, q)) * static_cast<double>(n)));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+      seen += counts[i];
+      if (seen >= rank) return BucketUpper(i);
+    }
+    return BucketUpper(kBuckets - 1);
+  }
+
+  std::chrono::milliseconds Timeout(const AdaptiveTimeoutOptions &options) const {
+    if (Samples() < options.min_samples) {
+      return std::chrono::milliseconds(options.default_ms);
+    }
+    double us = static_cast<double>(PercentileMicros(0.99)) * options.multiplier;
+    int64_t ms = static_cast<int64_t>(std::ceil(us / 1000.0));
+    ms = std::max<int64_t>(options.min_ms, std::min<int64_t>(options.max_ms, ms));
+    return std::chrono::milliseconds(ms);
+  }
+
+  // 值 us 所在的桶：0~3 各占一个桶，之后每个 [2^e, 2^(e+1)) 均分 4 个子桶
+  static size_t BucketOf(uint64_t us) {
+    if (us < 4) return static_cast<size_t>(us);
+    int e = 63 - __builtin_clzll(us);
+    size_t idx = static_cast<size_t>(4 * (e - 1)) + static_cast<size_t>((us >> (e - 2)) & 3);
+    return std::min(idx, kBuckets - 1);
+  }
+
+  static uint64_t BucketUpper(size_t idx) {
+    if (idx < 4) return idx;
+    int e = static_cast<int>(idx / 4) + 1;
+    uint64_t lower = (4 + idx % 4) << (e - 2);
+    return lower + (uint64_t{1} << (e - 2)) - 1;
+  }
+
+ private:
+  // 各桶减半 (fetch_sub 与并发的 fetch_add 不会丢计数)
+  void Decay() {
+    for (auto &b : buckets_) {
+      uint64_t v = b.load(std::memory_order_relaxed);
+      if (v > 0) b.fetch_sub(v / 2, std::memory_order_relaxed);
+    }
+  }
+
+  std::atomic<uint64_t> buckets_[kBuckets] = {};
+  std::atomic<uint64_t> ewma_us_{0};
+  std::atomic<uint64_t> total_{0};
+  std::atomic<uint64_t> since_decay_{0};
+};
+
+#endif  // LATENCY_TRACKER_H
@@ -0,0 +1,203 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @file metrics.h
+ * @brief 进程内指标：分片计数器、HDR 风格直方图与 Prometheus 文本格式导出
+ * @details
+ * 热路径只做 relaxed 原子加，不加锁、不分配：
+ * - MetricCounter 按线程分到 kMetricShards 个独立 cache line，多个 IO / 调度线程同时计数不争用；
+ * - MetricHistogram 采用对数-线性分桶 (每个 2 的幂均分 8 个子桶，相对误差 < 12.5%)，
+ *   覆盖 0 ~ 2^36 (纳秒约 68s，微秒约 19h)，累计计数不衰减，分位数由抓取端按时间窗口做差计算；
+ * - 指标对象由 MetricsRegistry 按 (名字, 标签) 创建一次，之后永不释放，调用方缓存指针直接使用。
+ *
+ * 读取 (抓取 / RenderPrometheus) 时把各分片相加，与写入并发进行，得到的是近似快照。
+ */
+
+// 标签按给定顺序输出，例如 {{"service", "KvService"}, {"method", "Get"}}
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+constexpr size_t kMetricShards = 16;
+constexpr size_t kHistogramShards = 4;
+
+// 当前线程固定使用的分片下标 (首次调用时按线程轮流分配)
+inline size_t MetricShardIndex() {
+  static std::atomic<size_t> next{0};
+  thread_local size_t shard = next.fetch_add(1, std::memory_order_relaxed);
+  return shard;
+}
+
+class MetricCounter {
+ public:
+  void Add(uint64_t n = 1) {
+    cells_[MetricShardIndex() % kMetricShards].value.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  uint64_t Value() const {
+    uint64_t sum = 0;
+    for (const auto &cell : cells_) sum += cell.value.load(std::memory_order_relaxed);
+    return sum;
+  }
+
+ private:
+  struct alignas(64) Cell {
+    std::atomic<uint64_t> value{0};
+  };
+  Cell cells_[kMetricShards];
+};
+
+class MetricGauge {
+ public:
+  void Set(int64_t v) { value_.store(v, std::memory_order_relaxed); }
+  void Add(int64_t n) { value_.fetch_add(n, std::memory_order_relaxed); }
+  int64_t Value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<int64_t> value_{0};
+};
+
+class MetricHistogram {
+ public:
+  static constexpr size_t kSubBuckets = 8;
+  static constexpr size_t kBuckets = 272;  // 8 * 34：最后一个桶收纳 >= 2^36 的值
+
+  struct Snapshot {
+    uint64_t counts[kBuckets] = {};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+
+    // 分位数，返回所在桶的上界；没有样本时返回 0
+    uint64_t Percentile(double q) const;
+  };
+
+  void Record(uint64_t value) {
+    Shard &shard = shards_[MetricShardIndex() % kHistogramShards];
+    shard.counts[BucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  Snapshot Collect() const;
+
+  // 值所在的桶：0~7 各占一个桶，之后每个 [2^e, 2^(e+1)) 均分 8 个子桶
+  static size_t BucketOf(uint64_t v) {
+    if (v < kSubBuckets) return static_cast<size_t>(v);
+    int e = 63 - __builtin_clzll(v);
+    size_t idx = kSubBuckets * static_cast<size_t>(e - 2) + static_cast<size_t>((v >> (e - 3)) & (kSubBuckets - 1));
+    return idx < kBuckets ? idx : kBuckets - 1;
+  }
+
+  // 桶内的最大值 (含)
+  static uint64_t BucketUpper(size_t idx) {
+    if (idx < kSubBuckets) return idx;
+    int e = static_cast<int>(idx / kSubBuckets) + 2;
+    uint64_t lower = static_cast<uint64_t>(kSubBuckets + idx % kSubBuckets) << (e - 3);
+    return lower + (uint64_t{1} << (e - 3)) - 1;
+  }
+
+ private:
+  struct alignas(64) Shard {
+    std::atomic<uint64_t> counts[kBuckets] = {};
+    std::atomic<uint64_t> sum{0};
+  };
+  Shard shards_[kHistogramShards];
+};
+
+// 把 start 到现在的耗时 (单位 Unit) 记入 h；h 为空时不读时钟
+template <typename Unit = std::chrono::microseconds>
+inline void RecordLatency(MetricHistogram *h, std::chrono::steady_clock::time_point start) {
+  if (!h) return;
+  auto d = std::chrono::duration_cast<Unit>(std::chrono::steady_clock::now() - start).count();
+  h->Record(d > 0 ? static_cast<uint64_t>(d) : 0);
+}
+
+/**
+ * @brief 作用域计时：析构时把耗时记入直方图 (h 为空时什么也不做)
+ * @tparam Unit 记录的单位，与指标名的后缀一致 (_microseconds / _nanoseconds)
+ */
+template <typename Unit = std::chrono::microseconds>
+class ScopedLatency {
+ public:
+  explicit ScopedLatency(MetricHistogram *h) : h_(h) {
+    if (h_) start_ = std::chrono::steady_clock::now();
+  }
+  ~ScopedLatency() { RecordLatency<Unit>(h_, start_); }
+  ScopedLatency(const ScopedLatency &) = delete;
+  ScopedLatency &operator=(const ScopedLatency &) = delete;
+
+ private:
+  MetricHistogram *h_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief 全进程的指标注册表
+ * @details Get* 按 (名字, 标签) 查找或创建，加锁，只应在初始化 / 首次使用时调用，返回的指针永久有效。
+ * 同一个名字只能对应一种类型，类型不一致时返回 nullptr (记录点随之成为空操作)。
+ * 已有的原子计数 (如 RpcProvider::Metrics) 通过 AddCallback 在抓取时读取，不必改写成 MetricCounter。
+ */
+class MetricsRegistry {
+ public:
+  enum class Type { kCounter, kGauge, kHistogram };
+
+  static MetricsRegistry &GetInstance() {
+    static MetricsRegistry instance;
+    return instance;
+  }
+
+  MetricCounter *GetCounter(const std::string &name, const MetricLabels &labels = {}, const std::string &help = "");
+  MetricGauge *GetGauge(const std::string &name, const MetricLabels &labels = {}, const std::string &help = "");
+  MetricHistogram *GetHistogram(const std::string &name, const MetricLabels &labels = {},
+                                const std::string &help = "");
+
+  /**
+   * @brief 注册一个抓取时求值的计数器 / 仪表 (type 不能是 kHistogram)
+   * @return 回调 id，持有被读取对象的一方在析构前必须 RemoveCallback
+   */
+  int AddCallback(const std::string &name, const MetricLabels &labels, Type type, std::function<double()> fn,
+                  const std::string &help = "");
+  void RemoveCallback(int id);
+
+  // Prometheus 文本格式 (text/plain; version=0.0.4)，按指标名排序
+  std::string RenderPrometheus() const;
+
+ private:
+  MetricsRegistry() = default;
+
+  struct Series {
+    std::unique_ptr<MetricCounter> counter;
+    std::unique_ptr<MetricGauge> gauge;
+    std::unique_ptr<MetricHistogram> histogram;
+    std::map<int, std::function<double()>> callbacks;  // AddCallback 注册的序列
+  };
+  struct Family {
+    Type type;
+    std::string help;
+    std::map<std::string, Series> series;  // key: 渲染好的标签 {a="b",...}
+  };
+
+  // 调用方持有 mutex_；类型冲突返回 nullptr。with_value 为 false 时只建序列，不建值对象 (回调序列)
+  Series *FindOrCreate(const std::string &name, const MetricLabels &labels, Type type, const std::string &help,
+                       bool with_value = true);
+
+  mutable std::mutex mutex_;
+  std::map<std::string, Family> families_;
+  std::map<int, std::pair<std::string, std::string>> callback_index_;  // id -> (name, labels)
+  int next_callback_id_ = 1;
+};
+
+// 渲染标签：{k1="v1",k2="v2"}，值中的 \ " 换行按 Prometheus 规则转义；没有标签时返回空串
+std::string FormatMetricLabels(const MetricLabels &labels);
+
+#endif  // METRICS_H
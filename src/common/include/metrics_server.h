@@ -0,0 +1,46 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+/**
+ * @file metrics_server.h
+ * @brief 最小的 HTTP 抓取端点：GET /metrics 返回 MetricsRegistry 的 Prometheus 文本，
+ *        GET /trace 返回 Tracer 记录的 span (Chrome trace JSON，?format=otlp 时为 OTLP/JSON)
+ * @details
+ * 单独一个阻塞线程，一次处理一个连接 (Connection: close)。抓取频率是秒级，
+ * 不值得占用 RPC 的 EventLoop，也不依赖 muduo，raft 节点、KV 服务和测试都能直接启动。
+ * 读请求有超时，慢客户端最多占住端点 kIoTimeoutMs，不影响业务线程。
+ */
+class MetricsServer {
+ public:
+  static constexpr int kIoTimeoutMs = 1000;
+
+  // port 为 0 时由内核分配，Start 之后用 Port() 取实际端口
+  MetricsServer(const std::string &ip, uint16_t port);
+  ~MetricsServer();
+
+  MetricsServer(const MetricsServer &) = delete;
+  MetricsServer &operator=(const MetricsServer &) = delete;
+
+  // 绑定并开始服务；端口被占用等失败返回 false
+  bool Start();
+  void Stop();
+
+  uint16_t Port() const { return port_; }
+
+ private:
+  void Loop();
+  void HandleConnection(int fd);
+
+  std::string ip_;
+  uint16_t port_;
+  int listen_fd_ = -1;
+  std::atomic<bool> running_{false};
+  std::thread thread_;
+};
+
+#endif  // METRICS_SERVER_H
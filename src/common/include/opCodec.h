@@ -0,0 +1,372 @@
+#ifndef OP_CODEC_H
+#define OP_CODEC_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file opCodec.h
+ * @brief Op 的紧凑二进制编码 (LogEntry.command 的规范格式)
+ * @details
+ * 取代 boost text_oarchive：没有文本头、没有十进制编码，编码只做一次 string 分配，
+ * 解码可以直接返回指向 entry 缓冲区的 string_view，apply 路径零拷贝。
+ *
+ * 格式：
+ *   magic    u8      0xC1 (boost 文本归档以 ASCII 数字开头，据此区分新旧格式)
+ *   opcode   u8      OpType；kOther 时后跟 varint 长度 + Operation 字符串
+ *   flags    u8      bit0 = ClientId 为纯数字，按 varint 编码
+ *   clientId varint  或 varint 长度 + 字节
+ *   reqId    varint  zigzag 编码 (RequestId 可能为负)
+ *   key      varint 长度 + 字节
+ *   value    varint 长度 + 字节
+ */
+
+constexpr uint8_t kOpCodecMagic = 0xC1;
+constexpr uint8_t kOpBatchMagic = 0xC2;  // 批量操作 (见 EncodeOpBatch)
+constexpr uint8_t kOpGroupMagic = 0xC3;  // 多个客户端的命令合并成一条日志 (见 EncodeOpGroup)
+constexpr uint8_t kMembershipMagic = 0xC4;  // Raft 成员变更日志 (raftCore membership.h)，状态机 apply 时跳过
+
+enum class OpType : uint8_t {
+  kOther = 0,  // 未知操作名，原样携带字符串
+  kGet = 1,
+  kPut = 2,
+  kAppend = 3,
+  kDelete = 4,
+};
+
+enum : uint8_t {
+  kOpFlagNumericClient = 0x01,
+};
+
+inline OpType OpTypeFromName(std::string_view name) {
+  if (name == "Get") return OpType::kGet;
+  if (name == "Put") return OpType::kPut;
+  if (name == "Append") return OpType::kAppend;
+  if (name == "Delete") return OpType::kDelete;
+  return OpType::kOther;
+}
+
+inline std::string_view OpTypeName(OpType type) {
+  switch (type) {
+    case OpType::kGet: return "Get";
+    case OpType::kPut: return "Put";
+    case OpType::kAppend: return "Append";
+    case OpType::kDelete: return "Delete";
+    default: return "";
+  }
+}
+
+// ========== varint (LEB128) ==========
+
+inline void PutVarint64(std::string &dst, uint64_t v) {
+  char buf[10];
+  int n = 0;
+  while (v >= 0x80) {
+    buf[n++] = static_cast<char>(v | 0x80);
+    v >>= 7;
+  }
+  buf[n++] = static_cast<char>(v);
+  dst.append(buf, n);
+}
+
+inline size_t VarintLength(uint64_t v) {
+  size_t len = 1;
+  while (v >= 0x80) {
+    v >>= 7;
+    len++;
+  }
+  return len;
+}
+
+inline bool GetVarint64(std::string_view &in, uint64_t *v) {
+  uint64_t result = 0;
+  for (int shift = 0; shift <= 63 && !in.empty(); shift += 7) {
+    uint8_t byte = static_cast<uint8_t>(in.front());
+    in.remove_prefix(1);
+    result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      *v = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+inline void PutLengthPrefixed(std::string &dst, std::string_view s) {
+  PutVarint64(dst, s.size());
+  dst.append(s.data(), s.size());
+}
+
+inline bool GetLengthPrefixed(std::string_view &in, std::string_view *out) {
+  uint64_t len = 0;
+  if (!GetVarint64(in, &len) || len > in.size()) return false;
+  *out = in.substr(0, len);
+  in.remove_prefix(len);
+  return true;
+}
+
+inline uint64_t ZigZagEncode(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+inline int64_t ZigZagDecode(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+// 纯数字 (无前导零、不超过 19 位) 的 ClientId 按整数编码，否则按字符串编码
+inline bool ParseNumericClientId(std::string_view id, uint64_t *num) {
+  if (id.empty() || id.size() > 19 || (id.size() > 1 && id[0] == '0')) return false;
+  uint64_t v = 0;
+  for (char c : id) {
+    if (c < '0' || c > '9') return false;
+    v = v * 10 + static_cast<uint64_t>(c - '0');
+  }
+  *num = v;
+  return true;
+}
+
+/**
+ * @brief 解码后的只读视图，字符串字段指向原始缓冲区 (缓冲区必须比视图活得久)
+ */
+struct OpView {
+  OpType type = OpType::kOther;
+  std::string_view Operation;  // 已知 opcode 时指向静态字符串
+  std::string_view Key;
+  std::string_view Value;
+  std::string_view ClientId;   // 数字形式时为空，见 ClientNum
+  bool ClientIsNumeric = false;
+  uint64_t ClientNum = 0;
+  int RequestId = 0;
+
+  std::string ClientIdString() const {
+    return ClientIsNumeric ? std::to_string(ClientNum) : std::string(ClientId);
+  }
+};
+
+inline void EncodeOp(std::string &dst, std::string_view operation, std::string_view key, std::string_view value,
+                     std::string_view client_id, int request_id) {
+  OpType type = OpTypeFromName(operation);
+  uint64_t client_num = 0;
+  bool numeric = ParseNumericClientId(client_id, &client_num);
+
+  // 预先算好总长度，只分配一次
+  size_t size = 3 + VarintLength(ZigZagEncode(request_id)) + VarintLength(key.size()) + key.size() +
+                VarintLength(value.size()) + value.size();
+  size += numeric ? VarintLength(client_num) : VarintLength(client_id.size()) + client_id.size();
+  if (type == OpType::kOther) size += VarintLength(operation.size()) + operation.size();
+  dst.reserve(dst.size() + size);
+
+  dst.push_back(static_cast<char>(kOpCodecMagic));
+  dst.push_back(static_cast<char>(type));
+  if (type == OpType::kOther) PutLengthPrefixed(dst, operation);
+  dst.push_back(static_cast<char>(numeric ? kOpFlagNumericClient : 0));
+  if (numeric) {
+    PutVarint64(dst, client_num);
+  } else {
+    PutLengthPrefixed(dst, client_id);
+  }
+  PutVarint64(dst, ZigZagEncode(request_id));
+  PutLengthPrefixed(dst, key);
+  PutLengthPrefixed(dst, value);
+}
+
+inline bool IsBinaryOp(std::string_view data) {
+  return !data.empty() && static_cast<uint8_t>(data[0]) == kOpCodecMagic;
+}
+
+// 零拷贝解码；格式错误返回 false
+inline bool DecodeOpView(std::string_view in, OpView *view) {
+  if (in.size() < 3 || static_cast<uint8_t>(in[0]) != kOpCodecMagic) return false;
+  in.remove_prefix(1);
+
+  uint8_t opcode = static_cast<uint8_t>(in.front());
+  in.remove_prefix(1);
+  if (opcode > static_cast<uint8_t>(OpType::kDelete)) return false;
+  view->type = static_cast<OpType>(opcode);
+  if (view->type == OpType::kOther) {
+    if (!GetLengthPrefixed(in, &view->Operation)) return false;
+  } else {
+    view->Operation = OpTypeName(view->type);
+  }
+
+  if (in.empty()) return false;
+  uint8_t flags = static_cast<uint8_t>(in.front());
+  in.remove_prefix(1);
+  view->ClientIsNumeric = (flags & kOpFlagNumericClient) != 0;
+  if (view->ClientIsNumeric) {
+    view->ClientId = std::string_view();
+    if (!GetVarint64(in, &view->ClientNum)) return false;
+  } else {
+    view->ClientNum = 0;
+    if (!GetLengthPrefixed(in, &view->ClientId)) return false;
+  }
+
+  uint64_t req = 0;
+  if (!GetVarint64(in, &req)) return false;
+  view->RequestId = static_cast<int>(ZigZagDecode(req));
+
+  if (!GetLengthPrefixed(in, &view->Key)) return false;
+  if (!GetLengthPrefixed(in, &view->Value)) return false;
+  return in.empty();
+}
+
+// ========== 批量操作 (BatchPut / BatchDelete / MultiOp 的一条日志) ==========
+/*
+ * 格式：
+ *   magic    u8      0xC2
+ *   flags    u8      同单条 Op
+ *   clientId varint  或 varint 长度 + 字节
+ *   reqId    varint  zigzag；整批只占一个幂等记录 (clientId, reqId)
+ *   count    varint
+ *   count 个子操作：opcode u8 (kOther 时后跟操作名) | key | value
+ */
+
+/**
+ * @brief 批量操作的子操作，字符串指向调用方 / 日志缓冲区
+ */
+struct OpBatchItem {
+  OpType type = OpType::kPut;
+  std::string_view Operation;  // 只在 type == kOther 时使用
+  std::string_view Key;
+  std::string_view Value;
+};
+
+/**
+ * @brief 解码后的批量视图；Ops 中每个 OpView 的 ClientId / RequestId 与整批相同
+ */
+struct OpBatchView {
+  std::string_view ClientId;
+  bool ClientIsNumeric = false;
+  uint64_t ClientNum = 0;
+  int RequestId = 0;
+  std::vector<OpView> Ops;
+
+  std::string ClientIdString() const {
+    return ClientIsNumeric ? std::to_string(ClientNum) : std::string(ClientId);
+  }
+};
+
+inline bool IsBinaryOpBatch(std::string_view data) {
+  return !data.empty() && static_cast<uint8_t>(data[0]) == kOpBatchMagic;
+}
+
+template <typename Items>
+inline void EncodeOpBatch(std::string &dst, const Items &items, std::string_view client_id, int request_id) {
+  uint64_t client_num = 0;
+  bool numeric = ParseNumericClientId(client_id, &client_num);
+
+  size_t size = 2 + VarintLength(ZigZagEncode(request_id)) + VarintLength(items.size());
+  size += numeric ? VarintLength(client_num) : VarintLength(client_id.size()) + client_id.size();
+  for (const OpBatchItem &item : items) {
+    size += 1 + VarintLength(item.Key.size()) + item.Key.size() + VarintLength(item.Value.size()) + item.Value.size();
+    if (item.type == OpType::kOther) size += VarintLength(item.Operation.size()) + item.Operation.size();
+  }
+  dst.reserve(dst.size() + size);
+
+  dst.push_back(static_cast<char>(kOpBatchMagic));
+  dst.push_back(static_cast<char>(numeric ? kOpFlagNumericClient : 0));
+  if (numeric) {
+    PutVarint64(dst, client_num);
+  } else {
+    PutLengthPrefixed(dst, client_id);
+  }
+  PutVarint64(dst, ZigZagEncode(request_id));
+  PutVarint64(dst, items.size());
+  for (const OpBatchItem &item : items) {
+    dst.push_back(static_cast<char>(item.type));
+    if (item.type == OpType::kOther) PutLengthPrefixed(dst, item.Operation);
+    PutLengthPrefixed(dst, item.Key);
+    PutLengthPrefixed(dst, item.Value);
+  }
+}
+
+// 零拷贝解码；格式错误返回 false
+inline bool DecodeOpBatchView(std::string_view in, OpBatchView *view) {
+  if (in.size() < 2 || static_cast<uint8_t>(in[0]) != kOpBatchMagic) return false;
+  in.remove_prefix(1);
+
+  uint8_t flags = static_cast<uint8_t>(in.front());
+  in.remove_prefix(1);
+  view->ClientIsNumeric = (flags & kOpFlagNumericClient) != 0;
+  if (view->ClientIsNumeric) {
+    view->ClientId = std::string_view();
+    if (!GetVarint64(in, &view->ClientNum)) return false;
+  } else {
+    view->ClientNum = 0;
+    if (!GetLengthPrefixed(in, &view->ClientId)) return false;
+  }
+  uint64_t req = 0;
+  if (!GetVarint64(in, &req)) return false;
+  view->RequestId = static_cast<int>(ZigZagDecode(req));
+
+  uint64_t count = 0;
+  // 每个子操作至少 3 字节，据此挡住损坏的 count，避免超大 reserve
+  if (!GetVarint64(in, &count) || count > in.size() / 3) return false;
+  view->Ops.clear();
+  view->Ops.reserve(count);
+  for (uint64_t i = 0; i < count; ++i) {
+    if (in.empty()) return false;
+    uint8_t opcode = static_cast<uint8_t>(in.front());
+    in.remove_prefix(1);
+    if (opcode > static_cast<uint8_t>(OpType::kDelete)) return false;
+    OpView op;
+    op.type = static_cast<OpType>(opcode);
+    if (op.type == OpType::kOther) {
+      if (!GetLengthPrefixed(in, &op.Operation)) return false;
+    } else {
+      op.Operation = OpTypeName(op.type);
+    }
+    if (!GetLengthPrefixed(in, &op.Key) || !GetLengthPrefixed(in, &op.Value)) return false;
+    op.ClientId = view->ClientId;
+    op.ClientIsNumeric = view->ClientIsNumeric;
+    op.ClientNum = view->ClientNum;
+    op.RequestId = view->RequestId;
+    view->Ops.push_back(op);
+  }
+  return in.empty();
+}
+
+// ========== 合并提交 (leader 把并发到达的多个客户端命令打包进一条日志) ==========
+/*
+ * 格式：
+ *   magic    u8      0xC3
+ *   count    varint
+ *   count 个子命令：varint 长度 + 完整的单条 Op / OpBatch 编码
+ *
+ * 与 OpBatch 不同，子命令各自携带 ClientId / RequestId，apply 时逐条去重、逐条返回结果；
+ * 省下的是每条日志的 entry 头、WAL 记录、复制和 apply 的固定开销。
+ */
+
+inline bool IsOpGroup(std::string_view data) {
+  return !data.empty() && static_cast<uint8_t>(data[0]) == kOpGroupMagic;
+}
+
+// Commands 的元素可转换为 std::string_view
+template <typename Commands>
+inline void EncodeOpGroup(std::string &dst, const Commands &commands) {
+  size_t size = 1 + VarintLength(commands.size());
+  for (const auto &cmd : commands) {
+    std::string_view c(cmd);
+    size += VarintLength(c.size()) + c.size();
+  }
+  dst.reserve(dst.size() + size);
+  dst.push_back(static_cast<char>(kOpGroupMagic));
+  PutVarint64(dst, commands.size());
+  for (const auto &cmd : commands) PutLengthPrefixed(dst, cmd);
+}
+
+// 零拷贝解码，commands 指向 in；格式错误返回 false (子命令本身的格式由调用方逐条检查)
+inline bool DecodeOpGroup(std::string_view in, std::vector<std::string_view> *commands) {
+  if (in.size() < 2 || static_cast<uint8_t>(in[0]) != kOpGroupMagic) return false;
+  in.remove_prefix(1);
+  uint64_t count = 0;
+  // 每个子命令至少 1 字节长度 + 3 字节 Op，挡住损坏的 count
+  if (!GetVarint64(in, &count) || count > in.size() / 4) return false;
+  commands->clear();
+  commands->reserve(count);
+  for (uint64_t i = 0; i < count; ++i) {
+    std::string_view cmd;
+    if (!GetLengthPrefixed(in, &cmd)) return false;
+    commands->push_back(cmd);
+  }
+  return in.empty();
+}
+
+#endif  // OP_CODEC_H
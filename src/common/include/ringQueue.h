@@ -0,0 +1,355 @@
+#ifndef RING_QUEUE_H
+#define RING_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @file ringQueue.h
+ * @brief 有界无锁环形队列 (LockQueue 的替代实现)
+ * @details
+ * 基于 Vyukov 的 bounded MPMC 算法：每个槽位带一个序号 seq，
+ * 生产者看到 seq == pos 说明槽位空闲，消费者看到 seq == pos + 1 说明数据已发布。
+ * 入队 / 出队只在各自的游标上做一次 CAS，队列未满/未空时不会进入内核。
+ *
+ * 1. 槽位和两个游标都按 cache line 对齐，生产者和消费者不会互相踩 cache line；
+ * 2. 单生产者 / 单消费者通过模板参数在编译期选择，对应一侧的 CAS 退化为普通 store；
+ * 3. 阻塞等待采用 "自旋 -> yield -> park"：短暂的空/满只自旋，长时间等待才挂到条件变量上，
+ *    对端只在确实有线程 park 时才去加锁 notify，热路径上 Push 不再每次 notify_one。
+ *
+ * 接口与 LockQueue 保持一致 (Push / timeOutPush / Pop / timeOutPop / PopBatch / Shutdown ...)，
+ * 区别是容量必须有界，会向上取整到 2 的幂。
+ */
+
+constexpr size_t kRingQueueCacheLine = 64;
+constexpr int kRingQueueSpinCount = 128;   // park 之前的忙等轮数
+constexpr int kRingQueueYieldCount = 16;   // 忙等之后的 yield 轮数
+
+inline void RingQueueCpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+template <typename T, bool kMultiProducer = true, bool kMultiConsumer = true>
+class RingQueue {
+ public:
+  explicit RingQueue(size_t capacity = 1024)
+      : mask_(RoundUpPowerOfTwo(capacity) - 1), slots_(mask_ + 1) {
+    for (size_t i = 0; i <= mask_; ++i) {
+      slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  RingQueue(const RingQueue &) = delete;
+  RingQueue &operator=(const RingQueue &) = delete;
+
+  ~RingQueue() {
+    // 析构时没有并发访问：把已发布但未取走的元素原地析构
+    size_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+    for (size_t pos = dequeue_pos_.load(std::memory_order_relaxed); pos != tail; ++pos) {
+      Slot &slot = slots_[pos & mask_];
+      if (slot.seq.load(std::memory_order_relaxed) == pos + 1) {
+        slot.item()->~T();
+      }
+    }
+  }
+
+  // ========== 生产者 ==========
+
+  // 阻塞 Push：队列满时等待，关闭后返回 false
+  bool Push(T &&data) { return PushUntil(std::move(data), nullptr); }
+
+  bool Push(const T &data) {
+    T temp(data);
+    return Push(std::move(temp));
+  }
+
+  // 超时 Push：timeout_ms 内仍然满则返回 false
+  bool timeOutPush(T &&data, int timeout_ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    return PushUntil(std::move(data), &deadline);
+  }
+
+  // 非阻塞 Push：满或已关闭返回 false
+  bool TryPush(T &&data) {
+    if (shutdown_.load(std::memory_order_acquire) || !TryPushImpl(data)) {
+      return false;
+    }
+    WakeConsumer();
+    return true;
+  }
+
+  // 批量 Push：逐个入队，每个元素按需等待空间；关闭时返回 false (已入队的部分不回滚)
+  bool PushBatch(std::vector<T> &&items) {
+    for (auto &item : items) {
+      if (!Push(std::move(item))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // ========== 消费者 ==========
+
+  // 阻塞 Pop：关闭且已取空时返回 false
+  bool Pop(T &out_data) { return PopUntil(out_data, nullptr); }
+
+  bool timeOutPop(int timeout_ms, T &out_data) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    return PopUntil(out_data, &deadline);
+  }
+
+  bool TryPop(T &out_data) {
+    if (!TryPopImpl(out_data)) {
+      return false;
+    }
+    WakeProducer();
+    return true;
+  }
+
+  // 批量 Pop：至少等到一个元素 (或关闭)，然后把当前可取的元素一次取走，最多 max_count 个
+  size_t PopBatch(std::vector<T> &out_items, size_t max_count) {
+    if (max_count == 0) {
+      return 0;
+    }
+    T item;
+    if (!Pop(item)) {
+      return 0;
+    }
+    out_items.push_back(std::move(item));
+    size_t count = 1;
+    while (count < max_count && TryPopImpl(item)) {
+      out_items.push_back(std::move(item));
+      ++count;
+    }
+    if (count > 1) {
+      Wake(sleeping_producers_, not_full_, true);  // 腾出了多个槽位，唤醒所有等待的生产者
+    }
+    return count;
+  }
+
+  // ========== 状态 ==========
+
+  // 并发环境下只是近似值
+  size_t Size() const {
+    size_t tail = enqueue_pos_.load(std::memory_order_acquire);
+    size_t head = dequeue_pos_.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+  }
+
+  bool Empty() const { return !HasItem(); }
+
+  bool IsFull() const { return !HasSpace(); }
+
+  size_t Capacity() const { return mask_ + 1; }
+
+  // 关闭：之后 Push 失败，Pop 取完剩余元素后返回 false，唤醒所有 park 的线程
+  void Shutdown() {
+    shutdown_.store(true, std::memory_order_release);
+    { std::lock_guard<std::mutex> lock(park_mutex_); }
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+  bool IsShutdown() const { return shutdown_.load(std::memory_order_acquire); }
+
+ private:
+  // 每个槽位独占 cache line，相邻槽位的 seq 不会伪共享
+  struct alignas(kRingQueueCacheLine) Slot {
+    std::atomic<size_t> seq{0};
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    T *item() { return std::launder(reinterpret_cast<T *>(storage)); }
+  };
+
+  static size_t RoundUpPowerOfTwo(size_t n) {
+    size_t cap = 2;
+    while (cap < n) cap <<= 1;
+    return cap;
+  }
+
+  bool TryPushImpl(T &data) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Slot *slot;
+    for (;;) {
+      slot = &slots_[pos & mask_];
+      size_t seq = slot->seq.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if constexpr (kMultiProducer) {
+          if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else {
+          enqueue_pos_.store(pos + 1, std::memory_order_relaxed);
+          break;
+        }
+      } else if (diff < 0) {
+        return false;  // 满：该槽位上一轮的数据还没被取走
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);  // 被其他生产者抢先
+      }
+    }
+    new (slot->storage) T(std::move(data));
+    slot->seq.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool TryPopImpl(T &out) {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    Slot *slot;
+    for (;;) {
+      slot = &slots_[pos & mask_];
+      size_t seq = slot->seq.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if constexpr (kMultiConsumer) {
+          if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else {
+          dequeue_pos_.store(pos + 1, std::memory_order_relaxed);
+          break;
+        }
+      } else if (diff < 0) {
+        return false;  // 空：生产者还没发布这个槽位
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    T *item = slot->item();
+    out = std::move(*item);
+    item->~T();
+    slot->seq.store(pos + mask_ + 1, std::memory_order_release);  // 槽位留给下一轮的生产者
+    return true;
+  }
+
+  bool HasItem() const {
+    size_t pos = dequeue_pos_.load(std::memory_order_acquire);
+    size_t seq = slots_[pos & mask_].seq.load(std::memory_order_acquire);
+    return static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) >= 0;
+  }
+
+  bool HasSpace() const {
+    size_t pos = enqueue_pos_.load(std::memory_order_acquire);
+    size_t seq = slots_[pos & mask_].seq.load(std::memory_order_acquire);
+    return static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos) >= 0;
+  }
+
+  bool PushUntil(T &&data, const std::chrono::steady_clock::time_point *deadline) {
+    for (;;) {
+      if (shutdown_.load(std::memory_order_acquire)) {
+        return false;
+      }
+      if (TryPushImpl(data)) {
+        WakeConsumer();
+        return true;
+      }
+      if (!WaitUntil([this]() { return HasSpace() || IsShutdown(); }, sleeping_producers_, not_full_, deadline)) {
+        return false;  // 超时
+      }
+    }
+  }
+
+  bool PopUntil(T &out, const std::chrono::steady_clock::time_point *deadline) {
+    for (;;) {
+      if (TryPopImpl(out)) {
+        WakeProducer();
+        return true;
+      }
+      if (shutdown_.load(std::memory_order_acquire)) {
+        // 关闭前已发布的元素仍然要交给消费者
+        if (TryPopImpl(out)) {
+          return true;
+        }
+        return false;
+      }
+      if (!WaitUntil([this]() { return HasItem() || IsShutdown(); }, sleeping_consumers_, not_empty_, deadline)) {
+        return false;
+      }
+    }
+  }
+
+  /**
+   * @brief 自旋 -> yield -> park 三段式等待
+   * @details park 时先登记 sleepers 再复查条件，对端发布数据后先读 sleepers；
+   *          两边各有一次 seq_cst fence，保证至少有一方看到对方 (不会丢失唤醒)。
+   * @return 条件满足返回 true，超时返回 false
+   */
+  template <typename Ready>
+  bool WaitUntil(Ready ready, std::atomic<int> &sleepers, std::condition_variable &cv,
+                 const std::chrono::steady_clock::time_point *deadline) {
+    for (int i = 0; i < kRingQueueSpinCount; ++i) {
+      if (ready()) return true;
+      RingQueueCpuRelax();
+    }
+    for (int i = 0; i < kRingQueueYieldCount; ++i) {
+      if (ready()) return true;
+      std::this_thread::yield();
+    }
+
+    std::unique_lock<std::mutex> lock(park_mutex_);
+    sleepers.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool ok = true;
+    while (!ready()) {
+      if (deadline == nullptr) {
+        cv.wait(lock);
+      } else if (cv.wait_until(lock, *deadline) == std::cv_status::timeout) {
+        ok = ready();
+        break;
+      }
+    }
+    sleepers.fetch_sub(1, std::memory_order_relaxed);
+    return ok;
+  }
+
+  void WakeConsumer() { Wake(sleeping_consumers_, not_empty_); }
+  void WakeProducer() { Wake(sleeping_producers_, not_full_); }
+
+  void Wake(std::atomic<int> &sleepers, std::condition_variable &cv, bool all = false) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers.load(std::memory_order_relaxed) == 0) {
+      return;  // 热路径：没有线程 park，不碰锁
+    }
+    // 进出一次锁：对端要么还没开始复查 (会看到新数据)，要么已经在 wait 中 (会收到 notify)
+    { std::lock_guard<std::mutex> lock(park_mutex_); }
+    if (all) {
+      cv.notify_all();
+    } else {
+      cv.notify_one();
+    }
+  }
+
+  const size_t mask_;
+  std::vector<Slot> slots_;
+
+  alignas(kRingQueueCacheLine) std::atomic<size_t> enqueue_pos_{0};
+  alignas(kRingQueueCacheLine) std::atomic<size_t> dequeue_pos_{0};
+  alignas(kRingQueueCacheLine) std::atomic<bool> shutdown_{false};
+
+  // 仅在 park 路径上使用
+  std::atomic<int> sleeping_producers_{0};
+  std::atomic<int> sleeping_consumers_{0};
+  std::mutex park_mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+};
+
+// 编译期选择的特化：省掉对应一侧的 CAS
+template <typename T>
+using MpmcRingQueue = RingQueue<T, true, true>;
+template <typename T>
+using MpscRingQueue = RingQueue<T, true, false>;
+template <typename T>
+using SpscRingQueue = RingQueue<T, false, false>;
+
+#endif  // RING_QUEUE_H
@@ -0,0 +1,195 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @file trace.h
+ * @brief 端到端请求追踪：客户端 -> RPC -> Raft 复制 -> apply 各阶段的 span
+ * @details
+ * 1. 上下文：TraceContext = (trace_id, span_id)，trace_id 为 0 表示未采样。
+ *    跨进程随 RpcHeader.trace_id / span_id、LogEntry.traceId / spanId 传播，
+ *    进程内通过 ScopedTraceContext 挂在当前线程上，下游阶段用 Tracer::Current() 取得父 span；
+ * 2. 采样：只在 trace 的根 (客户端发起请求) 按 SetSampleRate 决定，下游一律沿用传入的决定，
+ *    同一个 trace 在所有节点上要么完整、要么完全不记录。采样率为 0 (默认) 时 Sample() 只有一次 relaxed load，
+ *    各阶段只多一次 "trace_id != 0" 的判断，不读时钟、不写缓冲区；
+ * 3. 记录：每个线程一个固定容量的环形缓冲区，单写者 (本线程) 无锁写入，写满后覆盖最旧的 span。
+ *    每个槽位带序号 (seqlock)，Dump 与写入并发进行，读到正在被覆盖的槽位直接跳过；
+ * 4. 导出：DumpChromeTrace (chrome://tracing / Perfetto 可直接打开) 与 DumpOtlpJson (OTLP/JSON 的 resourceSpans)，
+ *    时间戳换算成墙上时钟，多个节点导出的文件可以合并查看。MetricsServer 的 GET /trace 返回前者。
+ *
+ * span 的名字和属性名必须是字符串字面量 (缓冲区只保存指针)。
+ */
+
+// steady_clock 纳秒，span 的起止时间都用它 (导出时再换算成墙上时钟)
+inline uint64_t TraceNanos(std::chrono::steady_clock::time_point tp) {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count());
+}
+
+inline uint64_t TraceNowNanos() { return TraceNanos(std::chrono::steady_clock::now()); }
+
+struct TraceContext {
+  uint64_t trace_id = 0;  // 0：未采样
+  uint64_t span_id = 0;   // 下游 span 的父 span
+
+  bool Sampled() const { return trace_id != 0; }
+};
+
+struct SpanRecord {
+  uint64_t trace_id = 0;
+  uint64_t span_id = 0;
+  uint64_t parent_id = 0;  // 0：根 span
+  const char *name = nullptr;
+  uint64_t start_ns = 0;  // TraceNanos
+  uint64_t end_ns = 0;
+  const char *arg_key = nullptr;  // 可选的一个数值属性，例如日志 index、批大小
+  uint64_t arg_value = 0;
+  uint32_t tid = 0;  // 写入线程的编号 (Record 时填写)
+};
+
+class Tracer {
+ public:
+  static constexpr size_t kRingCapacity = 4096;  // 每个线程保留最近的 span 数，必须是 2 的幂
+
+  static Tracer &GetInstance() {
+    static Tracer instance;
+    return instance;
+  }
+
+  // 根 span 的采样率，[0, 1]；0 关闭追踪
+  void SetSampleRate(double rate);
+  double SampleRate() const;
+
+  // 按采样率决定是否开启一个新的 trace；未采样时返回空上下文
+  TraceContext Sample() {
+    uint64_t threshold = threshold_.load(std::memory_order_relaxed);
+    if (threshold == 0) return TraceContext();
+    uint64_t r = NextRandom();
+    if (threshold != UINT64_MAX && r >= threshold) return TraceContext();
+    return TraceContext{NewId(), 0};
+  }
+
+  // 当前线程上的上下文 (见 ScopedTraceContext)
+  static TraceContext Current() { return CurrentSlot(); }
+
+  // 请求的入口：当前线程已在某个 trace 中则作为其子调用，否则按采样率开启新的 trace
+  TraceContext CurrentOrSample() {
+    TraceContext current = Current();
+    return current.Sampled() ? current : Sample();
+  }
+
+  // 非 0 的随机 id (trace_id / span_id)
+  static uint64_t NewId() {
+    uint64_t id;
+    do {
+      id = NextRandom();
+    } while (id == 0);
+    return id;
+  }
+
+  // 写入当前线程的环形缓冲区，span.trace_id 为 0 时忽略
+  void Record(const SpanRecord &span);
+
+  // 所有线程缓冲区中的 span 快照，按开始时间排序
+  std::vector<SpanRecord> Collect() const;
+
+  // {"traceEvents":[{"name":..,"ph":"X","ts":..,"dur":..,"pid":..,"tid":..,"args":{..}},...]}
+  std::string DumpChromeTrace() const;
+
+  // {"resourceSpans":[{"resource":{service.name},"scopeSpans":[{"spans":[...]}]}]}
+  std::string DumpOtlpJson(const std::string &service_name = "kvstore") const;
+
+  // 丢弃已记录的 span (与写入并发调用是安全的)
+  void Clear();
+
+ private:
+  struct Ring;
+
+  Tracer();
+  ~Tracer();
+
+  static TraceContext &CurrentSlot() {
+    thread_local TraceContext current;
+    return current;
+  }
+
+  // xorshift64*，每个线程独立的状态
+  static uint64_t NextRandom();
+
+  Ring *LocalRing();
+
+  std::atomic<uint64_t> threshold_{0};  // rate * 2^64，UINT64_MAX 表示全部采样
+  int64_t wall_offset_ns_ = 0;          // system_clock - steady_clock
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<Ring>> rings_;  // 只增不减：线程退出后由新线程复用
+
+  friend class ScopedTraceContext;
+};
+
+/**
+ * @brief 在作用域内把 ctx 设为当前线程的上下文，离开时恢复
+ * @details 只用于同步调用链 (例如 RPC 处理函数直到提交 Raft)。作用域内不要让出协程：
+ * 同一线程上的其他协程会看到这个上下文。
+ */
+class ScopedTraceContext {
+ public:
+  explicit ScopedTraceContext(const TraceContext &ctx) : saved_(Tracer::CurrentSlot()) {
+    Tracer::CurrentSlot() = ctx;
+  }
+  ~ScopedTraceContext() { Tracer::CurrentSlot() = saved_; }
+
+  ScopedTraceContext(const ScopedTraceContext &) = delete;
+  ScopedTraceContext &operator=(const ScopedTraceContext &) = delete;
+
+ private:
+  TraceContext saved_;
+};
+
+/**
+ * @brief RAII span：构造时开始、析构 (或 End) 时写入缓冲区；parent 未采样时是空操作
+ */
+class TraceSpan {
+ public:
+  TraceSpan(const char *name, const TraceContext &parent) {
+    if (!parent.Sampled()) return;
+    span_.trace_id = parent.trace_id;
+    span_.parent_id = parent.span_id;
+    span_.span_id = Tracer::NewId();
+    span_.name = name;
+    span_.start_ns = TraceNowNanos();
+  }
+  ~TraceSpan() { End(); }
+
+  TraceSpan(const TraceSpan &) = delete;
+  TraceSpan &operator=(const TraceSpan &) = delete;
+
+  bool Sampled() const { return span_.trace_id != 0; }
+
+  // 以本 span 为父的上下文 (未采样时为空)
+  TraceContext Context() const { return TraceContext{span_.trace_id, span_.span_id}; }
+
+  void SetArg(const char *key, uint64_t value) {
+    span_.arg_key = key;
+    span_.arg_value = value;
+  }
+
+  void End() {
+    if (!Sampled()) return;
+    span_.end_ns = TraceNowNanos();
+    Tracer::GetInstance().Record(span_);
+    span_.trace_id = 0;
+  }
+
+ private:
+  SpanRecord span_;
+};
+
+#endif  // TRACE_H
@@ -18,7 +18,10 @@
 #include <chrono>
 #include <atomic>
 #include <memory>
+#include "binlog.h"
 #include "config.h"
+#include "opCodec.h"
+#include "ringQueue.h"
 
 #ifndef KVRAFTCPP_DEFER_H
 #define KVRAFTCPP_DEFER_H
@@ -107,18 +110,30 @@ class DeferClass {
 // 4. 支持移动语义：通过实现移动构造函数和移动赋值运算符，允许 `Defer` 对象被移动，而不会导致多次执行延迟代码块。
 
 
-void DPrintf(const char* format, ...);
+// Raft 调试日志 (printf 风格，格式串必须是字面量)：记录走 BinLogger，调用线程只拷贝参数、不做格式化；
+// Debug 为 false 或 BINLOG_ACTIVE_LEVEL 高于 DEBUG 时整条调用在编译期去掉，参数不求值
+#define DPrintf(fmt, ...)                                                 \
+  do {                                                                    \
+    if constexpr (Debug) {                                                \
+      BINLOG_LOG(BinLogLevel::kDebug, true, fmt, ##__VA_ARGS__);          \
+    }                                                                     \
+  } while (0)
 
 void myAssert(bool condition, std::string message = "Assertion failed!");
 
 template <typename... Args>
 std::string format(const char* format_str, Args... args) {
-    int size_s = std::snprintf(nullptr, 0, format_str, args...) + 1; // "\0"
-    if (size_s <= 0) { throw std::runtime_error("Error during formatting."); }
+    // 先写栈上缓冲区：短字符串只格式化一次、只分配一次 (返回的 string)
+    char stack_buf[256];
+    int size_s = std::snprintf(stack_buf, sizeof(stack_buf), format_str, args...);
+    if (size_s < 0) { throw std::runtime_error("Error during formatting."); }
     auto size = static_cast<size_t>(size_s);
-    std::vector<char> buf(size);
-    std::snprintf(buf.data(), size, format_str, args...);
-    return std::string(buf.data(), buf.data() + size - 1);  // remove '\0'
+    if (size < sizeof(stack_buf)) {
+        return std::string(stack_buf, size);
+    }
+    std::string out(size, '\0');
+    std::snprintf(&out[0], size + 1, format_str, args...);
+    return out;
 }
 
 std::chrono::_V2::system_clock::time_point now();
@@ -391,11 +406,36 @@ class Op {
                          // IfDuplicate bool // Duplicate command can't be applied twice , but only for PUT and APPEND
 
  public:
-  // todo
-  //为了协调raftRPC中的command只设置成了string,这个的限制就是正常字符中不能包含|
-  //当然后期可以换成更高级的序列化方法，比如protobuf
-
+  // 序列化为 LogEntry.command 的规范格式：紧凑二进制编码 (见 opCodec.h)
   std::string asString() const {      // Op 对象序列化为 std::string（用于 RPC 传输或写入日志）。
+    std::string out;
+    EncodeOp(out, Operation, Key, Value, ClientId, RequestId);
+    return out;
+  }
+
+  // 反序列化：自动识别二进制格式与旧的 boost 文本归档 (兼容升级前写入的日志)
+  bool parseFromString(const std::string& str) {
+    if (IsBinaryOp(str)) {
+      OpView view;
+      if (!DecodeOpView(str, &view)) {
+        return false;
+      }
+      assignFrom(view);
+      return true;
+    }
+    return parseFromBoostString(str);
+  }
+
+  void assignFrom(const OpView& view) {
+    Operation.assign(view.Operation.data(), view.Operation.size());
+    Key.assign(view.Key.data(), view.Key.size());
+    Value.assign(view.Value.data(), view.Value.size());
+    ClientId = view.ClientIdString();
+    RequestId = view.RequestId;
+  }
+
+  // 旧格式：boost text_oarchive，仅用于兼容历史日志和性能对比
+  std::string asBoostString() const {
     std::stringstream ss;
     boost::archive::text_oarchive oa(ss);
 
@@ -407,7 +447,7 @@ class Op {
   }
 
   // 反序列化（添加try...catch 块，防止崩溃）
-  bool parseFromString(std::string str) {
+  bool parseFromBoostString(const std::string& str) {
     try {
         std::stringstream iss(str);
         boost::archive::text_iarchive ia(iss);
@@ -421,7 +461,7 @@ class Op {
         // DPrintf("Op::parseFromString failed: %s", e.what());
         return false;
     }
-}
+  }
 
  public:
   friend std::ostream& operator<<(std::ostream& os, const Op& obj) {
@@ -442,6 +482,58 @@ class Op {
   }
 };
 
+// 批量写 (BatchPut / BatchDelete / MultiOp) 对应的一条日志 command
+// 整批作为一个 Raft 日志条目复制、在一次 SkipList 写锁内 apply，并只占用一个 (ClientId, RequestId) 幂等记录
+class OpBatch {
+ public:
+  struct Item {
+    std::string Operation;  // "Put" "Delete" "Append"
+    std::string Key;
+    std::string Value;
+  };
+
+  std::vector<Item> Ops;
+  std::string ClientId;
+  int RequestId = 0;
+
+ public:
+  void add(const std::string& operation, const std::string& key, const std::string& value = std::string()) {
+    Ops.push_back(Item{operation, key, value});
+  }
+
+  // 紧凑二进制编码 (见 opCodec.h EncodeOpBatch)
+  std::string asString() const {
+    std::vector<OpBatchItem> items;
+    items.reserve(Ops.size());
+    for (const Item& op : Ops) {
+      OpBatchItem item;
+      item.type = OpTypeFromName(op.Operation);
+      item.Operation = op.Operation;
+      item.Key = op.Key;
+      item.Value = op.Value;
+      items.push_back(item);
+    }
+    std::string out;
+    EncodeOpBatch(out, items, ClientId, RequestId);
+    return out;
+  }
+
+  bool parseFromString(const std::string& str) {
+    OpBatchView view;
+    if (!DecodeOpBatchView(str, &view)) {
+      return false;
+    }
+    ClientId = view.ClientIdString();
+    RequestId = view.RequestId;
+    Ops.clear();
+    Ops.reserve(view.Ops.size());
+    for (const OpView& op : view.Ops) {
+      Ops.push_back(Item{std::string(op.Operation), std::string(op.Key), std::string(op.Value)});
+    }
+    return true;
+  }
+};
+
 ///////////////////////////////////////////////kvserver reply err to clerk
 
 const std::string OK = "OK";
@@ -0,0 +1,212 @@
+#include "include/metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// ============================================================================
+// MetricHistogram
+// ============================================================================
+
+MetricHistogram::Snapshot MetricHistogram::Collect() const {
+  Snapshot snap;
+  for (const auto &shard : shards_) {
+    for (size_t i = 0; i < kBuckets; ++i) {
+      snap.counts[i] += shard.counts[i].load(std::memory_order_relaxed);
+    }
+    snap.sum += shard.sum.load(std::memory_order_relaxed);
+  }
+  for (size_t i = 0; i < kBuckets; ++i) snap.count += snap.counts[i];
+  return snap;
+}
+
+uint64_t MetricHistogram::Snapshot::Percentile(double q) const {
+  if (count == 0) return 0;
+  uint64_t rank = static_cast<uint64_t>(std::ceil(std::min(1.0, std::max(0.0, q)) * static_cast<double>(count)));
+  rank = std::max<uint64_t>(rank, 1);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBuckets; ++i) {
+    seen += counts[i];
+    if (seen >= rank) return BucketUpper(i);
+  }
+  return BucketUpper(kBuckets - 1);
+}
+
+// ============================================================================
+// MetricsRegistry
+// ============================================================================
+
+std::string FormatMetricLabels(const MetricLabels &labels) {
+  if (labels.empty()) return "";
+  std::string out = "{";
+  for (size_t i = 0; i < labels.size(); ++i) {
+    if (i > 0) out += ',';
+    out += labels[i].first;
+    out += "=\"";
+    for (char c : labels[i].second) {
+      if (c == '\\') {
+        out += "\\\\";
+      } else if (c == '"') {
+        out += "\\\"";
+      } else if (c == '\n') {
+        out += "\\n";
+      } else {
+        out += c;
+      }
+    }
+    out += '"';
+  }
+  out += '}';
+  return out;
+}
+
+MetricsRegistry::Series *MetricsRegistry::FindOrCreate(const std::string &name, const MetricLabels &labels, Type type,
+                                                       const std::string &help, bool with_value) {
+  auto it = families_.find(name);
+  if (it == families_.end()) {
+    it = families_.emplace(name, Family{type, help, {}}).first;
+  } else if (it->second.type != type) {
+    return nullptr;
+  }
+  if (it->second.help.empty()) it->second.help = help;
+
+  Series &series = it->second.series[FormatMetricLabels(labels)];
+  if (!with_value) return &series;
+  switch (type) {
+    case Type::kCounter:
+      if (!series.counter) series.counter.reset(new MetricCounter());
+      break;
+    case Type::kGauge:
+      if (!series.gauge) series.gauge.reset(new MetricGauge());
+      break;
+    case Type::kHistogram:
+      if (!series.histogram) series.histogram.reset(new MetricHistogram());
+      break;
+  }
+  return &series;
+}
+
+MetricCounter *MetricsRegistry::GetCounter(const std::string &name, const MetricLabels &labels,
+                                           const std::string &help) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Series *series = FindOrCreate(name, labels, Type::kCounter, help);
+  return series ? series->counter.get() : nullptr;
+}
+
+MetricGauge *MetricsRegistry::GetGauge(const std::string &name, const MetricLabels &labels, const std::string &help) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Series *series = FindOrCreate(name, labels, Type::kGauge, help);
+  return series ? series->gauge.get() : nullptr;
+}
+
+MetricHistogram *MetricsRegistry::GetHistogram(const std::string &name, const MetricLabels &labels,
+                                               const std::string &help) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Series *series = FindOrCreate(name, labels, Type::kHistogram, help);
+  return series ? series->histogram.get() : nullptr;
+}
+
+int MetricsRegistry::AddCallback(const std::string &name, const MetricLabels &labels, Type type,
+                                 std::function<double()> fn, const std::string &help) {
+  if (type == Type::kHistogram || !fn) return 0;
+  std::lock_guard<std::mutex> lock(mutex_);
+  Series *series = FindOrCreate(name, labels, type, help, false);
+  if (!series) return 0;
+  int id = next_callback_id_++;
+  series->callbacks.emplace(id, std::move(fn));
+  callback_index_.emplace(id, std::make_pair(name, FormatMetricLabels(labels)));
+  return id;
+}
+
+void MetricsRegistry::RemoveCallback(int id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = callback_index_.find(id);
+  if (it == callback_index_.end()) return;
+  families_[it->second.first].series[it->second.second].callbacks.erase(id);
+  callback_index_.erase(it);
+}
+
+namespace {
+
+void AppendNumber(std::string *out, double v) {
+  char buf[32];
+  if (v == std::floor(v) && std::fabs(v) < 1e15) {
+    snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(v));
+  } else {
+    snprintf(buf, sizeof(buf), "%.6g", v);
+  }
+  *out += buf;
+}
+
+// 在已渲染的标签串 {a="b"} 后追加 le 标签
+std::string WithLe(const std::string &labels, const std::string &le) {
+  if (labels.empty()) return "{le=\"" + le + "\"}";
+  return labels.substr(0, labels.size() - 1) + ",le=\"" + le + "\"}";
+}
+
+const char *TypeName(MetricsRegistry::Type type) {
+  switch (type) {
+    case MetricsRegistry::Type::kCounter:
+      return "counter";
+    case MetricsRegistry::Type::kGauge:
+      return "gauge";
+    case MetricsRegistry::Type::kHistogram:
+      return "histogram";
+  }
+  return "untyped";
+}
+
+}  // namespace
+
+/**
+ * @details 直方图只输出非空的桶 (累计计数) 与 +Inf，几百个桶里通常只有十几个非空，抓取体积与分桶精度无关。
+ * 回调在持锁期间执行：只应读取原子量，不能阻塞，也不能再访问注册表。
+ */
+std::string MetricsRegistry::RenderPrometheus() const {
+  std::string out;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto &family_entry : families_) {
+    const std::string &name = family_entry.first;
+    const Family &family = family_entry.second;
+    if (!family.help.empty()) {
+      out += "# HELP " + name + " " + family.help + "\n";
+    }
+    out += "# TYPE " + name + " " + TypeName(family.type) + "\n";
+
+    for (const auto &series_entry : family.series) {
+      const std::string &labels = series_entry.first;
+      const Series &series = series_entry.second;
+      if (family.type == Type::kHistogram) {
+        if (!series.histogram) continue;
+        MetricHistogram::Snapshot snap = series.histogram->Collect();
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i + 1 < MetricHistogram::kBuckets; ++i) {
+          if (snap.counts[i] == 0) continue;
+          cumulative += snap.counts[i];
+          out += name + "_bucket" + WithLe(labels, std::to_string(MetricHistogram::BucketUpper(i))) + " ";
+          AppendNumber(&out, static_cast<double>(cumulative));
+          out += "\n";
+        }
+        out += name + "_bucket" + WithLe(labels, "+Inf") + " ";
+        AppendNumber(&out, static_cast<double>(snap.count));
+        out += "\n" + name + "_sum" + labels + " ";
+        AppendNumber(&out, static_cast<double>(snap.sum));
+        out += "\n" + name + "_count" + labels + " ";
+        AppendNumber(&out, static_cast<double>(snap.count));
+        out += "\n";
+        continue;
+      }
+
+      bool has_value = series.counter || series.gauge || !series.callbacks.empty();
+      if (!has_value) continue;
+      double value = 0;
+      if (series.counter) value += static_cast<double>(series.counter->Value());
+      if (series.gauge) value += static_cast<double>(series.gauge->Value());
+      for (const auto &cb : series.callbacks) value += cb.second();
+      out += name + labels + " ";
+      AppendNumber(&out, value);
+      out += "\n";
+    }
+  }
+  return out;
+}
@@ -0,0 +1,111 @@
+#include "include/metrics_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include "include/metrics.h"
+#include "include/trace.h"
+
+MetricsServer::MetricsServer(const std::string &ip, uint16_t port) : ip_(ip.empty() ? "0.0.0.0" : ip), port_(port) {}
+
+MetricsServer::~MetricsServer() { Stop(); }
+
+bool MetricsServer::Start() {
+  if (running_.load()) return true;
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) return false;
+  int on = 1;
+  ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+  sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port_);
+  if (::inet_pton(AF_INET, ip_.c_str(), &addr.sin_addr) != 1 ||
+      ::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || ::listen(fd, 16) != 0) {
+    std::cerr << "[Metrics] Failed to listen on " << ip_ << ":" << port_ << ": " << std::strerror(errno) << std::endl;
+    ::close(fd);
+    return false;
+  }
+  socklen_t len = sizeof(addr);
+  ::getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len);
+  port_ = ntohs(addr.sin_port);
+
+  listen_fd_ = fd;
+  running_.store(true);
+  thread_ = std::thread(&MetricsServer::Loop, this);
+  return true;
+}
+
+void MetricsServer::Stop() {
+  if (!running_.exchange(false)) return;
+  if (thread_.joinable()) thread_.join();
+  ::close(listen_fd_);
+  listen_fd_ = -1;
+}
+
+void MetricsServer::Loop() {
+  while (running_.load()) {
+    // 带超时的 poll：Stop 最多等一个周期，不需要额外的唤醒 fd
+    pollfd pfd{listen_fd_, POLLIN, 0};
+    int n = ::poll(&pfd, 1, 100);
+    if (n <= 0) continue;
+    int fd = ::accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) continue;
+    HandleConnection(fd);
+    ::close(fd);
+  }
+}
+
+static bool SendAll(int fd, const std::string &data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    sent += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+void MetricsServer::HandleConnection(int fd) {
+  timeval tv{kIoTimeoutMs / 1000, (kIoTimeoutMs % 1000) * 1000};
+  ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+  // 只需要请求行；请求头读到空行为止 (上限 8KB)
+  std::string request;
+  char buf[1024];
+  while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+    ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    request.append(buf, static_cast<size_t>(n));
+  }
+
+  std::string status = "200 OK";
+  std::string content_type = "text/plain; version=0.0.4";
+  std::string body;
+  if (request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 13, "GET /metrics?") == 0) {
+    body = MetricsRegistry::GetInstance().RenderPrometheus();
+  } else if (request.compare(0, 11, "GET /trace ") == 0 || request.compare(0, 11, "GET /trace?") == 0) {
+    // ?format=otlp 返回 OTLP/JSON，默认 Chrome trace
+    size_t line_end = request.find("\r\n");
+    bool otlp = request.substr(0, line_end).find("format=otlp") != std::string::npos;
+    content_type = "application/json";
+    body = otlp ? Tracer::GetInstance().DumpOtlpJson() : Tracer::GetInstance().DumpChromeTrace();
+  } else {
+    status = "404 Not Found";
+    body = "only GET /metrics and GET /trace are served\n";
+  }
+  std::string response = "HTTP/1.1 " + status + "\r\nContent-Type: " + content_type + "\r\nContent-Length: " +
+                         std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+  SendAll(fd, response);
+}
@@ -0,0 +1,247 @@
+#include "include/trace.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+
+// 单写者的 seqlock 环形缓冲区：槽位序号为奇数表示正在写，2 * pos + 2 表示位置 pos 的 span 已写完
+struct Tracer::Ring {
+  struct Slot {
+    std::atomic<uint64_t> seq{0};
+    std::atomic<uint64_t> trace_id{0};
+    std::atomic<uint64_t> span_id{0};
+    std::atomic<uint64_t> parent_id{0};
+    std::atomic<uint64_t> start_ns{0};
+    std::atomic<uint64_t> end_ns{0};
+    std::atomic<uint64_t> arg_value{0};
+    std::atomic<const char *> name{nullptr};
+    std::atomic<const char *> arg_key{nullptr};
+  };
+
+  explicit Ring(uint32_t t) : tid(t) {}
+
+  void Write(const SpanRecord &span) {
+    uint64_t pos = head.load(std::memory_order_relaxed);
+    Slot &s = slots[pos & (kRingCapacity - 1)];
+    s.seq.store(2 * pos + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s.trace_id.store(span.trace_id, std::memory_order_relaxed);
+    s.span_id.store(span.span_id, std::memory_order_relaxed);
+    s.parent_id.store(span.parent_id, std::memory_order_relaxed);
+    s.start_ns.store(span.start_ns, std::memory_order_relaxed);
+    s.end_ns.store(span.end_ns, std::memory_order_relaxed);
+    s.arg_value.store(span.arg_value, std::memory_order_relaxed);
+    s.name.store(span.name, std::memory_order_relaxed);
+    s.arg_key.store(span.arg_key, std::memory_order_relaxed);
+    s.seq.store(2 * pos + 2, std::memory_order_release);
+    head.store(pos + 1, std::memory_order_release);
+  }
+
+  void Read(std::vector<SpanRecord> *out) const {
+    uint64_t end = head.load(std::memory_order_acquire);
+    uint64_t begin = end > kRingCapacity ? end - kRingCapacity : 0;
+    begin = std::max(begin, cleared.load(std::memory_order_acquire));
+    for (uint64_t pos = begin; pos < end; ++pos) {
+      const Slot &s = slots[pos & (kRingCapacity - 1)];
+      uint64_t seq = s.seq.load(std::memory_order_acquire);
+      if (seq != 2 * pos + 2) continue;  // 已被更新的 span 覆盖，或正在写
+      SpanRecord r;
+      r.trace_id = s.trace_id.load(std::memory_order_relaxed);
+      r.span_id = s.span_id.load(std::memory_order_relaxed);
+      r.parent_id = s.parent_id.load(std::memory_order_relaxed);
+      r.start_ns = s.start_ns.load(std::memory_order_relaxed);
+      r.end_ns = s.end_ns.load(std::memory_order_relaxed);
+      r.arg_value = s.arg_value.load(std::memory_order_relaxed);
+      r.name = s.name.load(std::memory_order_relaxed);
+      r.arg_key = s.arg_key.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (s.seq.load(std::memory_order_relaxed) != seq) continue;  // 读的过程中被覆盖
+      r.tid = tid;
+      out->push_back(r);
+    }
+  }
+
+  const uint32_t tid;
+  std::atomic<bool> owned{true};      // 所属线程退出后置 false，供新线程复用
+  std::atomic<uint64_t> head{0};      // 下一个写入位置，只由拥有者写
+  std::atomic<uint64_t> cleared{0};   // Clear 时的 head，之前的 span 不再导出
+  Slot slots[kRingCapacity];
+};
+
+static_assert((Tracer::kRingCapacity & (Tracer::kRingCapacity - 1)) == 0, "kRingCapacity must be a power of 2");
+
+Tracer::Tracer() {
+  auto wall = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::system_clock::now().time_since_epoch())
+                  .count();
+  wall_offset_ns_ = static_cast<int64_t>(wall) - static_cast<int64_t>(TraceNowNanos());
+}
+
+Tracer::~Tracer() = default;
+
+void Tracer::SetSampleRate(double rate) {
+  uint64_t threshold;
+  if (!(rate > 0.0)) {
+    threshold = 0;
+  } else if (rate >= 1.0) {
+    threshold = UINT64_MAX;
+  } else {
+    threshold = std::max<uint64_t>(1, static_cast<uint64_t>(rate * 18446744073709551616.0));
+  }
+  threshold_.store(threshold, std::memory_order_relaxed);
+}
+
+double Tracer::SampleRate() const {
+  uint64_t threshold = threshold_.load(std::memory_order_relaxed);
+  if (threshold == UINT64_MAX) return 1.0;
+  return static_cast<double>(threshold) / 18446744073709551616.0;
+}
+
+uint64_t Tracer::NextRandom() {
+  static std::atomic<uint64_t> seeds{0};
+  thread_local uint64_t state = [] {
+    // splitmix64 打散 (时钟, 线程序号)，保证非 0 且各线程互不相同
+    uint64_t z = TraceNowNanos() + seeds.fetch_add(1, std::memory_order_relaxed) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return z != 0 ? z : 0x9E3779B97F4A7C15ULL;
+  }();
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+  return state * 0x2545F4914F6CDD1DULL;
+}
+
+Tracer::Ring *Tracer::LocalRing() {
+  struct Holder {
+    Ring *ring = nullptr;
+    ~Holder() {
+      if (ring) ring->owned.store(false, std::memory_order_release);
+    }
+  };
+  thread_local Holder holder;
+  if (holder.ring) return holder.ring;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto &ring : rings_) {
+    bool expected = false;
+    if (ring->owned.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+      holder.ring = ring.get();
+      return holder.ring;
+    }
+  }
+  rings_.emplace_back(new Ring(static_cast<uint32_t>(rings_.size() + 1)));
+  holder.ring = rings_.back().get();
+  return holder.ring;
+}
+
+void Tracer::Record(const SpanRecord &span) {
+  if (span.trace_id == 0) return;
+  LocalRing()->Write(span);
+}
+
+std::vector<SpanRecord> Tracer::Collect() const {
+  std::vector<SpanRecord> spans;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &ring : rings_) ring->Read(&spans);
+  }
+  std::sort(spans.begin(), spans.end(),
+            [](const SpanRecord &a, const SpanRecord &b) { return a.start_ns < b.start_ns; });
+  return spans;
+}
+
+void Tracer::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto &ring : rings_) ring->cleared.store(ring->head.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+namespace {
+
+std::string Hex64(uint64_t v) {
+  char buf[17];
+  std::snprintf(buf, sizeof(buf), "%016" PRIx64, v);
+  return buf;
+}
+
+void AppendJsonString(std::string *out, const char *s) {
+  out->push_back('"');
+  for (; s && *s; ++s) {
+    char c = *s;
+    if (c == '"' || c == '\\') {
+      out->push_back('\\');
+      out->push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char buf[8];
+      std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+      out->append(buf);
+    } else {
+      out->push_back(c);
+    }
+  }
+  out->push_back('"');
+}
+
+// 纳秒 -> 带三位小数的微秒 (Chrome trace 的时间单位)
+std::string Micros(uint64_t ns) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%" PRIu64 ".%03" PRIu64, ns / 1000, ns % 1000);
+  return buf;
+}
+
+}  // namespace
+
+std::string Tracer::DumpChromeTrace() const {
+  std::vector<SpanRecord> spans = Collect();
+  std::string pid = std::to_string(::getpid());
+  std::string out = "{\"traceEvents\":[";
+  for (size_t i = 0; i < spans.size(); ++i) {
+    const SpanRecord &s = spans[i];
+    if (i > 0) out += ',';
+    out += "{\"name\":";
+    AppendJsonString(&out, s.name);
+    out += ",\"cat\":\"kv\",\"ph\":\"X\",\"ts\":" + Micros(s.start_ns + wall_offset_ns_);
+    out += ",\"dur\":" + Micros(s.end_ns > s.start_ns ? s.end_ns - s.start_ns : 0);
+    out += ",\"pid\":" + pid + ",\"tid\":" + std::to_string(s.tid);
+    out += ",\"args\":{\"trace_id\":\"" + Hex64(s.trace_id) + "\",\"span_id\":\"" + Hex64(s.span_id) +
+           "\",\"parent_id\":\"" + Hex64(s.parent_id) + "\"";
+    if (s.arg_key) {
+      out += ',';
+      AppendJsonString(&out, s.arg_key);
+      out += ':' + std::to_string(s.arg_value);
+    }
+    out += "}}";
+  }
+  out += "],\"displayTimeUnit\":\"ms\"}";
+  return out;
+}
+
+std::string Tracer::DumpOtlpJson(const std::string &service_name) const {
+  std::vector<SpanRecord> spans = Collect();
+  std::string out = "{\"resourceSpans\":[{\"resource\":{\"attributes\":[{\"key\":\"service.name\",\"value\":{\"stringValue\":";
+  AppendJsonString(&out, service_name.c_str());
+  out += "}}]},\"scopeSpans\":[{\"scope\":{\"name\":\"kvstore.trace\"},\"spans\":[";
+  for (size_t i = 0; i < spans.size(); ++i) {
+    const SpanRecord &s = spans[i];
+    if (i > 0) out += ',';
+    // OTLP 的 traceId 为 16 字节，高 8 字节补 0
+    out += "{\"traceId\":\"" + Hex64(0) + Hex64(s.trace_id) + "\",\"spanId\":\"" + Hex64(s.span_id) + "\"";
+    if (s.parent_id != 0) out += ",\"parentSpanId\":\"" + Hex64(s.parent_id) + "\"";
+    out += ",\"name\":";
+    AppendJsonString(&out, s.name);
+    out += ",\"kind\":1,\"startTimeUnixNano\":\"" + std::to_string(s.start_ns + wall_offset_ns_) +
+           "\",\"endTimeUnixNano\":\"" + std::to_string(s.end_ns + wall_offset_ns_) + "\"";
+    out += ",\"attributes\":[{\"key\":\"thread.id\",\"value\":{\"intValue\":\"" + std::to_string(s.tid) + "\"}}";
+    if (s.arg_key) {
+      out += ",{\"key\":";
+      AppendJsonString(&out, s.arg_key);
+      out += ",\"value\":{\"intValue\":\"" + std::to_string(s.arg_value) + "\"}}";
+    }
+    out += "]}";
+  }
+  out += "]}]}]}";
+  return out;
+}
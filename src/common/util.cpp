@@ -1,6 +1,5 @@
 #include "include/util.h"
 #include <chrono>
-#include <cstdarg>
 #include <cstdio>
 #include <ctime>
 #include <iomanip>
@@ -58,18 +57,3 @@ bool isReleasePort(unsigned short usPort) {
   close(s);
   return true;
 }
-
-void DPrintf(const char *format, ...) {
-  if (Debug) {
-    // 获取当前的日期，然后取日志信息，写入相应的日志文件当中 a+
-    time_t now = time(nullptr);
-    tm *nowtm = localtime(&now);
-    va_list args;
-    va_start(args, format);
-    std::printf("[%d-%d-%d-%d-%d-%d] ", nowtm->tm_year + 1900, nowtm->tm_mon + 1, nowtm->tm_mday, nowtm->tm_hour,
-                nowtm->tm_min, nowtm->tm_sec);
-    std::vprintf(format, args);
-    std::printf("\n");
-    va_end(args);
-  }
-}
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "apply_pipeline.h"
+
+#include <algorithm>
+
+#include "cpu_topology.h"
+#include "trace.h"
+
+namespace raft {
+
+static const ApplyResult kEmptyResult;
+
+// 被采样的日志各记录一个 raft.apply span (整批在一次调用里执行，起止时间相同)
+static void RecordApplySpans(const std::vector<ApplyEntry>& batch, uint64_t start_ns, uint64_t end_ns) {
+    for (const ApplyEntry& e : batch) {
+        if (e.trace_id == 0) {
+            continue;
+        }
+        SpanRecord span;
+        span.trace_id = e.trace_id;
+        span.span_id = Tracer::NewId();
+        span.parent_id = e.span_id;
+        span.name = "raft.apply";
+        span.start_ns = start_ns;
+        span.end_ns = end_ns;
+        span.arg_key = "batch";
+        span.arg_value = batch.size();
+        Tracer::GetInstance().Record(span);
+    }
+}
+
+ApplyPipeline::ApplyPipeline(ApplySource* source, ApplyStateMachine* machine, const ApplyConfig& config)
+    : source_(source), machine_(machine), config_(config) {
+    config_.max_batch_entries = std::max<size_t>(1, config_.max_batch_entries);
+    config_.max_batch_bytes = std::max<size_t>(1, config_.max_batch_bytes);
+}
+
+ApplyPipeline::~ApplyPipeline() {
+    Stop();
+}
+
+// =========================================================
+//  PART 1: 生命周期
+// =========================================================
+
+void ApplyPipeline::Start(uint64_t applied_index) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (running_) {
+        return;
+    }
+    applied_index_ = applied_index;
+    commit_index_ = std::max(commit_index_, applied_index);
+    stalled_at_ = 0;
+    running_ = true;
+    applier_ = std::thread(&ApplyPipeline::ApplyLoop, this);
+}
+
+void ApplyPipeline::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        running_ = false;
+    }
+    cv_.notify_one();
+    if (applier_.joinable()) {
+        applier_.join();
+    }
+    WaiterMap pending;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        pending.swap(waiters_);
+        stats_.completed += pending.size();
+    }
+    CompleteAll(pending, Status::kShutdown);
+}
+
+void ApplyPipeline::CompleteAll(WaiterMap& waiters, Status status) {
+    for (auto& kv : waiters) {
+        kv.second.cb(status, kEmptyResult);
+    }
+    waiters.clear();
+}
+
+// =========================================================
+//  PART 2: 提交与等待 (Raft 核心 / RPC 线程调用)
+// =========================================================
+
+void ApplyPipeline::OnCommit(uint64_t commit_index) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (commit_index <= commit_index_) {
+            return;
+        }
+        commit_index_ = commit_index;
+    }
+    cv_.notify_one();
+}
+
+void ApplyPipeline::Wait(uint64_t index, uint64_t term, WaitCallback cb) {
+    Status status;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (running_ && index > applied_index_) {
+            waiters_.emplace(index, Waiter{term, std::move(cb)});
+            return;
+        }
+        status = running_ ? Status::kLost : Status::kShutdown;
+        ++stats_.completed;
+        if (status == Status::kLost) {
+            ++stats_.lost;
+        }
+    }
+    cb(status, kEmptyResult);
+}
+
+bool ApplyPipeline::InstallSnapshot(uint64_t last_included_index, const std::function<void()>& install) {
+    WaiterMap covered;
+    {
+        // 持有 apply_mtx_：没有正在执行的批，install 期间 apply 线程也不会开始新的一批
+        std::lock_guard<std::mutex> apply_guard(apply_mtx_);
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (last_included_index <= applied_index_) {
+                return false;
+            }
+        }
+        if (install) {
+            install();
+        }
+        std::lock_guard<std::mutex> lock(mtx_);
+        applied_index_ = last_included_index;
+        commit_index_ = std::max(commit_index_, last_included_index);
+        stalled_at_ = 0;
+        auto end = waiters_.upper_bound(last_included_index);
+        covered.insert(std::make_move_iterator(waiters_.begin()), std::make_move_iterator(end));
+        waiters_.erase(waiters_.begin(), end);
+        stats_.completed += covered.size();
+        stats_.lost += covered.size();
+    }
+    cv_.notify_one();
+    CompleteAll(covered, Status::kLost);
+    // 与 apply 线程一样在锁外回调：快照推进的 applied_index 也要通知 ReadIndex 等使用方
+    if (on_applied_) {
+        on_applied_(last_included_index);
+    }
+    return true;
+}
+
+uint64_t ApplyPipeline::AppliedIndex() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return applied_index_;
+}
+
+ApplyStats ApplyPipeline::Stats() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return stats_;
+}
+
+// =========================================================
+//  PART 3: apply 线程
+// =========================================================
+
+void ApplyPipeline::ApplyLoop() {
+    ThreadPlacement::GetInstance().PinCurrentThread(kPlacementApply);
+    std::vector<ApplyEntry> batch;      // 批与批之间复用，command 的内存不必重新分配
+    std::vector<ApplyResult> results;
+    std::vector<Completion> done;
+
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (true) {
+        cv_.wait(lock, [this] {
+            return !running_ || (commit_index_ > applied_index_ && applied_index_ + 1 != stalled_at_);
+        });
+        if (!running_) {
+            return;
+        }
+        lock.unlock();
+
+        uint64_t last = 0;
+        {
+            std::lock_guard<std::mutex> apply_guard(apply_mtx_);
+            uint64_t from = 0;
+            uint64_t to = 0;
+            {
+                std::lock_guard<std::mutex> guard(mtx_);
+                from = applied_index_ + 1;  // InstallSnapshot 可能刚推进过
+                to = commit_index_;
+            }
+            size_t n = from <= to ? source_->CopyCommitted(from, to, config_.max_batch_entries,
+                                                           config_.max_batch_bytes, &batch)
+                                  : 0;
+            if (n == 0) {
+                lock.lock();
+                if (from <= to && applied_index_ + 1 == from) {
+                    stalled_at_ = from;  // 日志已被压缩，等快照
+                }
+                continue;
+            }
+            batch.resize(n);
+            results.resize(n);
+            for (ApplyResult& r : results) {
+                r.code = 0;
+                r.value.clear();
+                r.ops.clear();
+            }
+            bool traced = std::any_of(batch.begin(), batch.end(),
+                                      [](const ApplyEntry& e) { return e.trace_id != 0; });
+            uint64_t apply_start = traced ? TraceNowNanos() : 0;
+            machine_->ApplyBatch(batch, &results);
+            last = batch.back().index;
+            if (traced) {
+                RecordApplySpans(batch, apply_start, TraceNowNanos());
+            }
+
+            std::lock_guard<std::mutex> guard(mtx_);
+            applied_index_ = last;
+            ++stats_.batches;
+            stats_.entries += n;
+            stats_.max_batch = std::max<uint64_t>(stats_.max_batch, n);
+            // 一次取出落在本批内的所有等待者；日志位置连续，下标直接由 index 算出
+            auto end = waiters_.upper_bound(last);
+            for (auto it = waiters_.begin(); it != end; ++it) {
+                Status status = Status::kLost;
+                size_t entry = 0;
+                if (it->first >= from) {
+                    entry = static_cast<size_t>(it->first - from);
+                    if (batch[entry].term == it->second.term) {
+                        status = Status::kApplied;
+                    }
+                }
+                if (status == Status::kLost) {
+                    ++stats_.lost;
+                }
+                done.push_back(Completion{status, entry, std::move(it->second.cb)});
+            }
+            stats_.completed += done.size();
+            waiters_.erase(waiters_.begin(), end);
+        }
+
+        // 不持有任何锁：OnCommit / Wait / InstallSnapshot 不会被回调挡住
+        if (on_applied_) {
+            on_applied_(last);
+        }
+        for (Completion& c : done) {
+            c.cb(c.status, c.status == Status::kApplied ? results[c.entry] : kEmptyResult);
+        }
+        done.clear();
+        lock.lock();
+    }
+}
+
+}  // namespace raft
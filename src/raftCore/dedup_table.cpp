@@ -0,0 +1,280 @@
+#include "dedup_table.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "crc32c.h"
+
+namespace raft {
+
+// =========================================================
+//  PART 1: 客户端 key
+// =========================================================
+
+static uint64_t Mix64(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+static uint64_t HashClientString(std::string_view id) {
+    uint64_t h = 0xcbf29ce484222325ull;  // FNV-1a
+    for (char c : id) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 0x100000001b3ull;
+    }
+    return Mix64(h);
+}
+
+uint64_t DedupClientKey(std::string_view client_id) {
+    uint64_t num = 0;
+    if (ParseNumericClientId(client_id, &num)) {
+        return num;
+    }
+    return HashClientString(client_id);
+}
+
+uint64_t DedupClientKey(const OpView& op) {
+    return op.ClientIsNumeric ? op.ClientNum : DedupClientKey(op.ClientId);
+}
+
+// =========================================================
+//  PART 2: 开放寻址表
+// =========================================================
+
+static size_t RoundUpPow2(size_t n) {
+    size_t cap = 16;
+    while (cap < n) {
+        cap <<= 1;
+    }
+    return cap;
+}
+
+DedupTable::DedupTable(DedupOptions options)
+    : options_(options), min_capacity_(RoundUpPow2(options.initial_capacity)) {
+    Rehash(min_capacity_);
+}
+
+size_t DedupTable::Home(uint64_t stored) const {
+    return static_cast<size_t>(Mix64(stored)) & mask_;
+}
+
+bool DedupTable::Expired(const Slot& slot, uint64_t tick) const {
+    return options_.session_ttl != 0 && tick > slot.last_tick && tick - slot.last_tick > options_.session_ttl;
+}
+
+size_t DedupTable::Find(uint64_t stored) const {
+    for (size_t pos = Home(stored);; pos = (pos + 1) & mask_) {
+        if (slots_[pos].client == stored) {
+            return pos;
+        }
+        if (slots_[pos].client == 0) {
+            return capacity_;
+        }
+    }
+}
+
+DedupTable::Result DedupTable::Check(uint64_t client, int64_t request_id, uint64_t tick) {
+    uint64_t stored = StoredKey(client);
+    size_t pos = Home(stored);
+    for (; slots_[pos].client != 0; pos = (pos + 1) & mask_) {
+        Slot& slot = slots_[pos];
+        if (slot.client != stored) {
+            continue;
+        }
+        bool expired = Expired(slot, tick);
+        slot.last_tick = std::max(slot.last_tick, tick);
+        if (!expired && request_id <= slot.request_id) {
+            return Result::kDuplicate;
+        }
+        // 过期的会话等同于不存在：从这个请求重新开始
+        slot.request_id = request_id;
+        return Result::kNew;
+    }
+
+    if ((size_ + 1) * 4 > capacity_ * 3) {
+        MaybeGrow(tick);
+        InsertNew(stored, request_id, tick);  // 表已经变了，重新探测空槽
+    } else {
+        slots_[pos] = Slot{stored, request_id, tick};
+        ++size_;
+    }
+    return Result::kNew;
+}
+
+bool DedupTable::LastRequest(uint64_t client, uint64_t tick, int64_t* request_id) const {
+    size_t pos = Find(StoredKey(client));
+    if (pos == capacity_ || Expired(slots_[pos], tick)) {
+        return false;
+    }
+    *request_id = slots_[pos].request_id;
+    return true;
+}
+
+// backward-shift 删除：把后面探测链上可以前移的元素依次挪进空洞，不留墓碑
+void DedupTable::EraseAt(size_t pos) {
+    size_t hole = pos;
+    for (size_t next = (hole + 1) & mask_; slots_[next].client != 0; next = (next + 1) & mask_) {
+        size_t home = Home(slots_[next].client);
+        // home 不在 (hole, next] 之间 (按环形距离) 时，元素挪到 hole 仍然能从 home 探测到
+        if (((next - home) & mask_) >= ((next - hole) & mask_)) {
+            slots_[hole] = slots_[next];
+            hole = next;
+        }
+    }
+    slots_[hole].client = 0;
+    --size_;
+}
+
+void DedupTable::InsertNew(uint64_t stored, int64_t request_id, uint64_t last_tick) {
+    size_t pos = Home(stored);
+    while (slots_[pos].client != 0) {
+        pos = (pos + 1) & mask_;
+    }
+    slots_[pos] = Slot{stored, request_id, last_tick};
+    ++size_;
+}
+
+void DedupTable::Rehash(size_t capacity) {
+    std::unique_ptr<Slot[]> old = std::move(slots_);
+    size_t old_capacity = old ? capacity_ : 0;
+    capacity_ = capacity;
+    mask_ = capacity - 1;
+    slots_.reset(new Slot[capacity]());
+    size_ = 0;
+    sweep_cursor_ = 0;
+    for (size_t i = 0; i < old_capacity; ++i) {
+        if (old[i].client != 0) {
+            InsertNew(old[i].client, old[i].request_id, old[i].last_tick);
+        }
+    }
+}
+
+// 装载率到 3/4：先整表回收过期会话，剩下的仍超过 5/8 才翻倍 (两次扩容之间至少隔 1/8 容量的插入)
+void DedupTable::MaybeGrow(uint64_t tick) {
+    Sweep(tick, capacity_);
+    if ((size_ + 1) * 8 > capacity_ * 5) {
+        Rehash(capacity_ * 2);
+    }
+}
+
+size_t DedupTable::Sweep(uint64_t tick, size_t max_slots) {
+    if (options_.session_ttl == 0) {
+        return 0;
+    }
+    size_t freed = 0;
+    for (size_t n = 0; n < max_slots; ++n) {
+        Slot& slot = slots_[sweep_cursor_];
+        if (slot.client != 0 && Expired(slot, tick)) {
+            EraseAt(sweep_cursor_);
+            ++freed;
+            // 后面的元素可能刚挪进这个槽：不前进，下一轮再看一次 (本轮计数照算，循环有界)
+            continue;
+        }
+        sweep_cursor_ = (sweep_cursor_ + 1) & mask_;
+    }
+    // 过空就缩容到 1/4 装载，把内存还回去 (下一次缩容 / 扩容之前至少隔 1/8 容量的删除 / 插入)
+    if (capacity_ > min_capacity_ && size_ * 8 < capacity_) {
+        Rehash(std::max(min_capacity_, RoundUpPow2(size_ * 4)));
+    }
+    return freed;
+}
+
+void DedupTable::Clear() {
+    slots_.reset();
+    Rehash(min_capacity_);
+}
+
+// =========================================================
+//  PART 3: 快照编码
+// =========================================================
+
+static constexpr uint8_t kDedupSnapshotMagic = 0xD7;
+
+static bool SetError(std::string* error, const std::string& what) {
+    if (error != nullptr) {
+        *error = what;
+    }
+    return false;
+}
+
+std::string DedupTable::Encode(uint64_t tick) const {
+    std::vector<Slot> live;
+    live.reserve(size_);
+    for (size_t i = 0; i < capacity_; ++i) {
+        const Slot& slot = slots_[i];
+        if (slot.client != 0 && !Expired(slot, tick)) {
+            live.push_back(Slot{UserKey(slot.client), slot.request_id, slot.last_tick});
+        }
+    }
+    std::sort(live.begin(), live.end(), [](const Slot& a, const Slot& b) { return a.client < b.client; });
+
+    std::string out;
+    out.reserve(16 + live.size() * 8);
+    out.push_back(static_cast<char>(kDedupSnapshotMagic));
+    PutVarint64(out, tick);
+    PutVarint64(out, live.size());
+    uint64_t prev = 0;
+    for (const Slot& slot : live) {
+        PutVarint64(out, slot.client - prev);  // 数字 id 通常是连续分配的，差值很短
+        PutVarint64(out, ZigZagEncode(slot.request_id));
+        PutVarint64(out, tick > slot.last_tick ? tick - slot.last_tick : 0);
+        prev = slot.client;
+    }
+    uint32_t crc = Crc32c(out.data(), out.size());
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((crc >> (8 * i)) & 0xFF));
+    }
+    return out;
+}
+
+bool DedupTable::Decode(std::string_view data, std::string* error) {
+    if (data.size() < 5 || static_cast<uint8_t>(data[0]) != kDedupSnapshotMagic) {
+        return SetError(error, "dedup snapshot: bad magic");
+    }
+    std::string_view body = data.substr(0, data.size() - 4);
+    uint32_t crc = 0;
+    for (int i = 0; i < 4; ++i) {
+        crc |= static_cast<uint32_t>(static_cast<uint8_t>(data[data.size() - 4 + i])) << (8 * i);
+    }
+    if (Crc32c(body.data(), body.size()) != crc) {
+        return SetError(error, "dedup snapshot: checksum mismatch");
+    }
+    body.remove_prefix(1);
+
+    uint64_t tick = 0;
+    uint64_t count = 0;
+    if (!GetVarint64(body, &tick) || !GetVarint64(body, &count) || count > body.size()) {
+        return SetError(error, "dedup snapshot: bad header");
+    }
+    std::vector<Slot> entries;
+    entries.reserve(count);
+    uint64_t client = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t delta = 0, request = 0, idle = 0;
+        if (!GetVarint64(body, &delta) || !GetVarint64(body, &request) || !GetVarint64(body, &idle)) {
+            return SetError(error, "dedup snapshot: truncated entry");
+        }
+        if (i > 0 && delta == 0) {
+            return SetError(error, "dedup snapshot: duplicate client");
+        }
+        client += delta;
+        entries.push_back(Slot{client, ZigZagDecode(request), tick > idle ? tick - idle : 0});
+    }
+    if (!body.empty()) {
+        return SetError(error, "dedup snapshot: trailing bytes");
+    }
+
+    // 全部解析成功才替换当前内容
+    slots_.reset();
+    Rehash(std::max(min_capacity_, RoundUpPow2(entries.size() * 2)));
+    for (const Slot& e : entries) {
+        InsertNew(StoredKey(e.client), e.request_id, e.last_tick);
+    }
+    return true;
+}
+
+}  // namespace raft
@@ -0,0 +1,172 @@
+#include "election.h"
+
+#include <algorithm>
+
+namespace raft {
+
+ElectionControl::ElectionControl(int32_t self, std::vector<int32_t> peers, const ElectionConfig& config)
+    : self_(self),
+      peers_(std::move(peers)),
+      config_(config),
+      election_timeout_(std::chrono::milliseconds(config.election_timeout_min_ms)) {}
+
+bool ElectionControl::IsPeer(int32_t node) const {
+    return std::find(peers_.begin(), peers_.end(), node) != peers_.end();
+}
+
+// =========================================================
+//  PART 1: 投票
+// =========================================================
+
+void ElectionControl::OnLeaderContact(int32_t leader, Clock::time_point now) {
+    leader_ = leader;
+    leader_contact_ = now;
+}
+
+bool ElectionControl::LeaderAlive(Clock::time_point now) const {
+    if (is_leader_) {
+        return true;  // 领导人是否失去多数派由 QuorumActive 判断，失去时先退位
+    }
+    return leader_ >= 0 && Recent(leader_contact_, now);
+}
+
+VoteDecision ElectionControl::HandleVote(const VoteRequest& request, uint64_t current_term, int32_t voted_for,
+                                         const LogPosition& local, Clock::time_point now) const {
+    VoteDecision decision;
+    if (request.term < current_term) {
+        return decision;
+    }
+    // stickiness：领导人还活着时不理会 (预) 投票，也不更新任期，分区节点回来不会打断现任领导人
+    if (config_.check_quorum && !request.transfer && LeaderAlive(now)) {
+        return decision;
+    }
+    if (request.pre_vote) {
+        // 预投票不改变任何本地状态；候选人的任期还没真正递增，等于当前任期说明它落后了 (或同任期已有选举)
+        decision.grant = request.term > current_term && LogUpToDate(request.log, local);
+        return decision;
+    }
+    decision.update_term = request.term > current_term;
+    bool can_vote = decision.update_term || voted_for < 0 || voted_for == request.candidate_id;
+    decision.grant = can_vote && LogUpToDate(request.log, local);
+    return decision;
+}
+
+bool ElectionControl::AcceptTimeoutNow(uint64_t request_term, int32_t from, uint64_t current_term) const {
+    return !is_leader_ && request_term == current_term && from == leader_;
+}
+
+// =========================================================
+//  PART 2: CheckQuorum
+// =========================================================
+
+void ElectionControl::BecomeLeader(Clock::time_point now) {
+    is_leader_ = true;
+    leader_ = self_;
+    transfer_target_ = -1;
+    // 刚当选时还没有任何回复：给一个完整的宽限期，而不是立刻判定失去多数派
+    last_ack_.clear();
+    for (int32_t peer : peers_) {
+        last_ack_[peer] = now;
+    }
+}
+
+void ElectionControl::StepDown() {
+    is_leader_ = false;
+    if (leader_ == self_) {
+        leader_ = -1;
+    }
+    transfer_target_ = -1;
+    timeout_now_sent_ = false;
+    last_ack_.clear();
+}
+
+void ElectionControl::OnPeerAck(int32_t peer, Clock::time_point now) {
+    if (is_leader_ && IsPeer(peer)) {
+        last_ack_[peer] = now;
+    }
+}
+
+bool ElectionControl::QuorumActive(Clock::time_point now) const {
+    if (!config_.check_quorum || !is_leader_) {
+        return true;
+    }
+    size_t active = 1;  // 自己
+    for (const auto& kv : last_ack_) {
+        if (Recent(kv.second, now)) {
+            ++active;
+        }
+    }
+    return active >= QuorumSize();
+}
+
+// =========================================================
+//  PART 3: 领导权转移
+// =========================================================
+
+ElectionControl::TransferStatus ElectionControl::BeginTransfer(int32_t target, uint64_t target_match,
+                                                               uint64_t last_index, bool* send_timeout_now,
+                                                               Clock::time_point now) {
+    *send_timeout_now = false;
+    if (!is_leader_) {
+        return TransferStatus::kNotLeader;
+    }
+    if (target == self_) {
+        return TransferStatus::kAlreadyLeader;
+    }
+    if (!IsPeer(target)) {
+        return TransferStatus::kUnknownTarget;
+    }
+    if (Transferring(now) && transfer_target_ == target) {
+        return TransferStatus::kInProgress;
+    }
+    // 换了目标：放弃之前的转移重新开始
+    transfer_target_ = target;
+    transfer_deadline_ = now + std::chrono::milliseconds(config_.transfer_timeout_ms);
+    timeout_now_sent_ = false;
+    if (target_match >= last_index) {
+        timeout_now_sent_ = true;
+        *send_timeout_now = true;
+    }
+    return TransferStatus::kStarted;
+}
+
+bool ElectionControl::OnMatchAdvanced(int32_t peer, uint64_t match, uint64_t last_index) {
+    if (!is_leader_ || peer != transfer_target_ || timeout_now_sent_ || match < last_index) {
+        return false;
+    }
+    timeout_now_sent_ = true;
+    return true;
+}
+
+bool ElectionControl::Transferring(Clock::time_point now) {
+    if (transfer_target_ < 0) {
+        return false;
+    }
+    if (now >= transfer_deadline_) {
+        // 目标迟迟没有当选 (宕机 / 追不上)：放弃，恢复接受写
+        transfer_target_ = -1;
+        timeout_now_sent_ = false;
+        return false;
+    }
+    return true;
+}
+
+int32_t ElectionControl::PickTransferTarget(const std::unordered_map<int32_t, uint64_t>& match_index,
+                                            Clock::time_point now) const {
+    int32_t best = -1;
+    uint64_t best_match = 0;
+    for (int32_t peer : peers_) {
+        auto ack = last_ack_.find(peer);
+        auto match = match_index.find(peer);
+        if (ack == last_ack_.end() || !Recent(ack->second, now) || match == match_index.end()) {
+            continue;
+        }
+        if (best < 0 || match->second > best_match || (match->second == best_match && peer < best)) {
+            best = peer;
+            best_match = match->second;
+        }
+    }
+    return best;
+}
+
+} // namespace raft
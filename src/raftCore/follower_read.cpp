@@ -0,0 +1,131 @@
+#include "follower_read.h"
+
+#include <algorithm>
+
+namespace raft {
+
+// =========================================================
+//  PART 1: Raft 核心驱动的状态
+// =========================================================
+
+FollowerRead::FollowerRead(ReadIndexFetcher fetcher, const FollowerReadConfig& config)
+    : fetcher_(std::move(fetcher)), config_(config) {
+    config_.max_contacts = std::max<size_t>(config_.max_contacts, 1);
+}
+
+void FollowerRead::OnLeaderContact(uint64_t leader_commit, Clock::time_point received_at) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (leader_commit <= applied_index_) {
+            // 本地已经覆盖这条消息之前的全部写
+            if (!has_fresh_ || received_at > fresh_at_) {
+                fresh_at_ = received_at;
+                has_fresh_ = true;
+            }
+        } else {
+            // 记录保持 leaderCommit 递增：新记录覆盖掉 commit 不更大的旧记录 (后者更早，不会给出更新的 fresh_at)
+            while (!contacts_.empty() && contacts_.back().first >= leader_commit) {
+                contacts_.pop_back();
+            }
+            if (contacts_.size() >= config_.max_contacts) {
+                contacts_.pop_front();
+            }
+            contacts_.emplace_back(leader_commit, received_at);
+        }
+    }
+    cv_.notify_all();
+}
+
+void FollowerRead::OnApplied(uint64_t applied_index) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (applied_index <= applied_index_) {
+            return;
+        }
+        applied_index_ = applied_index;
+        while (!contacts_.empty() && contacts_.front().first <= applied_index_) {
+            if (!has_fresh_ || contacts_.front().second > fresh_at_) {
+                fresh_at_ = contacts_.front().second;
+                has_fresh_ = true;
+            }
+            contacts_.pop_front();
+        }
+    }
+    cv_.notify_all();
+}
+
+void FollowerRead::OnLeaderLost() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    contacts_.clear();
+    has_fresh_ = false;
+}
+
+// =========================================================
+//  PART 2: 读请求
+// =========================================================
+
+bool FollowerRead::SatisfiedLocked(const FollowerReadOptions& options, Clock::time_point now) const {
+    if (applied_index_ < options.min_applied_index) {
+        return false;
+    }
+    if (options.max_staleness_ms <= 0) {
+        return true;
+    }
+    return has_fresh_ && now - fresh_at_ <= std::chrono::milliseconds(options.max_staleness_ms);
+}
+
+FollowerRead::Status FollowerRead::WaitReadable(const FollowerReadOptions& options, int timeout_ms,
+                                                uint64_t* applied_index) {
+    const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+    const Clock::time_point catch_up =
+        std::min(deadline, Clock::now() + std::chrono::milliseconds(config_.catch_up_wait_ms));
+
+    std::unique_lock<std::mutex> lock(mtx_);
+    // 1. 本地满足 (或很快满足：下一个心跳 / apply 到来)
+    if (cv_.wait_until(lock, catch_up, [&]() { return SatisfiedLocked(options, Clock::now()); })) {
+        ++stats_.local_reads;
+        if (applied_index) {
+            *applied_index = applied_index_;
+        }
+        return Status::kOk;
+    }
+
+    // 2. 回退：向领导人要 read index，再等本地 apply 追上
+    lock.unlock();
+    uint64_t read_index = 0;
+    int remaining = static_cast<int>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count());
+    bool fetched = remaining > 0 && fetcher_ && fetcher_(remaining, &read_index);
+    lock.lock();
+    if (!fetched) {
+        return Status::kTimeout;
+    }
+    if (!cv_.wait_until(lock, deadline, [&]() { return applied_index_ >= read_index; })) {
+        return Status::kTimeout;
+    }
+    ++stats_.fallback_reads;
+    if (applied_index) {
+        *applied_index = applied_index_;
+    }
+    return Status::kOk;
+}
+
+int64_t FollowerRead::StalenessMs() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!has_fresh_) {
+        return -1;
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - fresh_at_).count();
+}
+
+uint64_t FollowerRead::AppliedIndex() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return applied_index_;
+}
+
+FollowerReadStats FollowerRead::GetStats() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return stats_;
+}
+
+} // namespace raft
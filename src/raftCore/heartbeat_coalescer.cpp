@@ -0,0 +1,46 @@
+#include "heartbeat_coalescer.h"
+
+#include <utility>
+
+namespace raft {
+
+HeartbeatCoalescer::HeartbeatCoalescer(Sender sender) : sender_(std::move(sender)) {}
+
+void HeartbeatCoalescer::Enqueue(int32_t peer, const GroupHeartbeatInfo& hb) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    PeerBatch& batch = pending_[peer];
+    auto slot = batch.slot.find(hb.group_id);
+    if (slot != batch.slot.end()) {
+        batch.heartbeats[slot->second] = hb;
+        return;
+    }
+    batch.slot.emplace(hb.group_id, batch.heartbeats.size());
+    batch.heartbeats.push_back(hb);
+    ++stats_.heartbeats;
+}
+
+size_t HeartbeatCoalescer::Flush() {
+    std::unordered_map<int32_t, PeerBatch> batches;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        batches.swap(pending_);
+    }
+    size_t rpcs = 0;
+    for (auto& kv : batches) {
+        if (kv.second.heartbeats.empty()) {
+            continue;
+        }
+        sender_(kv.first, kv.second.heartbeats);
+        ++rpcs;
+    }
+    std::lock_guard<std::mutex> lock(mtx_);
+    stats_.rpcs += rpcs;
+    return rpcs;
+}
+
+HeartbeatCoalescerStats HeartbeatCoalescer::GetStats() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return stats_;
+}
+
+} // namespace raft
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "config.h"
+
+namespace raft {
+
+/**
+ * @brief 一条已提交、待 apply 的日志
+ */
+struct ApplyEntry {
+    uint64_t index = 0;
+    uint64_t term = 0;
+    std::string command;  // opCodec 编码的 Op / OpBatch，状态机用 DecodeOpView 零拷贝解码
+    uint64_t trace_id = 0;  // LogEntry.traceId / spanId：非 0 时记录 raft.apply span
+    uint64_t span_id = 0;
+};
+
+/**
+ * @brief 状态机对一条日志的执行结果，code 的含义由状态机定义 (例如 OK / ERR_KEY_NOT_FOUND)
+ */
+struct ApplyResult {
+    int32_t code = 0;
+    std::string value;
+    std::vector<ApplyResult> ops;  // OpGroup 日志 (ProposalBatcher 合并的提交)：与子命令一一对应的结果
+};
+
+// ========== apply 流水线需要的外部操作 (由 Raft 核心 / KV 状态机实现) ==========
+class ApplySource {
+public:
+    virtual ~ApplySource() = default;
+
+    /**
+     * @brief 从 from 开始连续复制已提交日志到 out (resize 为复制的条数)，条数不超过 max_entries 且不超过 to，
+     *        累计 command 字节数超过 max_bytes 时停止 (至少一条)，返回复制的条数
+     * @details 在 apply 线程中调用。out 在批与批之间复用：实现方对已有元素 assign 而不是重新构造，
+     * command 的内存不必每批重新分配。from 已被快照压缩时返回 0，流水线等待 InstallSnapshot。
+     * trace_id / span_id 同样要赋值 (未采样的日志为 0)，否则复用的元素会带着上一批的追踪信息。
+     */
+    virtual size_t CopyCommitted(uint64_t from, uint64_t to, size_t max_entries, size_t max_bytes,
+                                 std::vector<ApplyEntry>* out) = 0;
+};
+
+class ApplyStateMachine {
+public:
+    virtual ~ApplyStateMachine() = default;
+
+    /**
+     * @brief 按顺序 apply 一批日志，results 与 entries 一一对应 (已按 entries.size() 调整好大小)
+     * @details 在 apply 线程中调用。实现方应当在一次 SkipList 写锁内执行整批 (apply_batch)，
+     * 幂等检查 (DedupTable) 也在这里做。
+     */
+    virtual void ApplyBatch(const std::vector<ApplyEntry>& entries, std::vector<ApplyResult>* results) = 0;
+};
+
+struct ApplyConfig {
+    size_t max_batch_entries = APPLY_BATCH_MAX_ENTRIES;
+    size_t max_batch_bytes = APPLY_BATCH_MAX_BYTES;
+};
+
+struct ApplyStats {
+    uint64_t batches = 0;
+    uint64_t entries = 0;
+    uint64_t max_batch = 0;         // 单批最多的条数
+    uint64_t completed = 0;         // 回调过的等待者
+    uint64_t lost = 0;              // 其中因为日志被新领导人或快照覆盖而失败的
+};
+
+/**
+ * @brief commit -> apply 流水线
+ * @details
+ * 取代按 ApplyInterval 轮询的 apply 循环：
+ * 1. 唤醒：OnCommit 只记下新的 commit_index 并唤醒 apply 线程，不做任何 apply，
+ *    follower 的 AppendEntries 处理因此立刻返回，apply 与下一批日志的接收重叠进行；
+ * 2. 批量：apply 线程一次取出 (applied, commit] 中最多 max_batch_entries 条，交给状态机在
+ *    一次调用 (一次写锁) 里执行；apply 慢于提交时批次自然变大，积压越多单条成本越低；
+ * 3. 批量完成：客户端 RPC 在提交 Op 后用 Wait(index, term, cb) 登记，一批 apply 完之后在 apply
+ *    线程中一次性回调这批日志上的所有等待者 (不持有任何锁)。同一位置的日志任期与登记时不同，
+ *    说明它被新领导人覆盖，回调 kLost，由客户端重试 (DedupTable 保证重试不会重复执行)。
+ *
+ * 回调在 apply 线程中执行，应当只做唤醒协程 / 投递 RPC 回复这类轻量操作。
+ */
+class ApplyPipeline {
+public:
+    enum class Status {
+        kApplied,   // result 为状态机的执行结果
+        kLost,      // 该位置的日志不是登记时的那一条 (领导人变更)，或被快照覆盖、结果未知
+        kShutdown,  // 流水线停止
+    };
+    using WaitCallback = std::function<void(Status status, const ApplyResult& result)>;
+    using AppliedCallback = std::function<void(uint64_t applied_index)>;
+
+    ApplyPipeline(ApplySource* source, ApplyStateMachine* machine, const ApplyConfig& config = ApplyConfig());
+    ~ApplyPipeline();
+
+    ApplyPipeline(const ApplyPipeline&) = delete;
+    ApplyPipeline& operator=(const ApplyPipeline&) = delete;
+
+    // 每批 apply 完成后 (等待者回调之前)、InstallSnapshot 完成后调用，例如 ReadIndex::OnApplied；
+    // 快照与 apply 线程的回调可能乱序到达，使用方忽略不前进的 applied_index
+    void SetAppliedCallback(AppliedCallback cb) { on_applied_ = std::move(cb); }
+
+    /**
+     * @brief 启动 apply 线程，applied_index 为状态机当前已包含的最后一条日志 (快照的 last_included_index)
+     */
+    void Start(uint64_t applied_index);
+
+    /**
+     * @brief 停止 apply 线程 (正在执行的一批会先完成)，所有未完成的等待者回调 kShutdown
+     */
+    void Stop();
+
+    /**
+     * @brief commit_index 推进后调用 (可持有 Raft 核心的锁)；不阻塞，只唤醒 apply 线程
+     */
+    void OnCommit(uint64_t commit_index);
+
+    /**
+     * @brief 登记一个等待 index 处日志 apply 完成的客户端请求
+     * @details index 已经 apply 过时：任期无从核对，回调 kLost 由客户端重试 (在 Start 之后应当不会发生，
+     * 因为 Wait 在日志追加之后、提交之前调用)。
+     */
+    void Wait(uint64_t index, uint64_t term, WaitCallback cb);
+
+    /**
+     * @brief 安装快照 (包含到 last_included_index)：等正在执行的一批结束后在 apply 线程之外调用 install
+     *        (把快照装进状态机)，之后从 last_included_index + 1 继续 apply；被快照覆盖的等待者回调 kLost
+     * @return 快照不比已 apply 的位置新时不调用 install，返回 false
+     */
+    bool InstallSnapshot(uint64_t last_included_index, const std::function<void()>& install);
+
+    uint64_t AppliedIndex() const;
+    ApplyStats Stats() const;
+
+private:
+    struct Waiter {
+        uint64_t term;
+        WaitCallback cb;
+    };
+    struct Completion {
+        Status status;
+        size_t entry;  // 本批中的下标 (kApplied 时有效)
+        WaitCallback cb;
+    };
+    using WaiterMap = std::multimap<uint64_t, Waiter>;
+
+    void ApplyLoop();
+    static void CompleteAll(WaiterMap& waiters, Status status);
+
+    ApplySource* source_;
+    ApplyStateMachine* machine_;
+    ApplyConfig config_;
+    AppliedCallback on_applied_;
+
+    // 锁顺序：apply_mtx_ -> mtx_。apply_mtx_ 在状态机执行一批期间持有，与 InstallSnapshot 互斥；
+    // mtx_ 只保护下面的索引和等待者，apply 期间不持有，OnCommit / Wait 不会被一批 apply 挡住
+    std::mutex apply_mtx_;
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    std::thread applier_;
+    bool running_ = false;
+    uint64_t commit_index_ = 0;
+    uint64_t applied_index_ = 0;
+    uint64_t stalled_at_ = 0;  // 该位置的日志已被压缩，等待 InstallSnapshot
+    WaiterMap waiters_;        // index -> 等待者
+    ApplyStats stats_;
+};
+
+}  // namespace raft
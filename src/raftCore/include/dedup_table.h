@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "opCodec.h"
+
+namespace raft {
+
+/**
+ * @brief ClientId -> 64 位客户端 key
+ * @details 纯数字的 ClientId (opCodec 按整数编码的那种) 直接取数值；其他字符串用固定的 64 位哈希
+ * (FNV-1a + fmix64，不依赖 std::hash 的实现，所有副本、所有版本的结果相同)。
+ * 字符串 id 与其他 id 碰撞的概率约 n^2 / 2^65，一百万个客户端约 3e-8。
+ */
+uint64_t DedupClientKey(std::string_view client_id);
+uint64_t DedupClientKey(const OpView& op);
+
+struct DedupOptions {
+    // 会话闲置超过多少个 tick 即过期，0 表示永不过期。tick 由 apply 路径传入，
+    // 必须是所有副本一致的逻辑时钟 (applied index，或 leader 写进日志的时间戳)，不能用本地时钟
+    uint64_t session_ttl = 0;
+    size_t initial_capacity = 1024;  // 槽位数，向上取 2 的幂
+};
+
+/**
+ * @brief 按客户端记录最大已执行 RequestId 的幂等表 (apply 状态机的一部分)
+ * @details
+ * 1. 开放寻址 + 线性探测，每个槽 24 字节 (client | request_id | last_tick)，没有指针和字符串：
+ *    一次检查平均落在一条 cache line 里，一百万个客户端约 48MB (2^21 个槽)，而 map<string, int> 每个
+ *    客户端要一个树节点加一个 string。删除用 backward-shift，不留墓碑。
+ * 2. 过期在访问时判定：闲置超过 session_ttl 的会话对 Check / LastRequest 来说等同于不存在。
+ *    因此过期会话何时被 Sweep 物理回收 (各副本时机不同) 不影响任何结果，apply 仍然是确定性的。
+ *    装载率到 3/4 时先回收过期会话，仍然偏满才扩容；Sweep 之后表过空会缩容。
+ * 3. Encode 按 client 升序输出 (各副本字节相同)，只包含未过期的会话，与 SkipList 快照一起保存。
+ *
+ * 只由 apply 线程访问，不加锁。
+ */
+class DedupTable {
+public:
+    enum class Result {
+        kNew,        // 首次出现的请求：已记录，调用方执行
+        kDuplicate,  // request_id 不大于该客户端已执行过的最大值：调用方直接返回上次的结果
+    };
+
+    explicit DedupTable(DedupOptions options = DedupOptions());
+
+    /**
+     * @brief apply 路径的幂等检查，均摊 O(1)
+     * @param tick 当前日志条目的逻辑时钟，单调不减
+     */
+    Result Check(uint64_t client, int64_t request_id, uint64_t tick);
+
+    // 该客户端已执行过的最大 request_id；会话不存在或已过期返回 false
+    bool LastRequest(uint64_t client, uint64_t tick, int64_t* request_id) const;
+
+    /**
+     * @brief 回收过期会话，最多检查 max_slots 个槽 (从上次停下的位置继续)，返回回收的会话数
+     * @details 只影响内存，不影响语义；apply 线程空闲时或每条日志顺带调用少量即可
+     */
+    size_t Sweep(uint64_t tick, size_t max_slots);
+
+    size_t Size() const { return size_; }  // 含尚未回收的过期会话
+    size_t Capacity() const { return capacity_; }
+    size_t MemoryBytes() const { return capacity_ * sizeof(Slot); }
+    void Clear();
+
+    /**
+     * @brief 快照编码：magic u8 | tick varint | count varint | 按 client 升序的
+     *        (client 差值 varint | request_id zigzag varint | 闲置 tick 数 varint) | crc32c u32
+     */
+    std::string Encode(uint64_t tick) const;
+    bool Decode(std::string_view data, std::string* error = nullptr);
+
+private:
+    struct Slot {
+        uint64_t client;  // 0 = 空槽 (真实的 0 号客户端映射为 kZeroClient)
+        int64_t request_id;
+        uint64_t last_tick;
+    };
+
+    static constexpr uint64_t kZeroClient = 0x9E3779B97F4A7C15ull;  // 超出 19 位十进制，数字 id 不会撞上
+
+    static uint64_t StoredKey(uint64_t client) { return client == 0 ? kZeroClient : client; }
+    static uint64_t UserKey(uint64_t stored) { return stored == kZeroClient ? 0 : stored; }
+    size_t Home(uint64_t stored) const;
+    bool Expired(const Slot& slot, uint64_t tick) const;
+    size_t Find(uint64_t stored) const;  // 找不到返回 capacity_
+    void EraseAt(size_t pos);
+    void InsertNew(uint64_t stored, int64_t request_id, uint64_t last_tick);
+    void Rehash(size_t capacity);
+    void MaybeGrow(uint64_t tick);
+
+    DedupOptions options_;
+    size_t min_capacity_;
+    size_t capacity_;
+    size_t mask_;
+    size_t size_ = 0;
+    size_t sweep_cursor_ = 0;
+    std::unique_ptr<Slot[]> slots_;
+};
+
+}  // namespace raft
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "config.h"
+
+namespace raft {
+
+struct ElectionConfig {
+    bool pre_vote = RAFT_PRE_VOTE;
+    bool check_quorum = RAFT_CHECK_QUORUM;
+    int election_timeout_min_ms = minRandomizedElectionTime;
+    int transfer_timeout_ms = RAFT_TRANSFER_TIMEOUT_MS;
+};
+
+struct LogPosition {
+    uint64_t last_index = 0;
+    uint64_t last_term = 0;
+};
+
+/**
+ * @brief 候选人的日志是否至少和本地一样新 (Raft 论文 5.4.1)
+ */
+inline bool LogUpToDate(const LogPosition& candidate, const LogPosition& local) {
+    return candidate.last_term > local.last_term ||
+           (candidate.last_term == local.last_term && candidate.last_index >= local.last_index);
+}
+
+/**
+ * @brief 一次 (预) 投票请求，对应 RequestVoteArgs
+ */
+struct VoteRequest {
+    uint64_t term = 0;           // 预投票时是候选人 "将要使用" 的任期 (它的当前任期 + 1)，候选人自己并不递增
+    int32_t candidate_id = -1;
+    LogPosition log;
+    bool pre_vote = false;
+    bool transfer = false;       // 由 TimeoutNow 触发的选举：现任领导人主动让位，投票方不再坚持 stickiness
+};
+
+struct VoteDecision {
+    bool grant = false;
+    bool update_term = false;    // 投票方应先把任期更新为 request.term 并转为 follower (预投票永远为 false)
+};
+
+/**
+ * @brief 选举相关的状态与决策：PreVote、CheckQuorum (含 leader stickiness)、领导权转移
+ * @details
+ * PreVote (论文 9.6)：候选人先用 "当前任期 + 1" 问一轮，不递增自己的任期，只有多数派表示
+ * 会投票时才真正发起选举。被分区的节点反复超时也只会不断失败地预投票，回到集群时任期没有变大，
+ * 不会逼现任领导人退位。
+ *
+ * CheckQuorum：
+ * - 领导人：一个最小选举超时内没有收到多数派 (含自己) 的任何回复，就主动退位，
+ *   被分区的旧领导人不会继续接受 (永远提交不了的) 写请求；
+ * - follower：最近一个最小选举超时内联系过领导人时，拒绝 (预) 投票且不更新任期 (leader stickiness)。
+ *   这也是 ReadIndex 租约读成立的前提。
+ *
+ * 领导权转移 (论文 3.10)：领导人停止接受新的写提议，把目标的日志补齐，然后发 TimeoutNow；
+ * 目标收到后立即以 transfer 标记发起正式选举 (跳过预投票和 stickiness)，一个 RTT 内完成切换，
+ * 不用等一个完整的选举超时。超过 transfer_timeout_ms 未完成则放弃，领导人恢复接受写。
+ *
+ * 不加锁：所有方法都由 Raft 核心在持有自己的锁时调用。
+ */
+class ElectionControl {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class TransferStatus {
+        kStarted,        // 已开始 (或目标已追上，TimeoutNow 随即发出)
+        kInProgress,     // 同一目标的转移已在进行
+        kAlreadyLeader,  // 目标就是自己
+        kUnknownTarget,  // 目标不是本组成员 / 没有合适的目标
+        kNotLeader,
+    };
+
+    /**
+     * @param peers 组内其他成员 (不含自己)
+     */
+    ElectionControl(int32_t self, std::vector<int32_t> peers, const ElectionConfig& config = ElectionConfig());
+
+    // ========== follower / candidate ==========
+
+    /**
+     * @brief 收到当前任期领导人的 AppendEntries / 合并心跳 / 快照
+     */
+    void OnLeaderContact(int32_t leader, Clock::time_point now = Clock::now());
+
+    /**
+     * @brief 最近一个最小选举超时内联系过领导人 (领导人自己在退位前始终为 true)
+     */
+    bool LeaderAlive(Clock::time_point now = Clock::now()) const;
+
+    int32_t KnownLeader() const { return leader_; }
+
+    /**
+     * @brief 处理 (预) 投票请求
+     * @param voted_for 本任期已投给谁，-1 表示还没投
+     */
+    VoteDecision HandleVote(const VoteRequest& request, uint64_t current_term, int32_t voted_for,
+                            const LogPosition& local, Clock::time_point now = Clock::now()) const;
+
+    /**
+     * @brief 选举超时后候选人是否先做预投票 (TimeoutNow 触发的选举直接进入正式选举)
+     */
+    bool UsePreVote(bool transfer) const { return config_.pre_vote && !transfer; }
+
+    /**
+     * @brief 收到 TimeoutNow：来自本任期的已知领导人时立即发起选举
+     */
+    bool AcceptTimeoutNow(uint64_t request_term, int32_t from, uint64_t current_term) const;
+
+    size_t QuorumSize() const { return (peers_.size() + 1) / 2 + 1; }
+
+    // ========== leader ==========
+
+    void BecomeLeader(Clock::time_point now = Clock::now());
+
+    /**
+     * @brief 退位 / 看到更高任期：清空领导人状态与进行中的转移
+     */
+    void StepDown();
+
+    /**
+     * @brief 收到 peer 的本任期回复 (无论 success 与否)，用于 CheckQuorum
+     */
+    void OnPeerAck(int32_t peer, Clock::time_point now = Clock::now());
+
+    /**
+     * @brief 多数派在最近一个最小选举超时内回复过；返回 false 时领导人应退位
+     * @details 由领导人的定时器每个选举超时检查一次；check_quorum 关闭时恒为 true
+     */
+    bool QuorumActive(Clock::time_point now = Clock::now()) const;
+
+    /**
+     * @brief 开始把领导权转给 target
+     * @param target_match 目标当前的 matchIndex
+     * @param last_index 领导人最后一条日志的 index
+     * @param send_timeout_now [输出] 目标已追上，调用方应立即向它发送 TimeoutNow
+     */
+    TransferStatus BeginTransfer(int32_t target, uint64_t target_match, uint64_t last_index, bool* send_timeout_now,
+                                 Clock::time_point now = Clock::now());
+
+    /**
+     * @brief peer 的 matchIndex 推进后调用；返回 true 时调用方应向它发送 TimeoutNow (每次转移只返回一次)
+     */
+    bool OnMatchAdvanced(int32_t peer, uint64_t match, uint64_t last_index);
+
+    /**
+     * @brief 转移是否在进行中；进行中领导人拒绝新的写提议 (超时后自动放弃并返回 false)
+     */
+    bool Transferring(Clock::time_point now = Clock::now());
+
+    int32_t TransferTarget() const { return transfer_target_; }
+
+    /**
+     * @brief TransferLeadership 未指定目标时的选择：最近回复过的 peer 中 matchIndex 最大的，相同时取 id 小的
+     * @return 没有合适的 peer 时返回 -1
+     */
+    int32_t PickTransferTarget(const std::unordered_map<int32_t, uint64_t>& match_index,
+                               Clock::time_point now = Clock::now()) const;
+
+private:
+    bool IsPeer(int32_t node) const;
+    bool Recent(Clock::time_point t, Clock::time_point now) const { return now - t < election_timeout_; }
+
+    int32_t self_;
+    std::vector<int32_t> peers_;
+    ElectionConfig config_;
+    Clock::duration election_timeout_;
+
+    // follower 视角
+    int32_t leader_ = -1;
+    Clock::time_point leader_contact_;
+
+    // 领导人视角
+    bool is_leader_ = false;
+    std::unordered_map<int32_t, Clock::time_point> last_ack_;
+
+    int32_t transfer_target_ = -1;
+    Clock::time_point transfer_deadline_;
+    bool timeout_now_sent_ = false;
+};
+
+} // namespace raft
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+#include "config.h"
+
+namespace raft {
+
+/**
+ * @brief 单次 follower 读的约束 (对应 kv.proto 的 ReadOptions)
+ */
+struct FollowerReadOptions {
+    uint64_t min_applied_index = 0;  // 本地 apply 必须达到的 index (read-your-writes：客户端上次写返回的 index)
+    int max_staleness_ms = 0;        // 允许落后领导人多久，0 表示不限制
+};
+
+struct FollowerReadConfig {
+    int catch_up_wait_ms = HeartBeatTimeout * 2;  // 本地不满足约束时，先等这么久 (通常等到下一个心跳) 再回退到 ReadIndex
+    size_t max_contacts = 1024;                   // 记录的领导人心跳条数上限
+};
+
+struct FollowerReadStats {
+    uint64_t local_reads = 0;     // 直接由本地满足约束
+    uint64_t fallback_reads = 0;  // 回退到领导人的 ReadIndex 之后满足
+};
+
+/**
+ * @brief follower 本地读的有界陈旧度判定
+ * @details
+ * 1. 陈旧度：follower 在 t 时刻收到领导人的 AppendEntries (含心跳)，其中 leaderCommit = c；
+ *    一旦本地 applied >= c，本地状态至少包含了领导人在发出这条消息之前确认过的全部写，
+ *    于是 "陈旧度 <= now - t" (另加一次单程网络延迟)。按到达顺序记录 (c, t)，apply 推进时
+ *    弹出所有 c <= applied 的记录，最后一条的 t 即为 fresh_at。
+ * 2. 本地满足 min_applied_index 与 max_staleness_ms 时直接读本地 SkipList；
+ *    否则等待 catch_up_wait_ms，仍不满足就向领导人要 read index (ReadIndex RPC)，
+ *    等本地 apply 到该位置后读本地 —— 这时的读是线性一致的，自然满足两个约束。
+ *
+ * Raft 核心的调用约定：OnLeaderContact 在处理完当前领导人的 AppendEntries 之后调用；
+ * OnApplied 在 apply 之后调用；任期变化 / 开始选举时调用 OnLeaderLost (陈旧度无从判断)。
+ */
+class FollowerRead {
+public:
+    enum class Status {
+        kOk,
+        kTimeout,      // 约束未满足且回退失败 / 超时
+    };
+
+    /**
+     * @brief 向领导人要一个已确认领导权的 read index，失败返回 false (可能在任意读线程中调用)
+     */
+    using ReadIndexFetcher = std::function<bool(int timeout_ms, uint64_t* read_index)>;
+
+    explicit FollowerRead(ReadIndexFetcher fetcher, const FollowerReadConfig& config = FollowerReadConfig());
+
+    FollowerRead(const FollowerRead&) = delete;
+    FollowerRead& operator=(const FollowerRead&) = delete;
+
+    // ========== Raft 核心调用 ==========
+
+    void OnLeaderContact(uint64_t leader_commit,
+                         std::chrono::steady_clock::time_point received_at = std::chrono::steady_clock::now());
+    void OnApplied(uint64_t applied_index);
+    void OnLeaderLost();
+
+    // ========== 读请求调用 ==========
+
+    /**
+     * @brief 阻塞直到本地状态满足 options，之后调用方直接读本地存储
+     * @param applied_index 非空时返回满足约束时的本地 applied index (回给客户端，用作下一次的 min_applied_index)
+     */
+    Status WaitReadable(const FollowerReadOptions& options, int timeout_ms = CONSENSUS_TIMEOUT,
+                        uint64_t* applied_index = nullptr);
+
+    /**
+     * @brief 当前本地状态的陈旧度，无法判断时返回 -1
+     */
+    int64_t StalenessMs() const;
+
+    uint64_t AppliedIndex() const;
+    FollowerReadStats GetStats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    bool SatisfiedLocked(const FollowerReadOptions& options, Clock::time_point now) const;
+
+    ReadIndexFetcher fetcher_;
+    FollowerReadConfig config_;
+
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    uint64_t applied_index_ = 0;
+    std::deque<std::pair<uint64_t, Clock::time_point>> contacts_;  // (leaderCommit, 到达时刻)，尚未被 apply 覆盖
+    bool has_fresh_ = false;
+    Clock::time_point fresh_at_;
+
+    FollowerReadStats stats_;
+};
+
+} // namespace raft
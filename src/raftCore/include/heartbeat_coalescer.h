@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace raft {
+
+/**
+ * @brief 合并心跳中的一项 (对应 raft.proto 的 GroupHeartbeat)
+ */
+struct GroupHeartbeatInfo {
+    uint64_t group_id = 0;
+    uint64_t term = 0;
+    int32_t leader_id = 0;
+    // 必须是 min(leaderCommit, 该 follower 的 matchIndex)：
+    // 合并心跳不带 prevLogIndex / prevLogTerm，follower 无法校验日志一致性，
+    // 只能推进到领导人确认过它已经拥有的位置
+    uint64_t commit = 0;
+};
+
+struct HeartbeatCoalescerStats {
+    uint64_t heartbeats = 0;  // Enqueue 的组心跳个数 (去重之后)
+    uint64_t rpcs = 0;        // 实际发出的 NodeHeartbeat 个数
+};
+
+/**
+ * @brief Multi-Raft 心跳合并
+ * @details
+ * 一个节点上的 N 个组如果各自按 HeartBeatTimeout 向每个 follower 发心跳，
+ * 节点对之间每个周期就有 N 个 RPC；而心跳只携带任期和提交位置，完全可以合并。
+ * 各组在自己的心跳 tick 里调用 Enqueue 代替直接发 AppendEntries 心跳，
+ * 节点级定时器每个 HeartBeatTimeout 调用一次 Flush，每个对端节点只发一个 NodeHeartbeat。
+ * 带日志的 AppendEntries 不受影响，仍由各组直接发送。
+ *
+ * 同一周期内同一组对同一对端多次 Enqueue，只保留最后一次 (term / commit 只增不减)。
+ */
+class HeartbeatCoalescer {
+public:
+    /**
+     * @brief 把一个对端节点的一批心跳发出去 (通常是 RaftRpcClient::AsyncNodeHeartbeat)
+     */
+    using Sender = std::function<void(int32_t peer, std::vector<GroupHeartbeatInfo>& batch)>;
+
+    explicit HeartbeatCoalescer(Sender sender);
+
+    HeartbeatCoalescer(const HeartbeatCoalescer&) = delete;
+    HeartbeatCoalescer& operator=(const HeartbeatCoalescer&) = delete;
+
+    void Enqueue(int32_t peer, const GroupHeartbeatInfo& hb);
+
+    /**
+     * @brief 把当前周期积攒的心跳按对端节点各发一个 RPC
+     * @return 发出的 RPC 个数
+     * @details Sender 在锁外调用，期间新的 Enqueue 进入下一个周期
+     */
+    size_t Flush();
+
+    HeartbeatCoalescerStats GetStats() const;
+
+private:
+    struct PeerBatch {
+        std::vector<GroupHeartbeatInfo> heartbeats;
+        std::unordered_map<uint64_t, size_t> slot;  // group_id -> heartbeats 中的下标
+    };
+
+    Sender sender_;
+
+    mutable std::mutex mtx_;
+    std::unordered_map<int32_t, PeerBatch> pending_;
+    HeartbeatCoalescerStats stats_;
+};
+
+} // namespace raft
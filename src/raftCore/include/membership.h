@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "config.h"
+
+namespace raft {
+
+/**
+ * @brief 一个 Raft 组的成员配置
+ * @details voters 与 outgoing 都非空时处于 joint consensus (C_old,new)：选举、提交、CheckQuorum
+ * 都要求两组各自过半。learners 接收日志流、可以做 follower 读，但不投票、不计入任何多数派。
+ */
+struct MembershipConfig {
+    std::vector<int32_t> voters;    // 升序、去重
+    std::vector<int32_t> outgoing;  // joint 期间的旧投票成员，否则为空
+    std::vector<int32_t> learners;  // 升序、去重，与 voters / outgoing 不相交
+
+    bool Joint() const { return !outgoing.empty(); }
+    bool IsVoter(int32_t node) const;  // voters 或 outgoing 之一
+    bool IsLearner(int32_t node) const;
+    bool Contains(int32_t node) const { return IsVoter(node) || IsLearner(node); }
+
+    // 领导人需要复制日志的所有成员 (含 learner)
+    std::vector<int32_t> Replicas() const;
+
+    bool operator==(const MembershipConfig& other) const {
+        return voters == other.voters && outgoing == other.outgoing && learners == other.learners;
+    }
+};
+
+/**
+ * @brief 配置日志的编码 (LogEntry.command)：kMembershipMagic u8 | 三组 (count varint | id varint...)
+ * @details 首字节与 opCodec 的 Op / OpBatch / OpGroup 区分，状态机 apply 时跳过这种条目
+ */
+std::string EncodeMembership(const MembershipConfig& config);
+bool DecodeMembership(std::string_view data, MembershipConfig* config, std::string* error = nullptr);
+bool IsMembershipEntry(std::string_view data);
+
+enum class MemberChangeType {
+    kAddLearner,  // 加入为 learner：开始接收日志，不影响提交延迟
+    kPromote,     // learner -> voter，要求已追上领导人
+    kRemove,      // 移除 voter 或 learner
+};
+
+struct MemberChange {
+    MemberChangeType type;
+    int32_t node;
+};
+
+struct MembershipOptions {
+    uint64_t catch_up_entries = RAFT_LEARNER_CATCHUP_ENTRIES;  // learner 的 matchIndex 落后不超过该条数才可提升
+};
+
+/**
+ * @brief 成员变更：learner、单步变更与 joint consensus (Raft 论文第 4 章)
+ * @details
+ * 1. 配置在追加进本地日志时立即生效 (不等提交)，日志被截断时回退到之前的配置，
+ *    因此 follower 收到的配置日志也要调用 OnAppend / OnTruncate；
+ * 2. 同一时刻最多一个未提交的配置变更 (含 joint 期间)，否则 Prepare 返回 kPending；
+ *    新领导人在本任期提交第一条日志 (当选后的 no-op) 之前也返回 kPending：否则上一任期未提交的
+ *    单步变更与本任期的单步变更叠加，两步之后的新旧多数派可能不相交 (Ongaro 2015 对单步变更的勘误)；
+ * 3. 一次变更只增减一个 voter 时走单步变更 (新旧多数派必然相交)；增减多个 voter 时先进入
+ *    C_old,new，joint 配置提交后 OnCommit 返回 true，领导人随即提议 LeaveJoint() 得到 C_new；
+ * 4. 新节点先以 learner 加入：它追日志 / 装快照期间不计入多数派，提交延迟不受影响；
+ *    matchIndex 追到 catch_up_entries 以内才允许 kPromote，提升后不会因为它拖慢提交或失去可用性；
+ * 5. 领导人不在已提交配置的 voters 中 (自己被移除) 时，ShouldStepDown 为 true。
+ *
+ * 不加锁：所有方法都由 Raft 核心在持有自己的锁时调用。
+ */
+class Membership {
+public:
+    enum class ChangeStatus {
+        kOk,
+        kPending,      // 还有未提交的配置变更 / 处于 joint / 本任期还没有提交过日志
+        kInvalid,      // 变更本身不合法 (见 error)
+        kNotCaughtUp,  // 要提升的 learner 还没追上
+    };
+
+    using MatchLookup = std::function<uint64_t(int32_t node)>;  // 领导人自己返回 last_index
+    using AckLookup = std::function<bool(int32_t node)>;
+
+    explicit Membership(MembershipConfig initial, const MembershipOptions& options = MembershipOptions());
+
+    const MembershipConfig& Current() const { return history_.back().second; }
+    uint64_t CurrentIndex() const { return history_.back().first; }
+    const MembershipConfig& Committed() const;
+    bool ChangePending() const { return CurrentIndex() > commit_index_; }
+
+    // ========== 领导人 ==========
+
+    /**
+     * @brief 校验一组变更并生成下一个配置 (调用方把 EncodeMembership(*next) 作为一条日志提议)
+     * @param last_index 领导人最后一条日志的 index，用于判断 learner 是否追上
+     * @param leader_term_committed 领导人已在当前任期提交过日志 (即 ReadIndex::TermCommitted())
+     */
+    ChangeStatus Prepare(const std::vector<MemberChange>& changes, const MatchLookup& match, uint64_t last_index,
+                         bool leader_term_committed, MembershipConfig* next, std::string* error = nullptr) const;
+
+    // 当前 joint 配置对应的 C_new
+    MembershipConfig LeaveJoint() const;
+
+    bool CaughtUp(uint64_t match, uint64_t last_index) const {
+        return match + options_.catch_up_entries >= last_index;
+    }
+
+    // ========== 所有节点 ==========
+
+    /**
+     * @brief 配置日志追加进本地日志 (领导人提议时、follower 收到时)，立即生效
+     */
+    void OnAppend(uint64_t index, const MembershipConfig& config);
+
+    /**
+     * @brief 本地日志 last_kept_index 之后的部分被截断：回退之后追加的配置
+     */
+    void OnTruncate(uint64_t last_kept_index);
+
+    /**
+     * @brief commit_index 推进
+     * @return joint 配置刚好是最新配置且已提交：领导人应立即提议 LeaveJoint()
+     */
+    bool OnCommit(uint64_t commit_index);
+
+    /**
+     * @brief 安装快照 / 重启时从快照元数据恢复：index 处的配置已提交
+     */
+    void Restore(uint64_t index, const MembershipConfig& config);
+
+    // ========== 多数派 ==========
+
+    /**
+     * @brief 投票、CheckQuorum、ReadIndex 确认：joint 期间新旧两组都要过半，learner 不计
+     */
+    bool HasQuorum(const AckLookup& acked) const;
+
+    /**
+     * @brief 领导人可提交的位置：voters matchIndex 的多数派位置 (joint 取两组中较小者)
+     */
+    uint64_t QuorumMatch(const MatchLookup& match) const;
+
+    // 只有 voter 会在选举超时后发起选举
+    bool CanCampaign(int32_t self) const { return Current().IsVoter(self); }
+    bool ShouldStepDown(int32_t self) const { return !Committed().IsVoter(self); }
+
+private:
+    MembershipOptions options_;
+    // front 是最近一个已提交的配置，其后是按 index 递增的未提交配置
+    std::vector<std::pair<uint64_t, MembershipConfig>> history_;
+    uint64_t commit_index_ = 0;
+};
+
+}  // namespace raft
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "config.h"
+#include "range_table.h"
+
+namespace raft {
+
+/**
+ * @brief 一个节点上一个副本的负载 (由该节点周期性上报)
+ */
+struct GroupLoad {
+    uint64_t group_id = 0;
+    bool leader = false;   // 本节点是否是该组的领导人 (读写都由领导人承担)
+    double qps = 0;        // RangeLoadTracker::Snapshot::Qps，只有领导人的值有意义
+    uint64_t bytes = 0;    // 副本数据量
+};
+
+/**
+ * @brief 节点负载报告，写入 ZooKeeper 的 /kv/load/<node_id> (临时节点，节点下线自动消失)
+ */
+struct NodeLoadReport {
+    int32_t node_id = 0;
+    std::vector<GroupLoad> groups;
+};
+
+std::string EncodeNodeLoadReport(const NodeLoadReport& report);
+bool DecodeNodeLoadReport(std::string_view data, NodeLoadReport* report);
+
+/**
+ * @brief 调度指令，写入 ZooKeeper 的 /kv/moves/<group_id>，由该组领导人执行后删除
+ */
+struct PlacementMove {
+    enum class Type : uint8_t {
+        kTransferLeader = 0,  // 把领导权交给 to_node (已是副本)
+        kMoveReplica = 1,     // 在 to_node 上新增副本 (InstallSnapshotStream 传快照)，追上后移除 from_node
+    };
+    Type type = Type::kTransferLeader;
+    uint64_t group_id = 0;
+    int32_t from_node = 0;
+    int32_t to_node = 0;
+};
+
+std::string EncodePlacementMove(const PlacementMove& move);
+bool DecodePlacementMove(std::string_view data, PlacementMove* move);
+
+struct PlacementConfig {
+    double tolerance = REBALANCE_TOLERANCE;  // 节点负载超过均值 (1 + tolerance) 倍才迁出
+    size_t max_moves = 4;                     // 一轮最多生成的指令数，避免同时搬太多数据
+};
+
+/**
+ * @brief 根据各节点的负载报告生成一轮调度指令 (调度器周期调用，贪心、无状态)
+ * @details
+ * 1. 领导权均衡：按节点上作为领导人的 QPS 之和排序，从最热的节点上挑一个组，
+ *    把领导权交给该组副本中最空闲的节点 —— 只是一次 TransferLeadership，不搬数据，优先使用。
+ * 2. 副本均衡：按节点上的副本总字节数排序，把最满节点上的一个副本迁到不持有该组的最空节点。
+ *    迁移需要传快照，代价高，只在领导权均衡不产生指令时才做。
+ * 每条指令都必须让迁出节点和迁入节点之间的差距变小，否则不生成 (防止来回搬)。
+ * 没有上报的节点视为不可用，不作为迁入目标。
+ * @param ranges 当前所有区间 (用于副本集合)
+ * @param busy_groups 已有未完成指令的组，本轮跳过
+ */
+std::vector<PlacementMove> PlanRebalance(const std::vector<NodeLoadReport>& reports,
+                                         const std::vector<RangeDescriptor>& ranges,
+                                         const std::vector<uint64_t>& busy_groups = {},
+                                         const PlacementConfig& config = PlacementConfig());
+
+} // namespace raft
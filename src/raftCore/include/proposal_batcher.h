@@ -0,0 +1,111 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "apply_pipeline.h"
+#include "config.h"
+#include "trace.h"
+
+namespace raft {
+
+// ========== 合并后的提交交给 Raft 核心 ==========
+class ProposalSink {
+public:
+    virtual ~ProposalSink() = default;
+
+    /**
+     * @brief 把 command 追加为一条日志 (Raft Start)，并在同一把 Raft 锁内登记 done
+     *        (ApplyPipeline::Wait(index, term, done))，保证日志提交之前等待者已经就位
+     * @details 调用期间 Tracer::Current() 是这条日志的追踪上下文 (未采样时为空)，
+     *          Raft 核心把它写进 LogEntry.traceId / spanId，复制与 apply 阶段据此记录 span。
+     * @return 不是领导人时返回 false，done 不会被调用
+     */
+    virtual bool Propose(const std::string& command, ApplyPipeline::WaitCallback done) = 0;
+};
+
+struct ProposalBatcherConfig {
+    size_t max_ops = PROPOSAL_BATCH_MAX_OPS;
+    size_t max_bytes = PROPOSAL_BATCH_MAX_BYTES;
+    int64_t max_linger_us = PROPOSAL_MAX_LINGER_US;
+};
+
+struct ProposalBatcherStats {
+    uint64_t proposals = 0;   // 交给 Raft 的日志条数
+    uint64_t ops = 0;         // 其中包含的客户端命令数
+    uint64_t max_ops = 0;     // 单条日志最多的命令数
+    uint64_t rejected = 0;    // 不是领导人而被拒绝的命令数
+    int64_t linger_us = 0;    // 当前的凑批等待时间
+};
+
+/**
+ * @brief leader 上的提交合并阶段：并发到达的客户端写合并进一条 OpGroup 日志
+ * @details
+ * 1. 单线程 flusher：Propose 期间 (拿 Raft 锁、追加 WAL) 到达的命令自然攒成下一批，
+ *    不设任何定时器也能在高负载下成批；凑不满一批才按 linger 等待；
+ * 2. 自适应 linger：按最近批次大小的指数滑动平均 avg，linger = max_linger * (avg - 1) / avg。
+ *    低负载时每批只有一条，linger 收敛到 0，单个请求不付出任何延迟；负载越高 linger 越接近 max_linger。
+ *    命令数或字节数到上限时立即提交，不等 linger 结束；
+ * 3. 只有一条命令的批原样提交 (不加 OpGroup 框)，状态机不需要区分来源；
+ * 4. 扇出：一条日志 apply 完成后，ApplyResult::ops[i] 回调给第 i 个命令的等待者；
+ *    不是领导人 / 日志丢失时该批所有命令回调同样的状态，客户端各自重试 (由 DedupTable 去重)；
+ * 5. 追踪：Submit 时记下调用线程的 Tracer::Current()。被采样的命令各自记录 raft.batch.wait (排队凑批) 与
+ *    raft.propose (提交到 apply 回调) 两个 span；一条日志只携带批内第一个被采样命令的上下文。
+ */
+class ProposalBatcher {
+public:
+    using Status = ApplyPipeline::Status;
+    using Callback = ApplyPipeline::WaitCallback;
+
+    explicit ProposalBatcher(ProposalSink* sink, const ProposalBatcherConfig& config = ProposalBatcherConfig());
+    ~ProposalBatcher();
+
+    ProposalBatcher(const ProposalBatcher&) = delete;
+    ProposalBatcher& operator=(const ProposalBatcher&) = delete;
+
+    void Start();
+
+    /**
+     * @brief 停止 flusher，尚未提交给 Raft 的命令回调 kShutdown (已提交的由 ApplyPipeline 负责)
+     */
+    void Stop();
+
+    /**
+     * @brief 提交一条客户端命令 (EncodeOp / EncodeOpBatch 的结果)，apply 后以该命令自己的结果回调 cb
+     */
+    void Submit(std::string command, Callback cb);
+
+    ProposalBatcherStats Stats() const;
+
+private:
+    struct Pending {
+        std::string command;
+        Callback cb;
+        TraceContext trace;      // 提交者的追踪上下文，未采样时为空
+        uint64_t submit_ns = 0;  // 仅采样的命令
+    };
+
+    void FlushLoop();
+    void Flush(std::vector<Pending>& batch);
+    bool BatchFullLocked() const { return pending_.size() >= config_.max_ops || pending_bytes_ >= config_.max_bytes; }
+
+    ProposalSink* sink_;
+    ProposalBatcherConfig config_;
+
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    std::thread flusher_;
+    bool running_ = false;
+    std::deque<Pending> pending_;
+    size_t pending_bytes_ = 0;
+    double avg_batch_ = 1.0;  // 批次大小的指数滑动平均，只由 flusher 写
+    ProposalBatcherStats stats_;
+};
+
+}  // namespace raft
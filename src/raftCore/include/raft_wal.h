@@ -0,0 +1,199 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace raft {
+
+/**
+ * @brief WAL 中的一条日志 (字段与 raftRpcProctoc::LogEntry 一一对应)
+ * @details WAL 本身不依赖 protobuf，Raft 核心在收发 RPC 时与 LogEntry 互相转换。
+ * 追踪字段 (LogEntry.traceId / spanId) 只在内存中的日志里保留，不落盘。
+ */
+struct WalEntry {
+    uint64_t term = 0;
+    uint64_t index = 0;
+    std::string command;
+};
+
+/**
+ * @brief 需要持久化的 Raft 状态 (Figure 2 的 currentTerm / votedFor)
+ */
+struct HardState {
+    uint64_t current_term = 0;
+    int32_t voted_for = -1;
+};
+
+struct WalOptions {
+    std::string dir;                          // WAL 目录 (不存在则创建)
+    size_t segment_bytes = 64 * 1024 * 1024;  // 单个段文件的目标大小，写满后滚动到新段
+    bool sync = true;                         // false 时不调用 fdatasync (仅用于测试 / 基准对照)
+};
+
+/**
+ * @brief 段式 Raft 预写日志 (WAL)
+ * @details
+ * 1. 目录布局：wal-<首条 index 20 位十进制>.log 若干个段，只有最后一个段可写；hardstate 保存 term / vote。
+ * 2. 记录格式 (小端)：len u32 | crc32c u32 | term u64 | index u64 | command bytes，
+ *    len = 16 + command 长度，crc 覆盖 term 起的全部字节。
+ * 3. 索引：每个段在内存中保存 "entry -> 文件偏移" 的数组，另存全部 entry 的 term，
+ *    Open 时扫描段文件重建；读日志用 pread，TermAt 不碰磁盘。
+ * 4. 组提交：Append 只把记录写进 page cache 并返回，后台 sync 线程一次 fdatasync 覆盖
+ *    在它开始之前写入的全部记录，WaitDurable 等待对应 index 落盘；并发的多个提案因此共享一次 fdatasync。
+ * 5. 恢复：遇到第一条长度 / CRC / index 不合法的记录 (崩溃时的撕裂写) 就在那里截断，并删除其后的所有段；
+ *    这些记录不可能已被确认落盘 (durable 只在所有相关段都 fdatasync 之后推进)。
+ * 6. fdatasync 失败后 WAL 进入失败状态 (page cache 中的脏页可能已被丢弃，重试不可信)，之后的写入全部返回失败。
+ *
+ * 所有方法线程安全。
+ */
+class RaftWal {
+public:
+    using SyncObserver = std::function<void(std::chrono::microseconds latency, uint64_t synced_entries)>;
+
+    explicit RaftWal(const WalOptions& options);
+    ~RaftWal();
+
+    RaftWal(const RaftWal&) = delete;
+    RaftWal& operator=(const RaftWal&) = delete;
+
+    /**
+     * @brief 打开目录、恢复已有的段与 hardstate，并启动 sync 线程
+     * @return 失败时返回 false，原因写入 error
+     */
+    bool Open(std::string* error = nullptr);
+
+    /**
+     * @brief 等待已写入的日志落盘后停止 sync 线程并关闭文件 (析构时自动调用)
+     */
+    void Close();
+
+    // ========== 日志 ==========
+
+    /**
+     * @brief 追加日志 (只写入 page cache，不等待落盘)
+     * @details entries 的 index 必须从 LastIndex() + 1 起连续递增 (日志为空时可以从任意 index 开始)
+     * @return 最后一条的 index；参数不合法或 WAL 已失败时返回 0
+     */
+    uint64_t Append(const std::vector<WalEntry>& entries);
+
+    /**
+     * @brief 阻塞直到 index 及之前的日志全部落盘
+     * @return WAL 失败 / 已关闭时返回 false
+     */
+    bool WaitDurable(uint64_t index);
+
+    /**
+     * @brief Append + WaitDurable
+     */
+    uint64_t AppendSync(const std::vector<WalEntry>& entries);
+
+    /**
+     * @brief 读取一条日志
+     */
+    bool Read(uint64_t index, WalEntry* out) const;
+
+    /**
+     * @brief 从 from 开始读取日志到 out，条数不超过 max_count，command 累计字节数超过 max_bytes 时停止 (至少一条)
+     * @return 读取的条数
+     */
+    size_t ReadRange(uint64_t from, size_t max_count, size_t max_bytes, std::vector<WalEntry>* out) const;
+
+    /**
+     * @brief index 处日志的 term，不在日志范围内返回 0
+     */
+    uint64_t TermAt(uint64_t index) const;
+
+    uint64_t FirstIndex() const;
+    // 日志为空时为 FirstIndex() - 1
+    uint64_t LastIndex() const;
+    uint64_t DurableIndex() const;
+
+    /**
+     * @brief 冲突截断：删除 index >= from 的全部日志，返回前截断已落盘
+     */
+    bool TruncateSuffix(uint64_t from);
+
+    /**
+     * @brief 快照之后回收空间：删除全部 entry 都 < upto 的段 (不会删除最后一个段)
+     */
+    void CompactPrefix(uint64_t upto);
+
+    /**
+     * @brief 安装快照后：清空日志，下一条日志从 next_index 开始
+     */
+    bool Reset(uint64_t next_index);
+
+    // ========== currentTerm / votedFor ==========
+
+    /**
+     * @brief 持久化 hardstate：一次 pwrite (两个槽位交替写，撕裂写时退回上一份) + 一次 fdatasync
+     */
+    bool SaveHardState(const HardState& state);
+    HardState GetHardState() const;
+
+    /**
+     * @brief 每次 fdatasync 完成后在 sync 线程中回调 (耗时, 本次覆盖的 entry 数)，用于监控 / 基准
+     * @details 需在 Open 之前设置
+     */
+    void SetSyncObserver(SyncObserver observer) { sync_observer_ = std::move(observer); }
+
+private:
+    struct Segment {
+        ~Segment();
+
+        std::string path;
+        int fd = -1;
+        uint64_t first_index = 0;
+        uint64_t size = 0;               // 文件有效长度
+        std::vector<uint64_t> offsets;   // offsets[i]：first_index + i 的记录起始偏移
+    };
+    using SegmentPtr = std::shared_ptr<Segment>;
+
+    bool LoadSegments(std::string* error);
+    bool LoadHardState(std::string* error);
+    SegmentPtr CreateSegmentLocked(uint64_t first_index);
+    // index 所在的段，不在日志中返回 nullptr
+    SegmentPtr FindSegmentLocked(uint64_t index) const;
+    bool ReadRecords(const SegmentPtr& seg, uint64_t index, uint64_t begin, uint64_t end,
+                     std::vector<WalEntry>* out) const;
+    bool ResetLocked(uint64_t next_index);
+    bool SyncDir();
+    void SyncLoop();
+    void FailLocked(const char* what);
+
+    uint64_t NextIndexLocked() const { return first_index_ + terms_.size(); }
+
+    WalOptions options_;
+    SyncObserver sync_observer_;
+
+    mutable std::mutex mtx_;
+    std::condition_variable sync_cv_;     // 唤醒 sync 线程
+    std::condition_variable durable_cv_;  // 唤醒 WaitDurable
+    std::thread syncer_;
+    bool opened_ = false;
+    bool closing_ = false;
+    bool failed_ = false;
+
+    std::vector<SegmentPtr> segments_;    // 按 first_index 升序，最后一个可写
+    std::vector<SegmentPtr> unsynced_sealed_;  // 滚动时封存、尚未 fdatasync 的段
+    bool dir_dirty_ = false;              // 新建了段文件，需要 fsync 目录
+    std::deque<uint64_t> terms_;          // terms_[i]：first_index_ + i 的 term
+    uint64_t first_index_ = 1;
+    uint64_t durable_index_ = 0;
+    uint64_t truncate_epoch_ = 0;         // 截断 / 重置时递增，使截断前开始的 fdatasync 不推进 durable_index_
+
+    mutable std::mutex hs_mtx_;
+    int hs_fd_ = -1;
+    uint64_t hs_seq_ = 0;
+    HardState hard_state_;
+};
+
+} // namespace raft
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "config.h"
+#include "range_table.h"
+
+namespace raft {
+
+/**
+ * @brief 区间自动分裂的阈值
+ */
+struct SplitPolicy {
+    uint64_t max_bytes = static_cast<uint64_t>(RANGE_SPLIT_MAX_MB) * 1024 * 1024;
+    double max_qps = RANGE_SPLIT_MAX_QPS;
+    int min_interval_ms = RANGE_SPLIT_MIN_INTERVAL_MS;
+    uint64_t min_keys = 16;  // 太小的区间即使 QPS 高也不分裂 (热点集中在一个 key 上时分裂没有用)
+};
+
+enum class SplitReason {
+    kNone,
+    kSize,   // 数据量超过 max_bytes
+    kLoad,   // QPS 超过 max_qps
+};
+
+/**
+ * @brief 单个区间的读写负载统计
+ * @details
+ * 请求路径上只做原子自增 (RecordRead / RecordWrite)；领导人的定时器周期调用 Sample，
+ * 把两次采样之间的计数折算成速率，再按半衰期做指数滑动平均，短暂尖峰不会触发分裂。
+ */
+class RangeLoadTracker {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Snapshot {
+        double read_qps = 0;
+        double write_qps = 0;
+        double write_bytes_per_sec = 0;
+        double Qps() const { return read_qps + write_qps; }
+    };
+
+    explicit RangeLoadTracker(int half_life_ms = RANGE_LOAD_HALF_LIFE_MS, Clock::time_point now = Clock::now());
+
+    void RecordRead(uint64_t count = 1) { reads_.fetch_add(count, std::memory_order_relaxed); }
+    void RecordWrite(uint64_t bytes, uint64_t count = 1) {
+        writes_.fetch_add(count, std::memory_order_relaxed);
+        write_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 采样并更新滑动平均，返回更新后的值
+     */
+    Snapshot Sample(Clock::time_point now = Clock::now());
+    Snapshot Current() const;
+
+    /**
+     * @brief 分裂后两边都从当前速率的一半重新开始 (假设负载按 key 数对半分)
+     */
+    void Halve();
+
+private:
+    std::atomic<uint64_t> reads_{0};
+    std::atomic<uint64_t> writes_{0};
+    std::atomic<uint64_t> write_bytes_{0};
+
+    mutable std::mutex mtx_;
+    double half_life_ms_;
+    Clock::time_point last_sample_;
+    bool has_sample_ = false;
+    Snapshot avg_;
+};
+
+/**
+ * @brief 判断区间是否需要分裂
+ * @param bytes 区间当前数据量 (SkipList::mem_usage)
+ * @param keys 区间当前 key 数 (SkipList::size)
+ * @param since_last_split_ms 距上次分裂的时间，从未分裂过传一个足够大的值
+ */
+SplitReason ShouldSplit(const SplitPolicy& policy, uint64_t bytes, uint64_t keys, double qps,
+                        int64_t since_last_split_ms);
+
+/**
+ * @brief 在 split_key 处切开 range，得到分裂后的两个描述
+ * @details 左边保留原 group_id，右边是新组 new_group_id，副本集合相同，两边 epoch 都是原 epoch + 1。
+ *
+ * 分裂的完整流程 (由原组领导人发起)：
+ * 1. 用 SkipList::approximate_median_key 选分裂点 (按 SkipList 的有序性，不扫描全表)；
+ * 2. 提议一条 Op{Operation = "Split", Key = split_key, Value = EncodeRangeDescriptor(right)}；
+ * 3. 每个副本 apply 该日志时调用 SkipList::split_off(split_key, 新组的 SkipList)，节点整体
+ *    移交、不拷贝数据，然后以同样的副本集合启动新组的 Raft 实例 (日志从 apply index 开始)；
+ * 4. 领导人把两个描述写入 RangeMetaStore，其他节点通过 Watch 更新 RangeTable。
+ * 分裂日志之后到达原组、但 key 已属于右边的请求，在 apply 时按新区间拒绝，客户端刷新路由后重试。
+ * @return split_key 不在 range 内部 (必须严格大于 start_key) 时返回 false
+ */
+bool SplitDescriptor(const RangeDescriptor& range, const std::string& split_key, uint64_t new_group_id,
+                     RangeDescriptor* left, RangeDescriptor* right);
+
+} // namespace raft
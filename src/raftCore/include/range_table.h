@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace raft {
+
+/**
+ * @brief 一个 Raft 组负责的 key 区间 [start_key, end_key)
+ * @details Multi-Raft 下每个组各有一个 SkipList，只存自己区间内的 key；
+ * 描述在 ZooKeeper 的 /kv/ranges/<group_id> 下持久化 (见 RangeMetaStore)。
+ */
+struct RangeDescriptor {
+    uint64_t group_id = 0;
+    std::string start_key;           // 闭区间
+    std::string end_key;             // 开区间，空串表示 +inf
+    uint64_t epoch = 0;              // 区间或副本集合每变一次 (分裂 / 合并 / 迁移) 加一，旧描述一律被拒绝
+    std::vector<int32_t> replicas;   // 副本所在的节点 id
+
+    bool Contains(std::string_view key) const {
+        return key >= start_key && (end_key.empty() || key < end_key);
+    }
+};
+
+/**
+ * @brief 描述的紧凑二进制编码 (用作 ZooKeeper 节点数据)
+ */
+std::string EncodeRangeDescriptor(const RangeDescriptor& desc);
+bool DecodeRangeDescriptor(std::string_view data, RangeDescriptor* desc);
+
+/**
+ * @brief key -> Raft 组的路由表
+ * @details
+ * 1. 按 start_key 有序存放互不重叠的区间，Locate 是一次 upper_bound，O(log n)。
+ * 2. Update 按 epoch 判新旧：同组 epoch 不增大视为过期；新描述与其他组重叠时，
+ *    被覆盖的旧区间直接移除 (它们一定来自分裂 / 合并之前)，之后该区间可能暂时查不到，
+ *    调用方应当回源 (重新 LoadAll) 而不是用旧路由。
+ * 3. 读远多于写 (每个请求一次 Locate，区间变化很少)，用读写锁。
+ */
+class RangeTable {
+public:
+    enum class Status {
+        kOk,
+        kStale,     // 同组已有不旧于它的描述
+        kInvalid,   // start_key >= end_key
+    };
+
+    Status Update(const RangeDescriptor& desc);
+
+    /**
+     * @brief 用一份完整的描述列表替换整张表 (启动 / 监听到 ZooKeeper 变化后全量重载)
+     * @return 列表内部有重叠时返回 false，表不变
+     */
+    bool Reset(const std::vector<RangeDescriptor>& descs);
+
+    void Remove(uint64_t group_id);
+
+    /**
+     * @brief 查找负责 key 的组；没有任何区间覆盖 key 时返回 false
+     */
+    bool Locate(std::string_view key, RangeDescriptor* desc) const;
+
+    bool Get(uint64_t group_id, RangeDescriptor* desc) const;
+    std::vector<RangeDescriptor> All() const;
+    size_t Size() const;
+
+private:
+    using RangeMap = std::map<std::string, RangeDescriptor, std::less<>>;
+
+    RangeMap::iterator EraseLocked(RangeMap::iterator it);
+
+    mutable std::shared_mutex mtx_;
+    RangeMap ranges_;                                              // start_key -> 描述
+    std::unordered_map<uint64_t, std::string> by_group_;           // group_id -> start_key
+};
+
+} // namespace raft
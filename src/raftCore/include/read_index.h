@@ -0,0 +1,138 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include "config.h"
+
+namespace raft {
+
+// ========== ReadIndex 需要的领导人侧操作 (由 Raft 核心实现) ==========
+class ReadIndexHost {
+public:
+    virtual ~ReadIndexHost() = default;
+
+    /**
+     * @brief 立即向所有 follower 发送一轮心跳 (空 AppendEntries)，不等待结果
+     * @details 实现方在发出第一个 RPC 之前记下发送时刻 sent_at，收到多数派 (含自己) 同任期的
+     * 成功回复后调用 ReadIndex::OnQuorumAck(term, sent_at)。单节点集群可以在本函数内直接回调。
+     * 可能在任意读线程中调用，调用时不持有 ReadIndex 的锁。
+     */
+    virtual void BroadcastHeartbeat() = 0;
+};
+
+struct ReadIndexConfig {
+    bool lease_read = RAFT_LEASE_READ;
+    int election_timeout_min_ms = minRandomizedElectionTime;
+    int clock_drift_ms = RAFT_LEASE_CLOCK_DRIFT_MS;
+    int round_retry_ms = HeartBeatTimeout * 4;  // 一轮确认迟迟收不齐时重发
+};
+
+struct ReadIndexStats {
+    uint64_t reads = 0;        // 成功的读
+    uint64_t lease_reads = 0;  // 其中走租约、没有等待心跳的
+    uint64_t remote_reads = 0; // 为 follower 确认的 read index
+    uint64_t rounds = 0;       // 为读请求发起的心跳轮数
+};
+
+/**
+ * @brief 线性一致性读屏障 (Raft 论文 6.4 ReadIndex + 可选的领导人租约)
+ * @details
+ * Get 不再作为 Op 写进日志，而是在领导人本地：
+ * 1. 等到本任期已经提交过日志 (当选后的 no-op)，此时 commit_index 不落后于任何已确认的写；
+ * 2. 记下 read_index = commit_index；
+ * 3. 确认自己仍是领导人：需要一轮在 read_index 记下之后发出、被多数派确认的心跳。
+ *    在同一轮心跳发出前到达的读共享这一轮，心跳在途期间到达的读共享下一轮，
+ *    Raft 核心的常规心跳 (只要也回调 OnQuorumAck) 同样可以完成确认；
+ * 4. 等状态机 apply 到 read_index，然后直接读本地 SkipList。
+ *
+ * 租约 (lease_read)：多数派确认了在 sent_at 发出的心跳，意味着这些 follower 在
+ * sent_at 之后至少一个最小选举超时内不会发起选举，减去时钟漂移余量即为租约；
+ * 租约内第 3 步省略，读请求 0 RTT。
+ * 注意：租约只有在 follower 不给 "最近还收到过领导人心跳时" 的候选人投票 (leader stickiness)
+ * 的前提下才安全 (即 ElectionControl 的 check_quorum)，否则一个刚超时的分区节点仍可能被选出新领导人，因此默认关闭。
+ *
+ * Raft 核心的调用约定 (均需在相应状态变化后立即调用，可持有核心自己的锁)：
+ * BecomeLeader / StepDown 跟随角色变化；OnCommit 在 commit_index 推进后、apply 之前调用；
+ * OnApplied 在 apply 之后调用；OnQuorumAck 见 ReadIndexHost。
+ */
+class ReadIndex {
+public:
+    enum class Status {
+        kOk,
+        kNotLeader,
+        kTimeout,
+    };
+
+    explicit ReadIndex(ReadIndexHost* host, const ReadIndexConfig& config = ReadIndexConfig());
+
+    ReadIndex(const ReadIndex&) = delete;
+    ReadIndex& operator=(const ReadIndex&) = delete;
+
+    // ========== Raft 核心调用 ==========
+
+    void BecomeLeader(uint64_t term);
+    void StepDown();
+
+    /**
+     * @brief commit_index 推进 (commit_term 为该位置日志的任期)
+     */
+    void OnCommit(uint64_t commit_index, uint64_t commit_term);
+    void OnApplied(uint64_t applied_index);
+
+    /**
+     * @brief 在 sent_at 发出的一轮心跳得到了多数派的确认
+     */
+    void OnQuorumAck(uint64_t term, std::chrono::steady_clock::time_point sent_at);
+
+    // ========== 读请求调用 ==========
+
+    /**
+     * @brief 阻塞直到可以在本地状态机上执行一次线性一致性读
+     * @param read_index 非空时返回本次读使用的 read index
+     * @return kOk 之后调用方直接读本地存储；kNotLeader 时应把客户端重定向到领导人
+     */
+    Status WaitReadable(int timeout_ms = CONSENSUS_TIMEOUT, uint64_t* read_index = nullptr);
+
+    /**
+     * @brief 只做领导权确认、不等本地 apply，返回 read index (处理 follower 发来的 ReadIndex RPC)
+     * @details follower 拿到 read index 后等自己 apply 到该位置，再读自己的本地存储
+     */
+    Status ConfirmReadIndex(int timeout_ms, uint64_t* read_index);
+
+    bool LeaseValid() const;
+    // 领导人已在当前任期提交过日志 (成员变更 Membership::Prepare 的前置条件)
+    bool TermCommitted() const;
+    ReadIndexStats GetStats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    bool LeaderOfLocked(uint64_t term) const { return leader_ && term_ == term; }
+    Status ConfirmLocked(std::unique_lock<std::mutex>& lock, Clock::time_point deadline, uint64_t* read_index,
+                         bool* lease);
+
+    ReadIndexHost* host_;
+    ReadIndexConfig config_;
+    Clock::duration lease_duration_;
+
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+
+    bool leader_ = false;
+    uint64_t term_ = 0;
+    bool term_committed_ = false;  // 本任期的日志已提交
+    uint64_t commit_index_ = 0;
+    uint64_t applied_index_ = 0;
+
+    Clock::time_point confirmed_at_;   // 被多数派确认的心跳中最晚的发送时刻
+    Clock::time_point requested_at_;   // 最近一次为读请求发起心跳的时刻
+    bool round_inflight_ = false;      // requested_at_ 发起的那一轮尚未被确认
+    Clock::time_point lease_until_;
+
+    ReadIndexStats stats_;
+};
+
+} // namespace raft
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+namespace raft {
+
+struct ReplicationWindowConfig {
+    size_t max_batch_entries = 256;  // 攒满这么多条立即发送
+    size_t max_inflight = 8;         // 流水线模式下的窗口大小
+    int linger_us = 200;             // 未攒满一批时最多等待多久
+};
+
+/**
+ * @brief follower 对 AppendEntries 的回复中窗口关心的字段 (对应 AppendEntriesReply)
+ */
+struct ReplicationReply {
+    bool ok = false;              // RPC 本身成功；false 表示失败 / 超时，其余字段无意义
+    bool success = false;
+    uint64_t term = 0;
+    uint64_t conflict_term = 0;   // 非 0：follower 在 conflict_index 处的任期
+    uint64_t conflict_index = 0;
+};
+
+/**
+ * @brief 单个 follower 的复制窗口 (ReplicationPipeline 的状态机，不含线程、锁与 RPC)
+ * @details
+ * 1. 窗口：探测模式下最多 1 个在途批次，第一次成功后恢复为 max_inflight；next_index 发送时乐观推进；
+ * 2. generation：每次回退 / 失效递增，回复带着发送时的 generation，旧 generation 的失败直接忽略，
+ *    旧 generation 的成功仍可推进 match_index (follower 确实持有这些日志)；
+ * 3. 回退：拒绝时按 conflictTerm / conflictIndex 跳转 next_index，RPC 失败回到 match_index + 1，
+ *    回退后立即重发，不再等 linger；
+ * 4. 空复制：LastIndex 显示有新日志但 CopyEntries 一条也没拷出来 (日志被并发截断或压缩) 时停止重试，
+ *    直到下一次 MarkPending / Reset，避免按 linger 间隔空转。
+ * 不是线程安全的，由调用方加锁；时间由调用方传入，便于测试。
+ */
+class ReplicationWindow {
+public:
+    using Clock = std::chrono::steady_clock;
+    // 领导人日志中任期为 term 的最后一条日志索引，不存在返回 0
+    using LastIndexOfTerm = std::function<uint64_t(uint64_t term)>;
+
+    struct Batch {
+        uint64_t generation = 0;
+        uint64_t prev_index = 0;
+        uint64_t last_index = 0;
+    };
+
+    enum class Action {
+        kIdle,          // 无事可做 (窗口满 / 没有新日志 / 等待快照)：等 MarkPending 或回复唤醒
+        kWaitUntil,     // 有待发日志但还在 linger 窗口内：等到 deadline
+        kNeedSnapshot,  // next_index 已被快照压缩：发送快照，之后 ResetAfterSnapshot
+        kSend,          // 从 NextIndex() 开始复制一批，随后 OnSent / OnEmptyCopy
+    };
+
+    struct Decision {
+        Action action = Action::kIdle;
+        Clock::time_point deadline;  // 仅 kWaitUntil
+    };
+
+    enum class ReplyResult {
+        kStale,          // 旧 generation 的失败，已忽略
+        kHigherTerm,     // follower 任期更高：在途批次已失效，由 Raft 核心退位
+        kAcked,          // 成功，但 match_index 没有前进 (重复 / 乱序的确认)
+        kMatchAdvanced,  // 成功且 match_index 前进
+        kRewound,        // 拒绝或 RPC 失败：已回退 next_index 并进入探测模式
+    };
+
+    explicit ReplicationWindow(const ReplicationWindowConfig& config = ReplicationWindowConfig());
+
+    // 成为领导人：match_index = 0，从 next_index 开始探测
+    void Restart(uint64_t next_index);
+
+    // 丢弃在途批次并回到探测模式，立即从 next_index 重发
+    void Reset(uint64_t next_index);
+
+    // 快照安装完成后从 last_included_index + 1 继续
+    void ResetAfterSnapshot(uint64_t last_included_index);
+
+    // 让所有在途回复失效 (停止 / 发现更高任期)
+    void Invalidate();
+
+    // 领导人追加了新日志：开始 linger 计时
+    void MarkPending(Clock::time_point now);
+
+    /**
+     * @brief 下一步做什么
+     * @param first_index / last_index 领导人日志中第一条未压缩的索引与最后一条的索引
+     * @details 返回 kNeedSnapshot 时进入暂停，直到 ResetAfterSnapshot / Restart
+     */
+    Decision Next(Clock::time_point now, uint64_t first_index, uint64_t last_index);
+
+    // kSend 之后实际复制了 count (> 0) 条：记录在途批次并推进 next_index
+    Batch OnSent(size_t count);
+
+    // kSend 之后一条也没复制出来
+    void OnEmptyCopy();
+
+    /**
+     * @brief 处理批次 (generation, last_index) 的回复
+     * @param current_term 领导人当前任期
+     */
+    ReplyResult OnReply(uint64_t generation, uint64_t last_index, const ReplicationReply& reply,
+                        uint64_t current_term, const LastIndexOfTerm& last_index_of_term);
+
+    uint64_t NextIndex() const { return next_index_; }
+    uint64_t MatchIndex() const { return match_index_; }
+    uint64_t Generation() const { return generation_; }
+    size_t InflightCount() const { return inflight_.size(); }
+    bool Probing() const { return probing_; }
+    bool PausedForSnapshot() const { return paused_for_snapshot_; }
+    size_t Window() const { return probing_ ? 1 : config_.max_inflight; }
+
+private:
+    ReplicationWindowConfig config_;
+    bool paused_for_snapshot_ = false;
+    bool probing_ = true;
+    bool stalled_ = false;  // 上一次 kSend 没有复制出日志
+    uint64_t generation_ = 0;
+    uint64_t next_index_ = 1;
+    uint64_t match_index_ = 0;
+    std::deque<Batch> inflight_;
+    Clock::time_point first_pending_;
+    bool has_first_pending_ = false;
+};
+
+} // namespace raft
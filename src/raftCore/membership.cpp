@@ -0,0 +1,279 @@
+#include "membership.h"
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <iterator>
+
+#include "opCodec.h"
+
+namespace raft {
+
+// =========================================================
+//  PART 1: 配置与编码
+// =========================================================
+
+static bool SortedContains(const std::vector<int32_t>& ids, int32_t node) {
+    return std::binary_search(ids.begin(), ids.end(), node);
+}
+
+static void SortedInsert(std::vector<int32_t>& ids, int32_t node) {
+    ids.insert(std::lower_bound(ids.begin(), ids.end(), node), node);
+}
+
+static void SortedErase(std::vector<int32_t>& ids, int32_t node) {
+    auto it = std::lower_bound(ids.begin(), ids.end(), node);
+    if (it != ids.end() && *it == node) {
+        ids.erase(it);
+    }
+}
+
+static bool SetError(std::string* error, const std::string& what) {
+    if (error != nullptr) {
+        *error = what;
+    }
+    return false;
+}
+
+bool MembershipConfig::IsVoter(int32_t node) const {
+    return SortedContains(voters, node) || SortedContains(outgoing, node);
+}
+
+bool MembershipConfig::IsLearner(int32_t node) const {
+    return SortedContains(learners, node);
+}
+
+std::vector<int32_t> MembershipConfig::Replicas() const {
+    std::vector<int32_t> all;
+    all.reserve(voters.size() + outgoing.size() + learners.size());
+    all.insert(all.end(), voters.begin(), voters.end());
+    all.insert(all.end(), outgoing.begin(), outgoing.end());
+    all.insert(all.end(), learners.begin(), learners.end());
+    std::sort(all.begin(), all.end());
+    all.erase(std::unique(all.begin(), all.end()), all.end());
+    return all;
+}
+
+static void PutIds(std::string& out, const std::vector<int32_t>& ids) {
+    PutVarint64(out, ids.size());
+    for (int32_t id : ids) {
+        PutVarint64(out, static_cast<uint32_t>(id));
+    }
+}
+
+static bool GetIds(std::string_view& in, std::vector<int32_t>* ids) {
+    uint64_t count = 0;
+    if (!GetVarint64(in, &count) || count > in.size()) {
+        return false;
+    }
+    ids->clear();
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t id = 0;
+        if (!GetVarint64(in, &id) || id > INT32_MAX) {
+            return false;
+        }
+        if (!ids->empty() && static_cast<int32_t>(id) <= ids->back()) {
+            return false;  // 必须升序、去重
+        }
+        ids->push_back(static_cast<int32_t>(id));
+    }
+    return true;
+}
+
+std::string EncodeMembership(const MembershipConfig& config) {
+    std::string out;
+    out.push_back(static_cast<char>(kMembershipMagic));
+    PutIds(out, config.voters);
+    PutIds(out, config.outgoing);
+    PutIds(out, config.learners);
+    return out;
+}
+
+bool DecodeMembership(std::string_view data, MembershipConfig* config, std::string* error) {
+    if (!IsMembershipEntry(data)) {
+        return SetError(error, "membership: bad magic");
+    }
+    data.remove_prefix(1);
+    MembershipConfig decoded;
+    if (!GetIds(data, &decoded.voters) || !GetIds(data, &decoded.outgoing) || !GetIds(data, &decoded.learners)) {
+        return SetError(error, "membership: malformed member list");
+    }
+    if (!data.empty()) {
+        return SetError(error, "membership: trailing bytes");
+    }
+    if (decoded.voters.empty()) {
+        return SetError(error, "membership: no voters");
+    }
+    for (int32_t learner : decoded.learners) {
+        if (decoded.IsVoter(learner)) {
+            return SetError(error, "membership: node is both voter and learner");
+        }
+    }
+    *config = std::move(decoded);
+    return true;
+}
+
+bool IsMembershipEntry(std::string_view data) {
+    return !data.empty() && static_cast<uint8_t>(data[0]) == kMembershipMagic;
+}
+
+// =========================================================
+//  PART 2: 配置历史
+// =========================================================
+
+Membership::Membership(MembershipConfig initial, const MembershipOptions& options) : options_(options) {
+    history_.emplace_back(0, std::move(initial));
+}
+
+const MembershipConfig& Membership::Committed() const {
+    return history_.front().second;
+}
+
+void Membership::OnAppend(uint64_t index, const MembershipConfig& config) {
+    OnTruncate(index - 1);  // 同一位置被新领导人的日志覆盖
+    history_.emplace_back(index, config);
+}
+
+void Membership::OnTruncate(uint64_t last_kept_index) {
+    // 已提交的配置 (front) 不会被截断
+    while (history_.size() > 1 && history_.back().first > last_kept_index) {
+        history_.pop_back();
+    }
+}
+
+bool Membership::OnCommit(uint64_t commit_index) {
+    commit_index_ = std::max(commit_index_, commit_index);
+    size_t last_committed = 0;
+    while (last_committed + 1 < history_.size() && history_[last_committed + 1].first <= commit_index_) {
+        ++last_committed;
+    }
+    history_.erase(history_.begin(), history_.begin() + static_cast<long>(last_committed));
+    return Current().Joint() && !ChangePending();
+}
+
+void Membership::Restore(uint64_t index, const MembershipConfig& config) {
+    history_.clear();
+    history_.emplace_back(index, config);
+    commit_index_ = std::max(commit_index_, index);
+}
+
+// =========================================================
+//  PART 3: 变更校验
+// =========================================================
+
+Membership::ChangeStatus Membership::Prepare(const std::vector<MemberChange>& changes, const MatchLookup& match,
+                                             uint64_t last_index, bool leader_term_committed, MembershipConfig* next,
+                                             std::string* error) const {
+    const MembershipConfig& current = Current();
+    if (ChangePending() || current.Joint()) {
+        SetError(error, "membership: another change is in progress");
+        return ChangeStatus::kPending;
+    }
+    // 上一任期可能留下一个只复制到少数派的单步变更，本任期提交过日志后它要么已提交、要么已被覆盖
+    if (!leader_term_committed) {
+        SetError(error, "membership: leader has not committed an entry in its term");
+        return ChangeStatus::kPending;
+    }
+    if (changes.empty()) {
+        SetError(error, "membership: empty change");
+        return ChangeStatus::kInvalid;
+    }
+
+    MembershipConfig proposed;
+    proposed.voters = current.voters;
+    proposed.learners = current.learners;
+    for (const MemberChange& change : changes) {
+        const std::string node = std::to_string(change.node);
+        switch (change.type) {
+            case MemberChangeType::kAddLearner:
+                if (change.node < 0 || proposed.Contains(change.node)) {
+                    SetError(error, "membership: node " + node + " is already a member");
+                    return ChangeStatus::kInvalid;
+                }
+                SortedInsert(proposed.learners, change.node);
+                break;
+            case MemberChangeType::kPromote:
+                if (!proposed.IsLearner(change.node)) {
+                    SetError(error, "membership: node " + node + " is not a learner");
+                    return ChangeStatus::kInvalid;
+                }
+                if (!CaughtUp(match(change.node), last_index)) {
+                    SetError(error, "membership: learner " + node + " has not caught up");
+                    return ChangeStatus::kNotCaughtUp;
+                }
+                SortedErase(proposed.learners, change.node);
+                SortedInsert(proposed.voters, change.node);
+                break;
+            case MemberChangeType::kRemove:
+                if (!proposed.Contains(change.node)) {
+                    SetError(error, "membership: node " + node + " is not a member");
+                    return ChangeStatus::kInvalid;
+                }
+                SortedErase(proposed.voters, change.node);
+                SortedErase(proposed.learners, change.node);
+                break;
+        }
+    }
+    if (proposed.voters.empty()) {
+        SetError(error, "membership: cannot remove every voter");
+        return ChangeStatus::kInvalid;
+    }
+
+    // 投票成员只变化一个时新旧多数派必然相交，单步即可；否则经过 C_old,new
+    std::vector<int32_t> diff;
+    std::set_symmetric_difference(current.voters.begin(), current.voters.end(), proposed.voters.begin(),
+                                  proposed.voters.end(), std::back_inserter(diff));
+    if (diff.size() > 1) {
+        proposed.outgoing = current.voters;
+    }
+    *next = std::move(proposed);
+    return ChangeStatus::kOk;
+}
+
+MembershipConfig Membership::LeaveJoint() const {
+    MembershipConfig next = Current();
+    next.outgoing.clear();
+    return next;
+}
+
+// =========================================================
+//  PART 4: 多数派
+// =========================================================
+
+static bool MajorityAcked(const std::vector<int32_t>& voters, const Membership::AckLookup& acked) {
+    size_t count = 0;
+    for (int32_t node : voters) {
+        if (acked(node)) {
+            ++count;
+        }
+    }
+    return count * 2 > voters.size();
+}
+
+static uint64_t MajorityMatch(const std::vector<int32_t>& voters, const Membership::MatchLookup& match) {
+    std::vector<uint64_t> matches;
+    matches.reserve(voters.size());
+    for (int32_t node : voters) {
+        matches.push_back(match(node));
+    }
+    // 降序第 n/2 个：至少 n/2 + 1 个成员的 matchIndex 不小于它
+    auto mid = matches.begin() + static_cast<long>(matches.size() / 2);
+    std::nth_element(matches.begin(), mid, matches.end(), std::greater<uint64_t>());
+    return *mid;
+}
+
+bool Membership::HasQuorum(const AckLookup& acked) const {
+    const MembershipConfig& config = Current();
+    return MajorityAcked(config.voters, acked) && (!config.Joint() || MajorityAcked(config.outgoing, acked));
+}
+
+uint64_t Membership::QuorumMatch(const MatchLookup& match) const {
+    const MembershipConfig& config = Current();
+    uint64_t index = MajorityMatch(config.voters, match);
+    if (config.Joint()) {
+        index = std::min(index, MajorityMatch(config.outgoing, match));
+    }
+    return index;
+}
+
+}  // namespace raft
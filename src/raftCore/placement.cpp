@@ -0,0 +1,243 @@
+#include "placement.h"
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "opCodec.h"  // varint 编码
+
+namespace raft {
+
+// =========================================================
+//  PART 1: 报告 / 指令编解码
+// =========================================================
+/*
+ * NodeLoadReport：version u8 | node_id varint | count varint
+ *                 | (group_id varint | leader u8 | milli_qps varint | bytes varint) ...
+ * PlacementMove ：version u8 | type u8 | group_id varint | from varint | to varint
+ */
+static constexpr uint8_t kPlacementCodecVersion = 1;
+
+std::string EncodeNodeLoadReport(const NodeLoadReport& report) {
+    std::string out;
+    out.push_back(static_cast<char>(kPlacementCodecVersion));
+    PutVarint64(out, static_cast<uint32_t>(report.node_id));
+    PutVarint64(out, report.groups.size());
+    for (const GroupLoad& g : report.groups) {
+        PutVarint64(out, g.group_id);
+        out.push_back(static_cast<char>(g.leader ? 1 : 0));
+        PutVarint64(out, static_cast<uint64_t>(std::max(g.qps, 0.0) * 1000));
+        PutVarint64(out, g.bytes);
+    }
+    return out;
+}
+
+bool DecodeNodeLoadReport(std::string_view in, NodeLoadReport* report) {
+    if (in.empty() || static_cast<uint8_t>(in[0]) != kPlacementCodecVersion) {
+        return false;
+    }
+    in.remove_prefix(1);
+    uint64_t node = 0, count = 0;
+    if (!GetVarint64(in, &node) || !GetVarint64(in, &count) || count > in.size()) {
+        return false;
+    }
+    report->node_id = static_cast<int32_t>(node);
+    report->groups.clear();
+    for (uint64_t i = 0; i < count; ++i) {
+        GroupLoad g;
+        uint64_t milli_qps = 0;
+        if (!GetVarint64(in, &g.group_id) || in.empty()) {
+            return false;
+        }
+        g.leader = in.front() != 0;
+        in.remove_prefix(1);
+        if (!GetVarint64(in, &milli_qps) || !GetVarint64(in, &g.bytes)) {
+            return false;
+        }
+        g.qps = static_cast<double>(milli_qps) / 1000;
+        report->groups.push_back(g);
+    }
+    return in.empty();
+}
+
+std::string EncodePlacementMove(const PlacementMove& move) {
+    std::string out;
+    out.push_back(static_cast<char>(kPlacementCodecVersion));
+    out.push_back(static_cast<char>(move.type));
+    PutVarint64(out, move.group_id);
+    PutVarint64(out, static_cast<uint32_t>(move.from_node));
+    PutVarint64(out, static_cast<uint32_t>(move.to_node));
+    return out;
+}
+
+bool DecodePlacementMove(std::string_view in, PlacementMove* move) {
+    if (in.size() < 2 || static_cast<uint8_t>(in[0]) != kPlacementCodecVersion ||
+        static_cast<uint8_t>(in[1]) > static_cast<uint8_t>(PlacementMove::Type::kMoveReplica)) {
+        return false;
+    }
+    move->type = static_cast<PlacementMove::Type>(in[1]);
+    in.remove_prefix(2);
+    uint64_t from = 0, to = 0;
+    if (!GetVarint64(in, &move->group_id) || !GetVarint64(in, &from) || !GetVarint64(in, &to)) {
+        return false;
+    }
+    move->from_node = static_cast<int32_t>(from);
+    move->to_node = static_cast<int32_t>(to);
+    return in.empty();
+}
+
+// =========================================================
+//  PART 2: 调度
+// =========================================================
+
+namespace {
+
+// 节点 -> 负载；用有序 map 保证同样的输入总是得到同样的指令
+template <typename T>
+int32_t Hottest(const std::map<int32_t, T>& load) {
+    auto it = std::max_element(load.begin(), load.end(),
+                               [](const auto& a, const auto& b) { return a.second < b.second; });
+    return it->first;
+}
+
+template <typename T>
+double Mean(const std::map<int32_t, T>& load) {
+    double sum = 0;
+    for (const auto& kv : load) {
+        sum += static_cast<double>(kv.second);
+    }
+    return sum / static_cast<double>(load.size());
+}
+
+} // namespace
+
+std::vector<PlacementMove> PlanRebalance(const std::vector<NodeLoadReport>& reports,
+                                         const std::vector<RangeDescriptor>& ranges,
+                                         const std::vector<uint64_t>& busy_groups,
+                                         const PlacementConfig& config) {
+    std::vector<PlacementMove> moves;
+    if (reports.size() < 2 || config.max_moves == 0) {
+        return moves;
+    }
+
+    std::map<int32_t, double> leader_load;    // 节点上作为领导人的 QPS 之和
+    std::map<int32_t, uint64_t> replica_load; // 节点上的副本总字节数
+    std::unordered_map<uint64_t, int32_t> group_leader;
+    std::unordered_map<uint64_t, double> group_qps;
+    std::unordered_map<uint64_t, uint64_t> group_bytes;
+    for (const NodeLoadReport& r : reports) {
+        leader_load[r.node_id];
+        replica_load[r.node_id];
+        for (const GroupLoad& g : r.groups) {
+            replica_load[r.node_id] += g.bytes;
+            group_bytes[g.group_id] = std::max(group_bytes[g.group_id], g.bytes);
+            if (g.leader) {
+                leader_load[r.node_id] += g.qps;
+                group_leader[g.group_id] = r.node_id;
+                group_qps[g.group_id] = g.qps;
+            }
+        }
+    }
+
+    std::unordered_map<uint64_t, const RangeDescriptor*> by_group;
+    for (const RangeDescriptor& d : ranges) {
+        by_group[d.group_id] = &d;
+    }
+    std::unordered_set<uint64_t> skip(busy_groups.begin(), busy_groups.end());  // 每组每轮最多一条指令
+
+    // 1. 领导权均衡
+    while (moves.size() < config.max_moves) {
+        int32_t hot = Hottest(leader_load);
+        double hot_load = leader_load[hot];
+        if (hot_load <= 0 || hot_load <= Mean(leader_load) * (1 + config.tolerance)) {
+            break;
+        }
+        // 热节点领导的组按 QPS 从高到低尝试
+        std::vector<std::pair<double, uint64_t>> candidates;
+        for (const auto& kv : group_leader) {
+            if (kv.second == hot && !skip.count(kv.first) && by_group.count(kv.first)) {
+                candidates.emplace_back(group_qps[kv.first], kv.first);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), std::greater<>());
+
+        bool planned = false;
+        for (const auto& cand : candidates) {
+            const double qps = cand.first;
+            int32_t target = 0;
+            bool found = false;
+            for (int32_t node : by_group[cand.second]->replicas) {
+                if (node != hot && leader_load.count(node) && (!found || leader_load[node] < leader_load[target])) {
+                    target = node;
+                    found = true;
+                }
+            }
+            // 转移之后两者中较大的一方必须比现在的热节点小
+            if (!found || qps <= 0 || leader_load[target] + qps >= hot_load) {
+                continue;
+            }
+            moves.push_back({PlacementMove::Type::kTransferLeader, cand.second, hot, target});
+            leader_load[hot] -= qps;
+            leader_load[target] += qps;
+            group_leader[cand.second] = target;
+            skip.insert(cand.second);
+            planned = true;
+            break;
+        }
+        if (!planned) {
+            break;
+        }
+    }
+    if (!moves.empty()) {
+        return moves;
+    }
+
+    // 2. 副本均衡
+    while (moves.size() < config.max_moves) {
+        int32_t hot = Hottest(replica_load);
+        uint64_t hot_load = replica_load[hot];
+        if (hot_load == 0 || static_cast<double>(hot_load) <= Mean(replica_load) * (1 + config.tolerance)) {
+            break;
+        }
+        std::vector<std::pair<uint64_t, uint64_t>> candidates;  // (bytes, group)
+        for (const RangeDescriptor& d : ranges) {
+            if (!skip.count(d.group_id) && std::count(d.replicas.begin(), d.replicas.end(), hot)) {
+                candidates.emplace_back(group_bytes[d.group_id], d.group_id);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), std::greater<>());
+
+        bool planned = false;
+        for (const auto& cand : candidates) {
+            const uint64_t bytes = cand.first;
+            const std::vector<int32_t>& replicas = by_group[cand.second]->replicas;
+            int32_t target = 0;
+            bool found = false;
+            for (const auto& kv : replica_load) {
+                if (std::count(replicas.begin(), replicas.end(), kv.first)) {
+                    continue;
+                }
+                if (!found || kv.second < replica_load[target]) {
+                    target = kv.first;
+                    found = true;
+                }
+            }
+            if (!found || bytes == 0 || replica_load[target] + bytes >= hot_load) {
+                continue;
+            }
+            moves.push_back({PlacementMove::Type::kMoveReplica, cand.second, hot, target});
+            replica_load[hot] -= bytes;
+            replica_load[target] += bytes;
+            skip.insert(cand.second);
+            planned = true;
+            break;
+        }
+        if (!planned) {
+            break;
+        }
+    }
+    return moves;
+}
+
+} // namespace raft
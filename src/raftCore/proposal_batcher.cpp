@@ -0,0 +1,226 @@
+#include "proposal_batcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string_view>
+
+#include "cpu_topology.h"
+#include "opCodec.h"
+
+namespace raft {
+
+static const ApplyResult kEmptyResult;
+
+// raft.propose span 在 apply 回调 (或被拒绝) 时结束
+static void EndProposeSpans(std::vector<SpanRecord>& spans, ApplyPipeline::Status status) {
+    uint64_t now = TraceNowNanos();
+    for (SpanRecord& span : spans) {
+        span.end_ns = now;
+        span.arg_key = "status";
+        span.arg_value = static_cast<uint64_t>(status);
+        Tracer::GetInstance().Record(span);
+    }
+}
+
+ProposalBatcher::ProposalBatcher(ProposalSink* sink, const ProposalBatcherConfig& config)
+    : sink_(sink), config_(config) {
+    config_.max_ops = std::max<size_t>(1, config_.max_ops);
+    config_.max_bytes = std::max<size_t>(1, config_.max_bytes);
+    config_.max_linger_us = std::max<int64_t>(0, config_.max_linger_us);
+}
+
+ProposalBatcher::~ProposalBatcher() {
+    Stop();
+}
+
+// =========================================================
+//  PART 1: 生命周期与提交
+// =========================================================
+
+void ProposalBatcher::Start() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    flusher_ = std::thread(&ProposalBatcher::FlushLoop, this);
+}
+
+void ProposalBatcher::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        running_ = false;
+    }
+    cv_.notify_one();
+    if (flusher_.joinable()) {
+        flusher_.join();
+    }
+    std::deque<Pending> pending;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        pending.swap(pending_);
+        pending_bytes_ = 0;
+    }
+    for (Pending& p : pending) {
+        p.cb(Status::kShutdown, kEmptyResult);
+    }
+}
+
+void ProposalBatcher::Submit(std::string command, Callback cb) {
+    TraceContext trace = Tracer::Current();
+    uint64_t submit_ns = trace.Sampled() ? TraceNowNanos() : 0;
+    bool queued = false;
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (running_) {
+            queued = true;
+            pending_bytes_ += command.size();
+            pending_.push_back(Pending{std::move(command), std::move(cb), trace, submit_ns});
+            // 只在 flusher 可能空等 (队列原本为空) 或凑满一批 (提前结束 linger) 时唤醒
+            wake = pending_.size() == 1 || BatchFullLocked();
+        }
+    }
+    if (!queued) {
+        cb(Status::kShutdown, kEmptyResult);
+        return;
+    }
+    if (wake) {
+        cv_.notify_one();
+    }
+}
+
+ProposalBatcherStats ProposalBatcher::Stats() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return stats_;
+}
+
+// =========================================================
+//  PART 2: flusher 线程
+// =========================================================
+
+void ProposalBatcher::FlushLoop() {
+    ThreadPlacement::GetInstance().PinCurrentThread(kPlacementRaft);
+    std::vector<Pending> batch;
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (true) {
+        cv_.wait(lock, [this] { return !running_ || !pending_.empty(); });
+        if (!running_) {
+            return;
+        }
+        if (!BatchFullLocked() && stats_.linger_us > 0) {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(stats_.linger_us);
+            cv_.wait_until(lock, deadline, [this] { return !running_ || BatchFullLocked(); });
+            if (!running_) {
+                return;
+            }
+        }
+
+        size_t bytes = 0;
+        while (!pending_.empty() && batch.size() < config_.max_ops &&
+               (batch.empty() || bytes + pending_.front().command.size() <= config_.max_bytes)) {
+            bytes += pending_.front().command.size();
+            batch.push_back(std::move(pending_.front()));
+            pending_.pop_front();
+        }
+        pending_bytes_ -= bytes;
+        lock.unlock();
+
+        // Propose 期间到达的命令留在 pending_ 里，构成下一批
+        size_t n = batch.size();
+        Flush(batch);
+        batch.clear();
+
+        lock.lock();
+        avg_batch_ = 0.8 * avg_batch_ + 0.2 * static_cast<double>(n);
+        double scale = (avg_batch_ - 1.0) / avg_batch_;  // 每批一条时为 0
+        stats_.linger_us = static_cast<int64_t>(static_cast<double>(config_.max_linger_us) * scale);
+    }
+}
+
+void ProposalBatcher::Flush(std::vector<Pending>& batch) {
+    const bool single = batch.size() == 1;
+    std::string group;
+    if (!single) {
+        std::vector<std::string_view> commands;
+        commands.reserve(batch.size());
+        for (const Pending& p : batch) {
+            commands.emplace_back(p.command);
+        }
+        EncodeOpGroup(group, commands);
+    }
+
+    // 被采样的命令：raft.batch.wait 到此结束，raft.propose 从此开始 (未采样时不读时钟、不分配)
+    std::shared_ptr<std::vector<SpanRecord>> traced;
+    uint64_t flush_ns = 0;
+    for (const Pending& p : batch) {
+        if (!p.trace.Sampled()) {
+            continue;
+        }
+        if (!traced) {
+            traced = std::make_shared<std::vector<SpanRecord>>();
+            flush_ns = TraceNowNanos();
+        }
+        SpanRecord wait;
+        wait.trace_id = p.trace.trace_id;
+        wait.span_id = Tracer::NewId();
+        wait.parent_id = p.trace.span_id;
+        wait.name = "raft.batch.wait";
+        wait.start_ns = p.submit_ns;
+        wait.end_ns = flush_ns;
+        wait.arg_key = "batch";
+        wait.arg_value = batch.size();
+        Tracer::GetInstance().Record(wait);
+
+        SpanRecord propose = wait;
+        propose.span_id = Tracer::NewId();
+        propose.name = "raft.propose";
+        propose.start_ns = flush_ns;
+        traced->push_back(propose);
+    }
+
+    // 一条日志一次分配：所有等待者的回调一起交给 ApplyPipeline，apply 后按下标扇出
+    auto callbacks = std::make_shared<std::vector<Callback>>();
+    callbacks->reserve(batch.size());
+    for (Pending& p : batch) {
+        callbacks->push_back(std::move(p.cb));
+    }
+    auto fan_out = [callbacks, single, traced](Status status, const ApplyResult& result) {
+        if (traced) {
+            EndProposeSpans(*traced, status);
+        }
+        for (size_t i = 0; i < callbacks->size(); ++i) {
+            bool own = !single && status == Status::kApplied && i < result.ops.size();
+            (*callbacks)[i](status, own ? result.ops[i] : result);
+        }
+    };
+
+    bool accepted;
+    {
+        // 日志携带第一个被采样命令的 raft.propose span
+        ScopedTraceContext trace_scope(traced ? TraceContext{traced->front().trace_id, traced->front().span_id}
+                                              : TraceContext());
+        accepted = sink_->Propose(single ? batch[0].command : group, std::move(fan_out));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (accepted) {
+            ++stats_.proposals;
+            stats_.ops += batch.size();
+            stats_.max_ops = std::max<uint64_t>(stats_.max_ops, batch.size());
+        } else {
+            stats_.rejected += batch.size();
+        }
+    }
+    if (!accepted) {
+        if (traced) {
+            EndProposeSpans(*traced, Status::kLost);
+        }
+        for (Callback& cb : *callbacks) {
+            cb(Status::kLost, kEmptyResult);
+        }
+    }
+}
+
+}  // namespace raft
@@ -0,0 +1,751 @@
+#include "raft_wal.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "cpu_topology.h"
+#include "crc32c.h"
+
+namespace raft {
+
+namespace {
+
+constexpr size_t kRecordHeader = 8;    // len u32 | crc u32
+constexpr size_t kRecordFixed = 16;    // term u64 | index u64
+constexpr uint32_t kMaxRecordLen = 1u << 30;
+
+constexpr char kHardStateFile[] = "hardstate";
+constexpr uint32_t kHardStateMagic = 0x53485752;  // "RWHS"
+constexpr size_t kHardStateSlot = 512;            // 两个槽位分处不同扇区
+constexpr size_t kHardStateRecord = 28;           // magic u32 | seq u64 | term u64 | vote u32 | crc u32
+
+inline void PutU32(char* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<char>((v >> (8 * i)) & 0xFF);
+}
+
+inline void PutU64(char* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = static_cast<char>((v >> (8 * i)) & 0xFF);
+}
+
+inline uint32_t GetU32(const char* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+    return v;
+}
+
+inline uint64_t GetU64(const char* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= static_cast<uint64_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+    return v;
+}
+
+std::string SegmentName(uint64_t first_index) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "wal-%020llu.log", static_cast<unsigned long long>(first_index));
+    return buf;
+}
+
+bool ParseSegmentName(const char* name, uint64_t* first_index) {
+    // wal-<20 位数字>.log
+    size_t len = strlen(name);
+    if (len != 4 + 20 + 4 || strncmp(name, "wal-", 4) != 0 || strcmp(name + 24, ".log") != 0) {
+        return false;
+    }
+    uint64_t v = 0;
+    for (int i = 4; i < 24; ++i) {
+        if (name[i] < '0' || name[i] > '9') return false;
+        v = v * 10 + static_cast<uint64_t>(name[i] - '0');
+    }
+    *first_index = v;
+    return true;
+}
+
+bool WriteAll(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool PreadAll(int fd, char* buf, size_t len, uint64_t offset) {
+    while (len > 0) {
+        ssize_t n = ::pread(fd, buf, len, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (n == 0) {
+            return false;  // 文件被并发截断
+        }
+        buf += n;
+        len -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+bool SetError(std::string* error, const std::string& what) {
+    if (error) {
+        *error = what + ": " + strerror(errno);
+    }
+    return false;
+}
+
+void EncodeRecord(const WalEntry& e, std::string* buf) {
+    size_t base = buf->size();
+    uint32_t len = static_cast<uint32_t>(kRecordFixed + e.command.size());
+    buf->resize(base + kRecordHeader + kRecordFixed);
+    char* p = &(*buf)[base];
+    PutU32(p, len);
+    PutU64(p + kRecordHeader, e.term);
+    PutU64(p + kRecordHeader + 8, e.index);
+    buf->append(e.command);
+    p = &(*buf)[base];
+    PutU32(p + 4, Crc32c(p + kRecordHeader, len));
+}
+
+} // namespace
+
+// =========================================================
+//  PART 1: 生命周期与恢复
+// =========================================================
+
+RaftWal::Segment::~Segment() {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+RaftWal::RaftWal(const WalOptions& options) : options_(options) {
+    if (options_.segment_bytes < 4096) {
+        options_.segment_bytes = 4096;
+    }
+}
+
+RaftWal::~RaftWal() {
+    Close();
+}
+
+bool RaftWal::Open(std::string* error) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (opened_) {
+        return true;
+    }
+    if (::mkdir(options_.dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        return SetError(error, "mkdir " + options_.dir);
+    }
+    if (!LoadSegments(error) || !LoadHardState(error)) {
+        segments_.clear();
+        terms_.clear();
+        return false;
+    }
+    opened_ = true;
+    closing_ = false;
+    failed_ = false;
+    syncer_ = std::thread([this]() { SyncLoop(); });
+    return true;
+}
+
+void RaftWal::Close() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!opened_ || closing_) {
+            return;
+        }
+        closing_ = true;
+    }
+    sync_cv_.notify_all();
+    if (syncer_.joinable()) {
+        syncer_.join();  // sync 线程退出前会把已写入的日志全部落盘
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        segments_.clear();
+        unsynced_sealed_.clear();
+        terms_.clear();
+        opened_ = false;
+        closing_ = false;
+    }
+    durable_cv_.notify_all();
+    std::lock_guard<std::mutex> lock(hs_mtx_);
+    if (hs_fd_ >= 0) {
+        ::close(hs_fd_);
+        hs_fd_ = -1;
+    }
+}
+
+/**
+ * @brief 扫描段文件重建内存索引 (Open 中调用，持有 mtx_)
+ * @details 第一条不合法的记录之后的内容全部丢弃：所在段截断，之后的段删除
+ */
+bool RaftWal::LoadSegments(std::string* error) {
+    DIR* dir = ::opendir(options_.dir.c_str());
+    if (!dir) {
+        return SetError(error, "opendir " + options_.dir);
+    }
+    std::vector<std::pair<uint64_t, std::string>> files;
+    while (struct dirent* ent = ::readdir(dir)) {
+        uint64_t first = 0;
+        if (ParseSegmentName(ent->d_name, &first)) {
+            files.emplace_back(first, ent->d_name);
+        }
+    }
+    ::closedir(dir);
+    std::sort(files.begin(), files.end());
+
+    segments_.clear();
+    terms_.clear();
+    first_index_ = files.empty() ? 1 : files.front().first;
+
+    bool discard_rest = false;
+    bool removed = false;
+    std::string buf;
+    for (const auto& file : files) {
+        std::string path = options_.dir + "/" + file.second;
+        if (discard_rest || file.first != NextIndexLocked()) {
+            if (!discard_rest) {
+                std::cerr << "[RaftWal] segment " << path << " does not continue index " << NextIndexLocked()
+                          << ", dropping it and later segments" << std::endl;
+            }
+            discard_rest = true;
+            ::unlink(path.c_str());
+            removed = true;
+            continue;
+        }
+
+        int fd = ::open(path.c_str(), O_RDWR | O_APPEND | O_CLOEXEC);
+        if (fd < 0) {
+            return SetError(error, "open " + path);
+        }
+        auto seg = std::make_shared<Segment>();
+        seg->path = path;
+        seg->fd = fd;
+        seg->first_index = file.first;
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            return SetError(error, "fstat " + path);
+        }
+        uint64_t file_size = static_cast<uint64_t>(st.st_size);
+        buf.resize(file_size);
+        if (file_size > 0 && !PreadAll(fd, &buf[0], file_size, 0)) {
+            return SetError(error, "read " + path);
+        }
+
+        uint64_t off = 0;
+        uint64_t expect = file.first;
+        while (off + kRecordHeader <= file_size) {
+            const char* p = buf.data() + off;
+            uint32_t len = GetU32(p);
+            if (len < kRecordFixed || len > kMaxRecordLen || off + kRecordHeader + len > file_size) {
+                break;
+            }
+            if (Crc32c(p + kRecordHeader, len) != GetU32(p + 4)) {
+                break;
+            }
+            if (GetU64(p + kRecordHeader + 8) != expect) {
+                break;
+            }
+            seg->offsets.push_back(off);
+            terms_.push_back(GetU64(p + kRecordHeader));
+            off += kRecordHeader + len;
+            ++expect;
+        }
+        if (off != file_size) {
+            // 崩溃时的撕裂写：截掉不完整的尾部
+            std::cerr << "[RaftWal] " << path << ": invalid record at offset " << off << ", truncating "
+                      << (file_size - off) << " bytes" << std::endl;
+            if (::ftruncate(fd, static_cast<off_t>(off)) != 0 || ::fdatasync(fd) != 0) {
+                return SetError(error, "truncate " + path);
+            }
+            discard_rest = true;
+        }
+        seg->size = off;
+        segments_.push_back(std::move(seg));
+    }
+
+    durable_index_ = NextIndexLocked() - 1;
+    if (removed && !SyncDir()) {
+        return SetError(error, "fsync " + options_.dir);
+    }
+    return true;
+}
+
+/**
+ * @brief 读取 hardstate 两个槽位中 seq 较大的合法记录 (Open 中调用)
+ */
+bool RaftWal::LoadHardState(std::string* error) {
+    std::lock_guard<std::mutex> lock(hs_mtx_);
+    std::string path = options_.dir + "/" + kHardStateFile;
+    hs_fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (hs_fd_ < 0) {
+        return SetError(error, "open " + path);
+    }
+    char buf[2 * kHardStateSlot];
+    memset(buf, 0, sizeof(buf));
+    ssize_t n = ::pread(hs_fd_, buf, sizeof(buf), 0);
+    if (n < 0) {
+        return SetError(error, "read " + path);
+    }
+    if (n == 0 && !SyncDir()) {
+        return SetError(error, "fsync " + options_.dir);  // 新建的文件：目录项落盘
+    }
+
+    hs_seq_ = 0;
+    hard_state_ = HardState();
+    for (size_t slot = 0; slot < 2; ++slot) {
+        if (static_cast<size_t>(n) < slot * kHardStateSlot + kHardStateRecord) {
+            continue;
+        }
+        const char* p = buf + slot * kHardStateSlot;
+        if (GetU32(p) != kHardStateMagic || Crc32c(p, kHardStateRecord - 4) != GetU32(p + 24)) {
+            continue;
+        }
+        uint64_t seq = GetU64(p + 4);
+        if (seq > hs_seq_) {
+            hs_seq_ = seq;
+            hard_state_.current_term = GetU64(p + 12);
+            hard_state_.voted_for = static_cast<int32_t>(GetU32(p + 20));
+        }
+    }
+    return true;
+}
+
+bool RaftWal::SyncDir() {
+    int fd = ::open(options_.dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+void RaftWal::FailLocked(const char* what) {
+    std::cerr << "[RaftWal] " << what << " failed: " << strerror(errno) << ", WAL is now read-only" << std::endl;
+    failed_ = true;
+    durable_cv_.notify_all();
+    sync_cv_.notify_all();
+}
+
+// =========================================================
+//  PART 2: 追加与组提交
+// =========================================================
+
+RaftWal::SegmentPtr RaftWal::CreateSegmentLocked(uint64_t first_index) {
+    auto seg = std::make_shared<Segment>();
+    seg->path = options_.dir + "/" + SegmentName(first_index);
+    seg->first_index = first_index;
+    // O_TRUNC：同名文件只可能是之前截断 / 重置后残留的，内容作废
+    seg->fd = ::open(seg->path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (seg->fd < 0) {
+        FailLocked("create segment");
+        return nullptr;
+    }
+    segments_.push_back(seg);
+    dir_dirty_ = true;
+    return seg;
+}
+
+uint64_t RaftWal::Append(const std::vector<WalEntry>& entries) {
+    if (entries.empty()) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!opened_ || closing_ || failed_) {
+        return 0;
+    }
+    if (terms_.empty() && entries[0].index != first_index_ && !ResetLocked(entries[0].index)) {
+        return 0;
+    }
+    uint64_t next = NextIndexLocked();
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].index != next + i) {
+            std::cerr << "[RaftWal] non-contiguous append: expect " << (next + i) << " got " << entries[i].index
+                      << std::endl;
+            return 0;
+        }
+    }
+
+    SegmentPtr seg = segments_.empty() ? nullptr : segments_.back();
+    std::string buf;
+    auto flush = [&]() -> bool {
+        if (buf.empty()) {
+            return true;
+        }
+        if (!WriteAll(seg->fd, buf.data(), buf.size())) {
+            FailLocked("write");
+            return false;
+        }
+        seg->size += buf.size();
+        buf.clear();
+        return true;
+    };
+
+    for (const WalEntry& e : entries) {
+        size_t record = kRecordHeader + kRecordFixed + e.command.size();
+        // 当前段写满 (且至少有一条记录) 时滚动：先把缓冲写进旧段，旧段交给 sync 线程落盘
+        if (!seg || (!seg->offsets.empty() && seg->size + buf.size() + record > options_.segment_bytes)) {
+            if (seg) {
+                if (!flush()) {
+                    return 0;
+                }
+                unsynced_sealed_.push_back(seg);
+            }
+            seg = CreateSegmentLocked(e.index);
+            if (!seg) {
+                return 0;
+            }
+        }
+        seg->offsets.push_back(seg->size + buf.size());
+        EncodeRecord(e, &buf);
+        terms_.push_back(e.term);
+    }
+    if (!flush()) {
+        return 0;
+    }
+
+    uint64_t last = entries.back().index;
+    if (!options_.sync) {
+        durable_index_ = last;
+        unsynced_sealed_.clear();
+        durable_cv_.notify_all();
+    } else {
+        sync_cv_.notify_one();
+    }
+    return last;
+}
+
+bool RaftWal::WaitDurable(uint64_t index) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    // index 超出日志 (从未写入，或已被截断) 时不再等待
+    durable_cv_.wait(lock, [&]() {
+        return durable_index_ >= index || failed_ || !opened_ || index >= NextIndexLocked();
+    });
+    return durable_index_ >= index;
+}
+
+uint64_t RaftWal::AppendSync(const std::vector<WalEntry>& entries) {
+    uint64_t last = Append(entries);
+    if (last == 0 || !WaitDurable(last)) {
+        return 0;
+    }
+    return last;
+}
+
+/**
+ * @brief 组提交线程
+ * @details
+ * 每一轮记下当前已写入的最后 index，放锁后 fdatasync (期间新的 Append 照常写入，留给下一轮)，
+ * 完成后把 durable_index_ 推进到该 index。负载越高，一轮覆盖的提案越多。
+ */
+void RaftWal::SyncLoop() {
+    ThreadPlacement::GetInstance().PinCurrentThread(kPlacementRaft);
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (true) {
+        sync_cv_.wait(lock, [this]() { return closing_ || failed_ || NextIndexLocked() - 1 > durable_index_; });
+        if (failed_) {
+            break;
+        }
+        uint64_t target = NextIndexLocked() - 1;
+        if (target <= durable_index_) {
+            if (closing_) {
+                break;
+            }
+            continue;
+        }
+        uint64_t epoch = truncate_epoch_;
+        SegmentPtr active = segments_.back();
+        std::vector<SegmentPtr> sealed;
+        sealed.swap(unsynced_sealed_);
+        bool sync_dir = dir_dirty_;
+        dir_dirty_ = false;
+        lock.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        bool ok = true;
+        for (const SegmentPtr& seg : sealed) {
+            ok = ok && ::fdatasync(seg->fd) == 0;
+        }
+        ok = ok && ::fdatasync(active->fd) == 0;
+        ok = ok && (!sync_dir || SyncDir());
+        auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+        lock.lock();
+        if (!ok) {
+            FailLocked("fdatasync");
+            break;
+        }
+        // 期间发生过截断：target 之前的部分记录可能已被替换，这一轮不推进 (截断本身已同步落盘)
+        uint64_t covered = 0;
+        if (epoch == truncate_epoch_ && target > durable_index_) {
+            covered = target - durable_index_;
+            durable_index_ = target;
+        }
+        durable_cv_.notify_all();
+        if (sync_observer_ && covered > 0) {
+            lock.unlock();
+            sync_observer_(latency, covered);
+            lock.lock();
+        }
+    }
+    durable_cv_.notify_all();
+}
+
+// =========================================================
+//  PART 3: 读取
+// =========================================================
+
+RaftWal::SegmentPtr RaftWal::FindSegmentLocked(uint64_t index) const {
+    auto it = std::upper_bound(segments_.begin(), segments_.end(), index,
+                               [](uint64_t idx, const SegmentPtr& seg) { return idx < seg->first_index; });
+    if (it == segments_.begin()) {
+        return nullptr;
+    }
+    const SegmentPtr& seg = *(it - 1);
+    if (index - seg->first_index >= seg->offsets.size()) {
+        return nullptr;
+    }
+    return seg;
+}
+
+/**
+ * @brief 读取并校验 seg 中 [begin, end) 字节范围内的记录，第一条的 index 应为 index
+ */
+bool RaftWal::ReadRecords(const SegmentPtr& seg, uint64_t index, uint64_t begin, uint64_t end,
+                          std::vector<WalEntry>* out) const {
+    std::string buf(end - begin, '\0');
+    if (!PreadAll(seg->fd, &buf[0], buf.size(), begin)) {
+        return false;
+    }
+    size_t off = 0;
+    while (off < buf.size()) {
+        if (off + kRecordHeader + kRecordFixed > buf.size()) {
+            return false;
+        }
+        const char* p = buf.data() + off;
+        uint32_t len = GetU32(p);
+        if (len < kRecordFixed || off + kRecordHeader + len > buf.size() ||
+            Crc32c(p + kRecordHeader, len) != GetU32(p + 4) || GetU64(p + kRecordHeader + 8) != index) {
+            return false;  // 与并发的截断 / 覆盖写交错
+        }
+        WalEntry e;
+        e.term = GetU64(p + kRecordHeader);
+        e.index = index++;
+        e.command.assign(p + kRecordHeader + kRecordFixed, len - kRecordFixed);
+        out->push_back(std::move(e));
+        off += kRecordHeader + len;
+    }
+    return true;
+}
+
+size_t RaftWal::ReadRange(uint64_t from, size_t max_count, size_t max_bytes, std::vector<WalEntry>* out) const {
+    size_t total = 0;
+    size_t bytes = 0;
+    while (total < max_count && (total == 0 || bytes < max_bytes)) {
+        SegmentPtr seg;
+        uint64_t begin = 0, end = 0;
+        size_t count = 0;
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (!opened_ || from < first_index_ || from >= NextIndexLocked()) {
+                break;
+            }
+            seg = FindSegmentLocked(from);
+            if (!seg) {
+                break;
+            }
+            // 用相邻偏移算出每条记录的大小，按条数 / 字节数上限确定本段要读的范围
+            size_t i = from - seg->first_index;
+            begin = seg->offsets[i];
+            end = begin;
+            while (i < seg->offsets.size() && total + count < max_count && (total + count == 0 || bytes < max_bytes)) {
+                uint64_t next = (i + 1 < seg->offsets.size()) ? seg->offsets[i + 1] : seg->size;
+                bytes += next - end - kRecordHeader - kRecordFixed;
+                end = next;
+                ++i;
+                ++count;
+            }
+        }
+        if (!ReadRecords(seg, from, begin, end, out)) {
+            break;
+        }
+        total += count;
+        from += count;
+    }
+    return total;
+}
+
+bool RaftWal::Read(uint64_t index, WalEntry* out) const {
+    std::vector<WalEntry> entries;
+    if (ReadRange(index, 1, 0, &entries) != 1) {
+        return false;
+    }
+    *out = std::move(entries[0]);
+    return true;
+}
+
+uint64_t RaftWal::TermAt(uint64_t index) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (index < first_index_ || index >= NextIndexLocked()) {
+        return 0;
+    }
+    return terms_[index - first_index_];
+}
+
+uint64_t RaftWal::FirstIndex() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return first_index_;
+}
+
+uint64_t RaftWal::LastIndex() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return NextIndexLocked() - 1;
+}
+
+uint64_t RaftWal::DurableIndex() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return durable_index_;
+}
+
+// =========================================================
+//  PART 4: 截断 / 压缩 / 重置
+// =========================================================
+
+bool RaftWal::TruncateSuffix(uint64_t from) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!opened_ || failed_) {
+        return false;
+    }
+    if (from >= NextIndexLocked()) {
+        return true;
+    }
+    if (from <= first_index_) {
+        return ResetLocked(from);
+    }
+
+    SegmentPtr seg = FindSegmentLocked(from);
+    bool removed = false;
+    while (segments_.back() != seg) {
+        ::unlink(segments_.back()->path.c_str());
+        segments_.pop_back();
+        removed = true;
+    }
+    size_t keep = from - seg->first_index;
+    uint64_t new_size = seg->offsets[keep];
+    if (::ftruncate(seg->fd, static_cast<off_t>(new_size)) != 0 || (options_.sync && ::fdatasync(seg->fd) != 0)) {
+        FailLocked("truncate");
+        return false;
+    }
+    if (removed && options_.sync && !SyncDir()) {
+        FailLocked("fsync dir");
+        return false;
+    }
+    seg->offsets.resize(keep);
+    seg->size = new_size;
+    terms_.resize(from - first_index_);
+    ++truncate_epoch_;
+    durable_index_ = std::min(durable_index_, from - 1);
+    return true;
+}
+
+void RaftWal::CompactPrefix(uint64_t upto) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!opened_) {
+        return;
+    }
+    // 段 i 的全部 entry 都小于段 i+1 的 first_index，后者 <= upto 时段 i 可以删除
+    size_t remove = 0;
+    while (remove + 1 < segments_.size() && segments_[remove + 1]->first_index <= upto) {
+        ++remove;
+    }
+    if (remove == 0) {
+        return;
+    }
+    for (size_t i = 0; i < remove; ++i) {
+        ::unlink(segments_[i]->path.c_str());
+    }
+    uint64_t new_first = segments_[remove]->first_index;
+    terms_.erase(terms_.begin(), terms_.begin() + static_cast<std::ptrdiff_t>(new_first - first_index_));
+    segments_.erase(segments_.begin(), segments_.begin() + static_cast<std::ptrdiff_t>(remove));
+    first_index_ = new_first;
+}
+
+bool RaftWal::Reset(uint64_t next_index) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!opened_ || failed_) {
+        return false;
+    }
+    return ResetLocked(next_index);
+}
+
+bool RaftWal::ResetLocked(uint64_t next_index) {
+    bool removed = !segments_.empty();
+    for (const SegmentPtr& seg : segments_) {
+        ::unlink(seg->path.c_str());
+    }
+    segments_.clear();
+    unsynced_sealed_.clear();
+    terms_.clear();
+    first_index_ = std::max<uint64_t>(next_index, 1);
+    durable_index_ = first_index_ - 1;
+    ++truncate_epoch_;
+    if (removed && options_.sync && !SyncDir()) {
+        FailLocked("fsync dir");
+        return false;
+    }
+    return true;
+}
+
+// =========================================================
+//  PART 5: currentTerm / votedFor
+// =========================================================
+
+bool RaftWal::SaveHardState(const HardState& state) {
+    std::lock_guard<std::mutex> lock(hs_mtx_);
+    if (hs_fd_ < 0) {
+        return false;
+    }
+    uint64_t seq = hs_seq_ + 1;
+    char rec[kHardStateRecord];
+    PutU32(rec, kHardStateMagic);
+    PutU64(rec + 4, seq);
+    PutU64(rec + 12, state.current_term);
+    PutU32(rec + 20, static_cast<uint32_t>(state.voted_for));
+    PutU32(rec + 24, Crc32c(rec, kHardStateRecord - 4));
+
+    // 与上一次写不同的槽位：这次写撕裂时，Load 仍能读到上一份完整的记录
+    off_t offset = static_cast<off_t>((seq & 1) * kHardStateSlot);
+    if (::pwrite(hs_fd_, rec, sizeof(rec), offset) != static_cast<ssize_t>(sizeof(rec))) {
+        std::cerr << "[RaftWal] write hardstate failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (options_.sync && ::fdatasync(hs_fd_) != 0) {
+        std::cerr << "[RaftWal] fdatasync hardstate failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    hs_seq_ = seq;
+    hard_state_ = state;
+    return true;
+}
+
+HardState RaftWal::GetHardState() const {
+    std::lock_guard<std::mutex> lock(hs_mtx_);
+    return hard_state_;
+}
+
+} // namespace raft
@@ -0,0 +1,88 @@
+#include "range_load.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace raft {
+
+// =========================================================
+//  PART 1: 负载统计
+// =========================================================
+
+RangeLoadTracker::RangeLoadTracker(int half_life_ms, Clock::time_point now)
+    : half_life_ms_(std::max(half_life_ms, 1)), last_sample_(now) {}
+
+RangeLoadTracker::Snapshot RangeLoadTracker::Sample(Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    double dt_ms = std::chrono::duration<double, std::milli>(now - last_sample_).count();
+    if (dt_ms <= 0) {
+        return avg_;
+    }
+    // exchange 清零：两次采样之间的计数只被统计一次
+    double reads = static_cast<double>(reads_.exchange(0, std::memory_order_relaxed));
+    double writes = static_cast<double>(writes_.exchange(0, std::memory_order_relaxed));
+    double bytes = static_cast<double>(write_bytes_.exchange(0, std::memory_order_relaxed));
+    last_sample_ = now;
+
+    Snapshot rate;
+    rate.read_qps = reads * 1000.0 / dt_ms;
+    rate.write_qps = writes * 1000.0 / dt_ms;
+    rate.write_bytes_per_sec = bytes * 1000.0 / dt_ms;
+
+    // 采样间隔不固定：权重按经过的时间折算，半衰期之后旧值的权重剩一半
+    double alpha = has_sample_ ? 1.0 - std::exp2(-dt_ms / half_life_ms_) : 1.0;
+    has_sample_ = true;
+    avg_.read_qps += alpha * (rate.read_qps - avg_.read_qps);
+    avg_.write_qps += alpha * (rate.write_qps - avg_.write_qps);
+    avg_.write_bytes_per_sec += alpha * (rate.write_bytes_per_sec - avg_.write_bytes_per_sec);
+    return avg_;
+}
+
+RangeLoadTracker::Snapshot RangeLoadTracker::Current() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return avg_;
+}
+
+void RangeLoadTracker::Halve() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    avg_.read_qps /= 2;
+    avg_.write_qps /= 2;
+    avg_.write_bytes_per_sec /= 2;
+}
+
+// =========================================================
+//  PART 2: 分裂
+// =========================================================
+
+SplitReason ShouldSplit(const SplitPolicy& policy, uint64_t bytes, uint64_t keys, double qps,
+                        int64_t since_last_split_ms) {
+    if (keys < std::max<uint64_t>(policy.min_keys, 2) || since_last_split_ms < policy.min_interval_ms) {
+        return SplitReason::kNone;
+    }
+    if (policy.max_bytes > 0 && bytes >= policy.max_bytes) {
+        return SplitReason::kSize;
+    }
+    if (policy.max_qps > 0 && qps >= policy.max_qps) {
+        return SplitReason::kLoad;
+    }
+    return SplitReason::kNone;
+}
+
+bool SplitDescriptor(const RangeDescriptor& range, const std::string& split_key, uint64_t new_group_id,
+                     RangeDescriptor* left, RangeDescriptor* right) {
+    if (split_key <= range.start_key || !range.Contains(split_key) || new_group_id == range.group_id) {
+        return false;
+    }
+    RangeDescriptor l = range;
+    RangeDescriptor r = range;
+    l.end_key = split_key;
+    l.epoch = range.epoch + 1;
+    r.group_id = new_group_id;
+    r.start_key = split_key;
+    r.epoch = range.epoch + 1;
+    *left = std::move(l);
+    *right = std::move(r);
+    return true;
+}
+
+} // namespace raft
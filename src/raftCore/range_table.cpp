@@ -0,0 +1,181 @@
+#include "range_table.h"
+
+#include <mutex>
+
+#include "opCodec.h"  // varint / 长度前缀编码
+
+namespace raft {
+
+// =========================================================
+//  PART 1: 描述编解码
+// =========================================================
+/*
+ * 格式：version u8 | group_id varint | epoch varint | start_key lp | end_key lp
+ *       | replica_count varint | replica varint ...
+ */
+static constexpr uint8_t kRangeDescriptorVersion = 1;
+
+std::string EncodeRangeDescriptor(const RangeDescriptor& desc) {
+    std::string out;
+    out.push_back(static_cast<char>(kRangeDescriptorVersion));
+    PutVarint64(out, desc.group_id);
+    PutVarint64(out, desc.epoch);
+    PutLengthPrefixed(out, desc.start_key);
+    PutLengthPrefixed(out, desc.end_key);
+    PutVarint64(out, desc.replicas.size());
+    for (int32_t node : desc.replicas) {
+        PutVarint64(out, static_cast<uint32_t>(node));
+    }
+    return out;
+}
+
+bool DecodeRangeDescriptor(std::string_view in, RangeDescriptor* desc) {
+    if (in.empty() || static_cast<uint8_t>(in[0]) != kRangeDescriptorVersion) {
+        return false;
+    }
+    in.remove_prefix(1);
+
+    std::string_view start, end;
+    uint64_t count = 0;
+    if (!GetVarint64(in, &desc->group_id) || !GetVarint64(in, &desc->epoch) ||
+        !GetLengthPrefixed(in, &start) || !GetLengthPrefixed(in, &end) ||
+        !GetVarint64(in, &count) || count > in.size()) {
+        return false;
+    }
+    desc->start_key.assign(start.data(), start.size());
+    desc->end_key.assign(end.data(), end.size());
+    desc->replicas.clear();
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t node = 0;
+        if (!GetVarint64(in, &node)) {
+            return false;
+        }
+        desc->replicas.push_back(static_cast<int32_t>(node));
+    }
+    return in.empty();
+}
+
+// =========================================================
+//  PART 2: 路由表
+// =========================================================
+
+// [a.start, a.end) 与 [b.start, b.end) 是否相交 (end 为空表示 +inf)
+static bool Overlaps(const RangeDescriptor& a, const RangeDescriptor& b) {
+    return (b.end_key.empty() || a.start_key < b.end_key) && (a.end_key.empty() || b.start_key < a.end_key);
+}
+
+static bool Valid(const RangeDescriptor& desc) {
+    return desc.end_key.empty() || desc.start_key < desc.end_key;
+}
+
+RangeTable::RangeMap::iterator RangeTable::EraseLocked(RangeMap::iterator it) {
+    by_group_.erase(it->second.group_id);
+    return ranges_.erase(it);
+}
+
+RangeTable::Status RangeTable::Update(const RangeDescriptor& desc) {
+    if (!Valid(desc)) {
+        return Status::kInvalid;
+    }
+    std::unique_lock<std::shared_mutex> lock(mtx_);
+
+    // 1. 同组的旧描述
+    auto own = by_group_.find(desc.group_id);
+    if (own != by_group_.end()) {
+        auto it = ranges_.find(own->second);
+        if (it->second.epoch >= desc.epoch) {
+            return Status::kStale;
+        }
+        EraseLocked(it);
+    }
+
+    // 2. 被新区间覆盖的其他组：从可能与 start_key 相交的那个区间开始向后扫
+    auto it = ranges_.upper_bound(desc.start_key);
+    if (it != ranges_.begin()) {
+        --it;
+    }
+    while (it != ranges_.end() && (desc.end_key.empty() || it->first < desc.end_key)) {
+        if (Overlaps(it->second, desc)) {
+            it = EraseLocked(it);
+        } else {
+            ++it;
+        }
+    }
+
+    ranges_.emplace(desc.start_key, desc);
+    by_group_[desc.group_id] = desc.start_key;
+    return Status::kOk;
+}
+
+bool RangeTable::Reset(const std::vector<RangeDescriptor>& descs) {
+    RangeMap ranges;
+    std::unordered_map<uint64_t, std::string> by_group;
+    for (const RangeDescriptor& desc : descs) {
+        if (!Valid(desc) || !by_group.emplace(desc.group_id, desc.start_key).second ||
+            !ranges.emplace(desc.start_key, desc).second) {
+            return false;
+        }
+    }
+    // 按 start_key 有序后，只需检查相邻区间
+    const RangeDescriptor* prev = nullptr;
+    for (const auto& kv : ranges) {
+        if (prev && (prev->end_key.empty() || kv.first < prev->end_key)) {
+            return false;
+        }
+        prev = &kv.second;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mtx_);
+    ranges_.swap(ranges);
+    by_group_.swap(by_group);
+    return true;
+}
+
+void RangeTable::Remove(uint64_t group_id) {
+    std::unique_lock<std::shared_mutex> lock(mtx_);
+    auto own = by_group_.find(group_id);
+    if (own != by_group_.end()) {
+        EraseLocked(ranges_.find(own->second));
+    }
+}
+
+bool RangeTable::Locate(std::string_view key, RangeDescriptor* desc) const {
+    std::shared_lock<std::shared_mutex> lock(mtx_);
+    auto it = ranges_.upper_bound(key);  // 第一个 start_key > key
+    if (it == ranges_.begin()) {
+        return false;
+    }
+    --it;
+    if (!it->second.Contains(key)) {
+        return false;
+    }
+    *desc = it->second;
+    return true;
+}
+
+bool RangeTable::Get(uint64_t group_id, RangeDescriptor* desc) const {
+    std::shared_lock<std::shared_mutex> lock(mtx_);
+    auto own = by_group_.find(group_id);
+    if (own == by_group_.end()) {
+        return false;
+    }
+    *desc = ranges_.find(own->second)->second;
+    return true;
+}
+
+std::vector<RangeDescriptor> RangeTable::All() const {
+    std::shared_lock<std::shared_mutex> lock(mtx_);
+    std::vector<RangeDescriptor> out;
+    out.reserve(ranges_.size());
+    for (const auto& kv : ranges_) {
+        out.push_back(kv.second);
+    }
+    return out;
+}
+
+size_t RangeTable::Size() const {
+    std::shared_lock<std::shared_mutex> lock(mtx_);
+    return ranges_.size();
+}
+
+} // namespace raft
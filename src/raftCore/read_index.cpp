@@ -0,0 +1,185 @@
+#include "read_index.h"
+
+#include <algorithm>
+
+namespace raft {
+
+// =========================================================
+//  PART 1: Raft 核心驱动的状态
+// =========================================================
+
+ReadIndex::ReadIndex(ReadIndexHost* host, const ReadIndexConfig& config)
+    : host_(host), config_(config) {
+    config_.round_retry_ms = std::max(config_.round_retry_ms, 1);
+    int lease_ms = std::max(config_.election_timeout_min_ms - config_.clock_drift_ms, 0);
+    lease_duration_ = std::chrono::milliseconds(lease_ms);
+    confirmed_at_ = requested_at_ = lease_until_ = Clock::time_point::min();
+}
+
+void ReadIndex::BecomeLeader(uint64_t term) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        leader_ = true;
+        term_ = term;
+        term_committed_ = false;  // 等本任期的 no-op 提交
+        round_inflight_ = false;
+        confirmed_at_ = requested_at_ = lease_until_ = Clock::time_point::min();
+    }
+    cv_.notify_all();
+}
+
+void ReadIndex::StepDown() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        leader_ = false;
+        term_committed_ = false;
+        round_inflight_ = false;
+        lease_until_ = Clock::time_point::min();
+    }
+    cv_.notify_all();
+}
+
+void ReadIndex::OnCommit(uint64_t commit_index, uint64_t commit_term) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        commit_index_ = std::max(commit_index_, commit_index);
+        if (leader_ && commit_term == term_) {
+            term_committed_ = true;
+        }
+    }
+    cv_.notify_all();
+}
+
+void ReadIndex::OnApplied(uint64_t applied_index) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (applied_index <= applied_index_) {
+            return;
+        }
+        applied_index_ = applied_index;
+    }
+    cv_.notify_all();
+}
+
+void ReadIndex::OnQuorumAck(uint64_t term, Clock::time_point sent_at) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!LeaderOfLocked(term) || sent_at <= confirmed_at_) {
+            return;
+        }
+        confirmed_at_ = sent_at;
+        if (round_inflight_ && sent_at >= requested_at_) {
+            round_inflight_ = false;
+        }
+        if (config_.lease_read) {
+            lease_until_ = std::max(lease_until_, sent_at + lease_duration_);
+        }
+    }
+    cv_.notify_all();
+}
+
+// =========================================================
+//  PART 2: 读请求
+// =========================================================
+
+ReadIndex::Status ReadIndex::WaitReadable(int timeout_ms, uint64_t* read_index) {
+    const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+    std::unique_lock<std::mutex> lock(mtx_);
+    uint64_t index = 0;
+    bool lease = false;
+    Status status = ConfirmLocked(lock, deadline, &index, &lease);
+    if (status != Status::kOk) {
+        return status;
+    }
+
+    // 4. 等状态机追上 read index (领导权已确认，之后再退位也不影响这次读的正确性)
+    if (!cv_.wait_until(lock, deadline, [&]() { return applied_index_ >= index; })) {
+        return Status::kTimeout;
+    }
+    ++stats_.reads;
+    if (lease) {
+        ++stats_.lease_reads;
+    }
+    if (read_index) {
+        *read_index = index;
+    }
+    return Status::kOk;
+}
+
+ReadIndex::Status ReadIndex::ConfirmReadIndex(int timeout_ms, uint64_t* read_index) {
+    const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+    std::unique_lock<std::mutex> lock(mtx_);
+    bool lease = false;
+    Status status = ConfirmLocked(lock, deadline, read_index, &lease);
+    if (status == Status::kOk) {
+        ++stats_.remote_reads;
+    }
+    return status;
+}
+
+/**
+ * @brief 第 1 - 3 步：得到一个领导权已确认的 read index
+ */
+ReadIndex::Status ReadIndex::ConfirmLocked(std::unique_lock<std::mutex>& lock, Clock::time_point deadline,
+                                           uint64_t* read_index, bool* lease) {
+    const Clock::duration retry = std::chrono::milliseconds(config_.round_retry_ms);
+    if (!leader_) {
+        return Status::kNotLeader;
+    }
+    const uint64_t term = term_;
+
+    // 1. 本任期提交过日志之后，commit_index_ 才不落后于之前任何领导人确认过的写
+    if (!cv_.wait_until(lock, deadline, [&]() { return !LeaderOfLocked(term) || term_committed_; })) {
+        return Status::kTimeout;
+    }
+    if (!LeaderOfLocked(term)) {
+        return Status::kNotLeader;
+    }
+
+    // 2. read index
+    *read_index = commit_index_;
+    const Clock::time_point recorded = Clock::now();
+    *lease = config_.lease_read && recorded < lease_until_;
+
+    // 3. 确认领导权：需要一轮在 recorded 之后发出的心跳被多数派确认
+    while (!*lease && confirmed_at_ < recorded) {
+        if (!LeaderOfLocked(term)) {
+            return Status::kNotLeader;
+        }
+        Clock::time_point now = Clock::now();
+        if (now >= deadline) {
+            return Status::kTimeout;
+        }
+        // 没有在途的一轮 (或在途那轮发得比我们早)：发起新一轮，之后到达的读都搭这一轮；
+        // 在途那轮发得比我们晚：等它；在途太久 (丢包 / follower 卡顿)：重发
+        bool need_round = round_inflight_ ? (now - requested_at_ >= retry) : (requested_at_ < recorded);
+        if (need_round) {
+            requested_at_ = now;
+            round_inflight_ = true;
+            ++stats_.rounds;
+            lock.unlock();
+            host_->BroadcastHeartbeat();
+            lock.lock();
+            continue;
+        }
+        cv_.wait_until(lock, round_inflight_ ? std::min(deadline, requested_at_ + retry) : deadline);
+    }
+    return Status::kOk;
+}
+
+bool ReadIndex::LeaseValid() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return config_.lease_read && leader_ && term_committed_ && Clock::now() < lease_until_;
+}
+
+bool ReadIndex::TermCommitted() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return leader_ && term_committed_;
+}
+
+ReadIndexStats ReadIndex::GetStats() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return stats_;
+}
+
+} // namespace raft
@@ -0,0 +1,145 @@
+#include "replication_window.h"
+
+#include <algorithm>
+
+namespace raft {
+
+ReplicationWindow::ReplicationWindow(const ReplicationWindowConfig& config) : config_(config) {
+    config_.max_inflight = std::max<size_t>(config_.max_inflight, 1);
+    config_.max_batch_entries = std::max<size_t>(config_.max_batch_entries, 1);
+}
+
+void ReplicationWindow::Restart(uint64_t next_index) {
+    paused_for_snapshot_ = false;
+    match_index_ = 0;
+    Reset(next_index);
+}
+
+void ReplicationWindow::Reset(uint64_t next_index) {
+    generation_++;
+    inflight_.clear();
+    next_index_ = std::max<uint64_t>(next_index, 1);
+    probing_ = true;
+    stalled_ = false;
+    has_first_pending_ = true;  // 回退后立即重发，不再等待 linger
+    first_pending_ = Clock::time_point();
+}
+
+void ReplicationWindow::ResetAfterSnapshot(uint64_t last_included_index) {
+    paused_for_snapshot_ = false;
+    match_index_ = std::max(match_index_, last_included_index);
+    Reset(last_included_index + 1);
+}
+
+void ReplicationWindow::Invalidate() {
+    generation_++;
+    inflight_.clear();
+}
+
+void ReplicationWindow::MarkPending(Clock::time_point now) {
+    stalled_ = false;
+    if (!has_first_pending_) {
+        has_first_pending_ = true;
+        first_pending_ = now;
+    }
+}
+
+ReplicationWindow::Decision ReplicationWindow::Next(Clock::time_point now, uint64_t first_index,
+                                                    uint64_t last_index) {
+    Decision decision;
+    if (paused_for_snapshot_ || inflight_.size() >= Window()) {
+        return decision;
+    }
+    if (last_index < next_index_) {
+        has_first_pending_ = false;
+        return decision;
+    }
+    if (next_index_ < first_index) {
+        paused_for_snapshot_ = true;
+        decision.action = Action::kNeedSnapshot;
+        return decision;
+    }
+    if (stalled_) {
+        return decision;
+    }
+    if (last_index - next_index_ + 1 >= config_.max_batch_entries) {
+        decision.action = Action::kSend;  // 攒满一批，立即发送
+        return decision;
+    }
+    if (!has_first_pending_) {
+        // 未经 MarkPending 发现的新日志 (例如刚 Restart)：从现在开始计时
+        has_first_pending_ = true;
+        first_pending_ = now;
+    }
+    Clock::time_point deadline = first_pending_ + std::chrono::microseconds(config_.linger_us);
+    if (now >= deadline) {
+        decision.action = Action::kSend;
+    } else {
+        decision.action = Action::kWaitUntil;
+        decision.deadline = deadline;
+    }
+    return decision;
+}
+
+ReplicationWindow::Batch ReplicationWindow::OnSent(size_t count) {
+    Batch batch;
+    batch.generation = generation_;
+    batch.prev_index = next_index_ - 1;
+    batch.last_index = batch.prev_index + count;
+    inflight_.push_back(batch);
+    next_index_ = batch.last_index + 1;  // 乐观推进，下一批紧接着发
+    has_first_pending_ = false;
+    return batch;
+}
+
+void ReplicationWindow::OnEmptyCopy() {
+    stalled_ = true;
+    has_first_pending_ = false;
+}
+
+ReplicationWindow::ReplyResult ReplicationWindow::OnReply(uint64_t generation, uint64_t last_index,
+                                                          const ReplicationReply& reply, uint64_t current_term,
+                                                          const LastIndexOfTerm& last_index_of_term) {
+    // 1. 发现更高任期：交给 Raft 核心退位，窗口只让在途批次失效
+    if (reply.ok && reply.term > current_term) {
+        Invalidate();
+        return ReplyResult::kHigherTerm;
+    }
+
+    if (reply.ok && reply.success) {
+        // 2. 成功：即便来自旧 generation，follower 确实已经持有这些日志，仍可推进 match_index
+        bool advanced = last_index > match_index_;
+        if (advanced) {
+            match_index_ = last_index;
+        }
+        while (!inflight_.empty() && inflight_.front().last_index <= match_index_) {
+            inflight_.pop_front();
+        }
+        if (generation == generation_) {
+            probing_ = false;  // 探测成功，恢复流水线
+        }
+        return advanced ? ReplyResult::kMatchAdvanced : ReplyResult::kAcked;
+    }
+
+    // 3. 失败：只有当前 generation 的失败才回退 (旧 generation 的在 Reset 时已经处理过)
+    if (generation != generation_) {
+        return ReplyResult::kStale;
+    }
+    uint64_t next;
+    if (!reply.ok) {
+        // RPC 失败/超时：从已确认的位置重新探测
+        next = match_index_ + 1;
+    } else if (reply.conflict_term != 0) {
+        // follower 在 conflictIndex 处的任期为 conflictTerm：
+        // 领导人有该任期则跳到该任期最后一条之后，否则跳到 follower 该任期的第一条
+        uint64_t last_of_term = last_index_of_term ? last_index_of_term(reply.conflict_term) : 0;
+        next = last_of_term > 0 ? last_of_term + 1 : reply.conflict_index;
+    } else {
+        // follower 日志太短：conflictIndex 是它的日志长度 + 1
+        next = reply.conflict_index;
+    }
+    Reset(std::max(next, match_index_ + 1));
+    return ReplyResult::kRewound;
+}
+
+} // namespace raft
@@ -1,10 +1,28 @@
 #pragma once
 
 #include <grpcpp/grpcpp.h>
+#include <sys/types.h>
 #include <memory>
 #include <functional>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include "latency_tracker.h"
+#include "metrics.h"
 #include "raft.grpc.pb.h"
+#include "trace.h"
+#include "util.h"  // Op / OpView
+
+namespace monsoon {
+class Scheduler;
+}
 
 namespace raft {
 
@@ -23,14 +41,74 @@ struct AsyncClientCall {
     // 用于协程唤醒
     void* fiber_tag = nullptr;  // 指向 monsoon::Fiber::ptr
     RpcCallback<Reply> callback;
+
+    // 发起调用的调度器与线程下标 (发起方不在协程线程中时为 nullptr / -1)
+    monsoon::Scheduler* scheduler = nullptr;
+    int thread = -1;
+
+    // 完成时把往返时间计入该 peer 的延迟分布 (为空表示不统计)
+    std::shared_ptr<LatencyTracker> latency;
+    std::chrono::steady_clock::time_point start_time;
+    // 成功调用的往返时间写入导出的直方图 (为空表示不导出)，与 latency 共用 start_time
+    MetricHistogram* rtt = nullptr;
     
     AsyncClientCall() = default;
     ~AsyncClientCall() = default;
 };
 
+// ========== 异步 RPC 引擎 (CompletionQueue 池) ==========
+
+/**
+ * @brief RpcSystem 参数，必须在第一次发起异步 RPC 之前通过 ConfigureRpcSystem 设置
+ */
+struct RpcSystemConfig {
+    size_t cq_num = RAFT_RPC_CQ_NUM;                       // CompletionQueue / Poller 线程个数，0 表示按 CPU 核数
+    bool resume_on_caller = RAFT_RPC_RESUME_ON_CALLER;     // 回调与协程唤醒投递回发起线程，而不是在 Poller 线程执行
+};
+
+/**
+ * @brief 配置全局 RpcSystem
+ * @return RpcSystem 已经启动 (已有 RPC 发出) 时配置不再生效，返回 false
+ */
+bool ConfigureRpcSystem(const RpcSystemConfig& config);
+
+// ========== 流式快照传输 ==========
+
+/**
+ * @brief 快照元数据，随第一个 SnapshotChunk 发送
+ */
+struct SnapshotMeta {
+    uint64_t term = 0;
+    int32_t leader_id = 0;
+    uint64_t last_included_index = 0;
+    uint64_t last_included_term = 0;
+    uint64_t total_size = 0;
+    uint64_t group_id = 0;       // Multi-Raft：快照所属的 Raft 组
+};
+
+/**
+ * @brief 按偏移读取快照数据 (pread 语义)
+ * @return 实际读取字节数，0 表示 EOF，< 0 表示出错
+ * 需要支持任意 offset 读取，断点续传时会从 follower 返回的 nextOffset 处重新读
+ */
+using SnapshotChunkReader = std::function<ssize_t(uint64_t offset, char* buf, size_t len)>;
+
+/**
+ * @brief 流式快照传输参数
+ */
+struct SnapshotStreamConfig {
+    size_t chunk_size = 1024 * 1024;     // 每块大小，必须远小于 gRPC max_message_size
+    int chunk_timeout_ms = 2000;         // 单块的时间预算，整个流的 deadline = 块数 * 该值
+    int max_retries = 3;                 // 传输失败后断点续传的次数
+    uint64_t max_bytes_per_sec = 0;      // 发送限速，0 表示不限速
+};
+
 // ========== Raft RPC 客户端（用于发送RPC到其他节点）==========
 class RaftRpcClient {
 public:
+    // timeout_ms 取该值 (或任意 <= 0 的值) 时按该 peer 最近的延迟分布自适应，见 EffectiveTimeoutMs
+    static constexpr int kAdaptiveTimeout = 0;
+
     /**
      * @brief 构造函数
      * @param target 目标节点地址，格式: "ip:port"
@@ -44,13 +122,13 @@ public:
      * @param args 请求参数
      * @param callback 完成回调
      * @param fiber_tag 协程标记（用于协程唤醒）
-     * @param timeout_ms 超时时间（毫秒）
+     * @param timeout_ms 超时时间（毫秒），默认自适应
      */
     void AsyncRequestVote(
         const raftRpcProctoc::RequestVoteArgs& args,
         RpcCallback<raftRpcProctoc::RequestVoteReply> callback,
         void* fiber_tag = nullptr,
-        int timeout_ms = 100
+        int timeout_ms = kAdaptiveTimeout
     );
     
     /**
@@ -60,7 +138,7 @@ public:
         const raftRpcProctoc::AppendEntriesArgs& args,
         RpcCallback<raftRpcProctoc::AppendEntriesReply> callback,
         void* fiber_tag = nullptr,
-        int timeout_ms = 100
+        int timeout_ms = kAdaptiveTimeout
     );
     
     /**
@@ -73,13 +151,76 @@ public:
         int timeout_ms = 1000  // 快照传输超时时间长一些
     );
     
+    /**
+     * @brief 异步向领导人要 read index (follower 读回退)
+     * @details 领导人需要一轮心跳确认领导权，timeout_ms 至少应覆盖一个 RTT
+     */
+    void AsyncReadIndex(
+        const raftRpcProctoc::ReadIndexArgs& args,
+        RpcCallback<raftRpcProctoc::ReadIndexReply> callback,
+        void* fiber_tag = nullptr,
+        int timeout_ms = 200
+    );
+
+    /**
+     * @brief 异步发送合并心跳 (Multi-Raft：本节点领导的、对端是 follower 的所有组，见 HeartbeatCoalescer)
+     */
+    void AsyncNodeHeartbeat(
+        const raftRpcProctoc::NodeHeartbeatArgs& args,
+        RpcCallback<raftRpcProctoc::NodeHeartbeatReply> callback,
+        void* fiber_tag = nullptr,
+        int timeout_ms = kAdaptiveTimeout
+    );
+
+    /**
+     * @brief 异步发送 TimeoutNow：领导权转移的最后一步，目标日志已追平，让它立即发起选举
+     */
+    void AsyncTimeoutNow(
+        const raftRpcProctoc::TimeoutNowArgs& args,
+        RpcCallback<raftRpcProctoc::TimeoutNowReply> callback,
+        void* fiber_tag = nullptr,
+        int timeout_ms = kAdaptiveTimeout
+    );
+
+    /**
+     * @brief 流式发送快照 (阻塞直到传输完成或重试耗尽)
+     * @param meta 快照元数据
+     * @param reader 快照数据读取器，通常由 MakeFdChunkReader 绑定到 dump_snapshot_to_fd 生成的文件
+     * @param reply follower 的响应；reply->term() 大于 meta.term 时调用方应退位
+     * @details
+     * 1. 按 chunk_size 分块写入 client-streaming 调用，每次 Write 都受 HTTP/2 流控约束：
+     *    follower 消费不过来时 Write 会阻塞，内存中最多只有一块数据 (逐块背压)；
+     * 2. follower 发现 offset 与自己已落盘的字节数不一致时会提前结束流，并在 nextOffset 中
+     *    告知正确位置；连接中断等失败也会按 nextOffset 重新开流，从断点继续发送。
+     * @return follower 接受快照 (accepted) 或任期更高 (需要退位) 时返回 true
+     */
+    bool InstallSnapshotStream(
+        const SnapshotMeta& meta,
+        const SnapshotChunkReader& reader,
+        raftRpcProctoc::InstallSnapshotReply* reply,
+        const SnapshotStreamConfig& config = SnapshotStreamConfig()
+    );
+
+    /**
+     * @brief 异步流式发送快照：在独立线程中执行 InstallSnapshotStream，完成后回调并唤醒协程
+     * @details 线程归客户端所有：客户端析构时取消正在进行的流并 join (回调收到 success = false)，
+     * 不会在客户端释放后继续访问 stub_
+     */
+    void AsyncInstallSnapshotStream(
+        const SnapshotMeta& meta,
+        SnapshotChunkReader reader,
+        RpcCallback<raftRpcProctoc::InstallSnapshotReply> callback,
+        void* fiber_tag = nullptr,
+        const SnapshotStreamConfig& config = SnapshotStreamConfig()
+    );
+    
     /**
      * @brief 同步发送投票请求（用于测试或简单场景）
      */
     bool RequestVote(
         const raftRpcProctoc::RequestVoteArgs& args,
         raftRpcProctoc::RequestVoteReply* reply,
-        int timeout_ms = 100
+        int timeout_ms = kAdaptiveTimeout
     );
     
     /**
@@ -88,19 +229,75 @@ public:
     bool AppendEntries(
         const raftRpcProctoc::AppendEntriesArgs& args,
         raftRpcProctoc::AppendEntriesReply* reply,
-        int timeout_ms = 100
+        int timeout_ms = kAdaptiveTimeout
     );
     
+    /**
+     * @brief 同步 ReadIndex (FollowerRead 的 ReadIndexFetcher 在读线程中直接调用)
+     */
+    bool ReadIndex(
+        const raftRpcProctoc::ReadIndexArgs& args,
+        raftRpcProctoc::ReadIndexReply* reply,
+        int timeout_ms = 200
+    );
+
+    /**
+     * @brief 同步请求领导权转移 (运维工具 / 负载均衡调用，发给当前领导人)
+     * @details 领导人会阻塞到转移完成或 RAFT_TRANSFER_TIMEOUT_MS，timeout_ms 应比它长
+     */
+    bool TransferLeadership(
+        const raftRpcProctoc::TransferLeadershipArgs& args,
+        raftRpcProctoc::TransferLeadershipReply* reply,
+        int timeout_ms = 2000
+    );
+
+    /**
+     * @brief 同步请求成员变更 (运维工具调用，发给当前领导人)
+     * @details 领导人阻塞到新配置提交 (joint 变更要提交两条配置日志)，timeout_ms 应覆盖两轮复制
+     */
+    bool ChangeMembership(
+        const raftRpcProctoc::ChangeMembershipArgs& args,
+        raftRpcProctoc::ChangeMembershipReply* reply,
+        int timeout_ms = 5000
+    );
+
     /**
      * @brief 检查连接是否可用
      */
     bool IsAvailable() const;
+
+    /**
+     * @brief 本次调用实际使用的超时
+     * @details timeout_ms > 0 时原样返回；否则为 clamp(p99 * RAFT_RPC_TIMEOUT_P99_MULTIPLIER,
+     * RAFT_RPC_MIN_TIMEOUT_MS, RAFT_RPC_MAX_TIMEOUT_MS)，样本不足时为 RAFT_RPC_TIMEOUT_MS。
+     * 同机房的 peer 超时收紧到几十毫秒，卡住的 peer 不再每次都占满 100ms；跨地域的 peer 不会被误判超时。
+     */
+    int EffectiveTimeoutMs(int timeout_ms) const;
+
+    // 投票 / 日志复制 / 心跳 / TimeoutNow 的往返时间 (成功或超时的调用)
+    const LatencyTracker& Latency() const { return *latency_; }
     
 private:
     std::shared_ptr<grpc::Channel> channel_;
     std::unique_ptr<raftRpcProctoc::RaftRpcService::Stub> stub_;
+    // 该 peer 固定使用的 CQ 分片 (按 target 哈希)，同一 peer 的回复由同一个 Poller 处理
+    size_t shard_ = 0;
+    std::shared_ptr<LatencyTracker> latency_ = std::make_shared<LatencyTracker>();
+    // raft_append_entries_rtt_microseconds{peer=target}
+    MetricHistogram* append_rtt_ = nullptr;
     
-    // 设置超时
+    // 流式快照的发送线程 (finished 后由下一次 AsyncInstallSnapshotStream 回收，析构时全部 join)
+    struct SnapshotTransfer {
+        std::thread thread;
+        bool finished = false;
+    };
+    std::mutex transfer_mutex_;                        // 保护以下成员
+    std::condition_variable transfer_cv_;              // 限速等待可被析构打断
+    bool closing_ = false;                             // 析构中：不再开新流
+    std::list<SnapshotTransfer> transfers_;
+    std::set<grpc::ClientContext*> stream_contexts_;   // 正在进行的流，析构时 TryCancel
+
+    // 设置超时 (timeout_ms <= 0 时自适应)
     void SetDeadline(grpc::ClientContext* context, int timeout_ms);
 };
 
@@ -109,9 +306,28 @@ class RaftRpcServiceImpl final : public raftRpcProctoc::RaftRpcService::Service
 public:
     /**
      * @brief 构造函数
-     * @param raft_node Raft节点指针（实际处理逻辑在Raft类中）
+     * @param raft_node Raft节点指针（实际处理逻辑在Raft类中），注册为默认组 (groupId = 0)
      */
     explicit RaftRpcServiceImpl(void* raft_node);
+
+    // ========== Multi-Raft 组路由 ==========
+
+    // 读取组的当前任期 (由 Raft 核心提供，需线程安全)
+    using TermAccessor = std::function<uint64_t()>;
+
+    /**
+     * @brief 注册 / 替换一个 Raft 组，之后带该 groupId 的请求都路由到 raft_node
+     * @details 可以在服务运行中调用 (分裂产生新组、副本迁入)
+     * @param current_term 组的当前任期，快照流据此拒绝旧领导人的残留流；为空时不做任期检查
+     *        (构造函数注册的默认组也没有，需要时用同一 groupId 重新注册)
+     */
+    void RegisterGroup(uint64_t group_id, void* raft_node, TermAccessor current_term = nullptr);
+
+    /**
+     * @brief 注销一个 Raft 组 (副本迁出 / 合并)，之后的请求返回 NOT_FOUND
+     * @details 调用方要保证已经在处理的请求结束后再销毁 Raft 实例
+     */
+    void UnregisterGroup(uint64_t group_id);
     
     // gRPC 服务接口实现
     grpc::Status RequestVote(
@@ -131,9 +347,81 @@ public:
         const raftRpcProctoc::InstallSnapshotArgs* request,
         raftRpcProctoc::InstallSnapshotReply* reply
     ) override;
+
+    grpc::Status ReadIndex(
+        grpc::ServerContext* context,
+        const raftRpcProctoc::ReadIndexArgs* request,
+        raftRpcProctoc::ReadIndexReply* reply
+    ) override;
+
+    /**
+     * @brief 合并心跳：在一个协程里依次交给各组处理，本节点没有的组回复 success = false
+     */
+    grpc::Status NodeHeartbeat(
+        grpc::ServerContext* context,
+        const raftRpcProctoc::NodeHeartbeatArgs* request,
+        raftRpcProctoc::NodeHeartbeatReply* reply
+    ) override;
+
+    grpc::Status TimeoutNow(
+        grpc::ServerContext* context,
+        const raftRpcProctoc::TimeoutNowArgs* request,
+        raftRpcProctoc::TimeoutNowReply* reply
+    ) override;
+
+    grpc::Status TransferLeadership(
+        grpc::ServerContext* context,
+        const raftRpcProctoc::TransferLeadershipArgs* request,
+        raftRpcProctoc::TransferLeadershipReply* reply
+    ) override;
+
+    grpc::Status ChangeMembership(
+        grpc::ServerContext* context,
+        const raftRpcProctoc::ChangeMembershipArgs* request,
+        raftRpcProctoc::ChangeMembershipReply* reply
+    ) override;
+
+    /**
+     * @brief 流式接收快照
+     * @details 数据按 offset 写入 spool 文件，已落盘的字节数在连接中断后保留，
+     * 领导人重新开流时据此断点续传；收到 done 块后 fsync 并把文件交给 Raft 核心安装。
+     */
+    grpc::Status InstallSnapshotStream(
+        grpc::ServerContext* context,
+        grpc::ServerReader<raftRpcProctoc::SnapshotChunk>* reader,
+        raftRpcProctoc::InstallSnapshotReply* reply
+    ) override;
+
+    /**
+     * @brief 设置流式快照的落盘路径 (默认 "store/snapshot.recv")，非默认组追加 ".<groupId>" 后缀
+     */
+    void SetSnapshotSpoolPath(const std::string& path) { spool_path_ = path; }
     
 private:
-    void* raft_node_;  // 指向 Raft* （避免头文件循环依赖）
+    // 正在接收的流式快照 (每组同一时刻只接收一份，新的 meta 会覆盖旧的半成品)
+    struct PendingSnapshot {
+        std::mutex mutex;        // 串行化同一组的快照流；不同组的流互不阻塞
+        SnapshotMeta meta;
+        int fd = -1;
+        uint64_t received = 0;   // 已落盘字节数 = 下一块应有的 offset
+    };
+
+    struct GroupEntry {
+        void* raft_node = nullptr;  // 指向 Raft* （避免头文件循环依赖）
+        TermAccessor current_term;
+        std::shared_ptr<PendingSnapshot> snapshot = std::make_shared<PendingSnapshot>();
+    };
+
+    mutable std::mutex groups_mutex_;
+    std::unordered_map<uint64_t, GroupEntry> groups_;  // groupId -> Raft 组
+    std::string spool_path_ = "store/snapshot.recv";
+
+    void* FindGroup(uint64_t group_id) const;
+    std::shared_ptr<PendingSnapshot> FindPendingSnapshot(uint64_t group_id) const;
+    // 组的当前任期；组不存在或没有注册 TermAccessor 时返回 false
+    bool GroupTerm(uint64_t group_id, uint64_t* term) const;
+    std::string SpoolPath(uint64_t group_id) const;
+    void ResetPendingSnapshot(PendingSnapshot* pending, const raftRpcProctoc::SnapshotChunk& first);
 };
 
 // ========== Raft RPC 服务端管理器 ==========
@@ -162,6 +450,14 @@ public:
      * @brief 异步启动（在独立线程中运行）
      */
     void StartAsync();
+
+    /**
+     * @brief Multi-Raft：所有组共享同一个监听端口，见 RaftRpcServiceImpl::RegisterGroup
+     */
+    void RegisterGroup(uint64_t group_id, void* raft_node, RaftRpcServiceImpl::TermAccessor current_term = nullptr) {
+        service_->RegisterGroup(group_id, raft_node, std::move(current_term));
+    }
+    void UnregisterGroup(uint64_t group_id) { service_->UnregisterGroup(group_id); }
     
 private:
     std::string listen_addr_;
@@ -174,18 +470,48 @@ private:
 // ========== RPC 工具函数 ==========
 
 /**
- * @brief 序列化 Op 到 bytes
+ * @brief 序列化 Op 到 LogEntry.command (紧凑二进制格式，见 opCodec.h)
+ */
+std::string SerializeOp(const Op& op);
+
+/**
+ * @brief 反序列化 LogEntry.command 到 Op (兼容旧的 boost 文本格式)
+ */
+bool DeserializeOp(const std::string& data, Op* op);
+
+/**
+ * @brief 零拷贝解码 LogEntry.command，view 中的字符串指向 data，data 必须比 view 活得久
+ */
+bool DeserializeOpView(const std::string& data, OpView* view);
+
+/**
+ * @brief 序列化一批写操作到一条 LogEntry.command (见 opCodec.h 的批量格式)
+ */
+std::string SerializeOpBatch(const OpBatch& batch);
+
+/**
+ * @brief 零拷贝解码一个客户端的 command；单条 Op 也会被解码成只含一个操作的批
+ * @details 合并提交的 OpGroup (0xC3) 装的是多个客户端的命令，没法表示成一个 OpBatchView，这里返回 false。
+ * apply 路径先检查 IsOpGroup：是的话用 DecodeOpGroup 拆出子命令，对每个子命令调用本函数、各自去重和回复；
+ * 成员变更日志 (raft::IsMembershipEntry) 同样要在这之前跳过。
+ */
+bool DeserializeOpBatchView(std::string_view data, OpBatchView* view);
+
+/**
+ * @brief 基于文件描述符的快照读取器 (pread，不移动文件偏移，可安全断点续传)
  */
-std::string SerializeOp(const raftKVRpcProctoc::Op& op);
+SnapshotChunkReader MakeFdChunkReader(int fd);
 
 /**
- * @brief 反序列化 bytes 到 Op
+ * @brief 基于内存数据的快照读取器 (调用方保证 data 的生命周期覆盖整个传输)
  */
-bool DeserializeOp(const std::string& data, raftKVRpcProctoc::Op* op);
+SnapshotChunkReader MakeStringChunkReader(const std::string& data);
 
 /**
  * @brief 创建日志条目
+ * @param trace 提交这条日志的请求的追踪上下文 (Start 时传 Tracer::Current()，见 ProposalSink::Propose)
  */
-raftRpcProctoc::LogEntry MakeLogEntry(int term, int index, const std::string& command);
+raftRpcProctoc::LogEntry MakeLogEntry(int term, int index, const std::string& command,
+                                      const TraceContext& trace = TraceContext());
 
 } // namespace raft
\ No newline at end of file
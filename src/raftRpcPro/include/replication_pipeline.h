@@ -0,0 +1,137 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "raft_rpc.h"
+#include "replication_window.h"
+
+namespace raft {
+
+// ========== 复制管道需要的日志访问接口 (由 Raft 核心实现) ==========
+/**
+ * @brief 领导人侧日志与状态的只读视图
+ * @details 所有方法都可能在管道发送线程或 gRPC Poller 线程中被调用，实现方需自行保证线程安全。
+ */
+class ReplicationSource {
+public:
+    virtual ~ReplicationSource() = default;
+
+    virtual uint64_t CurrentTerm() = 0;
+    virtual int32_t LeaderId() = 0;
+    virtual uint64_t CommitIndex() = 0;
+
+    // 日志中第一条未被快照压缩的索引，以及最后一条的索引
+    virtual uint64_t FirstIndex() = 0;
+    virtual uint64_t LastIndex() = 0;
+
+    // index 处日志的任期 (index == FirstIndex() - 1 时返回快照的 lastIncludedTerm)
+    virtual uint64_t TermAt(uint64_t index) = 0;
+
+    // 领导人日志中任期为 term 的最后一条日志索引，不存在返回 0 (用于 conflictTerm 快速回退)
+    virtual uint64_t LastIndexOfTerm(uint64_t term) = 0;
+
+    /**
+     * @brief 从 from 开始复制日志到 out，条数不超过 max_count，
+     *        累计 command 字节数超过 max_bytes 时停止 (至少复制一条)
+     * @return 复制的条数
+     */
+    virtual size_t CopyEntries(uint64_t from, size_t max_count, size_t max_bytes,
+                               google::protobuf::RepeatedPtrField<raftRpcProctoc::LogEntry>* out) = 0;
+};
+
+// ========== 管道参数 ==========
+struct PipelineConfig {
+    size_t max_batch_entries = 256;          // 单个 AppendEntries 最多携带的日志条数
+    size_t max_batch_bytes = 1024 * 1024;    // 单个 AppendEntries 最多携带的 command 字节数
+    int linger_us = 200;                     // 未攒满一批时最多等待多久再发送
+    size_t max_inflight = 8;                 // 同一 follower 允许未确认的批次数 (窗口)
+    int rpc_timeout_ms = RaftRpcClient::kAdaptiveTimeout;  // 单个 AppendEntries 的超时时间，默认按 follower 的延迟分布自适应
+};
+
+/**
+ * @brief 单个 follower 的日志复制管道 (领导人侧)
+ * @details
+ * 1. 批量：Notify() 之后，新日志会在 linger_us 内攒成一批，或攒满 max_batch_entries /
+ *    max_batch_bytes 立即发送，多个 Put 共享一次 RTT；
+ * 2. 流水线：乐观地推进 next_index，窗口内允许 max_inflight 个批次同时在途，
+ *    不必等上一批确认再发下一批；
+ * 3. 回退：follower 拒绝时按 conflictTerm / conflictIndex 快速回退 next_index，
+ *    丢弃在途批次 (generation 递增使迟到的回复失效)，并进入探测模式 (窗口 = 1)，
+ *    直到第一次成功后恢复流水线；RPC 失败/超时同样回到 match_index + 1 探测。
+ *
+ * next_index 落到快照之前时调用 on_need_snapshot，管道暂停直到 ResetAfterSnapshot()。
+ * 以上状态机在 ReplicationWindow 中 (不依赖 gRPC，可单独测试)，这里只负责发送线程、加锁与 RPC。
+ */
+class ReplicationPipeline : public std::enable_shared_from_this<ReplicationPipeline> {
+public:
+    using MatchCallback = std::function<void(uint64_t match_index)>;
+    using TermCallback = std::function<void(uint64_t higher_term)>;
+    using SnapshotCallback = std::function<void()>;
+
+    static std::shared_ptr<ReplicationPipeline> Create(
+        std::shared_ptr<RaftRpcClient> client,
+        ReplicationSource* source,
+        const PipelineConfig& config = PipelineConfig()
+    );
+
+    ~ReplicationPipeline();
+
+    void SetMatchCallback(MatchCallback cb) { on_match_ = std::move(cb); }
+    void SetHigherTermCallback(TermCallback cb) { on_higher_term_ = std::move(cb); }
+    void SetNeedSnapshotCallback(SnapshotCallback cb) { on_need_snapshot_ = std::move(cb); }
+
+    /**
+     * @brief 成为领导人时启动：next_index = last_index + 1，match_index = 0
+     */
+    void Start(uint64_t next_index);
+
+    /**
+     * @brief 停止发送线程 (退位或析构时调用)，在途回复到达后会被忽略
+     */
+    void Stop();
+
+    /**
+     * @brief 领导人追加了新日志，唤醒发送线程
+     */
+    void Notify();
+
+    /**
+     * @brief 快照安装完成后从 last_included_index + 1 继续复制
+     */
+    void ResetAfterSnapshot(uint64_t last_included_index);
+
+    uint64_t MatchIndex() const;
+    uint64_t NextIndex() const;
+    size_t InflightCount() const;
+
+private:
+    ReplicationPipeline(std::shared_ptr<RaftRpcClient> client, ReplicationSource* source,
+                        const PipelineConfig& config);
+
+    void SendLoop();
+    void HandleReply(uint64_t generation, uint64_t last_index, bool ok,
+                     const raftRpcProctoc::AppendEntriesReply& reply);
+
+    std::shared_ptr<RaftRpcClient> client_;
+    ReplicationSource* source_;
+    PipelineConfig config_;
+
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    std::thread sender_;
+    bool running_ = false;
+    ReplicationWindow window_;  // 窗口 / generation / 回退，受 mtx_ 保护
+
+    MatchCallback on_match_;
+    TermCallback on_higher_term_;
+    SnapshotCallback on_need_snapshot_;
+};
+
+} // namespace raft
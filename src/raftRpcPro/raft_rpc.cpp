@@ -1,13 +1,21 @@
 #include "raft_rpc.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <climits>
+#include <cstring>
 #include <thread>
 #include <mutex>
 #include <iostream>
 #include <future>
 #include <memory>
+#include <vector>
 
 // 引入协程库头文件 (根据你的项目结构调整路径)
 #include "scheduler.h" 
 #include "fiber.h"
+#include "cpu_topology.h"
+#include "trace.h"
 
 namespace raft {
 
@@ -36,6 +44,132 @@ struct AsyncCallBase {
     virtual void Proceed(bool ok) = 0;
 };
 
+/**
+ * @brief 全局 RPC 系统单例
+ * * 负责管理 CompletionQueue 池和对应的后台轮询线程 (Poller Thread)，每个 CQ 一个 Poller。
+ * 每个 RaftRpcClient 按 target 哈希固定到一个 CQ 分片 (peer 亲和)：
+ * 同一 peer 的回复始终由同一个 Poller 按序处理，不同 peer 之间互不阻塞，
+ * 某个 peer 的慢回调不会拖慢其他 peer 的回复处理。
+ */
+class RpcSystem {
+public:
+    static RpcSystem& Instance() {
+        static RpcSystem instance;
+        return instance;
+    }
+
+    // 启动前修改配置；已经启动则返回 false
+    bool Configure(const RpcSystemConfig& config) {
+        std::lock_guard<std::mutex> lock(config_mutex_);
+        if (started_) {
+            return false;
+        }
+        config_ = config;
+        return true;
+    }
+
+    // 获取分片对应的 CompletionQueue 指针 (第一次调用时按配置启动 CQ 池)
+    grpc::CompletionQueue* GetCQ(size_t shard) {
+        EnsureStarted();
+        return cqs_[shard % cqs_.size()].get();
+    }
+
+    bool ResumeOnCaller() {
+        EnsureStarted();
+        return resume_on_caller_;
+    }
+
+private:
+    RpcSystem() = default;
+
+    void EnsureStarted() {
+        std::call_once(start_once_, [this]() { Start(); });
+    }
+
+    void Start() {
+        std::lock_guard<std::mutex> lock(config_mutex_);
+        size_t n = config_.cq_num;
+        if (n == 0) {
+            n = std::max(1u, std::thread::hardware_concurrency());
+        }
+        resume_on_caller_ = config_.resume_on_caller;
+
+        for (size_t i = 0; i < n; ++i) {
+            cqs_.emplace_back(new grpc::CompletionQueue());
+        }
+        for (size_t i = 0; i < n; ++i) {
+            grpc::CompletionQueue* cq = cqs_[i].get();
+            // 启动后台线程，不断从队列中取出完成的事件
+            std::thread poller([cq]() {
+                void* tag;  // 这是我们在 CallMethod 时传进去的 AsyncCallWrapper 指针
+                bool ok;
+
+                // 阻塞等待，直到有 RPC 完成
+                while (cq->Next(&tag, &ok)) {
+                    // 1. 将 void* 还原为基类指针
+                    auto* call = static_cast<AsyncCallBase*>(tag);
+                    // 2. 多态调用 Proceed，处理具体类型的 RPC
+                    call->Proceed(ok);
+                }
+            });
+            poller.detach(); // 简单起见，随进程退出而退出。生产环境建议妥善管理 join。
+        }
+        started_ = true;
+    }
+
+    std::mutex config_mutex_;
+    RpcSystemConfig config_;
+    bool started_ = false;
+    std::once_flag start_once_;
+    bool resume_on_caller_ = false;  // Start 之后只读
+    std::vector<std::unique_ptr<grpc::CompletionQueue>> cqs_;
+};
+
+/**
+ * @brief 把挂起的协程重新放回它原来的调度器/线程
+ * @param scheduler 发起 RPC 时所在的调度器；为空时退化为当前线程的调度器
+ */
+static void ResumeFiber(monsoon::Scheduler* scheduler, int thread, void* fiber_tag) {
+    if (!fiber_tag) {
+        return;
+    }
+    if (!scheduler) {
+        scheduler = monsoon::Scheduler::GetThisScheduler();
+    }
+    if (!scheduler) {
+        std::cerr << "[RaftRpc] fiber_tag set but caller has no scheduler, fiber not resumed" << std::endl;
+        return;
+    }
+    scheduler->schedule(static_cast<monsoon::Fiber*>(fiber_tag)->shared_from_this(), thread);
+}
+
+/**
+ * @brief 执行 RPC 完成后的收尾工作 (回调 + 唤醒协程)
+ * * resume_on_caller 开启且发起方在协程线程中时，投递回发起线程执行，Poller 线程立即返回；
+ * 否则直接在当前线程 (Poller / 快照发送线程) 执行。
+ */
+static void DispatchCompletion(monsoon::Scheduler* scheduler, int thread, std::function<void()> fn) {
+    if (scheduler && RpcSystem::Instance().ResumeOnCaller()) {
+        scheduler->schedule(std::move(fn), thread);
+    } else {
+        fn();
+    }
+}
+
+// 记录发起方所在的调度器与线程，用于完成时回到原线程
+template<typename Reply>
+static void BindCaller(AsyncClientCall<Reply>* call) {
+    call->scheduler = monsoon::Scheduler::GetThisScheduler();
+    call->thread = call->scheduler ? monsoon::Scheduler::GetThisThreadIndex() : -1;
+}
+
+// 统计往返时间 (只用于延迟分布相近的小 RPC：快照、ReadIndex 不计入)
+template<typename Reply>
+static void BindLatency(AsyncClientCall<Reply>* call, const std::shared_ptr<LatencyTracker>& latency) {
+    call->latency = latency;
+    call->start_time = std::chrono::steady_clock::now();
+}
+
 /**
  * @brief 具体的异步调用包装器
  * * 这是一个“胶水”类，连接了：
@@ -60,19 +194,31 @@ struct AsyncCallWrapper : public AsyncCallBase {
             call_data->status = grpc::Status(grpc::StatusCode::CANCELLED, "RPC failed or cancelled (gRPC level)");
         }
 
-        // 2. 执行用户注册的回调 (通常用于简单的状态更新)
+        // 成功与超时都计入延迟分布：对端整体变慢时超时随之放宽；连接失败等快速失败不计
+        grpc::StatusCode code = call_data->status.error_code();
+        if (call_data->latency && (code == grpc::StatusCode::OK || code == grpc::StatusCode::DEADLINE_EXCEEDED)) {
+            call_data->latency->Record(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - call_data->start_time));
+        }
+        if (call_data->rtt && code == grpc::StatusCode::OK) {
+            RecordLatency(call_data->rtt, call_data->start_time);
+        }
+
+        // 2. 回调与协程唤醒：按配置回到发起线程，或在 Poller 线程执行
+        DispatchCompletion(call_data->scheduler, call_data->thread, [this]() { Complete(); });
+    }
+
+    void Complete() {
+        // 1. 执行用户注册的回调 (通常用于简单的状态更新)
         if (call_data->callback) {
             call_data->callback(call_data->status.ok(), call_data->reply);
         }
 
-        // 3. 核心步骤：唤醒挂起的协程
-        // 如果调用方在发起 RPC 时传入了协程句柄 (fiber_tag)，我们需要把它重新加入调度器
-        if (call_data->fiber_tag) {
-             // 获取全局调度器，将挂起的协程指针强转回来，并 Schedule
-             monsoon::Scheduler::GetThis()->scheduler((monsoon::Fiber*)call_data->fiber_tag);
-        }
+        // 2. 核心步骤：唤醒挂起的协程
+        // 如果调用方在发起 RPC 时传入了协程句柄 (fiber_tag)，把它重新加入发起时的调度器/线程
+        ResumeFiber(call_data->scheduler, call_data->thread, call_data->fiber_tag);
 
-        // 4. 资源清理 (自杀式生命周期管理)
+        // 3. 资源清理 (自杀式生命周期管理)
         // 这一步非常重要！因为 call_data 和 wrapper 都是 new 出来的
         // 既然 RPC 已经结束，回调也已执行，必须在这里释放内存，否则内存泄漏
         delete call_data; // 释放 Protocol Buffer 消息和 Context
@@ -80,40 +226,9 @@ struct AsyncCallWrapper : public AsyncCallBase {
     }
 };
 
-/**
- * @brief 全局 RPC 系统单例
- * * 负责管理唯一的 CompletionQueue 和后台轮询线程 (Poller Thread)。
- * 所有的 gRPC 客户端请求都共享这个队列和线程。
- */
-class RpcSystem {
-public:
-    // 获取单例的 CompletionQueue 指针
-    static grpc::CompletionQueue* GetCQ() {
-        static RpcSystem instance;
-        return &instance.cq_;
-    }
-
-private:
-    RpcSystem() {
-        // 启动后台线程，不断从队列中取出完成的事件
-        poller_ = std::thread([this](){
-            void* tag;  // 这是我们在 CallMethod 时传进去的 AsyncCallWrapper 指针
-            bool ok;
-            
-            // 阻塞等待，直到有 RPC 完成
-            while (cq_.Next(&tag, &ok)) {
-                // 1. 将 void* 还原为基类指针
-                auto* call = static_cast<AsyncCallBase*>(tag);
-                // 2. 多态调用 Proceed，处理具体类型的 RPC
-                call->Proceed(ok);
-            }
-        });
-        poller_.detach(); // 简单起见，随进程退出而退出。生产环境建议妥善管理 join。
-    }
-
-    grpc::CompletionQueue cq_;
-    std::thread poller_;
-};
+bool ConfigureRpcSystem(const RpcSystemConfig& config) {
+    return RpcSystem::Instance().Configure(config);
+}
 
 // =========================================================
 //  PART 2: RaftRpcClient 实现 (发送端)
@@ -137,17 +252,47 @@ RaftRpcClient::RaftRpcClient(const std::string& target) {
         args
     );
     stub_ = raftRpcProctoc::RaftRpcService::NewStub(channel_);
+    shard_ = std::hash<std::string>()(target);
+    append_rtt_ = MetricsRegistry::GetInstance().GetHistogram(
+        "raft_append_entries_rtt_microseconds", {{"peer", target}}, "AppendEntries round trip per peer (OK replies)");
 }
 
-RaftRpcClient::~RaftRpcClient() = default;
+RaftRpcClient::~RaftRpcClient() {
+    // 取消进行中的快照流 (阻塞在流控上的 Write 随之返回)，等发送线程退出后才释放 stub_
+    std::list<SnapshotTransfer> transfers;
+    {
+        std::lock_guard<std::mutex> lock(transfer_mutex_);
+        closing_ = true;
+        for (grpc::ClientContext* context : stream_contexts_) {
+            context->TryCancel();
+        }
+        transfers.swap(transfers_);
+    }
+    transfer_cv_.notify_all();
+    for (SnapshotTransfer& transfer : transfers) {
+        transfer.thread.join();
+    }
+}
 
 // 设置 RPC 的超时时间，防止网络分区时协程永久挂起
 void RaftRpcClient::SetDeadline(grpc::ClientContext* context, int timeout_ms) {
     auto deadline = std::chrono::system_clock::now() + 
-                    std::chrono::milliseconds(timeout_ms);
+                    std::chrono::milliseconds(EffectiveTimeoutMs(timeout_ms));
     context->set_deadline(deadline);
 }
 
+int RaftRpcClient::EffectiveTimeoutMs(int timeout_ms) const {
+    if (timeout_ms > 0) {
+        return timeout_ms;
+    }
+    AdaptiveTimeoutOptions options;
+    options.default_ms = RAFT_RPC_TIMEOUT_MS;
+    options.min_ms = RAFT_RPC_MIN_TIMEOUT_MS;
+    options.max_ms = RAFT_RPC_MAX_TIMEOUT_MS;
+    options.multiplier = RAFT_RPC_TIMEOUT_P99_MULTIPLIER;
+    return static_cast<int>(latency_->Timeout(options).count());
+}
+
 // --- 1. 异步 RequestVote ---
 void RaftRpcClient::AsyncRequestVote(
     const raftRpcProctoc::RequestVoteArgs& args,
@@ -159,6 +304,8 @@ void RaftRpcClient::AsyncRequestVote(
     auto* call = new AsyncClientCall<raftRpcProctoc::RequestVoteReply>();
     call->callback = callback;
     call->fiber_tag = fiber_tag;
+    BindCaller(call);
+    BindLatency(call, latency_);
     SetDeadline(&call->context, timeout_ms);
 
     // 2. 创建类型擦除包装器 (Wrapper)
@@ -166,8 +313,8 @@ void RaftRpcClient::AsyncRequestVote(
     auto* wrapper = new AsyncCallWrapper<raftRpcProctoc::RequestVoteReply>(call);
 
     // 3. 发起异步调用 (Prepare -> Start -> Finish)
-    // 注意：我们将全局单例的 CQ 传入
-    call->response_reader = stub_->PrepareAsyncRequestVote(&call->context, args, RpcSystem::GetCQ());
+    // 注意：传入该 peer 固定的 CQ 分片
+    call->response_reader = stub_->PrepareAsyncRequestVote(&call->context, args, RpcSystem::Instance().GetCQ(shard_));
     call->response_reader->StartCall();
     
     // 4. 绑定 tag
@@ -186,11 +333,14 @@ void RaftRpcClient::AsyncAppendEntries(
     auto* call = new AsyncClientCall<raftRpcProctoc::AppendEntriesReply>();
     call->callback = callback;
     call->fiber_tag = fiber_tag;
+    BindCaller(call);
+    BindLatency(call, latency_);
+    call->rtt = append_rtt_;
     SetDeadline(&call->context, timeout_ms);
 
     auto* wrapper = new AsyncCallWrapper<raftRpcProctoc::AppendEntriesReply>(call);
 
-    call->response_reader = stub_->PrepareAsyncAppendEntries(&call->context, args, RpcSystem::GetCQ());
+    call->response_reader = stub_->PrepareAsyncAppendEntries(&call->context, args, RpcSystem::Instance().GetCQ(shard_));
     call->response_reader->StartCall();
     call->response_reader->Finish(&call->reply, &call->status, (void*)wrapper);
 }
@@ -206,15 +356,226 @@ void RaftRpcClient::AsyncInstallSnapshot(
     auto* call = new AsyncClientCall<raftRpcProctoc::InstallSnapshotReply>();
     call->callback = callback;
     call->fiber_tag = fiber_tag;
+    BindCaller(call);
     SetDeadline(&call->context, timeout_ms);
 
     auto* wrapper = new AsyncCallWrapper<raftRpcProctoc::InstallSnapshotReply>(call);
 
-    call->response_reader = stub_->PrepareAsyncInstallSnapshot(&call->context, args, RpcSystem::GetCQ());
+    call->response_reader = stub_->PrepareAsyncInstallSnapshot(&call->context, args, RpcSystem::Instance().GetCQ(shard_));
+    call->response_reader->StartCall();
+    call->response_reader->Finish(&call->reply, &call->status, (void*)wrapper);
+}
+
+// --- 4. 异步 ReadIndex (follower 读回退) ---
+void RaftRpcClient::AsyncReadIndex(
+    const raftRpcProctoc::ReadIndexArgs& args,
+    RpcCallback<raftRpcProctoc::ReadIndexReply> callback,
+    void* fiber_tag,
+    int timeout_ms
+) {
+    auto* call = new AsyncClientCall<raftRpcProctoc::ReadIndexReply>();
+    call->callback = callback;
+    call->fiber_tag = fiber_tag;
+    BindCaller(call);
+    SetDeadline(&call->context, timeout_ms);
+
+    auto* wrapper = new AsyncCallWrapper<raftRpcProctoc::ReadIndexReply>(call);
+
+    call->response_reader = stub_->PrepareAsyncReadIndex(&call->context, args, RpcSystem::Instance().GetCQ(shard_));
+    call->response_reader->StartCall();
+    call->response_reader->Finish(&call->reply, &call->status, (void*)wrapper);
+}
+
+// --- 5. 异步 NodeHeartbeat (Multi-Raft 合并心跳) ---
+void RaftRpcClient::AsyncNodeHeartbeat(
+    const raftRpcProctoc::NodeHeartbeatArgs& args,
+    RpcCallback<raftRpcProctoc::NodeHeartbeatReply> callback,
+    void* fiber_tag,
+    int timeout_ms
+) {
+    auto* call = new AsyncClientCall<raftRpcProctoc::NodeHeartbeatReply>();
+    call->callback = callback;
+    call->fiber_tag = fiber_tag;
+    BindCaller(call);
+    BindLatency(call, latency_);
+    SetDeadline(&call->context, timeout_ms);
+
+    auto* wrapper = new AsyncCallWrapper<raftRpcProctoc::NodeHeartbeatReply>(call);
+
+    call->response_reader = stub_->PrepareAsyncNodeHeartbeat(&call->context, args, RpcSystem::Instance().GetCQ(shard_));
+    call->response_reader->StartCall();
+    call->response_reader->Finish(&call->reply, &call->status, (void*)wrapper);
+}
+
+// --- 6. 异步 TimeoutNow (领导权转移) ---
+void RaftRpcClient::AsyncTimeoutNow(
+    const raftRpcProctoc::TimeoutNowArgs& args,
+    RpcCallback<raftRpcProctoc::TimeoutNowReply> callback,
+    void* fiber_tag,
+    int timeout_ms
+) {
+    auto* call = new AsyncClientCall<raftRpcProctoc::TimeoutNowReply>();
+    call->callback = callback;
+    call->fiber_tag = fiber_tag;
+    BindCaller(call);
+    BindLatency(call, latency_);
+    SetDeadline(&call->context, timeout_ms);
+
+    auto* wrapper = new AsyncCallWrapper<raftRpcProctoc::TimeoutNowReply>(call);
+
+    call->response_reader = stub_->PrepareAsyncTimeoutNow(&call->context, args, RpcSystem::Instance().GetCQ(shard_));
     call->response_reader->StartCall();
     call->response_reader->Finish(&call->reply, &call->status, (void*)wrapper);
 }
 
+// --- 7. 流式 InstallSnapshot ---
+bool RaftRpcClient::InstallSnapshotStream(
+    const SnapshotMeta& meta,
+    const SnapshotChunkReader& reader,
+    raftRpcProctoc::InstallSnapshotReply* reply,
+    const SnapshotStreamConfig& config
+) {
+    const size_t chunk_size = std::max<size_t>(config.chunk_size, 1);
+    std::string buf(chunk_size, '\0');
+    uint64_t offset = 0;  // 下一块要发送的偏移，由 follower 的 nextOffset 校正
+
+    // 登记本次流的 context，客户端析构时据此取消
+    struct StreamGuard {
+        RaftRpcClient* client;
+        grpc::ClientContext* context;
+        ~StreamGuard() {
+            std::lock_guard<std::mutex> lock(client->transfer_mutex_);
+            client->stream_contexts_.erase(context);
+        }
+    };
+
+    for (int attempt = 0; attempt <= config.max_retries; ++attempt) {
+        grpc::ClientContext context;
+        {
+            std::lock_guard<std::mutex> lock(transfer_mutex_);
+            if (closing_) {
+                return false;
+            }
+            stream_contexts_.insert(&context);
+        }
+        StreamGuard guard{this, &context};
+        uint64_t remaining_chunks = (meta.total_size - std::min(offset, meta.total_size)) / chunk_size + 2;
+        SetDeadline(&context, static_cast<int>(std::min<uint64_t>(
+            remaining_chunks * config.chunk_timeout_ms, INT_MAX)));
+
+        reply->Clear();
+        std::unique_ptr<grpc::ClientWriter<raftRpcProctoc::SnapshotChunk>> writer(
+            stub_->InstallSnapshotStream(&context, reply));
+
+        raftRpcProctoc::SnapshotChunk chunk;
+        bool first = true;
+        bool read_error = false;
+        auto start = std::chrono::steady_clock::now();
+        uint64_t sent_bytes = 0;
+
+        while (true) {
+            ssize_t n = reader(offset, &buf[0], chunk_size);
+            if (n < 0) {
+                read_error = true;
+                break;
+            }
+
+            chunk.Clear();
+            chunk.set_offset(offset);
+            chunk.set_data(buf.data(), static_cast<size_t>(n));
+            chunk.set_done(n == 0 || offset + static_cast<uint64_t>(n) >= meta.total_size);
+            if (first) {
+                chunk.set_term(meta.term);
+                chunk.set_leaderid(meta.leader_id);
+                chunk.set_lastincludedindex(meta.last_included_index);
+                chunk.set_lastincludedterm(meta.last_included_term);
+                chunk.set_totalsize(meta.total_size);
+                chunk.set_groupid(meta.group_id);
+                first = false;
+            }
+
+            // 同步 Write 受 HTTP/2 流控约束：follower 处理不过来时在这里阻塞 (逐块背压)
+            // 返回 false 表示流已被 follower 提前结束 (offset 不一致) 或连接断开
+            if (!writer->Write(chunk)) {
+                break;
+            }
+            offset += static_cast<uint64_t>(n);
+            sent_bytes += static_cast<uint64_t>(n);
+            if (chunk.done()) {
+                break;
+            }
+
+            // 简单的令牌桶限速：发送速度超过配额时睡眠补齐
+            if (config.max_bytes_per_sec > 0) {
+                auto expect = std::chrono::microseconds(sent_bytes * 1000000 / config.max_bytes_per_sec);
+                auto elapsed = std::chrono::steady_clock::now() - start;
+                if (expect > elapsed) {
+                    std::unique_lock<std::mutex> lock(transfer_mutex_);
+                    if (transfer_cv_.wait_for(lock, expect - elapsed, [this] { return closing_; })) {
+                        break;  // 客户端析构中，流已被取消
+                    }
+                }
+            }
+        }
+
+        if (read_error) {
+            context.TryCancel();
+            writer->Finish();
+            std::cerr << "[RaftRpcClient] Snapshot reader failed at offset " << offset << std::endl;
+            return false;
+        }
+
+        writer->WritesDone();
+        grpc::Status status = writer->Finish();
+        if (status.ok()) {
+            if (reply->accepted() || reply->term() > meta.term) {
+                return true;
+            }
+            // follower 告知断点，从 nextOffset 续传
+            offset = reply->nextoffset();
+        }
+        // 传输层失败：保留当前 offset，重新开流后 follower 会校正到它实际落盘的位置
+    }
+    return false;
+}
+
+void RaftRpcClient::AsyncInstallSnapshotStream(
+    const SnapshotMeta& meta,
+    SnapshotChunkReader reader,
+    RpcCallback<raftRpcProctoc::InstallSnapshotReply> callback,
+    void* fiber_tag,
+    const SnapshotStreamConfig& config
+) {
+    monsoon::Scheduler* scheduler = monsoon::Scheduler::GetThisScheduler();
+    int thread = scheduler ? monsoon::Scheduler::GetThisThreadIndex() : -1;
+
+    // 快照传输可能持续数秒到数分钟，不能占用 CQ Poller 线程或协程工作线程，单独起线程执行；
+    // 线程登记在 transfers_ 中，析构时 join，所以捕获 this 是安全的
+    std::lock_guard<std::mutex> lock(transfer_mutex_);
+    for (auto it = transfers_.begin(); it != transfers_.end();) {
+        if (it->finished) {
+            it->thread.join();  // 已经走完，join 立即返回
+            it = transfers_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    auto transfer = transfers_.emplace(transfers_.end());
+    transfer->thread = std::thread([this, transfer, meta, reader = std::move(reader), callback = std::move(callback),
+                                    fiber_tag, config, scheduler, thread]() {
+        auto reply = std::make_shared<raftRpcProctoc::InstallSnapshotReply>();
+        bool ok = InstallSnapshotStream(meta, reader, reply.get(), config);
+        DispatchCompletion(scheduler, thread, [callback, ok, reply, fiber_tag, scheduler, thread]() {
+            if (callback) {
+                callback(ok, *reply);
+            }
+            ResumeFiber(scheduler, thread, fiber_tag);
+        });
+        std::lock_guard<std::mutex> lock(transfer_mutex_);
+        transfer->finished = true;
+    });
+}
+
 // --- 同步辅助方法 (仅用于单元测试或简单调试) ---
 bool RaftRpcClient::RequestVote(
     const raftRpcProctoc::RequestVoteArgs& args,
@@ -239,6 +600,39 @@ bool RaftRpcClient::AppendEntries(
     return status.ok();
 }
 
+bool RaftRpcClient::ReadIndex(
+    const raftRpcProctoc::ReadIndexArgs& args,
+    raftRpcProctoc::ReadIndexReply* reply,
+    int timeout_ms
+) {
+    grpc::ClientContext context;
+    SetDeadline(&context, timeout_ms);
+    grpc::Status status = stub_->ReadIndex(&context, args, reply);
+    return status.ok();
+}
+
+bool RaftRpcClient::TransferLeadership(
+    const raftRpcProctoc::TransferLeadershipArgs& args,
+    raftRpcProctoc::TransferLeadershipReply* reply,
+    int timeout_ms
+) {
+    grpc::ClientContext context;
+    SetDeadline(&context, timeout_ms);
+    grpc::Status status = stub_->TransferLeadership(&context, args, reply);
+    return status.ok();
+}
+
+bool RaftRpcClient::ChangeMembership(
+    const raftRpcProctoc::ChangeMembershipArgs& args,
+    raftRpcProctoc::ChangeMembershipReply* reply,
+    int timeout_ms
+) {
+    grpc::ClientContext context;
+    SetDeadline(&context, timeout_ms);
+    grpc::Status status = stub_->ChangeMembership(&context, args, reply);
+    return status.ok();
+}
+
 bool RaftRpcClient::IsAvailable() const {
     auto state = channel_->GetState(false);
     return state != GRPC_CHANNEL_SHUTDOWN;
@@ -254,8 +648,71 @@ bool RaftRpcClient::IsAvailable() const {
 //  4. gRPC 线程返回结果
 // =========================================================
 
-RaftRpcServiceImpl::RaftRpcServiceImpl(void* raft_node)
-    : raft_node_(raft_node) {}
+RaftRpcServiceImpl::RaftRpcServiceImpl(void* raft_node) {
+    RegisterGroup(0, raft_node);
+}
+
+void RaftRpcServiceImpl::RegisterGroup(uint64_t group_id, void* raft_node, TermAccessor current_term) {
+    std::lock_guard<std::mutex> lock(groups_mutex_);
+    GroupEntry& entry = groups_[group_id];
+    entry.raft_node = raft_node;
+    entry.current_term = std::move(current_term);
+}
+
+void RaftRpcServiceImpl::UnregisterGroup(uint64_t group_id) {
+    std::shared_ptr<PendingSnapshot> pending;
+    {
+        std::lock_guard<std::mutex> lock(groups_mutex_);
+        auto it = groups_.find(group_id);
+        if (it == groups_.end()) {
+            return;
+        }
+        pending = std::move(it->second.snapshot);
+        groups_.erase(it);
+    }
+    // 丢弃该组未完成的快照 (正在接收的流持有 mutex，等它结束)
+    std::lock_guard<std::mutex> lock(pending->mutex);
+    if (pending->fd >= 0) {
+        ::close(pending->fd);
+        pending->fd = -1;
+        ::unlink(SpoolPath(group_id).c_str());
+    }
+}
+
+void* RaftRpcServiceImpl::FindGroup(uint64_t group_id) const {
+    std::lock_guard<std::mutex> lock(groups_mutex_);
+    auto it = groups_.find(group_id);
+    return it == groups_.end() ? nullptr : it->second.raft_node;
+}
+
+std::shared_ptr<RaftRpcServiceImpl::PendingSnapshot> RaftRpcServiceImpl::FindPendingSnapshot(uint64_t group_id) const {
+    std::lock_guard<std::mutex> lock(groups_mutex_);
+    auto it = groups_.find(group_id);
+    return it == groups_.end() ? nullptr : it->second.snapshot;
+}
+
+bool RaftRpcServiceImpl::GroupTerm(uint64_t group_id, uint64_t* term) const {
+    TermAccessor accessor;
+    {
+        std::lock_guard<std::mutex> lock(groups_mutex_);
+        auto it = groups_.find(group_id);
+        if (it == groups_.end() || !it->second.current_term) {
+            return false;
+        }
+        accessor = it->second.current_term;
+    }
+    // 在 groups_mutex_ 之外调用：实现方可能要取 Raft 核心自己的锁
+    *term = accessor();
+    return true;
+}
+
+std::string RaftRpcServiceImpl::SpoolPath(uint64_t group_id) const {
+    return group_id == 0 ? spool_path_ : spool_path_ + "." + std::to_string(group_id);
+}
+
+static grpc::Status UnknownGroup(uint64_t group_id) {
+    return grpc::Status(grpc::StatusCode::NOT_FOUND, "Unknown raft group " + std::to_string(group_id));
+}
 
 // [占位符] 假设 Raft 核心类的接口定义。
 // 在实际编译时，你需要包含 "raft.h"，并确保 Raft 类有这些 ProcessXXX 方法。
@@ -265,6 +722,19 @@ public:
     void ProcessRequestVote(const RequestVoteArgs* args, RequestVoteReply* reply);
     void ProcessAppendEntries(const AppendEntriesArgs* args, AppendEntriesReply* reply);
     void ProcessInstallSnapshot(const InstallSnapshotArgs* args, InstallSnapshotReply* reply);
+    // 领导人：ReadIndex::ConfirmReadIndex (阻塞到一轮心跳确认)；follower：success = false + leaderId
+    void ProcessReadIndex(const ReadIndexArgs* args, ReadIndexReply* reply);
+    // 合并心跳中属于本组的一项：按 AppendEntries 的任期规则处理，commit 推进到 min(commit, lastLogIndex)
+    void ProcessGroupHeartbeat(const GroupHeartbeat& hb, GroupHeartbeatResponse* resp);
+    // ElectionControl::AcceptTimeoutNow 通过后立即以 leadershipTransfer = true 发起正式选举
+    void ProcessTimeoutNow(const TimeoutNowArgs* args, TimeoutNowReply* reply);
+    // 领导人：ElectionControl::BeginTransfer，阻塞到目标在新任期当选 (收到更高任期的 AppendEntries) 或超时
+    void ProcessTransferLeadership(const TransferLeadershipArgs* args, TransferLeadershipReply* reply);
+    // 领导人：Membership::Prepare 生成新配置并作为一条日志提议 (追加即生效，learner 开始接收日志)；
+    // joint 配置提交后自动提议 LeaveJoint()，阻塞到最终配置提交或超时
+    void ProcessChangeMembership(const ChangeMembershipArgs* args, ChangeMembershipReply* reply);
+    // 注册组时作为 TermAccessor 传入：server.RegisterGroup(id, raft, [raft]() { return raft->CurrentTerm(); })
+    uint64_t CurrentTerm();
 };
 */
 
@@ -273,6 +743,12 @@ grpc::Status RaftRpcServiceImpl::RequestVote(
     const raftRpcProctoc::RequestVoteArgs* request,
     raftRpcProctoc::RequestVoteReply* reply
 ) {
+    // 0. Multi-Raft：按 groupId 找到目标组
+    void* raft_node = FindGroup(request->groupid());
+    if (!raft_node) {
+        return UnknownGroup(request->groupid());
+    }
+
     // 1. 获取全局单例协程调度器
     auto scheduler = monsoon::Scheduler::GetThis();
     if (!scheduler) {
@@ -286,11 +762,11 @@ grpc::Status RaftRpcServiceImpl::RequestVote(
 
     // 3. 将任务打包提交给协程调度器
     // Lambda 捕获 this, request, reply 指针是安全的，因为 gRPC 在此函数返回前不会销毁它们
-    scheduler->scheduler([this, request, reply, &prom]() {
+    scheduler->scheduler([raft_node, request, reply, &prom]() {
         // ============= 这里是协程上下文 (Fiber Context) =============
         
         // 1. 将 void* 转回 Raft* (实际项目中建议使用接口类 IRaftNode* 增加安全性)
-        // auto raft = static_cast<Raft*>(raft_node_);
+        // auto raft = static_cast<Raft*>(raft_node);
         
         // 2. 调用核心逻辑 (这是无锁或协程锁环境，安全！)
         // raft->ProcessRequestVote(request, reply);
@@ -318,18 +794,49 @@ grpc::Status RaftRpcServiceImpl::AppendEntries(
     const raftRpcProctoc::AppendEntriesArgs* request,
     raftRpcProctoc::AppendEntriesReply* reply
 ) {
+    void* raft_node = FindGroup(request->groupid());
+    if (!raft_node) {
+        return UnknownGroup(request->groupid());
+    }
     auto scheduler = monsoon::Scheduler::GetThis();
     std::promise<void> prom;
     auto fut = prom.get_future();
 
-    scheduler->scheduler([this, request, reply, &prom]() {
-        // auto raft = static_cast<Raft*>(raft_node_);
+    // follower 侧：被采样的日志记录一个 raft.append span (排队到 Raft 协程 + 追加日志)
+    uint64_t start_ns = 0;
+    for (const raftRpcProctoc::LogEntry& entry : request->entries()) {
+        if (entry.traceid() != 0) {
+            start_ns = TraceNowNanos();
+            break;
+        }
+    }
+
+    scheduler->scheduler([raft_node, request, reply, &prom]() {
+        // auto raft = static_cast<Raft*>(raft_node);
         // raft->ProcessAppendEntries(request, reply);
         prom.set_value();
     });
 
     // 等待结果
     fut.wait();
+    if (start_ns != 0) {
+        uint64_t end_ns = TraceNowNanos();
+        for (const raftRpcProctoc::LogEntry& entry : request->entries()) {
+            if (entry.traceid() == 0) {
+                continue;
+            }
+            SpanRecord span;
+            span.trace_id = entry.traceid();
+            span.span_id = Tracer::NewId();
+            span.parent_id = entry.spanid();
+            span.name = "raft.append";
+            span.start_ns = start_ns;
+            span.end_ns = end_ns;
+            span.arg_key = "index";
+            span.arg_value = entry.index();
+            Tracer::GetInstance().Record(span);
+        }
+    }
     return grpc::Status::OK;
 }
 
@@ -338,12 +845,16 @@ grpc::Status RaftRpcServiceImpl::InstallSnapshot(
     const raftRpcProctoc::InstallSnapshotArgs* request,
     raftRpcProctoc::InstallSnapshotReply* reply
 ) {
+    void* raft_node = FindGroup(request->groupid());
+    if (!raft_node) {
+        return UnknownGroup(request->groupid());
+    }
     auto scheduler = monsoon::Scheduler::GetThis();
     std::promise<void> prom;
     auto fut = prom.get_future();
 
-    scheduler->scheduler([this, request, reply, &prom]() {
-        // auto raft = static_cast<Raft*>(raft_node_);
+    scheduler->scheduler([raft_node, request, reply, &prom]() {
+        // auto raft = static_cast<Raft*>(raft_node);
         // raft->ProcessInstallSnapshot(request, reply);
         prom.set_value();
     });
@@ -352,6 +863,244 @@ grpc::Status RaftRpcServiceImpl::InstallSnapshot(
     return grpc::Status::OK;
 }
 
+/**
+ * @brief follower 读回退
+ * @details 确认领导权要等一轮心跳 (一个 RTT)，ReadIndex 用 condition_variable 阻塞等待，
+ * 放进协程会卡住整个调度线程，因此直接在 gRPC 线程里处理，不经过协程调度器。
+ */
+grpc::Status RaftRpcServiceImpl::ReadIndex(
+    grpc::ServerContext* context,
+    const raftRpcProctoc::ReadIndexArgs* request,
+    raftRpcProctoc::ReadIndexReply* reply
+) {
+    void* raft_node = FindGroup(request->groupid());
+    if (!raft_node) {
+        return UnknownGroup(request->groupid());
+    }
+    reply->set_success(false);
+    // auto raft = static_cast<Raft*>(raft_node);
+    // raft->ProcessReadIndex(request, reply);
+    return grpc::Status::OK;
+}
+
+grpc::Status RaftRpcServiceImpl::NodeHeartbeat(
+    grpc::ServerContext* context,
+    const raftRpcProctoc::NodeHeartbeatArgs* request,
+    raftRpcProctoc::NodeHeartbeatReply* reply
+) {
+    // 先在 gRPC 线程里解析好路由，协程里只做 Raft 逻辑
+    std::vector<void*> nodes;
+    nodes.reserve(request->heartbeats_size());
+    for (const auto& hb : request->heartbeats()) {
+        nodes.push_back(FindGroup(hb.groupid()));
+        auto* resp = reply->add_responses();
+        resp->set_groupid(hb.groupid());
+        resp->set_success(false);
+    }
+
+    auto scheduler = monsoon::Scheduler::GetThis();
+    std::promise<void> prom;
+    auto fut = prom.get_future();
+
+    // 一个心跳周期里所有组只调度一次协程，而不是每组一次
+    scheduler->scheduler([&nodes, request, reply, &prom]() {
+        for (int i = 0; i < request->heartbeats_size(); ++i) {
+            if (!nodes[i]) {
+                continue;  // 本节点没有该组 (已迁出)：success = false，领导人据此更新路由
+            }
+            // auto raft = static_cast<Raft*>(nodes[i]);
+            // raft->ProcessGroupHeartbeat(request->heartbeats(i), reply->mutable_responses(i));
+        }
+        prom.set_value();
+    });
+
+    fut.wait();
+    return grpc::Status::OK;
+}
+
+grpc::Status RaftRpcServiceImpl::TimeoutNow(
+    grpc::ServerContext* context,
+    const raftRpcProctoc::TimeoutNowArgs* request,
+    raftRpcProctoc::TimeoutNowReply* reply
+) {
+    void* raft_node = FindGroup(request->groupid());
+    if (!raft_node) {
+        return UnknownGroup(request->groupid());
+    }
+    auto scheduler = monsoon::Scheduler::GetThis();
+    std::promise<void> prom;
+    auto fut = prom.get_future();
+
+    // 只是发起选举 (投票请求异步发出)，不等选举结果
+    scheduler->scheduler([raft_node, request, reply, &prom]() {
+        // auto raft = static_cast<Raft*>(raft_node);
+        // raft->ProcessTimeoutNow(request, reply);
+        prom.set_value();
+    });
+
+    fut.wait();
+    return grpc::Status::OK;
+}
+
+/**
+ * @brief 领导权转移
+ * @details 要等目标追平日志并当选 (通常一到两个 RTT，最多 RAFT_TRANSFER_TIMEOUT_MS)，
+ * 与 ReadIndex 一样在 gRPC 线程里阻塞等待，不占用协程调度线程。
+ */
+grpc::Status RaftRpcServiceImpl::TransferLeadership(
+    grpc::ServerContext* context,
+    const raftRpcProctoc::TransferLeadershipArgs* request,
+    raftRpcProctoc::TransferLeadershipReply* reply
+) {
+    void* raft_node = FindGroup(request->groupid());
+    if (!raft_node) {
+        return UnknownGroup(request->groupid());
+    }
+    reply->set_success(false);
+    // auto raft = static_cast<Raft*>(raft_node);
+    // raft->ProcessTransferLeadership(request, reply);
+    return grpc::Status::OK;
+}
+
+/**
+ * @brief 成员变更
+ * @details 与 TransferLeadership 一样在 gRPC 线程里阻塞等待新配置提交，不占用协程调度线程
+ */
+grpc::Status RaftRpcServiceImpl::ChangeMembership(
+    grpc::ServerContext* context,
+    const raftRpcProctoc::ChangeMembershipArgs* request,
+    raftRpcProctoc::ChangeMembershipReply* reply
+) {
+    void* raft_node = FindGroup(request->groupid());
+    if (!raft_node) {
+        return UnknownGroup(request->groupid());
+    }
+    reply->set_success(false);
+    // auto raft = static_cast<Raft*>(raft_node);
+    // raft->ProcessChangeMembership(request, reply);
+    return grpc::Status::OK;
+}
+
+// 新快照的第一块：丢弃之前的半成品，重新创建 spool 文件
+void RaftRpcServiceImpl::ResetPendingSnapshot(PendingSnapshot* pending, const raftRpcProctoc::SnapshotChunk& first) {
+    if (pending->fd >= 0) {
+        ::close(pending->fd);
+    }
+    pending->meta = SnapshotMeta();
+    pending->meta.term = first.term();
+    pending->meta.leader_id = first.leaderid();
+    pending->meta.last_included_index = first.lastincludedindex();
+    pending->meta.last_included_term = first.lastincludedterm();
+    pending->meta.total_size = first.totalsize();
+    pending->meta.group_id = first.groupid();
+    pending->received = 0;
+    pending->fd = ::open(SpoolPath(first.groupid()).c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+}
+
+grpc::Status RaftRpcServiceImpl::InstallSnapshotStream(
+    grpc::ServerContext* context,
+    grpc::ServerReader<raftRpcProctoc::SnapshotChunk>* reader,
+    raftRpcProctoc::InstallSnapshotReply* reply
+) {
+    raftRpcProctoc::SnapshotChunk chunk;
+    if (!reader->Read(&chunk)) {
+        return grpc::Status::OK;  // 空流
+    }
+
+    // 第一块携带 groupId：找到目标组及其接收状态
+    const uint64_t group_id = chunk.groupid();
+    void* raft_node = FindGroup(group_id);
+    std::shared_ptr<PendingSnapshot> pending = FindPendingSnapshot(group_id);
+    if (!raft_node || !pending) {
+        return UnknownGroup(group_id);
+    }
+
+    // 同一组同一时刻只处理一个快照流；旧领导人的残留流会在这里排队
+    std::lock_guard<std::mutex> lock(pending->mutex);
+
+    // 拿到锁之后再读任期 (排队期间可能已经换了领导人)：任期落后的流直接拒绝，不碰当前领导人的 spool，
+    // 回复本组的任期，旧领导人据此得知自己已被取代
+    uint64_t current_term = 0;
+    if (GroupTerm(group_id, &current_term) && chunk.term() < current_term) {
+        reply->set_term(current_term);
+        reply->set_accepted(false);
+        return grpc::Status::OK;
+    }
+    reply->set_term(std::max<uint64_t>(chunk.term(), current_term));
+
+    const SnapshotMeta& cur = pending->meta;
+    bool same_snapshot = pending->fd >= 0 &&
+                         cur.term == chunk.term() &&
+                         cur.last_included_index == chunk.lastincludedindex() &&
+                         cur.last_included_term == chunk.lastincludedterm() &&
+                         cur.total_size == chunk.totalsize();
+    if (!same_snapshot || chunk.offset() == 0) {
+        ResetPendingSnapshot(pending.get(), chunk);
+        if (pending->fd < 0) {
+            return grpc::Status(grpc::StatusCode::INTERNAL, "Cannot open snapshot spool file");
+        }
+    }
+
+    do {
+        // offset 不连续：提前结束本次流，告诉领导人从哪里续传
+        if (chunk.offset() != pending->received) {
+            reply->set_nextoffset(pending->received);
+            reply->set_accepted(false);
+            return grpc::Status::OK;
+        }
+
+        const std::string& data = chunk.data();
+        size_t written = 0;
+        while (written < data.size()) {
+            ssize_t n = ::pwrite(pending->fd, data.data() + written, data.size() - written,
+                                 static_cast<off_t>(chunk.offset() + written));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                reply->set_nextoffset(pending->received);
+                return grpc::Status(grpc::StatusCode::INTERNAL, "Write snapshot spool failed");
+            }
+            written += static_cast<size_t>(n);
+        }
+        pending->received += data.size();
+
+        if (chunk.done()) {
+            reply->set_nextoffset(pending->received);
+            // 领导人读到文件末尾 (n == 0) 时也会置 done：字节数不足说明它的快照文件被截断，不能当作完整快照安装
+            if (pending->received != pending->meta.total_size) {
+                reply->set_accepted(false);
+                return grpc::Status::OK;
+            }
+            ::fsync(pending->fd);
+
+            // 交给 Raft 核心安装：由协程读取 spool 文件 (load_snapshot_from_fd)，同 InstallSnapshot；
+            // 文件完整即默认接受，核心拒绝 (任期落后 / 快照比已应用的旧) 时把 accepted 置回 false
+            reply->set_accepted(true);
+            auto scheduler = monsoon::Scheduler::GetThis();
+            std::promise<void> prom;
+            auto fut = prom.get_future();
+            int fd = pending->fd;
+            SnapshotMeta meta = pending->meta;
+            scheduler->scheduler([raft_node, fd, meta, reply, &prom]() {
+                // auto raft = static_cast<Raft*>(raft_node);
+                // raft->ProcessInstallSnapshotFile(meta, fd, reply);
+                prom.set_value();
+            });
+            fut.wait();
+
+            ::close(pending->fd);
+            pending->fd = -1;
+            pending->meta = SnapshotMeta();
+            pending->received = 0;
+            return grpc::Status::OK;
+        }
+    } while (reader->Read(&chunk));
+
+    // 领导人中途断开：保留已落盘的数据，等待续传
+    reply->set_nextoffset(pending->received);
+    reply->set_accepted(false);
+    return grpc::Status::OK;
+}
+
 // =========================================================
 //  PART 4: RaftRpcServer 实现 (服务端启动管理)
 // =========================================================
@@ -407,6 +1156,8 @@ void RaftRpcServer::Stop() {
 void RaftRpcServer::StartAsync() {
     // 启动一个独立的 std::thread 来运行 gRPC 的阻塞循环
     server_thread_ = std::thread([this]() {
+        // gRPC 没有线程创建的钩子：先把本线程绑到 grpc 组，BuildAndStart 创建的 poller / 处理线程继承这个亲和性
+        ThreadPlacement::GetInstance().PinCurrentThread(kPlacementGrpc);
         this->Start();
     });
 }
@@ -415,23 +1166,72 @@ void RaftRpcServer::StartAsync() {
 //  PART 5: 工具函数
 // =========================================================
 
-std::string SerializeOp(const raftKVRpcProctoc::Op& op) {
-    std::string serialized;
-    // Protobuf 提供的序列化方法
-    op.SerializeToString(&serialized);
-    return serialized;
+std::string SerializeOp(const Op& op) {
+    return op.asString();
+}
+
+bool DeserializeOp(const std::string& data, Op* op) {
+    return op->parseFromString(data);
+}
+
+bool DeserializeOpView(const std::string& data, OpView* view) {
+    return DecodeOpView(data, view);
+}
+
+std::string SerializeOpBatch(const OpBatch& batch) {
+    return batch.asString();
 }
 
-bool DeserializeOp(const std::string& data, raftKVRpcProctoc::Op* op) {
-    // Protobuf 提供的反序列化方法
-    return op->ParseFromString(data);
+bool DeserializeOpBatchView(std::string_view data, OpBatchView* view) {
+    if (IsOpGroup(data)) {
+        return false;  // 多个客户端的命令：调用方逐条解码
+    }
+    if (IsBinaryOpBatch(data)) {
+        return DecodeOpBatchView(data, view);
+    }
+    OpView op;
+    if (!DecodeOpView(data, &op)) {
+        return false;
+    }
+    view->ClientId = op.ClientId;
+    view->ClientIsNumeric = op.ClientIsNumeric;
+    view->ClientNum = op.ClientNum;
+    view->RequestId = op.RequestId;
+    view->Ops.assign(1, op);
+    return true;
+}
+
+SnapshotChunkReader MakeFdChunkReader(int fd) {
+    return [fd](uint64_t offset, char* buf, size_t len) -> ssize_t {
+        ssize_t n;
+        do {
+            n = ::pread(fd, buf, len, static_cast<off_t>(offset));
+        } while (n < 0 && errno == EINTR);
+        return n;
+    };
 }
 
-raftRpcProctoc::LogEntry MakeLogEntry(int term, int index, const std::string& command) {
+SnapshotChunkReader MakeStringChunkReader(const std::string& data) {
+    return [&data](uint64_t offset, char* buf, size_t len) -> ssize_t {
+        if (offset >= data.size()) {
+            return 0;
+        }
+        size_t n = std::min<size_t>(len, data.size() - offset);
+        memcpy(buf, data.data() + offset, n);
+        return static_cast<ssize_t>(n);
+    };
+}
+
+raftRpcProctoc::LogEntry MakeLogEntry(int term, int index, const std::string& command,
+                                      const TraceContext& trace) {
     raftRpcProctoc::LogEntry entry;
     entry.set_term(term);
     entry.set_index(index);
     entry.set_command(command);
+    if (trace.Sampled()) {
+        entry.set_traceid(trace.trace_id);
+        entry.set_spanid(trace.span_id);
+    }
     return entry;
 }
 
@@ -0,0 +1,236 @@
+#include "replication_pipeline.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "cpu_topology.h"
+#include "trace.h"
+
+namespace raft {
+
+// 一次 AppendEntries 往返 (发送到 follower 确认)，arg 为这批的最后一条 index
+static void RecordReplicateSpans(const std::vector<TraceContext>& traced, uint64_t send_ns, uint64_t last_index) {
+    uint64_t now = TraceNowNanos();
+    for (const TraceContext& ctx : traced) {
+        SpanRecord span;
+        span.trace_id = ctx.trace_id;
+        span.span_id = Tracer::NewId();
+        span.parent_id = ctx.span_id;
+        span.name = "raft.replicate";
+        span.start_ns = send_ns;
+        span.end_ns = now;
+        span.arg_key = "last_index";
+        span.arg_value = last_index;
+        Tracer::GetInstance().Record(span);
+    }
+}
+
+// =========================================================
+//  PART 1: 生命周期
+// =========================================================
+
+std::shared_ptr<ReplicationPipeline> ReplicationPipeline::Create(
+    std::shared_ptr<RaftRpcClient> client,
+    ReplicationSource* source,
+    const PipelineConfig& config
+) {
+    // 构造函数私有：回调里需要 weak_from_this()，必须由 shared_ptr 管理
+    return std::shared_ptr<ReplicationPipeline>(new ReplicationPipeline(std::move(client), source, config));
+}
+
+ReplicationPipeline::ReplicationPipeline(std::shared_ptr<RaftRpcClient> client, ReplicationSource* source,
+                                         const PipelineConfig& config)
+    : client_(std::move(client)), source_(source), config_(config),
+      window_(ReplicationWindowConfig{config.max_batch_entries, config.max_inflight, config.linger_us}) {
+    config_.max_inflight = std::max<size_t>(config_.max_inflight, 1);
+    config_.max_batch_entries = std::max<size_t>(config_.max_batch_entries, 1);
+}
+
+ReplicationPipeline::~ReplicationPipeline() {
+    Stop();
+}
+
+void ReplicationPipeline::Start(uint64_t next_index) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    window_.Restart(next_index);
+    sender_ = std::thread([this]() { SendLoop(); });
+}
+
+void ReplicationPipeline::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+        window_.Invalidate();  // 让所有在途回复失效
+    }
+    cv_.notify_all();
+    if (sender_.joinable()) {
+        if (sender_.get_id() == std::this_thread::get_id()) {
+            sender_.detach();  // 在回调中 (发送线程内) 调用 Stop：循环会在 running_ = false 后自行退出
+        } else {
+            sender_.join();
+        }
+    }
+}
+
+void ReplicationPipeline::Notify() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        window_.MarkPending(std::chrono::steady_clock::now());
+    }
+    cv_.notify_one();
+}
+
+void ReplicationPipeline::ResetAfterSnapshot(uint64_t last_included_index) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        window_.ResetAfterSnapshot(last_included_index);
+    }
+    cv_.notify_one();
+}
+
+uint64_t ReplicationPipeline::MatchIndex() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return window_.MatchIndex();
+}
+
+uint64_t ReplicationPipeline::NextIndex() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return window_.NextIndex();
+}
+
+size_t ReplicationPipeline::InflightCount() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return window_.InflightCount();
+}
+
+// =========================================================
+//  PART 2: 发送线程 (批量 + 流水线)
+// =========================================================
+
+void ReplicationPipeline::SendLoop() {
+    ThreadPlacement::GetInstance().PinCurrentThread(kPlacementRaft);
+    std::weak_ptr<ReplicationPipeline> weak_self = weak_from_this();
+    std::unique_lock<std::mutex> lock(mtx_);
+
+    while (running_) {
+        ReplicationWindow::Decision decision =
+            window_.Next(std::chrono::steady_clock::now(), source_->FirstIndex(), source_->LastIndex());
+        if (decision.action == ReplicationWindow::Action::kIdle) {
+            // 无日志可发、窗口已满或等待快照：直到 Notify / 回复 / Stop 唤醒
+            cv_.wait(lock);
+            continue;
+        }
+        if (decision.action == ReplicationWindow::Action::kWaitUntil) {
+            // 有待发日志但还在 linger 窗口内：等到 linger 到期或被新日志/回复唤醒
+            cv_.wait_until(lock, decision.deadline);
+            continue;
+        }
+
+        // 1. next_index 已被快照压缩：需要先发送快照
+        if (decision.action == ReplicationWindow::Action::kNeedSnapshot) {
+            SnapshotCallback cb = on_need_snapshot_;
+            lock.unlock();
+            if (cb) cb();
+            lock.lock();
+            continue;
+        }
+
+        // 2. 组装一批日志
+        uint64_t next_index = window_.NextIndex();
+        uint64_t prev_index = next_index - 1;
+        raftRpcProctoc::AppendEntriesArgs args;
+        args.set_term(source_->CurrentTerm());
+        args.set_leaderid(source_->LeaderId());
+        args.set_prevlogindex(prev_index);
+        args.set_prevlogterm(prev_index == 0 ? 0 : source_->TermAt(prev_index));
+        args.set_leadercommit(static_cast<int32_t>(source_->CommitIndex()));
+        size_t n = source_->CopyEntries(next_index, config_.max_batch_entries, config_.max_batch_bytes,
+                                        args.mutable_entries());
+        if (n == 0) {
+            // 日志被并发截断 / 压缩：不按 linger 空转重试，等下一次 Notify (或回复触发的回退)
+            window_.OnEmptyCopy();
+            continue;
+        }
+
+        // 批内被采样的日志 (未采样时只是逐条比较一个字段)：回复成功时各记录一个 raft.replicate span
+        std::vector<TraceContext> traced;
+        for (const raftRpcProctoc::LogEntry& entry : args.entries()) {
+            if (entry.traceid() != 0) {
+                traced.push_back(TraceContext{entry.traceid(), entry.spanid()});
+            }
+        }
+        uint64_t send_ns = traced.empty() ? 0 : TraceNowNanos();
+
+        ReplicationWindow::Batch batch = window_.OnSent(n);
+        uint64_t last_index = batch.last_index;
+        uint64_t generation = batch.generation;
+
+        // 3. 发送 (不持锁，回调在 gRPC Poller 线程中执行)
+        lock.unlock();
+        client_->AsyncAppendEntries(
+            args,
+            [weak_self, generation, last_index, traced = std::move(traced), send_ns](
+                bool ok, const raftRpcProctoc::AppendEntriesReply& reply) {
+                if (ok && reply.success() && !traced.empty()) {
+                    RecordReplicateSpans(traced, send_ns, last_index);
+                }
+                if (auto self = weak_self.lock()) {
+                    self->HandleReply(generation, last_index, ok, reply);
+                }
+            },
+            nullptr,
+            config_.rpc_timeout_ms);
+        lock.lock();
+    }
+}
+
+// =========================================================
+//  PART 3: 回复处理 (确认 / 快速回退)
+// =========================================================
+
+void ReplicationPipeline::HandleReply(uint64_t generation, uint64_t last_index, bool ok,
+                                      const raftRpcProctoc::AppendEntriesReply& reply) {
+    MatchCallback match_cb;
+    TermCallback term_cb;
+    uint64_t new_match = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!running_) {
+            return;
+        }
+
+        ReplicationReply r;
+        r.ok = ok;
+        if (ok) {
+            r.success = reply.success();
+            r.term = reply.term();
+            r.conflict_term = reply.conflictterm();
+            r.conflict_index = reply.conflictindex();
+        }
+        ReplicationWindow::ReplyResult result = window_.OnReply(
+            generation, last_index, r, source_->CurrentTerm(),
+            [this](uint64_t term) { return source_->LastIndexOfTerm(term); });
+        if (result == ReplicationWindow::ReplyResult::kHigherTerm) {
+            // 发现更高任期：交给 Raft 核心退位，管道本身不做处理
+            term_cb = on_higher_term_;
+        } else if (result == ReplicationWindow::ReplyResult::kMatchAdvanced) {
+            new_match = window_.MatchIndex();
+            match_cb = on_match_;
+        }
+    }
+
+    cv_.notify_one();
+    if (term_cb) term_cb(reply.term());
+    if (match_cb) match_cb(new_match);
+}
+
+} // namespace raft
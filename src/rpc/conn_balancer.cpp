@@ -0,0 +1,36 @@
+#include "conn_balancer.h"
+
+#include <algorithm>
+#include <cmath>
+
+PoolSizer::PoolSizer(const Options& options) : options_(options) {
+  options_.min_size = std::max<size_t>(1, options_.min_size);
+  options_.max_size = std::max(options_.min_size, options_.max_size);
+  options_.target_inflight = std::max<int64_t>(1, options_.target_inflight);
+}
+
+size_t PoolSizer::Observe(int64_t inflight, size_t current, Clock::time_point now) {
+  concurrency_ = 0.75 * concurrency_ + 0.25 * static_cast<double>(std::max<int64_t>(0, inflight));
+  size_t desired = static_cast<size_t>(std::ceil(concurrency_ / static_cast<double>(options_.target_inflight)));
+  desired = std::max(options_.min_size, std::min(options_.max_size, desired));
+
+  if (desired > current) {
+    below_ = false;
+    return current + 1;
+  }
+  if (desired == current) {
+    below_ = false;
+    return current;
+  }
+  // 持续低于期望 shrink_delay 才缩一个，之后重新计时
+  if (!below_) {
+    below_ = true;
+    below_since_ = now;
+    return current;
+  }
+  if (now - below_since_ >= options_.shrink_delay) {
+    below_since_ = now;
+    return current - 1;
+  }
+  return current;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file conn_balancer.h
+ * @brief 连接池的选路与伸缩策略 (与网络无关，ConnectionPool 使用)
+ * @details
+ * - 选路：power-of-two-choices。随机取两个候选，选在途请求数 (相同则比在途字节数) 较少的一个。
+ *   轮询会把调用均匀分给每个连接，其中一个连接卡住 (发送缓冲区满 / 对端慢) 时它仍分到同样多的请求；
+ *   P2C 只需要两次原子读，却能让卡住的连接几乎不再接新请求，且不像“全局最小”那样让所有调用挤向同一个连接。
+ * - 伸缩：按在途请求总数的 EWMA 估计并发度，期望连接数 = ceil(并发度 / target_inflight)，限制在
+ *   [min_size, max_size]。扩容立即进行 (每次一个)；缩容要求持续低于期望 shrink_delay 之后才进行，
+ *   同样每次一个，避免负载抖动时反复建连、断连。
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// 单个连接的负载快照
+struct ConnectionLoad {
+  int64_t requests = 0;   // 已发出、尚未完成的请求数
+  int64_t bytes = 0;      // 这些请求的请求体字节数
+  bool connected = true;
+};
+
+/**
+ * @brief P2C：在 [0, n) 中随机取两个不同的下标，返回负载较低的一个 (断开的连接视为无穷大)
+ * @param load 下标 -> ConnectionLoad
+ */
+template <typename LoadFn>
+size_t PickPowerOfTwo(size_t n, LoadFn&& load);
+
+class PoolSizer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Options {
+    size_t min_size = 1;
+    size_t max_size = 1;
+    int64_t target_inflight = 8;                         // 每个连接期望承载的在途请求数
+    std::chrono::milliseconds shrink_delay{30000};
+  };
+
+  explicit PoolSizer(const Options& options);
+
+  /**
+   * @brief 输入一次采样 (当前在途请求总数与连接数)，返回应有的连接数
+   * @return current + 1 (扩容)、current - 1 (缩容) 或 current；不加锁，由调用方串行化
+   */
+  size_t Observe(int64_t inflight, size_t current, Clock::time_point now = Clock::now());
+
+  double Concurrency() const { return concurrency_; }
+  const Options& options() const { return options_; }
+
+ private:
+  Options options_;
+  double concurrency_ = 0;
+  bool below_ = false;
+  Clock::time_point below_since_;
+};
+
+// ============================================================================
+// 模板实现
+// ============================================================================
+
+namespace conn_balancer_detail {
+
+// 线程局部的 xorshift64*，选路热路径上不加锁、不共享状态
+inline uint64_t NextRandom() {
+  thread_local uint64_t state = 0;
+  if (state == 0) {
+    state = reinterpret_cast<uintptr_t>(&state) ^
+            static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()) ^
+            0x9E3779B97F4A7C15ull;
+  }
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+  return state * 0x2545F4914F6CDD1Dull;
+}
+
+inline bool Lighter(const ConnectionLoad& a, const ConnectionLoad& b) {
+  if (a.connected != b.connected) return a.connected;
+  if (a.requests != b.requests) return a.requests < b.requests;
+  return a.bytes < b.bytes;
+}
+
+}  // namespace conn_balancer_detail
+
+template <typename LoadFn>
+size_t PickPowerOfTwo(size_t n, LoadFn&& load) {
+  if (n <= 1) return 0;
+  uint64_t r = conn_balancer_detail::NextRandom();
+  size_t a = static_cast<size_t>(r % n);
+  size_t b = static_cast<size_t>((r >> 32) % (n - 1));
+  if (b >= a) ++b;
+  return conn_balancer_detail::Lighter(load(b), load(a)) ? b : a;
+}
@@ -0,0 +1,143 @@
+/**
+ * @file kv_router.h
+ * @brief KV 客户端 (clerk) 的路由缓存：key -> 区间 -> 领导人 -> 连接池
+ * @details
+ * 热路径 (Locate) 上不访问 ZooKeeper、不碰 g_pools_mutex：
+ * - key -> 组：RangeTable (读锁；单组部署时不需要区间表，所有 key 都属于 group 0)；
+ * - 组 -> 领导人：本地缓存 (读锁)，由 ERR_NOT_LEADER 携带的 leader_id 与连接失败更新；
+ * - 节点 -> 连接：不可变快照，原子地整体替换，读方只做一次 shared_ptr 原子加载。
+ *   每个节点一个直连模式的 MprpcChannel，自带 ConnectionPool。
+ *
+ * 节点目录 (node_id -> "ip:port") 在构造时给定 (与 Raft 的 peers 配置一致)；
+ * WatchService 之后，ZooKeeper 上 /{root}/{service}/ip:port 的增删决定节点是否在线：
+ * 下线节点的连接被丢弃，指向它的领导人缓存被清除，下次请求改为轮询该组的其他副本。
+ *
+ * 使用方式 (clerk 的一次请求)：
+ * @code
+ * KvRouter::Route route;
+ * router.Locate(key, &route);
+ * Stub(route.channel.get()).Put(&cntl, &req, &resp, nullptr);
+ * if (cntl.Failed())                                  router.OnUnreachable(route);
+ * else if (resp.error().code() == kv::ERR_NOT_LEADER) router.OnNotLeader(route, resp.error().leader_id());
+ * @endcode
+ */
+
+#pragma once
+
+#include "range_table.h"
+#include "rpcclient.h"
+#include "zookeeperutil.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class KvRouter {
+ public:
+  using ChannelFactory =
+      std::function<std::shared_ptr<google::protobuf::RpcChannel>(const std::string& ip, uint16_t port)>;
+
+  struct Options {
+    std::unordered_map<int32_t, std::string> nodes;  // node_id -> "ip:port"
+    RpcClientConfig rpc_config;
+    // 为一个节点创建连接；默认创建直连模式的 MprpcChannel (测试可替换)
+    ChannelFactory channel_factory;
+  };
+
+  /**
+   * @brief 一次请求的路由结果
+   */
+  struct Route {
+    uint64_t group_id = 0;
+    uint64_t epoch = 0;      // 区间 epoch，服务端按此判断客户端的路由是否过期
+    int32_t node_id = -1;    // 本次发往的节点 (不一定是领导人：领导人未知时轮询副本)
+    std::shared_ptr<google::protobuf::RpcChannel> channel;
+  };
+
+  /**
+   * @param ranges 区间表；为 nullptr 时所有 key 属于 group 0，副本为全部节点
+   */
+  explicit KvRouter(Options options, const raft::RangeTable* ranges = nullptr);
+  ~KvRouter();
+
+  KvRouter(const KvRouter&) = delete;
+  KvRouter& operator=(const KvRouter&) = delete;
+
+  /**
+   * @brief 查找 key 应发往的节点
+   * @return key 不属于任何区间或该组没有在线副本时返回 false
+   */
+  bool Locate(std::string_view key, Route* route);
+
+  /**
+   * @brief 直接按组查找 (Scan / 批量请求已经按组拆分)
+   */
+  bool LocateGroup(uint64_t group_id, Route* route);
+
+  /**
+   * @brief 收到 ERR_NOT_LEADER：leader_hint 是合法的在线副本则直接采用，否则换下一个副本
+   * @details proto3 中 leader_id 缺省为 0，因此 node_id 从 1 开始编号，0 表示服务端也不知道领导人
+   */
+  void OnNotLeader(const Route& route, uint32_t leader_hint);
+
+  /**
+   * @brief 连接失败 / 超时：该节点暂时不再作为该组的领导人
+   */
+  void OnUnreachable(const Route& route);
+
+  /**
+   * @brief 监听 ZooKeeper 上的服务实例列表，实例增删时在后台刷新在线节点
+   */
+  bool WatchService(ZkClient& zk, const std::string& service_name);
+
+  /**
+   * @brief 按给定的在线地址列表刷新连接 (WatchService 的后台线程调用，也可手动调用)
+   */
+  void UpdateLiveEndpoints(const std::vector<std::string>& addrs);
+
+  /**
+   * @brief 当前缓存的领导人，未知时返回 -1
+   */
+  int32_t CachedLeader(uint64_t group_id) const;
+
+ private:
+  // node_id -> 在线节点的连接，整体替换，发布后不再修改
+  using EndpointMap = std::unordered_map<int32_t, std::shared_ptr<google::protobuf::RpcChannel>>;
+
+  std::shared_ptr<const EndpointMap> Endpoints() const { return std::atomic_load(&endpoints_); }
+  bool Replicas(uint64_t group_id, std::vector<int32_t>* replicas, uint64_t* epoch) const;
+  bool Pick(uint64_t group_id, const std::vector<int32_t>& replicas, uint64_t epoch, Route* route);
+  void Advance(const Route& route);  // 把该组的领导人缓存换成下一个副本
+  void RefreshLoop();
+
+  Options options_;
+  const raft::RangeTable* ranges_;
+  std::vector<int32_t> all_nodes_;  // 单组部署时的副本集合 (按 node_id 排序)
+
+  std::shared_ptr<const EndpointMap> endpoints_;
+  std::mutex endpoints_mutex_;  // 只串行化写方 (UpdateLiveEndpoints)
+
+  mutable std::shared_mutex leaders_mutex_;
+  std::unordered_map<uint64_t, int32_t> leaders_;  // group_id -> 缓存的领导人
+
+  // 回调只做标记 (不占用 ZkClient 的事件线程)，由 refresh_thread_ 重新拉取并重新设置 Watch。
+  // ZkClient 没有按服务摘除回调的接口，回调只持有这份共享状态，本对象析构后回调仍可安全执行
+  struct RefreshState {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool pending = false;
+    bool stopping = false;
+  };
+  ZkClient* zk_ = nullptr;
+  std::string service_name_;
+  std::shared_ptr<RefreshState> refresh_ = std::make_shared<RefreshState>();
+  std::thread refresh_thread_;
+};
@@ -41,6 +41,8 @@
 #define SPDLOG_ACTIVE_LEVEL SPDLOG_LEVEL_TRACE // 开启所有级别的编译
 #include <spdlog/spdlog.h>
 
+#include "binlog.h"
+
 //  解除 Muduo 或其他库可能存在的宏定义冲突
 #ifdef LOG_TRACE
   #undef LOG_TRACE
@@ -63,6 +65,7 @@
 
 //  定义方便的日志宏，直接映射到 spdlog 的宏
 // 使用这些宏可以保留文件行号信息，并且是零成本抽象
+// 注意：spdlog 在调用线程上格式化；每个请求都会走到的热路径改用 binlog.h 的 BLOG_* (同样的 {} 格式串)
 #define LOG_TRACE(...) SPDLOG_TRACE(__VA_ARGS__)
 #define LOG_DEBUG(...) SPDLOG_DEBUG(__VA_ARGS__)
 #define LOG_INFO(...)  SPDLOG_INFO(__VA_ARGS__)
@@ -245,6 +248,18 @@ class MprpcApplication {
   void InitLogging(const std::string& log_file, const std::string& log_level);
   void InitLoggingAsync(const std::string& log_file, const std::string& log_level);
 
+  /**
+   * @brief 启动 BinLogger (BLOG_* / DPrintf)：后台线程格式化后直接写进 spdlog 的 sinks
+   * @param sinks 与 LOG_* 共用的 sinks (时间戳、线程号、文件行号取自记录本身)
+   * @param level 运行期级别，与 spdlog logger 相同
+   */
+  void InitBinLog(const std::vector<spdlog::sink_ptr>& sinks, spdlog::level::level_enum level);
+
+  /**
+   * @brief 按 placement.enable / placement.<group> 配置线程放置 (见 cpu_topology.h)
+   */
+  void InitPlacement();
+
   /**
    * @brief 注册信号处理器 (捕获 SIGINT/SIGTERM)
    */
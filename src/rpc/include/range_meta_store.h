@@ -0,0 +1,109 @@
+/**
+ * @file range_meta_store.h
+ * @brief Multi-Raft 区间元数据在 ZooKeeper 中的持久化与监听
+ * @details
+ * 布局：{root}/{group_id} 为持久节点，数据为 EncodeRangeDescriptor 的结果。
+ * 写入方：只有该组的领导人在分裂 / 合并 / 副本变更的日志 apply 之后写自己组 (以及分裂出的新组)
+ * 的描述，因此同一节点不会有并发写者；Put 仍会拒绝 epoch 不增大的描述，防止旧领导人回写。
+ *
+ * 读取方：每个节点 Watch 一次，之后子节点增删或任一描述变化都会触发后台重载，
+ * 全量刷新本地 RangeTable。
+ *
+ * 负载均衡 (见 placement.h)：
+ * - {load_root}/{node_id}：临时节点，各节点周期性写入 NodeLoadReport，节点下线后自动消失；
+ * - {moves_root}/{group_id}：持久节点，调度器写入 PlacementMove，该组领导人执行完后删除。
+ *   调度器下一轮把仍存在指令的组作为 busy_groups 传给 PlanRebalance，同一组不会叠加指令。
+ */
+
+#pragma once
+
+#include "placement.h"
+#include "range_table.h"
+#include "zookeeperutil.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class RangeMetaStore {
+ public:
+  explicit RangeMetaStore(ZkClient& zk, const std::string& root = "/kv/ranges",
+                          const std::string& load_root = "/kv/load", const std::string& moves_root = "/kv/moves");
+  ~RangeMetaStore();
+
+  RangeMetaStore(const RangeMetaStore&) = delete;
+  RangeMetaStore& operator=(const RangeMetaStore&) = delete;
+
+  /**
+   * @brief 写入 / 更新一个组的描述
+   * @return 已有描述的 epoch 不小于 desc.epoch 或 ZooKeeper 操作失败时返回 false
+   */
+  bool Put(const raft::RangeDescriptor& desc);
+
+  /**
+   * @brief 删除一个组的描述 (合并后被吸收的组)
+   */
+  bool Remove(uint64_t group_id);
+
+  /**
+   * @brief 读取全部描述；watch 为 true 时同时为根节点和每个子节点设置 Watch
+   */
+  bool LoadAll(std::vector<raft::RangeDescriptor>* descs, bool watch = false);
+
+  /**
+   * @brief 全量加载到 table，并在之后的每次变化时自动重载
+   * @details table 必须比本对象活得久
+   */
+  bool Watch(raft::RangeTable* table);
+
+  // ========== 负载上报与调度指令 ==========
+
+  /**
+   * @brief 发布本节点的负载报告 (不存在则创建临时节点，否则覆盖)
+   */
+  bool PublishLoad(const raft::NodeLoadReport& report);
+
+  /**
+   * @brief 读取所有在线节点的负载报告 (调度器使用)
+   */
+  bool LoadReports(std::vector<raft::NodeLoadReport>* reports);
+
+  /**
+   * @brief 下发一条调度指令；该组已有未完成的指令时返回 false
+   */
+  bool IssueMove(const raft::PlacementMove& move);
+
+  /**
+   * @brief 列出所有未完成的指令 (领导人据此找自己组的指令，调度器据此得到 busy_groups)
+   */
+  bool ListMoves(std::vector<raft::PlacementMove>* moves);
+
+  /**
+   * @brief 指令执行完成 (或放弃) 后删除
+   */
+  bool FinishMove(uint64_t group_id);
+
+ private:
+  std::string PathOf(uint64_t group_id) const;
+  bool Reload();
+  void ReloadLoop();
+  void OnChanged();  // 任意 Watch 事件：标记需要重载
+
+  ZkClient& zk_;
+  std::string root_;
+  std::string load_root_;
+  std::string moves_root_;
+
+  raft::RangeTable* table_ = nullptr;
+  std::vector<std::string> watched_;  // 已注册回调的路径，析构时清理
+
+  // 回调在 ZkClient 的事件线程中串行执行，全量重载较慢，放在这里会推迟其他监听者的事件，
+  // 因此只做标记，由 reload_thread_ 完成重载
+  std::mutex reload_mutex_;
+  std::condition_variable reload_cv_;
+  bool reload_pending_ = false;
+  bool stopping_ = false;
+  std::thread reload_thread_;
+};
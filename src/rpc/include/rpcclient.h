@@ -16,8 +16,13 @@
 #include <vector>
 #include <string>
 #include <functional>
+#include <future>
 #include <chrono>
+#include "conn_balancer.h"
+#include "latency_tracker.h"
 #include "rpccontroller.h"
+#include "timer_wheel.h"
+#include "trace.h"
 #include "zookeeperutil.h"   
 
 // ============================================================================
@@ -25,18 +30,42 @@
 // ============================================================================
 struct RpcClientConfig {
   int connect_timeout_ms = 3000;      // 连接超时 (毫秒)
-  int rpc_timeout_ms = 5000;          // RPC 调用超时 (毫秒)
+  int rpc_timeout_ms = 5000;          // RPC 调用超时 (毫秒)；开启自适应超时时为上限与样本不足时的取值
   int max_retry_times = 3;            // 最大重试次数
   int max_message_size = 10 * 1024 * 1024;  // 最大消息 10MB
 
     // 连接池配置
-  int connection_pool_size = 4;        // 连接池大小（建议 = CPU 核数）
-  int io_thread_pool_size = 2;         // IO 线程数（接收线程）
+  int connection_pool_size = 4;        // 连接池初始 / 最小连接数（建议 = CPU 核数）
+  int max_connection_pool_size = 16;   // 按在途并发度扩容的上限 (不大于 connection_pool_size 时为固定大小)
+  int target_inflight_per_connection = 8;   // 每个连接期望承载的在途请求数，并发度超过即扩容
+  int pool_shrink_delay_ms = 30000;    // 并发度持续低于当前连接数这么久才缩容一个连接
+  int io_thread_pool_size = 2;         // 客户端共享 reactor 的 IO 线程数 (进程级，以第一个创建 reactor 的配置为准)
 
   bool enable_auto_reconnect = true;  // 是否自动重连
   bool enable_heartbeat = false;      // 是否启用心跳 (预留)
+
+  // 同步调用 (done == nullptr) 发生在 monsoon 协程中时，挂起协程而不是阻塞 OS 线程
+  bool fiber_aware_wait = true;
+
+  // 自适应超时：按目标端点最近的延迟分布取 clamp(p99 * multiplier, min_rpc_timeout_ms, rpc_timeout_ms)，
+  // controller 显式 SetTimeout 时以显式值为准
+  bool adaptive_timeout = true;
+  int min_rpc_timeout_ms = 50;
+  double timeout_p99_multiplier = 3.0;
+
+  // 对冲请求：controller->SetHedgeable(true) 的幂等调用在超过端点 p95 仍未返回时，
+  // 向第二个副本再发一份，先到的响应生效 (仅服务发现模式且有多个实例时)
+  bool enable_hedging = true;
+  int hedge_budget_percent = 10;      // 对冲请求数不超过可对冲调用数的该比例，防止副本整体变慢时流量翻倍
 };
 
+namespace monsoon {
+class Fiber;
+class Scheduler;
+}
+
+class RpcConnection;
+
 // ============================================================================
 // 请求上下文
 // ============================================================================
@@ -46,12 +75,76 @@ struct PendingRpcContext {
     google::protobuf::RpcController* controller;
     google::protobuf::Closure* done;
     
+    // 线程同步等待时使用 (异步 / 协程模式下不会有人等在 cv 上)
     std::mutex mutex;
     std::condition_variable cv;
     bool finished = false;
+
+    // 协程同步等待时使用：完成方把 waiter 投递回它所在的调度线程
+    std::shared_ptr<monsoon::Fiber> waiter;
+    monsoon::Scheduler* scheduler = nullptr;
+    int thread = -1;
     
     std::chrono::steady_clock::time_point start_time;
     std::chrono::steady_clock::time_point send_time;
+    std::chrono::steady_clock::time_point deadline;   // 超过该时间由超时检查线程以失败完成
+
+    // 完成权：对冲时同一个上下文在表中登记两个 request_id，先 Take 到且置位 claimed 的一方完成请求
+    std::atomic<bool> claimed{false};
+    std::shared_ptr<LatencyTracker> latency;          // 目标端点的延迟统计
+    std::shared_ptr<RpcConnection> conn;              // 发送所用的连接，完成时归还其在途计数
+    size_t request_bytes = 0;
+
+    // 对冲 (仅可对冲的调用)：请求体的副本，调用方在 done 之后即可释放原请求
+    std::unique_ptr<google::protobuf::Message> hedge_request;
+    std::string service_name;
+    std::string method_name;
+    std::string hedge_target;                         // 第二个副本 "ip:port"
+    int hedge_budget_percent = 0;
+    std::atomic<uint64_t> hedge_id{0};                // 对冲请求的 request_id，未发出时为 0
+    std::shared_ptr<LatencyTracker> hedge_latency;
+    std::shared_ptr<RpcConnection> hedge_conn;
+    std::chrono::steady_clock::time_point hedge_send_time;
+
+    // 追踪 (未采样时 trace_id 为 0)：parent 为调用方的上下文，call_span 覆盖发送到完成，随 RpcHeader 下发
+    TraceContext trace_parent;
+    uint64_t call_span = 0;
+};
+
+// ============================================================================
+// 分片的在途请求表
+// ============================================================================
+/**
+ * @brief 按 request_id 分片的在途请求表
+ * @details request_id 单调递增，按低位取模即可均匀打散到各分片；
+ * 每个分片独立加锁并按 cache line 对齐，IO 线程、调用线程、超时线程之间基本不会争用同一把锁。
+ */
+class PendingRequestTable {
+public:
+    static constexpr size_t kShardCount = 64;   // 必须是 2 的幂
+
+    void Insert(uint64_t request_id, std::shared_ptr<PendingRpcContext> ctx);
+
+    // 查找并移除；返回空表示已被其他路径 (响应 / 超时 / 发送失败) 取走
+    std::shared_ptr<PendingRpcContext> Take(uint64_t request_id);
+
+    // 查找但不移除 (对冲定时器到期时读取上下文)
+    std::shared_ptr<PendingRpcContext> Find(uint64_t request_id);
+
+    // 收集 deadline 早于 now 的请求 id (不移除，由调用方通过 Take 竞争完成权)
+    void CollectExpired(std::chrono::steady_clock::time_point now, std::vector<uint64_t>* out);
+
+    size_t Size();
+
+private:
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, std::shared_ptr<PendingRpcContext>> requests;
+    };
+
+    Shard& ShardFor(uint64_t request_id) { return shards_[request_id & (kShardCount - 1)]; }
+
+    Shard shards_[kShardCount];
 };
 
 // ============================================================================
@@ -63,7 +156,13 @@ class ConnectionPool;
 // ============================================================================
 // 单个 TCP 连接封装
 // ============================================================================
-class RpcConnection {
+/**
+ * @brief 单个 TCP 连接
+ * @details 接收不再每个连接一个线程：非阻塞 fd 注册到进程共享的 monsoon::IOManager
+ * (io_thread_pool_size 个线程)，可读时在 reactor 线程中读到 EAGAIN、切包并回调。
+ * 必须由 shared_ptr 管理 (事件回调通过 weak_ptr 持有连接)。
+ */
+class RpcConnection : public std::enable_shared_from_this<RpcConnection> {
 public:
     explicit RpcConnection(int id, const std::string& ip, uint16_t port,
                            const RpcClientConfig& config);
@@ -71,47 +170,87 @@ public:
 
     bool Connect();
     void Close();
-    bool IsConnected() const { return fd_ != -1; }
+    bool IsConnected() const { return fd_.load() != -1; }
     int GetFd() const { return fd_; }
     int GetId() const { return id_; }
 
-    // 发送请求（线程安全）
+    // 发送请求（线程安全）；trace 已采样时写进 RpcHeader，服务端的 span 以它为父
     bool SendRequest(uint64_t request_id,
                      const std::string& service_name,
                      const std::string& method_name,
                      const google::protobuf::Message* request,
-                     google::protobuf::RpcController* controller);
+                     google::protobuf::RpcController* controller,
+                     const TraceContext& trace = TraceContext());
 
-    // 启动/停止接收线程
-    void StartReceiveThread(
+    // 启动/停止接收 (在共享 reactor 上注册/注销读事件，重复启动直接复用)
+    void StartReceiving(
         std::function<void(uint64_t, int32_t, const std::string&, const std::string&)> callback);
-    void StopReceiveThread();
+    void StopReceiving();
 
     uint64_t GetTotalRequests() const { return total_requests_; }
     uint64_t GetFailedRequests() const { return failed_requests_; }
 
+    // 在途负载 (连接池 P2C 选路的依据)：登记请求前 Start，请求以任何方式完成 (响应 / 超时 / 发送失败) 后 End
+    void OnRequestStart(size_t bytes) {
+        inflight_requests_.fetch_add(1, std::memory_order_relaxed);
+        inflight_bytes_.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+    }
+    void OnRequestEnd(size_t bytes) {
+        inflight_requests_.fetch_sub(1, std::memory_order_relaxed);
+        inflight_bytes_.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+    }
+    ConnectionLoad Load() const {
+        ConnectionLoad load;
+        load.requests = inflight_requests_.load(std::memory_order_relaxed);
+        load.bytes = inflight_bytes_.load(std::memory_order_relaxed);
+        load.connected = IsConnected();
+        return load;
+    }
+
 private:
     int id_;
     std::string ip_;
     uint16_t port_;
     RpcClientConfig config_;
     
-    int fd_;
-    std::mutex send_mutex_;      // 保护发送操作
-    std::string recv_buffer_;    // 接收缓冲区
-    std::mutex recv_mutex_;      // 保护接收缓冲区
-    std::mutex thread_start_mutex_;     // 防止多线程同时启动的锁
-    bool thread_is_running_ = false;    // 记录是否已经启动的状态
+    std::atomic<int> fd_;        // Close 可能发生在任意线程 (写失败 / reactor 读失败)，用 exchange 保证只关一次
+
+    // 写合并队列中的一帧 (位于调用方栈上，写者写完后置 done)
+    struct OutgoingFrame {
+        std::string buffer;      // 完整的帧：varint + header + args
+        bool done = false;
+        bool ok = false;
+        int error = 0;
+    };
+    std::mutex send_mutex_;      // 保护写合并队列与写者身份
+    std::condition_variable send_cv_;
+    std::vector<OutgoingFrame*> send_queue_;
+    bool writer_active_ = false;
+    std::mutex buffer_pool_mutex_;
+    std::vector<std::string> buffer_pool_;
 
-    std::thread recv_thread_;
-    std::atomic<bool> stop_recv_thread_{false};
+    std::string recv_buffer_;    // 接收缓冲区
+    std::mutex recv_mutex_;      // 保护接收缓冲区，并让 recv / 注册读事件与 Close 互斥
+    std::mutex receive_state_mutex_;    // 防止多线程同时启动的锁
+    bool receiving_ = false;            // 是否已在 reactor 上注册 (断线重连后自动重新注册)
     std::function<void(uint64_t, int32_t, const std::string&, const std::string&)> response_callback_;
 
     std::atomic<uint64_t> total_requests_{0};
     std::atomic<uint64_t> failed_requests_{0};
+    std::atomic<int64_t> inflight_requests_{0};
+    std::atomic<int64_t> inflight_bytes_{0};
+
+    bool SubmitFrame(OutgoingFrame* frame);
+    int WriteFrames(const std::vector<OutgoingFrame*>& frames);
+    std::string AcquireBuffer();
+    void ReleaseBuffer(std::string&& buf);
+
+    enum class ReadResult { kData, kWouldBlock, kClosed, kStale };
 
-    void ReceiveLoop();
-    bool ReadToBuffer();
+    void RegisterReadEvent(int fd);
+    void OnReadable(int fd);
+    ReadResult ReadToBuffer(int fd);
+    int WaitWritable(int fd);
     bool TryParseResponse(uint64_t& request_id, int32_t& error_code,
                           std::string& error_msg, std::string& response_data);
 };
@@ -119,23 +258,58 @@ private:
 // ============================================================================
 // 连接池管理器
 // ============================================================================
+/**
+ * @brief 到同一个端点的一组连接
+ * @details
+ * 1. 选路：P2C，按各连接的在途请求数 / 字节数，卡住的连接不再分到新请求 (见 conn_balancer.h)；
+ * 2. 伸缩：每 kResizeCheckEvery 次选路采样一次在途总数，按并发度在
+ *    [connection_pool_size, max_connection_pool_size] 之间增减连接；
+ * 3. 连接列表是不可变快照，扩缩容时复制后原子替换，旧快照交给 EpochManager 回收，选路不加锁；
+ *    缩容摘下的连接先进入 draining，在途请求全部完成后才关闭。
+ */
 class ConnectionPool {
 public:
+    using ResponseCallback = std::function<void(uint64_t, int32_t, const std::string&, const std::string&)>;
+
+    static constexpr uint64_t kResizeCheckEvery = 64;   // 必须是 2 的幂
+
     ConnectionPool(const std::string& ip, uint16_t port,
                    const RpcClientConfig& config);
     ~ConnectionPool();
 
     bool Init();
     std::shared_ptr<RpcConnection> GetConnection();
+
+    // 给现有以及之后扩容出的所有连接设置响应回调并开始接收 (重复调用直接返回)
+    void StartReceiving(ResponseCallback callback);
+
+    size_t Size() const;
     void PrintStats() const;
 
+    // 该端点的延迟统计，由在途请求的上下文共享持有
+    const std::shared_ptr<LatencyTracker>& Latency() const { return latency_; }
+
 private:
+    using ConnList = std::vector<std::shared_ptr<RpcConnection>>;
+
     std::string ip_;
     uint16_t port_;
     RpcClientConfig config_;
+    std::shared_ptr<LatencyTracker> latency_ = std::make_shared<LatencyTracker>();
     
-    std::vector<std::shared_ptr<RpcConnection>> connections_;
-    std::atomic<size_t> next_conn_idx_{0};
+    std::atomic<const ConnList*> connections_;
+    std::atomic<uint64_t> picks_{0};
+
+    // 以下由 resize_mutex_ 保护
+    std::mutex resize_mutex_;
+    PoolSizer sizer_;
+    int next_conn_id_ = 0;
+    ResponseCallback callback_;
+    ConnList draining_;
+
+    std::shared_ptr<RpcConnection> NewConnection();
+    void MaybeResize();
+    void Publish(ConnList* next);   // 调用方持有 resize_mutex_
 };
 
 // ============================================================================
@@ -157,13 +331,36 @@ public:
     MprpcChannel(const MprpcChannel&) = delete;
     MprpcChannel& operator=(const MprpcChannel&) = delete;
 
-    // 核心调用接口
+    /**
+     * @brief 核心调用接口
+     * @details
+     * - done != nullptr：纯异步，发送后立即返回，响应 / 失败 / 超时时在 IO 线程中执行 done->Run()；
+     * - done == nullptr 且在 monsoon 协程中 (fiber_aware_wait)：挂起当前协程，完成后回到原调度线程继续；
+     * - done == nullptr 且在普通线程中：阻塞等待，最多 rpc_timeout_ms。
+     */
     void CallMethod(const google::protobuf::MethodDescriptor* method,
                     google::protobuf::RpcController* controller,
                     const google::protobuf::Message* request,
                     google::protobuf::Message* response,
                     google::protobuf::Closure* done) override;
 
+    /**
+     * @brief 异步调用，完成后在 IO 线程执行 callback (controller / response 需存活到回调结束)
+     */
+    void CallMethodAsync(const google::protobuf::MethodDescriptor* method,
+                         google::protobuf::RpcController* controller,
+                         const google::protobuf::Message* request,
+                         google::protobuf::Message* response,
+                         std::function<void()> callback);
+
+    /**
+     * @brief 异步调用，返回的 future 在完成时就绪，结果通过 controller->Failed() 判断
+     */
+    std::future<void> CallMethodFuture(const google::protobuf::MethodDescriptor* method,
+                                       google::protobuf::RpcController* controller,
+                                       const google::protobuf::Message* request,
+                                       google::protobuf::Message* response);
+
     void PrintStats() const;
 
 private:
@@ -175,14 +372,23 @@ private:
 
     int shutdown_hook_id_{-1}; // 优雅关闭钩子 ID
 
-    std::atomic<uint64_t> next_request_id_{1};
-    static std::mutex pending_mutex_;
-    static std::unordered_map<uint64_t, std::shared_ptr<PendingRpcContext>> pending_requests_;
+    // 全局连接池上的连接被所有 Channel 共享，request_id、在途请求表与 deadline 时间轮必须是进程级的
+    static std::atomic<uint64_t> next_request_id_;
+    static PendingRequestTable pending_requests_;
+    static TimerWheel deadline_wheel_;
+
+    enum TimerTag : uint32_t {
+        kTimeoutTimer = 0,   // 请求 deadline
+        kHedgeTimer = 1,     // 发出对冲请求的时刻
+    };
+
+    static std::atomic<uint64_t> hedgeable_calls_;
+    static std::atomic<uint64_t> hedges_sent_;
 
     std::thread timeout_checker_thread_;
     std::atomic<bool> stop_timeout_checker_{false};
 
-    uint64_t GenerateRequestId() { return next_request_id_.fetch_add(1); }
+    static uint64_t GenerateRequestId() { return next_request_id_.fetch_add(1, std::memory_order_relaxed); }
     
     void RegisterPendingRequest(uint64_t request_id, 
                                 std::shared_ptr<PendingRpcContext> ctx);
@@ -190,7 +396,22 @@ private:
     static void OnResponseReceived(uint64_t request_id, int32_t error_code,
                             const std::string& error_msg,
                             const std::string& response_data);
+
+    // 从表中取走 request_id 并归还它所在连接的在途计数 (每个 id 恰好被取走一次，因此恰好归还一次)
+    static std::shared_ptr<PendingRpcContext> TakeRequest(uint64_t request_id);
+    // 取走 request_id 并竞争完成权，成功时连同对冲的另一个 id 一起摘掉；失败返回空
+    static std::shared_ptr<PendingRpcContext> Claim(uint64_t request_id);
+    static void CompleteRequest(const std::shared_ptr<PendingRpcContext>& ctx, int32_t error_code,
+                                const std::string& error_msg, const std::string& response_data);
+    static void ExpireRequest(uint64_t request_id);
+    static void SendHedge(uint64_t request_id);
+
+    // 本次调用的超时：controller 显式值 > 端点延迟分布 > rpc_timeout_ms
+    std::chrono::milliseconds TimeoutFor(google::protobuf::RpcController* controller,
+                                         const LatencyTracker& latency) const;
     
+    void WaitForResponse(const std::shared_ptr<PendingRpcContext>& ctx);
+
     void TimeoutCheckerLoop();
     void CleanupTimeoutRequests();
 };
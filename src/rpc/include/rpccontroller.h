@@ -56,6 +56,10 @@ class MprpcController : public google::protobuf::RpcController {
   void SetRetryTimes(int retry_times) { m_retry_times = retry_times; }
   int GetRetryTimes() const { return m_retry_times; }
 
+  // 幂等的读请求可以标记为可对冲：超过端点 p95 未返回时客户端向另一个副本重发一份
+  void SetHedgeable(bool hedgeable) { m_hedgeable = hedgeable; }
+  bool IsHedgeable() const { return m_hedgeable; }
+
  private:
   // RPC方法执行过程中的状态
   bool m_failed;           // 是否失败
@@ -65,4 +69,5 @@ class MprpcController : public google::protobuf::RpcController {
   // 扩展配置 (构造函数中出现的成员变量)
   int m_timeout_ms;   // 超时时间 (-1 表示无超时)
   int m_retry_times;  // 重试次数
+  bool m_hedgeable = false;  // 是否允许对冲 (只对幂等调用设置)
 };
\ No newline at end of file
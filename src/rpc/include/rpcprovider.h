@@ -8,12 +8,21 @@
 #include <muduo/net/TcpConnection.h>
 #include <muduo/net/TcpServer.h>
 
+#include "rpcheader.pb.h"
+#include "metrics.h"
+#include "metrics_server.h"
+
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 // RPC 协议层面的错误码定义
 // 用于在 SendErrorResponse 中告知客户端具体的失败原因
@@ -25,7 +34,14 @@ enum RpcErrorCode {
   RPC_INVALID_REQUEST = 4,   // 请求参数反序列化失败
   RPC_INTERNAL_ERROR = 5,    // 服务端内部错误（如序列化响应失败）
   RPC_TIMEOUT = 6,           // (预留) 超时
-  RPC_OVERLOAD = 7           // (预留) 服务端过载
+  RPC_OVERLOAD = 7           // 服务端过载 (超过 max_pending_requests 或业务队列已满)
+};
+
+// 单个方法的耗时分布 (微秒)，未开启 enable_metrics 时均为空，记录点不读时钟
+struct RpcMethodMetrics {
+  MetricHistogram* parse = nullptr;    // 开始解析这一帧 -> 请求参数反序列化完成
+  MetricHistogram* dispatch = nullptr; // 反序列化完成 -> 业务方法开始执行 (业务线程模式下即排队时间)
+  MetricHistogram* handler = nullptr;  // 业务方法开始执行 -> 响应写出 (done->Run)
 };
 
 /**
@@ -34,6 +50,10 @@ enum RpcErrorCode {
  * 1. 网络层：基于 Muduo (Reactor模型) 处理高并发 TCP 连接。
  * 2. 协议层：处理 TCP 粘包/半包，解析 [Length][Header][Body] 格式。
  * 3. 业务层：利用 Protobuf 反射机制，动态分发请求到具体的 Service 实现。
+ * 4. 调度层 (可选)：worker_threads > 0 时，业务方法在独立的业务线程池中执行，
+ *    IO 线程只负责收包、解析和回写，慢请求不会拖住同一 EventLoop 上的其他连接。
+ *    同一连接的请求固定分派到同一个 worker，按到达顺序执行；
+ *    响应按 request_id 标识，谁先完成谁先回写，不必等前面的请求。
  */
 class RpcProvider {
  public:
@@ -52,7 +72,20 @@ class RpcProvider {
     // 配合 CheckIdleConnections 清理死连接
     int idle_timeout_seconds = 300;  
     
-    bool enable_metrics = true; // 是否开启指标统计
+    bool enable_metrics = true; // 是否开启指标统计 (含每个方法的解析 / 分派 / 执行耗时直方图)
+
+    // > 0 时在该端口提供 HTTP GET /metrics (Prometheus 文本格式，导出进程内全部指标)；需要 enable_metrics
+    uint16_t metrics_port = 0;
+
+    // 业务线程数 (默认 0：业务方法直接在 IO 线程内执行)
+    int worker_threads = 0;
+
+    // 每个业务线程的任务队列上限，队列满时直接返回 RPC_OVERLOAD
+    size_t worker_queue_size = 1024;
+
+    // 准入控制：正在处理的请求数 (Metrics::pending_requests) 超过该值时
+    // 新请求直接返回 RPC_OVERLOAD，不再解析和执行 (0 表示不限制)
+    int max_pending_requests = 0;
     // std::string log_level = "INFO";
   };
 
@@ -104,6 +137,8 @@ class RpcProvider {
     google::protobuf::Service* service; // 服务对象基类指针
     // 方法名 -> 方法描述符 的映射，用于快速查找
     std::unordered_map<std::string, const google::protobuf::MethodDescriptor*> method_map;
+    // 方法名 -> 耗时直方图 (注册时创建一次)
+    std::unordered_map<std::string, RpcMethodMetrics> method_metrics;
   };
 
   // 连接上下文 (附加到每个 TcpConnection 上)
@@ -135,6 +170,20 @@ class RpcProvider {
 
   // 监控指标
   Metrics metrics_;
+  // metrics_ 以回调的形式导出到 MetricsRegistry，析构时注销
+  std::vector<int> metric_callbacks_;
+  // HTTP 抓取端点 (metrics_port > 0 时在 Run 中启动)
+  std::unique_ptr<MetricsServer> metrics_server_;
+
+  // 业务线程 (每个 worker 一个有界 FIFO 队列，连接按名字哈希固定到一个 worker)
+  struct DispatchWorker {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> tasks;
+    bool stopping = false;
+    std::thread thread;
+  };
+  std::vector<std::unique_ptr<DispatchWorker>> workers_;
 
   // 关闭标志位 (Atomic)
   std::atomic<bool> shutdown_flag_{false};
@@ -153,8 +202,30 @@ class RpcProvider {
   // ================= 核心处理逻辑 =================
 
   /**
-   * @brief 尝试从缓冲区解析一个完整的 RPC 消息
-   * @details 实现了 "Peek-All-First" 策略：
+   * @brief 一帧完整请求的零拷贝视图
+   * @details args_data 直接指向 Buffer 内部，只在 retrieve(frame_size) 之前有效。
+   * OnMessage 在循环中复用同一个 RequestFrame，RpcHeader 的字符串容量跨帧保留。
+   */
+  struct RequestFrame {
+    RPC::RpcHeader header;
+    uint32_t header_size = 0;
+    const char* args_data = nullptr;
+    uint32_t args_size = 0;
+    size_t frame_size = 0;  // [长度头 + Header + Args] 总字节数
+    std::chrono::steady_clock::time_point parse_start;  // 开始解析这一帧的时间 (仅 enable_metrics)
+  };
+
+  /**
+   * @brief 偷看 (Peek) 缓冲区中的下一帧请求，不消费任何数据
+   * @details RpcHeader 直接在 buffer->peek() 上 ParseFromArray，不拷贝出临时 string。
+   * 集齐 [Length] + [Header] + [Body] 时返回 true，调用方处理完后负责 retrieve(frame.frame_size)；
+   * 半包返回 false；协议错误时丢弃坏数据并抛出异常。
+   */
+  bool PeekRequest(muduo::net::Buffer* buffer, RequestFrame& frame);
+
+  /**
+   * @brief 尝试从缓冲区解析一个完整的 RPC 消息 (拷贝版本，供测试和调试使用)
+   * @details 基于 PeekRequest 实现 "Peek-All-First" 策略：
    * 只有当 Buffer 中集齐了 [Length] + [Header] + [Body] 时，才返回 true 并消费数据。
    * 否则返回 false，且不移动 Buffer 的读取指针。
    * * @param buffer 网络读缓冲区
@@ -175,28 +246,39 @@ class RpcProvider {
    * @brief 执行 RPC 业务逻辑
    * @details 
    * 1. 查找 Service 和 Method 描述符
-   * 2. 反序列化 Request 对象
-   * 3. 绑定 SendRpcResponse 回调
-   * 4. 调用 service->CallMethod()
+   * 2. 在调用级 Arena 上创建 Request/Response，直接从 frame.args_data 反序列化
+   * 3. 绑定 SendRpcResponse 回调 (回调结束时整体释放 Arena)
+   * 4. 调用 service->CallMethod()：未开启业务线程时在当前 IO 线程内执行，
+   *    否则投递到连接对应的 worker (请求已在 IO 线程解析完，不依赖 Buffer)
    */
   void HandleRpcRequest(const muduo::net::TcpConnectionPtr& conn,
-                        const std::string& service_name,
-                        const std::string& method_name,
-                        const std::string& args_str,
-                        uint64_t request_id);
+                        const RequestFrame& frame);
 
   // ================= 响应发送区 =================
 
   // 发送正常响应 (由 Closure 回调触发)
-  // 会自动序列化 response 并添加长度头
-  void SendRpcResponse(muduo::net::TcpConnectionPtr conn,
-                       google::protobuf::Message* response,
+  // Header 和 response 直接序列化进输出 Buffer，不经过中间 string
+  void SendRpcResponse(const muduo::net::TcpConnectionPtr& conn,
+                       const google::protobuf::Message* response,
                        uint64_t request_id);
   
   // 发送错误响应 (如解析失败、服务未找到)
+  // 错误码和错误信息放在 RpcHeader 中，客户端按 request_id 找到对应请求并置为失败
   void SendErrorResponse(const muduo::net::TcpConnectionPtr& conn,
                          int error_code,
-                         const std::string& error_msg);
+                         const std::string& error_msg,
+                         uint64_t request_id = 0);
+
+  // ================= 业务线程池 =================
+
+  // 启动 / 停止业务线程 (Stop 会先执行完队列中剩余的任务)
+  void StartWorkers();
+  void StopWorkers();
+
+  // 投递到连接对应的 worker，队列已满返回 false
+  bool SubmitToWorker(const muduo::net::TcpConnectionPtr& conn, std::function<void()> task);
+
+  void WorkerLoop(DispatchWorker* worker);
 
   // ================= 辅助功能区 =================
 
@@ -212,4 +294,7 @@ protected:
   
   // 校验配置合法性
   bool ValidateConfig() const;
+
+  // 把 metrics_ 注册为抓取时读取的回调指标
+  void RegisterMetrics();
 };
\ No newline at end of file
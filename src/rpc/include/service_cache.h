@@ -0,0 +1,80 @@
+/**
+ * @file service_cache.h
+ * @brief 服务发现的本地缓存 (ZkClient::GetServiceList 的读路径)
+ * @details
+ * 整个缓存是一份不可变快照 (service -> 实例列表)，写方复制一份修改后原子地替换指针，
+ * 旧快照交给 EpochManager 延迟释放。读方只做 pin + 一次原子加载 + 查表，不加锁、
+ * 不访问 ZooKeeper，也不会被写方阻塞 (wait-free)。
+ *
+ * 条目分两种：
+ * - 正缓存：来自一次带 Watch 的 GetChildren，之后子节点变化由 Watch 驱动刷新，不过期；
+ * - 负缓存：服务节点不存在或查询失败，在 until 之前直接返回“没有实例”，
+ *   避免对不存在的服务每次调用都打一次 ZooKeeper (这种情况下 Watch 设置不上)。
+ *
+ * 写方 (ZkClient 的事件线程 / 首次查询的调用方) 由内部互斥锁串行化，服务数量很少，整表复制的代价可以忽略。
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ServiceDiscoveryCache {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  enum class Result {
+    kHit,       // 正缓存命中 (实例列表可能为空：服务存在但没有实例)
+    kNegative,  // 负缓存命中，未过期
+    kMiss,      // 没有条目或负缓存已过期，需要访问 ZooKeeper
+  };
+
+  ServiceDiscoveryCache();
+  ~ServiceDiscoveryCache();
+
+  ServiceDiscoveryCache(const ServiceDiscoveryCache&) = delete;
+  ServiceDiscoveryCache& operator=(const ServiceDiscoveryCache&) = delete;
+
+  /**
+   * @brief 查找服务的实例列表 (无锁)
+   * @param endpoints [输出] 仅 kHit 时填充
+   */
+  Result Lookup(const std::string& service, std::vector<std::string>* endpoints,
+                Clock::time_point now = Clock::now()) const;
+
+  /**
+   * @brief 写入正缓存 (整体替换该服务的实例列表)
+   */
+  void Update(const std::string& service, std::vector<std::string> endpoints);
+
+  /**
+   * @brief 写入负缓存，until 之前 Lookup 返回 kNegative
+   * @details 已有正缓存时保留旧列表：查询失败多半是连接问题，旧列表仍比“没有实例”更有用
+   */
+  void MarkMissing(const std::string& service, Clock::time_point until);
+
+  void Erase(const std::string& service);
+
+  /**
+   * @brief 当前缓存的所有服务名 (重连后全量重新拉取时使用)
+   */
+  std::vector<std::string> Services() const;
+
+ private:
+  struct Entry {
+    std::vector<std::string> endpoints;
+    bool negative = false;
+    Clock::time_point negative_until;
+  };
+  using Snapshot = std::unordered_map<std::string, Entry>;
+
+  // 调用方持有 write_mutex_
+  void Publish(Snapshot* next);
+
+  std::atomic<const Snapshot*> snapshot_;
+  std::mutex write_mutex_;
+};
@@ -0,0 +1,81 @@
+/**
+ * @file timer_wheel.h
+ * @brief 在途 RPC 的 deadline 时间轮 (哈希时间轮，带圈数)
+ * @details
+ * 之前超时检查线程每轮都要扫描整张在途请求表，代价与在途请求数成正比，
+ * 且为了控制代价只能把检查间隔放大到超时的 1/4，超时的实际触发时间也随之被推迟。
+ * 时间轮按 tick 把定时器哈希到 slot 中，Advance 只访问这段时间内到期的 slot：
+ * - Schedule：O(1)，只锁目标 slot，多个调用线程之间基本不争用；
+ * - Advance：检查线程按 tick 推进，每个 slot 中还没到圈数的定时器原样保留；
+ * - 不支持显式取消：请求完成后定时器留在轮子里，到期时由调用方通过 PendingRequestTable::Take
+ *   发现请求已被取走而忽略 (惰性取消)，免去每次完成时再锁一次 slot。
+ *
+ * 定时器不会早于 when 触发，最多晚一个 tick (加上检查线程的调度延迟)。
+ * Advance 可以被多个线程调用，同一时刻只有一个在推进，其余直接返回。
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class TimerWheel {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Timer {
+    uint64_t id;
+    uint32_t tag;   // 定时器种类，由调用方定义 (如超时 / 对冲)
+  };
+
+  /**
+   * @param tick 精度
+   * @param slots slot 个数 (向上取到 2 的幂)，tick * slots 为一圈的长度
+   */
+  explicit TimerWheel(std::chrono::milliseconds tick = std::chrono::milliseconds(5), size_t slots = 1024,
+                      Clock::time_point origin = Clock::now());
+
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  void Schedule(uint64_t id, uint32_t tag, Clock::time_point when);
+
+  /**
+   * @brief 推进到 now，把到期的定时器追加到 expired
+   * @return 另一个线程正在推进时返回 false (expired 不变)
+   */
+  bool Advance(Clock::time_point now, std::vector<Timer>* expired);
+
+  size_t Size() const { return size_.load(std::memory_order_relaxed); }
+  std::chrono::milliseconds Tick() const { return tick_; }
+
+ private:
+  struct Entry {
+    uint64_t id;
+    uint32_t tag;
+    uint64_t expire_tick;
+  };
+
+  struct alignas(64) Slot {
+    std::mutex mutex;
+    std::vector<Entry> entries;
+  };
+
+  uint64_t CeilTick(Clock::time_point when) const;
+  uint64_t FloorTick(Clock::time_point now) const;
+  void CollectSlot(uint64_t tick, uint64_t upto, std::vector<Timer>* expired);
+
+  const std::chrono::milliseconds tick_;
+  const Clock::time_point origin_;
+  size_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+
+  // 已处理完的 tick：只在持有对应 slot 锁时更新 (见 Schedule 中的晚到检查)
+  std::atomic<uint64_t> current_tick_{0};
+  std::atomic<size_t> size_{0};
+  std::mutex advance_mutex_;
+};
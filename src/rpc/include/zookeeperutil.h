@@ -15,6 +15,14 @@
  * - RAII：自动资源管理
  * 
  * 线程安全：是（内部使用互斥锁）
+ *
+ * 服务发现缓存：GetServiceList 优先读本地快照 (ServiceDiscoveryCache，无锁)，
+ * 只有首次查询 / 负缓存过期时才访问 ZooKeeper；之后由子节点 Watch 驱动刷新，
+ * 重连 (新会话丢失全部 Watch) 后在随机抖动的时间内逐个重新拉取，避免所有客户端同时打 ZooKeeper。
+ *
+ * Watch 回调不在 ZooKeeper 的事件线程中执行：事件先入队，由 ZkClient 自己的事件线程
+ * 刷新发现缓存后再依次调用用户回调 (不持有 watchers 锁)，因此回调里可以访问 ZooKeeper，
+ * 但回调执行时间过长会推迟后续事件的处理。
  */
 
 #pragma once
@@ -23,14 +31,19 @@
 
 #include <zookeeper/zookeeper.h>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "service_cache.h"
+
 // ============================================================================
 // ZooKeeper 配置参数
 // ============================================================================
@@ -44,6 +57,10 @@ struct ZkConfig {
   int max_retry_times = 3;            // 最大重试次数
   bool enable_auto_reconnect = true;  // 是否启用自动重连
   std::string root_path = "/rpc";     // RPC 服务的根路径
+
+  // 服务发现缓存
+  int discovery_negative_ttl_ms = 1000;   // 服务不存在 / 查询失败的结果缓存多久
+  int discovery_resync_jitter_ms = 2000;  // 重连后在 [0, jitter) 内随机地重新拉取每个服务
 };
 
 // ============================================================================
@@ -243,6 +260,8 @@ class ZkClient {
    * @details
    * 查询路径：/rpc/{service_name}/*
    * 返回所有子节点名称（即服务地址）
+   * 命中本地缓存时不访问 ZooKeeper；未命中时同步查询一次并设置子节点 Watch，
+   * 之后实例增删由 Watch 异步刷新缓存。服务不存在时在 discovery_negative_ttl_ms 内直接返回空。
    * 
    * @example
    * auto services = zk.GetServiceList("UserService");
@@ -256,7 +275,7 @@ class ZkClient {
    * @param callback 服务变化时的回调函数
    * @return true 监听成功, false 监听失败
    * @details
-   * 当服务上线/下线时，触发回调通知
+   * 当服务上线/下线时，触发回调通知 (回调执行时发现缓存已经刷新，回调里的 GetServiceList 读到的是新列表)
    * 
    * @example
    * zk.WatchService("UserService", [](const std::string& path, int type, int state) {
@@ -281,6 +300,7 @@ class ZkClient {
   /**
    * @brief 清除指定路径的 Watch 回调
    * @param path 节点路径
+   * @details 返回时该路径的回调已不在执行，之后也不会再被调用 (可以安全释放回调捕获的对象)
    */
   void ClearWatcher(const std::string& path);
 
@@ -348,6 +368,31 @@ class ZkClient {
   void PrintTreeRecursive(const std::string& path, int depth, int max_depth, 
                          const std::string& prefix);
 
+  // ========== 服务发现缓存与事件线程 ==========
+
+  struct WatchEvent {
+    int type;
+    int state;
+    std::string path;
+  };
+
+  std::string ServicePath(const std::string& service_name) const;
+
+  /**
+   * @brief 从 ZooKeeper 拉取服务实例列表 (同时重新设置子节点 Watch) 并写入缓存
+   */
+  std::vector<std::string> RefreshService(const std::string& service_name);
+
+  /**
+   * @brief 重连后为每个已缓存的服务安排一次带随机抖动的重新拉取
+   */
+  void ScheduleDiscoveryResync();
+
+  void StartEventThread();
+  void StopEventThread();
+  void EventLoop();
+  void DispatchEvent(const WatchEvent& event);
+
   /**
    * @brief 将 ZooKeeper 错误码转换为字符串
    * @param error_code 错误码
@@ -369,6 +414,20 @@ class ZkClient {
   // Watch 回调管理
   std::mutex watchers_mutex_;         // Watch 回调锁
   std::unordered_map<std::string, ZkWatchCallback> watchers_;  // 路径 -> 回调映射
+  std::condition_variable watchers_cv_;
+  std::string running_watch_path_;    // 事件线程正在执行的回调所属路径 (ClearWatcher 据此等待)
+  bool watch_running_ = false;
+
+  // 服务发现缓存 (读方无锁)
+  ServiceDiscoveryCache discovery_cache_;
+
+  // 事件线程：ZooKeeper 线程只入队，刷新缓存与用户回调都在这里执行
+  std::thread event_thread_;
+  std::mutex event_mutex_;
+  std::condition_variable event_cv_;
+  std::deque<WatchEvent> events_;
+  std::unordered_map<std::string, std::chrono::steady_clock::time_point> resync_due_;  // 服务名 -> 计划拉取时间
+  bool event_stopping_ = false;
 
   // 统计信息
   std::atomic<uint64_t> total_operations_{0};  // 总操作次数
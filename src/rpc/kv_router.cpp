@@ -0,0 +1,280 @@
+/**
+ * @file kv_router.cpp
+ * @brief KV 客户端路由缓存实现
+ */
+
+#include "kv_router.h"
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_set>
+
+KvRouter::KvRouter(Options options, const raft::RangeTable* ranges)
+    : options_(std::move(options)), ranges_(ranges) {
+  if (!options_.channel_factory) {
+    RpcClientConfig config = options_.rpc_config;
+    options_.channel_factory = [config](const std::string& ip, uint16_t port) {
+      return std::make_shared<MprpcChannel>(ip, port, config);
+    };
+  }
+  std::vector<std::string> addrs;
+  for (const auto& kv : options_.nodes) {
+    all_nodes_.push_back(kv.first);
+    addrs.push_back(kv.second);
+  }
+  std::sort(all_nodes_.begin(), all_nodes_.end());
+
+  // 还没有 ZooKeeper 的信息时，认为目录中的节点都在线
+  std::atomic_store(&endpoints_, std::shared_ptr<const EndpointMap>(std::make_shared<EndpointMap>()));
+  UpdateLiveEndpoints(addrs);
+}
+
+KvRouter::~KvRouter() {
+  {
+    std::lock_guard<std::mutex> lock(refresh_->mutex);
+    refresh_->stopping = true;
+  }
+  refresh_->cv.notify_all();
+  if (refresh_thread_.joinable()) {
+    refresh_thread_.join();
+  }
+}
+
+// ============================================================================
+// 热路径：查找
+// ============================================================================
+
+bool KvRouter::Replicas(uint64_t group_id, std::vector<int32_t>* replicas, uint64_t* epoch) const {
+  if (ranges_ == nullptr) {
+    if (group_id != 0) {
+      return false;
+    }
+    *replicas = all_nodes_;
+    *epoch = 0;
+    return true;
+  }
+  raft::RangeDescriptor desc;
+  if (!ranges_->Get(group_id, &desc)) {
+    return false;
+  }
+  *replicas = std::move(desc.replicas);
+  *epoch = desc.epoch;
+  return true;
+}
+
+bool KvRouter::Locate(std::string_view key, Route* route) {
+  if (ranges_ == nullptr) {
+    return LocateGroup(0, route);
+  }
+  raft::RangeDescriptor desc;
+  if (!ranges_->Locate(key, &desc)) {
+    return false;
+  }
+  return Pick(desc.group_id, desc.replicas, desc.epoch, route);
+}
+
+bool KvRouter::LocateGroup(uint64_t group_id, Route* route) {
+  std::vector<int32_t> replicas;
+  uint64_t epoch = 0;
+  if (!Replicas(group_id, &replicas, &epoch)) {
+    return false;
+  }
+  return Pick(group_id, replicas, epoch, route);
+}
+
+bool KvRouter::Pick(uint64_t group_id, const std::vector<int32_t>& replicas, uint64_t epoch, Route* route) {
+  std::shared_ptr<const EndpointMap> endpoints = Endpoints();
+  route->group_id = group_id;
+  route->epoch = epoch;
+
+  {
+    std::shared_lock<std::shared_mutex> lock(leaders_mutex_);
+    auto it = leaders_.find(group_id);
+    if (it != leaders_.end()) {
+      auto ep = endpoints->find(it->second);
+      if (ep != endpoints->end()) {
+        route->node_id = it->second;
+        route->channel = ep->second;
+        return true;
+      }
+    }
+  }
+
+  // 领导人未知：先试第一个在线副本，并把它记为领导人 (之后 NOT_LEADER / 失败时再换)，
+  // 这样并发的请求会发往同一个节点，而不是各自乱试
+  for (int32_t node : replicas) {
+    auto ep = endpoints->find(node);
+    if (ep == endpoints->end()) {
+      continue;
+    }
+    std::unique_lock<std::shared_mutex> lock(leaders_mutex_);
+    auto [it, inserted] = leaders_.emplace(group_id, node);
+    if (!inserted && it->second != node) {
+      auto cur = endpoints->find(it->second);
+      if (cur != endpoints->end()) {
+        // 其他线程刚刚选定 (或根据 hint 更新) 了领导人，以它为准
+        route->node_id = it->second;
+        route->channel = cur->second;
+        return true;
+      }
+      it->second = node;
+    }
+    route->node_id = node;
+    route->channel = ep->second;
+    return true;
+  }
+  return false;
+}
+
+int32_t KvRouter::CachedLeader(uint64_t group_id) const {
+  std::shared_lock<std::shared_mutex> lock(leaders_mutex_);
+  auto it = leaders_.find(group_id);
+  return it == leaders_.end() ? -1 : it->second;
+}
+
+// ============================================================================
+// 领导人缓存更新
+// ============================================================================
+
+void KvRouter::OnNotLeader(const Route& route, uint32_t leader_hint) {
+  const int32_t hint = static_cast<int32_t>(leader_hint);
+  std::vector<int32_t> replicas;
+  uint64_t epoch = 0;
+  if (leader_hint != 0 && hint != route.node_id && Replicas(route.group_id, &replicas, &epoch) &&
+      std::find(replicas.begin(), replicas.end(), hint) != replicas.end() && Endpoints()->count(hint)) {
+    std::unique_lock<std::shared_mutex> lock(leaders_mutex_);
+    auto it = leaders_.find(route.group_id);
+    // 只有缓存仍是这次请求的目标时才更新：别的请求可能已经带回了更新的 hint
+    if (it == leaders_.end() || it->second == route.node_id) {
+      leaders_[route.group_id] = hint;
+    }
+    return;
+  }
+  Advance(route);
+}
+
+void KvRouter::OnUnreachable(const Route& route) {
+  Advance(route);
+}
+
+void KvRouter::Advance(const Route& route) {
+  std::vector<int32_t> replicas;
+  uint64_t epoch = 0;
+  if (!Replicas(route.group_id, &replicas, &epoch) || replicas.empty()) {
+    std::unique_lock<std::shared_mutex> lock(leaders_mutex_);
+    leaders_.erase(route.group_id);
+    return;
+  }
+  std::shared_ptr<const EndpointMap> endpoints = Endpoints();
+
+  std::unique_lock<std::shared_mutex> lock(leaders_mutex_);
+  auto it = leaders_.find(route.group_id);
+  if (it != leaders_.end() && it->second != route.node_id) {
+    return;  // 已经被其他请求换过了，不要连跳两个
+  }
+  // 从失败节点在副本列表中的下一个位置开始，找第一个在线的副本
+  auto pos = std::find(replicas.begin(), replicas.end(), route.node_id);
+  size_t start = pos == replicas.end() ? 0 : static_cast<size_t>(pos - replicas.begin()) + 1;
+  for (size_t i = 0; i < replicas.size(); ++i) {
+    int32_t node = replicas[(start + i) % replicas.size()];
+    if (node != route.node_id && endpoints->count(node)) {
+      leaders_[route.group_id] = node;
+      return;
+    }
+  }
+  leaders_.erase(route.group_id);
+}
+
+// ============================================================================
+// 在线节点维护
+// ============================================================================
+
+void KvRouter::UpdateLiveEndpoints(const std::vector<std::string>& addrs) {
+  std::unordered_set<std::string> live(addrs.begin(), addrs.end());
+
+  std::lock_guard<std::mutex> lock(endpoints_mutex_);
+  std::shared_ptr<const EndpointMap> old = Endpoints();
+  auto next = std::make_shared<EndpointMap>();
+  for (const auto& kv : options_.nodes) {
+    if (!live.count(kv.second)) {
+      continue;
+    }
+    auto it = old->find(kv.first);
+    if (it != old->end()) {
+      next->emplace(kv.first, it->second);  // 已有连接继续复用
+      continue;
+    }
+    size_t split = kv.second.find(':');
+    if (split == std::string::npos) {
+      LOG_ERROR("[KvRouter] Invalid address for node {}: {}", kv.first, kv.second);
+      continue;
+    }
+    uint16_t port = static_cast<uint16_t>(atoi(kv.second.substr(split + 1).c_str()));
+    next->emplace(kv.first, options_.channel_factory(kv.second.substr(0, split), port));
+  }
+  for (const std::string& addr : addrs) {
+    bool known = std::any_of(options_.nodes.begin(), options_.nodes.end(),
+                             [&](const auto& kv) { return kv.second == addr; });
+    if (!known) {
+      LOG_ERROR("[KvRouter] Instance {} is not in the node directory, ignored", addr);
+    }
+  }
+  std::atomic_store(&endpoints_, std::shared_ptr<const EndpointMap>(next));
+
+  // 指向已下线节点的领导人缓存作废 (Pick 本身也会跳过，这里只是让 CachedLeader 如实反映)
+  std::unique_lock<std::shared_mutex> leaders_lock(leaders_mutex_);
+  for (auto it = leaders_.begin(); it != leaders_.end();) {
+    it = next->count(it->second) ? std::next(it) : leaders_.erase(it);
+  }
+}
+
+bool KvRouter::WatchService(ZkClient& zk, const std::string& service_name) {
+  if (refresh_thread_.joinable()) {
+    return false;
+  }
+  zk_ = &zk;
+  service_name_ = service_name;
+  {
+    std::lock_guard<std::mutex> lock(refresh_->mutex);
+    refresh_->pending = true;  // 首次拉取也在后台线程完成
+  }
+  refresh_thread_ = std::thread([this]() { RefreshLoop(); });
+  return true;
+}
+
+void KvRouter::RefreshLoop() {
+  std::shared_ptr<RefreshState> state = refresh_;
+  std::unique_lock<std::mutex> lock(state->mutex);
+  while (true) {
+    state->cv.wait(lock, [&]() { return state->stopping || state->pending; });
+    if (state->stopping) {
+      return;
+    }
+    state->pending = false;
+    lock.unlock();
+
+    // ZooKeeper 的 Watch 是一次性的：每次刷新都重新设置
+    bool ok = zk_->WatchService(service_name_, [state](const std::string&, int, int) {
+      {
+        std::lock_guard<std::mutex> guard(state->mutex);
+        state->pending = true;
+      }
+      state->cv.notify_all();
+    });
+    std::vector<std::string> hosts;
+    if (ok) {
+      hosts = zk_->GetServiceList(service_name_);
+      // 空列表与查询失败无法区分：保留上一次的结果，宁可多试一个已下线的节点
+      if (!hosts.empty()) {
+        UpdateLiveEndpoints(hosts);
+      }
+    }
+
+    lock.lock();
+    if (!ok) {
+      LOG_ERROR("[KvRouter] Failed to watch service {}, retrying", service_name_);
+      state->pending = true;
+      state->cv.wait_for(lock, std::chrono::seconds(1), [&]() { return state->stopping; });
+    }
+  }
+}
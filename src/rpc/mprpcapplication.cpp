@@ -18,6 +18,10 @@
 #include <spdlog/sinks/rotating_file_sink.h> // 滚动文件输出 (推荐)
 #include <spdlog/async.h>                    // 异步日志支持
 
+#include "config.h"
+#include "cpu_topology.h"
+#include "trace.h"
+
 // ============================================================================
 // 静态成员变量初始化
 // ============================================================================
@@ -144,6 +148,9 @@ void MprpcApplication::Init(int argc, char* argv[]) {
   std::cout << "[MprpcApplication] Loading environment variables (RPC_* prefix)..." << std::endl;
   app.config_.LoadEnvVariables("RPC_");
 
+  // 线程放置：必须在创建任何线程 (包括下面 spdlog 的异步线程池) 之前配置
+  app.InitPlacement();
+
   // 6. 初始化日志系统
   std::string log_file = app.args_.log_file;
   if (log_file.empty()) {
@@ -161,6 +168,18 @@ void MprpcApplication::Init(int argc, char* argv[]) {
 
   app.InitLoggingAsync(log_file, log_level);  // 正式初始化日志系统
 
+  // 请求追踪的采样率 (0 ~ 1)，未配置时用 config.h 的默认值
+  double sample_rate = TRACE_SAMPLE_RATE;
+  std::string rate = app.config_.Load("trace.sample_rate");
+  if (!rate.empty()) {
+    try {
+      sample_rate = std::stod(rate);
+    } catch (const std::exception&) {
+      std::cerr << "[MprpcApplication] Warning: invalid trace.sample_rate: " << rate << std::endl;
+    }
+  }
+  Tracer::GetInstance().SetSampleRate(sample_rate);
+
   // 7. 注册信号处理器（捕获 Ctrl+C 等信号）
   app.RegisterSignalHandlers();
 
@@ -294,6 +313,8 @@ void MprpcApplication::Shutdown() {
   }
 
   safe_log("MprpcApplication Shutdown complete.");
+  // 写出 BLOG_* 缓冲区里剩下的记录
+  BinLogger::GetInstance().Flush();
 }
 
 
@@ -441,6 +462,39 @@ CommandLineArgs MprpcApplication::ParseCommandLine(int argc, char* argv[]) {
   return args;
 }
 
+/**
+ * @brief 配置线程放置
+ * @details placement.enable = 1 时开启 (默认 PLACEMENT_ENABLE)，placement.<group> 覆盖该组的 CPU 集合，
+ * 例如 placement.raft = 0-3、placement.rpc_io = node1。配置有误时保持不绑核并打印原因，不影响启动。
+ */
+void MprpcApplication::InitPlacement() {
+  std::string enable = config_.Load("placement.enable");
+  bool enabled = enable.empty() ? PLACEMENT_ENABLE : (enable == "1" || enable == "true");
+  ThreadPlacement& placement = ThreadPlacement::GetInstance();
+  if (!enabled) {
+    placement.Disable();
+    return;
+  }
+
+  std::map<std::string, std::string> specs;
+  for (const std::string& group : ThreadPlacement::Groups()) {
+    std::string spec = config_.Load("placement." + group);
+    if (!spec.empty()) specs[group] = spec;
+  }
+  std::string error;
+  if (!placement.Configure(CpuTopology::GetInstance(), specs, &error)) {
+    std::cerr << "[MprpcApplication] Warning: invalid placement config (" << error
+              << "), threads are left unpinned" << std::endl;
+    placement.Disable();
+    return;
+  }
+  std::cout << "[MprpcApplication] Thread placement (" << CpuTopology::GetInstance().NumNodes()
+            << " NUMA node(s)):\n" << placement.Describe();
+  if (!placement.Isolated()) {
+    std::cerr << "[MprpcApplication] Warning: raft threads share cores with client IO threads" << std::endl;
+  }
+}
+
 /**
  * @brief 初始化日志系统
  * @param log_file 日志文件路径（空则输出到 stdout）
@@ -528,6 +582,7 @@ void MprpcApplication::InitLogging(const std::string& log_file, const std::strin
     // ========== 4. 设置为全局默认 logger ==========
     // 这是关键！设置后，所有 LOG_INFO() 等宏都会使用这个 logger
     spdlog::set_default_logger(logger);
+    InitBinLog(sinks, level);
     
     // ========== 5. 其他配置 ==========
     // 立即刷新日志（确保不丢失）
@@ -568,8 +623,8 @@ void MprpcApplication::InitLoggingAsync(const std::string& log_file,
 
   try {
     // ========== 1. 初始化异步日志线程池 ==========
-    // 参数：队列大小 32768，后台线程数 3
-    spdlog::init_thread_pool(32768, 3);
+    // 参数：队列大小 32768，后台线程数 3；后台线程在 log 组内浮动 (未开启放置时不绑核)
+    spdlog::init_thread_pool(32768, 3, []() { ThreadPlacement::GetInstance().PinCurrentThread(kPlacementLog); });
 
     // ========== 2. 创建异步 sinks ==========
     std::vector<spdlog::sink_ptr> sinks;
@@ -622,6 +677,7 @@ void MprpcApplication::InitLoggingAsync(const std::string& log_file,
     // ========== 5. 设置为全局默认 logger ==========
     // 这是关键！设置后，所有 LOG_INFO() 等宏都会使用这个 logger
     spdlog::set_default_logger(logger);
+    InitBinLog(sinks, level);
     
     // 异步日志建议按时间刷新（不需要每条都立即刷新）
     spdlog::flush_every(std::chrono::seconds(3));
@@ -639,6 +695,29 @@ void MprpcApplication::InitLoggingAsync(const std::string& log_file,
   }
 }
 
+void MprpcApplication::InitBinLog(const std::vector<spdlog::sink_ptr>& sinks,
+                                  spdlog::level::level_enum level) {
+  static_assert(static_cast<int>(spdlog::level::info) == BINLOG_LEVEL_INFO &&
+                    static_cast<int>(spdlog::level::off) == BINLOG_LEVEL_OFF,
+                "BinLogLevel must match spdlog::level::level_enum");
+  BinLogger& binlog = BinLogger::GetInstance();
+  binlog.SetLevel(static_cast<BinLogLevel>(level));
+  // 在 BinLogger 的后台线程上调用：正文已经格式化好，这里只套用 sinks 的 pattern 并写出
+  binlog.SetSink([sinks](const BinLogRecord& record) {
+    auto lvl = static_cast<spdlog::level::level_enum>(record.site->level);
+    spdlog::log_clock::time_point when(
+        std::chrono::duration_cast<spdlog::log_clock::duration>(std::chrono::nanoseconds(record.wall_ns)));
+    spdlog::details::log_msg msg(when, spdlog::source_loc{record.site->file, record.site->line, ""}, "binlog", lvl,
+                                 record.message);
+    msg.thread_id = record.tid;
+    for (const auto& sink : sinks) {
+      if (sink->should_log(lvl)) sink->log(msg);
+    }
+  });
+  binlog.Start(static_cast<size_t>(BINLOG_BUFFER_KB) * 1024, std::chrono::milliseconds(BINLOG_FLUSH_INTERVAL_MS),
+               []() { ThreadPlacement::GetInstance().PinCurrentThread(kPlacementLog); });
+}
+
 /**
  * @brief 注册信号处理器
  * @details
@@ -0,0 +1,228 @@
+/**
+ * @file range_meta_store.cpp
+ * @brief Multi-Raft 区间元数据存储实现
+ */
+
+#include "range_meta_store.h"
+
+#include <algorithm>
+#include <chrono>
+
+RangeMetaStore::RangeMetaStore(ZkClient& zk, const std::string& root, const std::string& load_root,
+                               const std::string& moves_root)
+    : zk_(zk), root_(root), load_root_(load_root), moves_root_(moves_root) {}
+
+RangeMetaStore::~RangeMetaStore() {
+  // 先停后台线程 (watched_ 之后不再变化)，再摘掉回调 (ClearWatcher 会等正在执行的回调结束)
+  {
+    std::lock_guard<std::mutex> lock(reload_mutex_);
+    stopping_ = true;
+  }
+  reload_cv_.notify_all();
+  if (reload_thread_.joinable()) {
+    reload_thread_.join();
+  }
+  for (const std::string& path : watched_) {
+    zk_.ClearWatcher(path);
+  }
+}
+
+std::string RangeMetaStore::PathOf(uint64_t group_id) const {
+  return root_ + "/" + std::to_string(group_id);
+}
+
+// ============================================================================
+// 写入
+// ============================================================================
+
+bool RangeMetaStore::Put(const raft::RangeDescriptor& desc) {
+  const std::string path = PathOf(desc.group_id);
+  const std::string data = raft::EncodeRangeDescriptor(desc);
+
+  if (!zk_.Exists(path)) {
+    return zk_.Create(path, data, ZkNodeType::PERSISTENT);
+  }
+
+  std::string old_data;
+  raft::RangeDescriptor old;
+  if (zk_.Get(path, old_data) && raft::DecodeRangeDescriptor(old_data, &old) && old.epoch >= desc.epoch) {
+    LOG_ERROR("[RangeMetaStore] Stale descriptor for group {}: epoch {} <= {}", desc.group_id, desc.epoch,
+              old.epoch);
+    return false;
+  }
+  return zk_.Set(path, data);
+}
+
+bool RangeMetaStore::Remove(uint64_t group_id) {
+  return zk_.Delete(PathOf(group_id));
+}
+
+// ============================================================================
+// 读取与监听
+// ============================================================================
+
+bool RangeMetaStore::LoadAll(std::vector<raft::RangeDescriptor>* descs, bool watch) {
+  std::vector<std::string> children;
+  if (!zk_.GetChildren(root_, children, watch)) {
+    return false;
+  }
+  descs->clear();
+  for (const std::string& child : children) {
+    std::string data;
+    raft::RangeDescriptor desc;
+    if (!zk_.Get(root_ + "/" + child, data, watch)) {
+      continue;  // 刚被删除：子节点 Watch 会再触发一次重载
+    }
+    if (!raft::DecodeRangeDescriptor(data, &desc)) {
+      LOG_ERROR("[RangeMetaStore] Corrupted descriptor: {}/{}", root_, child);
+      continue;
+    }
+    descs->push_back(std::move(desc));
+  }
+  return true;
+}
+
+bool RangeMetaStore::Reload() {
+  std::vector<raft::RangeDescriptor> descs;
+  if (!LoadAll(&descs, true)) {
+    return false;
+  }
+
+  // 新出现的子节点也要注册回调 (ZooKeeper 的 Watch 只按路径分发)
+  for (const raft::RangeDescriptor& desc : descs) {
+    std::string path = PathOf(desc.group_id);
+    if (std::find(watched_.begin(), watched_.end(), path) == watched_.end()) {
+      zk_.SetWatcher(path, [this](const std::string&, int, int) { OnChanged(); });
+      watched_.push_back(std::move(path));
+    }
+  }
+
+  // 分裂进行到一半时 (新组已写入、原组还没缩小) 全量替换会因重叠失败，
+  // 这时逐条按 epoch 合入：覆盖规则会先保留较新的描述，下一次变化到来后收敛
+  if (!table_->Reset(descs)) {
+    std::sort(descs.begin(), descs.end(),
+              [](const raft::RangeDescriptor& a, const raft::RangeDescriptor& b) { return a.epoch < b.epoch; });
+    for (const raft::RangeDescriptor& desc : descs) {
+      table_->Update(desc);
+    }
+  }
+  LOG_INFO("[RangeMetaStore] Loaded {} ranges from {}", descs.size(), root_);
+  return true;
+}
+
+bool RangeMetaStore::Watch(raft::RangeTable* table) {
+  table_ = table;
+  zk_.SetWatcher(root_, [this](const std::string&, int, int) { OnChanged(); });
+  watched_.push_back(root_);
+  if (!zk_.Exists(root_) && !zk_.Create(root_, "", ZkNodeType::PERSISTENT)) {
+    return false;
+  }
+  if (!reload_thread_.joinable()) {
+    reload_thread_ = std::thread([this]() { ReloadLoop(); });
+  }
+  std::lock_guard<std::mutex> lock(reload_mutex_);
+  reload_pending_ = true;  // 首次加载也在后台线程完成，watched_ 只由该线程修改
+  reload_cv_.notify_all();
+  return true;
+}
+
+void RangeMetaStore::OnChanged() {
+  {
+    std::lock_guard<std::mutex> lock(reload_mutex_);
+    reload_pending_ = true;
+  }
+  reload_cv_.notify_all();
+}
+
+void RangeMetaStore::ReloadLoop() {
+  std::unique_lock<std::mutex> lock(reload_mutex_);
+  while (true) {
+    reload_cv_.wait(lock, [this]() { return stopping_ || reload_pending_; });
+    if (stopping_) {
+      return;
+    }
+    reload_pending_ = false;  // 重载期间的新变化会再次置位，不会丢
+    lock.unlock();
+    bool ok = Reload();
+    lock.lock();
+    if (!ok) {
+      // 连接断开等：Watch 没能重新设置，不能只等下一次变化，隔一段时间重试
+      LOG_ERROR("[RangeMetaStore] Reload failed, retrying");
+      reload_pending_ = true;
+      reload_cv_.wait_for(lock, std::chrono::seconds(1), [this]() { return stopping_; });
+    }
+  }
+}
+
+// ============================================================================
+// 负载上报与调度指令
+// ============================================================================
+
+bool RangeMetaStore::PublishLoad(const raft::NodeLoadReport& report) {
+  const std::string path = load_root_ + "/" + std::to_string(report.node_id);
+  const std::string data = raft::EncodeNodeLoadReport(report);
+  if (zk_.Exists(path)) {
+    return zk_.Set(path, data);
+  }
+  return zk_.Create(path, data, ZkNodeType::EPHEMERAL);
+}
+
+bool RangeMetaStore::LoadReports(std::vector<raft::NodeLoadReport>* reports) {
+  reports->clear();
+  if (!zk_.Exists(load_root_)) {
+    return true;  // 还没有节点上报过
+  }
+  std::vector<std::string> children;
+  if (!zk_.GetChildren(load_root_, children)) {
+    return false;
+  }
+  for (const std::string& child : children) {
+    std::string data;
+    raft::NodeLoadReport report;
+    if (!zk_.Get(load_root_ + "/" + child, data)) {
+      continue;  // 节点刚下线
+    }
+    if (!raft::DecodeNodeLoadReport(data, &report)) {
+      LOG_ERROR("[RangeMetaStore] Corrupted load report: {}/{}", load_root_, child);
+      continue;
+    }
+    reports->push_back(std::move(report));
+  }
+  return true;
+}
+
+bool RangeMetaStore::IssueMove(const raft::PlacementMove& move) {
+  const std::string path = moves_root_ + "/" + std::to_string(move.group_id);
+  if (zk_.Exists(path)) {
+    return false;
+  }
+  return zk_.Create(path, raft::EncodePlacementMove(move), ZkNodeType::PERSISTENT);
+}
+
+bool RangeMetaStore::ListMoves(std::vector<raft::PlacementMove>* moves) {
+  moves->clear();
+  if (!zk_.Exists(moves_root_)) {
+    return true;
+  }
+  std::vector<std::string> children;
+  if (!zk_.GetChildren(moves_root_, children)) {
+    return false;
+  }
+  for (const std::string& child : children) {
+    std::string data;
+    raft::PlacementMove move;
+    if (!zk_.Get(moves_root_ + "/" + child, data)) {
+      continue;
+    }
+    if (!raft::DecodePlacementMove(data, &move)) {
+      LOG_ERROR("[RangeMetaStore] Corrupted move: {}/{}", moves_root_, child);
+      continue;
+    }
+    moves->push_back(move);
+  }
+  return true;
+}
+
+bool RangeMetaStore::FinishMove(uint64_t group_id) {
+  return zk_.Delete(moves_root_ + "/" + std::to_string(group_id));
+}
@@ -2,11 +2,16 @@
 #include "rpcheader.pb.h" 
 #include "mprpcapplication.h" 
 #include "zookeeperutil.h"    
+#include "epoch.h"
+#include "cpu_topology.h"
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+#include <poll.h>
+#include <climits>
 #include <unistd.h>
 #include <fcntl.h>
 #include <cerrno>
@@ -18,6 +23,11 @@
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 
+// 协程库：同步调用在协程中时挂起协程而不是阻塞线程
+#include "fiber.h"
+#include "iomanager.h"
+#include "scheduler.h"
+
 // ============================================================================
 // 静态辅助工具 
 // (保留原来源码逻辑，未修改，仅作为工具函数使用)
@@ -63,6 +73,23 @@ static bool PeekVarint32FromString(const std::string& buffer,
   return true;
 }
 
+// ============================================================================
+// 客户端共享 reactor
+// ============================================================================
+// 所有 RpcConnection 的读事件都注册在这一个 IOManager 上，线程数由第一个创建它的配置决定
+static std::atomic<monsoon::IOManager*> g_client_reactor{nullptr};
+
+static monsoon::IOManager* GetClientReactor(int threads) {
+    static std::once_flag once;
+    std::call_once(once, [threads]() {
+        // 故意不析构：进程退出时仍有注册的读事件，IOManager 析构会一直等待它们而阻塞退出
+        // 开启线程放置时 reactor 线程各自独占 rpc_client 组的一个核，未开启时 Cpus 为空、不绑核
+        g_client_reactor = new monsoon::IOManager(std::max(1, threads), false, "RpcClientIO",
+                                                  ThreadPlacement::GetInstance().Cpus(kPlacementRpcClient));
+    });
+    return g_client_reactor.load();
+}
+
 // ============================================================================
 // [类 RpcConnection] 实现 
 // 【并发化修改】：这是一个新抽象出的类，用于封装单个 TCP 连接的生命周期和 IO 线程
@@ -73,7 +100,7 @@ RpcConnection::RpcConnection(int id, const std::string& ip, uint16_t port,
     : id_(id), ip_(ip), port_(port), config_(config), fd_(-1) {}
 
 RpcConnection::~RpcConnection() {
-    StopReceiveThread();
+    StopReceiving();
     Close();
 }
 
@@ -161,37 +188,52 @@ bool RpcConnection::Connect() {
         }
     }
 
-    // 5. 恢复阻塞模式 (后续 send/recv 使用阻塞模式，但 recv 在独立线程中)
-    fcntl(client_fd, F_SETFL, flags);
-    
-    // 6. 设置读写超时 (防止死锁)
-    struct timeval timeout;
-    timeout.tv_sec = config_.rpc_timeout_ms / 1000;
-    timeout.tv_usec = (config_.rpc_timeout_ms % 1000) * 1000;
-    setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)); // 设置接收超时
-    setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)); // 设置发送超时
+    // 5. 保持非阻塞模式：接收由 reactor 驱动读到 EAGAIN，发送遇到 EAGAIN 时 poll 等待可写 (见 WriteFrames)
 
     fd_ = client_fd;
     LOG_INFO("[Conn-{}] Connected to {}:{}", id_, ip_, port_);
     // std::cout << "[Conn-" << id_ << "] Connected to " << ip_ << ":" << port_ << std::endl;
+
+    // 6. 断线重连：之前已经在接收的连接，新 fd 重新注册读事件
+    {
+        std::lock_guard<std::mutex> lock(receive_state_mutex_);
+        if (receiving_) {
+            RegisterReadEvent(client_fd);
+        }
+    }
     return true;
 }
 
+/**
+ * @brief [RpcConnection] 断开连接
+ * @details 可能在任意线程调用 (写失败 / reactor 读失败 / 析构)。摘除与 close 都在 recv_mutex_ 下进行：
+ * reactor 线程每次 recv 前也在 recv_mutex_ 下确认 fd_ 未变 (见 ReadToBuffer)，
+ * 所以不会对已经 close、甚至已被复用的 fd 号继续 recv。
+ */
 void RpcConnection::Close() {
-    if (fd_ != -1) {
-        close(fd_);
-        fd_ = -1;
+    std::lock_guard<std::mutex> lock(recv_mutex_);
+    int fd = fd_.exchange(-1);
+    if (fd != -1) {
+        // 先从 epoll 摘掉再 close，避免 fd 号被复用后收到旧连接的事件
+        if (monsoon::IOManager* reactor = g_client_reactor.load()) {
+            reactor->delEvent(fd, monsoon::READ);
+        }
+        close(fd);
+        recv_buffer_.clear();  // 旧连接上读了一半的包，不能拼到重连后的字节流前面
     }
 }
 
 /**
  * @brief [RpcConnection] 发送请求
  * @details
- * 逻辑保留了原 MprpcChannel::SendRequest 的序列化和拼接逻辑。
+ * 逻辑保留了原 MprpcChannel::SendRequest 的帧格式。
  * * 【并发化修改】：
- * 1. 增加了 `std::lock_guard<std::mutex> lock(send_mutex_);` 
- * 原因：多个业务线程可能通过连接池共享同一个 Connection 对象，必须互斥写入 socket。
+ * 1. 多个业务线程可能通过连接池共享同一个 Connection 对象，写 socket 由写合并队列串行化 (见 SubmitFrame)。
  * 2. 不再负责“接收响应”，发送完毕即返回 true。
+ * * 【零拷贝修改】：
+ * 原实现先把 header / args 各序列化成 string，再 append 到 send_buffer，请求体至少被拷贝三次；
+ * 现在先算出各部分长度，直接把 varint + header + args 序列化进一块池化的帧缓冲区，
+ * 请求体只写一次，之后由 sendmsg 的 iovec 直接发出。
  * 
  * @brief 发送 RPC 请求（带帧头）
  * @details
@@ -202,6 +244,7 @@ void RpcConnection::Close() {
  * - method_name: 方法名
  * - args_size: 参数长度
  * - request_id: 请求 ID（用于异步匹配）
+ * - trace_id / span_id: 追踪上下文（仅采样的请求，未采样时不占字节）
  * 
  * @param request_id 请求 ID
  * @param service_name 服务名
@@ -214,120 +257,292 @@ bool RpcConnection::SendRequest(uint64_t request_id,
                                 const std::string& service_name,
                                 const std::string& method_name,
                                 const google::protobuf::Message* request,
-                                google::protobuf::RpcController* controller) {
-    // 【关键修改】加锁保护发送缓冲区和 Socket 写入
-    std::lock_guard<std::mutex> lock(send_mutex_);
-    
-    // 1. 序列化请求参数 Request
-    std::string args_str;
-    if (!request->SerializeToString(&args_str)) {
-        controller->SetFailed("Serialize request failed");
-        return false;
-    }
+                                google::protobuf::RpcController* controller,
+                                const TraceContext& trace) {
+    // 1. 计算请求参数 Request 的序列化长度 (不生成中间 string)
+    size_t args_size = request->ByteSizeLong();
 
     // 2. 构造 Header
     RPC::RpcHeader header;
     header.set_service_name(service_name);
     header.set_method_name(method_name);
-    header.set_args_size(args_str.size());
+    header.set_args_size(args_size);
     header.set_request_id(request_id);  // 关键：设置请求 ID
-
-    // 3. 序列化 RpcHeader
-    std::string header_str;
-    if (!header.SerializeToString(&header_str)) {
+    if (trace.Sampled()) {
+        header.set_trace_id(trace.trace_id);
+        header.set_span_id(trace.span_id);
+    }
+    size_t header_size = header.ByteSizeLong();
+
+    // 3. 整帧一次性序列化进池化缓冲区：[Varint32: header_size] + [Header] + [Args]
+    size_t varint_size = google::protobuf::io::CodedOutputStream::VarintSize32(static_cast<uint32_t>(header_size));
+    OutgoingFrame frame;
+    frame.buffer = AcquireBuffer();
+    frame.buffer.resize(varint_size + header_size + args_size);
+
+    uint8_t* p = reinterpret_cast<uint8_t*>(&frame.buffer[0]);
+    p = google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(static_cast<uint32_t>(header_size), p);
+    if (!header.SerializeToArray(p, static_cast<int>(header_size))) {
+        ReleaseBuffer(std::move(frame.buffer));
         controller->SetFailed("Serialize header failed");
         return false;
     }
+    p += header_size;
+    if (!request->SerializeToArray(p, static_cast<int>(args_size))) {
+        ReleaseBuffer(std::move(frame.buffer));
+        controller->SetFailed("Serialize request failed");
+        return false;
+    }
 
-    // 4. 构造完整的请求帧：[Varint32: header_size] + [Header] + [Args]
-    std::string send_buffer;
-    {
-        google::protobuf::io::StringOutputStream string_output(&send_buffer); // 将 string 包装成 protobuf 支持的输出流
-        google::protobuf::io::CodedOutputStream coded_output(&string_output); // 给“流”增加了“编码能力”和“缓冲能力”
-        
-        // 写入 header 长度（varint 编码，占 1-5 字节）
-        coded_output.WriteVarint32(header_str.size());
-        // CodedOutputStream 析构时会自动 flush，coded_output会让适配器string_output赶紧取走数据（header长度）
+    // 4. 交给写合并队列发送
+    bool ok = SubmitFrame(&frame);
+    ReleaseBuffer(std::move(frame.buffer));
+    if (!ok) {
+        controller->SetFailed(std::string("Send failed: ") + strerror(frame.error));
+        failed_requests_++;
+        return false;
     }
-    
-    // 追加 header 和 args
-    send_buffer.append(header_str);
-    send_buffer.append(args_str);
-
-    // 5. 发送数据（循环发送，处理部分发送的情况）
-    size_t total_sent = 0;
-    while (total_sent < send_buffer.size()) {
-        ssize_t sent = send(fd_, send_buffer.data() + total_sent,
-                            send_buffer.size() - total_sent, 0);
+    total_requests_++;
+    return true;
+}
+
+/**
+ * @brief [RpcConnection] 写合并 (write-combining)
+ * @details
+ * 调用方把帧挂到 send_queue_ 上：
+ * - 如果当前没有写者，自己成为写者，把队列里所有帧 (包括其他线程刚挂上的) 一次 sendmsg 发出；
+ * - 如果已有写者，等待它把自己的帧写完。
+ * 高并发时 N 个请求合成一次系统调用；写者最多连续处理 kMaxCombineRounds 轮，
+ * 之后把写者身份交给仍在等待的线程，避免单个调用方被一直占用。
+ * @return 本帧是否写入成功
+ */
+bool RpcConnection::SubmitFrame(OutgoingFrame* frame) {
+    static constexpr int kMaxCombineRounds = 8;
+
+    std::unique_lock<std::mutex> lock(send_mutex_);
+    send_queue_.push_back(frame);
+    while (!frame->done && writer_active_) {
+        send_cv_.wait(lock);
+    }
+    if (frame->done) {
+        return frame->ok;
+    }
+
+    // 成为写者
+    writer_active_ = true;
+    std::vector<OutgoingFrame*> batch;
+    for (int round = 0; round < kMaxCombineRounds && !send_queue_.empty(); ++round) {
+        batch.swap(send_queue_);
+        lock.unlock();
+        int err = WriteFrames(batch);
+        lock.lock();
+        for (OutgoingFrame* f : batch) {
+            f->done = true;
+            f->ok = (err == 0);
+            f->error = err;
+        }
+        batch.clear();
+        send_cv_.notify_all();
+    }
+    writer_active_ = false;
+    // 队列里还有帧：唤醒等待者，其中之一会接替成为写者
+    send_cv_.notify_all();
+    return frame->ok;
+}
+
+/**
+ * @brief [RpcConnection] 用 sendmsg + iovec 把一批帧写到 socket (处理部分写)
+ * @return 0 成功，否则为 errno
+ */
+int RpcConnection::WriteFrames(const std::vector<OutgoingFrame*>& frames) {
+    int fd = fd_;
+    if (fd == -1) {
+        return ENOTCONN;
+    }
+
+    std::vector<struct iovec> iov;
+    iov.reserve(frames.size());
+    for (OutgoingFrame* f : frames) {
+        iov.push_back({&f->buffer[0], f->buffer.size()});
+    }
+
+    size_t idx = 0;
+    while (idx < iov.size()) {
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov[idx];
+        msg.msg_iovlen = std::min<size_t>(iov.size() - idx, IOV_MAX);
+
+        // MSG_NOSIGNAL：对端关闭时返回 EPIPE 而不是触发 SIGPIPE 杀掉进程
+        ssize_t sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // 非阻塞 socket 的发送缓冲区满：等待可写，超时视为失败
+            int err = WaitWritable(fd);
+            if (err == 0) {
+                continue;
+            }
+            Close();
+            return err;
+        }
         if (sent <= 0) {
-            controller->SetFailed(std::string("Send failed: ") + strerror(errno));
-            failed_requests_++;
+            int err = (sent < 0) ? errno : EPIPE;
             Close(); // 发送失败视为连接断开
-            return false;
+            return err;
+        }
+
+        // 跳过已完整写出的 iovec，调整写了一半的那个
+        size_t n = static_cast<size_t>(sent);
+        while (idx < iov.size() && n >= iov[idx].iov_len) {
+            n -= iov[idx].iov_len;
+            ++idx;
+        }
+        if (n > 0) {
+            iov[idx].iov_base = static_cast<char*>(iov[idx].iov_base) + n;
+            iov[idx].iov_len -= n;
         }
-        total_sent += sent;
     }
-    total_requests_++;
-    return true;
+    return 0;
+}
+
+// 等待 fd 可写，最多 rpc_timeout_ms；返回 0 或 errno
+int RpcConnection::WaitWritable(int fd) {
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLOUT;
+    while (true) {
+        int ret = poll(&pfd, 1, config_.rpc_timeout_ms);
+        if (ret > 0) {
+            return (pfd.revents & (POLLERR | POLLHUP)) ? EPIPE : 0;
+        }
+        if (ret == 0) {
+            return ETIMEDOUT;
+        }
+        if (errno != EINTR) {
+            return errno;
+        }
+    }
+}
+
+// 帧缓冲区池：复用 string 的容量，热路径上不再每次 malloc
+std::string RpcConnection::AcquireBuffer() {
+    std::lock_guard<std::mutex> lock(buffer_pool_mutex_);
+    if (buffer_pool_.empty()) {
+        return std::string();
+    }
+    std::string buf = std::move(buffer_pool_.back());
+    buffer_pool_.pop_back();
+    return buf;
+}
+
+void RpcConnection::ReleaseBuffer(std::string&& buf) {
+    static constexpr size_t kMaxPooledBuffers = 16;
+    static constexpr size_t kMaxPooledCapacity = 1024 * 1024;  // 偶发的大 Put 不常驻内存
+    if (buf.capacity() > kMaxPooledCapacity) {
+        return;
+    }
+    buf.clear();
+    std::lock_guard<std::mutex> lock(buffer_pool_mutex_);
+    if (buffer_pool_.size() < kMaxPooledBuffers) {
+        buffer_pool_.push_back(std::move(buf));
+    }
 }
 
 /**
- * @brief [RpcConnection] 启动接收线程
+ * @brief [RpcConnection] 启动接收
  * @details
- * 【并发化修改】：这是新增的函数。
- * 以前的接收是在 CallMethod 中同步调用的，现在每个连接启动一个独立的 std::thread 进行接收。
- * 解决了并发重复启动导致的崩溃问题
+ * 以前每个连接启动一个独立的 std::thread 阻塞 recv，成百上千个目标时会有数千个空闲线程；
+ * 现在只在共享 reactor 上注册读事件，多次调用直接复用 (解决了并发重复启动导致的崩溃问题)。
  */
-void RpcConnection::StartReceiveThread(std::function<void(uint64_t, int32_t, const std::string&, const std::string&)> callback) {
-    std::lock_guard<std::mutex> lock(thread_start_mutex_);  // 加锁防止多线程同时启动
+void RpcConnection::StartReceiving(std::function<void(uint64_t, int32_t, const std::string&, const std::string&)> callback) {
+    std::lock_guard<std::mutex> lock(receive_state_mutex_);  // 加锁防止多线程同时启动
 
-    // 如果已经在运行，直接返回，不做任何操作
-    // 这让后续拿到该连接的线程可以直接复用已有的接收线程
-    if (thread_is_running_) {
-        LOG_INFO("[Conn-{}] Receive thread already running, can be reused", id_);
+    // 如果已经在接收，直接返回，不做任何操作
+    if (receiving_) {
         return;
     }
 
     response_callback_ = callback; // 绑定回调，连接层只负责收字节，收齐了就通过这个回调扔给 Channel 去处理业务。
-    stop_recv_thread_ = false;
-    recv_thread_ = std::thread([this]() { ReceiveLoop(); }); // 启动线程：std::thread 启动，执行 ReceiveLoop
+    receiving_ = true;
 
-    // 标记为已运行
-    thread_is_running_ = true;
-
-    LOG_INFO("[Conn-{}] Receive thread first started.", id_);
+    int fd = fd_;
+    if (fd != -1) {
+        RegisterReadEvent(fd);
+    }
+    LOG_INFO("[Conn-{}] Receiving on shared reactor.", id_);
 }
 
-void RpcConnection::StopReceiveThread() {
-    stop_recv_thread_ = true;   // 通知线程在下一次循环判断时退出（优雅退出）。
-    if (recv_thread_.joinable()) {
-        recv_thread_.join();
+void RpcConnection::StopReceiving() {
+    std::lock_guard<std::mutex> lock(receive_state_mutex_);
+    receiving_ = false;
+    int fd = fd_;
+    monsoon::IOManager* reactor = g_client_reactor.load();
+    if (fd != -1 && reactor) {
+        // delEvent 不会触发回调；已经在执行的回调通过 weak_ptr 保活，不会访问已析构的连接
+        reactor->delEvent(fd, monsoon::READ);
     }
+}
+
+/**
+ * @brief [RpcConnection] 注册 (或重新注册) 一次性的读事件
+ * @details IOManager 的事件触发一次后即自动移除，且事件回调会投递到注册时所在线程的调度器，
+ * 所以注册必须发生在 reactor 线程中：非 reactor 线程先把注册动作 schedule 过去。
+ */
+void RpcConnection::RegisterReadEvent(int fd) {
+    monsoon::IOManager* reactor = GetClientReactor(config_.io_thread_pool_size);
+    std::weak_ptr<RpcConnection> weak_self = shared_from_this();
+
+    auto arm = [weak_self, fd, reactor]() {
+        auto self = weak_self.lock();
+        if (!self) {
+            return;  // 连接已析构
+        }
+        // 与 Close 互斥：检查通过后 fd 不会在 addEvent 之前被关闭
+        std::lock_guard<std::mutex> lock(self->recv_mutex_);
+        if (self->fd_ != fd) {
+            return;  // 在等待注册期间已经断开/重连
+        }
+        reactor->addEvent(fd, monsoon::READ, [weak_self, fd]() {
+            if (auto conn = weak_self.lock()) {
+                conn->OnReadable(fd);
+            }
+        });
+    };
 
-    std::lock_guard<std::mutex> lock(thread_start_mutex_);
-    thread_is_running_ = false;
+    if (monsoon::IOManager::GetThis() == reactor) {
+        arm();
+    } else {
+        reactor->schedule(arm);
+    }
 }
 
 /**
- * @brief [RpcConnection] 接收线程循环
+ * @brief [RpcConnection] 可读事件处理 (运行在 reactor 线程)
  * @details
- * 【并发化修改】：
- * 1. 这是一个死循环 (`while(!stop)` )，持续从 socket 读取数据。
- * 2. 复用了原 `ReadToBuffer` 和 `TryParseResponse` 的核心逻辑。
- * 3. 当解析出一个完整包时，不再直接处理，而是通过 `response_callback_` 通知 MprpcChannel。
+ * 1. 边缘触发：一直读到 EAGAIN，每次读完都尝试切出所有完整包 (处理粘包)；
+ * 2. 复用了原 `TryParseResponse` 的核心逻辑，解析出完整包后通过 `response_callback_` 通知 MprpcChannel；
+ * 3. 单次最多读 kMaxReadsPerEvent 轮，防止一个高流量连接霸占 reactor 线程，之后重新注册让出；
+ * 4. 读事件一次性有效，处理完重新注册；连接出错则 Close，不再注册。
  */
-void RpcConnection::ReceiveLoop() {
-    while (!stop_recv_thread_) {
-        // 1. 读取数据 (复用逻辑)
-        if (!ReadToBuffer()) {
-            if (!stop_recv_thread_) {
-                LOG_ERROR("[Conn-{}] Connection closed/error, waiting for retry...", id_);
-                // std::cerr << "[Conn-" << id_ << "] Connection closed/error, waiting for retry..." << std::endl;
-                Close();
-                // 简单重试等待，防止 CPU 空转
-                std::this_thread::sleep_for(std::chrono::seconds(1)); 
-            }
-            break;
+void RpcConnection::OnReadable(int fd) {
+    static constexpr int kMaxReadsPerEvent = 16;
+
+    if (fd_ != fd) {
+        return;  // 旧 fd 的残留事件
+    }
+
+    for (int round = 0; round < kMaxReadsPerEvent; ++round) {
+        // 1. 读取数据
+        ReadResult result = ReadToBuffer(fd);
+        if (result == ReadResult::kStale) {
+            return;  // 其他线程已经 Close (例如写失败)，不再注册
+        }
+        if (result == ReadResult::kClosed) {
+            LOG_ERROR("[Conn-{}] Connection closed/error, will reconnect on next call.", id_);
+            Close();
+            return;
         }
 
         // 2. 循环解析 (处理粘包)
@@ -347,21 +562,19 @@ void RpcConnection::ReceiveLoop() {
             catch (const std::exception& e) {
                 // 捕获标准异常 (如 bad_alloc, runtime_error)
                 LOG_ERROR("[Conn-{}] CRITICAL EXCEPTION in parser: {}", id_, e.what());
-                // std::cerr << "[Conn-" << id_ << "] CRITICAL EXCEPTION in parser: " << e.what() << std::endl;
                 // 发生异常通常意味着内存错乱或协议严重破坏，必须断开连接
                 Close(); 
-                return; // 直接退出线程，防止死循环或二次崩溃
+                return; // 不再注册读事件，防止死循环或二次崩溃
             }
             catch (...) {
                 // 捕获未知异常
                 LOG_ERROR("[Conn-{}] UNKNOWN EXCEPTION in parser.", id_);
-                // std::cerr << "[Conn-" << id_ << "] UNKNOWN EXCEPTION in parser." << std::endl;
                 Close();
                 return;
             }
 
             if (!parse_success) {
-                break; // 数据不够，跳出内层循环，继续 ReadToBuffer
+                break; // 数据不够，跳出内层循环，继续读取
             }
 
             // 3. 触发回调 (通知 Channel 层)
@@ -369,52 +582,55 @@ void RpcConnection::ReceiveLoop() {
                 response_callback_(request_id, error_code, error_msg, response_data);
             }
         }
+
+        if (result == ReadResult::kWouldBlock) {
+            break;  // 内核缓冲区已读空
+        }
     }
-    LOG_INFO("[Conn-{}] Receive thread exited.", id_);
 
+    // 4. 重新注册 (未读空时 epoll_ctl MOD 会立即再次报告可读)
+    std::lock_guard<std::mutex> lock(receive_state_mutex_);
+    if (receiving_ && fd_ == fd) {
+        RegisterReadEvent(fd);
+    }
 }
 
 /**
  * @brief [RpcConnection] 读取数据到缓冲区
  * @details
- * 逻辑基本保留原 MprpcChannel::ReadToBuffer。
- * 【并发化修改】：
- * 增加了 `std::lock_guard<std::mutex> lock(recv_mutex_);`
- * 因为接收线程在写 buffer，而可能的外部监控或重置操作可能会读写 buffer。
+ * 逻辑基本保留原 MprpcChannel::ReadToBuffer，fd 改为非阻塞：
+ * 读到数据返回 kData，内核缓冲区已空返回 kWouldBlock，对端关闭或出错返回 kClosed，
+ * fd 已被其他线程 Close 返回 kStale。
+ * recv 本身也在 `recv_mutex_` 下进行：每次 recv 前确认 fd_ 仍是这个 fd，Close 与之互斥
+ * (非阻塞 fd，recv 不会长时间持锁)。
  */
-bool RpcConnection::ReadToBuffer() {
-    if (fd_ == -1) return false;
-
-    char temp_buf[4096];
-    ssize_t n = recv(fd_, temp_buf, sizeof(temp_buf), 0);
-    
-    if (n > 0) {
+RpcConnection::ReadResult RpcConnection::ReadToBuffer(int fd) {
+    char temp_buf[16384];
+    while (true) {
+        std::lock_guard<std::mutex> lock(recv_mutex_);
+        if (fd_ != fd) {
+            return ReadResult::kStale;
+        }
+        ssize_t n = recv(fd, temp_buf, sizeof(temp_buf), 0);
+        if (n > 0) {
             // 1. 正常读取到数据
-            std::lock_guard<std::mutex> lock(recv_mutex_);
             recv_buffer_.append(temp_buf, n);
-            return true;
-        } 
-        else if (n == 0) {
+            return ReadResult::kData;
+        } else if (n == 0) {
             // 2. 对端关闭连接 (FIN)
             LOG_ERROR("[Conn-{}] Connection closed by peer.", id_);
-            // std::cerr << "[Conn-" << id_ << "] Connection closed by peer." << std::endl;
-            return false; // 返回 false 通知调用者断开连接
-        } 
-        else {
-            // 3. 读取发生错误 (n < 0)
-            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
-                // 3.1 仅仅是超时 (Timeout) 或 信号中断
-                // 注意：对于连接池的长连接，超时不应该视为错误断开，
-                // 而是应该视为空转一轮，让线程有机会检查 stop_recv_thread_ 标志。
-                // 所以这里返回 true，但是不追加数据。
-                return true; 
-            } else {
-                // 3.2 真正的 socket 错误 (如 Connection Reset)
-                LOG_ERROR("[Conn-{}] Recv error: {}", id_, strerror(errno));
-                // std::cerr << "[Conn-" << id_ << "] Recv error: " << strerror(errno) << std::endl;
-                return false; // 返回 false 通知调用者断开连接
-            }
+            return ReadResult::kClosed; // 通知调用者断开连接
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            // 3.1 数据已读完，等待下一次可读事件
+            return ReadResult::kWouldBlock;
+        } else {
+            // 3.2 真正的 socket 错误 (如 Connection Reset)
+            LOG_ERROR("[Conn-{}] Recv error: {}", id_, strerror(errno));
+            return ReadResult::kClosed;
         }
+    }
 }
 
 /**
@@ -503,55 +719,160 @@ bool RpcConnection::TryParseResponse(uint64_t& request_id, int32_t& error_code,
 // 【并发化修改】：这是一个新类，用于管理多个 RpcConnection，实现负载均衡
 // ============================================================================
 
+static PoolSizer::Options SizerOptions(const RpcClientConfig& config) {
+    PoolSizer::Options options;
+    options.min_size = static_cast<size_t>(std::max(1, config.connection_pool_size));
+    options.max_size = static_cast<size_t>(std::max(config.connection_pool_size, config.max_connection_pool_size));
+    options.target_inflight = config.target_inflight_per_connection;
+    options.shrink_delay = std::chrono::milliseconds(config.pool_shrink_delay_ms);
+    return options;
+}
+
 ConnectionPool::ConnectionPool(const std::string& ip, uint16_t port,
                                const RpcClientConfig& config)
-    : ip_(ip), port_(port), config_(config) {}
+    : ip_(ip), port_(port), config_(config), connections_(new ConnList()), sizer_(SizerOptions(config)) {}
 
 ConnectionPool::~ConnectionPool() {
-    // 优雅结束所有连接的接收线程
-    for (auto& conn : connections_) {
-        conn->StopReceiveThread();
+    // 优雅结束所有连接的接收 (从共享 reactor 注销读事件)；析构时已没有选路的读者
+    const ConnList* conns = connections_.load(std::memory_order_acquire);
+    for (auto& conn : *conns) {
+        conn->StopReceiving();
     }
+    for (auto& conn : draining_) {
+        conn->StopReceiving();
+    }
+    delete conns;
 }
 
 /**
  * @brief [ConnectionPool] 初始化连接池
- * @details 创建指定数量的 RpcConnection 并尝试连接。
+ * @details 创建 connection_pool_size 个 RpcConnection 并尝试连接，之后按并发度伸缩。
  */
 bool ConnectionPool::Init() {
     LOG_INFO("[ConnPool] Initializing connection pool to {}:{} with {} connections.",
              ip_, port_, config_.connection_pool_size);
-    for (int i = 0; i < config_.connection_pool_size; ++i) {
-        auto conn = std::make_shared<RpcConnection>(i, ip_, port_, config_);    // 创建N个连接对象实例
-        if (!conn->Connect()) {
-            LOG_ERROR("[ConnPool] Warn: Failed to connect {}, will retry later.", i);
-            // std::cerr << "[ConnPool] Warn: Failed to connect " << i << ", will retry later." << std::endl;
-            // 策略：即使部分连接失败也继续初始化，允许后续重连
-        }
-        LOG_INFO("[ConnPool] Successfully created connection {}", i);
-        connections_.push_back(conn); // 创建的连接加入连接池（一个 vector 里）
+    std::lock_guard<std::mutex> lock(resize_mutex_);
+    auto* next = new ConnList(*connections_.load(std::memory_order_relaxed));
+    for (size_t i = next->size(); i < sizer_.options().min_size; ++i) {
+        next->push_back(NewConnection()); // 创建的连接加入连接池（一个 vector 里）
     }
+    Publish(next);
     return true;
 }
 
+// 调用方持有 resize_mutex_
+std::shared_ptr<RpcConnection> ConnectionPool::NewConnection() {
+    int id = next_conn_id_++;
+    auto conn = std::make_shared<RpcConnection>(id, ip_, port_, config_);    // 创建连接对象实例
+    if (!conn->Connect()) {
+        LOG_ERROR("[ConnPool] Warn: Failed to connect {}, will retry later.", id);
+        // 策略：即使连接失败也加入连接池，允许后续重连 (断开的连接在选路时排在最后)
+    } else {
+        LOG_INFO("[ConnPool] Successfully created connection {}", id);
+    }
+    if (callback_) {
+        conn->StartReceiving(callback_);
+    }
+    return conn;
+}
+
+void ConnectionPool::Publish(ConnList* next) {
+    const ConnList* old = connections_.exchange(next, std::memory_order_acq_rel);
+    // 选路方可能还持有旧快照的指针，宽限期后再释放
+    EpochManager::GetInstance().retire(const_cast<ConnList*>(old));
+}
+
+void ConnectionPool::StartReceiving(ResponseCallback callback) {
+    std::lock_guard<std::mutex> lock(resize_mutex_);
+    if (callback_) {
+        return;
+    }
+    callback_ = std::move(callback);
+    for (auto& conn : *connections_.load(std::memory_order_relaxed)) {
+        conn->StartReceiving(callback_);
+    }
+}
+
 /**
  * @brief [ConnectionPool] 获取连接
- * @details 简单的 Round-Robin (轮询) 策略，实现负载均衡。
- * 原子计数器让n个线程分别获取到0~n-1的返回值，再对每个值进行取模映射到连接池索引，索引对应的是真正的连接，将被返回分配。
+ * @details power-of-two-choices：随机两个连接中取在途请求较少的一个 (见 conn_balancer.h)。
+ * 以前的轮询不看负载，一个卡住的连接和空闲的连接分到一样多的调用。
  */
 std::shared_ptr<RpcConnection> ConnectionPool::GetConnection() {
-    if (connections_.empty()) return nullptr;
-    // 线程安全的轮询
-    size_t idx = next_conn_idx_.fetch_add(1) % connections_.size();
-    return connections_[idx];   // 从连接池中取出对应索引的连接
+    if ((picks_.fetch_add(1, std::memory_order_relaxed) & (kResizeCheckEvery - 1)) == 0) {
+        MaybeResize();
+    }
+    EpochGuard guard;
+    const ConnList* conns = connections_.load(std::memory_order_acquire);
+    if (conns->empty()) return nullptr;
+    size_t idx = PickPowerOfTwo(conns->size(), [conns](size_t i) { return (*conns)[i]->Load(); });
+    return (*conns)[idx];   // 从连接池中取出对应索引的连接
+}
+
+/**
+ * @brief [ConnectionPool] 采样在途总数并按需扩 / 缩一个连接
+ * @details 由选路的调用线程顺带执行，try_lock 失败 (另一个线程正在扩缩容) 直接返回，
+ * 选路本身不会被扩容时的 connect 阻塞。
+ */
+void ConnectionPool::MaybeResize() {
+    std::unique_lock<std::mutex> lock(resize_mutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;
+    }
+    // 之前摘下的连接：在途请求都已完成 (响应 / 超时) 后再关闭
+    draining_.erase(std::remove_if(draining_.begin(), draining_.end(),
+                                   [](const std::shared_ptr<RpcConnection>& conn) {
+                                       if (conn->Load().requests > 0) {
+                                           return false;
+                                       }
+                                       conn->StopReceiving();
+                                       conn->Close();
+                                       return true;
+                                   }),
+                    draining_.end());
+
+    const ConnList* current = connections_.load(std::memory_order_relaxed);
+    int64_t inflight = 0;
+    for (const auto& conn : *current) {
+        inflight += conn->Load().requests;
+    }
+    size_t want = sizer_.Observe(inflight, current->size());
+    if (want > current->size()) {
+        auto* next = new ConnList(*current);
+        next->push_back(NewConnection());
+        LOG_INFO("[ConnPool] {}:{} grows to {} connections (concurrency {:.1f})",
+                 ip_, port_, next->size(), sizer_.Concurrency());
+        Publish(next);
+    } else if (want < current->size()) {
+        // 摘下最空闲的一个：新快照里不再有它，不会再被选中
+        size_t victim = 0;
+        for (size_t i = 1; i < current->size(); ++i) {
+            if ((*current)[i]->Load().requests < (*current)[victim]->Load().requests) {
+                victim = i;
+            }
+        }
+        auto* next = new ConnList(*current);
+        draining_.push_back((*next)[victim]);
+        next->erase(next->begin() + static_cast<long>(victim));
+        LOG_INFO("[ConnPool] {}:{} shrinks to {} connections (concurrency {:.1f})",
+                 ip_, port_, next->size(), sizer_.Concurrency());
+        Publish(next);
+    }
+}
+
+size_t ConnectionPool::Size() const {
+    EpochGuard guard;
+    return connections_.load(std::memory_order_acquire)->size();
 }
 
 // 打印连接池中每个连接的统计信息
 void ConnectionPool::PrintStats() const {
+    EpochGuard guard;
     LOG_INFO("========== Connection Pool Stats ==========");
-    for (const auto& conn : connections_) {
-        LOG_INFO("Conn-{} | Requests: {} | Failed: {}",
-                 conn->GetId(), conn->GetTotalRequests(), conn->GetFailedRequests());
+    for (const auto& conn : *connections_.load(std::memory_order_acquire)) {
+        ConnectionLoad load = conn->Load();
+        LOG_INFO("Conn-{} | Requests: {} | Failed: {} | Inflight: {} ({} bytes)",
+                 conn->GetId(), conn->GetTotalRequests(), conn->GetFailedRequests(), load.requests, load.bytes);
     }
     LOG_INFO("==========================================");
 }
@@ -565,8 +886,100 @@ void ConnectionPool::PrintStats() const {
 static std::map<std::string, std::shared_ptr<ConnectionPool>> g_conn_pools;
 static std::mutex g_pools_mutex;
 // 初始化静态成员
-std::unordered_map<uint64_t, std::shared_ptr<PendingRpcContext>> MprpcChannel::pending_requests_;
-std::mutex MprpcChannel::pending_mutex_;
+std::atomic<uint64_t> MprpcChannel::next_request_id_{1};
+PendingRequestTable MprpcChannel::pending_requests_;
+// 2ms 精度、一圈约 8s：默认 5s 的超时在一圈之内，自适应后的短超时也只差一个 tick
+TimerWheel MprpcChannel::deadline_wheel_(std::chrono::milliseconds(2), 4096);
+std::atomic<uint64_t> MprpcChannel::hedgeable_calls_{0};
+std::atomic<uint64_t> MprpcChannel::hedges_sent_{0};
+
+// 整个调用 (含网络与服务端) 的 span：由拿到完成权的一方记录，error 为 0 表示成功
+static void RecordCallSpan(const PendingRpcContext& ctx, int32_t error_code) {
+    if (ctx.call_span == 0) {
+        return;
+    }
+    SpanRecord span;
+    span.trace_id = ctx.trace_parent.trace_id;
+    span.span_id = ctx.call_span;
+    span.parent_id = ctx.trace_parent.span_id;
+    span.name = "rpc.client.call";
+    span.start_ns = TraceNanos(ctx.start_time);
+    span.end_ns = TraceNowNanos();
+    span.arg_key = "error";
+    span.arg_value = static_cast<uint64_t>(static_cast<uint32_t>(error_code));
+    Tracer::GetInstance().Record(span);
+}
+
+// ============================================================================
+// [类 PendingRequestTable] 实现
+// ============================================================================
+
+void PendingRequestTable::Insert(uint64_t request_id, std::shared_ptr<PendingRpcContext> ctx) {
+    Shard& shard = ShardFor(request_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.requests[request_id] = std::move(ctx);
+}
+
+std::shared_ptr<PendingRpcContext> PendingRequestTable::Take(uint64_t request_id) {
+    Shard& shard = ShardFor(request_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.requests.find(request_id);
+    if (it == shard.requests.end()) {
+        return nullptr;
+    }
+    std::shared_ptr<PendingRpcContext> ctx = std::move(it->second);
+    shard.requests.erase(it);
+    return ctx;
+}
+
+std::shared_ptr<PendingRpcContext> PendingRequestTable::Find(uint64_t request_id) {
+    Shard& shard = ShardFor(request_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.requests.find(request_id);
+    return it == shard.requests.end() ? nullptr : it->second;
+}
+
+void PendingRequestTable::CollectExpired(std::chrono::steady_clock::time_point now, std::vector<uint64_t>* out) {
+    // 逐个分片加锁扫描，任意时刻只持有一把分片锁
+    for (Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& kv : shard.requests) {
+            if (kv.second->deadline <= now) {
+                out->push_back(kv.first);
+            }
+        }
+    }
+}
+
+size_t PendingRequestTable::Size() {
+    size_t total = 0;
+    for (Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.requests.size();
+    }
+    return total;
+}
+
+namespace {
+
+/**
+ * @brief 把 std::function 包装成一次性的 protobuf Closure，Run 之后自删除
+ */
+class FunctionClosure : public google::protobuf::Closure {
+public:
+    explicit FunctionClosure(std::function<void()> fn) : fn_(std::move(fn)) {}
+
+    void Run() override {
+        std::function<void()> fn = std::move(fn_);
+        delete this;
+        if (fn) fn();
+    }
+
+private:
+    std::function<void()> fn_;
+};
+
+}  // namespace
 
 // 构造函数不再强制初始化单个 IP 的 Pool，而是作为 RPCClient 启动器
 // ip 和 port 参数现在可以传空，或者用于直连模式
@@ -579,15 +992,11 @@ MprpcChannel::MprpcChannel(const std::string& ip, uint16_t port,
         conn_pool_ = std::make_unique<ConnectionPool>(ip, port, config);
         conn_pool_->Init();
         
-        // 这里使用简单的 Hack 方式，循环调用 GetConnection 来覆盖所有连接。
-        // 给每个连接注册同一个回调函数：MprpcChannel::OnResponseReceived
-        for(int i = 0; i < config.connection_pool_size * 2; ++i) { 
-            auto conn = conn_pool_->GetConnection();
-            // 启动接受线程
-            conn->StartReceiveThread([this](uint64_t req_id, int32_t err, const std::string& msg, const std::string& data) {
-                this->OnResponseReceived(req_id, err, msg, data);
-            });
-        }
+        // 给池中每个连接 (包括之后扩容出的) 注册同一个回调函数：MprpcChannel::OnResponseReceived
+        // 在共享 reactor 上开始接收
+        conn_pool_->StartReceiving([this](uint64_t req_id, int32_t err, const std::string& msg, const std::string& data) {
+            this->OnResponseReceived(req_id, err, msg, data);
+        });
     }
 
     // 3. 启动超时检查后台线程
@@ -636,7 +1045,7 @@ void MprpcChannel::Shutdown() {
     // 2. 停止所有连接池的线程
     // 注意：g_conn_pools 是全局的，通常由程序退出时统一清理。
     // 但如果是直连模式的 conn_pool_ (unique_ptr)，它会随着 MprpcChannel 析构自动释放
-    // ConnectionPool 的析构函数里已经调用了 StopReceiveThread。
+    // ConnectionPool 的析构函数里已经调用了 StopReceiving。
     // 所以这里主要处理属于自己的线程资源。
     
     if (conn_pool_) {
@@ -655,8 +1064,8 @@ void MprpcChannel::Shutdown() {
  * 2. **异步发送**：调用 `conn->SendRequest` 后不再立即调用 `ReceiveResponse`。
  * 3. **同步等待**：
  * - 原逻辑：Send -> Receive(阻塞读) -> Return
- * - 新逻辑：Send -> `cv.wait_for`(挂起等待信号) -> Return
- * - 信号由 IO 线程在 `OnResponseReceived` 中触发。
+ * - 新逻辑：Send -> 协程中 yield / 普通线程 `cv.wait_until` -> Return
+ * - 唤醒由 IO 线程在 `OnResponseReceived` 中触发。
  * 4. **异步支持**：如果 `done != nullptr`，发送完直接返回，不阻塞。
  * 5. 引入 ZK 服务发现
  */
@@ -674,6 +1083,7 @@ void MprpcChannel::CallMethod(const google::protobuf::MethodDescriptor* method,
     // -------------------------------------------------------------
     std::string target_ip = ip_;
     uint16_t target_port = port_;
+    std::string hedge_target;   // 可对冲调用的第二个副本
 
     // 如果没有指定直连 IP，则通过 ZK 查询
     if (target_ip.empty()) {
@@ -705,32 +1115,24 @@ void MprpcChannel::CallMethod(const google::protobuf::MethodDescriptor* method,
         int idx = load_balance_idx.fetch_add(1) % hosts.size();
         
         std::string host_data = hosts[idx]; // 获取选中的节点
+        if (hosts.size() > 1) {
+            hedge_target = hosts[(idx + 1) % hosts.size()];
+        }
 
         // =============================================================
 
         size_t split = host_data.find(':');
         if (split == std::string::npos) {
             controller->SetFailed("Invalid host address from ZK: " + host_data);
+            if (done) done->Run();
             return;
         }
         target_ip = host_data.substr(0, split);  // 服务实例的IP
         target_port = atoi(host_data.substr(split + 1).c_str());   // 服务实例的Port
     }
 
-    // 生成全局唯一的 Request ID
-    uint64_t request_id = GenerateRequestId();
-
-    // 创建上下文，保存到全局 Map 中
-    auto ctx = std::make_shared<PendingRpcContext>();
-    ctx->request_id = request_id;
-    ctx->response = response;
-    ctx->controller = controller;
-    ctx->done = done;
-    ctx->start_time = std::chrono::steady_clock::now();
-
-    RegisterPendingRequest(request_id, ctx);
-
     // 获取或创建对应的连接池
+    std::shared_ptr<ConnectionPool> pool;
     std::shared_ptr<RpcConnection> conn;
     // 如果是直连模式 (构造函数传了IP)，直接用成员变量 conn_pool_
     if (!ip_.empty()) {
@@ -738,8 +1140,6 @@ void MprpcChannel::CallMethod(const google::protobuf::MethodDescriptor* method,
     } else {
         // 否则使用动态全局池
         std::string host_key = target_ip + ":" + std::to_string(target_port); // 能够提供该服务的实例IP:Port
-        std::shared_ptr<ConnectionPool> pool;
-        
         {
             std::lock_guard<std::mutex> lock(g_pools_mutex);
             auto it = g_conn_pools.find(host_key);  // 全局名册 (`g_conn_pools`)是否已经有该 IP 的连接池
@@ -757,19 +1157,16 @@ void MprpcChannel::CallMethod(const google::protobuf::MethodDescriptor* method,
                 // 考虑到高并发代码的复杂性，这里我们采用【从池中取出连接，并动态绑定回调】的策略
                 // ----------------------------------------------------
                 
-                // 为了简化，这里我们暂时只对新池做初始化，回调绑定在 GetConnection 后做
+                // 回调绑定在连接池上：现有连接与之后扩容出的连接都交给静态回调，按 request_id 找 Context
+                pool->StartReceiving([](uint64_t req_id, int32_t err, const std::string& msg, const std::string& data) {
+                    MprpcChannel::OnResponseReceived(req_id, err, msg, data); // 绑定到静态回调函数，以便找到对应的 Channel 实例
+                });
                 g_conn_pools[host_key] = pool;
             } else {
                 pool = it->second;
             }
         }
         conn = pool->GetConnection();   // 从全局池中借出一个连接
-        
-        // 这是一个轻量级操作，因为 StartReceiveThread 内部只是赋值 callback
-        // 选中的TCP连接开启接受线程
-        conn->StartReceiveThread([](uint64_t req_id, int32_t err, const std::string& msg, const std::string& data) {
-            MprpcChannel::OnResponseReceived(req_id, err, msg, data); // 绑定到静态回调函数，以便找到对应的 Channel 实例
-        });
     }
 
     if (!conn || !conn->IsConnected()) {
@@ -779,48 +1176,163 @@ void MprpcChannel::CallMethod(const google::protobuf::MethodDescriptor* method,
         }
         if (!conn || !conn->IsConnected()) {
             controller->SetFailed("No connection available");
-            // 失败时必须移除 Pending 记录
-            {
-                std::lock_guard<std::mutex> lock(pending_mutex_);
-                pending_requests_.erase(request_id);
-            }
             if (done) done->Run();
             return;
         }
     }
+    const std::shared_ptr<LatencyTracker>& latency = pool ? pool->Latency() : conn_pool_->Latency();
 
-    // 发送请求（非阻塞/独立锁）
+    // 生成全局唯一的 Request ID
+    uint64_t request_id = GenerateRequestId();
+
+    // 创建上下文，保存到全局在途请求表中
+    auto ctx = std::make_shared<PendingRpcContext>();
+    ctx->request_id = request_id;
+    ctx->response = response;
+    ctx->controller = controller;
+    ctx->done = done;
+    ctx->latency = latency;
+    ctx->conn = conn;
+    ctx->request_bytes = request->ByteSizeLong();
+    ctx->start_time = std::chrono::steady_clock::now();
+    ctx->deadline = ctx->start_time + TimeoutFor(controller, *latency);
+    ctx->trace_parent = Tracer::GetInstance().CurrentOrSample();
+    if (ctx->trace_parent.Sampled()) {
+        ctx->call_span = Tracer::NewId();
+    }
+
+    // 可对冲：端点已有足够的样本时，在 p95 处安排一次对冲 (晚于 deadline 则没有意义)
+    auto* mprpc_controller = dynamic_cast<MprpcController*>(controller);
+    std::chrono::steady_clock::time_point hedge_at;
+    bool hedge = false;
+    if (config_.enable_hedging && !hedge_target.empty() && mprpc_controller && mprpc_controller->IsHedgeable()) {
+        hedgeable_calls_.fetch_add(1, std::memory_order_relaxed);
+        hedge_at = ctx->start_time + std::chrono::microseconds(latency->PercentileMicros(0.95));
+        hedge = latency->Samples() >= AdaptiveTimeoutOptions().min_samples && hedge_at < ctx->deadline;
+    }
+    if (hedge) {
+        ctx->hedge_request.reset(request->New());
+        ctx->hedge_request->CopyFrom(*request);
+        ctx->service_name = service_name;
+        ctx->method_name = method_name;
+        ctx->hedge_target = std::move(hedge_target);
+        ctx->hedge_budget_percent = config_.hedge_budget_percent;
+    }
+
+    // 同步调用且运行在调度器管理的协程中：记录协程与所在线程，等待时 yield 而不是阻塞线程
+    // (线程的调度主协程不能 yield，仍然走 cv 阻塞)
+    if (done == nullptr && config_.fiber_aware_wait) {
+        monsoon::Scheduler* scheduler = monsoon::Scheduler::GetThisScheduler();
+        int thread = monsoon::Scheduler::GetThisThreadIndex();
+        if (scheduler && thread >= 0) {
+            auto fiber = monsoon::Fiber::GetThis();
+            if (fiber.get() != monsoon::Scheduler::GetMainFiber()) {
+                ctx->waiter = std::move(fiber);
+                ctx->scheduler = scheduler;
+                ctx->thread = thread;
+            }
+        }
+    }
+
+    // 必须在发送前登记，否则响应可能先于登记到达 (send_time 也在登记前写好，IO 线程 Take 之后读取)
     ctx->send_time = std::chrono::steady_clock::now();
-    if (!conn->SendRequest(request_id, service_name, method_name, request, controller)) {
-        // 发送失败回滚
-        {
-            std::lock_guard<std::mutex> lock(pending_mutex_);
-            pending_requests_.erase(request_id);
+    conn->OnRequestStart(ctx->request_bytes);
+    RegisterPendingRequest(request_id, ctx);
+    deadline_wheel_.Schedule(request_id, kTimeoutTimer, ctx->deadline);
+    if (hedge) {
+        deadline_wheel_.Schedule(request_id, kHedgeTimer, hedge_at);
+    }
+
+    // 发送请求（非阻塞/独立锁）
+    TraceContext call_trace{ctx->trace_parent.trace_id, ctx->call_span};
+    bool sent = conn->SendRequest(request_id, service_name, method_name, request, controller, call_trace);
+    if (call_trace.Sampled()) {
+        // 排队阶段：进入 CallMethod 到帧交给写合并队列 (选路、建连、序列化、等写锁)
+        SpanRecord span;
+        span.trace_id = call_trace.trace_id;
+        span.span_id = Tracer::NewId();
+        span.parent_id = call_trace.span_id;
+        span.name = "rpc.client.send";
+        span.start_ns = TraceNanos(ctx->start_time);
+        span.end_ns = TraceNowNanos();
+        Tracer::GetInstance().Record(span);
+    }
+    if (!sent) {
+        // 发送阶段失败：抢到完成权则由本线程以失败完成；
+        // 抢不到说明超时线程已经接手，同步调用必须等它完成后才能返回 (它会写 controller)
+        if (Claim(request_id)) {
+            RecordCallSpan(*ctx, -1);
+            if (!controller->Failed()) {
+                controller->SetFailed("Send request failed");
+            }
+            if (done) done->Run();
+        } else if (done == nullptr) {
+            WaitForResponse(ctx);
         }
-        if (done) done->Run();
         return;
     }
 
     // 【同步调用逻辑】
     // 如果没有传入 done 回调，说明用户希望同步等待结果
     if (done == nullptr) {
-        std::unique_lock<std::mutex> lock(ctx->mutex);
-        auto timeout = std::chrono::milliseconds(config_.rpc_timeout_ms);
-        
-        // 挂起当前线程，等待 IO 线程唤醒 (ctx->finished == true)
-        if (!ctx->cv.wait_for(lock, timeout, [&]{ return ctx->finished; })) {
-            controller->SetFailed("RPC call timeout");
-            // 超时后的清理工作主要由 TimeoutChecker 负责，这里只负责标记失败
-        }
+        WaitForResponse(ctx);
     }
     // 【异步调用逻辑】
     // 如果 done != nullptr，函数直接结束。当 IO 线程收到响应后，会主动调用 done->Run()。
 }// <--- CallMethod 函数结束，控制权返回给调用者（上层业务）
 
+void MprpcChannel::CallMethodAsync(const google::protobuf::MethodDescriptor* method,
+                                   google::protobuf::RpcController* controller,
+                                   const google::protobuf::Message* request,
+                                   google::protobuf::Message* response,
+                                   std::function<void()> callback) {
+    CallMethod(method, controller, request, response, new FunctionClosure(std::move(callback)));
+}
+
+std::future<void> MprpcChannel::CallMethodFuture(const google::protobuf::MethodDescriptor* method,
+                                                 google::protobuf::RpcController* controller,
+                                                 const google::protobuf::Message* request,
+                                                 google::protobuf::Message* response) {
+    auto promise = std::make_shared<std::promise<void>>();
+    std::future<void> future = promise->get_future();
+    CallMethodAsync(method, controller, request, response, [promise]() { promise->set_value(); });
+    return future;
+}
+
+/**
+ * @brief [MprpcChannel] 同步调用的等待逻辑
+ * @details
+ * - 协程模式：恰好 yield 一次。完成方 (IO 线程 / 超时线程) 通过 Take 保证恰好投递一次，
+ *   且投递到本协程所在的线程：本协程真正切出之前该线程不会执行它，不存在“还没挂起就被唤醒”的竞态。
+ * - 线程模式：cv 等到 deadline；超时后与 IO 线程竞争完成权，竞争失败说明响应正在填充，
+ *   必须等它写完 response / controller 才能返回，否则调用方释放它们后 IO 线程会写野指针。
+ */
+void MprpcChannel::WaitForResponse(const std::shared_ptr<PendingRpcContext>& ctx) {
+    if (ctx->waiter) {
+        monsoon::Fiber::GetThis()->yield();
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(ctx->mutex);
+    if (ctx->cv.wait_until(lock, ctx->deadline, [&] { return ctx->finished; })) {
+        return;
+    }
+    lock.unlock();
+    if (Claim(ctx->request_id)) {
+        ctx->latency->Record(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - ctx->send_time));
+        RecordCallSpan(*ctx, -1);
+        ctx->controller->SetFailed("RPC call timeout");
+        return;
+    }
+    lock.lock();
+    ctx->cv.wait(lock, [&] { return ctx->finished; });
+}
+
 /**
  * @brief [MprpcChannel] 响应回调处理
  * @details
- * 该函数由 RpcConnection 的 IO 接收线程调用。
+ * 该函数由 RpcConnection 在共享 reactor 的 IO 线程中调用。
  * 相当于原源码中的 `CompletePendingRequest`，但适配了并发逻辑。
  * * 流程：
  * 1. 查表 (PendingMap) 找到 request_id 对应的上下文。
@@ -830,17 +1342,51 @@ void MprpcChannel::CallMethod(const google::protobuf::MethodDescriptor* method,
 void MprpcChannel::OnResponseReceived(uint64_t request_id, int32_t error_code,
                                       const std::string& error_msg,
                                       const std::string& response_data) {
-    std::shared_ptr<PendingRpcContext> ctx;
-    {
-        // 加锁查找并移除，防止重复处理
-        std::lock_guard<std::mutex> lock(pending_mutex_);
-        auto it = pending_requests_.find(request_id);
-        if (it == pending_requests_.end()) {
-            return; // 找不到说明可能已经超时被移除了
+    // 查找并移除 (只锁一个分片)，保证每个请求只被完成一次
+    std::shared_ptr<PendingRpcContext> ctx = Claim(request_id);
+    if (!ctx) {
+        return; // 找不到说明可能已经超时被移除了，或对冲的另一份已经先返回
+    }
+
+    // 往返时间计入实际应答的那个端点
+    auto now = std::chrono::steady_clock::now();
+    if (request_id == ctx->request_id) {
+        ctx->latency->Record(std::chrono::duration_cast<std::chrono::microseconds>(now - ctx->send_time));
+    } else {
+        ctx->hedge_latency->Record(std::chrono::duration_cast<std::chrono::microseconds>(now - ctx->hedge_send_time));
+    }
+    CompleteRequest(ctx, error_code, error_msg, response_data);
+}
+
+std::shared_ptr<PendingRpcContext> MprpcChannel::TakeRequest(uint64_t request_id) {
+    std::shared_ptr<PendingRpcContext> ctx = pending_requests_.Take(request_id);
+    if (ctx) {
+        if (request_id == ctx->request_id) {
+            ctx->conn->OnRequestEnd(ctx->request_bytes);
+        } else {
+            ctx->hedge_conn->OnRequestEnd(ctx->request_bytes);
         }
-        ctx = it->second;
-        pending_requests_.erase(it);
     }
+    return ctx;
+}
+
+std::shared_ptr<PendingRpcContext> MprpcChannel::Claim(uint64_t request_id) {
+    std::shared_ptr<PendingRpcContext> ctx = TakeRequest(request_id);
+    if (!ctx || ctx->claimed.exchange(true)) {
+        return nullptr;
+    }
+    // 原请求与对冲请求共享上下文：任一方完成后把另一方也从表中摘掉，迟到的响应直接丢弃。
+    // 与 SendHedge 的 "先写 hedge_id、再登记、再检查 claimed" 配对，两边至少有一方会 Take 到对冲 id
+    uint64_t other = (request_id == ctx->request_id) ? ctx->hedge_id.load() : ctx->request_id;
+    if (other != 0) {
+        TakeRequest(other);
+    }
+    return ctx;
+}
+
+void MprpcChannel::CompleteRequest(const std::shared_ptr<PendingRpcContext>& ctx, int32_t error_code,
+                                   const std::string& error_msg, const std::string& response_data) {
+    RecordCallSpan(*ctx, error_code);
 
     // 填充结果
     if (error_code != 0) {
@@ -851,63 +1397,142 @@ void MprpcChannel::OnResponseReceived(uint64_t request_id, int32_t error_code,
         }
     }
 
-    // 唤醒同步等待的线程，无论CallMethod中选择同步等待还是异步回调都会执行唤醒，只不过异步回调时会空响而已
+    // 执行异步回调，转到上层业务层执行回调函数（同步调用时 done 为空，不需要回调函数）
+    if (ctx->done) {
+        ctx->done->Run();
+        return;
+    }
+
+    // 协程同步等待：把协程投递回它原来的调度线程
+    if (ctx->waiter) {
+        ctx->scheduler->schedule(std::move(ctx->waiter), ctx->thread);
+        return;
+    }
+
+    // 线程同步等待：唤醒 cv
     {
         std::lock_guard<std::mutex> lock(ctx->mutex);
         ctx->finished = true;
-        ctx->cv.notify_one();   // <--- 这一行代码向当初发起这个请求的 rpcChannel 线程发出了信号！
     }
+    ctx->cv.notify_one();   // <--- 这一行代码向当初发起这个请求的 rpcChannel 线程发出了信号！
+}
 
-    // 执行异步回调，转到上层业务层执行回调函数（同步调用时 done 为空，不需要回调函数）
-    if (ctx->done) {
-        ctx->done->Run();
+/**
+ * @brief [MprpcChannel] deadline 到期
+ * @details 超时也计入端点的延迟分布 (按已等待的时间)：对端整体变慢时 p99 随之上升，
+ * 自适应超时逐步放宽到 rpc_timeout_ms，而不会一直按旧的分布超时、永远拿不到新样本。
+ */
+void MprpcChannel::ExpireRequest(uint64_t request_id) {
+    std::shared_ptr<PendingRpcContext> ctx = Claim(request_id);
+    if (!ctx) {
+        return;  // 惰性取消：请求早已完成
     }
+    ctx->latency->Record(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - ctx->send_time));
+    CompleteRequest(ctx, -1, "RPC Timeout", "");
+}
+
+/**
+ * @brief [MprpcChannel] 对冲定时器到期：原请求还没返回，向第二个副本重发一份
+ * @details
+ * 1. 只向已有连接的副本对冲，不在检查线程里为对冲新建连接 (connect 会阻塞时间轮)；
+ * 2. 对冲请求用新的 request_id 登记到同一个上下文，谁先回来谁完成 (见 Claim)；
+ * 3. 发送失败只撤回对冲，原请求照常等待，不影响调用方的 controller；
+ * 4. 对冲总数受 hedge_budget_percent 限制：副本普遍变慢时对冲不会让集群负载翻倍。
+ */
+void MprpcChannel::SendHedge(uint64_t request_id) {
+    std::shared_ptr<PendingRpcContext> ctx = pending_requests_.Find(request_id);
+    if (!ctx || ctx->claimed.load()) {
+        return;
+    }
+    uint64_t sent = hedges_sent_.load(std::memory_order_relaxed);
+    if (sent * 100 >= hedgeable_calls_.load(std::memory_order_relaxed) * ctx->hedge_budget_percent) {
+        return;
+    }
+
+    std::shared_ptr<ConnectionPool> pool;
+    {
+        std::lock_guard<std::mutex> lock(g_pools_mutex);
+        auto it = g_conn_pools.find(ctx->hedge_target);
+        if (it != g_conn_pools.end()) {
+            pool = it->second;
+        }
+    }
+    std::shared_ptr<RpcConnection> conn = pool ? pool->GetConnection() : nullptr;
+    if (!conn || !conn->IsConnected()) {
+        return;
+    }
+
+    uint64_t hedge_id = GenerateRequestId();
+    ctx->hedge_latency = pool->Latency();
+    ctx->hedge_conn = conn;
+    ctx->hedge_send_time = std::chrono::steady_clock::now();
+    ctx->hedge_id.store(hedge_id);
+    conn->OnRequestStart(ctx->request_bytes);
+    pending_requests_.Insert(hedge_id, ctx);
+    if (ctx->claimed.load()) {
+        TakeRequest(hedge_id);  // 登记期间原请求已完成
+        return;
+    }
+    MprpcController scratch;
+    TraceContext call_trace{ctx->trace_parent.trace_id, ctx->call_span};
+    if (!conn->SendRequest(hedge_id, ctx->service_name, ctx->method_name, ctx->hedge_request.get(), &scratch,
+                           call_trace)) {
+        TakeRequest(hedge_id);
+        return;
+    }
+    hedges_sent_.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::chrono::milliseconds MprpcChannel::TimeoutFor(google::protobuf::RpcController* controller,
+                                                   const LatencyTracker& latency) const {
+    auto* mprpc_controller = dynamic_cast<MprpcController*>(controller);
+    if (mprpc_controller && mprpc_controller->GetTimeout() > 0) {
+        return std::chrono::milliseconds(mprpc_controller->GetTimeout());
+    }
+    if (!config_.adaptive_timeout) {
+        return std::chrono::milliseconds(config_.rpc_timeout_ms);
+    }
+    AdaptiveTimeoutOptions options;
+    options.default_ms = config_.rpc_timeout_ms;
+    options.min_ms = std::min(config_.min_rpc_timeout_ms, config_.rpc_timeout_ms);
+    options.max_ms = config_.rpc_timeout_ms;
+    options.multiplier = config_.timeout_p99_multiplier;
+    return latency.Timeout(options);
 }
 
 void MprpcChannel::RegisterPendingRequest(uint64_t request_id, 
                                           std::shared_ptr<PendingRpcContext> ctx) {
-    std::lock_guard<std::mutex> lock(pending_mutex_);
-    pending_requests_[request_id] = ctx;
+    pending_requests_.Insert(request_id, std::move(ctx));
 }
 
 /**
  * @brief [MprpcChannel] 超时检查循环
- * @details 后台线程，定期清理超时的请求，防止内存泄漏。
+ * @details 后台线程，按时间轮精度推进进程级的 deadline 时间轮 (多个 Channel 的检查线程同一时刻只有一个在推进)。
  */
 void MprpcChannel::TimeoutCheckerLoop() {
     while (!stop_timeout_checker_) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        std::this_thread::sleep_for(deadline_wheel_.Tick());
         CleanupTimeoutRequests();
     }
 }
 
 /**
  * @brief [MprpcChannel] 执行超时清理
- * @details 扫描 Map，找到超时的请求，模拟一次“失败的响应”来唤醒业务线程。
+ * @details 只处理这段时间内到期的定时器，代价与到期数成正比，而不是与在途请求数成正比；
+ * 已完成请求的定时器在 Claim 时取不到上下文，直接忽略。
  */
 void MprpcChannel::CleanupTimeoutRequests() {
-    auto now = std::chrono::steady_clock::now();
-    std::vector<uint64_t> timeout_ids;
-
-    {
-        std::lock_guard<std::mutex> lock(pending_mutex_);
-        for (auto it = pending_requests_.begin(); it != pending_requests_.end(); ) {
-            auto ctx = it->second;
-            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-                now - ctx->start_time).count();
-            if (duration > config_.rpc_timeout_ms) {
-                timeout_ids.push_back(it->first);
-                ++it; // 这里不直接 erase，而是记录 ID
-            } else {
-                ++it;
-            }
-        }
+    std::vector<TimerWheel::Timer> expired;
+    if (!deadline_wheel_.Advance(std::chrono::steady_clock::now(), &expired)) {
+        return;
     }
-
-    // 针对超时的 ID，调用 OnResponseReceived 模拟超时错误
-    // 这样可以复用唤醒逻辑和清理逻辑
-    for (uint64_t id : timeout_ids) {
-        OnResponseReceived(id, -1, "RPC Timeout", "");
+    for (const TimerWheel::Timer& timer : expired) {
+        if (timer.tag == kHedgeTimer) {
+            SendHedge(timer.id);
+        } else {
+            ExpireRequest(timer.id);
+        }
     }
 }
 
@@ -7,12 +7,16 @@
 #include <sys/socket.h>
 #include <unistd.h>
 #include <cstring>
-#include <sstream>
 #include <algorithm> // for std::min
+#include <atomic>
+#include <memory>
 
+#include "google/protobuf/arena.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
 #include "rpcheader.pb.h"
+#include "trace.h"
+#include "cpu_topology.h"
 
 // ===========================================================================
 // 辅助类：用于将 C++11 Lambda 转换为 google::protobuf::Closure
@@ -21,18 +25,23 @@ class RpcClosure : public google::protobuf::Closure {
 public:
     using Callback = std::function<void()>;
 
-    explicit RpcClosure(Callback cb) : cb_(cb) {}
+    explicit RpcClosure(Callback cb) : cb_(cb), ran_(std::make_shared<std::atomic<bool>>(false)) {}
 
     // 重写 Run 方法
     void Run() override {
+        ran_->store(true, std::memory_order_release);  // 开始执行即视为已回复：之后的异常不能再回一次
         if (cb_) {
             cb_();
         }
         delete this; // 关键：Run 执行完后，必须自杀 (delete this)，这是 Protobuf Closure 的规矩
     }
 
+    // Run 之后闭包已经释放：需要事后判断 "是否执行过" 的调用方先取走这个标记
+    std::shared_ptr<std::atomic<bool>> RanFlag() const { return ran_; }
+
 private:
     Callback cb_;
+    std::shared_ptr<std::atomic<bool>> ran_;
 };
 
 // ===========================================================================
@@ -92,6 +101,11 @@ RpcProvider::RpcProvider(const Config& config)
              config_.port, 
              config_.thread_num, 
              config_.max_message_size);
+
+  // 3. 指标导出：已有的原子计数在抓取时读取
+  if (config_.enable_metrics) {
+    RegisterMetrics();
+  }
 }
 
 RpcProvider::~RpcProvider() {
@@ -100,6 +114,31 @@ RpcProvider::~RpcProvider() {
     MprpcApplication::GetInstance().UnregisterShutdownHook(shutdown_hook_id_);
   }
   Shutdown(); // 析构时确保资源释放
+  // 回调读取的是 metrics_，必须在析构前注销
+  for (int id : metric_callbacks_) {
+    MetricsRegistry::GetInstance().RemoveCallback(id);
+  }
+}
+
+void RpcProvider::RegisterMetrics() {
+  MetricsRegistry& registry = MetricsRegistry::GetInstance();
+  MetricLabels labels = {{"port", std::to_string(config_.port)}};
+  using Type = MetricsRegistry::Type;
+  metric_callbacks_.push_back(registry.AddCallback(
+      "rpc_server_requests_total", labels, Type::kCounter,
+      [this] { return static_cast<double>(metrics_.total_requests.load()); }, "Complete request frames received"));
+  metric_callbacks_.push_back(registry.AddCallback(
+      "rpc_server_failed_requests_total", labels, Type::kCounter,
+      [this] { return static_cast<double>(metrics_.failed_requests.load()); }, "Requests answered with an error"));
+  metric_callbacks_.push_back(registry.AddCallback(
+      "rpc_server_partial_messages_total", labels, Type::kCounter,
+      [this] { return static_cast<double>(metrics_.partial_messages.load()); }, "Reads that ended in a partial frame"));
+  metric_callbacks_.push_back(registry.AddCallback(
+      "rpc_server_active_connections", labels, Type::kGauge,
+      [this] { return static_cast<double>(metrics_.active_connections.load()); }, "Open client connections"));
+  metric_callbacks_.push_back(registry.AddCallback(
+      "rpc_server_pending_requests", labels, Type::kGauge,
+      [this] { return static_cast<double>(metrics_.pending_requests.load()); }, "Requests being processed"));
 }
 
 // 校验逻辑：确保rpc服务启动时候所有来自配置文件的参数在合理范围内
@@ -121,6 +160,18 @@ bool RpcProvider::ValidateConfig() const {
     LOG_ERROR("Invalid max_message_size: {}", config_.max_message_size);
     return false;
   }
+  if (config_.worker_threads < 0 || config_.worker_threads > 256) {
+    LOG_ERROR("Invalid worker_threads: {}", config_.worker_threads);
+    return false;
+  }
+  if (config_.worker_threads > 0 && config_.worker_queue_size == 0) {
+    LOG_ERROR("Invalid worker_queue_size: {}", config_.worker_queue_size);
+    return false;
+  }
+  if (config_.max_pending_requests < 0) {
+    LOG_ERROR("Invalid max_pending_requests: {}", config_.max_pending_requests);
+    return false;
+  }
   return true;
 }
 
@@ -167,6 +218,9 @@ void RpcProvider::Shutdown() {
       LOG_INFO("All requests finished.");
   }
 
+  // 业务线程执行完队列中剩余的任务后退出
+  StopWorkers();
+
   // -----------------------------------------------------------------------
   // 第三步：断开所有连接
   // -----------------------------------------------------------------------
@@ -186,6 +240,10 @@ void RpcProvider::Shutdown() {
     event_loop_.quit();
   }
 
+  if (metrics_server_) {
+    metrics_server_->Stop();
+  }
+
   // 打印最终统计信息
   LOG_INFO("RpcProvider shutdown complete. Stats - "
            "Total: {}, Failed: {}, Partial: {}",
@@ -225,6 +283,17 @@ bool RpcProvider::NotifyService(google::protobuf::Service* service) {
     const google::protobuf::MethodDescriptor* method_desc = service_desc->method(i);
     std::string method_name = method_desc->name();
     service_info.method_map[method_name] = method_desc;
+    if (config_.enable_metrics) {
+      MetricsRegistry& registry = MetricsRegistry::GetInstance();
+      MetricLabels labels = {{"service", service_name}, {"method", method_name}};
+      RpcMethodMetrics& mm = service_info.method_metrics[method_name];
+      mm.parse = registry.GetHistogram("rpc_server_parse_microseconds", labels,
+                                       "Frame header + request argument parsing time");
+      mm.dispatch = registry.GetHistogram("rpc_server_dispatch_microseconds", labels,
+                                          "Time from parsed request to handler start (worker queue wait)");
+      mm.handler = registry.GetHistogram("rpc_server_handler_microseconds", labels,
+                                         "Time from handler start to response written");
+    }
     LOG_INFO("Registered method: {}.{},", service_name, method_name);
   }
 
@@ -268,13 +337,22 @@ void RpcProvider::Run() {
 
   // 设置 Reactor 线程数，实现高并发处理 (One Loop Per Thread)
   server_->setThreadNum(config_.thread_num);
+  // IO 线程启动时各自独占 rpc_io 组的一个核 (未开启放置时是空操作)
+  auto io_index = std::make_shared<std::atomic<int>>(0);
+  server_->setThreadInitCallback([io_index](muduo::net::EventLoop*) {
+    ThreadPlacement::GetInstance().PinCurrentThread(kPlacementRpcIo, io_index->fetch_add(1));
+  });
 
   // 启动空闲连接检查定时器：每 30 秒执行一次 CheckIdleConnections，此函数实现清理长时间不活跃的“僵尸连接”
   if (config_.idle_timeout_seconds > 0) {
     event_loop_.runEvery(30.0, [this]() { CheckIdleConnections(); });
   }
 
-  LOG_INFO("RpcProvider starting at {}:{} with {} threads", ip, config_.port, config_.thread_num);
+  LOG_INFO("RpcProvider starting at {}:{} with {} threads, {} workers",
+           ip, config_.port, config_.thread_num, config_.worker_threads);
+
+  // 业务线程必须先于端口打开启动
+  StartWorkers();
 
   // 注册到 MprpcApplication 的生命周期管理
   int hook_id = MprpcApplication::GetInstance().RegisterShutdownHook([this]() {
@@ -287,6 +365,17 @@ void RpcProvider::Run() {
   
   server_->start();   // 此时端口才真正打开，可以接收 TCP 握手
 
+  // 指标抓取端点：与 RPC 端口分开，Prometheus 直接 GET /metrics
+  if (config_.enable_metrics && config_.metrics_port > 0) {
+    metrics_server_ = std::make_unique<MetricsServer>(ip, config_.metrics_port);
+    if (metrics_server_->Start()) {
+      LOG_INFO("Metrics endpoint listening at http://{}:{}/metrics", ip, metrics_server_->Port());
+    } else {
+      LOG_ERROR("Failed to start metrics endpoint on port {}", config_.metrics_port);
+      metrics_server_.reset();
+    }
+  }
+
   //========================================================
   //连接 ZK 并注册服务
   //========================================================
@@ -368,24 +457,24 @@ void RpcProvider::OnMessage(const muduo::net::TcpConnectionPtr& conn,
   }
 
   // 2. 循环解析：处理 Buffer 中可能存在的多个包 (TCP 粘包)
-  // 如果收到半个包，循环会因 TryParseMessage 返回 false 而终止
+  // 如果收到半个包，循环会因 PeekRequest 返回 false 而终止
+  // frame 在循环间复用：RpcHeader 里 service/method 字符串的容量不必每帧重新分配
+  RequestFrame frame;
   while (true) {
-    uint32_t header_size = 0;
-    uint64_t request_id = 0;  // <--- 定义请求ID变量
-    std::string service_name, method_name, args_str;
-
-    // 尝试解析一个完整的消息
-    // 返回 true 表示成功解析了一个包，buffer 指针已后移
-    // 返回 false 表示数据不够（半包），buffer 指针未动，等待下次数据到来
-    bool parsed = TryParseMessage(buffer, header_size, 
-                                  service_name, method_name, args_str, request_id);
+    if (config_.enable_metrics) {
+      frame.parse_start = std::chrono::steady_clock::now();
+    }
+    // 偷看一个完整的消息
+    // 返回 true 表示整帧已到齐，frame.args_data 指向 buffer 内部，buffer 指针未动
+    // 返回 false 表示数据不够（半包），等待下次数据到来
+    bool parsed = PeekRequest(buffer, frame);
     
     if (!parsed) {
       // 半包：数据不够，退出循环，等待 TCP 继续传输
       metrics_.partial_messages++;
       // Debug log, 生产环境可降低级别
-      LOG_DEBUG("Partial message received, waiting for more data. "
-                "Buffer size: {}", buffer->readableBytes());
+      BLOG_DEBUG("Partial message received, waiting for more data. "
+                 "Buffer size: {}", buffer->readableBytes());
       break; 
     }
 
@@ -393,15 +482,25 @@ void RpcProvider::OnMessage(const muduo::net::TcpConnectionPtr& conn,
     metrics_.total_requests++;
 
     // 正在处理的请求计数 +1
-    metrics_.pending_requests++;
+    int pending = ++metrics_.pending_requests;
+
+    // 准入控制：积压过多时直接拒绝，既不解析也不执行，快速失败让客户端退避
+    if (config_.max_pending_requests > 0 && pending > config_.max_pending_requests) {
+      SendErrorResponse(conn, RPC_OVERLOAD, "Server overloaded", frame.header.request_id());
+      metrics_.failed_requests++;
+      buffer->retrieve(frame.frame_size);
+      continue;
+    }
     
     try {
-      HandleRpcRequest(conn, service_name, method_name, args_str, request_id);
+      // 请求参数直接从 buffer 内部反序列化，处理完之后才消费这一帧
+      HandleRpcRequest(conn, frame);
     } catch (const std::exception& e) {
       LOG_ERROR("Exception handling RPC request: {}", e.what());
-      SendErrorResponse(conn, RPC_INTERNAL_ERROR, e.what());
+      SendErrorResponse(conn, RPC_INTERNAL_ERROR, e.what(), frame.header.request_id());
       metrics_.failed_requests++;
     }
+    buffer->retrieve(frame.frame_size);
   }
 
   // 请求处理完成计数
@@ -414,17 +513,13 @@ void RpcProvider::OnMessage(const muduo::net::TcpConnectionPtr& conn,
   }
 }
 
-// 协议解析器：状态机模式（改进版：全 Peek 策略）
+// 协议解析器：状态机模式（全 Peek 策略，零拷贝）
 // 协议格式：[Varint32: header_size] + [RpcHeader] + [Args]
-bool RpcProvider::TryParseMessage(muduo::net::Buffer* buffer,
-                                  uint32_t& header_size,
-                                  std::string& service_name,
-                                  std::string& method_name,
-                                  std::string& args_str,
-                                  uint64_t& request_id) {
+bool RpcProvider::PeekRequest(muduo::net::Buffer* buffer, RequestFrame& frame) {
   // ==========================================================
   // 阶段 1: 偷看 (Peek) 头部长度
   // ==========================================================
+  uint32_t header_size = 0;
   size_t varint_size = 0;
   // 这里使用辅助函数 peek，不移动 buffer 指针
   if (!PeekVarint32(buffer, header_size, varint_size)) {
@@ -453,26 +548,17 @@ bool RpcProvider::TryParseMessage(muduo::net::Buffer* buffer,
     return false; // Header 还没收齐，等待下次
   }
 
-  // 此时数据够了，我们手动从 Buffer 中“偷”出 Header 的数据进行解析
   // buffer->peek() 是起始位置，偏移 varint_size 就是 Header 的开始
+  // 直接在 Buffer 的内存上反序列化，不再拷贝出临时 string
   const char* header_start = buffer->peek() + varint_size;
-  
-  // 使用收到的二进制数据流拷贝构造临时的 string ，用于反序列化
-  std::string rpc_header_str(header_start, header_size);
-  
-  RPC::RpcHeader rpc_header;
-  if (!rpc_header.ParseFromString(rpc_header_str)) {
+  if (!frame.header.ParseFromArray(header_start, static_cast<int>(header_size))) {
     LOG_ERROR("Failed to parse RPC header");
     // 协议错乱，消费掉已读取的部分，抛出异常断开连接
     buffer->retrieve(total_header_len);
     throw std::runtime_error("Invalid RPC header");
   }
 
-  // ... 解析 Header ...
-  service_name = rpc_header.service_name();
-  method_name = rpc_header.method_name();
-  uint32_t args_size = rpc_header.args_size();
-  request_id = rpc_header.request_id(); // <--- 提取请求ID
+  uint32_t args_size = frame.header.args_size();
 
   // 校验 args 长度
   if (args_size > config_.max_message_size) {
@@ -487,40 +573,168 @@ bool RpcProvider::TryParseMessage(muduo::net::Buffer* buffer,
   // ==========================================================
   
   // 整个包的总长度 = 长度头(varint) + Header数据 + Args数据
-  size_t total_package_len = varint_size + header_size + args_size;
+  size_t total_package_len = total_header_len + args_size;
 
-  // 关键判断：只有当 Buffer 数据 >= 整个包长度时，才开始消费
+  // 关键判断：只有当 Buffer 数据 >= 整个包长度时，才算集齐
   if (buffer->readableBytes() < total_package_len) {
     // Args 还没收齐，等待下次。此时 Buffer 指针完全没动！
-    // 这解决了旧代码“读了Header发现Args不够，导致下次Header丢失”的Bug
     return false; 
   }
 
   // ==========================================================
-  // 阶段 4: 正式消费数据 (Retrieve)
+  // 阶段 4: 输出视图 (由调用方在处理完后 retrieve)
   // ==========================================================
-  
-  // 1. 消费掉 [长度头 + Header]
-  buffer->retrieve(varint_size + header_size);
-  
-  // 2. 消费并读取 [Args]
-  // 此时 Buffer 的 readerIndex 已经指向了 Args 的开头
-  args_str = buffer->retrieveAsString(args_size);
+  frame.header_size = header_size;
+  frame.args_data = header_start + header_size;
+  frame.args_size = args_size;
+  frame.frame_size = total_package_len;
+
+  BLOG_DEBUG("Parsed complete message: {} . {}, args size: {}",
+             frame.header.service_name(), frame.header.method_name(), args_size);
 
-  LOG_DEBUG("Parsed complete message: {} . {}, args size: {}", service_name, method_name, args_size);
+  return true;
+}
+
+// 拷贝版本：在 PeekRequest 之上把各字段复制出来并消费整帧
+bool RpcProvider::TryParseMessage(muduo::net::Buffer* buffer,
+                                  uint32_t& header_size,
+                                  std::string& service_name,
+                                  std::string& method_name,
+                                  std::string& args_str,
+                                  uint64_t& request_id) {
+  RequestFrame frame;
+  if (!PeekRequest(buffer, frame)) {
+    return false;
+  }
+
+  header_size = frame.header_size;
+  service_name = frame.header.service_name();
+  method_name = frame.header.method_name();
+  request_id = frame.header.request_id();
+  args_str.assign(frame.args_data, frame.args_size);
+
+  buffer->retrieve(frame.frame_size);
+  return true;
+}
+
+namespace {
+
+inline void RecordMicros(MetricHistogram* h, std::chrono::steady_clock::time_point from,
+                         std::chrono::steady_clock::time_point to) {
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+  h->Record(us > 0 ? static_cast<uint64_t>(us) : 0);
+}
+
+inline void RecordSpan(const char* name, const TraceContext& parent, uint64_t span_id, uint64_t start_ns,
+                       uint64_t end_ns) {
+  SpanRecord span;
+  span.trace_id = parent.trace_id;
+  span.span_id = span_id;
+  span.parent_id = parent.span_id;
+  span.name = name;
+  span.start_ns = start_ns;
+  span.end_ns = end_ns;
+  Tracer::GetInstance().Record(span);
+}
+
+// 单次调用的 Arena 初始块：小请求的 request/response 完全落在这块内存里，不再单独 new
+constexpr size_t kRpcArenaInitialBlock = 1024;
+
+/**
+ * @brief 单次 RPC 调用的上下文
+ * request / response 都分配在 arena 上，done 回调发送完响应后 delete 整个对象，
+ * 一次释放所有内存 (不再逐个析构 Message)。
+ */
+struct RpcCallState {
+  static google::protobuf::ArenaOptions MakeOptions(char* block) {
+    google::protobuf::ArenaOptions options;
+    options.initial_block = block;
+    options.initial_block_size = kRpcArenaInitialBlock;
+    return options;
+  }
+
+  RpcCallState() : arena(MakeOptions(initial_block)) {}
+
+  alignas(8) char initial_block[kRpcArenaInitialBlock];  // 必须先于 arena 构造、后于 arena 析构
+  google::protobuf::Arena arena;
+  google::protobuf::Message* request = nullptr;
+  google::protobuf::Message* response = nullptr;
+
+  // 耗时统计 (metrics 为空时不读时钟)
+  RpcMethodMetrics metrics;
+  std::chrono::steady_clock::time_point parsed_at;
+  std::chrono::steady_clock::time_point handler_start;
+
+  // 追踪 (trace 来自 RpcHeader，未采样时 trace_id 为 0)：排队 span + 处理函数 span
+  TraceContext trace;
+  uint64_t handler_span = 0;
+  uint64_t parsed_ns = 0;
+  uint64_t handler_ns = 0;
+
+  void StartHandler() {
+    if (metrics.dispatch) {
+      handler_start = std::chrono::steady_clock::now();
+      RecordMicros(metrics.dispatch, parsed_at, handler_start);
+    }
+    if (trace.Sampled()) {
+      handler_ns = TraceNowNanos();
+      RecordSpan("rpc.server.queue", trace, Tracer::NewId(), parsed_ns, handler_ns);
+    }
+  }
+
+  // 处理函数内的上下文：处理函数同步调用的下游 (提交 Raft、再发 RPC) 以 handler span 为父
+  TraceContext HandlerContext() const { return TraceContext{trace.trace_id, handler_span}; }
+
+  void FinishHandler() {
+    if (metrics.handler) {
+      RecordMicros(metrics.handler, handler_start, std::chrono::steady_clock::now());
+    }
+    if (trace.Sampled()) {
+      RecordSpan("rpc.server.handler", trace, handler_span, handler_ns, TraceNowNanos());
+    }
+  }
+};
 
+/**
+ * @brief 把一帧 [Varint: header_len] + [Header] + [Body] 直接序列化进 out 的可写区
+ * @details 先算好各段长度并一次 ensureWritableBytes，然后原地写入，成功后才 hasWritten，
+ *          失败时 out 保持原状。body 为空表示只有 Header (错误响应)。
+ */
+bool AppendResponseFrame(muduo::net::Buffer* out, RPC::RpcHeader& header,
+                         const google::protobuf::Message* body) {
+  size_t body_size = body ? body->ByteSizeLong() : 0;
+  header.set_args_size(static_cast<uint32_t>(body_size));
+  size_t header_size = header.ByteSizeLong();
+  size_t varint_size = google::protobuf::io::CodedOutputStream::VarintSize32(static_cast<uint32_t>(header_size));
+  size_t total = varint_size + header_size + body_size;
+
+  out->ensureWritableBytes(total);
+  uint8_t* p = reinterpret_cast<uint8_t*>(out->beginWrite());
+  p = google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(static_cast<uint32_t>(header_size), p);
+  if (!header.SerializeToArray(p, static_cast<int>(header_size))) {
+    return false;
+  }
+  p += header_size;
+  if (body && !body->SerializeToArray(p, static_cast<int>(body_size))) {
+    return false;
+  }
+  out->hasWritten(total);
   return true;
 }
 
+}  // namespace
+
 // 业务分发
 void RpcProvider::HandleRpcRequest(const muduo::net::TcpConnectionPtr& conn,
-                                   const std::string& service_name,
-                                   const std::string& method_name,
-                                   const std::string& args_str,
-                                   uint64_t request_id) {
+                                   const RequestFrame& frame) {
+  const std::string& service_name = frame.header.service_name();
+  const std::string& method_name = frame.header.method_name();
+  uint64_t request_id = frame.header.request_id();
+
   // 1. 查找服务和方法
   google::protobuf::Service* service = nullptr;
   const google::protobuf::MethodDescriptor* method = nullptr;
+  RpcMethodMetrics mm;
 
   {
     std::lock_guard<std::mutex> lock(service_mutex_);
@@ -528,121 +742,215 @@ void RpcProvider::HandleRpcRequest(const muduo::net::TcpConnectionPtr& conn,
     auto service_it = service_map_.find(service_name);
     if (service_it == service_map_.end()) {
       LOG_WARN("Service not found: {}", service_name);
-      SendErrorResponse(conn, RPC_SERVICE_NOT_FOUND, "Service not found: " + service_name);
+      SendErrorResponse(conn, RPC_SERVICE_NOT_FOUND, "Service not found: " + service_name, request_id);
       return;
     }
 
     auto method_it = service_it->second.method_map.find(method_name);
     if (method_it == service_it->second.method_map.end()) {
       LOG_WARN("Method not found: {} . {}", service_name, method_name);
-      SendErrorResponse(conn, RPC_METHOD_NOT_FOUND, "Method not found: " + method_name);
+      SendErrorResponse(conn, RPC_METHOD_NOT_FOUND, "Method not found: " + method_name, request_id);
       return;
     }
 
     service = service_it->second.service;
     method = method_it->second;
+    auto metrics_it = service_it->second.method_metrics.find(method_name);
+    if (metrics_it != service_it->second.method_metrics.end()) {
+      mm = metrics_it->second;
+    }
   }
 
-  // 2. 创建请求和响应对象 (Protobuf 反射)
-  std::unique_ptr<google::protobuf::Message> request(
-      service->GetRequestPrototype(method).New());
-  std::unique_ptr<google::protobuf::Message> response(
-      service->GetResponsePrototype(method).New());
+  // 2. 在调用级 Arena 上创建请求和响应对象 (Protobuf 反射)
+  std::unique_ptr<RpcCallState> call(new RpcCallState());
+  call->request = service->GetRequestPrototype(method).New(&call->arena);
+  call->response = service->GetResponsePrototype(method).New(&call->arena);
 
-  // 3. 反序列化请求参数
-  if (!request->ParseFromString(args_str)) {
+  // 3. 反序列化请求参数：直接读 Buffer 里的那段字节，不经过 string
+  if (!call->request->ParseFromArray(frame.args_data, static_cast<int>(frame.args_size))) {
     LOG_ERROR("Failed to parse request arguments");
-    SendErrorResponse(conn, RPC_INVALID_REQUEST, "Failed to parse request arguments");
+    SendErrorResponse(conn, RPC_INVALID_REQUEST, "Failed to parse request arguments", request_id);
     return;
   }
+  if (mm.parse) {
+    call->parsed_at = std::chrono::steady_clock::now();
+    call->metrics = mm;
+    RecordMicros(mm.parse, frame.parse_start, call->parsed_at);
+  }
+  if (frame.header.trace_id() != 0) {
+    call->trace = TraceContext{frame.header.trace_id(), frame.header.span_id()};
+    call->handler_span = Tracer::NewId();
+    call->parsed_ns = TraceNowNanos();
+  }
 
-  // 4. 绑定回调闭包
-  // 注意：response.get() 传给回调，response.release() 放弃所有权，防止被提前析构
-  auto response_ptr = response.get();
-  
-  //  绑定回调闭包 (Closure)
+  // 4. 绑定回调闭包 (Closure)
   // 相当于构造一个回调函数：当业务做完后，请调用 this->SendRpcResponse
-  // 利用 Lambda 捕获 this, conn, response_ptr, request_id，这样无论有多少个参数都能传进去
-  google::protobuf::Closure* done = new RpcClosure([this, conn, response_ptr, request_id]() {
-        this->SendRpcResponse(conn, response_ptr, request_id);
+  // call 的所有权交给闭包，响应发出后连同 Arena 一起释放
+  RpcCallState* call_ptr = call.release();
+  RpcClosure* done = new RpcClosure([this, conn, call_ptr, request_id]() {
+        this->SendRpcResponse(conn, call_ptr->response, request_id);
+        call_ptr->FinishHandler();
+        delete call_ptr;
     });
-  // google::protobuf::Closure* done = google::protobuf::NewCallback(
-  //     this, &RpcProvider::SendRpcResponse, conn, response_ptr, request_id);
 
   // 5. 执行业务逻辑
   // 这一步会跳转到 RaftService 的实现代码中
   // done->Run() 会在业务逻辑处理完毕后被调用
-  service->CallMethod(method, nullptr, request.get(), response_ptr, done);
-  
-  response.release(); // 所有权转移给 Closure，SendRpcResponse 负责 delete
-}
-
-// 发送响应：添加长度头
-void RpcProvider::SendRpcResponse(muduo::net::TcpConnectionPtr conn,
-                                  google::protobuf::Message* response,
-                                  uint64_t request_id) {
-  // 接管 response 所有权，确保函数结束时自动 delete，防止内存泄漏
-  std::unique_ptr<google::protobuf::Message> response_guard(response);
-
-  std::string response_str;
-  if (!response->SerializeToString(&response_str)) {
-    LOG_ERROR("Failed to serialize response");
-    SendErrorResponse(conn, RPC_INTERNAL_ERROR, "Failed to serialize response");
+  if (workers_.empty()) {
+    call_ptr->StartHandler();
+    ScopedTraceContext trace_scope(call_ptr->HandlerContext());
+    service->CallMethod(method, nullptr, call_ptr->request, call_ptr->response, done);
     return;
   }
 
+  // 业务线程模式：请求已经解析到 Arena 上，任务不再引用 IO 线程的 Buffer
+  std::shared_ptr<std::atomic<bool>> done_ran = done->RanFlag();
+  bool submitted = SubmitToWorker(conn, [this, conn, service, method, call_ptr, done, done_ran, request_id]() {
+    try {
+      call_ptr->StartHandler();
+      ScopedTraceContext trace_scope(call_ptr->HandlerContext());
+      service->CallMethod(method, nullptr, call_ptr->request, call_ptr->response, done);
+    } catch (const std::exception& e) {
+      LOG_ERROR("Exception handling RPC request: {}", e.what());
+      metrics_.failed_requests++;
+      // done 已执行：响应已经发出，call_ptr 也已随闭包释放，不能再回一次错误
+      // (约定：处理函数把 done 交给异步路径之后不应再抛异常，否则这里无法判断它将来是否会执行)
+      if (!done_ran->load(std::memory_order_acquire)) {
+        SendErrorResponse(conn, RPC_INTERNAL_ERROR, e.what(), request_id);
+        call_ptr->FinishHandler();
+        delete done;
+        delete call_ptr;
+      }
+    }
+  });
+  if (!submitted) {
+    // 队列已满：没有执行过业务逻辑，闭包直接丢弃
+    delete done;
+    delete call_ptr;
+    SendErrorResponse(conn, RPC_OVERLOAD, "Worker queue full", request_id);
+    metrics_.failed_requests++;
+  }
+}
+
+// 发送响应：Header + Body 直接写进输出 Buffer
+void RpcProvider::SendRpcResponse(const muduo::net::TcpConnectionPtr& conn,
+                                  const google::protobuf::Message* response,
+                                  uint64_t request_id) {
   // 构造 RpcHeader，设置 request_id
   RPC::RpcHeader rpc_header;
   rpc_header.set_request_id(request_id); // 客户端靠这个 ID 知道是哪个请求的响应
   rpc_header.set_error_code(0);
-  rpc_header.set_args_size(response_str.size());
-
-  std::string header_str;
-  rpc_header.SerializeToString(&header_str);
 
   // 构造带长度头的帧：[Varint: header_len] + [Header] + [Body]
   // 客户端收到后，也必须先读 varint 长度，再读 data
-  std::string frame;
-  {
-    google::protobuf::io::StringOutputStream string_output(&frame);
-    google::protobuf::io::CodedOutputStream coded_output(&string_output);
-    coded_output.WriteVarint32(header_str.size()); // 写入 header 长度
-    // CodedOutputStream 析构时会 flush 到 frame
+  muduo::net::Buffer frame;
+  if (!AppendResponseFrame(&frame, rpc_header, response)) {
+    LOG_ERROR("Failed to serialize response");
+    SendErrorResponse(conn, RPC_INTERNAL_ERROR, "Failed to serialize response", request_id);
+    return;
   }
-  frame.append(header_str); // 追加 header 部分
-  frame.append(response_str); // 追加 body 部分
 
-  conn->send(frame); // 发送的是frame
+  size_t frame_bytes = frame.readableBytes();
+  // 在 IO 线程中直接写 socket / 追加到 outputBuffer；跨线程时 muduo 会转交给 IO 线程
+  conn->send(&frame);
 
   metrics_.pending_requests--; // 响应发送完毕，正在处理的请求结束，计数 -1
-  LOG_DEBUG("Response sent: id={}, bytes={}", request_id, frame.size());
+  BLOG_DEBUG("Response sent: id={}, bytes={}", request_id, frame_bytes);
 }
 
 // 发送错误响应（用于协议错误或系统错误）
 void RpcProvider::SendErrorResponse(const muduo::net::TcpConnectionPtr& conn,
                                     int error_code,
-                                    const std::string& error_msg) {
-  std::ostringstream oss;
-  // 简单的错误协议：ERROR:code:msg
-  oss << "ERROR:" << error_code << ":" << error_msg;
-  std::string error_str = oss.str();
-  
-  // 同样需要加帧头
-  std::string frame;
-  {
-    google::protobuf::io::StringOutputStream string_output(&frame);
-    google::protobuf::io::CodedOutputStream coded_output(&string_output);
-    coded_output.WriteVarint32(error_str.size());
+                                    const std::string& error_msg,
+                                    uint64_t request_id) {
+  // 与正常响应同样的帧格式，只是 Body 为空，错误信息放在 Header 中
+  RPC::RpcHeader rpc_header;
+  rpc_header.set_request_id(request_id);
+  rpc_header.set_error_code(error_code);
+  rpc_header.set_error_msg(error_msg);
+
+  muduo::net::Buffer frame;
+  if (AppendResponseFrame(&frame, rpc_header, nullptr)) {
+    conn->send(&frame);
   }
-  frame.append(error_str);
-  
-  conn->send(frame);
 
   // 错误响应发送完毕，请求结束，计数 -1
   metrics_.pending_requests--;
   LOG_WARN("Error response: code={}, msg={}", error_code, error_msg);
 }
 
+// ===========================================================================
+// 业务线程池
+// ===========================================================================
+
+void RpcProvider::StartWorkers() {
+  if (config_.worker_threads <= 0 || !workers_.empty()) {
+    return;
+  }
+  workers_.reserve(config_.worker_threads);
+  for (int i = 0; i < config_.worker_threads; ++i) {
+    workers_.push_back(std::make_unique<DispatchWorker>());
+  }
+  // 先建好全部 worker 再起线程，SubmitToWorker 看到的 workers_ 不再变化
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    DispatchWorker* w = workers_[i].get();
+    w->thread = std::thread([this, w, i]() {
+      ThreadPlacement::GetInstance().PinCurrentThread(kPlacementRpcWorker, static_cast<int>(i));
+      WorkerLoop(w);
+    });
+  }
+}
+
+void RpcProvider::StopWorkers() {
+  for (auto& worker : workers_) {
+    {
+      std::lock_guard<std::mutex> lock(worker->mutex);
+      worker->stopping = true;
+    }
+    worker->cv.notify_all();
+  }
+  for (auto& worker : workers_) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+  // workers_ 本身保留：迟到的 OnMessage 会因 stopping 而被拒绝，不会访问已释放的 worker
+}
+
+bool RpcProvider::SubmitToWorker(const muduo::net::TcpConnectionPtr& conn, std::function<void()> task) {
+  // 同一连接固定到同一个 worker：该连接上的请求按到达顺序开始执行
+  size_t index = std::hash<std::string>()(conn->name()) % workers_.size();
+  DispatchWorker* worker = workers_[index].get();
+  {
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    if (worker->stopping || worker->tasks.size() >= config_.worker_queue_size) {
+      return false;
+    }
+    worker->tasks.push_back(std::move(task));
+  }
+  worker->cv.notify_one();
+  return true;
+}
+
+void RpcProvider::WorkerLoop(DispatchWorker* worker) {
+  std::deque<std::function<void()>> batch;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(worker->mutex);
+      worker->cv.wait(lock, [worker]() { return worker->stopping || !worker->tasks.empty(); });
+      if (worker->tasks.empty()) {
+        return;  // stopping 且队列已清空
+      }
+      // 一次取走整个队列，减少 IO 线程投递时的锁竞争
+      batch.swap(worker->tasks);
+    }
+    for (auto& task : batch) {
+      task();
+    }
+    batch.clear();
+  }
+}
+
 // 检查空闲连接
 void RpcProvider::CheckIdleConnections() {
   if (shutdown_flag_) return;
@@ -0,0 +1,84 @@
+/**
+ * @file service_cache.cpp
+ * @brief 服务发现本地缓存实现
+ */
+
+#include "service_cache.h"
+
+#include "epoch.h"
+
+ServiceDiscoveryCache::ServiceDiscoveryCache() : snapshot_(new Snapshot()) {}
+
+ServiceDiscoveryCache::~ServiceDiscoveryCache() {
+  // 析构时已没有读者
+  delete snapshot_.load(std::memory_order_acquire);
+}
+
+ServiceDiscoveryCache::Result ServiceDiscoveryCache::Lookup(const std::string& service,
+                                                            std::vector<std::string>* endpoints,
+                                                            Clock::time_point now) const {
+  EpochGuard guard;
+  const Snapshot* snapshot = snapshot_.load(std::memory_order_acquire);
+  auto it = snapshot->find(service);
+  if (it == snapshot->end()) {
+    return Result::kMiss;
+  }
+  const Entry& entry = it->second;
+  if (entry.negative) {
+    return now < entry.negative_until ? Result::kNegative : Result::kMiss;
+  }
+  *endpoints = entry.endpoints;
+  return Result::kHit;
+}
+
+void ServiceDiscoveryCache::Update(const std::string& service, std::vector<std::string> endpoints) {
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  auto* next = new Snapshot(*snapshot_.load(std::memory_order_relaxed));
+  Entry& entry = (*next)[service];
+  entry.endpoints = std::move(endpoints);
+  entry.negative = false;
+  Publish(next);
+}
+
+void ServiceDiscoveryCache::MarkMissing(const std::string& service, Clock::time_point until) {
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  const Snapshot* current = snapshot_.load(std::memory_order_relaxed);
+  auto it = current->find(service);
+  if (it != current->end() && !it->second.negative) {
+    return;
+  }
+  auto* next = new Snapshot(*current);
+  Entry& entry = (*next)[service];
+  entry.endpoints.clear();
+  entry.negative = true;
+  entry.negative_until = until;
+  Publish(next);
+}
+
+void ServiceDiscoveryCache::Erase(const std::string& service) {
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  const Snapshot* current = snapshot_.load(std::memory_order_relaxed);
+  if (current->count(service) == 0) {
+    return;
+  }
+  auto* next = new Snapshot(*current);
+  next->erase(service);
+  Publish(next);
+}
+
+std::vector<std::string> ServiceDiscoveryCache::Services() const {
+  EpochGuard guard;
+  const Snapshot* snapshot = snapshot_.load(std::memory_order_acquire);
+  std::vector<std::string> services;
+  services.reserve(snapshot->size());
+  for (const auto& kv : *snapshot) {
+    services.push_back(kv.first);
+  }
+  return services;
+}
+
+void ServiceDiscoveryCache::Publish(Snapshot* next) {
+  const Snapshot* old = snapshot_.exchange(next, std::memory_order_acq_rel);
+  // 读方可能还持有旧快照的指针，宽限期后再释放
+  EpochManager::GetInstance().retire(const_cast<Snapshot*>(old));
+}
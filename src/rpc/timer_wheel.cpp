@@ -0,0 +1,79 @@
+#include "timer_wheel.h"
+
+#include <algorithm>
+
+TimerWheel::TimerWheel(std::chrono::milliseconds tick, size_t slots, Clock::time_point origin)
+    : tick_(std::max(tick, std::chrono::milliseconds(1))), origin_(origin) {
+  size_t n = 1;
+  while (n < slots) n <<= 1;
+  mask_ = n - 1;
+  slots_.reset(new Slot[n]);
+}
+
+uint64_t TimerWheel::CeilTick(Clock::time_point when) const {
+  auto d = when - origin_;
+  if (d <= Clock::duration::zero()) return 0;
+  auto tick = std::chrono::duration_cast<Clock::duration>(tick_);
+  return static_cast<uint64_t>((d + tick - Clock::duration(1)) / tick);
+}
+
+uint64_t TimerWheel::FloorTick(Clock::time_point now) const {
+  auto d = now - origin_;
+  if (d <= Clock::duration::zero()) return 0;
+  return static_cast<uint64_t>(d / std::chrono::duration_cast<Clock::duration>(tick_));
+}
+
+void TimerWheel::Schedule(uint64_t id, uint32_t tag, Clock::time_point when) {
+  uint64_t tick = CeilTick(when);
+  while (true) {
+    tick = std::max(tick, current_tick_.load(std::memory_order_acquire) + 1);
+    Slot& slot = slots_[tick & mask_];
+    std::lock_guard<std::mutex> lock(slot.mutex);
+    // 推进线程在持有该 slot 锁时才会把 current_tick_ 推过 tick：这里看到的值没过 tick，
+    // 说明这个 slot 在 tick 这一圈还没被处理，放进去一定会被取到；否则已经错过，换到下一个 tick
+    if (current_tick_.load(std::memory_order_acquire) < tick) {
+      slot.entries.push_back(Entry{id, tag, tick});
+      size_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+}
+
+void TimerWheel::CollectSlot(uint64_t tick, uint64_t upto, std::vector<Timer>* expired) {
+  Slot& slot = slots_[tick & mask_];
+  std::lock_guard<std::mutex> lock(slot.mutex);
+  current_tick_.store(tick, std::memory_order_release);
+  size_t removed = 0;
+  for (size_t i = 0; i < slot.entries.size();) {
+    if (slot.entries[i].expire_tick <= upto) {
+      expired->push_back(Timer{slot.entries[i].id, slot.entries[i].tag});
+      slot.entries[i] = slot.entries.back();
+      slot.entries.pop_back();
+      ++removed;
+    } else {
+      ++i;  // 还没到圈数
+    }
+  }
+  size_.fetch_sub(removed, std::memory_order_relaxed);
+}
+
+bool TimerWheel::Advance(Clock::time_point now, std::vector<Timer>* expired) {
+  std::unique_lock<std::mutex> lock(advance_mutex_, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    return false;
+  }
+  uint64_t target = FloorTick(now);
+  uint64_t current = current_tick_.load(std::memory_order_relaxed);
+  if (target <= current) {
+    return true;
+  }
+  // 落后超过一圈时每个 slot 只需访问一次 (这期间晚到的定时器最多再晚一圈触发)
+  uint64_t end = std::min<uint64_t>(target, current + mask_ + 1);
+  for (uint64_t t = current + 1; t <= end; ++t) {
+    CollectSlot(t, target, expired);
+  }
+  if (end < target) {
+    current_tick_.store(target, std::memory_order_release);
+  }
+  return true;
+}
@@ -10,6 +10,7 @@
 #include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <random>
 #include <sstream>
 #include <thread>
 
@@ -33,6 +34,7 @@ ZkClient::ZkClient()
  * @details RAII思想：自动关闭连接，释放资源
  */
 ZkClient::~ZkClient() {
+  StopEventThread();
   Stop();
 }
 
@@ -121,6 +123,7 @@ bool ZkClient::Start() {
 
   if (connected) {
     LOG_INFO("[ZkClient] Connected successfully!");
+    StartEventThread();
     
     // 4. 创建rpc服务根路径（如果不存在）
     if (!config_.root_path.empty() && config_.root_path != "/") {
@@ -525,16 +528,43 @@ bool ZkClient::UnregisterService(const std::string& service_name,
  * @return 服务地址列表
  */
 std::vector<std::string> ZkClient::GetServiceList(const std::string& service_name) {
-  std::string service_path = config_.root_path + "/" + service_name;
-  
+  // 1. 本地缓存 (无锁)：命中时不访问 ZooKeeper
+  std::vector<std::string> endpoints;
+  switch (discovery_cache_.Lookup(service_name, &endpoints)) {
+    case ServiceDiscoveryCache::Result::kHit:
+      return endpoints;
+    case ServiceDiscoveryCache::Result::kNegative:
+      return {};
+    case ServiceDiscoveryCache::Result::kMiss:
+      break;
+  }
+
+  // 2. 首次查询 / 负缓存过期：同步拉取一次，同时挂上子节点 Watch
+  return RefreshService(service_name);
+}
+
+std::string ZkClient::ServicePath(const std::string& service_name) const {
   // server_path = /rpc/UserService，下面的子节点都是服务实例
+  return config_.root_path + "/" + service_name;
+}
+
+std::vector<std::string> ZkClient::RefreshService(const std::string& service_name) {
   std::vector<std::string> children;
-  if (GetChildren(service_path, children, false)) {
+  if (GetChildren(ServicePath(service_name), children, true)) {
     LOG_INFO("[ZkClient] Found {} instances for service: {}", children.size(), service_name);
+    discovery_cache_.Update(service_name, children);
     return children;
   }
 
+  // 服务节点不存在时 Watch 设置不上：负缓存一段时间，到期后由下一次查询重试
   LOG_ERROR("[ZkClient] Failed to get service list: {}", service_name);
+  discovery_cache_.MarkMissing(service_name, std::chrono::steady_clock::now() +
+                                                 std::chrono::milliseconds(config_.discovery_negative_ttl_ms));
+  // 已有正缓存时 MarkMissing 不会覆盖，继续返回旧列表
+  std::vector<std::string> cached;
+  if (discovery_cache_.Lookup(service_name, &cached) == ServiceDiscoveryCache::Result::kHit) {
+    return cached;
+  }
   return {};
 }
 
@@ -550,9 +580,13 @@ bool ZkClient::WatchService(const std::string& service_name, ZkWatchCallback cal
   // 注册 Watch 回调
   SetWatcher(service_path, callback);
   
-  // 获取子节点列表并设置 Watch = true 监听所有子节点的变化
+  // 获取子节点列表并设置 Watch = true 监听所有子节点的变化，顺便刷新发现缓存
   std::vector<std::string> children;
-  return GetChildren(service_path, children, true);
+  if (!GetChildren(service_path, children, true)) {
+    return false;
+  }
+  discovery_cache_.Update(service_name, std::move(children));
+  return true;
 }
 
 // ============================================================================
@@ -572,8 +606,12 @@ void ZkClient::SetWatcher(const std::string& path, ZkWatchCallback callback) {
  * @brief 清除 Watch 回调
  */
 void ZkClient::ClearWatcher(const std::string& path) {
-  std::lock_guard<std::mutex> lock(watchers_mutex_);
+  std::unique_lock<std::mutex> lock(watchers_mutex_);
   watchers_.erase(path);
+  // 返回后回调不会再被执行：等正在执行的同一路径回调结束 (回调自己摘除自己时不能等)
+  if (std::this_thread::get_id() != event_thread_.get_id()) {
+    watchers_cv_.wait(lock, [&]() { return !watch_running_ || running_watch_path_ != path; });
+  }
   LOG_INFO("[ZkClient] Watch cleared for path: {}", path);
 }
 
@@ -652,18 +690,128 @@ void ZkClient::OnWatcherEvent(int type, int state, const std::string& path) {
     }
   }
 
-  // 2. 触发用户注册的 Watch 回调
+  // 2. 其余工作 (刷新发现缓存、用户回调) 交给事件线程：
+  //    在 ZooKeeper 的事件线程里做同步 ZooKeeper 调用会死锁，执行慢的回调也会拖住所有事件
   {
-    std::lock_guard<std::mutex> lock(watchers_mutex_);
-    auto it = watchers_.find(path);
-    if (it != watchers_.end()) {
-      try {
-        it->second(path, type, state);
-      } catch (const std::exception& e) {
-        LOG_ERROR("[ZkClient] Exception in Watch callback: {}", e.what());
+    std::lock_guard<std::mutex> lock(event_mutex_);
+    events_.push_back(WatchEvent{type, state, path});
+  }
+  event_cv_.notify_one();
+}
+
+// ============================================================================
+// 事件线程与服务发现缓存刷新
+// ============================================================================
+
+void ZkClient::StartEventThread() {
+  std::lock_guard<std::mutex> lock(event_mutex_);
+  if (event_thread_.joinable()) {
+    return;
+  }
+  event_stopping_ = false;
+  event_thread_ = std::thread([this]() { EventLoop(); });
+}
+
+void ZkClient::StopEventThread() {
+  {
+    std::lock_guard<std::mutex> lock(event_mutex_);
+    event_stopping_ = true;
+  }
+  event_cv_.notify_all();
+  if (event_thread_.joinable()) {
+    event_thread_.join();
+  }
+}
+
+void ZkClient::ScheduleDiscoveryResync() {
+  static thread_local std::mt19937 rng(std::random_device{}());
+  std::uniform_int_distribution<int> jitter(0, std::max(config_.discovery_resync_jitter_ms, 1) - 1);
+  auto now = std::chrono::steady_clock::now();
+  {
+    std::lock_guard<std::mutex> lock(event_mutex_);
+    for (const std::string& service : discovery_cache_.Services()) {
+      resync_due_[service] = now + std::chrono::milliseconds(jitter(rng));
+    }
+  }
+  event_cv_.notify_one();
+}
+
+void ZkClient::EventLoop() {
+  std::unique_lock<std::mutex> lock(event_mutex_);
+  while (!event_stopping_) {
+    if (events_.empty()) {
+      if (resync_due_.empty()) {
+        event_cv_.wait(lock);
+      } else {
+        auto earliest = std::min_element(resync_due_.begin(), resync_due_.end(),
+                                          [](const auto& a, const auto& b) { return a.second < b.second; });
+        event_cv_.wait_until(lock, earliest->second);
+      }
+      if (event_stopping_) {
+        break;
+      }
+    }
+
+    std::deque<WatchEvent> events;
+    events.swap(events_);
+    std::vector<std::string> due;
+    auto now = std::chrono::steady_clock::now();
+    for (auto it = resync_due_.begin(); it != resync_due_.end();) {
+      if (it->second <= now) {
+        due.push_back(it->first);
+        it = resync_due_.erase(it);
+      } else {
+        ++it;
       }
     }
+    lock.unlock();
+
+    for (const WatchEvent& event : events) {
+      DispatchEvent(event);
+    }
+    // 重连后的重新拉取：每个服务在各自的抖动时间点到期
+    for (const std::string& service : due) {
+      RefreshService(service);
+    }
+
+    lock.lock();
+  }
+}
+
+void ZkClient::DispatchEvent(const WatchEvent& event) {
+  // 1. 子节点变化 / 服务节点增删：先刷新发现缓存 (同时重新挂上一次性的 Watch)
+  const std::string prefix = config_.root_path + "/";
+  if (event.type != ZOO_SESSION_EVENT && event.path.compare(0, prefix.size(), prefix) == 0) {
+    std::string service = event.path.substr(prefix.size());
+    std::vector<std::string> unused;
+    if (service.find('/') == std::string::npos &&
+        discovery_cache_.Lookup(service, &unused) != ServiceDiscoveryCache::Result::kMiss) {
+      RefreshService(service);
+    }
+  }
+
+  // 2. 用户回调：复制出来后在锁外执行，回调里可以再 SetWatcher / ClearWatcher
+  ZkWatchCallback callback;
+  {
+    std::lock_guard<std::mutex> lock(watchers_mutex_);
+    auto it = watchers_.find(event.path);
+    if (it == watchers_.end()) {
+      return;
+    }
+    callback = it->second;
+    running_watch_path_ = event.path;
+    watch_running_ = true;
+  }
+  try {
+    callback(event.path, event.type, event.state);
+  } catch (const std::exception& e) {
+    LOG_ERROR("[ZkClient] Exception in Watch callback: {}", e.what());
+  }
+  {
+    std::lock_guard<std::mutex> lock(watchers_mutex_);
+    watch_running_ = false;
   }
+  watchers_cv_.notify_all();
 }
 
 /**
@@ -679,6 +827,8 @@ bool ZkClient::Reconnect() {
     
     if (Start()) {
       LOG_INFO("[ZkClient] Reconnected successfully!");
+      // 新会话上旧的 Watch 全部失效，缓存的服务需要重新拉取 (抖动错开，避免同时打 ZooKeeper)
+      ScheduleDiscoveryResync();
       return true;
     }
   }
@@ -0,0 +1,118 @@
+#include "fd_manager.h"
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include "hook.h"
+
+namespace monsoon {
+
+FdCtx::FdCtx(int fd)
+    : m_isInit(false),
+      m_isSocket(false),
+      m_sysNonblock(false),
+      m_userNonblock(false),
+      m_isClosed(false),
+      m_fd(fd),
+      m_recvTimeout(-1),
+      m_sendTimeout(-1) {
+    init();
+}
+
+FdCtx::~FdCtx() {}
+
+/**
+ * @brief 初始化句柄上下文
+ * * 细节：socket 一律在内核层面设为非阻塞 (hook 负责在 EAGAIN 时挂起协程)，
+ *   用户视角的阻塞语义由 m_userNonblock 记录。
+ */
+bool FdCtx::init() {
+    if (m_isInit) {
+        return true;
+    }
+    m_recvTimeout = -1;
+    m_sendTimeout = -1;
+
+    struct stat fd_stat;
+    if (-1 == fstat(m_fd, &fd_stat)) {
+        m_isInit = false;
+        m_isSocket = false;
+    } else {
+        m_isInit = true;
+        m_isSocket = S_ISSOCK(fd_stat.st_mode);
+    }
+
+    if (m_isSocket) {
+        int flags = fcntl_f(m_fd, F_GETFL, 0);
+        if (!(flags & O_NONBLOCK)) {
+            fcntl_f(m_fd, F_SETFL, flags | O_NONBLOCK);
+        }
+        m_sysNonblock = true;
+    } else {
+        m_sysNonblock = false;
+    }
+
+    m_userNonblock = false;
+    m_isClosed = false;
+    return m_isInit;
+}
+
+void FdCtx::setTimeout(int type, uint64_t v) {
+    if (type == SO_RCVTIMEO) {
+        m_recvTimeout = v;
+    } else {
+        m_sendTimeout = v;
+    }
+}
+
+uint64_t FdCtx::getTimeout(int type) {
+    if (type == SO_RCVTIMEO) {
+        return m_recvTimeout;
+    } else {
+        return m_sendTimeout;
+    }
+}
+
+FdManager::FdManager() {}
+
+/**
+ * @brief 获取/创建文件句柄上下文
+ * * 细节：FdCtx 的构造会做 fstat / fcntl 系统调用，放在槽位锁之外；
+ *   两个线程同时创建同一个 fd 时，后装入的一方丢弃自己的对象，返回先装入的那个。
+ */
+FdCtx::ptr FdManager::get(int fd, bool auto_create) {
+    if (fd < 0) {
+        return nullptr;
+    }
+    Slot *slot = auto_create ? m_datas.getOrCreate(fd) : m_datas.get(fd);
+    if (!slot) {
+        return nullptr;
+    }
+    {
+        Spinlock::Lock lock(slot->mutex);
+        if (slot->ctx || !auto_create) {
+            return slot->ctx;
+        }
+    }
+
+    FdCtx::ptr ctx(new FdCtx(fd));
+    Spinlock::Lock lock(slot->mutex);
+    if (!slot->ctx) {
+        slot->ctx = ctx;
+    }
+    return slot->ctx;
+}
+
+void FdManager::del(int fd) {
+    Slot *slot = m_datas.get(fd);
+    if (!slot) {
+        return;
+    }
+    FdCtx::ptr old;
+    {
+        Spinlock::Lock lock(slot->mutex);
+        old.swap(slot->ctx);
+    }
+    // old 在锁外析构
+}
+
+}  // namespace monsoon
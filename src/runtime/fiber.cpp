@@ -1,11 +1,14 @@
 #include "fiber.h"
 #include <atomic>
+#include <cstdint>
 #include <cassert>
 #include <cstdlib>
 #include <exception>
 #include <iostream>
+#include <vector>
 #include <unistd.h>     // for sysconf
 #include <sys/mman.h>   // for mmap, mprotect, munmap
+#include "cpu_topology.h"
 #include "scheduler.h"  // 必须包含，用于访问 Scheduler::GetMainFiber()
 
 // 引入 Valgrind 头文件以支持内存分析
@@ -50,6 +53,7 @@ public:
      * @brief 使用 mmap 分配栈内存
      * 1. 使用 mmap 实现 Lazy Allocation (虚拟内存很大，物理内存按需分配)
      * 2. 在低地址端设置 Guard Page (保护页)
+     * 3. 开启线程放置时绑定到当前 NUMA node
      */
     static void* Alloc(size_t size) {
         // 获取系统页大小 (通常 4KB)
@@ -78,6 +82,11 @@ public:
             return nullptr;
         }
 
+        // 开启线程放置时，栈页优先落在创建它的线程所在的 node (第一次写入之前设置才有效)
+        if (ThreadPlacement::GetInstance().Enabled()) {
+            BindToLocalNode(base + page_size, size);
+        }
+
         // 返回的栈底指针需要跳过保护页
         return base + page_size;
     }
@@ -95,6 +104,297 @@ public:
     }
 };
 
+// =======================================================
+// 上下文切换 (Context Switch)
+// =======================================================
+
+#if MONSOON_FIBER_ASM_CONTEXT
+/**
+ * @brief 汇编版上下文切换 (思路同 boost.context fcontext / libco coctx_swap)
+ * monsoon_ctx_swap(from_sp, to_sp):
+ * 1. 把 callee-saved 寄存器 (以及浮点控制字) 压到当前栈上，栈指针写入 *from_sp；
+ * 2. 栈指针换成 to_sp，按相反顺序弹出寄存器，ret 到目标协程上次切出的位置。
+ * caller-saved 寄存器由编译器在调用点自行保存，信号掩码不动，整个过程不进内核。
+ * 新协程的栈由 makeContext 伪造成 "刚调用过 monsoon_ctx_swap" 的样子，ret 落到 monsoon_ctx_entry，
+ * 后者把保存在 callee-saved 寄存器里的参数和入口函数取出来调用。
+ */
+extern "C" {
+void monsoon_ctx_swap(void **from_sp, void *to_sp);
+void monsoon_ctx_entry();
+}
+
+#if defined(__x86_64__)
+// 栈布局 (低 -> 高)：mxcsr/x87cw | r12 | r13 | r14 | r15 | rbx | rbp | 返回地址
+asm(R"(
+    .text
+    .globl monsoon_ctx_swap
+    .hidden monsoon_ctx_swap
+    .type monsoon_ctx_swap, @function
+    .align 16
+monsoon_ctx_swap:
+    pushq %rbp
+    pushq %rbx
+    pushq %r15
+    pushq %r14
+    pushq %r13
+    pushq %r12
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r12
+    popq %r13
+    popq %r14
+    popq %r15
+    popq %rbx
+    popq %rbp
+    ret
+    .size monsoon_ctx_swap, .-monsoon_ctx_swap
+
+    .globl monsoon_ctx_entry
+    .hidden monsoon_ctx_entry
+    .type monsoon_ctx_entry, @function
+    .align 16
+monsoon_ctx_entry:
+    movq %r12, %rdi
+    callq *%r13
+    ud2
+    .size monsoon_ctx_entry, .-monsoon_ctx_entry
+)");
+
+static const size_t kCtxFrameSize = 8 + 6 * 8;  // 浮点控制字 + 6 个通用寄存器 (返回地址另算)
+#elif defined(__aarch64__)
+// 栈布局 (低 -> 高)：d8-d15 | x19-x28 | x29(fp) | x30(lr)，共 0xa0 字节，保持 16 字节对齐
+asm(R"(
+    .text
+    .globl monsoon_ctx_swap
+    .hidden monsoon_ctx_swap
+    .type monsoon_ctx_swap, %function
+    .align 4
+monsoon_ctx_swap:
+    sub sp, sp, #0xa0
+    stp d8, d9, [sp, #0x00]
+    stp d10, d11, [sp, #0x10]
+    stp d12, d13, [sp, #0x20]
+    stp d14, d15, [sp, #0x30]
+    stp x19, x20, [sp, #0x40]
+    stp x21, x22, [sp, #0x50]
+    stp x23, x24, [sp, #0x60]
+    stp x25, x26, [sp, #0x70]
+    stp x27, x28, [sp, #0x80]
+    stp x29, x30, [sp, #0x90]
+    mov x9, sp
+    str x9, [x0]
+    mov sp, x1
+    ldp d8, d9, [sp, #0x00]
+    ldp d10, d11, [sp, #0x10]
+    ldp d12, d13, [sp, #0x20]
+    ldp d14, d15, [sp, #0x30]
+    ldp x19, x20, [sp, #0x40]
+    ldp x21, x22, [sp, #0x50]
+    ldp x23, x24, [sp, #0x60]
+    ldp x25, x26, [sp, #0x70]
+    ldp x27, x28, [sp, #0x80]
+    ldp x29, x30, [sp, #0x90]
+    add sp, sp, #0xa0
+    ret
+    .size monsoon_ctx_swap, .-monsoon_ctx_swap
+
+    .globl monsoon_ctx_entry
+    .hidden monsoon_ctx_entry
+    .type monsoon_ctx_entry, %function
+    .align 4
+monsoon_ctx_entry:
+    mov x0, x19
+    blr x20
+    brk #0
+    .size monsoon_ctx_entry, .-monsoon_ctx_entry
+)");
+
+static const size_t kCtxFrameSize = 0xa0;
+#endif
+
+// 汇编入口的 C 侧落脚点：arg 目前未使用，MainFunc 通过 t_fiber 找到当前协程
+static void FiberEntry(void* /*arg*/) {
+    Fiber::MainFunc();
+}
+#endif
+
+void Fiber::makeContext() {
+#if MONSOON_FIBER_ASM_CONTEXT
+    // 栈从高地址向低地址增长：从栈顶 (16 字节对齐) 往下伪造一帧 monsoon_ctx_swap 的现场
+    uintptr_t top = (reinterpret_cast<uintptr_t>(stack_ptr) + stackSize_) & ~static_cast<uintptr_t>(15);
+#if defined(__x86_64__)
+    // ret 之后 rsp 需要 16 字节对齐，这样 monsoon_ctx_entry 中 call 进入 FiberEntry 时满足 ABI
+    void** frame = reinterpret_cast<void**>(top - 16 - 8 - kCtxFrameSize);
+    uint32_t* fpu = reinterpret_cast<uint32_t*>(frame);
+    fpu[0] = 0x1F80;  // MXCSR 默认值：屏蔽所有 SSE 浮点异常，就近舍入
+    fpu[1] = 0x037F;  // x87 控制字默认值
+    frame[1] = nullptr;                                          // r12: FiberEntry 的参数
+    frame[2] = reinterpret_cast<void*>(&FiberEntry);             // r13: 入口函数
+    frame[3] = frame[4] = frame[5] = frame[6] = nullptr;         // r14 r15 rbx rbp
+    frame[7] = reinterpret_cast<void*>(&monsoon_ctx_entry);      // 返回地址
+#elif defined(__aarch64__)
+    void** frame = reinterpret_cast<void**>(top - kCtxFrameSize);
+    for (size_t i = 0; i < kCtxFrameSize / sizeof(void*); ++i) {
+        frame[i] = nullptr;
+    }
+    frame[8] = nullptr;                                          // x19: FiberEntry 的参数
+    frame[9] = reinterpret_cast<void*>(&FiberEntry);             // x20: 入口函数
+    frame[19] = reinterpret_cast<void*>(&monsoon_ctx_entry);     // x30: 返回地址
+#endif
+    ctx_sp_ = frame;
+#else
+    // getcontext + makecontext 是 Linux 的“魔法组合”
+    // 它们并没有分配新内存，而是修改了现有的 ctx_ 结构体
+    // 告诉它：下次被激活时，指令指针(IP) 指向 MainFunc，栈顶指针(SP) 指向 stack_ptr
+    if (getcontext(&ctx_) == -1) {
+        assert(false && "getcontext error");
+    }
+    ctx_.uc_link = nullptr;             // 执行完后不自动跳转，由 MainFunc 手动 yield
+    ctx_.uc_stack.ss_sp = stack_ptr;    // 设置栈顶
+    ctx_.uc_stack.ss_size = stackSize_; // 设置栈大小
+    makecontext(&ctx_, &Fiber::MainFunc, 0);
+#endif
+}
+
+void Fiber::SwapContext(Fiber* from, Fiber* to) {
+#if MONSOON_FIBER_ASM_CONTEXT
+    monsoon_ctx_swap(&from->ctx_sp_, to->ctx_sp_);
+#else
+    if (swapcontext(&from->ctx_, &to->ctx_) == -1) {
+        assert(false && "swapcontext error");
+    }
+#endif
+}
+
+const char* Fiber::ContextBackend() {
+    return MONSOON_FIBER_ASM_CONTEXT ? "asm" : "ucontext";
+}
+
+// =======================================================
+// 协程池 (Fiber & Stack Pool)
+// =======================================================
+
+// 每个线程最多缓存的 Fiber / 栈个数
+static std::atomic<size_t> g_pool_capacity{64};
+
+static std::atomic<uint64_t> s_stack_hits{0};
+static std::atomic<uint64_t> s_stack_misses{0};
+static std::atomic<uint64_t> s_fiber_hits{0};
+static std::atomic<uint64_t> s_fiber_misses{0};
+
+/**
+ * @brief 线程局部的空闲链表
+ * 1. fibers: 已结束的子协程 (保留栈)，Fiber::Create 命中时 reset 复用，省掉 new + mmap + mprotect；
+ * 2. stacks: 池满或非 Create 创建的协程析构时留下的栈，下次构造 Fiber 时直接取用，省掉 munmap + mmap；
+ * 3. 只缓存默认大小的栈，自定义栈大小的协程仍走 mmap。
+ * 线程内访问无需加锁；协程在 A 线程创建、B 线程释放时进入 B 的池子，内存本身与线程无关。
+ */
+class FiberPool {
+public:
+    ~FiberPool();
+
+    std::vector<Fiber*> fibers;
+    std::vector<void*> stacks;
+};
+
+// 线程退出时池子先于其它 thread_local 析构，之后的释放直接走 munmap
+static thread_local bool t_pool_destroyed = false;
+
+static FiberPool* LocalPool() {
+    if (t_pool_destroyed) {
+        return nullptr;
+    }
+    static thread_local FiberPool pool;
+    return &pool;
+}
+
+static void* AcquireStack(size_t size) {
+    FiberPool* pool = LocalPool();
+    if (pool && size == g_fiber_stack_size && !pool->stacks.empty()) {
+        void* stack = pool->stacks.back();
+        pool->stacks.pop_back();
+        s_stack_hits.fetch_add(1, std::memory_order_relaxed);
+        return stack;
+    }
+    s_stack_misses.fetch_add(1, std::memory_order_relaxed);
+    return StackAllocator::Alloc(size);
+}
+
+static void ReleaseStack(void* stack, size_t size) {
+    FiberPool* pool = LocalPool();
+    if (pool && size == g_fiber_stack_size &&
+        pool->stacks.size() < g_pool_capacity.load(std::memory_order_relaxed)) {
+        pool->stacks.push_back(stack);
+        return;
+    }
+    StackAllocator::Dealloc(stack, size);
+}
+
+FiberPool::~FiberPool() {
+    t_pool_destroyed = true;
+    for (Fiber* f : fibers) {
+        ++s_fiber_count; // 入池时已从协程总数中扣除，~Fiber 会再减一次
+        delete f;
+    }
+    for (void* stack : stacks) {
+        StackAllocator::Dealloc(stack, g_fiber_stack_size);
+    }
+}
+
+Fiber::ptr Fiber::Create(std::function<void()> cb, size_t stacksize, bool run_in_scheduler) {
+    size_t size = stacksize > 0 ? stacksize : g_fiber_stack_size;
+    FiberPool* pool = LocalPool();
+    if (pool && size == g_fiber_stack_size && !pool->fibers.empty()) {
+        Fiber* f = pool->fibers.back();
+        pool->fibers.pop_back();
+        s_fiber_hits.fetch_add(1, std::memory_order_relaxed);
+
+        ++s_fiber_count;
+        f->id_ = s_fiber_id++;
+        f->isRunInScheduler_ = run_in_scheduler;
+        f->reset(std::move(cb));
+        return Fiber::ptr(f, &Fiber::Recycle);
+    }
+    s_fiber_misses.fetch_add(1, std::memory_order_relaxed);
+    return Fiber::ptr(new Fiber(std::move(cb), size, run_in_scheduler), &Fiber::Recycle);
+}
+
+void Fiber::Recycle(Fiber* f) {
+    FiberPool* pool = LocalPool();
+    // 只回收没在运行的子协程：RUNNING 说明还在某个上下文里执行，交给析构断言报错
+    if (pool && f->stack_ptr && f->stackSize_ == g_fiber_stack_size && f->state_ != RUNNING &&
+        pool->fibers.size() < g_pool_capacity.load(std::memory_order_relaxed)) {
+        f->cb_ = nullptr; // 尽早释放回调捕获的资源
+        --s_fiber_count;
+        pool->fibers.push_back(f);
+        return;
+    }
+    delete f;
+}
+
+void Fiber::SetPoolCapacity(size_t cap) {
+    g_pool_capacity.store(cap, std::memory_order_relaxed);
+}
+
+size_t Fiber::GetPoolCapacity() {
+    return g_pool_capacity.load(std::memory_order_relaxed);
+}
+
+Fiber::PoolStats Fiber::GetPoolStats() {
+    PoolStats stats;
+    stats.stack_hits = s_stack_hits.load(std::memory_order_relaxed);
+    stats.stack_misses = s_stack_misses.load(std::memory_order_relaxed);
+    stats.fiber_hits = s_fiber_hits.load(std::memory_order_relaxed);
+    stats.fiber_misses = s_fiber_misses.load(std::memory_order_relaxed);
+    return stats;
+}
+
 // =======================================================
 // 协程核心实现 (Fiber Implementation)
 // =======================================================
@@ -186,10 +486,12 @@ Fiber::Fiber() {
     state_ = RUNNING;
     SetThis(this);
 
-    // 获取当前上下文 (保存到 ctx_)
+#if !MONSOON_FIBER_ASM_CONTEXT
+    // 获取当前上下文 (保存到 ctx_)；汇编后端在第一次切出时才写入 ctx_sp_
     if (getcontext(&ctx_) == -1) {
         assert(false && "getcontext error");
     }
+#endif
 
     ++s_fiber_count;
     id_ = s_fiber_id++;
@@ -206,8 +508,8 @@ Fiber::Fiber(std::function<void()> cb, size_t stacksize, bool run_inscheduler)
     ++s_fiber_count;    // 子协程数量+1
     stackSize_ = stacksize > 0 ? stacksize : g_fiber_stack_size;    // 设置栈大小
     
-    // 1. 分配栈内存 (使用 mmap)
-    stack_ptr = StackAllocator::Alloc(stackSize_);
+    // 1. 分配栈内存 (优先取线程缓存，未命中再 mmap)
+    stack_ptr = AcquireStack(stackSize_);
 
     // 2. 注册到 Valgrind (Added Feature)
     // 告诉 Valgrind 这块堆内存被当作栈使用，避免未初始化内存误报
@@ -215,18 +517,8 @@ Fiber::Fiber(std::function<void()> cb, size_t stacksize, bool run_inscheduler)
     valgrind_stack_id_ = VALGRIND_STACK_REGISTER(stack_ptr, (char*)stack_ptr + stackSize_);
 #endif
 
-    // 3. 获取当前上下文作为模板
-    if (getcontext(&ctx_) == -1) {
-        assert(false && "getcontext error");
-    }
-
-    // 4. 修改上下文
-    ctx_.uc_link = nullptr;          // 执行完后不自动跳转，由 MainFunc 手动 yield
-    ctx_.uc_stack.ss_sp = stack_ptr; // 设置栈顶
-    ctx_.uc_stack.ss_size = stackSize_; // 设置栈大小
-
-    // 5. 绑定入口函数
-    makecontext(&ctx_, &Fiber::MainFunc, 0);
+    // 3. 在新栈上构造初始上下文，绑定入口函数 MainFunc
+    makeContext();
 }
 
 Fiber::~Fiber() {
@@ -243,8 +535,8 @@ Fiber::~Fiber() {
             VALGRIND_STACK_DEREGISTER(valgrind_stack_id_);
         }
 #endif
-        // 2. 释放内存
-        StackAllocator::Dealloc(stack_ptr, stackSize_);
+        // 2. 释放内存 (放回线程缓存，池满再 munmap)
+        ReleaseStack(stack_ptr, stackSize_);
     } else {
         // 主协程析构：确保当前协程就是自己 (逻辑正确性检查)
         // 主协程没有回调函数 cb_
@@ -277,14 +569,10 @@ void Fiber::resume() {
 
     if (isRunInScheduler_) {
         // [核心适配]：与调度器主协程交换
-        if (swapcontext(&(Scheduler::GetMainFiber()->ctx_), &ctx_) == -1) {
-            assert(false && "swapcontext error (scheduler->fiber)");
-        }
+        SwapContext(Scheduler::GetMainFiber(), this);
     } else {
         // [独立协程]：与线程主协程交换
-        if (swapcontext(&(t_threadFiber->ctx_), &ctx_) == -1) {
-            assert(false && "swapcontext error (thread->fiber)");
-        }
+        SwapContext(t_threadFiber.get(), this);
     }
 }
 
@@ -295,8 +583,8 @@ void Fiber::resume() {
  * 2. 独立协程：切回 线程主协程。
  */
 void Fiber::yield() {
-    // 协程必须在运行态或结束态才能 yield
-    assert(state_ == RUNNING || state_ == TERM);
+    // 协程必须在运行态或结束态 (含异常结束，MainFunc 捕获异常后也从这里切出) 才能 yield
+    assert(state_ == RUNNING || state_ == TERM || state_ == EXCEPT);
     
     if (state_ != TERM && state_ != EXCEPT) {
         state_ = READY;     // 标记：我还没写完，只是“就绪”等待下次被叫
@@ -305,15 +593,11 @@ void Fiber::yield() {
     if (isRunInScheduler_) {
         // 切回调度协程，恢复调度器的执行权
         SetThis(Scheduler::GetMainFiber()); 
-        if (swapcontext(&ctx_, &(Scheduler::GetMainFiber()->ctx_)) == -1) {
-            assert(false && "swapcontext error (fiber->scheduler)");
-        }
+        SwapContext(this, Scheduler::GetMainFiber());
     } else {
         // 切回线程主协程
         SetThis(t_threadFiber.get());
-        if (swapcontext(&ctx_, &(t_threadFiber->ctx_)) == -1) {
-            assert(false && "swapcontext error (fiber->thread)");
-        }
+        SwapContext(this, t_threadFiber.get());
     }
 }
 
@@ -327,18 +611,8 @@ void Fiber::reset(std::function<void()> cb) {
     
     cb_ = cb;   // 绑定新的任务函数
     
-    // getcontext + makecontext 是 Linux 的“魔法组合”
-    // 它们并没有分配新内存，而是修改了现有的 ctx_ 结构体
-    // 告诉它：下次被激活时，指令指针(IP) 指向 MainFunc，栈顶指针(SP) 指向 stack_ptr
-    if (getcontext(&ctx_) == -1) {
-        assert(false && "getcontext error");
-    }
-
-    ctx_.uc_link = nullptr;
-    ctx_.uc_stack.ss_sp = stack_ptr;
-    ctx_.uc_stack.ss_size = stackSize_;
-
-    makecontext(&ctx_, &Fiber::MainFunc, 0);
+    // 不分配新内存，只在原有栈上重新构造初始上下文：下次被激活时从 MainFunc 开始
+    makeContext();
     state_ = READY;
 }
 
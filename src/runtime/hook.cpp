@@ -1,5 +1,7 @@
 #include "hook.h"
 #include <dlfcn.h>
+#include <linux/io_uring.h>
+#include <algorithm>
 #include <cstdarg>
 #include <iostream>
 #include <string.h>
@@ -79,6 +81,27 @@ struct timer_info {
     int cancelled = 0;
 };
 
+/**
+ * @brief 读 / 写当前线程的 errno
+ * * 细节：协程 yield 之后可能在另一个线程上恢复，而 __errno_location 被声明为 const，编译器会在整个函数内
+ *   复用第一次取到的地址 (即挂起前那个线程的 errno)。跨 yield 的 errno 访问都经由这两个不内联的函数。
+ */
+__attribute__((noinline)) static int get_errno() { return errno; }
+__attribute__((noinline)) static void set_errno(int err) { errno = err; }
+
+/**
+ * @brief 构造 do_io 使用的 io_uring 请求 (io_uring 的长度字段是 32 位，超长的请求截断，调用方按短读写处理)
+ */
+static UringIoRequest MakeUringRequest(uint8_t opcode, int fd, const void *buf, size_t len, int flags) {
+    UringIoRequest req;
+    req.opcode = opcode;
+    req.fd = fd;
+    req.addr = buf;
+    req.len = (uint32_t)std::min<size_t>(len, UINT32_MAX);
+    req.op_flags = (uint32_t)flags;
+    return req;
+}
+
 /**
  * @brief 通用 IO 协程调度模板函数
  * @param fd 文件描述符
@@ -86,6 +109,7 @@ struct timer_info {
  * @param hook_fun_name Hook 函数名
  * @param event 关注的事件
  * @param timeout_so 超时选项类型
+ * @param uring 等价的 io_uring 操作 (可为 nullptr，表示只能走事件等待)
  * @param args 参数列表
  * @return ssize_t IO 结果
  * * 场景： 拦截 read/write 等可能阻塞的 IO 调用。
@@ -94,9 +118,12 @@ struct timer_info {
  * 2. 设置定时器（如果配置了超时）。
  * 3. 注册 IO 事件并 yield。
  * 4. 恢复后重试。
+ * 5. io_uring 后端下，如果调用方给出了等价操作，则直接把操作交给内核完成 (一次挂起，无需重试)；
+ *    内核返回 -EAGAIN (老内核对非阻塞 fd 的行为) 时退回第 3 步。
  */
 template <typename OriginFun, typename... Args>
-static ssize_t do_io(int fd, OriginFun fun, const char *hook_fun_name, uint32_t event, int timeout_so, Args &&...args) {
+static ssize_t do_io(int fd, OriginFun fun, const char *hook_fun_name, uint32_t event, int timeout_so,
+                     const UringIoRequest *uring, Args &&...args) {
     // 1. 未开启 Hook，直接调用原函数
     if (!t_hook_enable) {
         return fun(fd, std::forward<Args>(args)...);
@@ -127,12 +154,23 @@ static ssize_t do_io(int fd, OriginFun fun, const char *hook_fun_name, uint32_t
 retry:
     ssize_t n = fun(fd, std::forward<Args>(args)...);
 
-    while (n == -1 && errno == EINTR) {
+    while (n == -1 && get_errno() == EINTR) {
         n = fun(fd, std::forward<Args>(args)...);
     }
 
-    if (n == -1 && errno == EAGAIN) {
+    if (n == -1 && get_errno() == EAGAIN) {
         IOManager *iom = IOManager::GetThis();
+        if (uring && iom->backend() == IOBackend::IO_URING) {
+            ssize_t res = iom->submitIo(*uring, to);
+            if (res >= 0) {
+                return res;
+            }
+            if (res != -EAGAIN) {
+                set_errno((int)-res);
+                return -1;
+            }
+        }
+
         Timer::ptr timer;
         std::weak_ptr<timer_info> winfo(tinfo);
 
@@ -165,7 +203,7 @@ retry:
                 timer->cancel();
             }
             if (tinfo->cancelled) {
-                errno = tinfo->cancelled;
+                set_errno(tinfo->cancelled);
                 return -1;
             }
             goto retry;
@@ -298,15 +336,28 @@ int connect_with_timeout(int fd, const struct sockaddr *addr, socklen_t addrlen,
     }
     // 检查完毕，开始发起连接
 
-    int n = connect_f(fd, addr, addrlen);   // Hook connet
-    if (n == 0) {
-        return 0;
-    } else if (n != -1 || errno != EINPROGRESS) {
-        return n;
+    IOManager *iom = IOManager::GetThis();
+    // io_uring 后端：连接 (含超时) 整体交给内核完成；老内核对非阻塞 socket 返回 -EINPROGRESS 时退回事件等待
+    if (iom && iom->backend() == IOBackend::IO_URING) {
+        UringIoRequest req = MakeUringRequest(IORING_OP_CONNECT, fd, addr, 0, 0);
+        req.off = addrlen;
+        ssize_t res = iom->submitIo(req, timeout_ms);
+        if (res == 0) {
+            return 0;
+        } else if (res != -EINPROGRESS) {
+            set_errno((int)-res);
+            return -1;
+        }
+    } else {
+        int n = connect_f(fd, addr, addrlen);   // Hook connet
+        if (n == 0) {
+            return 0;
+        } else if (n != -1 || get_errno() != EINPROGRESS) {
+            return n;
+        }
     }
 
     // 操作系统正在进行非阻塞连接（正在三次握手），注册写事件和定时器
-    IOManager *iom = IOManager::GetThis();
     Timer::ptr timer;
     std::shared_ptr<timer_info> tinfo(new timer_info);
     std::weak_ptr<timer_info> winfo(tinfo);
@@ -334,7 +385,7 @@ int connect_with_timeout(int fd, const struct sockaddr *addr, socklen_t addrlen,
             timer->cancel();
         }
         if (tinfo->cancelled) {
-            errno = tinfo->cancelled;
+            set_errno(tinfo->cancelled);
             return -1;
         }
     } else {
@@ -352,7 +403,7 @@ int connect_with_timeout(int fd, const struct sockaddr *addr, socklen_t addrlen,
     if (!error) {
         return 0;
     } else {
-        errno = error;
+        set_errno(error);
         return -1;
     }
 }
@@ -374,7 +425,9 @@ int connect(int sockfd, const struct sockaddr *addr, socklen_t addrlen) {
  */
 int accept(int s, struct sockaddr *addr, socklen_t *addrlen) {
     // 【修正】使用 monsoon::READ
-    int fd = do_io(s, accept_f, "accept", monsoon::READ, SO_RCVTIMEO, addr, addrlen);
+    UringIoRequest req = MakeUringRequest(IORING_OP_ACCEPT, s, addr, 0, 0);
+    req.off = reinterpret_cast<uint64_t>(addrlen);
+    int fd = do_io(s, accept_f, "accept", monsoon::READ, SO_RCVTIMEO, &req, addr, addrlen);
     if (fd >= 0) {
         FdMgr::GetInstance()->get(fd, true);
     }
@@ -386,7 +439,8 @@ int accept(int s, struct sockaddr *addr, socklen_t *addrlen) {
  * * 场景： 读数据。
  */
 ssize_t read(int fd, void *buf, size_t count) { 
-    return do_io(fd, read_f, "read", monsoon::READ, SO_RCVTIMEO, buf, count); 
+    UringIoRequest req = MakeUringRequest(IORING_OP_RECV, fd, buf, count, 0);
+    return do_io(fd, read_f, "read", monsoon::READ, SO_RCVTIMEO, &req, buf, count);
 }
 
 /**
@@ -394,7 +448,7 @@ ssize_t read(int fd, void *buf, size_t count) {
  * * 场景： 分散读。
  */
 ssize_t readv(int fd, const struct iovec *iov, int iovcnt) {
-    return do_io(fd, readv_f, "readv", monsoon::READ, SO_RCVTIMEO, iov, iovcnt);
+    return do_io(fd, readv_f, "readv", monsoon::READ, SO_RCVTIMEO, nullptr, iov, iovcnt);
 }
 
 /**
@@ -402,7 +456,8 @@ ssize_t readv(int fd, const struct iovec *iov, int iovcnt) {
  * * 场景： 接收数据。
  */
 ssize_t recv(int sockfd, void *buf, size_t len, int flags) {
-    return do_io(sockfd, recv_f, "recv", monsoon::READ, SO_RCVTIMEO, buf, len, flags);
+    UringIoRequest req = MakeUringRequest(IORING_OP_RECV, sockfd, buf, len, flags);
+    return do_io(sockfd, recv_f, "recv", monsoon::READ, SO_RCVTIMEO, &req, buf, len, flags);
 }
 
 /**
@@ -410,7 +465,7 @@ ssize_t recv(int sockfd, void *buf, size_t len, int flags) {
  * * 场景： 接收数据并获取源地址 (UDP)。
  */
 ssize_t recvfrom(int sockfd, void *buf, size_t len, int flags, struct sockaddr *src_addr, socklen_t *addrlen) {
-    return do_io(sockfd, recvfrom_f, "recvfrom", monsoon::READ, SO_RCVTIMEO, buf, len, flags, src_addr, addrlen);
+    return do_io(sockfd, recvfrom_f, "recvfrom", monsoon::READ, SO_RCVTIMEO, nullptr, buf, len, flags, src_addr, addrlen);
 }
 
 /**
@@ -418,7 +473,7 @@ ssize_t recvfrom(int sockfd, void *buf, size_t len, int flags, struct sockaddr *
  * * 场景： 通用接收消息。
  */
 ssize_t recvmsg(int sockfd, struct msghdr *msg, int flags) {
-    return do_io(sockfd, recvmsg_f, "recvmsg", monsoon::READ, SO_RCVTIMEO, msg, flags);
+    return do_io(sockfd, recvmsg_f, "recvmsg", monsoon::READ, SO_RCVTIMEO, nullptr, msg, flags);
 }
 
 /**
@@ -426,7 +481,8 @@ ssize_t recvmsg(int sockfd, struct msghdr *msg, int flags) {
  * * 场景： 写数据。
  */
 ssize_t write(int fd, const void *buf, size_t count) {
-    return do_io(fd, write_f, "write", monsoon::WRITE, SO_SNDTIMEO, buf, count);
+    UringIoRequest req = MakeUringRequest(IORING_OP_SEND, fd, buf, count, 0);
+    return do_io(fd, write_f, "write", monsoon::WRITE, SO_SNDTIMEO, &req, buf, count);
 }
 
 /**
@@ -434,7 +490,7 @@ ssize_t write(int fd, const void *buf, size_t count) {
  * * 场景： 聚集写。
  */
 ssize_t writev(int fd, const struct iovec *iov, int iovcnt) {
-    return do_io(fd, writev_f, "writev", monsoon::WRITE, SO_SNDTIMEO, iov, iovcnt);
+    return do_io(fd, writev_f, "writev", monsoon::WRITE, SO_SNDTIMEO, nullptr, iov, iovcnt);
 }
 
 /**
@@ -442,7 +498,8 @@ ssize_t writev(int fd, const struct iovec *iov, int iovcnt) {
  * * 场景： 发送数据。
  */
 ssize_t send(int s, const void *msg, size_t len, int flags) {
-    return do_io(s, send_f, "send", monsoon::WRITE, SO_SNDTIMEO, msg, len, flags);
+    UringIoRequest req = MakeUringRequest(IORING_OP_SEND, s, msg, len, flags);
+    return do_io(s, send_f, "send", monsoon::WRITE, SO_SNDTIMEO, &req, msg, len, flags);
 }
 
 /**
@@ -450,7 +507,7 @@ ssize_t send(int s, const void *msg, size_t len, int flags) {
  * * 场景： 发送数据到指定地址 (UDP)。
  */
 ssize_t sendto(int s, const void *msg, size_t len, int flags, const struct sockaddr *to, socklen_t tolen) {
-    return do_io(s, sendto_f, "sendto", monsoon::WRITE, SO_SNDTIMEO, msg, len, flags, to, tolen);
+    return do_io(s, sendto_f, "sendto", monsoon::WRITE, SO_SNDTIMEO, nullptr, msg, len, flags, to, tolen);
 }
 
 /**
@@ -458,7 +515,7 @@ ssize_t sendto(int s, const void *msg, size_t len, int flags, const struct socka
  * * 场景： 通用发送消息。
  */
 ssize_t sendmsg(int s, const struct msghdr *msg, int flags) {
-    return do_io(s, sendmsg_f, "sendmsg", monsoon::WRITE, SO_SNDTIMEO, msg, flags);
+    return do_io(s, sendmsg_f, "sendmsg", monsoon::WRITE, SO_SNDTIMEO, nullptr, msg, flags);
 }
 
 /**
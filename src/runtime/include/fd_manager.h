@@ -2,7 +2,7 @@
 #define __FD_MANAGER_H__
 
 #include <memory>
-#include <vector>
+#include "fd_table.h"
 #include "mutex.h"
 #include "singleton.h"
 #include "thread.h"
@@ -59,10 +59,10 @@ class FdCtx : public std::enable_shared_from_this<FdCtx> {
   uint64_t m_sendTimeout;
 };
 // 文件句柄管理
+// 与 IOManager 共用 FdTable：按 fd 无锁定位槽位，每个槽位一把自旋锁保护其中的 FdCtx::ptr，
+// 因此 hook 的每次 IO 只会碰到自己 fd 的锁，不再有进程级的读写锁
 class FdManager {
  public:
-  typedef RWMutex RWMutexType;
-
   FdManager();
   // 获取/创建文件句柄类
   // auto_create 是否自动创建
@@ -71,10 +71,12 @@ class FdManager {
   void del(int fd);
 
  private:
-  /// 读写锁
-  RWMutexType m_mutex;
-  /// 文件句柄集合
-  std::vector<FdCtx::ptr> m_datas;
+  struct Slot {
+    Spinlock mutex;
+    FdCtx::ptr ctx;
+  };
+  /// 文件句柄集合 (fd 为下标)
+  FdTable<Slot> m_datas;
 };
 
 /// 文件句柄单例
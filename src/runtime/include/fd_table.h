@@ -0,0 +1,158 @@
+#ifndef __MONSOON_FD_TABLE_H__
+#define __MONSOON_FD_TABLE_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+namespace monsoon {
+
+/**
+ * @brief 以 fd 为下标、可无锁增长的分段数组
+ * * 场景：IOManager 的 FdContext 表、FdManager 的 FdCtx 表。fd 总是从小到大复用，
+ *   之前的 "vector + 全局读写锁 + 扩容" 让每次注册事件都要碰同一把锁。
+ * * 细节：
+ * 1. 第 k 段有 (kFirstSegment << k) 个槽，段大小翻倍，kMaxSegments 段即可覆盖全部非负 int fd；
+ * 2. 段一旦发布就不再移动也不释放 (直到析构)，因此返回的元素指针在表的整个生命周期内有效；
+ * 3. 查找只有一次 acquire load；新段由第一个访问者先 CAS 占位、再分配并初始化、最后发布，
+ *    同时到达的其他线程等待发布，所以每段只分配一次、init 只在最终发布的那份上运行；
+ * 4. 本类只负责 "找到槽"，槽内元素的并发访问由元素自己同步 (如 FdContext::mutex)。
+ * * 约束：T 必须可默认构造。
+ */
+template <typename T>
+class FdTable {
+ public:
+  static constexpr size_t kFirstSegmentShift = 6;  // 第 0 段 64 个槽
+  static constexpr size_t kFirstSegment = size_t(1) << kFirstSegmentShift;
+  static constexpr size_t kMaxSegments = 26;  // 64 * (2^26 - 1) > INT_MAX
+
+  FdTable() {
+    for (size_t i = 0; i < kMaxSegments; ++i) {
+      segments_[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  ~FdTable() {
+    for (size_t i = 0; i < kMaxSegments; ++i) {
+      T *base = segments_[i].load(std::memory_order_relaxed);
+      if (base != creatingMark()) {
+        delete[] base;
+      }
+    }
+  }
+
+  FdTable(const FdTable &) = delete;
+  FdTable &operator=(const FdTable &) = delete;
+
+  /**
+   * @brief 查找 fd 对应的槽，所在段尚未分配时返回 nullptr
+   */
+  T *get(int fd) const {
+    if (fd < 0) {
+      return nullptr;
+    }
+    size_t seg, off;
+    locate((size_t)fd, seg, off);
+    T *base = segments_[seg].load(std::memory_order_acquire);
+    return (base && base != creatingMark()) ? base + off : nullptr;
+  }
+
+  /**
+   * @brief 查找 fd 对应的槽，所在段不存在时分配
+   * @param init 新段中的每个元素在发布前调用一次 init(T &, int fd) (只在分配新段时调用)
+   */
+  template <typename Init>
+  T *getOrCreate(int fd, Init &&init) {
+    if (fd < 0) {
+      return nullptr;
+    }
+    size_t seg, off;
+    locate((size_t)fd, seg, off);
+    T *base = segments_[seg].load(std::memory_order_acquire);
+    if (!base || base == creatingMark()) {
+      base = createSegment(seg, init);
+    }
+    return base + off;
+  }
+
+  T *getOrCreate(int fd) {
+    return getOrCreate(fd, [](T &, int) {});
+  }
+
+  /**
+   * @brief 遍历所有已分配段中的元素，调用 f(T &, int fd)
+   * * 只应在没有并发增长时调用 (如析构、调试输出)
+   */
+  template <typename F>
+  void forEach(F &&f) {
+    for (size_t seg = 0; seg < kMaxSegments; ++seg) {
+      T *base = segments_[seg].load(std::memory_order_acquire);
+      if (!base || base == creatingMark()) {
+        continue;
+      }
+      size_t first = segmentStart(seg);
+      for (size_t i = 0; i < segmentSize(seg); ++i) {
+        f(base[i], (int)(first + i));
+      }
+    }
+  }
+
+  static size_t segmentSize(size_t seg) { return kFirstSegment << seg; }
+  // 第 seg 段第一个槽的下标：kFirstSegment * (2^seg - 1)
+  static size_t segmentStart(size_t seg) { return ((size_t(1) << seg) - 1) << kFirstSegmentShift; }
+
+  /**
+   * @brief 下标 -> (段号, 段内偏移)
+   */
+  static void locate(size_t idx, size_t &seg, size_t &off) {
+    // idx 落在第 k 段 <=> (idx / kFirstSegment + 1) 的最高位是第 k 位
+    uint64_t v = (idx >> kFirstSegmentShift) + 1;
+    seg = 63 - __builtin_clzll(v);
+    off = idx - segmentStart(seg);
+  }
+
+ private:
+  // 段已被某个线程占下、正在分配和初始化 (尚未发布)
+  static T *creatingMark() { return reinterpret_cast<T *>(uintptr_t(1)); }
+
+  template <typename Init>
+  T *createSegment(size_t seg, Init &init) {
+    T *expected = nullptr;
+    while (!segments_[seg].compare_exchange_weak(expected, creatingMark(), std::memory_order_acquire,
+                                                 std::memory_order_acquire)) {
+      if (expected && expected != creatingMark()) {
+        return expected;  // 其他线程已经发布
+      }
+      // 其他线程已占位：等它发布 (只发生在这一段第一次被并发访问时)
+      if (expected) {
+        std::this_thread::yield();
+      }
+      expected = nullptr;
+    }
+
+    size_t n = segmentSize(seg);
+    size_t first = segmentStart(seg);
+    T *fresh = nullptr;
+    try {
+      fresh = new T[n]();  // 值初始化：平凡类型 (如 std::atomic<int>) 也从零开始
+      for (size_t i = 0; i < n; ++i) {
+        init(fresh[i], (int)(first + i));
+      }
+    } catch (...) {
+      // 撤销占位，等待者会重新尝试分配
+      delete[] fresh;
+      segments_[seg].store(nullptr, std::memory_order_release);
+      throw;
+    }
+    segments_[seg].store(fresh, std::memory_order_release);
+    return fresh;
+  }
+
+ private:
+  std::atomic<T *> segments_[kMaxSegments];
+};
+
+}  // namespace monsoon
+
+#endif
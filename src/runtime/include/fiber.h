@@ -7,9 +7,29 @@
 #include <functional>
 #include <iostream>
 #include <memory>
+#include <vector>
 #include "utils.h"
 #include "thread.h" // 引用 Thread 以确保线程安全操作
 
+// 上下文切换后端 (编译期选择)：
+// x86-64 / aarch64 默认使用手写汇编，只保存 callee-saved 寄存器，不像 swapcontext 那样每次切换都
+// 走 rt_sigprocmask 系统调用；定义 MONSOON_FIBER_UCONTEXT 可强制回退到 ucontext。
+// ASan / TSan 只拦截 swapcontext，无法感知自定义切换，开启它们时自动回退
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define MONSOON_FIBER_SANITIZER 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer)
+#define MONSOON_FIBER_SANITIZER 1
+#endif
+#endif
+
+#if !defined(MONSOON_FIBER_UCONTEXT) && !defined(MONSOON_FIBER_SANITIZER) && \
+    (defined(__x86_64__) || defined(__aarch64__))
+#define MONSOON_FIBER_ASM_CONTEXT 1
+#else
+#define MONSOON_FIBER_ASM_CONTEXT 0
+#endif
+
 namespace monsoon {
 
 class Scheduler; // 前置声明
@@ -76,11 +96,42 @@ class Fiber : public std::enable_shared_from_this<Fiber> {
   
   // 协程回调函数
   static void MainFunc();
+
+  // 协程池命中统计 (所有线程累计)
+  struct PoolStats {
+    uint64_t stack_hits = 0;    // 栈从线程缓存中取得
+    uint64_t stack_misses = 0;  // 栈走 mmap + mprotect
+    uint64_t fiber_hits = 0;    // Fiber 对象从线程缓存中复用 (reset)
+    uint64_t fiber_misses = 0;  // Fiber 对象重新 new
+  };
+
+  /**
+   * @brief 从当前线程的协程池获取子协程
+   * 命中时 reset(cb) 复用已结束的 Fiber (连同它的栈)，未命中才 new 一个；
+   * 返回的智能指针引用归零时，协程被放回"当时所在线程"的池子，而不是 munmap
+   */
+  static Fiber::ptr Create(std::function<void()> cb, size_t stackSz = 0, bool run_in_scheduler = true);
+
+  // 每个线程最多缓存的 Fiber / 栈个数，0 表示关闭池化 (默认 64)
+  static void SetPoolCapacity(size_t cap);
+  static size_t GetPoolCapacity();
+  static PoolStats GetPoolStats();
   
   // 获取当前协程Id
   static uint64_t GetCurFiberID();
 
+  // 当前编译使用的上下文切换后端 ("asm" / "ucontext")
+  static const char *ContextBackend();
+
  private:
+  // Create() 返回的智能指针的删除器：能缓存则放回线程池，否则 delete
+  static void Recycle(Fiber *f);
+
+  // 在 stack_ptr 上构造初始上下文，下次切入时从 MainFunc 开始执行
+  void makeContext();
+  // 保存当前上下文到 from，切换到 to
+  static void SwapContext(Fiber *from, Fiber *to);
+
   // 协程ID
   uint64_t id_ = 0;
   // 协程栈大小
@@ -88,7 +139,11 @@ class Fiber : public std::enable_shared_from_this<Fiber> {
   // 协程状态
   State state_ = READY;
   // 协程上下文
+#if MONSOON_FIBER_ASM_CONTEXT
+  void *ctx_sp_ = nullptr;  // 切出时保存的栈指针，callee-saved 寄存器都压在这个栈上
+#else
   ucontext_t ctx_;
+#endif
   // 协程栈地址
   void *stack_ptr = nullptr;
   // 协程回调函数
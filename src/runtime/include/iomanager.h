@@ -8,11 +8,36 @@
 #include <functional>
 #include <vector>
 
+#include "fd_table.h"
 #include "scheduler.h"
 #include "timer.h"
 
+struct io_uring_sqe;
+
 namespace monsoon {
 
+class IoUring;
+
+/**
+ * @brief IO 多路复用后端 (构造 IOManager 时选择)
+ */
+enum class IOBackend {
+  EPOLL,     // epoll 就绪通知 + 非阻塞重试 (默认)
+  IO_URING,  // io_uring：就绪通知走 POLL_ADD，hook 的 socket IO 在 EAGAIN 后直接提交到环上完成
+};
+
+/**
+ * @brief 一次提交到 io_uring 的 IO 操作 (字段含义与 io_uring_sqe 相同)
+ */
+struct UringIoRequest {
+  uint8_t opcode = 0;          // IORING_OP_*
+  int fd = -1;
+  const void *addr = nullptr;  // 缓冲区 / sockaddr
+  uint32_t len = 0;
+  uint64_t off = 0;            // 文件偏移；accept: socklen_t* ; connect: addrlen (内核中与 addr2 是同一个 union)
+  uint32_t op_flags = 0;       // msg_flags / accept_flags / fsync_flags
+};
+
 /**
  * @brief IO事件类型枚举
  * * 细节：使用位掩码，支持同时注册读写事件
@@ -35,9 +60,10 @@ struct EventContext {
 
 /**
  * @brief 文件句柄上下文
- * * 细节：管理一个 FD 关注的所有事件（读/写）
+ * * 细节：管理一个 FD 关注的所有事件（读/写）；
+ *   16 字节对齐：io_uring 后端把对象地址和 4 位类型标记一起编进 user_data，段内数组元素也必须满足
  */
-class FdContext {
+class alignas(16) FdContext {
   friend class IOManager;
 
  public:
@@ -66,11 +92,16 @@ class FdContext {
   int fd = 0;             // 文件句柄
   Event events = NONE;    // 当前已注册的事件
   Mutex mutex;            // 互斥锁，保护 FdContext 的修改
+  // [io_uring 后端] 每次 addEvent 递增，编进 POLL_ADD 的 user_data，用于丢弃已注销的旧 poll 的完成事件
+  uint16_t readGen = 0;
+  uint16_t writeGen = 0;
 };
 
 /**
- * @brief 基于 Epoll 的 IO 协程调度器
+ * @brief 基于 Epoll / io_uring 的 IO 协程调度器
  * * 场景：服务器的核心 IO 调度模块，负责监听 socket 事件并唤醒协程。
+ * * 后端在构造时选择 (IOBackend)，addEvent / cancelEvent 等接口两种后端语义一致；
+ *   io_uring 初始化失败 (内核过老、被 seccomp 禁用) 时自动回退到 epoll。
  */
 class IOManager : public Scheduler, public TimerManager {
  public:
@@ -83,11 +114,20 @@ class IOManager : public Scheduler, public TimerManager {
    * @param use_caller 是否将当前的调用线程（Caller Thread）纳入调度体系
    * @param name 调度器的名称，用于日志和调试
    * @param core_offset CPU绑定偏移量，用于设置线程亲和性
+   * @param backend IO 后端
    * * 细节：
-   * 1. 初始化 Epoll 实例和 Tickle 管道。
+   * 1. 初始化 Epoll 实例和 Tickle eventfd (或 io_uring 环)。
    * 2. 启动调度器线程池。
    */
-  IOManager(size_t threads = 1, bool use_caller = true, const std::string &name = "IOManager", int core_offset = 0);
+  IOManager(size_t threads = 1, bool use_caller = true, const std::string &name = "IOManager", int core_offset = 0,
+            IOBackend backend = IOBackend::EPOLL);
+
+  /**
+   * @brief 构造函数：工作线程绑定到给定的 CPU 列表 (见 Scheduler 的同名重载)
+   * @param cpus 第 i 个工作线程绑定到 cpus[i % cpus.size()]，为空时不绑定
+   */
+  IOManager(size_t threads, bool use_caller, const std::string &name, std::vector<int> cpus,
+            IOBackend backend = IOBackend::EPOLL);
 
   /**
    * @brief 析构函数
@@ -95,6 +135,12 @@ class IOManager : public Scheduler, public TimerManager {
    */
   ~IOManager();
 
+ private:
+  // 两个构造函数的公共部分：建 epoll / io_uring 并启动调度器
+  void init(IOBackend backend);
+
+ public:
+
   /**
    * @brief 添加事件
    * @param fd 文件描述符
@@ -130,6 +176,35 @@ class IOManager : public Scheduler, public TimerManager {
    */
   bool cancelAll(int fd);
 
+  /**
+   * @brief 实际使用的 IO 后端 (io_uring 初始化失败时为 EPOLL)
+   */
+  IOBackend backend() const { return backend_; }
+
+  /**
+   * @brief [io_uring 后端] 提交一个 IO 操作并挂起当前协程，内核完成后唤醒
+   * @param req 操作描述
+   * @param timeout_ms 超时时间 (-1 不超时)，由内核 LINK_TIMEOUT 负责取消
+   * @return >= 0 内核返回值；< 0 为 -errno (超时为 -ETIMEDOUT)
+   * * 场景：hook 的 socket IO；raft 日志的 fsync 之后也可以走这里 (IORING_OP_FSYNC)。
+   * * 细节：提交被攒批：有空闲线程阻塞在环上时立即 enter，否则等下一个进入 idle 的线程一次性提交。
+   */
+  ssize_t submitIo(const UringIoRequest &req, uint64_t timeout_ms = (uint64_t)-1);
+
+  /**
+   * @brief 设置每次 epoll_wait 最多取回的就绪事件数 (默认 256，下一轮 idle 生效)
+   * * 场景：连接数多、事件密集时调大，减少 epoll_wait 次数；只有少量 fd 时调小，减少每线程内存。
+   */
+  void setMaxEvents(int max_events);
+  int getMaxEvents() const { return maxEvents_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief 设置 idle 线程无定时器时的最长阻塞时间 (毫秒，默认 5000)
+   * * 场景：该值只是兜底的自检周期，调度密集的 raft 负载可以调大，减少空转的唤醒。
+   */
+  void setMaxIdleTimeout(int timeout_ms);
+  int getMaxIdleTimeout() const { return maxIdleTimeoutMs_.load(std::memory_order_relaxed); }
+
   /**
    * @brief 获取当前的 IOManager 对象
    */
@@ -138,7 +213,7 @@ class IOManager : public Scheduler, public TimerManager {
  protected:
   /**
    * @brief 通知调度器有任务到来
-   * * 细节：写 pipe 唤醒从 epoll_wait 中阻塞的 idle 协程。
+   * * 细节：写 eventfd 唤醒阻塞在 epoll_wait 中的 idle 协程；没人阻塞或已有唤醒在途时不做系统调用。
    */
   void tickle() override;
 
@@ -166,21 +241,46 @@ class IOManager : public Scheduler, public TimerManager {
   void OnTimerInsertedAtFront() override;
 
   /**
-   * @brief 扩展 FdContext 容器大小
+   * @brief 获取 fd 对应的 FdContext，不存在则创建 (fd < 0 返回 nullptr)
    */
-  void contextResize(size_t size);
+  FdContext *getFdContext(int fd);
+
+ private:
+  void idleEpoll();
+  void idleUring();
+  bool initUring();
+  // 以下 uring* 调用方持有 uringSqMutex_
+  io_uring_sqe *uringGetSqeLocked();
+  // 发布 SQE；攒够一批、urgent 或有线程阻塞在环上时立即提交
+  void uringFlushLocked(bool urgent);
+  void uringArmPoll(FdContext *fd_ctx, Event event);
+  void uringRemovePoll(FdContext *fd_ctx, Event event);
 
  private:
+  /// 实际使用的后端
+  IOBackend backend_ = IOBackend::EPOLL;
+  /// io_uring 环 (仅 IO_URING 后端)
+  std::unique_ptr<IoUring> ring_;
+  /// 保护 SQ 的分配与发布
+  Mutex uringSqMutex_;
+  /// 保护 CQ 的消费 (多个 idle 线程共享一个环)
+  Mutex uringCqMutex_;
   /// Epoll 文件句柄
-  int epfd_ = 0;
-  /// Pipe 文件句柄 [0]读 [1]写，用于唤醒 idle
-  int tickleFds_[2];
+  int epfd_ = -1;
+  /// eventfd，用于唤醒 idle
+  int tickleFd_ = -1;
+  /// 正在 (或即将) 阻塞在 epoll_wait 中的线程数，为 0 时 tickle 直接返回
+  std::atomic<int> pollingThreads_ = {0};
+  /// eventfd 已被写入、尚未被 idle 读走，此时再 tickle 是多余的
+  std::atomic<bool> tickled_ = {false};
+  /// 每次 epoll_wait 的事件数上限
+  std::atomic<int> maxEvents_ = {256};
+  /// 无定时器时 idle 的最长阻塞时间 (毫秒)
+  std::atomic<int> maxIdleTimeoutMs_ = {5000};
   /// 正在等待执行的 IO 事件数量
   std::atomic<size_t> pendingEventCnt_ = {0};
-  /// 读写锁，保护 fdContexts_ 的扩容
-  RWMutexType mutex_;
-  /// socket 事件上下文容器
-  std::vector<FdContext *> fdContexts_;
+  /// socket 事件上下文表 (fd 为下标，无锁分段增长)
+  FdTable<FdContext> fdContexts_;
 };
 
 }  // namespace monsoon
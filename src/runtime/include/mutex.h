@@ -1,20 +1,41 @@
 #ifndef __MONSOON_MUTEX_H_
 #define __MONSOON_MUTEX_H_
 
+#include <linux/futex.h>
 #include <pthread.h>
 #include <semaphore.h>
 #include <stdint.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
 #include <atomic>
+#include <cstring>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <thread>
 #include <stdexcept>
+#include <type_traits>
 
 #include "noncopyable.h"
 #include "util.h" // 确保包含 util.h 以使用 CondPanic
 
 namespace monsoon {
 
+class Fiber;
+class Scheduler;
+
+/**
+ * @brief 忙等循环里的 CPU 提示 (x86 pause / arm yield)：降低功耗，让出超线程的执行单元
+ */
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
 /**
  * @brief 信号量封装
  * * 场景： 线程间同步，例如 Thread 类中等待线程初始化完成。
@@ -285,8 +306,16 @@ class CASLock : Nonecopyable {
   ~CASLock() {}
 
   void lock() {
-    // 自旋直到获取锁 (TAS: Test And Set)
+    // 自旋直到获取锁 (TAS: Test And Set)；失败后指数退避的 pause，转满一轮仍拿不到就让出时间片，
+    // 避免持有者被抢占时空转掉整个时间片
+    int backoff = 1;
     while (std::atomic_flag_test_and_set_explicit(&m_mutex, std::memory_order_acquire)) {
+      if (backoff <= kMaxBackoff) {
+        for (int i = 0; i < backoff; ++i) CpuRelax();
+        backoff <<= 1;
+      } else {
+        std::this_thread::yield();
+      }
     }
   }
 
@@ -295,9 +324,224 @@ class CASLock : Nonecopyable {
   }
 
  private:
+  static constexpr int kMaxBackoff = 64;
   volatile std::atomic_flag m_mutex = ATOMIC_FLAG_INIT;
 };
 
+/**
+ * @brief 自适应互斥锁：先短暂自旋，拿不到再在 futex 上挂起
+ * * 场景： 临界区很短、但偶尔会被抢占或遇到长临界区的地方，如 TimerManager。
+ *   Spinlock 在持有者被抢占时会空转，Mutex / RWMutex 每次竞争都进内核；这里两者折中。
+ * * 细节：
+ * 1. 状态 0 空闲、1 已持有、2 已持有且可能有线程挂起 (Drepper, "Futexes Are Tricky" 的 mutex 3)；
+ *    无竞争时 lock / unlock 各一次原子操作，有挂起者时 unlock 才需要 futex_wake。
+ * 2. 自旋上限按每把锁最近的成功自旋次数动态调整 (同 glibc PTHREAD_MUTEX_ADAPTIVE_NP)：
+ *    持有时间短的锁多转几圈就能拿到，持有时间长的锁很快放弃自旋。单核机器上不自旋。
+ * * 注意： 与 Mutex 一样会挂起 OS 线程，协程业务逻辑中请用 FiberMutex。
+ */
+class AdaptiveMutex : Nonecopyable {
+ public:
+  typedef ScopedLockImpl<AdaptiveMutex> Lock;
+
+  // 自旋次数上限 (每次一个 pause，约几微秒)
+  static constexpr int kMaxSpins = 100;
+
+  AdaptiveMutex() = default;
+
+  bool try_lock() {
+    int expected = 0;
+    return m_state.compare_exchange_strong(expected, 1, std::memory_order_acquire, std::memory_order_relaxed);
+  }
+
+  void lock() {
+    if (!try_lock()) {
+      lockSlow();
+    }
+  }
+
+  void unlock() {
+    if (m_state.exchange(0, std::memory_order_release) == 2) {
+      futex(FUTEX_WAKE_PRIVATE, 1);
+    }
+  }
+
+ private:
+  void lockSlow() {
+    if (Multicore()) {
+      int estimate = m_spins.load(std::memory_order_relaxed);
+      int max_spins = std::min(kMaxSpins, estimate * 2 + 10);
+      for (int spun = 1; spun <= max_spins; ++spun) {
+        CpuRelax();
+        if (m_state.load(std::memory_order_relaxed) == 0 && try_lock()) {
+          m_spins.store(estimate + (spun - estimate) / 8, std::memory_order_relaxed);
+          return;
+        }
+      }
+      m_spins.store(estimate + (max_spins - estimate) / 8, std::memory_order_relaxed);
+    }
+    // 标记为 "有挂起者" 后睡眠；醒来时可能被别的线程抢先，继续以 2 的状态竞争，保证 unlock 会唤醒后继
+    while (m_state.exchange(2, std::memory_order_acquire) != 0) {
+      futex(FUTEX_WAIT_PRIVATE, 2);
+    }
+  }
+
+  void futex(int op, int val) {
+    syscall(SYS_futex, reinterpret_cast<int *>(&m_state), op, val, nullptr, nullptr, 0);
+  }
+
+  static bool Multicore() {
+    static const bool multicore = std::thread::hardware_concurrency() > 1;
+    return multicore;
+  }
+
+  static_assert(sizeof(std::atomic<int>) == sizeof(int), "futex needs a plain 32-bit word");
+  std::atomic<int> m_state{0};
+  std::atomic<int> m_spins{0};
+};
+
+/**
+ * @brief 协程感知的互斥锁：拿不到锁的协程让出给 Scheduler，而不是挂起整个线程
+ * * 场景： 协程业务逻辑中的临界区 (Mutex 会把同线程上的其他协程一起卡住)。
+ * * 细节：
+ * 1. 无竞争时一次 CAS；竞争时调度器里的协程把自己挂到等待队列后 yield，
+ *    不在协程中的调用方 (普通线程、调度循环本身) 在信号量上等待，二者可以混用同一把锁。
+ * 2. unlock 直接把锁交给队首的等待者 (FIFO 移交)，被唤醒的协程重新进入原调度器的队列，不会饿死。
+ *    唤醒可能早于等待者 yield，调度器对仍在 RUNNING 的协程会稍后重试。
+ * 3. 持锁期间不要 yield 到调度器之外的地方，持有者可能在另一个线程上 unlock。
+ */
+class FiberMutex : Nonecopyable {
+ public:
+  typedef ScopedLockImpl<FiberMutex> Lock;
+
+  FiberMutex() = default;
+
+  bool try_lock();
+  void lock();
+  void unlock();
+
+ private:
+  struct Waiter {
+    Scheduler *scheduler = nullptr;  // 协程等待者所在的调度器
+    std::shared_ptr<Fiber> fiber;
+    Semaphore *sem = nullptr;        // 线程等待者
+  };
+
+  std::atomic<bool> m_locked{false};
+  // 保护 m_waiters；unlock 的移交与 lock 的入队都在它之下判断 m_locked，不会丢失唤醒
+  Spinlock m_waitLock;
+  std::deque<Waiter> m_waiters;
+};
+
+/**
+ * @brief 顺序锁：读多写少的小块元数据，读者不写共享内存、不阻塞写者
+ * @tparam T 可平凡复制的值类型，例如 Raft 的 {term, leader_id}
+ * * 场景： 很多线程频繁读取、偶尔整体更新的状态。RWMutex 的读锁也要写锁字，核多时在读者之间来回弹缓存行；
+ *   这里读者只读，写者把序号置为奇数 -> 写数据 -> 置为偶数，读者发现序号为奇数或前后不一致时重读。
+ * * 细节：
+ * 1. 数据按 8 字节存放在原子变量中 (relaxed 访问 + fence)，读写并发不构成数据竞争，TSan 也不会误报。
+ * 2. 写者之间通过 CAS 序号互斥，可以有多个写者；写者很频繁时读者会一直重试，此时不适合用顺序锁。
+ *
+ * @code
+ *   struct RaftMeta { uint64_t term; int32_t leader_id; };
+ *   monsoon::SeqLock<RaftMeta> meta;
+ *   meta.update([&](RaftMeta &m) { m.term = new_term; m.leader_id = -1; });
+ *   RaftMeta snapshot = meta.load();   // 两个字段来自同一次写入
+ * @endcode
+ */
+template <class T>
+class SeqLock : Nonecopyable {
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock requires a trivially copyable type");
+
+ public:
+  SeqLock() : SeqLock(T()) {}
+  explicit SeqLock(const T &value) { writeWords(value); }
+
+  // 读取一致的快照
+  T load() const {
+    T value;
+    while (!tryLoad(value)) {
+      CpuRelax();
+    }
+    return value;
+  }
+
+  // 读取一次：写者正在写或读到一半被覆盖时返回 false
+  bool tryLoad(T &value) const {
+    uint64_t before = m_seq.load(std::memory_order_acquire);
+    if (before & 1) {
+      return false;
+    }
+    uint64_t words[kWords];
+    for (size_t i = 0; i < kWords; ++i) {
+      words[i] = m_words[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (m_seq.load(std::memory_order_relaxed) != before) {
+      return false;
+    }
+    std::memcpy(&value, words, sizeof(T));
+    return true;
+  }
+
+  void store(const T &value) {
+    uint64_t seq = beginWrite();
+    writeWords(value);
+    endWrite(seq);
+  }
+
+  // 读-改-写：fn(T&) 在写者互斥下执行，不要在其中做耗时操作
+  template <class Fn>
+  void update(Fn &&fn) {
+    uint64_t seq = beginWrite();
+    T value = readWords();
+    fn(value);
+    writeWords(value);
+    endWrite(seq);
+  }
+
+  // 完成的写入次数
+  uint64_t version() const { return m_seq.load(std::memory_order_acquire) >> 1; }
+
+ private:
+  static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  // 返回写入前的 (偶数) 序号，序号置为奇数后才返回
+  uint64_t beginWrite() {
+    uint64_t seq = m_seq.load(std::memory_order_relaxed);
+    while ((seq & 1) || !m_seq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire,
+                                                      std::memory_order_relaxed)) {
+      CpuRelax();
+      seq = m_seq.load(std::memory_order_relaxed);
+    }
+    // 让数据的写入不会被重排到奇数序号之前
+    std::atomic_thread_fence(std::memory_order_release);
+    return seq;
+  }
+
+  void endWrite(uint64_t seq) { m_seq.store(seq + 2, std::memory_order_release); }
+
+  T readWords() const {
+    uint64_t words[kWords];
+    for (size_t i = 0; i < kWords; ++i) {
+      words[i] = m_words[i].load(std::memory_order_relaxed);
+    }
+    T value;
+    std::memcpy(&value, words, sizeof(T));
+    return value;
+  }
+
+  void writeWords(const T &value) {
+    uint64_t words[kWords] = {};
+    std::memcpy(words, &value, sizeof(T));
+    for (size_t i = 0; i < kWords; ++i) {
+      m_words[i].store(words[i], std::memory_order_relaxed);
+    }
+  }
+
+  std::atomic<uint64_t> m_seq{0};
+  std::atomic<uint64_t> m_words[kWords];
+};
+
 }  // namespace monsoon
 
 #endif
\ No newline at end of file
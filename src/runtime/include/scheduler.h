@@ -3,6 +3,7 @@
 
 #include <atomic>
 #include <boost/type_index.hpp>
+#include <chrono>
 #include <functional>
 #include <list>
 #include <deque>
@@ -13,9 +14,11 @@
 #include <iostream>
 
 #include "fiber.h"
+#include "metrics.h"
 #include "mutex.h"
 #include "thread.h"
 #include "utils.h"
+#include "work_steal_deque.h"
 
 namespace monsoon {
 
@@ -23,7 +26,10 @@ namespace monsoon {
  * @brief N-M 协程调度器 (Raft 优化版)
  * * 场景：作为 IOManager 的基类，管理线程池和任务队列
  * * 架构变更：
- * 从“全局队列”改为“Thread-per-Core”模型，包含线程私有队列和公共窃取队列。
+ * 从“全局队列”改为“Thread-per-Core”模型，每个线程包含：
+ * 1. 私有队列：指定到本线程的任务，仅 owner 访问；
+ * 2. 窃取队列：Chase-Lev 无锁双端队列，owner 在底部 push/pop，空闲线程在顶部 CAS 窃取；
+ * 3. 信箱：其他线程投递过来的任务，owner 每轮一次性整体取走再分拣到 1/2。
  */
 class Scheduler {
 public:
@@ -38,6 +44,13 @@ public:
      * @param core_offset CPU绑定偏移量，-1表示不绑定
      */
     Scheduler(size_t threads = 1, bool use_caller = true, const std::string &name = "Scheduler", int core_offset = -1);
+
+    /**
+     * @brief 构造函数：工作线程绑定到给定的 CPU 列表
+     * @param cpus 第 i 个工作线程绑定到 cpus[i % cpus.size()]，线程上下文分配在该核所在的 NUMA node；
+     *        为空时不绑定 (与 core_offset = -1 相同)。通常来自 ThreadPlacement::Cpus(group)
+     */
+    Scheduler(size_t threads, bool use_caller, const std::string &name, std::vector<int> cpus);
     
     virtual ~Scheduler();
     
@@ -47,6 +60,8 @@ public:
     static Scheduler *GetThisScheduler();
     // 获取当前线程的调度协程 (MainFiber)
     static Fiber *GetMainFiber();
+    // 获取当前线程在调度器中的线程下标 (即 schedule 的 thread 参数)，非调度线程返回 -1
+    static int GetThisThreadIndex();
 
     /**
      * @brief 启动调度器
@@ -102,6 +117,12 @@ protected:
     // 是否有空闲线程
     bool isHasIdleThreads() { return idleThreadCnt_ > 0; }
 
+    // [无锁] 当前线程醒来后能否拿到任务 (自己的信箱 + 任意窃取队列)，用于 idle 阻塞前的复查
+    bool hasRunnableTasks();
+
+    // [无锁] 处于 idle 的其他线程信箱里是否积压了任务 (信箱只能由 owner 收取，需要把 owner 唤醒)
+    bool hasMailForOthers();
+
 private:
     /**
      * @brief 调度任务封装 (设为私有内部类)
@@ -112,44 +133,81 @@ private:
         Fiber::ptr fiber_;           // 任务对应的协程
         std::function<void()> cb_;   // 任务对应的回调函数
         int thread_;                 // 指定运行的线程ID，-1表示任意线程
+        // 入队时间：只有被抽样的任务才记录 (默认值表示不统计排队时间)
+        std::chrono::steady_clock::time_point enqueued_;
 
         SchedulerTask() { thread_ = -1; }
-        SchedulerTask(Fiber::ptr f, int t) : fiber_(f), thread_(t) {}
-        SchedulerTask(std::function<void()> f, int t) : cb_(f), thread_(t) {}
+        SchedulerTask(Fiber::ptr f, int t) : fiber_(std::move(f)), thread_(t) {}
+        SchedulerTask(std::function<void()> f, int t) : cb_(std::move(f)), thread_(t) {}
 
         // 清空任务
         void reset() {
             fiber_ = nullptr;
             cb_ = nullptr;
             thread_ = -1;
+            enqueued_ = std::chrono::steady_clock::time_point();
         }
     };
 
     /**
      * @brief [Raft优化] 线程局部上下文
-     * * 细节：每个线程拥有独立的上下文，包含私有队列和公共队列
+     * * 细节：每个线程拥有独立的上下文，只有信箱需要加锁
      */
     struct ThreadContext {
-        // [私有队列]：仅当前线程可访问，用于 Raft Leader 等核心逻辑 (无锁/极低开销)
-        // 注意：.h 中定义结构，具体无锁逻辑依赖 run 方法实现
-        // 这里为了简化实现，暂统一放在结构体中，逻辑上区分对待
+        // [私有队列]：仅当前线程可访问，存放指定到本线程的任务 (thread_ != -1)，
+        // 用于 Raft Leader 等需要 CPU 亲和性的核心逻辑，无锁且不会被窃取
         std::deque<SchedulerTask> private_queue; 
 
-        // [公共队列]：允许被窃取 (Work Stealing)，需加锁
-        std::deque<SchedulerTask> public_queue;
-        MutexType mutex; // 保护 public_queue
+        // [窃取队列]：只存放未指定线程的任务 (thread_ == -1)
+        // owner 在底部无锁 push/pop，其他线程在顶部 CAS 窃取，单次窃取 O(1)
+        WorkStealDeque<SchedulerTask*> ready_queue;
+
+        // [信箱]：其他线程 (或调度器外的线程) 投递给本线程的任务
+        // owner 每轮 swap 整个信箱，指定线程的任务进私有队列，其余进窃取队列
+        std::vector<SchedulerTask> mailbox;
+        std::atomic<bool> has_mail{false}; // 无锁快速判断信箱是否为空
+        std::atomic<bool> idle{false};     // owner 是否处于 idle 协程中 (转发唤醒时用)
+        MutexType mutex; // 保护 mailbox
+
+        // 以下只有 owner 访问
+        std::vector<SchedulerTask> inbox;  // 与 mailbox 交换的缓冲，保留容量避免反复分配
+        uint32_t dispatch_count = 0;       // 每隔若干次从自己的顶部取任务，防止 LIFO 饿死旧任务
     };
 
+    // [线程缓存] 窃取队列里的任务对象从当前线程的空闲链表分配 / 回收，省掉每个任务一次 new + delete
+    struct TaskPool;
+    static TaskPool *localTaskPool();
+    static SchedulerTask *allocTask(SchedulerTask &&task);
+    static void freeTask(SchedulerTask *task);
+
+    // 把任务放入合适的队列 (两个 schedule 重载的公共实现)
+    void scheduleTask(SchedulerTask &&task);
+
+    // [owner] 取走信箱中的所有任务并分拣
+    void drainMailbox(ThreadContext *ctx);
+
+    // [owner] 按 "信箱 -> 私有队列 -> 自己的窃取队列 -> 窃取别人" 的顺序取一个任务
+    bool fetchTask(ThreadContext *ctx, int my_index, SchedulerTask &task);
+
+    Scheduler(size_t threads, bool use_caller, const std::string &name, int core_offset, std::vector<int> cpus);
+
+    // 上下文 index 所属线程将要运行的 NUMA node (-1 表示不指定)
+    int contextNode(size_t index) const;
+
 protected:
     // 保存 CPU 偏移量
 
     int m_core_offset = -1; 
+    // 绑核列表 (非空时优先于 m_core_offset)
+    std::vector<int> m_cpus;
     // 线程池
     std::vector<Thread::ptr> threadPool_;
     
     // [修改] 替换原有的全局 tasks_，改为每个线程独立的上下文容器
     // 索引对应线程 ID (或映射后的 ID)
     std::vector<ThreadContext*> threadContexts_;
+    // threadContexts_[i] 是否用 AllocOnNode 分配 (析构时对应地释放)
+    std::vector<bool> contextOnNode_;
 
     // 互斥锁 (保护全局 metadata，不再保护任务队列)
     MutexType mutex_;
@@ -173,8 +231,12 @@ protected:
     // use caller = true 时，主线程的ID
     int rootThread_ = 0;
 
-    // 是否正在停止
-    bool stopping_ = false;
+    // 是否正在停止 (未 start 时视为已停止，start() 据此判断是否重复启动)
+    bool stopping_ = true;
+
+    // 导出指标 (标签 scheduler=name_)：任务从入队到被取出的等待时间 (抽样)，以及跨线程窃取成功次数
+    MetricHistogram *queueWait_ = nullptr;
+    MetricCounter *steals_ = nullptr;
 };
 
 }  // namespace monsoon
@@ -1,8 +1,8 @@
 #ifndef __MONSOON_TIMER_H__
 #define __MONSOON_TIMER_H__
 
+#include <atomic>
 #include <memory>
-#include <set>
 #include <vector>
 #include <functional>
 #include "mutex.h"
@@ -38,7 +38,7 @@ public:
      * * 场景： 类似于看门狗机制，重置执行时间。
      * 细节：
      * 1. 将执行时间更新为：当前时间 + 周期 (ms_)。
-     * 2. 在 TimerManager 的 set 中重新排序。
+     * 2. 从时间轮原槽位摘下，挂到新槽位 (O(1))。
      */
     bool refresh();
 
@@ -57,12 +57,6 @@ private:
      */
     Timer(uint64_t ms, std::function<void()> cb, bool recurring, TimerManager *manager);
 
-    /**
-     * @brief 仅用于比较的构造函数
-     * * 作用： 用于 set 查找时的临时对象构建。
-     */
-    Timer(uint64_t next);
-
 private:
     /// 是否是循环定时器
     bool recurring_ = false;
@@ -75,31 +69,31 @@ private:
     /// 管理器指针
     TimerManager *manager_ = nullptr;
 
-private:
-    /**
-     * @brief 定时器比较仿函数
-     * * 作用： 定义 std::set 的排序规则。
-     * 细节：
-     * 1. 优先比较 next_ (执行时间)，时间越早越靠前。
-     * 2. 时间相同时，比较对象地址，确保 set 能存储多个同一时刻触发的定时器。
-     */
-    struct Comparator {
-        bool operator()(const Timer::ptr &lhs, const Timer::ptr &rhs) const;
-    };
+    /// 时间轮槽位内的侵入式双向链表 (无锁待插入栈复用 listNext_)
+    Timer *listPrev_ = nullptr;
+    Timer *listNext_ = nullptr;
+    /// 所在层级 (-1 表示不在时间轮中) 与槽位下标，cancel / refresh 据此 O(1) 摘链
+    int level_ = -1;
+    uint32_t slot_ = 0;
+    /// 挂在时间轮 / 待插入栈期间持有自身，出轮时释放
+    Timer::ptr self_;
 };
 
 /**
  * @brief 定时器管理器
  * * 场景： 作为 IOManager 的基类，赋予调度器处理定时任务的能力。
  * 细节：
- * 1. 维护一个按时间排序的定时器集合。
- * 2. 提供获取最近超时时间的方法，供 epoll_wait 使用。
+ * 1. 定时器存放在分层时间轮中 (1ms 一个 tick)：第 0 层 256 个槽，第 1~4 层各 64 个槽，覆盖约 49 天；
+ *    高层槽位在低层转完一圈时逐级下放 (cascade)，add / cancel / refresh 都是 O(1) 的摘链挂链。
+ * 2. addTimer 不加锁：新定时器压入无锁待插入栈，由持锁的操作 (到期收集、取最近超时、cancel 等) 批量搬进时间轮。
+ * 3. 提供获取最近超时时间的方法，供 epoll_wait 使用。
  */
 class TimerManager {
     friend class Timer;
 
 public:
-    typedef RWMutex RWMutexType;
+    // 临界区都很短 (摘链挂链)，几乎都是写操作：自适应锁先自旋，避免读写锁每次竞争都进内核
+    typedef AdaptiveMutex MutexType;
 
     TimerManager();
     virtual ~TimerManager();
@@ -110,8 +104,8 @@ public:
      * @param[in] cb 回调函数
      * @param[in] recurring 是否循环执行
      * * 细节：
-     * 1. 创建 Timer 对象并插入 set。
-     * 2. 如果新插入的定时器排在最前面，触发 OnTimerInsertedAtFront()。
+     * 1. 创建 Timer 对象并压入无锁待插入栈 (不取锁)。
+     * 2. 如果新定时器早于 epoll_wait 当前的超时时刻，触发 OnTimerInsertedAtFront()。
      */
     Timer::ptr addTimer(uint64_t ms, std::function<void()> cb, bool recurring = false);
 
@@ -139,8 +133,8 @@ public:
      * * 场景： 工作线程从 epoll_wait 醒来后调用。
      * 细节：
      * 1. 检测系统时间是否回卷（Rollover）。
-     * 2. 将所有 (next_ <= now) 的定时器取出。
-     * 3. 如果是循环定时器，重新计算时间放回 set；否则删除。
+     * 2. 时间轮推进到 now，沿途把到期槽位整条链表摘下 (空槽通过位图跳过)。
+     * 3. 如果是循环定时器，重新计算时间挂回时间轮；否则删除。
      */
     void listExpiredCb(std::vector<std::function<void()>> &cbs);
 
@@ -157,11 +151,17 @@ protected:
      */
     virtual void OnTimerInsertedAtFront() = 0;
 
+    /**
+     * @brief 当前时刻 (ms，单调时钟)
+     * * 作用： 定时器的所有时间计算都经过这里；测试中覆写为手动推进的时钟。
+     */
+    virtual uint64_t getNowMS();
+
     /**
      * @brief 添加定时器的底层实现
      * * 细节： 复用锁逻辑，避免死锁。
      */
-    void addTimer(Timer::ptr val, RWMutexType::WriteLock &lock);
+    void addTimer(Timer::ptr val, MutexType::Lock &lock);
 
 private:
     /**
@@ -170,13 +170,61 @@ private:
      */
     bool detectClockRollover(uint64_t now_ms);
 
+    // ---- 时间轮内部操作，调用方持有 mutex_ ----
+
+    /// 侵入式链表头
+    struct TimerList {
+        Timer *head = nullptr;
+    };
+
+    TimerList &listOf(int level, uint32_t slot);
+    /// 按 next_ 与 base_ 的距离挂到对应层级的槽位
+    void link(Timer *timer);
+    /// 从所在槽位摘下
+    void unlink(Timer *timer);
+    /// 把整条链表摘下，定时器的自引用移交给 out
+    void takeList(int level, uint32_t slot, std::vector<Timer::ptr> &out);
+    /// 把无锁待插入栈中的定时器搬进时间轮
+    void drainPending();
+    /// 把高层某个槽位的定时器按剩余时间重新分配到低层，返回该槽位下标
+    uint32_t cascade(int level, uint32_t slot);
+    /// 推进时间轮到 now_ms，收集沿途到期的定时器
+    void advance(uint64_t now_ms, std::vector<Timer::ptr> &expired);
+    /// 下一个需要处理的时刻 (绝对时间，~0ull 表示没有定时器)
+    uint64_t nextExpireTime();
+    /// 第 0 层中 [from, 256) 范围内第一个非空槽，没有返回 -1
+    int findRootSlot(uint32_t from) const;
+
 private:
-    /// 读写锁
-    RWMutexType mutex_;
-    /// set（红黑树）定时器集合 (有序)
-    std::set<Timer::ptr, Timer::Comparator> timers_;
+    static const uint32_t kRootBits = 8;
+    static const uint32_t kRootSize = 1u << kRootBits;    // 第 0 层：256 个 1ms 槽
+    static const uint32_t kRootMask = kRootSize - 1;
+    static const uint32_t kLevelBits = 6;
+    static const uint32_t kLevelSize = 1u << kLevelBits;  // 第 1~4 层：每层 64 个槽
+    static const uint32_t kLevelMask = kLevelSize - 1;
+    static const int kUpperLevels = 4;
+    static const int kDueLevel = kUpperLevels + 1;        // 插入时已经过期、等待下次收集的定时器
+    static const int kPendingLevel = kUpperLevels + 2;    // 还在无锁待插入栈中
+
+    /// 保护时间轮
+    MutexType mutex_;
+    /// 第 0 层槽位及其非空位图
+    TimerList root_[kRootSize];
+    uint64_t rootBitmap_[kRootSize / 64] = {0};
+    /// 第 1~4 层槽位
+    TimerList levels_[kUpperLevels][kLevelSize];
+    /// 已过期但尚未收集的定时器
+    TimerList due_;
+    /// 下一个待处理的 tick (ms)，小于它的时刻都已经处理过
+    uint64_t base_ = 0;
+    /// 时间轮中的定时器个数 (不含待插入栈)
+    size_t count_ = 0;
+    /// 无锁待插入栈 (Treiber stack，经 Timer::listNext_ 串联)
+    std::atomic<Timer *> pending_{nullptr};
+    /// epoll_wait 当前会在这个时刻醒来，更早的新定时器才需要唤醒
+    std::atomic<uint64_t> nextWakeup_{~0ull};
     /// 是否已经触发过 Tickle (优化，避免重复唤醒)
-    bool tickled_ = false;
+    std::atomic<bool> tickled_{false};
     /// 上次检查的时间戳
     uint64_t previousTime_ = 0;
 };
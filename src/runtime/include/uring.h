@@ -0,0 +1,97 @@
+#ifndef __MONSOON_URING_H__
+#define __MONSOON_URING_H__
+
+#include <linux/io_uring.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "noncopyable.h"
+
+namespace monsoon {
+
+/**
+ * @brief io_uring 的最小封装 (直接走 io_uring_setup / io_uring_enter 系统调用，不依赖 liburing)
+ * * 场景： IOManager 的 io_uring 后端，一个 IOManager 一个环。
+ * 细节：
+ * 1. getSqe / commit 操作提交队列 (SQ)，reap 消费完成队列 (CQ)；
+ * 2. 本类不做任何同步：SQ 与 CQ 各自的互斥由调用方负责，enter 可以在任意线程、不持锁调用
+ *    (内核自己串行化提交；commit 之后 SQE 对内核可见，谁先 enter 谁提交)；
+ * 3. 要求内核支持 IORING_FEAT_EXT_ARG (5.11+)，这样 enter 可以直接带超时等待，不必额外提交 TIMEOUT。
+ */
+class IoUring : Nonecopyable {
+ public:
+  IoUring() = default;
+  ~IoUring();
+
+  /**
+   * @brief 建环
+   * @param entries SQ 大小 (CQ 为其 8 倍)
+   * @return 0 成功；-errno 失败 (内核不支持、被 seccomp 禁用、缺少必需特性等)
+   */
+  int init(unsigned entries);
+
+  /**
+   * @brief 获取一个清零的空闲 SQE，SQ 已满时返回 nullptr (调用方 commit + enter 后重试)
+   */
+  io_uring_sqe *getSqe();
+
+  /**
+   * @brief 把已填写的 SQE 发布给内核
+   * @return 已发布但内核尚未消费的 SQE 个数 (即下一次 enter 的 to_submit)
+   */
+  unsigned commit();
+
+  /**
+   * @brief io_uring_enter
+   * @param to_submit 提交的 SQE 个数
+   * @param min_complete 等待的完成个数 (0 表示不等待)
+   * @param timeout_ms 等待超时，-1 表示一直等
+   * @return >= 0 实际提交的个数；< 0 为 -errno (超时为 -ETIME)
+   */
+  int enter(unsigned to_submit, unsigned min_complete, int timeout_ms = -1);
+
+  /**
+   * @brief 取出当前所有完成事件，对每个调用 f(user_data, res)
+   * @return 取出的个数
+   */
+  template <typename F>
+  unsigned reap(F &&f) {
+    unsigned head = *cqHead_;
+    unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    unsigned n = 0;
+    while (head != tail) {
+      const io_uring_cqe &cqe = cqes_[head & cqMask_];
+      f(cqe.user_data, cqe.res);
+      ++head;
+      ++n;
+    }
+    __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+    return n;
+  }
+
+ private:
+  int ringFd_ = -1;
+
+  // SQ
+  void *sqRing_ = nullptr;
+  size_t sqRingSize_ = 0;
+  unsigned *sqHead_ = nullptr;  // 内核消费位置
+  unsigned *sqTail_ = nullptr;  // 用户发布位置
+  unsigned sqMask_ = 0;
+  unsigned sqEntries_ = 0;
+  io_uring_sqe *sqes_ = nullptr;
+  size_t sqesSize_ = 0;
+  unsigned sqeTail_ = 0;        // 已分配 (getSqe) 但可能尚未发布的位置
+
+  // CQ
+  void *cqRing_ = nullptr;      // 与 sqRing_ 共用一次 mmap 时为 nullptr
+  size_t cqRingSize_ = 0;
+  unsigned *cqHead_ = nullptr;
+  unsigned *cqTail_ = nullptr;
+  unsigned cqMask_ = 0;
+  io_uring_cqe *cqes_ = nullptr;
+};
+
+}  // namespace monsoon
+
+#endif
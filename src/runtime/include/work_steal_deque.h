@@ -0,0 +1,143 @@
+#ifndef __MONSOON_WORK_STEAL_DEQUE_H__
+#define __MONSOON_WORK_STEAL_DEQUE_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace monsoon {
+
+/**
+ * @brief Chase-Lev 无锁工作窃取双端队列
+ * * 场景：Scheduler 每个线程一个，存放未指定线程 (thread == -1) 的任务
+ * * 细节 (参考 Lê et al. "Correct and Efficient Work-Stealing for Weak Memory Models")：
+ * 1. 只有 owner 线程能 push / pop，二者都在底部 (bottom) 操作，不加锁；
+ * 2. 任意线程都能 steal，在顶部 (top) 用一次 CAS 抢占，不会与 owner 争锁；
+ * 3. 只剩最后一个元素时，owner 的 pop 与 thief 的 steal 通过同一个 CAS 决出胜负；
+ * 4. 环形数组满了由 owner 扩容为两倍；旧数组可能仍被 thief 读取，延迟到析构时释放。
+ * * 约束：T 必须可平凡拷贝 (通常是指针)，元素的所有权由调用方管理。
+ */
+template <typename T>
+class WorkStealDeque {
+    static_assert(std::is_trivially_copyable<T>::value, "WorkStealDeque element must be trivially copyable");
+
+public:
+    explicit WorkStealDeque(size_t capacity = 256) {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        buffers_.emplace_back(new Buffer(cap));
+        buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealDeque(const WorkStealDeque &) = delete;
+    WorkStealDeque &operator=(const WorkStealDeque &) = delete;
+
+    /**
+     * @brief [owner] 压入底部
+     */
+    void push(T item) {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_acquire);
+        Buffer *buf = buffer_.load(std::memory_order_relaxed);
+        if (b - t > static_cast<int64_t>(buf->mask)) {
+            buf = grow(buf, t, b);
+        }
+        buf->put(b, item);
+        // release：thief 看到新的 bottom 时一定能看到槽位里的数据
+        bottom_.store(b + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief [owner] 从底部弹出 (LIFO，cache 最热的任务)
+     * @return 队列为空或最后一个元素被 thief 抢走时返回 false
+     */
+    bool pop(T &out) {
+        int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        Buffer *buf = buffer_.load(std::memory_order_relaxed);
+        // 先占住 bottom 再读 top：与 steal 中 "先读 top 再读 bottom" 构成 seq_cst 顺序
+        bottom_.store(b, std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_seq_cst);
+
+        if (t > b) {
+            // 空队列：恢复 bottom
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        out = buf->get(b);
+        if (t == b) {
+            // 最后一个元素：和 thief 竞争同一个 top
+            bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /**
+     * @brief [任意线程] 从顶部窃取 (FIFO，最老的任务)
+     * @return 队列为空或 CAS 失败 (被其他 thief / owner 抢先) 时返回 false
+     */
+    bool steal(T &out) {
+        int64_t t = top_.load(std::memory_order_seq_cst);
+        int64_t b = bottom_.load(std::memory_order_seq_cst);
+        if (t >= b) {
+            return false;
+        }
+        Buffer *buf = buffer_.load(std::memory_order_acquire);
+        T item = buf->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return false;
+        }
+        out = item;
+        return true;
+    }
+
+    // 近似判空 (stopping 检查用)，并发下可能短暂不准确
+    bool empty() const {
+        int64_t t = top_.load(std::memory_order_acquire);
+        int64_t b = bottom_.load(std::memory_order_acquire);
+        return t >= b;
+    }
+
+    size_t size() const {
+        int64_t t = top_.load(std::memory_order_acquire);
+        int64_t b = bottom_.load(std::memory_order_acquire);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+
+private:
+    struct Buffer {
+        explicit Buffer(size_t cap) : mask(cap - 1), slots(new std::atomic<T>[cap]) {}
+
+        T get(int64_t i) const { return slots[i & mask].load(std::memory_order_relaxed); }
+        void put(int64_t i, T v) { slots[i & mask].store(v, std::memory_order_relaxed); }
+
+        const size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    // [owner] 扩容：拷贝 [t, b) 到两倍大小的新数组
+    Buffer *grow(Buffer *old, int64_t t, int64_t b) {
+        Buffer *buf = new Buffer((old->mask + 1) * 2);
+        for (int64_t i = t; i < b; ++i) {
+            buf->put(i, old->get(i));
+        }
+        buffers_.emplace_back(buf);
+        buffer_.store(buf, std::memory_order_release);
+        return buf;
+    }
+
+    // top / bottom 分处不同 cache line：thief 的 CAS 不会干扰 owner 的 bottom 写入
+    alignas(64) std::atomic<int64_t> top_{0};
+    alignas(64) std::atomic<int64_t> bottom_{0};
+    alignas(64) std::atomic<Buffer *> buffer_{nullptr};
+    // 所有分配过的数组 (只有 owner 修改)，析构时统一释放
+    std::vector<std::unique_ptr<Buffer>> buffers_;
+};
+
+}  // namespace monsoon
+
+#endif
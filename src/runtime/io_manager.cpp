@@ -1,11 +1,14 @@
 #include "iomanager.h"
 #include <fcntl.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
 #include <cstring>
 #include <vector>
 #include <algorithm> // for std::min
 #include <sched.h> // [新增] for pthread_setaffinity_np
+#include <poll.h>
+#include "uring.h"
 
 namespace monsoon {
 
@@ -70,38 +73,49 @@ void FdContext::triggerEvent(Event event) {
  * * 场景： 在服务器启动时调用，构建基于Epoll的协程调度中心。
  * 细节：
  * 1. 创建 Epoll 实例。
- * 2. 创建用于通知调度协程的管道 (Pipe)，并注册到 Epoll 中。
+ * 2. 创建用于通知调度协程的 eventfd，并注册到 Epoll 中。
  * 3. 预分配 Socket 上下文容器。
  * 4. 启动调度器。
  * 5. [Raft优化] 根据传入的 core_offset 参数，设置线程亲和性 (CPU Affinity)。
  */
-IOManager::IOManager(size_t threads, bool use_caller, const std::string &name, int core_offset)
+IOManager::IOManager(size_t threads, bool use_caller, const std::string &name, int core_offset, IOBackend backend)
     : Scheduler(threads, use_caller, name) {
+    init(backend);
+}
+
+IOManager::IOManager(size_t threads, bool use_caller, const std::string &name, std::vector<int> cpus,
+                     IOBackend backend)
+    : Scheduler(threads, use_caller, name, std::move(cpus)) {
+    init(backend);
+}
+
+void IOManager::init(IOBackend backend) {
+    // io_uring 后端：建环成功就不再创建 epoll 和 tickle eventfd (tickle 改为提交 NOP)
+    if (backend == IOBackend::IO_URING && initUring()) {
+        backend_ = IOBackend::IO_URING;
+        start();
+        return;
+    }
+
     // 创建epoll实例，size参数在Linux 2.6.8之后被忽略，但必须大于0
     epfd_ = epoll_create(5000);
     CondPanic(epfd_ > 0, "epoll_create error");
 
-    // 创建管道，用于tickle（唤醒）idle协程
-    int ret = pipe(tickleFds_);
-    CondPanic(ret == 0, "pipe error");
+    // 创建 eventfd，用于tickle（唤醒）idle协程
+    // 相比 pipe：只占一个 fd，多次写入在内核中累加为一个计数，一次 read 即可清空 (非阻塞，配合ET模式)
+    tickleFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    CondPanic(tickleFd_ >= 0, "eventfd error");
 
-    // 注册管道读端的可读事件
+    // 注册 eventfd 的可读事件
     epoll_event event{};
     memset(&event, 0, sizeof(epoll_event));
     event.events = EPOLLIN | EPOLLET; // 边缘触发
-    event.data.fd = tickleFds_[0];
+    event.data.fd = tickleFd_;
 
-    // 设置管道读端为非阻塞，配合ET模式
-    ret = fcntl(tickleFds_[0], F_SETFL, O_NONBLOCK);
-    CondPanic(ret == 0, "set fd nonblock error");
-
-    // 将管道加入epoll监听
-    ret = epoll_ctl(epfd_, EPOLL_CTL_ADD, tickleFds_[0], &event);
+    // 将 eventfd 加入epoll监听
+    int ret = epoll_ctl(epfd_, EPOLL_CTL_ADD, tickleFd_, &event);
     CondPanic(ret == 0, "epoll_ctl error");
 
-    // 预分配一定的FdContext大小
-    contextResize(32);
-
     // 启动 Scheduler::run 进行调度，会创建线程池并让每个工作线程运行调度循环
     start();
     
@@ -172,39 +186,23 @@ IOManager::IOManager(size_t threads, bool use_caller, const std::string &name, i
  * * 场景： 服务器关闭或对象销毁时。
  * 细节：
  * 1. 停止调度器。
- * 2. 关闭 Epoll 文件句柄和管道句柄。
- * 3. 释放所有的 FdContext 内存。
+ * 2. 关闭 Epoll 文件句柄和 eventfd。
+ * 3. FdContext 随 fdContexts_ 的各段一起释放。
  */
 IOManager::~IOManager() {
     stop();
-    close(epfd_);   // 关闭 epoll 文件句柄
-    close(tickleFds_[0]);   // 关闭管道读端
-    close(tickleFds_[1]);   // 关闭管道写端
-
-    // 释放 fdContexts 内存中的每个 FdContext 对象(一个FdContext对应一个socket fd)
-    for (size_t i = 0; i < fdContexts_.size(); i++) {
-        if (fdContexts_[i]) {
-            delete fdContexts_[i];
-        }
+    if (backend_ == IOBackend::EPOLL) {
+        close(epfd_);   // 关闭 epoll 文件句柄
+        close(tickleFd_);   // 关闭 eventfd
     }
+    ring_.reset();  // 关闭 io_uring 环 (如果有)
 }
 
 /**
- * @brief 扩展 FdContext 容器大小，使fdContexts_能容纳指定数量的fd
- * @param size 扩容后的目标大小
- * * 细节：
- * 1. 只有在 fd 超过当前大小时才需要调用。
- * 2. 初始化新分配的 FdContext 对象。
+ * @brief 获取 fd 对应的 FdContext，所在段未分配时按需分配 (无全局锁)
  */
-void IOManager::contextResize(size_t size) {
-    fdContexts_.resize(size);
-    // 初始化新分配的 FdContext 对象
-    for (size_t i = 0; i < fdContexts_.size(); i++) {
-        if (!fdContexts_[i]) {
-            fdContexts_[i] = new FdContext;
-            fdContexts_[i]->fd = i;
-        }
-    }
+FdContext *IOManager::getFdContext(int fd) {
+    return fdContexts_.getOrCreate(fd, [](FdContext &ctx, int idx) { ctx.fd = idx; });
 }
 
 /**
@@ -215,27 +213,15 @@ void IOManager::contextResize(size_t size) {
  * @return int 0 success, -1 error
  * * 场景： 协程执行 read/write 遇到 EAGAIN（资源暂时不可用） 时，将 fd 注册到 IOManager 并挂起当前协程。
  * 细节：
- * 1. 检查并扩展 fd 上下文容器 (Double-Checked Locking)。
+ * 1. 从分段表中取出 fd 上下文 (不存在则分配所在段，无全局锁)。
  * 2. 更新 Epoll 监听状态 (EPOLL_CTL_ADD 或 EPOLL_CTL_MOD)。
  * 3. 保存回调对象或当前协程上下文。
  */
 int IOManager::addEvent(int fd, Event event, std::function<void()> cb) {
-    FdContext *fd_ctx = nullptr;
-    
-    // 1. 获取读锁，尝试获取 FdContext
-    RWMutex::ReadLock lock(mutex_);
-    if ((int)fdContexts_.size() > fd) {
-        fd_ctx = fdContexts_[fd];
-        lock.unlock();
-    } else {
-        lock.unlock();
-        // 2. 读锁获取失败（fd超出范围），升级为写锁进行扩容，扩容后获取 FdContext
-        RWMutex::WriteLock lock2(mutex_);
-        // Double-Check: 再次判断大小，防止在获取写锁等待期间已被其他线程扩容
-        if ((int)fdContexts_.size() <= fd) {
-            contextResize(fd * 1.5);    // 扩容的时候，fdContexts_ 大小变 150，fdContexts_[100]~[150] 的对象全被 new 出来了。
-        }
-        fd_ctx = fdContexts_[fd];
+    // 1. 获取 FdContext：一次原子读；fd 超出已分配的段时分配新段 (段只增不移，指针始终有效)
+    FdContext *fd_ctx = getFdContext(fd);
+    if (!fd_ctx) {
+        return -1;
     }
 
     // 3. 对具体的 FdContext 加锁
@@ -248,17 +234,22 @@ int IOManager::addEvent(int fd, Event event, std::function<void()> cb) {
         CondPanic(!(fd_ctx->events & event), "addEvent error");
     }
 
-    // 判断是新增还是修改 (若已有其他事件则为MOD，否则为ADD)
-    int op = fd_ctx->events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
-    // 构建增加了 event 的事件集合（events）给 epoll_ctl 使用（给内核监听）
-    epoll_event epevent;
-    epevent.events = EPOLLET | fd_ctx->events | event; // 新的事件集合如下：保持原有事件，添加新事件，开启ET模式
-    epevent.data.ptr = fd_ctx; // 携带 fd 的上下文指针（用于触发事件时找到对应的 FdContext）
-
-    int ret = epoll_ctl(epfd_, op, fd, &epevent);
-    if (ret) {
-        std::cerr << "addEvent: epoll_ctl error, fd=" << fd << " op=" << op << " err=" << strerror(errno) << std::endl;
-        return -1;
+    if (backend_ == IOBackend::IO_URING) {
+        // 每个事件单独一个一次性 POLL_ADD，读写互不影响
+        uringArmPoll(fd_ctx, event);
+    } else {
+        // 判断是新增还是修改 (若已有其他事件则为MOD，否则为ADD)
+        int op = fd_ctx->events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+        // 构建增加了 event 的事件集合（events）给 epoll_ctl 使用（给内核监听）
+        epoll_event epevent;
+        epevent.events = EPOLLET | fd_ctx->events | event; // 新的事件集合如下：保持原有事件，添加新事件，开启ET模式
+        epevent.data.ptr = fd_ctx; // 携带 fd 的上下文指针（用于触发事件时找到对应的 FdContext）
+
+        int ret = epoll_ctl(epfd_, op, fd, &epevent);
+        if (ret) {
+            std::cerr << "addEvent: epoll_ctl error, fd=" << fd << " op=" << op << " err=" << strerror(errno) << std::endl;
+            return -1;
+        }
     }
 
     // 待执行IO事件数量 +1
@@ -294,13 +285,11 @@ int IOManager::addEvent(int fd, Event event, std::function<void()> cb) {
  * 2. **主动触发**一次该事件（执行回调），以确保协程能从 yield 状态恢复并退出。
  */
 bool IOManager::cancelEvent(int fd, Event event) {
-    // 1. 获取读锁，尝试获取 fd 对应的 FdContext
-    RWMutex::ReadLock lock(mutex_);
-    if ((int)fdContexts_.size() <= fd) {
+    // 1. 获取 fd 对应的 FdContext (所在段从未分配过，说明从没注册过事件)
+    FdContext *fd_ctx = fdContexts_.get(fd);
+    if (!fd_ctx) {
         return false;
     }
-    FdContext *fd_ctx = fdContexts_[fd];
-    lock.unlock();
 
     // 2. 对具体的 FdContext 加锁
     Mutex::Lock ctxLock(fd_ctx->mutex);
@@ -308,17 +297,21 @@ bool IOManager::cancelEvent(int fd, Event event) {
         return false;
     }
 
-    // 构建去除了 event 的事件集合（events）给 epoll_ctl 使用（给内核监听）
-    Event new_events = (Event)(fd_ctx->events & ~event);    // 清理指定事件位，也就是移除 events 中的 event 事件
-    int op = new_events ? EPOLL_CTL_MOD : EPOLL_CTL_DEL;
-    epoll_event epevent;
-    epevent.events = EPOLLET | new_events;
-    epevent.data.ptr = fd_ctx;  // 携带 fd 的上下文指针（用于触发事件时找到对应的 FdContext）
-
-    int ret = epoll_ctl(epfd_, op, fd, &epevent);
-    if (ret) {
-        std::cerr << "cancelEvent: epoll_ctl error, fd=" << fd << " err=" << strerror(errno) << std::endl;
-        return false;
+    if (backend_ == IOBackend::IO_URING) {
+        uringRemovePoll(fd_ctx, event);
+    } else {
+        // 构建去除了 event 的事件集合（events）给 epoll_ctl 使用（给内核监听）
+        Event new_events = (Event)(fd_ctx->events & ~event);    // 清理指定事件位，也就是移除 events 中的 event 事件
+        int op = new_events ? EPOLL_CTL_MOD : EPOLL_CTL_DEL;
+        epoll_event epevent;
+        epevent.events = EPOLLET | new_events;
+        epevent.data.ptr = fd_ctx;  // 携带 fd 的上下文指针（用于触发事件时找到对应的 FdContext）
+
+        int ret = epoll_ctl(epfd_, op, fd, &epevent);
+        if (ret) {
+            std::cerr << "cancelEvent: epoll_ctl error, fd=" << fd << " err=" << strerror(errno) << std::endl;
+            return false;
+        }
     }
 
     // 关键区别：取消操作会触发一次事件，让等待的协程醒来处理“被取消”的逻辑
@@ -339,13 +332,11 @@ bool IOManager::cancelEvent(int fd, Event event) {
  * 2. 如果该 fd 上没有其他事件了，则使用 EPOLL_CTL_DEL。
  */
 bool IOManager::delEvent(int fd, Event event) {
-    // 1. 获取读锁，尝试获取 fd 对应的 FdContext
-    RWMutex::ReadLock lock(mutex_);
-    if ((int)fdContexts_.size() <= fd) {
+    // 1. 获取 fd 对应的 FdContext (所在段从未分配过，说明从没注册过事件)
+    FdContext *fd_ctx = fdContexts_.get(fd);
+    if (!fd_ctx) {
         return false;
     }
-    FdContext *fd_ctx = fdContexts_[fd];
-    lock.unlock();
 
     // 对具体的 FdContext 加锁
     Mutex::Lock ctxLock(fd_ctx->mutex);
@@ -355,16 +346,20 @@ bool IOManager::delEvent(int fd, Event event) {
 
     // 2. 构建去除了 event 的事件集合（events）给 epoll_ctl 使用（给内核监听）
     Event new_events = (Event)(fd_ctx->events & ~event);    // 位清零，移除 events 中的 event 事件
-    int op = new_events ? EPOLL_CTL_MOD : EPOLL_CTL_DEL;
-    epoll_event epevent;
-    epevent.events = EPOLLET | new_events;
-    epevent.data.ptr = fd_ctx;
-
-    // 3. 调用 epoll_ctl 更新监听状态
-    int ret = epoll_ctl(epfd_, op, fd, &epevent);
-    if (ret) {
-        std::cerr << "delEvent: epoll_ctl error, fd=" << fd << " err=" << strerror(errno) << std::endl;
-        return false;
+    if (backend_ == IOBackend::IO_URING) {
+        uringRemovePoll(fd_ctx, event);
+    } else {
+        int op = new_events ? EPOLL_CTL_MOD : EPOLL_CTL_DEL;
+        epoll_event epevent;
+        epevent.events = EPOLLET | new_events;
+        epevent.data.ptr = fd_ctx;
+
+        // 3. 调用 epoll_ctl 更新监听状态
+        int ret = epoll_ctl(epfd_, op, fd, &epevent);
+        if (ret) {
+            std::cerr << "delEvent: epoll_ctl error, fd=" << fd << " err=" << strerror(errno) << std::endl;
+            return false;
+        }
     }
 
     --pendingEventCnt_;
@@ -383,27 +378,34 @@ bool IOManager::delEvent(int fd, Event event) {
  * * 场景： fd 关闭时，清理所有残留事件。
  */
 bool IOManager::cancelAll(int fd) {
-    RWMutex::ReadLock lock(mutex_);
-    if ((int)fdContexts_.size() <= fd) {
+    FdContext *fd_ctx = fdContexts_.get(fd);
+    if (!fd_ctx) {
         return false;
     }
-    FdContext *fd_ctx = fdContexts_[fd];
-    lock.unlock();
 
     Mutex::Lock ctxLock(fd_ctx->mutex);
     if (!fd_ctx->events) {
         return false;
     }
 
-    int op = EPOLL_CTL_DEL;
-    epoll_event epevent;
-    epevent.events = 0;
-    epevent.data.ptr = fd_ctx;
-
-    int ret = epoll_ctl(epfd_, op, fd, &epevent);
-    if (ret) {
-        std::cerr << "cancelAll: epoll_ctl error, fd=" << fd << " err=" << strerror(errno) << std::endl;
-        return false;
+    if (backend_ == IOBackend::IO_URING) {
+        if (fd_ctx->events & READ) {
+            uringRemovePoll(fd_ctx, READ);
+        }
+        if (fd_ctx->events & WRITE) {
+            uringRemovePoll(fd_ctx, WRITE);
+        }
+    } else {
+        int op = EPOLL_CTL_DEL;
+        epoll_event epevent;
+        epevent.events = 0;
+        epevent.data.ptr = fd_ctx;
+
+        int ret = epoll_ctl(epfd_, op, fd, &epevent);
+        if (ret) {
+            std::cerr << "cancelAll: epoll_ctl error, fd=" << fd << " err=" << strerror(errno) << std::endl;
+            return false;
+        }
     }
 
     // 依次触发可能存在的读写事件
@@ -431,15 +433,43 @@ IOManager *IOManager::GetThis() {
  * @brief 通知调度器有任务到来
  * * 场景： 当其他线程添加了任务，或者定时器超时，需要唤醒 idle 状态的线程。
  * 细节：
- * 1. 写入管道一个字符，使阻塞在 epoll_wait 的 idle 协程返回。
+ * 1. 写 eventfd，使阻塞在 epoll_wait 的 idle 协程返回。
+ * 2. [合并唤醒] 没有线程阻塞在 epoll_wait 中，或者上一次写入还没被读走，都不必再写：
+ *    前者下一个进入 idle 的线程会先复查任务队列，后者已在途的唤醒足以让一个线程醒来处理。
  */
 void IOManager::tickle() {
     if (!isHasIdleThreads()) {
         return;
     }
-    // 写pipe管道，使得idle协程从epoll_wait退出，开始调度任务
-    int rt = write(tickleFds_[1], "T", 1);
-    CondPanic(rt == 1, "write pipe error");
+    if (backend_ == IOBackend::IO_URING) {
+        // 提交一个 NOP：它的完成事件会唤醒阻塞在 io_uring_enter 上的 idle 线程
+        Mutex::Lock lock(uringSqMutex_);
+        io_uring_sqe *sqe = uringGetSqeLocked();
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = 0;
+        uringFlushLocked(true);
+        return;
+    }
+    // 与 idleEpoll 中 "++pollingThreads_ -> 复查任务" 配对 (Dekker)：
+    // 任务入队在前、这里读计数在后，二者至少有一方能看到对方
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (pollingThreads_.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    if (tickled_.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    // 写 eventfd，使得idle协程从epoll_wait退出，开始调度任务
+    int rt = eventfd_write(tickleFd_, 1);
+    CondPanic(rt == 0, "write eventfd error");
+}
+
+void IOManager::setMaxEvents(int max_events) {
+    maxEvents_.store(std::max(max_events, 1), std::memory_order_relaxed);
+}
+
+void IOManager::setMaxIdleTimeout(int timeout_ms) {
+    maxIdleTimeoutMs_.store(std::max(timeout_ms, 1), std::memory_order_relaxed);
 }
 
 /**
@@ -452,38 +482,59 @@ void IOManager::tickle() {
  * 4. 如果收到 tickle 信号，说明有新任务加入，退出 idle 状态。
  */
 void IOManager::idle() {
-    // 每次 epoll_wait 最多检测 256 个就绪事件
-    const uint64_t MAX_EVENTS = 256;
+    if (backend_ == IOBackend::IO_URING) {
+        idleUring();
+    } else {
+        idleEpoll();
+    }
+}
+
+void IOManager::idleEpoll() {
+    // 每次 epoll_wait 最多检测 maxEvents_ 个就绪事件 (默认 256)
     // 使用 vector 管理内存，自动释放，避免手动 delete[]
-    std::vector<epoll_event> events(MAX_EVENTS);
+    std::vector<epoll_event> events(getMaxEvents());
 
     while (true) {
+        // 先登记 "我要阻塞了"，再读定时器、复查任务：此后的 tickle 一定会写 eventfd
+        pollingThreads_.fetch_add(1, std::memory_order_seq_cst);
+
         // 获取下一个定时器超时时间，同时判断调度器是否已经 stop
         // 如果系统要停止了（且没定时器、没 Pending 事件），直接 break 退出 idle 循环
         uint64_t next_timeout = 0;
         if (stopping(next_timeout)) {
+            pollingThreads_.fetch_sub(1, std::memory_order_relaxed);
+            // stop() 的若干次 tickle 可能被合并成一次，把唤醒传给下一个仍在等待的线程
+            tickle();
             std::cout << "name=" << getName() << " idle stopping exit" << std::endl;
             break;
         }
 
+        if ((size_t)getMaxEvents() != events.size()) {
+            events.resize(getMaxEvents());
+        }
+
         // 阻塞等待，等待事件发生 或者 定时器超时
         int ret = 0;
         do {
-            static const int MAX_TIMEOUT = 5000;
+            const int max_timeout = getMaxIdleTimeout();
 
             // 问一下定时器管理器：“下一个定时器啥时候触发？”
             // 如果最近的定时器是 10ms 后，那就设置 epoll_wait 超时时间为 10ms
             // 如果没有定时器，就设为默认最大值（5秒）
             if (next_timeout != ~0ull) {
-                next_timeout = std::min((int)next_timeout, MAX_TIMEOUT);
+                next_timeout = std::min<uint64_t>(next_timeout, max_timeout);
             } else {
-                next_timeout = MAX_TIMEOUT;
+                next_timeout = max_timeout;
+            }
+            // 登记之前投递的任务，tickle 可能因为没看到我们而跳过写入：复查一次，有就只轮询不阻塞
+            if (hasRunnableTasks()) {
+                next_timeout = 0;
             }
             
             // 工作线程执行 epoll_wait()，阻塞等待 IO 事件或超时发生（协程的read是非阻塞的）
             // 物理动作：当前线程挂起，让出 CPU
             // &events[0] 获取 vector 底层数组指针
-            ret = epoll_wait(epfd_, &events[0], MAX_EVENTS, (int)next_timeout);
+            ret = epoll_wait(epfd_, &events[0], (int)events.size(), (int)next_timeout);
 
             if (ret < 0) {
                 if (errno == EINTR) {
@@ -497,6 +548,7 @@ void IOManager::idle() {
                 break;
             }
         } while (true);
+        pollingThreads_.fetch_sub(1, std::memory_order_relaxed);
 
         // 1. 收集定时管理器（一组内存里的数据结构）中所有超时定时器，执行回调函数
         std::vector<std::function<void()>> cbs; // 检查所有已经过期的定时器，把它们绑定的回调函数取出来。
@@ -514,17 +566,15 @@ void IOManager::idle() {
         for (int i = 0; i < ret; i++) {
             epoll_event &event = events[i];
 
-            // 如果是 tickle 管道的可读事件(有其他线程喊醒此线程)
-            if (event.data.fd == tickleFds_[0]) {
-                uint8_t dummy[256];
-                // 循环 read 管道，把里面的数据读干净（必须循环读取直到 EAGAIN，防止 ET 模式下漏读导致下次无法触发）
-                while (true) {
-                    int read_len = read(tickleFds_[0], dummy, sizeof(dummy));
-                    if (read_len < 0) {
-                        if (errno == EAGAIN) break; // 读完了
-                    } else if (read_len == 0) {
-                        break; // 对端关闭
-                    }
+            // 如果是 tickle eventfd 的可读事件(有其他线程喊醒此线程)
+            if (event.data.fd == tickleFd_) {
+                // 一次 read 即清空计数；先读后清标记，清之前的 tickle 被合并掉也没关系，本线程马上就会去取任务
+                eventfd_t dummy;
+                eventfd_read(tickleFd_, &dummy);
+                tickled_.store(false, std::memory_order_release);
+                // 信箱只能由 owner 收取：积压在别人信箱里的任务，要把唤醒转给其他等待的线程
+                if (hasMailForOthers()) {
+                    tickle();
                 }
                 continue;
             }
@@ -620,4 +670,263 @@ void IOManager::OnTimerInsertedAtFront() {
     tickle(); 
 }
 
+// =======================================================
+// io_uring 后端
+// =======================================================
+
+namespace {
+
+// 环的 SQ 大小
+const unsigned kUringEntries = 256;
+// 没有线程阻塞在环上时，攒够这么多 SQE 才主动 enter 一次
+const unsigned kUringSubmitBatch = 32;
+
+/**
+ * user_data 编码：低 4 位为类型，高 16 位为 poll 的代数 (generation)，中间是对象指针
+ * (FdContext / UringOp 都声明为 16 字节对齐，x86-64 / aarch64 用户态地址不超过 48 位)
+ */
+static_assert(alignof(FdContext) >= 16, "user_data tag bits overlap FdContext address");
+const uint64_t kUringTagMask = 0xF;
+const uint64_t kUringPtrMask = 0x0000FFFFFFFFFFF0ull;
+const uint64_t kUringTagIgnore = 0;   // NOP / POLL_REMOVE / LINK_TIMEOUT 自身的完成事件
+const uint64_t kUringTagRead = 1;     // FdContext 的读 poll
+const uint64_t kUringTagWrite = 2;    // FdContext 的写 poll
+const uint64_t kUringTagOp = 3;       // submitIo 的 IO 操作
+
+/**
+ * @brief 一次 submitIo 的等待上下文，放在发起协程的栈上，完成后由 idle 线程填入结果并唤醒协程
+ */
+struct alignas(16) UringOp {
+    Fiber::ptr fiber;
+    Scheduler *scheduler = nullptr;
+    int32_t res = 0;
+    __kernel_timespec timeout;
+};
+
+inline uint64_t EncodePoll(FdContext *fd_ctx, Event event, uint16_t gen) {
+    uint64_t tag = (event == READ) ? kUringTagRead : kUringTagWrite;
+    return reinterpret_cast<uint64_t>(fd_ctx) | tag | (static_cast<uint64_t>(gen) << 48);
+}
+
+}  // namespace
+
+/**
+ * @brief 建环
+ * * 失败 (内核不支持 / 需要的特性缺失) 时返回 false，构造函数据此回退到 epoll
+ */
+bool IOManager::initUring() {
+    std::unique_ptr<IoUring> ring(new IoUring);
+    int ret = ring->init(kUringEntries);
+    if (ret < 0) {
+        std::cerr << "IOManager: io_uring unavailable (" << strerror(-ret) << "), fall back to epoll" << std::endl;
+        return false;
+    }
+    ring_ = std::move(ring);
+    return true;
+}
+
+/**
+ * @brief 获取空闲 SQE；SQ 满了就先把已发布的提交给内核腾出空间
+ */
+io_uring_sqe *IOManager::uringGetSqeLocked() {
+    io_uring_sqe *sqe = ring_->getSqe();
+    while (!sqe) {
+        unsigned n = ring_->commit();
+        int ret = ring_->enter(n, 0);
+        if (ret < 0 && ret != -EINTR && ret != -EAGAIN && ret != -EBUSY) {
+            std::cerr << "io_uring_enter submit error: " << strerror(-ret) << std::endl;
+        }
+        sqe = ring_->getSqe();
+    }
+    return sqe;
+}
+
+/**
+ * @brief 发布并 (视情况) 提交
+ * * 细节：
+ * 1. 有 idle 线程阻塞在 io_uring_enter 上时必须立即提交，否则没人会替我们提交；
+ * 2. 否则只发布不提交，等下一个进入 idle 的线程把这一批一次性提交 (攒批)，攒够 kUringSubmitBatch 个例外。
+ */
+void IOManager::uringFlushLocked(bool urgent) {
+    unsigned n = ring_->commit();
+    if (n == 0) {
+        return;
+    }
+    if (urgent || n >= kUringSubmitBatch || isHasIdleThreads()) {
+        int ret = ring_->enter(n, 0);
+        if (ret < 0 && ret != -EINTR && ret != -EAGAIN && ret != -EBUSY) {
+            std::cerr << "io_uring_enter submit error: " << strerror(-ret) << std::endl;
+        }
+    }
+}
+
+/**
+ * @brief 为 fd 的一个事件提交一次性 POLL_ADD (调用方持有 fd_ctx->mutex)
+ */
+void IOManager::uringArmPoll(FdContext *fd_ctx, Event event) {
+    uint16_t gen = (event == READ) ? ++fd_ctx->readGen : ++fd_ctx->writeGen;
+    Mutex::Lock lock(uringSqMutex_);
+    io_uring_sqe *sqe = uringGetSqeLocked();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd_ctx->fd;
+    sqe->poll32_events = (event == READ) ? POLLIN : POLLOUT;
+    sqe->user_data = EncodePoll(fd_ctx, event, gen);
+    uringFlushLocked(false);
+}
+
+/**
+ * @brief 撤销 fd 的一个事件上的 poll (调用方持有 fd_ctx->mutex)
+ * * 旧 poll 之后若仍有完成事件 (已就绪或 -ECANCELED)，会因为事件已注销或代数不符被丢弃
+ */
+void IOManager::uringRemovePoll(FdContext *fd_ctx, Event event) {
+    uint16_t gen = (event == READ) ? fd_ctx->readGen : fd_ctx->writeGen;
+    Mutex::Lock lock(uringSqMutex_);
+    io_uring_sqe *sqe = uringGetSqeLocked();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->addr = EncodePoll(fd_ctx, event, gen);
+    sqe->user_data = kUringTagIgnore;
+    uringFlushLocked(false);
+}
+
+/**
+ * @brief 提交 IO 操作并挂起当前协程
+ * * 细节：
+ * 1. 带超时时在操作后面链一个 LINK_TIMEOUT，到期由内核取消操作 (完成结果为 -ECANCELED，转换为 -ETIMEDOUT)；
+ * 2. 完成事件可能在本协程 yield 之前就被其他线程处理，调度器对尚在 RUNNING 的协程会稍后重试，不会丢失唤醒。
+ */
+ssize_t IOManager::submitIo(const UringIoRequest &req, uint64_t timeout_ms) {
+    CondPanic(backend_ == IOBackend::IO_URING, "submitIo requires io_uring backend");
+
+    UringOp op;
+    op.fiber = Fiber::GetThis();
+    op.scheduler = Scheduler::GetThisScheduler();
+    bool has_timeout = timeout_ms != (uint64_t)-1;
+
+    ++pendingEventCnt_;
+    {
+        Mutex::Lock lock(uringSqMutex_);
+        io_uring_sqe *sqe = uringGetSqeLocked();
+        sqe->opcode = req.opcode;
+        sqe->fd = req.fd;
+        sqe->addr = reinterpret_cast<uint64_t>(req.addr);
+        sqe->len = req.len;
+        sqe->off = req.off;
+        sqe->rw_flags = req.op_flags;
+        sqe->user_data = reinterpret_cast<uint64_t>(&op) | kUringTagOp;
+
+        if (has_timeout) {
+            sqe->flags |= IOSQE_IO_LINK;
+            op.timeout.tv_sec = timeout_ms / 1000;
+            op.timeout.tv_nsec = (long long)(timeout_ms % 1000) * 1000000;
+            io_uring_sqe *tsqe = uringGetSqeLocked();
+            tsqe->opcode = IORING_OP_LINK_TIMEOUT;
+            tsqe->addr = reinterpret_cast<uint64_t>(&op.timeout);
+            tsqe->len = 1;
+            tsqe->user_data = kUringTagIgnore;
+        }
+        uringFlushLocked(false);
+    }
+
+    Fiber::GetThis()->yield();
+
+    if (has_timeout && op.res == -ECANCELED) {
+        return -ETIMEDOUT;
+    }
+    return op.res;
+}
+
+/**
+ * @brief io_uring 后端的 Idle 协程
+ * * 细节：
+ * 1. 把攒下的 SQE 一次提交，并在同一次 io_uring_enter 中等待完成事件或定时器超时；
+ * 2. 多个 idle 线程共享一个环，CQ 的消费用 uringCqMutex_ 串行化，取出后在锁外分发；
+ * 3. 分发规则：poll 完成 -> triggerEvent (与 epoll 就绪相同)；IO 操作完成 -> 写回结果并调度发起协程；
+ * 4. 唤醒转发：醒来的线程发现其他 idle 线程信箱非空时再 tickle 一次，否则那些任务要等到 idle 超时。
+ */
+void IOManager::idleUring() {
+    std::vector<std::pair<uint64_t, int32_t>> completions;
+    completions.reserve(kUringEntries);
+
+    while (true) {
+        uint64_t next_timeout = 0;
+        if (stopping(next_timeout)) {
+            // 同一批 NOP 可能被一个线程全部取走，把唤醒传给下一个仍阻塞在环上的线程
+            tickle();
+            std::cout << "name=" << getName() << " idle stopping exit" << std::endl;
+            break;
+        }
+
+        const int max_timeout = getMaxIdleTimeout();
+        int timeout = (next_timeout != ~0ull) ? (int)std::min<uint64_t>(next_timeout, max_timeout) : max_timeout;
+        // 进入 idle 之前投递的任务：只轮询不阻塞
+        if (hasRunnableTasks()) {
+            timeout = 0;
+        }
+
+        unsigned to_submit = 0;
+        {
+            Mutex::Lock lock(uringSqMutex_);
+            to_submit = ring_->commit();
+        }
+        // 阻塞等待：提交 + 等待至少一个完成事件 (或超时)
+        int ret = ring_->enter(to_submit, 1, timeout);
+        if (ret < 0 && ret != -ETIME && ret != -EINTR && ret != -EAGAIN && ret != -EBUSY) {
+            std::cerr << "io_uring_enter wait error: " << strerror(-ret) << std::endl;
+        }
+
+        completions.clear();
+        {
+            Mutex::Lock lock(uringCqMutex_);
+            ring_->reap([&completions](uint64_t user_data, int32_t res) { completions.emplace_back(user_data, res); });
+        }
+
+        // 1. 超时定时器
+        std::vector<std::function<void()>> cbs;
+        listExpiredCb(cbs);
+        for (const auto &cb : cbs) {
+            schedule(cb);
+        }
+
+        // 2. 完成事件
+        for (const auto &c : completions) {
+            uint64_t tag = c.first & kUringTagMask;
+            if (tag == kUringTagOp) {
+                UringOp *op = reinterpret_cast<UringOp *>(c.first & kUringPtrMask);
+                // 先把协程取出来再写结果：协程一旦被调度，op 所在的栈帧随时可能失效
+                Fiber::ptr fiber = std::move(op->fiber);
+                Scheduler *scheduler = op->scheduler;
+                op->res = c.second;
+                --pendingEventCnt_;
+                scheduler->schedule(fiber);
+            } else if (tag == kUringTagRead || tag == kUringTagWrite) {
+                FdContext *fd_ctx = reinterpret_cast<FdContext *>(c.first & kUringPtrMask);
+                Event event = (tag == kUringTagRead) ? READ : WRITE;
+                uint16_t gen = static_cast<uint16_t>(c.first >> 48);
+
+                Mutex::Lock lock(fd_ctx->mutex);
+                uint16_t cur_gen = (event == READ) ? fd_ctx->readGen : fd_ctx->writeGen;
+                // 事件已被 del/cancel，或这是被替换掉的旧 poll
+                if (!(fd_ctx->events & event) || gen != cur_gen) {
+                    continue;
+                }
+                // 出错 (POLLERR/POLLHUP/-EBADF) 同样唤醒，由重试的系统调用拿到具体错误
+                fd_ctx->triggerEvent(event);
+                --pendingEventCnt_;
+            }
+        }
+
+        // tickle 的 NOP 只能唤醒环上任意一个线程，而信箱只能由 owner 收取：
+        // 醒的不是 owner 时把唤醒转给其他等待的线程 (与 idleEpoll 的转发相同)
+        if (hasMailForOthers()) {
+            tickle();
+        }
+
+        Fiber::ptr cur = Fiber::GetThis();
+        auto raw_ptr = cur.get();
+        cur.reset();
+
+        raw_ptr->yield();
+    }
+}
+
 }  // namespace monsoon
\ No newline at end of file
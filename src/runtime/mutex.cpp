@@ -0,0 +1,84 @@
+#include "mutex.h"
+#include "fiber.h"
+#include "scheduler.h"
+
+namespace monsoon {
+
+bool FiberMutex::try_lock() {
+  bool expected = false;
+  return m_locked.compare_exchange_strong(expected, true, std::memory_order_acquire, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 加锁
+ * * 细节：
+ * 1. 快路径 CAS 失败后，在 m_waitLock 下再试一次：unlock 也是在 m_waitLock 下决定 "释放" 还是 "移交"，
+ *    所以这里要么拿到锁，要么已经排进队列，不会两头落空。
+ * 2. 排队后返回时锁已经被移交给自己 (m_locked 一直为 true)，不需要再 CAS。
+ */
+void FiberMutex::lock() {
+  if (try_lock()) {
+    return;
+  }
+
+  // 调度协程自身 (run / idle 所在的执行流) 不能 yield，按普通线程处理
+  Scheduler *scheduler = Scheduler::GetThisScheduler();
+  Fiber::ptr self;
+  if (scheduler != nullptr) {
+    self = Fiber::GetThis();
+    if (self.get() == Scheduler::GetMainFiber()) {
+      self = nullptr;
+    }
+  }
+
+  if (self) {
+    {
+      Spinlock::Lock lock(m_waitLock);
+      if (try_lock()) {
+        return;
+      }
+      Waiter waiter;
+      waiter.scheduler = scheduler;
+      waiter.fiber = self;
+      m_waiters.push_back(std::move(waiter));
+    }
+    // 等待期间的引用由队列 (之后是调度器) 持有，栈上不留引用
+    Fiber *raw_ptr = self.get();
+    self.reset();
+    raw_ptr->yield();
+    return;
+  }
+
+  Semaphore sem;
+  {
+    Spinlock::Lock lock(m_waitLock);
+    if (try_lock()) {
+      return;
+    }
+    Waiter waiter;
+    waiter.sem = &sem;
+    m_waiters.push_back(std::move(waiter));
+  }
+  sem.wait();
+}
+
+void FiberMutex::unlock() {
+  Waiter next;
+  {
+    Spinlock::Lock lock(m_waitLock);
+    if (m_waiters.empty()) {
+      m_locked.store(false, std::memory_order_release);
+      return;
+    }
+    next = std::move(m_waiters.front());
+    m_waiters.pop_front();
+  }
+  // 锁直接移交给 next：m_locked 保持 true，其他线程的快路径 CAS 无法插队
+  if (next.sem != nullptr) {
+    next.sem->notify();
+  } else {
+    next.scheduler->schedule(std::move(next.fiber));
+  }
+}
+
+}  // namespace monsoon
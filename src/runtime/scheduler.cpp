@@ -1,6 +1,7 @@
 #include "scheduler.h"
 #include "fiber.h"
 #include "hook.h"
+#include "cpu_topology.h"
 #include <iostream>
 #include <algorithm>
 #include <cassert>
@@ -25,8 +26,67 @@ static thread_local Fiber *t_scheduler_fiber = nullptr;
 // 作用：用于 schedule 时快速判断是否是“本线程给本线程派活”
 static thread_local void* t_thread_ctx = nullptr;
 
+// 当前线程在 threadContexts_ 中的下标
+// 作用：异步回调需要回到发起线程时，作为 schedule 的 thread 参数
+static thread_local int t_thread_index = -1;
+
 const std::string LOG_HEAD = "[scheduler] ";
 
+// =======================================================
+// 任务对象池 (SchedulerTask Pool)
+// =======================================================
+
+/**
+ * @brief 线程局部的 SchedulerTask 空闲链表
+ * 1. 窃取队列存放 SchedulerTask*：不指定线程的任务每次入队都要 new、出队都要 delete；
+ * 2. 出队后的对象放回取走它的线程的链表，下次入队直接复用；被窃取的任务在窃取方回收，内存本身与线程无关；
+ * 3. 容量与协程池相同 (Fiber::SetPoolCapacity，0 表示关闭池化)。
+ */
+struct Scheduler::TaskPool {
+    ~TaskPool();
+
+    std::vector<SchedulerTask *> tasks;
+};
+
+// 线程退出时池子先于其它 thread_local 析构，之后的释放直接 delete
+static thread_local bool t_task_pool_destroyed = false;
+
+Scheduler::TaskPool::~TaskPool() {
+    t_task_pool_destroyed = true;
+    for (SchedulerTask *task : tasks) {
+        delete task;
+    }
+}
+
+Scheduler::TaskPool *Scheduler::localTaskPool() {
+    if (t_task_pool_destroyed) {
+        return nullptr;
+    }
+    static thread_local TaskPool pool;
+    return &pool;
+}
+
+Scheduler::SchedulerTask *Scheduler::allocTask(SchedulerTask &&task) {
+    TaskPool *pool = localTaskPool();
+    if (pool && !pool->tasks.empty()) {
+        SchedulerTask *item = pool->tasks.back();
+        pool->tasks.pop_back();
+        *item = std::move(task);
+        return item;
+    }
+    return new SchedulerTask(std::move(task));
+}
+
+void Scheduler::freeTask(SchedulerTask *task) {
+    TaskPool *pool = localTaskPool();
+    if (pool && pool->tasks.size() < Fiber::GetPoolCapacity()) {
+        task->reset();  // 尽早释放回调捕获的资源
+        pool->tasks.push_back(task);
+        return;
+    }
+    delete task;
+}
+
 /**
  * @brief 构造函数：初始化调度器
  * @param threads 调度器启动时会创建线程池，threads是线程池包含的线程数量
@@ -39,7 +99,14 @@ const std::string LOG_HEAD = "[scheduler] ";
  * 2. 初始化线程数、名称等基础配置。
  */
 Scheduler::Scheduler(size_t threads, bool use_caller, const std::string &name, int core_offset)
-    : name_(name), m_core_offset(core_offset) {
+    : Scheduler(threads, use_caller, name, core_offset, std::vector<int>()) {}
+
+Scheduler::Scheduler(size_t threads, bool use_caller, const std::string &name, std::vector<int> cpus)
+    : Scheduler(threads, use_caller, name, -1, std::move(cpus)) {}
+
+Scheduler::Scheduler(size_t threads, bool use_caller, const std::string &name, int core_offset,
+                     std::vector<int> cpus)
+    : name_(name), m_core_offset(core_offset), m_cpus(std::move(cpus)) {
     assert(threads > 0);
 
     isUseCaller_ = use_caller;  // 是否将当前的调用线程（Caller Thread）纳入调度体系
@@ -58,7 +125,7 @@ Scheduler::Scheduler(size_t threads, bool use_caller, const std::string &name, i
         // 3. 创建 Caller 线程的调度协程 (rootFiber)
         // 注意：这个协程执行的是 Scheduler::run 方法。
         // 当 run 方法 yield 时，会切回当前线程的主协程 (即 main 函数原本的执行流)
-        Caller_Schedule_Fiber_.reset(new Fiber(std::bind(&Scheduler::run, this), 0, true)); // run 方法作为协程入口函数
+        Caller_Schedule_Fiber_ = Fiber::Create(std::bind(&Scheduler::run, this), 0, true); // run 方法作为协程入口函数
         
         Thread::SetName(name_);
         
@@ -74,9 +141,22 @@ Scheduler::Scheduler(size_t threads, bool use_caller, const std::string &name, i
     // [Raft优化] 初始化所有线程的上下文容器 (Thread-per-Core)
     // threadCnt_ + 1 是为了包含 caller 线程（如果有）
     threadContexts_.resize(threadCnt_ + (use_caller ? 1 : 0));
+    // 指定了绑核列表时，上下文 (队列头、信箱) 分配在对应线程所在的 node 上，而不是构造者所在的 node
     for(size_t i = 0; i < threadContexts_.size(); ++i) {
-        threadContexts_[i] = new ThreadContext();
+        if (m_cpus.empty()) {
+            threadContexts_[i] = new ThreadContext();
+            continue;
+        }
+        void *mem = AllocOnNode(sizeof(ThreadContext), contextNode(i));
+        threadContexts_[i] = mem ? new (mem) ThreadContext() : new ThreadContext();
+        contextOnNode_.push_back(mem != nullptr);
     }
+
+    MetricsRegistry &registry = MetricsRegistry::GetInstance();
+    queueWait_ = registry.GetHistogram("scheduler_queue_wait_microseconds", {{"scheduler", name_}},
+                                       "Run-queue wait from schedule() to dispatch (1 in 16 tasks sampled)");
+    steals_ = registry.GetCounter("scheduler_steals_total", {{"scheduler", name_}},
+                                  "Tasks taken from another thread's ready queue");
     // std::cout << LOG_HEAD << "Constructed: " << name_ << " success" << std::endl;
 }
 
@@ -93,9 +173,31 @@ Scheduler::~Scheduler() {
         t_scheduler = nullptr;
     }
     // [Raft优化] 清理上下文
-    for(auto ctx : threadContexts_) {
-        delete ctx;
+    for(size_t i = 0; i < threadContexts_.size(); ++i) {
+        ThreadContext *ctx = threadContexts_[i];
+        if (i < contextOnNode_.size() && contextOnNode_[i]) {
+            ctx->~ThreadContext();
+            FreeOnNode(ctx, sizeof(ThreadContext));
+        } else {
+            delete ctx;
+        }
+    }
+}
+
+/**
+ * @brief 上下文 index 的 owner 线程所在的 NUMA node
+ * 细节：use_caller 时 0 号上下文属于构造调度器的线程，取它当前的 node；
+ * 其余上下文对应第 index - (use_caller ? 1 : 0) 个工作线程，取它绑定的核所在的 node。
+ */
+int Scheduler::contextNode(size_t index) const {
+    if (isUseCaller_ && index == 0) {
+        return CurrentNumaNode();
+    }
+    if (m_cpus.empty()) {
+        return -1;
     }
+    size_t worker = index - (isUseCaller_ ? 1 : 0);
+    return CpuTopology::GetInstance().NodeOfCpu(m_cpus[worker % m_cpus.size()]);
 }
 
 /**
@@ -114,6 +216,10 @@ Fiber *Scheduler::GetMainFiber() {
     return t_scheduler_fiber; 
 }
 
+int Scheduler::GetThisThreadIndex() {
+    return t_thread_index;
+}
+
 /**
  * @brief 设置当前线程的调度器
  * 场景： 在 run() 方法开始时调用，标记当前线程归属。
@@ -153,14 +259,22 @@ void Scheduler::start() {
         
         // 计算该线程应该绑定的 CPU ID
         // 只有在 Scheduler 构造时指定了有效的 core_offset_ 才进行绑定
-        if (m_core_offset != -1 && num_cores > 0) {
+        if (!m_cpus.empty()) {
+            cpu_id = m_cpus[i % m_cpus.size()];
+        } else if (m_core_offset != -1 && num_cores > 0) {
             // 公式：(起始偏移 + 索引 * 步长) % 总核数
             cpu_id = (m_core_offset + i * stride) % num_cores;
         }
 
         // 创建新线程，入口函数为 Scheduler::run
         // 传递 cpu_id 给 Thread 构造函数，实现"出生即绑核"
-        threadPool_[i].reset(new Thread(std::bind(&Scheduler::run, this), 
+        // ThreadContext 下标在创建时确定 (use_caller 时 0 号留给 caller 线程)，
+        // 不能在 run() 里反查 threadIds_：新线程可能先于下面的 push_back 跑起来
+        int ctx_index = static_cast<int>(i) + (isUseCaller_ ? 1 : 0);
+        threadPool_[i].reset(new Thread([this, ctx_index]() {
+                                            t_thread_index = ctx_index;
+                                            run();
+                                        },
                                         name_ + "_" + std::to_string(i),
                                         cpu_id));
 
@@ -168,7 +282,7 @@ void Scheduler::start() {
     }
     
     std::cout << LOG_HEAD << "Start success, threads: " << threadCnt_ 
-              << ", affinity_mode: " << (m_core_offset == -1 ? "NONE" : "THREAD_PER_CORE") 
+              << ", affinity_mode: " << (!m_cpus.empty() ? "CPU_LIST" : m_core_offset == -1 ? "NONE" : "THREAD_PER_CORE") 
               << std::endl;
 }
 
@@ -232,81 +346,146 @@ void Scheduler::stop() {
  * @details 支持指定线程 ID，将任务放入特定线程的私有队列，实现 Raft Leader 绑核
  */
 void Scheduler::schedule(Fiber::ptr fiber, int thread) {
-    bool need_tickle = false;
-    {
-        // 1. 确定目标上下文
-        ThreadContext* target_ctx = nullptr;
-        // [Raft优化] 如果指定了线程，尝试放入目标线程的上下文
-        if (thread != -1) {
-            // 用户指定了 thread ID (例如 Raft Leader 指定 thread=0)
-            // 这里为了简化演示，假设 thread 参数对应 threadContexts_ 的索引
-            // 实际可能需要一个 map<threadId, index> 的映射
-            if (thread < (int)threadContexts_.size()) {
-                target_ctx = threadContexts_[thread];
-            } else {
-                // 索引越界回退到随机
-                target_ctx = threadContexts_[rand() % threadContexts_.size()];
+    scheduleTask(SchedulerTask(std::move(fiber), thread));
+}
+
+/**
+ * @brief [核心改造] 调度回调入口
+ */
+void Scheduler::schedule(std::function<void()> cb, int thread) {
+    scheduleTask(SchedulerTask(std::move(cb), thread));
+}
+
+/**
+ * @brief 任务分派
+ * * 细节：
+ * 1. 本调度器的线程给自己派活：
+ *    - 指定本线程 -> 私有队列 (无锁，不唤醒)；
+ *    - 不指定线程 -> 自己的窃取队列底部 (无锁)，有空闲线程时 tickle 让它们来偷。
+ * 2. 其他情况 (给别的线程派活 / 调度器外的线程提交)：
+ *    放入目标线程的信箱，不指定线程时按 Round-Robin 选目标。
+ */
+// 每隔多少个入队的任务抽样一个统计排队时间：读时钟的开销只摊到 1/16 的任务上
+static constexpr uint32_t kQueueWaitSampleEvery = 16;
+
+void Scheduler::scheduleTask(SchedulerTask &&task) {
+    static thread_local uint32_t t_schedule_count = 0;
+    if (queueWait_ && task.enqueued_ == std::chrono::steady_clock::time_point() &&
+        ++t_schedule_count % kQueueWaitSampleEvery == 0) {
+        task.enqueued_ = std::chrono::steady_clock::now();
+    }
+
+    // t_thread_ctx 只有在属于本调度器时才能直接操作 (同一线程可能先后服务于不同调度器)
+    ThreadContext* self = (t_scheduler == this) ? static_cast<ThreadContext*>(t_thread_ctx) : nullptr;
+
+    if (task.thread_ >= (int)threadContexts_.size()) {
+        task.thread_ = -1; // 索引越界回退为不指定
+    }
+
+    ThreadContext* target_ctx = nullptr;
+    if (task.thread_ == -1) {
+        if (self) {
+            self->ready_queue.push(allocTask(std::move(task)));
+            if (isHasIdleThreads()) {
+                tickle();
             }
-        } else {
-            // 用户没指定 (thread == -1)，也就是普通任务
-            // 使用 Round-Robin (轮询) 算法选择一个线程
-            static std::atomic<size_t> s_robin{0};
-            target_ctx = threadContexts_[s_robin++ % threadContexts_.size()];
+            return;
         }
-
-        // [核心优化]：私有队列 (Private Queue) 判断
-        // 如果目标上下文就是当前线程的上下文，说明是“自己给自己派活” (例如 Raft 状态机连续步骤)
-        // 此时直接放入 private_queue，完全无锁，性能极高。
-        if (target_ctx == t_thread_ctx) {
-            target_ctx->private_queue.push_back(SchedulerTask(fiber, thread));
+        // 用户没指定 (thread == -1)，也就是普通任务
+        // 使用 Round-Robin (轮询) 算法选择一个线程
+        static std::atomic<size_t> s_robin{0};
+        target_ctx = threadContexts_[s_robin++ % threadContexts_.size()];
+    } else {
+        // 指定了 thread (例如 Raft Leader 指定 thread=0)，thread 是 threadContexts_ 的下标
+        target_ctx = threadContexts_[task.thread_];
+        if (target_ctx == self) {
+            // [核心优化]：自己给自己派活 (例如 Raft 状态机连续步骤)，完全无锁
             // 不需要 tickle，因为我自己就在运行中，下一次 run 循环开头就会处理
-        } else {
-            // 如果是给别的线程派活，必须加锁并放入自己线程的 public_queue，后续会被窃取
-            MutexType::Lock lock(target_ctx->mutex);
-            target_ctx->public_queue.push_back(SchedulerTask(fiber, thread));
-            need_tickle = true;
+            self->private_queue.push_back(std::move(task));
+            return;
         }
     }
 
-    // 任务放进去了，如果放入的是公共队列，需要唤醒可能沉睡的 Worker 线程。
-    if (need_tickle) {
-        tickle(); // 任务队列从空变非空，唤醒idle协程
+    {
+        MutexType::Lock lock(target_ctx->mutex);
+        target_ctx->mailbox.push_back(std::move(task));
+        target_ctx->has_mail.store(true, std::memory_order_release);
     }
+    // 任务放进了别人的信箱，需要唤醒可能沉睡的 Worker 线程。
+    tickle();
 }
 
-/**
- * @brief [核心改造] 调度回调入口
- */
-void Scheduler::schedule(std::function<void()> cb, int thread) {
-    bool need_tickle = false;
+void Scheduler::drainMailbox(ThreadContext* ctx) {
     {
-        ThreadContext* target_ctx = nullptr;
-        // [Raft优化] 如果指定了线程，尝试放入目标线程的上下文
-        if (thread != -1 && thread < (int)threadContexts_.size()) {
-            target_ctx = threadContexts_[thread];
-        } else {
-            // 用户没指定 (thread == -1)，也就是普通任务
-            static std::atomic<size_t> s_robin{0};
-            target_ctx = threadContexts_[s_robin++ % threadContexts_.size()];
-        }
+        MutexType::Lock lock(ctx->mutex);
+        ctx->inbox.swap(ctx->mailbox);
+        ctx->has_mail.store(false, std::memory_order_relaxed);
+    }
 
-        // [核心优化]：私有队列 (Private Queue) 判断
-        if (target_ctx == t_thread_ctx) {
-            target_ctx->private_queue.push_back(SchedulerTask(cb, thread));
+    bool stealable = false;
+    for (auto& task : ctx->inbox) {
+        if (task.thread_ == -1) {
+            ctx->ready_queue.push(allocTask(std::move(task)));
+            stealable = true;
         } else {
-            // 如果是给别的线程派活，必须加锁并放入自己线程的 public_queue，后续会被窃取
-            MutexType::Lock lock(target_ctx->mutex);
-            target_ctx->public_queue.push_back(SchedulerTask(cb, thread));
-            need_tickle = true;
+            ctx->private_queue.push_back(std::move(task));
         }
     }
+    ctx->inbox.clear();
 
-    // 任务放进去了，如果放入的是公共队列，需要唤醒可能沉睡的 Worker 线程。
-    if (need_tickle) {
+    // 新的可窃取任务：让空闲线程过来分担
+    if (stealable && isHasIdleThreads()) {
         tickle();
     }
 }
 
+// 每隔多少次取任务，从自己窃取队列的顶部 (最老的任务) 取一次
+static constexpr uint32_t kSelfStealInterval = 32;
+
+bool Scheduler::fetchTask(ThreadContext* ctx, int my_index, SchedulerTask& task) {
+    // 0. 收取信箱
+    if (ctx->has_mail.load(std::memory_order_acquire)) {
+        drainMailbox(ctx);
+    }
+
+    // 1. 私有队列：无锁，优先级最高。Raft 核心逻辑（如日志追加循环）将常驻于此。
+    if (!ctx->private_queue.empty()) {
+        task = std::move(ctx->private_queue.front());
+        ctx->private_queue.pop_front();
+        return true;
+    }
+
+    // 2. 自己的窃取队列：通常从底部取 (LIFO，cache 热)，定期从顶部取一次，
+    //    避免不断 re-schedule 自己的协程把旧任务饿死
+    SchedulerTask* item = nullptr;
+    bool got = false;
+    if (++ctx->dispatch_count % kSelfStealInterval == 0) {
+        got = ctx->ready_queue.steal(item);
+    }
+    if (!got) {
+        got = ctx->ready_queue.pop(item);
+    }
+
+    // 3. Work Stealing：从 (my_index + 1) 开始遍历，绕一圈回来，每个 victim 只做一次 CAS
+    if (!got) {
+        size_t thread_ctx_count = threadContexts_.size();
+        for (size_t i = 1; i < thread_ctx_count && !got; ++i) {
+            ThreadContext* victim = threadContexts_[(my_index + i) % thread_ctx_count];
+            got = victim->ready_queue.steal(item);
+        }
+        if (got && steals_) {
+            steals_->Add();
+        }
+    }
+
+    if (!got) {
+        return false;
+    }
+    task = std::move(*item);
+    freeTask(item);
+    return true;
+}
+
 /**
  * @brief 核心调度循环
  * * 场景： 每一个参与调度的线程（包括 Worker 线程和 Caller 线程）的入口函数。
@@ -316,10 +495,11 @@ void Scheduler::schedule(std::function<void()> cb, int thread) {
  * - 有任务 -> 执行任务 (resume)。
  * - 无任务 -> 执行 Idle 协程 (yield + wait)。
  * 3. 实现了对象复用：对于函数回调 (cb) 类型的任务，复用 cb_fiber，避免重复内存分配。
- * 4. 使用三级任务获取策略：
- *  - 私有队列 (Private Queue)：无锁，极速，优先级最高。
- * - 本线程公共队列 (Local Public Queue)：加锁，次优先级。
- * - 窃取其他线程任务 (Work Stealing)：加锁，最低优先级。
+ * 4. 任务获取策略 (见 fetchTask)：
+ * - 信箱 (Mailbox)：其他线程投递的任务，加锁整体取走后分拣，只在 has_mail 时才加锁。
+ * - 私有队列 (Private Queue)：无锁，极速，优先级最高。
+ * - 本线程窃取队列 (Chase-Lev Deque)：无锁，owner 从底部取。
+ * - 窃取其他线程任务 (Work Stealing)：无锁，从 victim 顶部 CAS 一次。
  */
 void Scheduler::run() {
     std::cout << LOG_HEAD << "Run begin in thread: " << GetThreadId() << std::endl;
@@ -335,23 +515,18 @@ void Scheduler::run() {
     }
 
     // [Raft优化] 初始化当前线程的 ThreadContext
-    // 简单映射策略：通过 threadIds_ 找到自己的 index
-    int my_index = -1;
-    for(size_t i=0; i<threadIds_.size(); ++i) {
-        if(threadIds_[i] == GetThreadId()) {
-            my_index = i;
-            break;
-        }
-    }
-    if (my_index == -1 && isUseCaller_) my_index = threadContexts_.size() - 1; 
+    // 工作线程的 index 已在 start() 中预置；caller 线程固定为 0 (与 threadIds_ 的顺序一致)
+    int my_index = (isUseCaller_ && GetThreadId() == rootThread_) ? 0 : t_thread_index;
+    assert(my_index >= 0 && my_index < static_cast<int>(threadContexts_.size()));
     ThreadContext* my_ctx = threadContexts_[my_index];
 
     // [新增] 设置线程局部上下文，供 schedule 判断使用
     t_thread_ctx = my_ctx;
+    t_thread_index = my_index;
 
     // 创建 Idle 协程：当没有任务时，运行这个协程进行休眠
     // 由于虚函数，且实际中只需要实例化 IOManager，因此实际执行的是 IOManager::idle
-    Fiber::ptr idle_fiber(new Fiber(std::bind(&Scheduler::idle, this)));
+    Fiber::ptr idle_fiber = Fiber::Create(std::bind(&Scheduler::idle, this));
     
     // 创建回调协程容器：用于执行 std::function 类型的任务
     Fiber::ptr cb_fiber;
@@ -360,98 +535,27 @@ void Scheduler::run() {
 
     while (true) {
         task.reset();
-        bool tickle_other_thread = false; // 是否需要唤醒其他线程
-        bool is_active = false; // 本轮是否处理了任务
-
-        // --- [核心改造] 三级任务获取策略 ---
-
-        // 1. [新增] 检查 Private Queue (私有队列)
-        // 无锁，极速，优先级最高。Raft 核心逻辑（如日志追加循环）将常驻于此。
-        {
-            if (!my_ctx->private_queue.empty()) {
-                task = my_ctx->private_queue.front();
-                my_ctx->private_queue.pop_front();
-                // 只要私有队列有活，就一直干，不用去管公共队列
-                // 这保证了核心逻辑的 CPU 亲和性和无锁执行
-                if (task.fiber_ || task.cb_) {
-                    ++activeThreadCnt_;
-                    is_active = true;
-                    // 跳转到执行部分，跳过后面的公共队列检查
-                    goto execute_task; 
-                }
-            }
-        }
 
-        // 2. 检查 Local Public Queue (自家公有队列)
-        {
-            MutexType::Lock lock(my_ctx->mutex);
-            auto it = my_ctx->public_queue.begin();
-            while (it != my_ctx->public_queue.end()) {
-                // 如果任务指定了别的线程，跳过 (这种情况理论上在 schedule 时就避免了，但在 Work Stealing 场景下可能发生)
-                if (it->thread_ != -1 && it->thread_ != GetThreadId()) {
-                    tickle_other_thread = true; // 通知别人去拿
-                    ++it;
-                    continue;
-                }
-
-                // 确保任务有效
-                assert(it->fiber_ || it->cb_);
-                
-                // 如果是协程任务，且正在执行中 -> 跳过 (不应发生，除非逻辑错误)
-                if (it->fiber_ && it->fiber_->getState() == Fiber::RUNNING) {
-                    ++it;
+        // --- [核心改造] 任务获取：信箱 -> 私有队列 -> 自己的窃取队列 -> 窃取别人 ---
+        if (fetchTask(my_ctx, my_index, task)) {
+            if (task.enqueued_ != std::chrono::steady_clock::time_point()) {
+                RecordLatency(queueWait_, task.enqueued_);
+                task.enqueued_ = std::chrono::steady_clock::time_point();
+            }
+            if (task.fiber_) {
+                Fiber::State state = task.fiber_->getState();
+                if (state == Fiber::RUNNING) {
+                    // 协程还在别的线程上运行 (唤醒早于它 yield)：放回去稍后再取
+                    scheduleTask(std::move(task));
                     continue;
                 }
-
-                // 找到可用任务，取出
-                task = *it;
-                my_ctx->public_queue.erase(it);
-                ++activeThreadCnt_; // 活跃线程数 +1
-                is_active = true;
-                break;
-            }
-        }
-
-        // 3. Work Stealing (窃取其他线程的任务)
-        if (!is_active) {
-            size_t thread_ctx_count = threadContexts_.size();
-            // 从 (my_index + 1) 开始遍历，绕一圈回来
-            for (size_t i = 0; i < threadContexts_.size(); ++i) {
-                // 计算要偷取目标线程的索引：(自己 + 1 + 偏移量) % 总数
-                size_t target_idx = (my_index + 1 + i) % thread_ctx_count;
-                if ((int)i == my_index) continue; // 不偷自己
-                
-                // 确定好要偷取线程的目标上下文
-                ThreadContext* victim = threadContexts_[target_idx];
-                // 加锁偷取
-                MutexType::Lock lock(victim->mutex);
-                
-                auto it = victim->public_queue.begin();
-                while(it != victim->public_queue.end()) {
-                    // [关键] 绝对不能偷指定了特定线程的任务 (Raft 绑核逻辑)
-                    if (it->thread_ != -1) {
-                        ++it;
-                        continue; 
-                    }
-                    
-                    // 偷走通用任务
-                    task = *it;
-                    victim->public_queue.erase(it);
-                    ++activeThreadCnt_;
-                    is_active = true;
-                    break;
+                if (state == Fiber::TERM || state == Fiber::EXCEPT) {
+                    continue; // 已经结束的协程，直接丢弃
                 }
-                if (is_active) break; // 偷到了就跑
             }
+            ++activeThreadCnt_;
         }
 
-        // 调用的字面上是 tickle()，但实际运行时，执行的是 IOManager::tickle()，通过 C++ 的 虚函数（Virtual Function） 机制实现的。
-        if (tickle_other_thread) {
-            tickle();
-        }
-
-    // [新增] 执行标签，供 private_queue 跳转使用
-    execute_task:
         // --- 使用这个任务（task）持有的协程执行任务逻辑 ---
         if (task.fiber_ && (task.fiber_->getState() != Fiber::TERM && task.fiber_->getState() != Fiber::EXCEPT)) {
             // Case 1: 这是一个协程任务 (Fiber)
@@ -466,7 +570,8 @@ void Scheduler::run() {
                 // 避免了重复的 Alloc/mmap 开销
                 cb_fiber->reset(task.cb_);
             } else {
-                cb_fiber.reset(new Fiber(task.cb_));
+                // 从线程协程池取：上一个协程被 yield 带走后，这里不必每次 new + mmap
+                cb_fiber = Fiber::Create(task.cb_);
             }
             task.reset();
             
@@ -476,6 +581,10 @@ void Scheduler::run() {
             // 只有当复用的协程彻底结束或异常时，才重置智能指针
             if(cb_fiber->getState() == Fiber::TERM || cb_fiber->getState() == Fiber::EXCEPT) {
                  cb_fiber->reset(nullptr); 
+            } else {
+                 // 回调中途 yield (例如同步等待 RPC)：协程归唤醒方持有，这里放弃引用，下次新建，
+                 // 否则下一个回调会 reset 掉一个还没执行完的协程
+                 cb_fiber.reset();
             }
         
         } else {
@@ -489,7 +598,9 @@ void Scheduler::run() {
 
             // 切换到 idle 协程进行等待 (会挂起当前线程)
             ++idleThreadCnt_;
+            my_ctx->idle.store(true, std::memory_order_relaxed);
             idle_fiber->resume();   
+            my_ctx->idle.store(false, std::memory_order_relaxed);
             --idleThreadCnt_;
         }
     }
@@ -508,6 +619,40 @@ void Scheduler::tickle() {
     // std::cout << LOG_HEAD << "tickle (base)" << std::endl;
 }
 
+/**
+ * @brief 当前线程是否有可执行的任务 (近似值，不加锁)
+ * * 场景： IOManager 在 epoll_wait 之前复查，防止 "复查之后才投递、但 tickle 以为没人在等" 的丢失唤醒。
+ * 细节：私有队列只由 owner 在 run 中清空，进入 idle 时必为空，不需要检查。
+ */
+bool Scheduler::hasRunnableTasks() {
+    int my_index = t_thread_index;
+    if (my_index >= 0 && my_index < (int)threadContexts_.size() &&
+        threadContexts_[my_index]->has_mail.load(std::memory_order_acquire)) {
+        return true;
+    }
+    for (auto ctx : threadContexts_) {
+        if (!ctx->ready_queue.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 除当前线程外，是否有处于 idle 的线程信箱非空 (近似值，不加锁)
+ * 细节：正在执行任务的线程会在下一轮 run 自己收取信箱，不需要唤醒，也不计入。
+ */
+bool Scheduler::hasMailForOthers() {
+    for (int i = 0; i < (int)threadContexts_.size(); ++i) {
+        ThreadContext *ctx = threadContexts_[i];
+        if (i != t_thread_index && ctx->idle.load(std::memory_order_relaxed) &&
+            ctx->has_mail.load(std::memory_order_acquire)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /**
  * @brief 检查是否可以停止
  * @return true 可以停止, false 不能停止
@@ -520,10 +665,9 @@ void Scheduler::tickle() {
  */
 bool Scheduler::stopping() {
     MutexType::Lock lock(mutex_);
-    // 检查所有线程的队列
+    // 检查所有线程的信箱和窃取队列 (私有队列只有 owner 能看，由 owner 在 run 中清空)
     for(auto ctx : threadContexts_) {
-        MutexType::Lock ctx_lock(ctx->mutex);
-        if(!ctx->public_queue.empty()) return false;
+        if (ctx->has_mail.load(std::memory_order_acquire) || !ctx->ready_queue.empty()) return false;
     }
     return stopping_ && activeThreadCnt_ == 0;
 }
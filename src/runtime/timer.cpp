@@ -1,4 +1,5 @@
 #include "timer.h"
+#include <algorithm>
 #include "utils.h"
 
 namespace monsoon {
@@ -7,49 +8,27 @@ namespace monsoon {
 // Timer 类实现
 // =======================================================
 
-// 仿函数，专门用于定义 std::set 中定时器的排序规则。它决定了红黑树中哪个定时器排在前面（即最先被触发）。
-// 排序规则：
-// 树的左侧：时间早的（即将过期的）。
-// 树的右侧：时间晚的。
-// 节点相同时间：通过内存地址区分，依然挂在树上。
-bool Timer::Comparator::operator()(const Timer::ptr &lhs, const Timer::ptr &rhs) const {
-    if (!lhs && !rhs) return false;
-    if (!lhs) return true;
-    if (!rhs) return false;
-    // 核心逻辑：时间早的排前面
-    if (lhs->next_ < rhs->next_) {
-        return true;
-    }
-    if (rhs->next_ < lhs->next_) {
-        return false;
-    }
-    // 时间相同时，比较指针地址，保证 set 能够存储多个时间相同的定时器
-    return lhs.get() < rhs.get();
-}
-
 // 定时器的初始化入口，负责将用户传入的“相对时间”转换为系统能理解的“绝对时间”
 // 存绝对时间（在第10000秒触发）：无论过了多久，只需要用 next_ - 当前时间，就能算出还要等多久。数据本身不需要频繁修改。
 Timer::Timer(uint64_t ms, std::function<void()> cb, bool recurring, TimerManager *manager)
-    : recurring_(recurring), ms_(ms), cb_(cb), manager_(manager) {
-    next_ = GetElapsedMS() + ms_;
-}
-
-Timer::Timer(uint64_t next) : next_(next) {}
+    : recurring_(recurring), ms_(ms), next_(manager->getNowMS() + ms), cb_(cb), manager_(manager) {}
 
 /**
  * @brief 取消定时器
  * 细节：
- * 1. 必须加锁，因为 timers_ 是共享资源。
- * 2. 只有在 timers_ 中找到自己才算成功。
+ * 1. 必须加锁，因为时间轮是共享资源；先把待插入栈搬进时间轮，保证自己一定挂在某个槽位上。
+ * 2. 摘链是 O(1) 的：定时器自己记录了层级和槽位。
+ * 3. 自引用在出锁后才释放 (self 先于 lock 构造、后于 lock 析构)。
  */
 bool Timer::cancel() {
-    TimerManager::RWMutexType::WriteLock lock(manager_->mutex_);
+    Timer::ptr self;
+    TimerManager::MutexType::Lock lock(manager_->mutex_);
     if (cb_) {
         cb_ = nullptr;
-        // 用“当前 Timer 自己对应的 shared_ptr”作为 key，在 TimerManager 的 timers_ 容器中查找该 Timer，并得到它在容器中的位置（迭代器）
-        auto it = manager_->timers_.find(shared_from_this());
-        if (it != manager_->timers_.end()) {
-            manager_->timers_.erase(it);  // 从容器中移除该 Timer
+        manager_->drainPending();
+        if (level_ != -1) {
+            manager_->unlink(this);
+            self = std::move(self_);
         }
         return true;
     }
@@ -59,24 +38,23 @@ bool Timer::cancel() {
 /**
  * @brief 刷新定时器
  * 细节：
- * 1. std::set 的 key 是 const 的，不能直接修改 next_。
- * 2. 必须先 erase，更新 next_，再 insert。
+ * 1. 从原槽位摘下，更新 next_ 后挂到新槽位，两步都是 O(1)。
+ * 2. Raft 每收到一次 AppendEntries 就会刷新选举定时器，这里是热路径。
  */
 bool Timer::refresh() {
-    TimerManager::RWMutexType::WriteLock lock(manager_->mutex_);
+    TimerManager::MutexType::Lock lock(manager_->mutex_);
     if (!cb_) {
         return false;
     }
-    
-    // 用“当前 Timer 自己对应的 shared_ptr”作为 key，在 TimerManager 的 timers_ 容器中查找该 Timer，并得到它在容器中的位置（迭代器）
-    auto it = manager_->timers_.find(shared_from_this());
-    if (it == manager_->timers_.end()) {
+
+    manager_->drainPending();
+    if (level_ == -1) {
         return false;
     }
-    
-    manager_->timers_.erase(it);  // 先从容器中移除该 Timer
-    next_ = GetElapsedMS() + ms_; // 更新 next_ 为新的触发时间
-    manager_->timers_.insert(shared_from_this()); // 重新插入容器，保持有序性
+
+    manager_->unlink(this);       // 先从原槽位移除该 Timer
+    next_ = manager_->getNowMS() + ms_; // 更新 next_ 为新的触发时间
+    manager_->link(this);         // 挂到新的槽位
     return true;
 }
 
@@ -90,31 +68,30 @@ bool Timer::reset(uint64_t ms, bool from_now) {
     if (ms == ms_ && !from_now) {
         return true;
     }
-    
-    TimerManager::RWMutexType::WriteLock lock(manager_->mutex_);
+
+    TimerManager::MutexType::Lock lock(manager_->mutex_);
     if (!cb_) {
         return false;
     }
-    
-    // 用“当前 Timer 自己对应的 shared_ptr”作为 key，在 TimerManager 的 timers_ 容器中查找该 Timer，并得到它在容器中的位置（迭代器）
-    auto it = manager_->timers_.find(shared_from_this());
-    if (it == manager_->timers_.end()) {
+
+    manager_->drainPending();
+    if (level_ == -1) {
         return false;
     }
-    
-    manager_->timers_.erase(it);
-    
+
+    manager_->unlink(this);
+
     uint64_t start = 0;
     if (from_now) {
-        start = GetElapsedMS();
+        start = manager_->getNowMS();
     } else {
         start = next_ - ms_; // 恢复出上次的理论触发时间
     }
-    
+
     ms_ = ms;
     next_ = start + ms_;
-    
-    manager_->addTimer(shared_from_this(), lock);
+
+    manager_->addTimer(self_, lock);
     return true;
 }
 
@@ -124,23 +101,55 @@ bool Timer::reset(uint64_t ms, bool from_now) {
 
 TimerManager::TimerManager() {
     previousTime_ = GetElapsedMS();
+    base_ = previousTime_;
 }
 
-TimerManager::~TimerManager() {}
+/**
+ * @brief 析构：打断所有定时器的自引用，否则挂在轮上的 Timer 永远不会释放
+ */
+TimerManager::~TimerManager() {
+    std::vector<Timer::ptr> all;
+    MutexType::Lock lock(mutex_);
+    drainPending();
+    takeList(kDueLevel, 0, all);
+    for (uint32_t i = 0; i < kRootSize; ++i) {
+        takeList(0, i, all);
+    }
+    for (int level = 1; level <= kUpperLevels; ++level) {
+        for (uint32_t i = 0; i < kLevelSize; ++i) {
+            takeList(level, i, all);
+        }
+    }
+    for (auto &timer : all) {
+        timer->cb_ = nullptr;
+    }
+}
 
 /**
  * @brief 添加定时器
  * 触发场景：
- * 1. 用户希望在未来某个时间点执行任务时调用。
+ * 1. 用户希望在未来某个时间点执行任务时调用 (例如每个 RPC 的超时定时器)。
  * 2. 这里是 TimerManager 提供给外部的接口，负责创建 Timer 对象，不需要关心内部Timer的创建细节
  * 细节：
- * 1. 创建 Timer 对象并插入 set。
- * 2. 如果新插入的定时器排在最前面，触发 OnTimerInsertedAtFront()。
+ * 1. 不取锁：CAS 压入 pending_ 栈，下一次持锁操作时统一搬进时间轮。
+ * 2. 只有比 epoll_wait 当前超时时刻更早的定时器才需要唤醒 (OnTimerInsertedAtFront)。
  */
 Timer::ptr TimerManager::addTimer(uint64_t ms, std::function<void()> cb, bool recurring) {
     Timer::ptr timer(new Timer(ms, cb, recurring, this));
-    RWMutexType::WriteLock lock(mutex_);
-    addTimer(timer, lock);
+    timer->self_ = timer;
+    timer->level_ = kPendingLevel;
+    uint64_t next = timer->next_; // 入栈后可能被其他线程搬走并修改，先取出来
+
+    Timer *head = pending_.load(std::memory_order_relaxed);
+    do {
+        timer->listNext_ = head;
+    } while (!pending_.compare_exchange_weak(head, timer.get(), std::memory_order_seq_cst,
+                                             std::memory_order_relaxed));
+
+    // 与 getNextTimer 构成 Dekker 式握手：要么这里看到新的 nextWakeup_，要么那边看到 pending_ 非空
+    if (next < nextWakeup_.load(std::memory_order_seq_cst) && !tickled_.exchange(true)) {
+        OnTimerInsertedAtFront();
+    }
     return timer;
 }
 
@@ -172,79 +181,82 @@ Timer::ptr TimerManager::addConditionTimer(uint64_t ms, std::function<void()> cb
 /**
  * @brief 获取下个超时时间
  * 细节：
- * 1. 加读锁即可。
- * 2. 如果已经超时（now >= next），返回 0，告诉 epoll_wait 立即返回。
+ * 1. 先把待插入栈搬进时间轮，再通过第 0 层位图找到最近的非空槽；
+ *    第 0 层这一圈没有定时器时，返回到这一圈结束 (高层下放) 的时间。
+ * 2. 发布 nextWakeup_ 后再检查一次 pending_，防止与并发的 addTimer 互相错过。
+ * 3. 如果已经超时（now >= next），返回 0，告诉 epoll_wait 立即返回。
  */
 uint64_t TimerManager::getNextTimer() {
-    RWMutexType::ReadLock lock(mutex_);
+    MutexType::Lock lock(mutex_);
     tickled_ = false;
-    
-    if (timers_.empty()) {
+
+    uint64_t next_ms = ~0ull;
+    do {
+        drainPending();
+        next_ms = nextExpireTime();
+        nextWakeup_.store(next_ms, std::memory_order_seq_cst);
+    } while (pending_.load(std::memory_order_seq_cst) != nullptr);
+
+    if (next_ms == ~0ull) {
         return ~0ull;
     }
-    
-    const Timer::ptr &nextTimer = *timers_.begin();  // 获取最早的定时器
-    uint64_t now_ms = GetElapsedMS(); // 获取当前启动的毫秒数：系统从启动到当前时刻的毫秒数
 
+    uint64_t now_ms = getNowMS(); // 获取当前启动的毫秒数：系统从启动到当前时刻的毫秒数
     // 计算距离下个定时器触发的时间，如果最早的定时器已经过期，返回0
-    if (now_ms >= nextTimer->next_) {
+    if (now_ms >= next_ms) {
         return 0;
     } else {
-        return nextTimer->next_ - now_ms;
+        return next_ms - now_ms;
     }
 }
 
 /**
  * @brief 收集并处理过期定时器
- * * 改进点：
- * 1. 移除了原版代码中不安全的 lower_bound 查找方式。
- * 2. 改为直接遍历迭代器，安全且逻辑清晰。
+ * * 细节：
+ * 1. 时间轮推进到 now，到期的槽位整条摘下，一次加锁批量取出所有到期定时器。
+ * 2. 回调和过期的 Timer 在出锁后才析构。
  */
 void TimerManager::listExpiredCb(std::vector<std::function<void()>> &cbs) {
-    uint64_t now_ms = GetElapsedMS(); // 获取当前启动的毫秒数：系统从启动到当前时刻的毫秒数
+    uint64_t now_ms = getNowMS(); // 获取当前启动的毫秒数：系统从启动到当前时刻的毫秒数
     std::vector<Timer::ptr> expired;  // 用于存储所有过期的定时器
-    
+
     {
-        RWMutexType::WriteLock lock(mutex_);
-        if (timers_.empty()) {
-            return;
-        }
-        
+        MutexType::Lock lock(mutex_);
+        drainPending();
+
         // 检查时钟倒流，如果倒流则判断全部定时器过期
         bool rollover = detectClockRollover(now_ms);
-        
-        // 如果没倒流，且最早的一个还没到时间，直接返回，不做无用功
-        if (!rollover && ((*timers_.begin())->next_ > now_ms)) {
+        if (count_ == 0) {
+            base_ = std::max(base_, now_ms + 1);
             return;
         }
-        
-        Timer::ptr now_timer(new Timer(now_ms));
-        
-        // 查找所有过期定时器
-        // 迭代器遍历直到找到一个未过期的
-        auto it = timers_.begin();
+
         if (rollover) {
             // 时间倒流了，为了安全，将所有定时器视为过期
-            it = timers_.end();
-        } else {
-            while (it != timers_.end() && (*it)->next_ <= now_ms) {
-                ++it;
+            takeList(kDueLevel, 0, expired);
+            for (uint32_t i = 0; i < kRootSize; ++i) {
+                takeList(0, i, expired);
+            }
+            for (int level = 1; level <= kUpperLevels; ++level) {
+                for (uint32_t i = 0; i < kLevelSize; ++i) {
+                    takeList(level, i, expired);
+                }
             }
+            base_ = now_ms + 1;
+        } else {
+            advance(now_ms, expired);
         }
-        
-        // 批量提取并移除
-        expired.insert(expired.begin(), timers_.begin(), it); // 提取所有过期定时器到 expired 列表
-        timers_.erase(timers_.begin(), it); // 从定时器集合中移除所有过期定时器
-        
-        cbs.reserve(expired.size());
-        
+
+        cbs.reserve(cbs.size() + expired.size());
+
         // 处理提取出来的定时器，放入回调函数列表cbs中
         for (auto &timer : expired) {
             cbs.push_back(timer->cb_);
             if (timer->recurring_) {
-                // 循环定时器任务：计算下次时间重新入队
+                // 循环定时器任务：计算下次时间重新挂回时间轮
                 timer->next_ = now_ms + timer->ms_;
-                timers_.insert(timer);
+                timer->self_ = timer;
+                link(timer.get());
             } else {
                 // 一次性定时任务：清理回调
                 timer->cb_ = nullptr;
@@ -254,22 +266,18 @@ void TimerManager::listExpiredCb(std::vector<std::function<void()>> &cbs) {
 }
 
 /**
- * @brief 添加定时器内部实现
+ * @brief 添加定时器内部实现 (Timer::reset 使用)
  * * 关键逻辑：
- * 1. timers_.insert 返回迭代器。
- * 2. 只有当新插入的定时器排在最前面 (begin)，才需要唤醒 epoll_wait (OnTimerInsertedAtFront)。
+ * 1. 直接挂进时间轮 (调用方已持锁)。
+ * 2. 只有当新定时器早于 epoll_wait 当前的超时时刻，才需要唤醒 (OnTimerInsertedAtFront)。
  * 3. 使用 tickled_ 标志位防止频繁无效唤醒。
  */
-void TimerManager::addTimer(Timer::ptr timer, RWMutexType::WriteLock &lock) {
-    auto it = timers_.insert(timer).first;  // 向set<Timer::ptr, Timer::Comparator> timers_插入定时器并获取定时器的迭代器
-    bool at_front = (it == timers_.begin()) && !tickled_; // 判断是否是最前面的定时器且未被触发过tickle_
-    
-    if (at_front) {
-        tickled_ = true;
-    }
-    
+void TimerManager::addTimer(Timer::ptr timer, MutexType::Lock &lock) {
+    link(timer.get());
+    bool at_front = timer->next_ < nextWakeup_.load(std::memory_order_seq_cst) && !tickled_.exchange(true);
+
     lock.unlock(); // 尽早解锁
-    
+
     // 如果是排在最前面的定时器（定时最短），立刻触发唤醒操作
     if (at_front) {
         OnTimerInsertedAtFront();
@@ -290,9 +298,227 @@ bool TimerManager::detectClockRollover(uint64_t now_ms) {
     return rollover;
 }
 
+uint64_t TimerManager::getNowMS() { return GetElapsedMS(); }
+
 bool TimerManager::hasTimer() {
-    RWMutexType::ReadLock lock(mutex_);
-    return !timers_.empty();
+    MutexType::Lock lock(mutex_);
+    return count_ > 0 || pending_.load(std::memory_order_acquire) != nullptr;
+}
+
+// =======================================================
+// 分层时间轮 (Hierarchical Timing Wheel)
+// =======================================================
+
+TimerManager::TimerList &TimerManager::listOf(int level, uint32_t slot) {
+    if (level == 0) {
+        return root_[slot];
+    }
+    if (level == kDueLevel) {
+        return due_;
+    }
+    return levels_[level - 1][slot];
+}
+
+/**
+ * @brief 挂链
+ * 细节 (与 Linux 经典 timer wheel 相同的分配规则)：
+ * 1. 距离 base_ 不足 256ms：第 0 层，槽位 = next_ 的低 8 位，到点时恰好被扫到；
+ * 2. 否则按距离落到第 1~4 层，槽位取 next_ 对应的 6 位，在低层转完一圈时下放；
+ * 3. 超出约 49 天的按最远距离挂在第 4 层，下放时再按真实时间重新分配。
+ */
+void TimerManager::link(Timer *timer) {
+    uint64_t expires = timer->next_;
+    int level = 0;
+    uint32_t slot = 0;
+
+    if (expires < base_) {
+        level = kDueLevel;
+    } else {
+        uint64_t delta = expires - base_;
+        if (delta < kRootSize) {
+            level = 0;
+            slot = static_cast<uint32_t>(expires & kRootMask);
+        } else {
+            const uint64_t kMaxDelta = (1ull << (kRootBits + kUpperLevels * kLevelBits)) - 1;
+            if (delta > kMaxDelta) {
+                expires = base_ + kMaxDelta;
+                delta = kMaxDelta;
+            }
+            level = 1;
+            while (level < kUpperLevels && delta >= (1ull << (kRootBits + level * kLevelBits))) {
+                ++level;
+            }
+            slot = static_cast<uint32_t>((expires >> (kRootBits + (level - 1) * kLevelBits)) & kLevelMask);
+        }
+    }
+
+    TimerList &list = listOf(level, slot);
+    timer->listPrev_ = nullptr;
+    timer->listNext_ = list.head;
+    if (list.head) {
+        list.head->listPrev_ = timer;
+    }
+    list.head = timer;
+    timer->level_ = level;
+    timer->slot_ = slot;
+    if (level == 0) {
+        rootBitmap_[slot >> 6] |= (1ull << (slot & 63));
+    }
+    ++count_;
+}
+
+void TimerManager::unlink(Timer *timer) {
+    TimerList &list = listOf(timer->level_, timer->slot_);
+    if (timer->listPrev_) {
+        timer->listPrev_->listNext_ = timer->listNext_;
+    } else {
+        list.head = timer->listNext_;
+    }
+    if (timer->listNext_) {
+        timer->listNext_->listPrev_ = timer->listPrev_;
+    }
+    if (timer->level_ == 0 && !list.head) {
+        rootBitmap_[timer->slot_ >> 6] &= ~(1ull << (timer->slot_ & 63));
+    }
+    timer->listPrev_ = timer->listNext_ = nullptr;
+    timer->level_ = -1;
+    --count_;
+}
+
+void TimerManager::takeList(int level, uint32_t slot, std::vector<Timer::ptr> &out) {
+    TimerList &list = listOf(level, slot);
+    Timer *timer = list.head;
+    list.head = nullptr;
+    if (level == 0) {
+        rootBitmap_[slot >> 6] &= ~(1ull << (slot & 63));
+    }
+    while (timer) {
+        Timer *next = timer->listNext_;
+        timer->listPrev_ = timer->listNext_ = nullptr;
+        timer->level_ = -1;
+        --count_;
+        out.push_back(std::move(timer->self_));
+        timer = next;
+    }
+}
+
+/**
+ * @brief 搬运待插入栈
+ * 细节： 时间轮为空时 base_ 不再推进 (线程在 epoll_wait 里无限期阻塞)，先把 base_ 追到当前时刻，
+ * 否则长时间空闲后的新定时器会按到旧 base_ 的距离挂到高层，getNextTimer 返回 0 造成一次空转。
+ */
+void TimerManager::drainPending() {
+    Timer *timer = pending_.exchange(nullptr, std::memory_order_acquire);
+    if (timer && count_ == 0) {
+        base_ = std::max(base_, getNowMS());
+    }
+    while (timer) {
+        Timer *next = timer->listNext_;
+        link(timer);
+        timer = next;
+    }
+}
+
+/**
+ * @brief 下放 (cascade)
+ * 第 0 层转完一圈时，第 1 层当前槽位里的定时器剩余时间都不足 256ms，重新挂链后全部落到第 0 层；
+ * 若第 1 层也转完一圈 (返回的下标为 0)，调用方继续下放更高一层。
+ */
+uint32_t TimerManager::cascade(int level, uint32_t slot) {
+    Timer *timer = levels_[level - 1][slot].head;
+    levels_[level - 1][slot].head = nullptr;
+    while (timer) {
+        Timer *next = timer->listNext_;
+        --count_; // link 会重新计数
+        link(timer);
+        timer = next;
+    }
+    return slot;
+}
+
+/**
+ * @brief 推进时间轮
+ * 细节：
+ * 1. 逐圈推进：每到第 0 层的 0 号槽先做下放，圈内用位图直接跳到下一个非空槽，空 tick 不逐个扫描。
+ * 2. 到期槽位整条链表摘下，批量交给 listExpiredCb。
+ */
+void TimerManager::advance(uint64_t now_ms, std::vector<Timer::ptr> &expired) {
+    takeList(kDueLevel, 0, expired);
+
+    while (base_ <= now_ms) {
+        if (count_ == 0) {
+            base_ = now_ms + 1;
+            break;
+        }
+
+        uint32_t index = static_cast<uint32_t>(base_ & kRootMask);
+        if (index == 0) {
+            uint32_t shift = kRootBits;
+            for (int level = 1; level <= kUpperLevels; ++level, shift += kLevelBits) {
+                if (cascade(level, static_cast<uint32_t>((base_ >> shift) & kLevelMask)) != 0) {
+                    break;
+                }
+            }
+        }
+
+        int slot = findRootSlot(index);
+        if (slot < 0) {
+            // 这一圈剩下的槽都是空的：直接跳到下一圈的起点 (或 now 之后)
+            base_ = std::min((base_ | kRootMask) + 1, now_ms + 1);
+            continue;
+        }
+
+        uint64_t tick = (base_ & ~static_cast<uint64_t>(kRootMask)) + static_cast<uint64_t>(slot);
+        if (tick > now_ms) {
+            base_ = now_ms + 1;
+            break;
+        }
+        takeList(0, static_cast<uint32_t>(slot), expired);
+        base_ = tick + 1;
+    }
+}
+
+uint64_t TimerManager::nextExpireTime() {
+    if (due_.head) {
+        return 0;
+    }
+    if (count_ == 0) {
+        return ~0ull;
+    }
+    uint32_t index = static_cast<uint32_t>(base_ & kRootMask);
+    if (index == 0) {
+        // advance 停在圈首时这一圈还没有下放：待下放的槽位非空就先在圈首醒来，
+        // 否则高层落下来的、就在圈首附近的定时器要等到圈末才被发现
+        uint32_t shift = kRootBits;
+        for (int level = 1; level <= kUpperLevels; ++level, shift += kLevelBits) {
+            uint32_t slot = static_cast<uint32_t>((base_ >> shift) & kLevelMask);
+            if (levels_[level - 1][slot].head) {
+                return base_;
+            }
+            if (slot != 0) {
+                break;
+            }
+        }
+    }
+    int slot = findRootSlot(index);
+    if (slot >= 0) {
+        return (base_ & ~static_cast<uint64_t>(kRootMask)) + static_cast<uint64_t>(slot);
+    }
+    // 这一圈没有定时器：在圈末醒来做一次下放
+    return (base_ | kRootMask) + 1;
+}
+
+int TimerManager::findRootSlot(uint32_t from) const {
+    for (uint32_t word = from >> 6; word < kRootSize / 64; ++word) {
+        uint64_t bits = rootBitmap_[word];
+        if (word == (from >> 6)) {
+            bits &= ~0ull << (from & 63);
+        }
+        if (bits) {
+            return static_cast<int>(word * 64 + __builtin_ctzll(bits));
+        }
+    }
+    return -1;
 }
 
-}  // namespace monsoon
\ No newline at end of file
+}  // namespace monsoon
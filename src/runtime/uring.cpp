@@ -0,0 +1,145 @@
+#include "uring.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace monsoon {
+
+static int sys_io_uring_setup(unsigned entries, io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags, const void *arg,
+                              size_t argsz) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+IoUring::~IoUring() {
+    if (sqes_) {
+        munmap(sqes_, sqesSize_);
+    }
+    if (cqRing_) {
+        munmap(cqRing_, cqRingSize_);
+    }
+    if (sqRing_) {
+        munmap(sqRing_, sqRingSize_);
+    }
+    if (ringFd_ >= 0) {
+        ::close(ringFd_);
+    }
+}
+
+/**
+ * @brief 建环并映射三块共享内存：SQ 环、CQ 环 (新内核与 SQ 环共用一次 mmap)、SQE 数组
+ */
+int IoUring::init(unsigned entries) {
+    io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    // CQ 放大到 8 倍：一个 IO 操作可能连带 LINK_TIMEOUT / POLL_REMOVE 的完成事件
+    p.flags = IORING_SETUP_CQSIZE;
+    p.cq_entries = entries * 8;
+
+    int fd = sys_io_uring_setup(entries, &p);
+    if (fd < 0) {
+        return -errno;
+    }
+    ringFd_ = fd;
+    if (!(p.features & IORING_FEAT_EXT_ARG)) {
+        return -ENOSYS;
+    }
+
+    sqRingSize_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cqRingSize_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = p.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    }
+
+    sqRing_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED) {
+        sqRing_ = nullptr;
+        return -errno;
+    }
+    void *cq_base = sqRing_;
+    if (!single_mmap) {
+        cqRing_ = mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqRing_ == MAP_FAILED) {
+            cqRing_ = nullptr;
+            return -errno;
+        }
+        cq_base = cqRing_;
+    }
+
+    sqesSize_ = p.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        return -errno;
+    }
+    sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+    char *sq = static_cast<char *>(sqRing_);
+    sqHead_ = reinterpret_cast<unsigned *>(sq + p.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned *>(sq + p.sq_off.tail);
+    sqMask_ = *reinterpret_cast<unsigned *>(sq + p.sq_off.ring_mask);
+    sqEntries_ = *reinterpret_cast<unsigned *>(sq + p.sq_off.ring_entries);
+    // SQ 间接数组按下标一一对应，之后只需推进 tail
+    unsigned *array = reinterpret_cast<unsigned *>(sq + p.sq_off.array);
+    for (unsigned i = 0; i < sqEntries_; ++i) {
+        array[i] = i;
+    }
+    sqeTail_ = *sqTail_;
+
+    char *cq = static_cast<char *>(cq_base);
+    cqHead_ = reinterpret_cast<unsigned *>(cq + p.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned *>(cq + p.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned *>(cq + p.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(cq + p.cq_off.cqes);
+    return 0;
+}
+
+io_uring_sqe *IoUring::getSqe() {
+    unsigned head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+    if (sqeTail_ - head >= sqEntries_) {
+        return nullptr;
+    }
+    io_uring_sqe *sqe = &sqes_[sqeTail_ & sqMask_];
+    ++sqeTail_;
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+unsigned IoUring::commit() {
+    __atomic_store_n(sqTail_, sqeTail_, __ATOMIC_RELEASE);
+    return sqeTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+}
+
+int IoUring::enter(unsigned to_submit, unsigned min_complete, int timeout_ms) {
+    unsigned flags = 0;
+    io_uring_getevents_arg arg;
+    __kernel_timespec ts;
+    const void *argp = nullptr;
+    size_t argsz = 0;
+
+    if (min_complete > 0) {
+        flags |= IORING_ENTER_GETEVENTS;
+        if (timeout_ms >= 0) {
+            ts.tv_sec = timeout_ms / 1000;
+            ts.tv_nsec = (long long)(timeout_ms % 1000) * 1000000;
+            memset(&arg, 0, sizeof(arg));
+            arg.ts = (uint64_t)(uintptr_t)&ts;
+            flags |= IORING_ENTER_EXT_ARG;
+            argp = &arg;
+            argsz = sizeof(arg);
+        }
+    }
+
+    int ret = sys_io_uring_enter(ringFd_, to_submit, min_complete, flags, argp, argsz);
+    return ret < 0 ? -errno : ret;
+}
+
+}  // namespace monsoon
@@ -0,0 +1,90 @@
+#ifndef SKIPLIST_ARENA_H
+#define SKIPLIST_ARENA_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+/**
+ * @brief 跳表节点使用的 bump-pointer 内存池
+ * @details
+ * 节点按块 (kBlockSize) 批量向系统申请，分配只是移动指针，没有 malloc 的头部开销和锁；
+ * 单个对象不单独释放，整块内存在 reset() / 析构时统一归还。
+ * 跳表删除节点时由调用方把空间挂到按层高分桶的空闲链表上复用 (见 SkipList::destroy_node)。
+ *
+ * 非线程安全：SkipList 只在持有独占锁时分配。
+ */
+class Arena {
+ public:
+  Arena() : alloc_ptr_(nullptr), alloc_bytes_remaining_(0), memory_usage_(0) {}
+
+  ~Arena() { reset(); }
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  // 按 align 对齐分配 bytes 字节 (align 须为 2 的幂且不超过 max_align_t)
+  char *allocate_aligned(size_t bytes, size_t align = alignof(std::max_align_t)) {
+    size_t current_mod = reinterpret_cast<uintptr_t>(alloc_ptr_) & (align - 1);
+    size_t slop = (current_mod == 0 ? 0 : align - current_mod);
+    size_t needed = bytes + slop;
+    char *result;
+    if (needed <= alloc_bytes_remaining_) {
+      result = alloc_ptr_ + slop;
+      alloc_ptr_ += needed;
+      alloc_bytes_remaining_ -= needed;
+    } else {
+      // 新块由 operator new 分配，天然满足 max_align_t 对齐
+      result = allocate_fallback(bytes);
+    }
+    assert((reinterpret_cast<uintptr_t>(result) & (align - 1)) == 0);
+    return result;
+  }
+
+  // 释放所有块，之前分配出去的指针全部失效
+  void reset() {
+    for (char *block : blocks_) {
+      ::operator delete(block);
+    }
+    blocks_.clear();
+    alloc_ptr_ = nullptr;
+    alloc_bytes_remaining_ = 0;
+    memory_usage_ = 0;
+  }
+
+  // 已向系统申请的总字节数
+  size_t memory_usage() const { return memory_usage_; }
+
+ private:
+  static constexpr size_t kBlockSize = 64 * 1024;
+
+  char *allocate_fallback(size_t bytes) {
+    if (bytes > kBlockSize / 4) {
+      // 大对象单独成块，避免浪费当前块的剩余空间
+      return allocate_new_block(bytes);
+    }
+    alloc_ptr_ = allocate_new_block(kBlockSize);
+    alloc_bytes_remaining_ = kBlockSize;
+
+    char *result = alloc_ptr_;
+    alloc_ptr_ += bytes;
+    alloc_bytes_remaining_ -= bytes;
+    return result;
+  }
+
+  char *allocate_new_block(size_t block_bytes) {
+    char *result = static_cast<char *>(::operator new(block_bytes));
+    blocks_.push_back(result);
+    memory_usage_ += block_bytes + sizeof(char *);
+    return result;
+  }
+
+  char *alloc_ptr_;
+  size_t alloc_bytes_remaining_;
+  std::vector<char *> blocks_;
+  size_t memory_usage_;
+};
+
+#endif  // SKIPLIST_ARENA_H
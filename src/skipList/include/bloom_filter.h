@@ -0,0 +1,99 @@
+#ifndef SKIPLIST_BLOOM_FILTER_H
+#define SKIPLIST_BLOOM_FILTER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+/**
+ * @file bloom_filter.h
+ * @brief 分块 (blocked) bloom 过滤器
+ * @details
+ * 每个 key 的全部 k 个 bit 都落在同一个 512 bit (一条 cache line) 的块里：
+ * 先用哈希的高 32 位选块，再用低 32 位双重哈希出块内的 k 个位置。一次判断只碰一条 cache line，
+ * 代价比一次跳表查找 (十几次随机指针跳转) 小一个数量级；误判率比经典 bloom 略高 (10 bit/key 约 1%~2%)。
+ *
+ * 本身不加锁：由持有者保证 add / clear 与 may_contain 不并发 (SkipList 在写锁下 add，读锁下判断)。
+ * 只支持添加，删除的 key 留下的 bit 只会增加误判，由持有者按需重建。
+ */
+
+constexpr int kReadFilterBitsPerKey = 10;
+
+// 64 位哈希的终结混合 (murmur3 fmix64)：std::hash 对整数是恒等映射，不能直接拿来选块
+inline uint64_t skiplist_mix_hash(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+class BlockedBloomFilter {
+ public:
+  BlockedBloomFilter(size_t expected_keys, int bits_per_key = kReadFilterBitsPerKey)
+      : capacity_(std::max<size_t>(expected_keys, 64)) {
+    bits_per_key = std::max(1, bits_per_key);
+    // 块内的 bit 比整个过滤器更 "拥挤"，k 取比经典公式 (0.69 * bits_per_key) 略小
+    k_ = std::max(1, std::min(16, static_cast<int>(bits_per_key * 0.6)));
+    size_t bits = capacity_ * static_cast<size_t>(bits_per_key);
+    num_blocks_ = std::max<size_t>(1, (bits + kBlockBits - 1) / kBlockBits);
+    blocks_.reset(new Block[num_blocks_]);
+    clear();
+  }
+
+  void add(uint64_t hash) {
+    Block &block = blocks_[block_index(hash)];
+    uint32_t h = static_cast<uint32_t>(hash);
+    uint32_t delta = (h >> 17) | (h << 15);
+    for (int i = 0; i < k_; ++i) {
+      uint32_t bit = h & (kBlockBits - 1);
+      block.words[bit >> 6] |= 1ull << (bit & 63);
+      h += delta;
+    }
+  }
+
+  // false 表示 key 一定没有被 add 过
+  bool may_contain(uint64_t hash) const {
+    const Block &block = blocks_[block_index(hash)];
+    uint32_t h = static_cast<uint32_t>(hash);
+    uint32_t delta = (h >> 17) | (h << 15);
+    for (int i = 0; i < k_; ++i) {
+      uint32_t bit = h & (kBlockBits - 1);
+      if ((block.words[bit >> 6] & (1ull << (bit & 63))) == 0) {
+        return false;
+      }
+      h += delta;
+    }
+    return true;
+  }
+
+  void clear() {
+    memset(blocks_.get(), 0, num_blocks_ * sizeof(Block));
+  }
+
+  // 按这个 key 数设计的大小：实际 key 数明显超过它之后误判率迅速上升，应当重建
+  size_t capacity() const { return capacity_; }
+  size_t memory_bytes() const { return num_blocks_ * sizeof(Block); }
+
+ private:
+  static constexpr uint32_t kBlockBits = 512;
+
+  struct alignas(64) Block {
+    uint64_t words[kBlockBits / 64];
+  };
+
+  // 高 32 位映射到 [0, num_blocks_)：乘法代替取模
+  size_t block_index(uint64_t hash) const {
+    return static_cast<size_t>(((hash >> 32) * static_cast<uint64_t>(num_blocks_)) >> 32);
+  }
+
+  size_t capacity_;
+  int k_;
+  size_t num_blocks_;
+  std::unique_ptr<Block[]> blocks_;
+};
+
+#endif  // SKIPLIST_BLOOM_FILTER_H
@@ -0,0 +1,69 @@
+#ifndef SKIPLIST_KEY_COMPARE_H
+#define SKIPLIST_KEY_COMPARE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @file key_compare.h
+ * @brief SkipList<K, V, Compare> 的 key 比较器与相关 trait
+ * @details
+ * SkipList 只通过 Compare 比较 key (默认 std::less<K>)：
+ * 1. Compare 带 is_transparent 时，search_element / Iterator::seek 接受其他类型的 key
+ *    (例如拿 std::string_view 查 std::string 的表)，查找路径上不构造 K、不分配内存。
+ * 2. Compare 提供 static uint32_t prefix(key) 时，节点创建时缓存 key 的前缀。前缀的整数大小必须与
+ *    完整比较一致 (前缀不等则大小已定，相等再完整比较)，查找路径上多数节点一次整数比较就能越过。
+ * bloom 过滤器按 SkipListKeyHash<K> 哈希：异构 key 与等值的 K 必须得到相同的哈希值。
+ */
+
+/**
+ * \brief std::string key 的比较器：透明 (接受一切可转换为 std::string_view 的 key) + 4 字节前缀
+ * \details 前缀只在 key 的前几个字节有区分度时有效；大量 key 共享同一个长前缀 (如 "user") 时
+ * 退化为每次一次整数比较加一次完整比较，结果仍然正确。
+ */
+struct StringKeyCompare {
+  using is_transparent = void;
+
+  bool operator()(std::string_view a, std::string_view b) const { return a < b; }
+
+  // 前 4 个字节按大端拼成整数，不足补 0：与按 unsigned char 的字典序单调一致
+  // (短 key 补的 0 只可能让前缀相等，不会颠倒大小，相等时由完整比较裁决)
+  static uint32_t prefix(std::string_view key) {
+    uint32_t p = 0;
+    size_t n = key.size() < 4 ? key.size() : 4;
+    for (size_t i = 0; i < 4; ++i) {
+      p <<= 8;
+      if (i < n) p |= static_cast<unsigned char>(key[i]);
+    }
+    return p;
+  }
+};
+
+// Compare 是否提供 key 前缀 (static uint32_t prefix(const K &))
+template <typename Compare, typename K, typename = void>
+struct KeyComparePrefix : std::false_type {};
+
+template <typename Compare, typename K>
+struct KeyComparePrefix<Compare, K, std::void_t<decltype(Compare::prefix(std::declval<const K &>()))>>
+    : std::true_type {};
+
+/**
+ * \brief bloom 过滤器使用的 key 哈希；异构查找的 key 按同一个函数哈希
+ * 通用版本把异构 key 转换成 K 再哈希 (结果正确，但有一次构造)；std::string 按 std::string_view 哈希，不分配。
+ */
+template <typename K>
+struct SkipListKeyHash {
+  size_t operator()(const K &key) const { return std::hash<K>{}(key); }
+};
+
+template <>
+struct SkipListKeyHash<std::string> {
+  size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+};
+
+#endif  // SKIPLIST_KEY_COMPARE_H
@@ -0,0 +1,515 @@
+#ifndef LOCK_FREE_SKIPLIST_H
+#define LOCK_FREE_SKIPLIST_H
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "epoch.h"
+#include "skipList.h"  // 复用 SkipListDump，保证两种引擎的快照格式互通
+
+/**
+ * @file lockFreeSkipList.h
+ * @brief 无锁跳表引擎 (读多写少场景)
+ * @details
+ * 与 SkipList<K,V> 提供相同的公开接口，区别在于并发控制：
+ * - SkipList：一把 std::shared_mutex，读共享/写独占，读线程在同一条 cache line 上争抢锁计数，
+ *   写操作会阻塞所有读。
+ * - LockFreeSkipList：每层 forward 指针都是 std::atomic，插入/删除通过 CAS 完成，
+ *   读路径不写任何共享内存 (只 pin 住线程本地的 epoch 记录)，因此 Get 吞吐随核数线性扩展，
+ *   写操作也不会阻塞读。
+ *
+ * 删除采用 "先逻辑删除、再物理摘链" 的经典做法 (Harris / Fraser)：
+ * 1. 把节点各层 forward 指针的最低位置 1 (mark)，从高层到第 0 层；第 0 层 mark 成功即为删除的线性化点；
+ * 2. 任何遍历到被 mark 节点的线程都会顺手用 CAS 把它从前驱上摘下；
+ * 3. 节点完全不可达后交给 EpochManager::retire()，宽限期结束再释放，杜绝读线程 use-after-free。
+ *
+ * 值的更新 (insert_set_element) 通过原子替换 V* 实现，旧值同样走 EBR 延迟释放。
+ */
+
+template <typename K, typename V>
+class LockFreeNode {
+ public:
+  LockFreeNode(const K &k, V *v, int level) : key(k), value(v), node_level(level) {
+    forward = new std::atomic<LockFreeNode<K, V> *>[level + 1];
+    for (int i = 0; i <= level; ++i) {
+      forward[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  ~LockFreeNode() {
+    delete value.load(std::memory_order_relaxed);
+    delete[] forward;
+  }
+
+  K get_key() const { return key; }
+
+  V get_value() const { return *value.load(std::memory_order_acquire); }
+
+  const K key;
+  std::atomic<V *> value;
+  int node_level;
+
+  // 每层的后继指针，最低位为删除标记
+  std::atomic<LockFreeNode<K, V> *> *forward;
+
+  // 节点生命周期引用：插入线程完成各层链接释放一次，删除线程 mark 成功释放一次，
+  // 减到 0 的线程负责最终摘链并 retire，避免插入线程仍在链接高层时节点被提前回收
+  std::atomic<int> refs{2};
+};
+
+template <typename K, typename V>
+class LockFreeSkipList {
+  using NodePtr = LockFreeNode<K, V> *;
+
+ public:
+  /**
+   * \brief 有序迭代器：seek 到 lower_bound 后沿第 0 层顺序遍历，自动跳过已逻辑删除的节点
+   * 持有 EpochGuard 而不是锁，存活期间不会阻塞任何写操作；
+   * 看到的是弱一致视图 (遍历过程中并发插入的 key 可能可见也可能不可见)。
+   * 注意：迭代器必须在创建它的线程内使用和销毁。
+   */
+  class Iterator {
+   public:
+    explicit Iterator(LockFreeSkipList<K, V> *list) : _list(list), _node(nullptr) {}
+
+    bool valid() const { return _node != nullptr; }
+    void seek(const K &key) { _node = _list->find_greater_or_equal(key); }
+    void seek_to_first() { _node = _list->next_live(_list->_header); }
+    void next() { _node = _list->next_live(_node); }
+    K key() const { return _node->get_key(); }
+    V value() const { return _node->get_value(); }
+
+   private:
+    LockFreeSkipList<K, V> *_list;
+    EpochGuard _guard;
+    NodePtr _node;
+  };
+
+  LockFreeSkipList(int);
+  ~LockFreeSkipList();
+  int get_random_level();
+  NodePtr create_node(const K &key, const V &value, int level);
+  int insert_element(const K &key, const V &value);
+  void display_list();
+  bool search_element(const K &key, V &value);
+  void delete_element(const K &key);
+  void insert_set_element(const K &key, const V &value);
+  bool scan(const K &start_key, int limit, std::vector<std::pair<K, V>> &out, K *next_key = nullptr);
+  bool scan(const K &start_key, const K &end_key, int limit, std::vector<std::pair<K, V>> &out,
+            K *next_key = nullptr);
+  std::string dump_file();
+  void load_file(const std::string &dumpStr);
+  void clear();
+  int size();
+
+ private:
+  static bool is_marked(NodePtr p) { return (reinterpret_cast<uintptr_t>(p) & 1) != 0; }
+  static NodePtr marked(NodePtr p) { return reinterpret_cast<NodePtr>(reinterpret_cast<uintptr_t>(p) | 1); }
+  static NodePtr unmarked(NodePtr p) { return reinterpret_cast<NodePtr>(reinterpret_cast<uintptr_t>(p) & ~uintptr_t(1)); }
+
+  bool find(const K &key, NodePtr *preds, NodePtr *succs);
+  NodePtr find_greater_or_equal(const K &key);
+  NodePtr next_live(NodePtr node);
+  int insert_impl(const K &key, const V &value, bool overwrite);
+  void link_upper_levels(NodePtr node, int top, NodePtr *preds, NodePtr *succs);
+  void release_ref(NodePtr node);
+  bool scan_impl(const K &start_key, const K *end_key, int limit, std::vector<std::pair<K, V>> &out,
+                 K *next_key);
+
+ private:
+  // Maximum level of the skip list
+  int _max_level;
+
+  // 当前使用到的最高层，只增不减 (空的高层只会让查找多走几步 nullptr 判断)
+  std::atomic<int> _skip_list_level;
+
+  // pointer to header node
+  NodePtr _header;
+
+  // skiplist current element count
+  std::atomic<int> _element_count;
+};
+
+template <typename K, typename V>
+LockFreeSkipList<K, V>::LockFreeSkipList(int max_level)
+    : _max_level(max_level), _skip_list_level(0), _element_count(0) {
+  _header = new LockFreeNode<K, V>(K(), nullptr, _max_level);
+}
+
+template <typename K, typename V>
+LockFreeSkipList<K, V>::~LockFreeSkipList() {
+  // 析构时不允许再有并发访问者：第 0 层仍挂着的节点 (包括已 mark 未摘链的) 直接释放，
+  // 已经 retire 的节点由 EpochManager 负责
+  NodePtr current = unmarked(_header->forward[0].load(std::memory_order_acquire));
+  while (current != nullptr) {
+    NodePtr next = unmarked(current->forward[0].load(std::memory_order_relaxed));
+    delete current;
+    current = next;
+  }
+  delete _header;
+}
+
+template <typename K, typename V>
+LockFreeNode<K, V> *LockFreeSkipList<K, V>::create_node(const K &k, const V &v, int level) {
+  return new LockFreeNode<K, V>(k, new V(v), level);
+}
+
+// 获取随机层高，与 SkipList 保持一致
+template <typename K, typename V>
+int LockFreeSkipList<K, V>::get_random_level() {
+  static thread_local std::mt19937 generator(std::random_device{}());
+  static thread_local std::uniform_int_distribution<int> distribution(0, 1);
+
+  int k = 1;
+  while (distribution(generator) % 2) {
+    k++;
+  }
+  k = (k < _max_level) ? k : _max_level;
+  return k;
+}
+
+/**
+ * \brief 自顶向下定位 key 在每一层的前驱/后继，并顺手摘掉路过的已删除节点
+ * \return 第 0 层是否存在未删除的 key
+ * 调用方必须处于 EpochGuard 保护之下
+ */
+template <typename K, typename V>
+bool LockFreeSkipList<K, V>::find(const K &key, NodePtr *preds, NodePtr *succs) {
+retry:
+  NodePtr pred = _header;
+  for (int i = _max_level; i >= 0; i--) {
+    NodePtr curr = unmarked(pred->forward[i].load(std::memory_order_acquire));
+    while (curr != nullptr) {
+      NodePtr succ = curr->forward[i].load(std::memory_order_acquire);
+      // curr 在本层已被逻辑删除：尝试从 pred 上摘除；pred 自身被删或已变化则从头再来
+      while (is_marked(succ)) {
+        NodePtr expected = curr;
+        if (!pred->forward[i].compare_exchange_strong(expected, unmarked(succ), std::memory_order_acq_rel)) {
+          goto retry;
+        }
+        curr = unmarked(succ);
+        if (curr == nullptr) break;
+        succ = curr->forward[i].load(std::memory_order_acquire);
+      }
+      if (curr == nullptr) break;
+
+      if (curr->key < key) {
+        pred = curr;
+        curr = unmarked(succ);
+      } else {
+        break;
+      }
+    }
+    preds[i] = pred;
+    succs[i] = curr;
+  }
+  return succs[0] != nullptr && !(key < succs[0]->key);
+}
+
+// 只读定位：第一个未删除且 key >= 给定 key 的节点 (lower_bound)，不做摘链，不写共享内存
+template <typename K, typename V>
+LockFreeNode<K, V> *LockFreeSkipList<K, V>::find_greater_or_equal(const K &key) {
+  NodePtr pred = _header;
+  NodePtr curr = nullptr;
+  for (int i = _skip_list_level.load(std::memory_order_acquire); i >= 0; i--) {
+    curr = unmarked(pred->forward[i].load(std::memory_order_acquire));
+    while (curr != nullptr) {
+      NodePtr succ = curr->forward[i].load(std::memory_order_acquire);
+      if (is_marked(succ)) {
+        curr = unmarked(succ);  // 跳过本层已删除节点
+      } else if (curr->key < key) {
+        pred = curr;
+        curr = unmarked(succ);
+      } else {
+        break;
+      }
+    }
+  }
+  return curr;
+}
+
+// 第 0 层上 node 之后的第一个未删除节点
+template <typename K, typename V>
+LockFreeNode<K, V> *LockFreeSkipList<K, V>::next_live(NodePtr node) {
+  NodePtr curr = unmarked(node->forward[0].load(std::memory_order_acquire));
+  while (curr != nullptr && is_marked(curr->forward[0].load(std::memory_order_acquire))) {
+    curr = unmarked(curr->forward[0].load(std::memory_order_acquire));
+  }
+  return curr;
+}
+
+template <typename K, typename V>
+int LockFreeSkipList<K, V>::insert_impl(const K &key, const V &value, bool overwrite) {
+  EpochGuard guard;
+  NodePtr preds[_max_level + 1];
+  NodePtr succs[_max_level + 1];
+
+  int top = get_random_level();
+  NodePtr node = nullptr;
+
+  while (true) {
+    if (find(key, preds, succs)) {
+      if (overwrite) {
+        // 原位替换值，旧值延迟释放 (可能仍有读线程在拷贝它)
+        V *old = succs[0]->value.exchange(new V(value), std::memory_order_acq_rel);
+        EpochManager::GetInstance().retire(old);
+      }
+      delete node;  // 可能是上一轮 CAS 失败时创建的节点，还未发布
+      return 1;
+    }
+
+    if (node == nullptr) {
+      node = create_node(key, value, top);
+    }
+    for (int i = 0; i <= top; ++i) {
+      node->forward[i].store(succs[i], std::memory_order_relaxed);
+    }
+
+    // 第 0 层链接成功即为插入的线性化点
+    NodePtr expected = succs[0];
+    if (preds[0]->forward[0].compare_exchange_strong(expected, node, std::memory_order_acq_rel)) {
+      break;
+    }
+  }
+
+  _element_count.fetch_add(1, std::memory_order_relaxed);
+
+  int level = _skip_list_level.load(std::memory_order_relaxed);
+  while (top > level && !_skip_list_level.compare_exchange_weak(level, top, std::memory_order_acq_rel)) {
+  }
+
+  link_upper_levels(node, top, preds, succs);
+  return 0;
+}
+
+// 逐层链接高层指针；节点在链接过程中被并发删除时放弃剩余层
+template <typename K, typename V>
+void LockFreeSkipList<K, V>::link_upper_levels(NodePtr node, int top, NodePtr *preds, NodePtr *succs) {
+  for (int i = 1; i <= top; ++i) {
+    while (true) {
+      NodePtr cur = node->forward[i].load(std::memory_order_acquire);
+      if (is_marked(cur)) {
+        release_ref(node);
+        return;
+      }
+      // 先把节点自己的后继修正为最新的 succ；失败只可能是被 mark 了
+      if (cur != succs[i] &&
+          !node->forward[i].compare_exchange_strong(cur, succs[i], std::memory_order_acq_rel)) {
+        release_ref(node);
+        return;
+      }
+      NodePtr expected = succs[i];
+      if (preds[i]->forward[i].compare_exchange_strong(expected, node, std::memory_order_acq_rel)) {
+        break;
+      }
+      // 前驱变化，重新定位；若节点已不在第 0 层 (已被删除并摘链) 则不再链接
+      find(node->key, preds, succs);
+      if (succs[0] != node) {
+        release_ref(node);
+        return;
+      }
+    }
+    // 链接期间被 mark：可能删除线程的摘链已经扫过这一层，这里补一次
+    if (is_marked(node->forward[i].load(std::memory_order_acquire))) {
+      find(node->key, preds, succs);
+      break;
+    }
+  }
+  release_ref(node);
+}
+
+// 最后一个释放引用的线程负责摘链并 retire
+template <typename K, typename V>
+void LockFreeSkipList<K, V>::release_ref(NodePtr node) {
+  if (node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    NodePtr preds[_max_level + 1];
+    NodePtr succs[_max_level + 1];
+    find(node->key, preds, succs);  // 摘掉所有层上的残留链接
+    EpochManager::GetInstance().retire(node);
+  }
+}
+
+template <typename K, typename V>
+int LockFreeSkipList<K, V>::insert_element(const K &key, const V &value) {
+  return insert_impl(key, value, false);
+}
+
+/**
+ * \brief 插入元素。如果键已存在，则更新其值 (Upsert 语义)
+ */
+template <typename K, typename V>
+void LockFreeSkipList<K, V>::insert_set_element(const K &key, const V &value) {
+  insert_impl(key, value, true);
+}
+
+template <typename K, typename V>
+bool LockFreeSkipList<K, V>::search_element(const K &key, V &value) {
+  EpochGuard guard;
+  NodePtr node = find_greater_or_equal(key);
+  if (node != nullptr && !(key < node->key)) {
+    value = node->get_value();
+    return true;
+  }
+  return false;
+}
+
+template <typename K, typename V>
+void LockFreeSkipList<K, V>::delete_element(const K &key) {
+  EpochGuard guard;
+  NodePtr preds[_max_level + 1];
+  NodePtr succs[_max_level + 1];
+
+  if (!find(key, preds, succs)) {
+    return;
+  }
+  NodePtr victim = succs[0];
+
+  // 1. 从高层到第 1 层逐层打标记 (幂等，多个删除者并发执行也安全)
+  for (int i = victim->node_level; i >= 1; i--) {
+    NodePtr succ = victim->forward[i].load(std::memory_order_acquire);
+    while (!is_marked(succ)) {
+      victim->forward[i].compare_exchange_weak(succ, marked(succ), std::memory_order_acq_rel);
+    }
+  }
+
+  // 2. 第 0 层打标记：只有一个线程能成功，成功者完成删除
+  NodePtr succ = victim->forward[0].load(std::memory_order_acquire);
+  while (true) {
+    if (is_marked(succ)) {
+      return;  // 被其他线程抢先删除
+    }
+    if (victim->forward[0].compare_exchange_weak(succ, marked(succ), std::memory_order_acq_rel)) {
+      break;
+    }
+  }
+
+  _element_count.fetch_sub(1, std::memory_order_relaxed);
+  release_ref(victim);
+}
+
+template <typename K, typename V>
+bool LockFreeSkipList<K, V>::scan_impl(const K &start_key, const K *end_key, int limit,
+                                       std::vector<std::pair<K, V>> &out, K *next_key) {
+  EpochGuard guard;
+  NodePtr node = find_greater_or_equal(start_key);
+  int count = 0;
+
+  while (node != nullptr) {
+    if (end_key != nullptr && !(node->key < *end_key)) {
+      return false;
+    }
+    if (limit > 0 && count >= limit) {
+      if (next_key != nullptr) {
+        *next_key = node->key;
+      }
+      return true;
+    }
+    out.emplace_back(node->key, node->get_value());
+    ++count;
+    node = next_live(node);
+  }
+  return false;
+}
+
+/**
+ * \brief 范围扫描 [start_key, +inf)，语义与 SkipList::scan 相同，但不持锁、结果为弱一致视图
+ */
+template <typename K, typename V>
+bool LockFreeSkipList<K, V>::scan(const K &start_key, int limit, std::vector<std::pair<K, V>> &out,
+                                  K *next_key) {
+  return scan_impl(start_key, nullptr, limit, out, next_key);
+}
+
+template <typename K, typename V>
+bool LockFreeSkipList<K, V>::scan(const K &start_key, const K &end_key, int limit,
+                                  std::vector<std::pair<K, V>> &out, K *next_key) {
+  return scan_impl(start_key, &end_key, limit, out, next_key);
+}
+
+template <typename K, typename V>
+void LockFreeSkipList<K, V>::display_list() {
+  EpochGuard guard;
+  std::cout << "\n*****Lock-Free Skip List*****"
+            << "\n";
+  for (int i = 0; i <= _skip_list_level.load(std::memory_order_acquire); i++) {
+    NodePtr node = unmarked(_header->forward[i].load(std::memory_order_acquire));
+    std::cout << "Level " << i << ": ";
+    while (node != nullptr) {
+      NodePtr next = node->forward[i].load(std::memory_order_acquire);
+      if (!is_marked(next)) {
+        std::cout << node->key << ":" << node->get_value() << ";";
+      }
+      node = unmarked(next);
+    }
+    std::cout << std::endl;
+  }
+}
+
+/**
+ * \brief 导出快照，格式与 SkipList::dump_file 完全一致 (两种引擎可互相 load)
+ * 无锁实现下导出的是遍历期间的弱一致视图；Raft 快照场景下调用方在 apply 线程内调用，
+ * 此时没有并发写入，得到的就是精确快照。
+ */
+template <typename K, typename V>
+std::string LockFreeSkipList<K, V>::dump_file() {
+  SkipListDump<K, V> dumper;
+  {
+    EpochGuard guard;
+    for (NodePtr node = next_live(_header); node != nullptr; node = next_live(node)) {
+      dumper.keyDumpVt_.emplace_back(node->key);
+      dumper.valDumpVt_.emplace_back(node->get_value());
+    }
+  }
+
+  std::stringstream ss;
+  boost::archive::binary_oarchive oa(ss);
+  oa << dumper;
+  return ss.str();
+}
+
+// 替换语义：先清空再逐个插入；期间并发读可能看到部分数据
+template <typename K, typename V>
+void LockFreeSkipList<K, V>::load_file(const std::string &dumpStr) {
+  clear();
+  if (dumpStr.empty()) {
+    return;
+  }
+
+  SkipListDump<K, V> dumper;
+  std::stringstream iss(dumpStr);
+  boost::archive::binary_iarchive ia(iss);
+  ia >> dumper;
+
+  for (size_t i = 0; i < dumper.keyDumpVt_.size(); ++i) {
+    insert_element(dumper.keyDumpVt_[i], dumper.valDumpVt_[i]);
+  }
+}
+
+// 逐个删除首元素：每次删除都走正常的无锁路径，因此与并发读写共存也是安全的
+template <typename K, typename V>
+void LockFreeSkipList<K, V>::clear() {
+  while (true) {
+    K key;
+    {
+      EpochGuard guard;
+      NodePtr first = next_live(_header);
+      if (first == nullptr) {
+        break;
+      }
+      key = first->key;
+    }
+    delete_element(key);
+  }
+}
+
+template <typename K, typename V>
+int LockFreeSkipList<K, V>::size() {
+  return _element_count.load(std::memory_order_relaxed);
+}
+
+#endif  // LOCK_FREE_SKIPLIST_H
@@ -0,0 +1,180 @@
+#ifndef SKIPLIST_READ_CACHE_H
+#define SKIPLIST_READ_CACHE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "bloom_filter.h"
+
+/**
+ * @file read_cache.h
+ * @brief 分片 CLOCK 热点 value 缓存
+ * @details
+ * 1. 分片：按 key 哈希分到 2 的幂个分片，每个分片一把互斥锁，读线程之间基本不争用。
+ * 2. CLOCK 而不是 LRU：命中只置一个引用位，不移动链表节点；淘汰时指针绕环一圈，
+ *    跳过 (并清除) 最近被访问过的槽位，效果接近 LRU，命中路径的写操作少得多。
+ * 3. 只缓存存在的 key (不存在的 key 交给 bloom 过滤器)；一致性由使用方保证：
+ *    SkipList 在写锁下对被修改的 key 调用 erase，在读锁下 put，写方不会与 put 交错。
+ */
+
+constexpr size_t kReadCacheShards = 16;
+
+struct ReadCacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t inserts = 0;
+  uint64_t evictions = 0;
+  size_t entries = 0;
+};
+
+template <typename K, typename V, typename Hash = std::hash<K>>
+class ShardedClockCache {
+ public:
+  ShardedClockCache(size_t capacity, size_t shards = kReadCacheShards) {
+    size_t n = 1;
+    while (n < std::max<size_t>(shards, 1)) n <<= 1;
+    num_shards_ = n;
+    shards_.reset(new Shard[num_shards_]);
+    size_t per_shard = std::max<size_t>(1, (capacity + num_shards_ - 1) / num_shards_);
+    for (size_t i = 0; i < num_shards_; ++i) {
+      shards_[i].slots.resize(per_shard);
+      shards_[i].index.reserve(per_shard);
+    }
+  }
+
+  bool get(const K &key, V &value) {
+    Shard &shard = shard_for(key);
+    {
+      // 计数放在分片里、由分片锁保护：命中路径不额外争用一条全局共享的 cache line
+      std::lock_guard<std::mutex> lock(shard.mtx);
+      auto it = shard.index.find(key);
+      if (it != shard.index.end()) {
+        Slot &slot = shard.slots[it->second];
+        slot.referenced = true;
+        value = slot.value;
+        shard.hits++;
+        return true;
+      }
+      shard.misses++;
+    }
+    return false;
+  }
+
+  void put(const K &key, const V &value) {
+    Shard &shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+      shard.slots[it->second].value = value;
+      return;
+    }
+    size_t pos = take_slot(shard);
+    Slot &slot = shard.slots[pos];
+    slot.key = key;
+    slot.value = value;
+    slot.referenced = false;  // 新条目要再被访问一次才能躲过下一轮淘汰
+    shard.index.emplace(key, pos);
+    shard.inserts++;
+  }
+
+  void erase(const K &key) {
+    Shard &shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+      return;
+    }
+    release_slot(shard, it->second);
+    shard.index.erase(it);
+  }
+
+  void clear() {
+    for (size_t i = 0; i < num_shards_; ++i) {
+      Shard &shard = shards_[i];
+      std::lock_guard<std::mutex> lock(shard.mtx);
+      for (auto &kv : shard.index) release_slot(shard, kv.second);
+      shard.index.clear();
+    }
+  }
+
+  ReadCacheStats stats() const {
+    ReadCacheStats s;
+    for (size_t i = 0; i < num_shards_; ++i) {
+      const Shard &shard = shards_[i];
+      std::lock_guard<std::mutex> lock(shard.mtx);
+      s.hits += shard.hits;
+      s.misses += shard.misses;
+      s.inserts += shard.inserts;
+      s.evictions += shard.evictions;
+      s.entries += shard.index.size();
+    }
+    return s;
+  }
+
+ private:
+  struct Slot {
+    K key{};
+    V value{};
+    bool referenced = false;
+  };
+
+  struct alignas(64) Shard {
+    mutable std::mutex mtx;
+    std::vector<Slot> slots;
+    std::unordered_map<K, size_t, Hash> index;
+    std::vector<size_t> free_slots;  // erase 留下的空槽
+    size_t filled = 0;               // 从未使用过的槽位从这里开始
+    size_t hand = 0;                 // CLOCK 指针
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t inserts = 0;
+    uint64_t evictions = 0;
+  };
+
+  Shard &shard_for(const K &key) {
+    // 低位给 unordered_map 用，分片取混合后的高位
+    return shards_[(skiplist_mix_hash(Hash{}(key)) >> 40) & (num_shards_ - 1)];
+  }
+
+  size_t take_slot(Shard &shard) {
+    if (!shard.free_slots.empty()) {
+      size_t pos = shard.free_slots.back();
+      shard.free_slots.pop_back();
+      return pos;
+    }
+    if (shard.filled < shard.slots.size()) {
+      return shard.filled++;
+    }
+    // 满了：CLOCK 淘汰。最多绕两圈 (第一圈清掉所有引用位)
+    while (true) {
+      Slot &slot = shard.slots[shard.hand];
+      size_t pos = shard.hand;
+      shard.hand = (shard.hand + 1) % shard.slots.size();
+      if (slot.referenced) {
+        slot.referenced = false;
+        continue;
+      }
+      shard.index.erase(slot.key);
+      shard.evictions++;
+      return pos;
+    }
+  }
+
+  void release_slot(Shard &shard, size_t pos) {
+    Slot &slot = shard.slots[pos];
+    slot.referenced = false;
+    slot.value = V();  // 释放大 value 占的内存
+    shard.free_slots.push_back(pos);
+  }
+
+  size_t num_shards_;
+  std::unique_ptr<Shard[]> shards_;
+};
+
+#endif  // SKIPLIST_READ_CACHE_H
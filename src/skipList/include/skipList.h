@@ -1,15 +1,25 @@
 #ifndef SKIPLIST_H
 #define SKIPLIST_H
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <shared_mutex>
 #include <sstream>
+#include <thread>
 #include <random>
+#include <set>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 // Boost 序列化所需头文件
 #include <boost/archive/text_oarchive.hpp>
@@ -20,56 +30,78 @@
 #include <boost/serialization/string.hpp>    // 序列化 string 必需
 #include <boost/serialization/access.hpp>    // access 必需
 
+#include "arena.h"
+#include "bloom_filter.h"
+#include "key_compare.h"
+#include "metrics.h"
+#include "read_cache.h"
+#include "snapshot.h"
+
 #define STORE_FILE "store/dumpFile"
 
 static std::string delimiter = ":";
 
+/**
+ * \brief MVCC 模式下被覆盖 / 删除的旧版本，按版本号从新到旧挂在节点上
+ */
+template <typename V>
+struct MvccVersion {
+  uint64_t version;
+  bool deleted;
+  V value;
+  MvccVersion<V> *older;
+};
+
+// 读最新数据时使用的版本号：任何已写入的版本都可见
+constexpr uint64_t kLatestVersion = UINT64_MAX;
+
 // Class template to implement node
+// 内存布局：key、value 与变长的 forward 塔 (level + 1 个指针) 位于同一块连续内存中，
+// forward 必须是最后一个成员，实际长度由 SkipList::create_node 按层高分配。
+// 因此 Node 不能直接 new，只能通过 SkipList 的 arena 创建。
+// version / deleted / older 只在 MVCC 模式下使用：节点上的 value 是最新版本，
+// 更旧的版本挂在 older 链上；deleted 的节点是墓碑，等没有读者需要时再摘除。
 template <typename K, typename V>
 class Node {
  public:
-  Node() {}
-
-  Node(K k, V v, int);
+  Node(const K &k, const V &v, int);
 
-  ~Node();
+  ~Node() = default;
 
-  K get_key() const;
+  const K &get_key() const;
 
   V get_value() const;
 
   void set_value(V);
 
-  // 线性数组，保存不同层级的下一个节点指针
-  Node<K, V> **forward;
+  // 持有 level + 1 层 forward 指针的 Node 所需字节数
+  static size_t alloc_size(int level) { return sizeof(Node<K, V>) + sizeof(Node<K, V> *) * level; }
 
-  int node_level;
+  int16_t node_level;
+  bool deleted = false;  // 与 node_level 共用对齐空隙，不增加节点大小
+  uint32_t key_prefix = 0;  // 比较器提供前缀时由 SkipList 填写 (见 key_compare.h)，同样位于对齐空隙内
 
  private:
   K key;
   V value;
+
+ public:
+  uint64_t version = 0;
+  MvccVersion<V> *older = nullptr;
+
+  // 线性数组，保存不同层级的下一个节点指针 (内联塔，真实长度为 node_level + 1)
+  Node<K, V> *forward[1];
 };
 
 template <typename K, typename V>
-Node<K, V>::Node(const K k, const V v, int level) {
-  this->key = k;
-  this->value = v;
-  this->node_level = level;
-
+Node<K, V>::Node(const K &k, const V &v, int level) : node_level(level), key(k), value(v) {
   // level + 1, because array index is from 0 - level
-  this->forward = new Node<K, V> *[level + 1];
-
   // Fill forward array with 0(NULL)
   memset(this->forward, 0, sizeof(Node<K, V> *) * (level + 1));
 };
 
 template <typename K, typename V>
-Node<K, V>::~Node() {
-  delete[] forward;
-};
-
-template <typename K, typename V>
-K Node<K, V>::get_key() const {
+const K &Node<K, V>::get_key() const {
   return key;
 };
 
@@ -101,29 +133,316 @@ class SkipListDump {
   void insert(const Node<K, V> &node);
 };
 
+/**
+ * \brief 流式扫描时单条 key / value 计入帧的字节数
+ * 内置支持算术类型和 std::string；其他类型按 sizeof 估算，需要精确值时自行特化。
+ */
+template <typename T>
+struct ScanByteSize {
+  static size_t of(const T &) { return sizeof(T); }
+};
+
+template <>
+struct ScanByteSize<std::string> {
+  static size_t of(const std::string &v) { return v.size(); }
+};
+
+constexpr size_t kScanFrameBytes = 64 * 1024;
+
+/**
+ * \brief 流式扫描参数
+ */
+struct ScanStreamOptions {
+  size_t frame_bytes = kScanFrameBytes;  // 单帧 key + value 字节数上限 (至少放一条，保证前进)
+  int frame_keys = 0;                    // 单帧条数上限，<= 0 表示只按字节切帧
+  int limit = 0;                         // 整个流最多返回的条数，<= 0 表示不限制
+};
+
+/**
+ * \brief 读路径加速的命中统计 (见 enable_read_filter / enable_value_cache)
+ */
+struct SkipListReadStats {
+  uint64_t filter_checks = 0;           // 经过过滤器的点查
+  uint64_t filter_negatives = 0;        // 被过滤器直接判定为不存在，省掉一次跳表查找
+  uint64_t filter_false_positives = 0;  // 过滤器放行但 key 不存在
+  uint64_t filter_rebuilds = 0;
+  size_t filter_bytes = 0;
+  ReadCacheStats cache;
+};
+
+/**
+ * \brief 单张表的操作耗时直方图 (纳秒，含等锁时间)，见 enable_op_metrics
+ */
+struct SkipListOpMetrics {
+  MetricHistogram *get = nullptr;     // search_element
+  MetricHistogram *put = nullptr;     // insert_element / insert_set_element
+  MetricHistogram *remove = nullptr;  // delete_element
+  MetricHistogram *scan = nullptr;    // scan (分页扫描的一页)；批量接口的耗时与批大小有关，不计入
+};
+
 // Class template for Skip list
-template <typename K, typename V>
+// Compare 决定 key 的顺序 (默认 std::less<K>)；透明比较器 / key 前缀缓存见 key_compare.h
+template <typename K, typename V, typename Compare = std::less<K>>
 class SkipList {
  public:
-  SkipList(int);
+  /**
+   * \brief 有序迭代器：seek 到 lower_bound 后沿第 0 层顺序遍历
+   * 构造时获取共享锁 (读锁)，析构时释放；因此迭代器存活期间写操作会被阻塞，
+   * 使用方应尽快消费并销毁迭代器，不要长时间持有。
+   */
+  class Iterator {
+   public:
+    explicit Iterator(SkipList<K, V, Compare> *list) : _list(list), _lock(list->_mtx), _node(nullptr) {}
+
+    bool valid() const { return _node != nullptr; }
+    // 定位到第一个 >= key 的节点，O(log n)
+    void seek(const K &key) { _node = _list->find_greater_or_equal(key); skip_deleted(); }
+    // 异构 seek：仅当 Compare 带 is_transparent 时可用
+    template <typename Q, typename C = Compare, typename = typename C::is_transparent>
+    void seek(const Q &key) { _node = _list->find_greater_or_equal(key); skip_deleted(); }
+    void seek_to_first() { _node = _list->_header->forward[0]; skip_deleted(); }
+    void next() { _node = _node->forward[0]; skip_deleted(); }
+    const K &key() const { return _node->get_key(); }
+    V value() const { return _node->get_value(); }
+
+   private:
+    // MVCC 墓碑对最新数据不可见
+    void skip_deleted() {
+      while (_node != nullptr && _node->deleted) _node = _node->forward[0];
+    }
+
+    SkipList<K, V, Compare> *_list;
+    std::shared_lock<std::shared_mutex> _lock;
+    Node<K, V> *_node;
+  };
+
+  /**
+   * \brief 时间点快照 (写时复制)
+   * \details
+   * begin_snapshot 只在写锁下登记一个空的前像表，O(1)。之后每个 key 第一次被修改 (插入 / 更新 /
+   * 删除) 时，写方先把它在快照时刻的值 (或 "不存在") 存进前像表，再原地修改跳表。
+   * 导出时按 key 升序合并 "跳表当前内容" 与 "前像表"：改过的 key 取前像，没改过的 key
+   * 当前值就是快照时刻的值，得到的是 begin_snapshot 那一刻的一致镜像，而导出过程中写入照常进行。
+   * 前像表只随导出期间被改动的不同 key 数增长。
+   *
+   * 增量：第一次 begin_snapshot 之后，跳表记录每个被改动的 key；下一次 begin_snapshot 把这组 key
+   * 收进新快照 (base_id 指向上一个快照)，dump_delta_snapshot 只导出这些 key 在快照时刻的值
+   * 或删除标记。导出并落盘成功后调用 mark_persisted；没有调用就释放的快照会把它的改动集合还给
+   * 跳表，下一次快照的 base_id 随之退回，曾经导出过的半个增量不会成为基准。
+   *
+   * 同一时刻只能有一个 begin_snapshot 的快照；load_file / load_snapshot / split_off 会使进行中的
+   * 快照失效 (导出返回 false) 并重新开始增量链。快照必须在跳表析构前释放。
+   */
+  class Snapshot {
+   public:
+    ~Snapshot() { _list->release_snapshot(this); }
+    Snapshot(const Snapshot &) = delete;
+    Snapshot &operator=(const Snapshot &) = delete;
+
+    uint64_t id() const { return _id; }
+    // 增量的基准快照编号，0 表示没有基准 (只能导出全量)
+    uint64_t base_id() const { return _base_id; }
+    // 快照时刻的元素个数
+    int size() const { return _count; }
+    // 快照 (全量或增量) 已持久化，成为下一个增量的基准
+    void mark_persisted() { _persisted = true; }
+
+   private:
+    friend class SkipList<K, V, Compare>;
+    Snapshot(SkipList<K, V, Compare> *list, uint64_t id, uint64_t base_id, bool chained, int count)
+        : _list(list), _id(id), _base_id(base_id), _chained(chained), _count(count) {}
+
+    SkipList<K, V, Compare> *_list;
+    uint64_t _id;
+    uint64_t _base_id;
+    bool _chained;  // 属于增量链 (begin_snapshot)；dump_file 等内部使用的临时快照不参与
+    int _count;
+    bool _persisted = false;
+    bool _valid = true;  // 以下成员均受 _list->_mtx 保护
+    // 快照之后第一次被修改的 key 的前像：first 为快照时刻是否存在
+    std::map<K, std::pair<bool, V>, Compare> _preserved;
+    // 基准快照之后、本快照之前改动过的 key (创建后不再修改)
+    std::set<K, Compare> _changed;
+  };
+
+  /**
+   * \brief MVCC 读版本 (只在 MVCC 模式下可用)
+   * \details
+   * 持有期间，按该版本读到的内容不会变：写方发现有读者 pin 在更老的版本上时，先把当前值
+   * 挂到节点的版本链上 (删除则留下墓碑) 再写，否则仍然原地覆盖 / 摘除。每次读只在调用内
+   * 持有共享锁，多页 Scan、follower 读可以各自 pin 一个 applied index 而不长时间挡住写。
+   * 最老的 pin 释放时回收不再被任何读者需要的旧版本。pin 必须在跳表析构前释放。
+   */
+  class ReadPin {
+   public:
+    ~ReadPin() { _list->unpin(this); }
+    ReadPin(const ReadPin &) = delete;
+    ReadPin &operator=(const ReadPin &) = delete;
+
+    uint64_t version() const { return *_it; }
+
+   private:
+    friend class SkipList<K, V, Compare>;
+    ReadPin(SkipList<K, V, Compare> *list, std::multiset<uint64_t>::iterator it) : _list(list), _it(it) {}
+
+    SkipList<K, V, Compare> *_list;
+    std::multiset<uint64_t>::iterator _it;
+  };
+
+  // mvcc 为 true 时节点保留多版本，支持 pin_version 的一致读
+  SkipList(int, bool mvcc = false);
   ~SkipList();
   int get_random_level();
   Node<K, V> *create_node(const K& key, const V& value, int level);
   int insert_element(const K& key, const V& value);
   void display_list();
   bool search_element(const K& key, V& value);
+  // 异构点查 (例如用 std::string_view 查 std::string)：仅当 Compare 带 is_transparent 时可用，
+  // 查找路径上不构造 K；开启了 value 缓存时会构造一次 K 以查缓存
+  template <typename Q, typename C = Compare, typename = typename C::is_transparent>
+  bool search_element(const Q& key, V& value);
   void delete_element(const K& key);
   void insert_set_element(const K& key, const V& value);
+  // MVCC 写：version 通常是 Raft 的 applied index，必须单调不减，同一版本号的写入视为同一批；
+  // 不带 version 的写在 MVCC 模式下各自使用 applied_version() + 1，非 MVCC 模式下忽略 version
+  void insert_set_element(const K& key, const V& value, uint64_t version);
+  void delete_element(const K& key, uint64_t version);
+
+  // MVCC 一致读
+  std::unique_ptr<ReadPin> pin_version();                  // pin 当前的 applied_version()；非 MVCC 模式返回 nullptr
+  std::unique_ptr<ReadPin> pin_version(uint64_t version);  // 该版本的数据已被回收 / 尚未写入时返回 nullptr
+  uint64_t applied_version();
+  // 安装 Raft 快照之后把 applied 版本推进到快照的 index (只增不减)
+  void set_applied_version(uint64_t version);
+  bool search_element(const K& key, V& value, const ReadPin &pin);
+  // 按 pin 的版本回收旧版本 (通常由最老的 pin 释放时自动触发)，返回回收的版本数
+  size_t collect_versions();
+
+  /**
+   * \brief 批量写的单个操作：is_delete 为 false 时是 upsert
+   */
+  struct WriteOp {
+    bool is_delete = false;
+    K key;
+    V value;
+  };
+  // 批量写：整批只获取一次写锁，按顺序执行 (同一 key 的多次操作以最后一次为准)
+  void apply_batch(const std::vector<WriteOp> &ops);
+  void apply_batch(const std::vector<WriteOp> &ops, uint64_t version);
+  // 批量读：整批只获取一次读锁；values / found 与 keys 一一对应
+  void multi_get(const std::vector<K> &keys, std::vector<V> &values, std::vector<bool> &found);
+  bool scan(const K& start_key, int limit, std::vector<std::pair<K, V>> &out, K *next_key = nullptr);
+  bool scan(const K& start_key, const K& end_key, int limit, std::vector<std::pair<K, V>> &out,
+            K *next_key = nullptr);
+  // 按 pin 的版本扫描：用同一个 pin 分多页续扫，看到的是同一个时间点
+  bool scan(const ReadPin &pin, const K& start_key, int limit, std::vector<std::pair<K, V>> &out,
+            K *next_key = nullptr);
+  bool scan(const ReadPin &pin, const K& start_key, const K& end_key, int limit,
+            std::vector<std::pair<K, V>> &out, K *next_key = nullptr);
+
+  /**
+   * \brief 流式扫描的一帧；同一个对象在整个流中复用，内存占用只有一帧
+   */
+  struct ScanFrame {
+    std::vector<std::pair<K, V>> kvs;
+    bool last = false;      // 流的最后一帧
+    bool has_more = false;  // 仅 last 时有意义：因 limit 截断，区间内仍有数据
+    K next_key{};           // 仅 has_more 时有意义：续扫游标
+  };
+  // 返回 false 表示下游失败 (客户端断开 / Write 失败)，扫描立即中止
+  using ScanFrameSink = std::function<bool(ScanFrame &frame)>;
+  // 流式范围扫描 [start_key, +inf) / [start_key, end_key)
+  bool scan_stream(const K &start_key, const ScanStreamOptions &options, const ScanFrameSink &sink);
+  bool scan_stream(const K &start_key, const K &end_key, const ScanStreamOptions &options,
+                   const ScanFrameSink &sink);
+  // 按 pin 的版本流式扫描：帧与帧之间的写入不可见
+  bool scan_stream(const ReadPin &pin, const K &start_key, const K &end_key, const ScanStreamOptions &options,
+                   const ScanFrameSink &sink);
   std::string dump_file();
   void load_file(const std::string &dumpStr);
+  // 流式快照 (格式见 snapshot.h)
+  bool dump_snapshot(const SnapshotSink &sink);
+  bool dump_snapshot_to_fd(int fd);
+  bool load_snapshot(const SnapshotSource &source);
+  bool load_snapshot_from_fd(int fd);
+  // 写时复制快照与增量快照 (见 Snapshot)
+  std::unique_ptr<Snapshot> begin_snapshot();
+  bool dump_snapshot(Snapshot &snapshot, const SnapshotSink &sink);
+  bool dump_delta_snapshot(Snapshot &snapshot, const SnapshotSink &sink);
+  bool load_delta_snapshot(const SnapshotSource &source, uint64_t *base_id = nullptr, uint64_t *id = nullptr);
   //递归删除节点
   void clear(Node<K, V> *);
   int size();
+  // 节点内存占用 (arena 已申请的字节数)
+  size_t mem_usage();
+
+  // 区间分裂 (Multi-Raft)：近似中位 key，以及不拷贝数据地把 [key, +inf) 整体移到另一张表
+  bool approximate_median_key(K *key);
+  bool split_off(const K &key, SkipList<K, V, Compare> &right);
+
+  // 读路径加速 (默认关闭)：不存在的 key 由分块 bloom 过滤器直接挡掉，热点 key 的 value 由分片 CLOCK 缓存命中。
+  // 两者都在写路径上同步维护，search_element / multi_get 透明使用
+  void enable_read_filter(size_t expected_keys, int bits_per_key = kReadFilterBitsPerKey);
+  void enable_value_cache(size_t capacity, size_t shards = kReadCacheShards);
+  // 只查过滤器：false 表示 key 一定不存在 (未开启过滤器时总是 true)。
+  // 供 KV apply 路径在处理 Get / Delete 之前直接判定 ERR_KEY_NOT_FOUND，只持有一次读锁、不走跳表
+  bool may_contain(const K &key);
+  SkipListReadStats read_stats();
+
+  // 把点查 / 写入 / 删除 / 扫描的耗时导出为 skiplist_op_latency_nanoseconds{table, op} (默认关闭，
+  // 关闭时每个操作只多一次原子读)。只能开启一次，之后的调用忽略
+  void enable_op_metrics(const std::string &table);
 
  private:
   void get_key_value_from_string(const std::string &str, std::string *key, std::string *value);
   bool is_valid_string(const std::string &str);
   int insert_element_unlocked(const K key, const V value);
+  static constexpr bool kKeyPrefix = KeyComparePrefix<Compare, K>::value;
+  template <typename Q>
+  static uint32_t probe_prefix(const Q &key);
+  template <typename Q>
+  bool node_before(const Node<K, V> *node, const Q &key, uint32_t prefix) const;
+  template <typename Q>
+  bool node_matches(const Node<K, V> *node, const Q &key, uint32_t prefix) const;
+  template <typename A, typename B>
+  bool key_less(const A &a, const B &b) const { return _compare(a, b); }
+  void insert_set_element_unlocked(const K &key, const V &value);
+  void delete_element_unlocked(const K &key);
+  template <typename Q>
+  bool search_element_unlocked(const Q &key, V &value, uint64_t read_version = kLatestVersion) const;
+  template <typename Q>
+  Node<K, V> *find_greater_or_equal(const Q &key) const;
+  void destroy_node(Node<K, V> *node);
+  bool append_sorted_unlocked(Node<K, V> **last, const K &key, const V &value);
+  bool scan_unlocked(const K &start_key, const K *end_key, int limit, std::vector<std::pair<K, V>> &out,
+                     K *next_key, uint64_t read_version = kLatestVersion);
+  bool scan_stream_impl(const K &start_key, const K *end_key, const ScanStreamOptions &options,
+                        const ScanFrameSink &sink, uint64_t read_version = kLatestVersion);
+  // MVCC
+  static bool visible(const Node<K, V> *node, uint64_t read_version, V *value);
+  static size_t free_versions(MvccVersion<V> *version);
+  void begin_write_unlocked(uint64_t version);
+  void end_write_unlocked();
+  bool readers_behind_unlocked() const;
+  bool keep_history_unlocked(const Node<K, V> *node) const;
+  void push_version_unlocked(Node<K, V> *node);
+  void unlink_node_unlocked(Node<K, V> *target, Node<K, V> **update);
+  void unpin(ReadPin *pin);
+  size_t collect_versions_unlocked();
+  template <typename Q>
+  static uint64_t key_hash(const Q &key);
+  struct ReadCounters;
+  static ReadCounters &read_counters(ReadCounters *stripes);
+  template <typename Q>
+  bool filter_rejects_unlocked(const Q &key);
+  bool search_cached_unlocked(const K &key, V &value);
+  void rebuild_filter_unlocked(size_t expected_keys);
+  std::unique_ptr<Snapshot> open_snapshot_unlocked(bool chained);
+  void release_snapshot(Snapshot *snapshot);
+  void record_write_unlocked(const K &key, const Node<K, V> *existing);
+  void reset_snapshots_unlocked();
+  using SnapshotBatchVisitor = std::function<bool(const std::vector<std::pair<K, V>> &batch)>;
+  bool visit_snapshot(Snapshot &snapshot, const SnapshotBatchVisitor &visit);
 
  private:
   // Maximum level of the skip list
@@ -135,6 +454,8 @@ class SkipList {
   // pointer to header node
   Node<K, V> *_header;
 
+  Compare _compare;
+
   // file operator
   // std::ofstream _file_writer;
   // std::ifstream _file_reader;
@@ -142,15 +463,95 @@ class SkipList {
   // skiplist current element count
   int _element_count;
 
+  // 节点内存池；被删除节点的空间按层高挂到 _free_nodes[level] 上等待复用，
+  // 整个 arena 只在 clear() / load_file() / 析构时批量释放
+  std::shared_ptr<Arena> _arena = std::make_shared<Arena>();
+  std::vector<Node<K, V> *> _free_nodes;
+  // split_off 移入的节点仍位于来源表的 arena 中：持有引用，直到本表 clear / 析构
+  std::vector<std::shared_ptr<Arena>> _borrowed_arenas;
+
+  // MVCC 状态 (均受 _mtx 保护)
+  bool _mvcc;
+  uint64_t _applied_version = 0;
+  uint64_t _write_version = 0;            // 当前写操作使用的版本号
+  std::multiset<uint64_t> _pins;          // 活跃读者 pin 的版本
+  std::unordered_set<Node<K, V> *> _versioned_nodes;  // 带版本链或墓碑、等待回收的节点
+
+  // 进行中的写时复制快照，以及增量链的状态 (均受 _mtx 保护)
+  std::vector<Snapshot *> _snapshots;
+  bool _chain_active = false;   // 已有一个 begin_snapshot 的快照未释放
+  bool _track_changes = false;  // 第一次 begin_snapshot 之后开始记录改动的 key
+  std::set<K, Compare> _changed;         // 最近一个增量链快照之后改动过的 key
+  uint64_t _last_snapshot_id = 0;  // 最近一个增量链快照，下一个增量的基准
+  uint64_t _next_snapshot_id = 0;
+
+  // 读路径加速：过滤器只在写锁下 add / 重建；缓存在写锁下 erase、读锁下 put (自身按分片加锁)
+  std::unique_ptr<BlockedBloomFilter> _filter;
+  int _filter_bits_per_key = kReadFilterBitsPerKey;
+  size_t _filter_keys = 0;  // 上次重建以来 add 过的 key 数 (含之后被删除的)
+  uint64_t _filter_rebuilds = 0;
+  // 读锁下的计数按线程分条，避免所有读者争用同一条 cache line
+  static constexpr size_t kReadCounterStripes = 16;
+  struct alignas(64) ReadCounters {
+    std::atomic<uint64_t> checks{0};
+    std::atomic<uint64_t> negatives{0};
+    std::atomic<uint64_t> false_positives{0};
+  };
+  ReadCounters _read_counters[kReadCounterStripes];
+  std::unique_ptr<ShardedClockCache<K, V>> _cache;
+
+  // 操作耗时：开启前为空，开启后不再改变 (读写不需要持锁)
+  std::unique_ptr<SkipListOpMetrics> _op_metrics_storage;
+  std::atomic<const SkipListOpMetrics *> _op_metrics{nullptr};
+  MetricHistogram *op_histogram(MetricHistogram *SkipListOpMetrics::*op) const {
+    const SkipListOpMetrics *m = _op_metrics.load(std::memory_order_acquire);
+    return m ? m->*op : nullptr;
+  }
+  using OpTimer = ScopedLatency<std::chrono::nanoseconds>;
+
   // std::mutex _mtx;  // mutex for critical section
   std::shared_mutex _mtx;;  // mutex for critical section
 };
 
 // create new node
-template <typename K, typename V>
-Node<K, V> *SkipList<K, V>::create_node(const K& k, const V& v, int level) {
-  Node<K, V> *n = new Node<K, V>(k, v, level);
-  return n;
+// 节点与其 forward 塔一次分配完成：优先复用同层高的空闲节点，否则从 arena 切一块
+template <typename K, typename V, typename Compare>
+Node<K, V> *SkipList<K, V, Compare>::create_node(const K& k, const V& v, int level) {
+  void *mem;
+  if (_free_nodes[level] != nullptr) {
+    Node<K, V> *reuse = _free_nodes[level];
+    _free_nodes[level] = *reinterpret_cast<Node<K, V> **>(reuse);
+    mem = reuse;
+  } else {
+    mem = _arena->allocate_aligned(Node<K, V>::alloc_size(level), alignof(Node<K, V>));
+  }
+  Node<K, V> *node = new (mem) Node<K, V>(k, v, level);
+  node->version = _write_version;
+  if constexpr (kKeyPrefix) {
+    node->key_prefix = Compare::prefix(k);
+  }
+  if (_filter) {
+    // 删掉的 key 也占着 bit：add 过的 key 数达到设计容量就按当前大小的两倍重建，一并清掉这些 bit
+    if (_filter_keys >= _filter->capacity()) {
+      rebuild_filter_unlocked(std::max<size_t>(_filter->capacity(), static_cast<size_t>(_element_count)) * 2);
+    }
+    _filter->add(key_hash(k));
+    ++_filter_keys;
+  }
+  return node;
+}
+
+// 析构节点并把空间挂回按层高分桶的空闲链表 (复用节点内存的前 8 字节作为 next 指针)
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::destroy_node(Node<K, V> *node) {
+  free_versions(node->older);
+  if (_mvcc) {
+    _versioned_nodes.erase(node);
+  }
+  int level = node->node_level;
+  node->~Node<K, V>();
+  *reinterpret_cast<Node<K, V> **>(node) = _free_nodes[level];
+  _free_nodes[level] = node;
 }
 
 // Insert given key and value in skip list
@@ -177,8 +578,8 @@ level 0         1    4   9 10         30   40  | 50 |  60      70       100
 
 */
 
-template <typename K, typename V>
-int SkipList<K, V>::insert_element_unlocked(const K key, const V value) {
+template <typename K, typename V, typename Compare>
+int SkipList<K, V, Compare>::insert_element_unlocked(const K key, const V value) {
   // 无锁版本
   Node<K, V> *current = this->_header;
 
@@ -187,9 +588,10 @@ int SkipList<K, V>::insert_element_unlocked(const K key, const V value) {
   memset(update, 0, sizeof(Node<K, V> *) * (_max_level + 1));
 
   // 3. 从顶层向下查找插入位置
+  const uint32_t prefix = probe_prefix(key);
   for (int i = _skip_list_level; i >= 0; i--) { // i 负责层高，从顶层开始找
     // 在第 i 层不断向前移动，直到找到第一个大于等于 key 的节点，遇到层高小于 i 就 i-- 继续往下层找
-      while (current->forward[i] != NULL && current->forward[i]->get_key() < key) {
+      while (current->forward[i] != NULL && node_before(current->forward[i], key, prefix)) {
           current = current->forward[i];
       }
       update[i] = current; // 记录每层的前驱节点， update[i]表示新节点在第 i 层的“前驱节点”
@@ -198,7 +600,17 @@ int SkipList<K, V>::insert_element_unlocked(const K key, const V value) {
   current = current->forward[0];
 
   // 4. 检查键是否已存在
-  if (current != NULL && current->get_key() == key) {
+  if (current != NULL && node_matches(current, key, prefix)) {
+      if (current->deleted) {
+          // MVCC 墓碑：在原节点上复活
+          record_write_unlocked(key, nullptr);
+          push_version_unlocked(current);
+          current->set_value(value);
+          current->deleted = false;
+          current->version = _write_version;
+          _element_count++;
+          return 0;
+      }
       // std::cout << "key: " << key << ", exists" << std::endl;
       
       // (改进) 无需手动 unlock()，lock 会在 return 时自动释放
@@ -208,7 +620,8 @@ int SkipList<K, V>::insert_element_unlocked(const K key, const V value) {
   }
 
   // 5. 键不存在，执行插入
-  if (current == NULL || current->get_key() != key) {
+  if (current == NULL || !node_matches(current, key, prefix)) {
+      record_write_unlocked(key, nullptr);
       // 6. 获取随机层高
       int random_level = get_random_level();
 
@@ -235,18 +648,22 @@ int SkipList<K, V>::insert_element_unlocked(const K key, const V value) {
   return 0;
 }
 
-template <typename K, typename V>
-int SkipList<K, V>::insert_element(const K& key, const V& value) {
+template <typename K, typename V, typename Compare>
+int SkipList<K, V, Compare>::insert_element(const K& key, const V& value) {
+  OpTimer timer(op_histogram(&SkipListOpMetrics::put));
   // 使用 std::unique_lock (获取独占锁)
   std::unique_lock<std::shared_mutex> lock(_mtx);
 
   // 调用无锁的内部版本
-    return insert_element_unlocked(key, value);
+    begin_write_unlocked(kLatestVersion);
+    int ret = insert_element_unlocked(key, value);
+    end_write_unlocked();
+    return ret;
 }
 
 // Display skip list
-template <typename K, typename V>
-void SkipList<K, V>::display_list() {
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::display_list() {
   std::cout << "\n*****Skip List*****"
             << "\n";
   for (int i = 0; i <= _skip_list_level; i++) {
@@ -260,27 +677,31 @@ void SkipList<K, V>::display_list() {
   }
 }
 
-// todo 对dump 和 load 后面可能要考虑加锁的问题
 // Dump data in memory to file
-template <typename K, typename V>
-std::string SkipList<K, V>::dump_file() {
+template <typename K, typename V, typename Compare>
+std::string SkipList<K, V, Compare>::dump_file() {
    std::cout << "dump_file-----------------" << std::endl;
     //
-    // 1. (改进 - 关键) 增加共享锁 (读锁)
-    //    这保证了在创建快照期间，跳表结构不会被其他线程修改
-    //    保证了线程安全和快照的一致性
+    // 1. (改进 - 关键) 写时复制快照
+    //    只在登记快照时短暂持有写锁，之后按批遍历，每批持有一次共享锁；
+    //    遍历期间的写入不会被阻塞，得到的仍是登记那一刻的一致镜像
     //
-    std::shared_lock<std::shared_mutex> lock(_mtx);
+    std::unique_ptr<Snapshot> snapshot;
+    {
+        std::unique_lock<std::shared_mutex> lock(_mtx);
+        snapshot = open_snapshot_unlocked(false);
+    }
 
-    Node<K, V> *node = this->_header->forward[0];
     SkipListDump<K, V> dumper;
-
-    // 遍历第0层链表，将所有 K/V 复制到 dumper DTO 中
-    // 这个遍历操作现在是线程安全的
-    while (node != nullptr) {
-        dumper.insert(*node);
-        node = node->forward[0];
-    }
+    dumper.keyDumpVt_.reserve(snapshot->size());
+    dumper.valDumpVt_.reserve(snapshot->size());
+    visit_snapshot(*snapshot, [&dumper](const std::vector<std::pair<K, V>> &batch) {
+        for (const auto &kv : batch) {
+            dumper.keyDumpVt_.push_back(kv.first);
+            dumper.valDumpVt_.push_back(kv.second);
+        }
+        return true;
+    });
 
     std::stringstream ss;
 
@@ -293,13 +714,11 @@ std::string SkipList<K, V>::dump_file() {
     oa << dumper;
 
     return ss.str();
-
-    // 注意：std::shared_lock 会在函数返回时自动释放
 }
 
 // Load data from disk
-template <typename K, typename V>
-void SkipList<K, V>::load_file(const std::string &dumpStr) {
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::load_file(const std::string &dumpStr) {
     //
     // 1. (改进 - 关键) 获取独占锁 (写锁)
     //    在加载快照的整个过程中持有锁，防止任何并发读/写
@@ -310,18 +729,15 @@ void SkipList<K, V>::load_file(const std::string &dumpStr) {
     // 2. (改进 - 关键 Bug 修复) 清空当前所有状态
     //    这是 "替换" 语义的实现
     //
-    if (_header->forward[0] != nullptr) {
-        clear(_header->forward[0]); // 递归删除所有节点
-    }
-    // 重置 header 的所有指针
-    memset(this->_header->forward, 0, sizeof(Node<K, V> *) * (_max_level + 1));
-    _skip_list_level = 0;
-    _element_count = 0;
+    // clear 会析构所有节点并批量释放 arena，同时重置 header
+    clear(_header->forward[0]);
 
     // 3. (改进) 如果快照为空，直接返回
     if (dumpStr.empty()) {
         return;
     }
+    // MVCC：加载的数据使用同一个新版本号
+    begin_write_unlocked(kLatestVersion);
 
     // 4. (改进 - 性能/兼容) 使用二进制归档
     SkipListDump<K, V> dumper;
@@ -332,25 +748,690 @@ void SkipList<K, V>::load_file(const std::string &dumpStr) {
     ia >> dumper;
 
     //
-    // 6. (改进 - 关键 Bug 修复 / 性能)
+    // 6. (改进 - 性能) dump_file 按 key 升序导出，直接 O(n) 尾部链接，无需逐个查找插入位置
     //
-    for (int i = 0; i < dumper.keyDumpVt_.size(); ++i) {
+    Node<K, V> *last[_max_level + 1];
+    std::fill(last, last + _max_level + 1, _header);
+    for (size_t i = 0; i < dumper.keyDumpVt_.size(); ++i) {
         // (Bug 修复) 使用 valDumpVt_ 而不是 keyDumpVt_
-        // (性能) 调用无锁的内部函数，避免死锁和重复加锁
-        insert_element_unlocked(dumper.keyDumpVt_[i], dumper.valDumpVt_[i]); 
+        append_sorted_unlocked(last, dumper.keyDumpVt_[i], dumper.valDumpVt_[i]);
     }
+    end_write_unlocked();
     
     // 独占锁 lock 会在这里自动释放
 }
 
+/**
+ * \brief 有序批量构建：把 key 链到各层的尾部，O(1) 每条
+ * \param last 每层当前的尾节点，初始全部指向 _header
+ * 一旦遇到非严格升序的输入 (例如外部构造的数据)，last 失效，本条及之后的元素
+ * 统一退化为 insert_element_unlocked 查找插入，返回 false 告知调用方。
+ */
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::append_sorted_unlocked(Node<K, V> **last, const K &key, const V &value) {
+  if (last[0] == nullptr || (last[0] != _header && !key_less(last[0]->get_key(), key))) {
+    last[0] = nullptr;  // 标记为无序模式
+    insert_element_unlocked(key, value);
+    return false;
+  }
+
+  int level = get_random_level();
+  if (level > _skip_list_level) {
+    _skip_list_level = level;
+  }
+  Node<K, V> *node = create_node(key, value, level);
+  for (int i = 0; i <= level; ++i) {
+    last[i]->forward[i] = node;
+    last[i] = node;
+  }
+  _element_count++;
+  return true;
+}
+
+/**
+ * \brief 流式导出快照：按 key 升序逐条编码，攒满一个 chunk 就交给 sink
+ * 基于一个临时的写时复制快照 (不参与增量链)，导出期间写入照常进行，sink 在锁外调用。
+ * \return sink 写失败时返回 false
+ */
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::dump_snapshot(const SnapshotSink &sink) {
+  std::unique_ptr<Snapshot> snapshot;
+  {
+    std::unique_lock<std::shared_mutex> lock(_mtx);
+    snapshot = open_snapshot_unlocked(false);
+  }
+  return dump_snapshot(*snapshot, sink);
+}
+
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::dump_snapshot_to_fd(int fd) {
+  return dump_snapshot(make_fd_sink(fd));
+}
+
+/**
+ * \brief 流式加载快照 (替换语义)，有序输入走 O(n) 批量构建
+ * \return 格式错误或数据截断时返回 false，此时跳表被清空，不会留下半份状态
+ */
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::load_snapshot(const SnapshotSource &source) {
+  std::unique_lock<std::shared_mutex> lock(_mtx);
+  clear(_header->forward[0]);
+
+  SnapshotReader reader(source);
+  uint64_t count = 0;
+  if (!reader.read_header(count)) {
+    return false;
+  }
+  begin_write_unlocked(kLatestVersion);
+
+  Node<K, V> *last[_max_level + 1];
+  std::fill(last, last + _max_level + 1, _header);
+  K key;
+  V value;
+  for (uint64_t i = 0; i < count; ++i) {
+    if (!reader.read_field(key) || !reader.read_field(value)) {
+      clear(_header->forward[0]);
+      return false;
+    }
+    append_sorted_unlocked(last, key, value);
+  }
+
+  uint32_t footer = 0;
+  if (!reader.read_u32(footer) || footer != kSnapshotFooter) {
+    clear(_header->forward[0]);
+    return false;
+  }
+  end_write_unlocked();
+  return true;
+}
+
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::load_snapshot_from_fd(int fd) {
+  return load_snapshot(make_fd_source(fd));
+}
+
+/**
+ * \brief 开始一个增量链上的时间点快照，O(1)
+ * \return 上一个 begin_snapshot 的快照还没有释放时返回 nullptr
+ */
+template <typename K, typename V, typename Compare>
+std::unique_ptr<typename SkipList<K, V, Compare>::Snapshot> SkipList<K, V, Compare>::begin_snapshot() {
+  std::unique_lock<std::shared_mutex> lock(_mtx);
+  if (_chain_active) {
+    return nullptr;
+  }
+  return open_snapshot_unlocked(true);
+}
+
+template <typename K, typename V, typename Compare>
+std::unique_ptr<typename SkipList<K, V, Compare>::Snapshot> SkipList<K, V, Compare>::open_snapshot_unlocked(bool chained) {
+  uint64_t id = ++_next_snapshot_id;
+  uint64_t base_id = 0;
+  if (chained) {
+    base_id = _track_changes ? _last_snapshot_id : 0;
+  }
+  std::unique_ptr<Snapshot> snapshot(new Snapshot(this, id, base_id, chained, _element_count));
+  if (chained) {
+    snapshot->_changed.swap(_changed);
+    _track_changes = true;
+    _chain_active = true;
+    _last_snapshot_id = id;
+  }
+  _snapshots.push_back(snapshot.get());
+  return snapshot;
+}
+
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::release_snapshot(Snapshot *snapshot) {
+  std::unique_lock<std::shared_mutex> lock(_mtx);
+  _snapshots.erase(std::find(_snapshots.begin(), _snapshots.end(), snapshot));
+  if (!snapshot->_chained) {
+    return;
+  }
+  _chain_active = false;
+  if (snapshot->_valid && !snapshot->_persisted) {
+    // 没有持久化：把它从增量链上摘掉，它的改动并入下一个增量
+    _changed.insert(snapshot->_changed.begin(), snapshot->_changed.end());
+    _last_snapshot_id = snapshot->_base_id;
+  }
+}
+
+// 写方在修改 key 之前调用 (持有写锁)：existing 为 nullptr 表示 key 当前不存在
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::record_write_unlocked(const K &key, const Node<K, V> *existing) {
+  if (_cache) {
+    _cache->erase(key);  // 读方只在读锁下回填，写锁释放前不会再被放回旧值
+  }
+  if (_track_changes) {
+    _changed.insert(key);
+  }
+  for (Snapshot *snapshot : _snapshots) {
+    if (!snapshot->_valid) {
+      continue;
+    }
+    auto it = snapshot->_preserved.lower_bound(key);
+    if (it != snapshot->_preserved.end() && !key_less(key, it->first)) {
+      continue;  // 快照之后已经改过，前像早已保存
+    }
+    if (existing != nullptr) {
+      snapshot->_preserved.emplace_hint(it, key, std::make_pair(true, existing->get_value()));
+    } else {
+      snapshot->_preserved.emplace_hint(it, key, std::make_pair(false, V()));
+    }
+  }
+}
+
+// 整表被替换 / 分裂：进行中的快照作废，增量链从下一个快照重新开始
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::reset_snapshots_unlocked() {
+  for (Snapshot *snapshot : _snapshots) {
+    snapshot->_valid = false;
+    snapshot->_preserved.clear();
+  }
+  _track_changes = false;
+  _changed.clear();
+  _last_snapshot_id = 0;
+}
+
+/**
+ * \brief 按 key 升序分批访问快照镜像
+ * \details 每批持有一次共享锁：从游标之后 seek 跳表与前像表，二者归并，前像优先；
+ * visit 在锁外调用。
+ * \return 快照失效或 visit 返回 false 时返回 false
+ */
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::visit_snapshot(Snapshot &snapshot, const SnapshotBatchVisitor &visit) {
+  std::vector<std::pair<K, V>> batch;
+  batch.reserve(kSnapshotBatchKeys);
+  K cursor{};
+  bool started = false;
+  bool done = false;
+
+  while (!done) {
+    batch.clear();
+    {
+      std::shared_lock<std::shared_mutex> lock(_mtx);
+      if (!snapshot._valid) {
+        return false;
+      }
+      Node<K, V> *node = _header->forward[0];
+      auto pre = snapshot._preserved.begin();
+      if (started) {
+        node = find_greater_or_equal(cursor);
+        if (node != nullptr && !key_less(cursor, node->get_key())) {
+          node = node->forward[0];
+        }
+        pre = snapshot._preserved.upper_bound(cursor);
+      }
+      while (batch.size() < kSnapshotBatchKeys) {
+        while (node != nullptr && node->deleted) {
+          node = node->forward[0];  // MVCC 墓碑
+        }
+        bool has_node = node != nullptr;
+        bool has_pre = pre != snapshot._preserved.end();
+        if (!has_node && !has_pre) {
+          done = true;
+          break;
+        }
+        started = true;
+        if (has_pre && (!has_node || !key_less(node->get_key(), pre->first))) {
+          // 快照之后改过的 key：以前像为准 (快照时刻不存在的直接跳过)
+          if (has_node && !key_less(pre->first, node->get_key())) {
+            node = node->forward[0];
+          }
+          if (pre->second.first) {
+            batch.emplace_back(pre->first, pre->second.second);
+          }
+          cursor = pre->first;
+          ++pre;
+        } else {
+          batch.emplace_back(node->get_key(), node->get_value());
+          cursor = node->get_key();
+          node = node->forward[0];
+        }
+      }
+    }
+    if (!batch.empty() && !visit(batch)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * \brief 导出快照时刻的全量镜像 (格式与 dump_snapshot(sink) 相同，load_snapshot 可直接加载)
+ * \return sink 写失败或快照已失效时返回 false
+ */
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::dump_snapshot(Snapshot &snapshot, const SnapshotSink &sink) {
+  SnapshotWriter writer(sink);
+  writer.write_header(static_cast<uint64_t>(snapshot.size()));
+  int written = 0;
+  bool ok = visit_snapshot(snapshot, [&](const std::vector<std::pair<K, V>> &batch) {
+    for (const auto &kv : batch) {
+      if (!writer.write_entry(kv.first, kv.second)) {
+        return false;
+      }
+    }
+    written += static_cast<int>(batch.size());
+    return true;
+  });
+  // header 中的条目数是快照时刻的元素个数，归并结果必然与之相等
+  return ok && written == snapshot.size() && writer.finish();
+}
+
+/**
+ * \brief 导出增量：基准快照之后改动过的 key 在本快照时刻的值，已删除的写删除标记
+ * \return 没有基准 (base_id == 0)、sink 写失败或快照已失效时返回 false
+ */
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::dump_delta_snapshot(Snapshot &snapshot, const SnapshotSink &sink) {
+  if (!snapshot._chained || snapshot._base_id == 0) {
+    return false;
+  }
+  SnapshotWriter writer(sink);
+  writer.write_delta_header(snapshot._base_id, snapshot._id, snapshot._changed.size());
+
+  // (是否存在, key, value)；_changed 创建后不再修改，可以在锁外遍历
+  std::vector<std::pair<bool, std::pair<K, V>>> batch;
+  batch.reserve(kSnapshotBatchKeys);
+  auto it = snapshot._changed.begin();
+  while (it != snapshot._changed.end()) {
+    batch.clear();
+    {
+      std::shared_lock<std::shared_mutex> lock(_mtx);
+      if (!snapshot._valid) {
+        return false;
+      }
+      for (; it != snapshot._changed.end() && batch.size() < kSnapshotBatchKeys; ++it) {
+        auto pre = snapshot._preserved.find(*it);
+        V value{};
+        bool exists;
+        if (pre != snapshot._preserved.end()) {
+          exists = pre->second.first;
+          if (exists) {
+            value = pre->second.second;
+          }
+        } else {
+          exists = search_element_unlocked(*it, value);
+        }
+        batch.emplace_back(exists, std::make_pair(*it, std::move(value)));
+      }
+    }
+    for (const auto &entry : batch) {
+      bool ok = entry.first ? writer.write_put(entry.second.first, entry.second.second)
+                            : writer.write_delete(entry.second.first);
+      if (!ok) {
+        return false;
+      }
+    }
+  }
+  {
+    std::shared_lock<std::shared_mutex> lock(_mtx);
+    if (!snapshot._valid) {
+      return false;  // 没有改动时循环一次也不会执行，这里再检查一次
+    }
+  }
+  return writer.finish();
+}
+
+/**
+ * \brief 在当前内容上叠加一个增量
+ * \details 先解析完整个增量并校验 footer，再在一次写锁内应用，格式错误时跳表保持不变。
+ * 调用方负责检查 base_id 与本地已加载的快照编号一致。
+ */
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::load_delta_snapshot(const SnapshotSource &source, uint64_t *base_id, uint64_t *id) {
+  SnapshotReader reader(source);
+  uint64_t base = 0;
+  uint64_t delta_id = 0;
+  uint64_t count = 0;
+  if (!reader.read_delta_header(base, delta_id, count)) {
+    return false;
+  }
+  std::vector<WriteOp> ops;
+  // count 来自文件头、尚未校验：损坏的头部不能让这里一次申请巨量内存，更多的条目靠 vector 自己增长
+  ops.reserve(std::min<uint64_t>(count, kSnapshotBatchKeys));
+  for (uint64_t i = 0; i < count; ++i) {
+    uint8_t op = 0;
+    WriteOp write;
+    if (!reader.read_u8(op) || !reader.read_field(write.key)) {
+      return false;
+    }
+    if (op == kDeltaDelete) {
+      write.is_delete = true;
+    } else if (op != kDeltaPut || !reader.read_field(write.value)) {
+      return false;
+    }
+    ops.push_back(std::move(write));
+  }
+  uint32_t footer = 0;
+  if (!reader.read_u32(footer) || footer != kSnapshotFooter) {
+    return false;
+  }
+  apply_batch(ops);
+  if (base_id != nullptr) {
+    *base_id = base;
+  }
+  if (id != nullptr) {
+    *id = delta_id;
+  }
+  return true;
+}
+
+// ================= MVCC =================
+
+// 节点在 read_version 时刻是否存在，存在时通过 value 返回当时的值
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::visible(const Node<K, V> *node, uint64_t read_version, V *value) {
+  if (node->version <= read_version) {
+    if (node->deleted) {
+      return false;
+    }
+    *value = node->get_value();
+    return true;
+  }
+  for (const MvccVersion<V> *v = node->older; v != nullptr; v = v->older) {
+    if (v->version <= read_version) {
+      if (v->deleted) {
+        return false;
+      }
+      *value = v->value;
+      return true;
+    }
+  }
+  return false;  // 该版本之后才插入
+}
+
+template <typename K, typename V, typename Compare>
+size_t SkipList<K, V, Compare>::free_versions(MvccVersion<V> *version) {
+  size_t freed = 0;
+  while (version != nullptr) {
+    MvccVersion<V> *older = version->older;
+    delete version;
+    version = older;
+    ++freed;
+  }
+  return freed;
+}
+
+// kLatestVersion 表示 "下一个版本"；显式版本号不会回退到 applied 之前
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::begin_write_unlocked(uint64_t version) {
+  if (!_mvcc) {
+    return;
+  }
+  _write_version = version == kLatestVersion ? _applied_version + 1 : std::max(version, _applied_version);
+}
+
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::end_write_unlocked() {
+  if (_mvcc) {
+    _applied_version = _write_version;
+  }
+}
+
+// 有读者 pin 在本次写入之前的版本上
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::readers_behind_unlocked() const {
+  return _mvcc && !_pins.empty() && *_pins.begin() < _write_version;
+}
+
+// 节点的当前值还可能被读到，不能原地覆盖 (同一批次内写过的值对任何读者都不可见)
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::keep_history_unlocked(const Node<K, V> *node) const {
+  return readers_behind_unlocked() && node->version < _write_version;
+}
+
+// 覆盖节点之前调用：需要时把当前版本挂到版本链上
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::push_version_unlocked(Node<K, V> *node) {
+  if (!keep_history_unlocked(node)) {
+    return;
+  }
+  node->older = new MvccVersion<V>{node->version, node->deleted, node->get_value(), node->older};
+  _versioned_nodes.insert(node);
+}
+
+template <typename K, typename V, typename Compare>
+std::unique_ptr<typename SkipList<K, V, Compare>::ReadPin> SkipList<K, V, Compare>::pin_version() {
+  if (!_mvcc) {
+    return nullptr;
+  }
+  std::unique_lock<std::shared_mutex> lock(_mtx);
+  return std::unique_ptr<ReadPin>(new ReadPin(this, _pins.insert(_applied_version)));
+}
+
+/**
+ * \brief pin 一个已有的版本 (例如 follower 读要求的 read index)
+ * \details 只有最老的 pin 之后的版本保证完整保留；没有 pin 时只能 pin 当前版本
+ */
+template <typename K, typename V, typename Compare>
+std::unique_ptr<typename SkipList<K, V, Compare>::ReadPin> SkipList<K, V, Compare>::pin_version(uint64_t version) {
+  if (!_mvcc) {
+    return nullptr;
+  }
+  std::unique_lock<std::shared_mutex> lock(_mtx);
+  uint64_t oldest = _pins.empty() ? _applied_version : *_pins.begin();
+  if (version < oldest || version > _applied_version) {
+    return nullptr;
+  }
+  return std::unique_ptr<ReadPin>(new ReadPin(this, _pins.insert(version)));
+}
+
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::unpin(ReadPin *pin) {
+  std::unique_lock<std::shared_mutex> lock(_mtx);
+  bool oldest = pin->_it == _pins.begin();
+  _pins.erase(pin->_it);
+  if (oldest && !_versioned_nodes.empty()) {
+    collect_versions_unlocked();
+  }
+}
+
+template <typename K, typename V, typename Compare>
+uint64_t SkipList<K, V, Compare>::applied_version() {
+  std::shared_lock<std::shared_mutex> lock(_mtx);
+  return _applied_version;
+}
+
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::set_applied_version(uint64_t version) {
+  std::unique_lock<std::shared_mutex> lock(_mtx);
+  _applied_version = std::max(_applied_version, version);
+}
+
+template <typename K, typename V, typename Compare>
+size_t SkipList<K, V, Compare>::collect_versions() {
+  std::unique_lock<std::shared_mutex> lock(_mtx);
+  return collect_versions_unlocked();
+}
+
+/**
+ * \brief 回收最老的读者 (没有读者时为 applied 版本) 也用不到的旧版本
+ * \details 所有读者的版本都 >= horizon，对它们来说 "<= horizon 的最新版本" 之前的版本都不可见：
+ * 节点本身 <= horizon 时整条版本链都可以丢弃 (墓碑直接摘除)，否则从链上第一个 <= horizon 的版本截断。
+ * 只遍历带历史的节点，不扫描整张表。
+ * \return 回收的版本 (含墓碑) 个数
+ */
+template <typename K, typename V, typename Compare>
+size_t SkipList<K, V, Compare>::collect_versions_unlocked() {
+  if (!_mvcc) {
+    return 0;
+  }
+  uint64_t horizon = _pins.empty() ? _applied_version : *_pins.begin();
+  size_t freed = 0;
+  std::vector<Node<K, V> *> dead;
+  for (auto it = _versioned_nodes.begin(); it != _versioned_nodes.end();) {
+    Node<K, V> *node = *it;
+    if (node->version <= horizon) {
+      freed += free_versions(node->older);
+      node->older = nullptr;
+      if (node->deleted) {
+        dead.push_back(node);
+        ++it;
+      } else {
+        it = _versioned_nodes.erase(it);
+      }
+      continue;
+    }
+    MvccVersion<V> *v = node->older;
+    while (v != nullptr && v->version > horizon) {
+      v = v->older;
+    }
+    if (v != nullptr) {
+      freed += free_versions(v->older);
+      v->older = nullptr;
+    }
+    ++it;
+  }
+
+  Node<K, V> *update[_max_level + 1];
+  for (Node<K, V> *node : dead) {
+    Node<K, V> *current = _header;
+    for (int i = _skip_list_level; i >= 0; i--) {
+      while (current->forward[i] != nullptr &&
+             node_before(current->forward[i], node->get_key(), node->key_prefix)) {
+        current = current->forward[i];
+      }
+      update[i] = current;
+    }
+    unlink_node_unlocked(node, update);
+    destroy_node(node);
+    ++freed;
+  }
+  return freed;
+}
+
 // Get current SkipList size
-template <typename K, typename V>
-int SkipList<K, V>::size() {
+template <typename K, typename V, typename Compare>
+int SkipList<K, V, Compare>::size() {
   return _element_count;
 }
 
-template <typename K, typename V>
-void SkipList<K, V>::get_key_value_from_string(const std::string &str, std::string *key, std::string *value) {
+template <typename K, typename V, typename Compare>
+size_t SkipList<K, V, Compare>::mem_usage() {
+  std::shared_lock<std::shared_mutex> lock(_mtx);
+  return _arena->memory_usage();
+}
+
+/**
+ * \brief 近似中位 key，用作区间分裂点
+ * \details 第 i 层大约每 2^i 个节点出现一次，在第 0 层上近似均匀分布：
+ * 从最高层往下找第一个节点数 >= kMedianSamples 的层，取该层中间的节点。
+ * 只遍历几十个节点，不需要 O(n) 计数；表较小时退化为第 0 层上的精确中位数。
+ * \return 元素少于 2 个 (无法分成两个非空区间) 时返回 false；
+ *         成功时 key 之前至少有一个元素，[key, +inf) 也非空
+ */
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::approximate_median_key(K *key) {
+  static constexpr int kMedianSamples = 32;
+  std::shared_lock<std::shared_mutex> lock(_mtx);
+  if (_element_count < 2) {
+    return false;
+  }
+  for (int i = _skip_list_level; i >= 0; --i) {
+    int count = 0;
+    for (Node<K, V> *node = _header->forward[i]; node != nullptr; node = node->forward[i]) {
+      ++count;
+    }
+    if (count < kMedianSamples && i > 0) {
+      continue;
+    }
+    // count >= 2 时中间节点在该层不是第一个，因此它之前至少还有一个元素
+    if (count < 2) {
+      continue;
+    }
+    Node<K, V> *node = _header->forward[i];
+    for (int k = 0; k < count / 2; ++k) {
+      node = node->forward[i];
+    }
+    *key = node->get_key();
+    return true;
+  }
+  return false;
+}
+
+/**
+ * \brief 把 [key, +inf) 的全部节点移到 right，不拷贝 key / value
+ * \details 在每一层把第一个 >= key 的节点从前驱上断开、接到 right 的 header 上，
+ * 只有 O(level) 次指针修改，另加一次遍历统计移走的个数。移走的节点内存仍在本表
+ * 的 arena 中，right 持有该 arena 的引用，两张表都 clear / 析构后才真正释放。
+ * \param right 必须为空，且与本表的最大层高相同
+ * \return 参数不满足要求时返回 false，两张表都不变
+ */
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::split_off(const K &key, SkipList<K, V, Compare> &right) {
+  if (&right == this) {
+    return false;
+  }
+  std::scoped_lock lock(_mtx, right._mtx);
+  if (right._element_count != 0 || right._max_level != _max_level || right._mvcc != _mvcc) {
+    return false;
+  }
+  if (_mvcc) {
+    // 版本链与墓碑不跟着节点搬：没有读者时全部回收，之后两张表都只剩最新版本
+    if (!_pins.empty() || !right._pins.empty()) {
+      return false;
+    }
+    collect_versions_unlocked();
+    right.collect_versions_unlocked();
+    right._applied_version = std::max(right._applied_version, _applied_version);
+  }
+
+  Node<K, V> *update[_max_level + 1];
+  memset(update, 0, sizeof(Node<K, V> *) * (_max_level + 1));
+  Node<K, V> *current = _header;
+  const uint32_t prefix = probe_prefix(key);
+  for (int i = _skip_list_level; i >= 0; i--) {
+    while (current->forward[i] != nullptr && node_before(current->forward[i], key, prefix)) {
+      current = current->forward[i];
+    }
+    update[i] = current;
+  }
+
+  for (int i = 0; i <= _skip_list_level; i++) {
+    right._header->forward[i] = update[i]->forward[i];
+    update[i]->forward[i] = nullptr;
+  }
+  int moved = 0;
+  for (Node<K, V> *node = right._header->forward[0]; node != nullptr; node = node->forward[0]) {
+    ++moved;
+  }
+  if (moved == 0) {
+    return true;
+  }
+  // 两张表的内容都变了，但不是逐个 key 的写入：快照与增量链作废
+  reset_snapshots_unlocked();
+  right.reset_snapshots_unlocked();
+  // 本表的过滤器仍然覆盖留下的 key (移走的只是多出一些误判)；缓存里移走的 key 必须清掉
+  if (_cache) {
+    _cache->clear();
+  }
+  if (right._cache) {
+    right._cache->clear();
+  }
+
+  right._element_count = moved;
+  right._skip_list_level = _skip_list_level;
+  _element_count -= moved;
+  while (_skip_list_level > 0 && _header->forward[_skip_list_level] == nullptr) {
+    _skip_list_level--;
+  }
+  while (right._skip_list_level > 0 && right._header->forward[right._skip_list_level] == nullptr) {
+    right._skip_list_level--;
+  }
+  if (right._filter) {
+    right.rebuild_filter_unlocked(right._filter->capacity());
+  }
+  // 移走的节点可能本身就是从更早的分裂中借来的
+  right._borrowed_arenas.push_back(_arena);
+  right._borrowed_arenas.insert(right._borrowed_arenas.end(), _borrowed_arenas.begin(), _borrowed_arenas.end());
+  return true;
+}
+
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::get_key_value_from_string(const std::string &str, std::string *key, std::string *value) {
   if (!is_valid_string(str)) {
     return;
   }
@@ -358,8 +1439,8 @@ void SkipList<K, V>::get_key_value_from_string(const std::string &str, std::stri
   *value = str.substr(str.find(delimiter) + 1, str.length());
 }
 
-template <typename K, typename V>
-bool SkipList<K, V>::is_valid_string(const std::string &str) {
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::is_valid_string(const std::string &str) {
   if (str.empty()) {
     return false;
   }
@@ -370,20 +1451,38 @@ bool SkipList<K, V>::is_valid_string(const std::string &str) {
 }
 
 // Delete element from skip list
-template <typename K, typename V>
-void SkipList<K, V>::delete_element(const K& key) {
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::delete_element(const K& key) {
+    OpTimer timer(op_histogram(&SkipListOpMetrics::remove));
     // 1. (改进 - 关键) 使用 std::unique_lock 管理写锁
     //    构造时自动加锁，析构时自动解锁。
     //    配合 shared_mutex，这会阻塞所有的 search 操作，保证数据安全。
     std::unique_lock<std::shared_mutex> lock(_mtx);
+    begin_write_unlocked(kLatestVersion);
+    delete_element_unlocked(key);
+    end_write_unlocked();
+    // 7. (改进) 无需手动 unlock，lock 对象析构时会自动释放锁
+}
+
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::delete_element(const K& key, uint64_t version) {
+    OpTimer timer(op_histogram(&SkipListOpMetrics::remove));
+    std::unique_lock<std::shared_mutex> lock(_mtx);
+    begin_write_unlocked(version);
+    delete_element_unlocked(key);
+    end_write_unlocked();
+}
 
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::delete_element_unlocked(const K& key) {
     Node<K, V> *current = this->_header;
     Node<K, V> *update[_max_level + 1];
     memset(update, 0, sizeof(Node<K, V> *) * (_max_level + 1));
 
     // 2. 查找要删除节点的前驱节点
+    const uint32_t prefix = probe_prefix(key);
     for (int i = _skip_list_level; i >= 0; i--) {
-        while (current->forward[i] != nullptr && current->forward[i]->get_key() < key) {
+        while (current->forward[i] != nullptr && node_before(current->forward[i], key, prefix)) {
             current = current->forward[i];
         }
         update[i] = current;
@@ -391,33 +1490,48 @@ void SkipList<K, V>::delete_element(const K& key) {
 
     current = current->forward[0];
 
-    // 3. 检查是否找到目标节点
-    if (current != nullptr && current->get_key() == key) {
-        
-        // 4. 从低层向高层，逐层解链
-        for (int i = 0; i <= _skip_list_level; i++) {
-            // 如果在第 i 层，前驱节点的下一个节点不是目标节点，
-            // 说明目标节点没有达到这一层高度，直接跳出循环
-            if (update[i]->forward[i] != current) break;
-
-            // 核心删除操作：前驱指向后继
-            update[i]->forward[i] = current->forward[i];
+    // 3. 检查是否找到目标节点 (MVCC 墓碑视为已删除)
+    if (current != nullptr && node_matches(current, key, prefix) && !current->deleted) {
+        record_write_unlocked(key, current);
+
+        if (readers_behind_unlocked()) {
+            // MVCC：还有读者 pin 在更老的版本上 (可能正需要节点或它的版本链)，留下墓碑，等回收时再摘除
+            push_version_unlocked(current);
+            current->set_value(V());
+            current->deleted = true;
+            current->version = _write_version;
+            _versioned_nodes.insert(current);
+            _element_count--;
+            return;
         }
 
-        // 5. 更新跳表的最大层级
-        // 如果删除了最高层的节点，且最高层变空了，需要降低层高
-        while (_skip_list_level > 0 && _header->forward[_skip_list_level] == nullptr) {
-            _skip_list_level--;
-        }
+        unlink_node_unlocked(current, update);
 
         // 6. (改进 - 性能) 移除 std::cout
         // std::cout << "Successfully deleted key " << key << std::endl;
         
-        delete current; // 释放内存
+        destroy_node(current); // 释放节点，空间留给后续插入复用
         _element_count--;
     }
-    
-    // 7. (改进) 无需手动 unlock，lock 对象析构时会自动释放锁
+}
+
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::unlink_node_unlocked(Node<K, V> *target, Node<K, V> **update) {
+    // 4. 从低层向高层，逐层解链
+    for (int i = 0; i <= _skip_list_level; i++) {
+        // 如果在第 i 层，前驱节点的下一个节点不是目标节点，
+        // 说明目标节点没有达到这一层高度，直接跳出循环
+        if (update[i]->forward[i] != target) break;
+
+        // 核心删除操作：前驱指向后继
+        update[i]->forward[i] = target->forward[i];
+    }
+
+    // 5. 更新跳表的最大层级
+    // 如果删除了最高层的节点，且最高层变空了，需要降低层高
+    while (_skip_list_level > 0 && _header->forward[_skip_list_level] == nullptr) {
+        _skip_list_level--;
+    }
 }
 
 /**
@@ -427,18 +1541,36 @@ void SkipList<K, V>::delete_element(const K& key) {
  * 2. 高性能：只进行一次 O(log n) 遍历。
  * 3. 内存优化：如果 key 存在，直接更新 value，避免了 delete+new 的开销。
  */
-template <typename K, typename V>
-void SkipList<K, V>::insert_set_element(const K& key, const V& value) {
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::insert_set_element(const K& key, const V& value) {
+  OpTimer timer(op_histogram(&SkipListOpMetrics::put));
   // 1. 获取独占锁 (写锁)
   std::unique_lock<std::shared_mutex> lock(_mtx);
+  begin_write_unlocked(kLatestVersion);
+  insert_set_element_unlocked(key, value);
+  end_write_unlocked();
+  // lock 析构自动解锁
+}
 
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::insert_set_element(const K& key, const V& value, uint64_t version) {
+  OpTimer timer(op_histogram(&SkipListOpMetrics::put));
+  std::unique_lock<std::shared_mutex> lock(_mtx);
+  begin_write_unlocked(version);
+  insert_set_element_unlocked(key, value);
+  end_write_unlocked();
+}
+
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::insert_set_element_unlocked(const K& key, const V& value) {
   Node<K, V> *current = this->_header;
   Node<K, V> *update[_max_level + 1];
   memset(update, 0, sizeof(Node<K, V> *) * (_max_level + 1));
 
   // 2. 查找位置 (一次遍历)
+  const uint32_t prefix = probe_prefix(key);
   for(int i = _skip_list_level; i >= 0; i--) {
-    while (current->forward[i] != nullptr && current->forward[i]->get_key() < key) {
+    while (current->forward[i] != nullptr && node_before(current->forward[i], key, prefix)) {
         current = current->forward[i];
     }
     update[i] = current;
@@ -447,15 +1579,23 @@ void SkipList<K, V>::insert_set_element(const K& key, const V& value) {
   current = current->forward[0];
 
   // 3. 情况 A: 键已存在 -> 原位更新 (Update)
-  if (current != nullptr && current->get_key() == key) {
+  if (current != nullptr && node_matches(current, key, prefix)) {
+      record_write_unlocked(key, current->deleted ? nullptr : current);
+      push_version_unlocked(current);
       current->set_value(value);
+      if (current->deleted) {
+          current->deleted = false;  // MVCC 墓碑复活
+          _element_count++;
+      }
+      current->version = _write_version;
       // std::cout << "Key already exists, updated value for key: " << key << std::endl;
       return; // 更新完成，直接返回
   }
 
   // 4. 情况 B: 键不存在 -> 插入新节点 (Insert)
   // (以下逻辑与 insert_element 完全一致)
-  if (current == nullptr || current->get_key() != key) {
+  if (current == nullptr || !node_matches(current, key, prefix)) {
+      record_write_unlocked(key, nullptr);
       int random_level = get_random_level();
       
       if (random_level > _skip_list_level) {
@@ -473,8 +1613,26 @@ void SkipList<K, V>::insert_set_element(const K& key, const V& value) {
       }
       _element_count++;
   }
-  
-  // lock 析构自动解锁
+}
+
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::apply_batch(const std::vector<WriteOp> &ops) {
+  apply_batch(ops, kLatestVersion);
+}
+
+// 整批使用同一个版本号：pin 在任何版本上的读者都看不到半个批次
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::apply_batch(const std::vector<WriteOp> &ops, uint64_t version) {
+  std::unique_lock<std::shared_mutex> lock(_mtx);
+  begin_write_unlocked(version);
+  for (const WriteOp &op : ops) {
+    if (op.is_delete) {
+      delete_element_unlocked(op.key);
+    } else {
+      insert_set_element_unlocked(op.key, op.value);
+    }
+  }
+  end_write_unlocked();
 }
 
 // Search for element in skip list
@@ -496,14 +1654,19 @@ level 1         1    4     10         30         50|           70       100
                                                    |
 level 0         1    4   9 10         30   40    50+-->60      70       100
 */
-template <typename K, typename V>
-bool SkipList<K, V>::search_element(const K& key, V &value) {
-  
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::search_element(const K& key, V &value) {
+  OpTimer timer(op_histogram(&SkipListOpMetrics::get));
   // 1. (改进 - 关键) 使用共享锁 (读锁)
   //    允许多个线程同时进入此函数进行查找，互不阻塞。
   //    但如果有线程持有独占锁(正在写)，这里会等待。
   std::shared_lock<std::shared_mutex> lock(_mtx);
+  return search_cached_unlocked(key, value);
+}
 
+template <typename K, typename V, typename Compare>
+template <typename Q>
+bool SkipList<K, V, Compare>::search_element_unlocked(const Q& key, V &value, uint64_t read_version) const {
   // 2. (改进 - 性能) 移除 std::cout
   //    高频调用的查找函数中绝对不能有 I/O 操作
   // std::cout << "search_element-----------------" << std::endl;
@@ -511,8 +1674,9 @@ bool SkipList<K, V>::search_element(const K& key, V &value) {
   Node<K, V> *current = _header;
 
   // 3. 从顶层向下查找
+  const uint32_t prefix = probe_prefix(key);
   for (int i = _skip_list_level; i >= 0; i--) {
-    while (current->forward[i] && current->forward[i]->get_key() < key) {
+    while (current->forward[i] && node_before(current->forward[i], key, prefix)) {
       current = current->forward[i];
     }
   }
@@ -520,15 +1684,381 @@ bool SkipList<K, V>::search_element(const K& key, V &value) {
   current = current->forward[0]; // 移动到第0层的目标节点
 
   // 4. (改进 - 风格) 使用 && 替代 and
-  if (current && current->get_key() == key) {
-    value = current->get_value();
+  if (current && node_matches(current, key, prefix)) {
     // std::cout << "Found key: " << key << ", value: " << current->get_value() << std::endl;
+    return visible(current, read_version, &value);
+  }
+
+  return false;
+}
+
+template <typename K, typename V, typename Compare>
+template <typename Q, typename C, typename>
+bool SkipList<K, V, Compare>::search_element(const Q& key, V &value) {
+  OpTimer timer(op_histogram(&SkipListOpMetrics::get));
+  std::shared_lock<std::shared_mutex> lock(_mtx);
+  if (_cache) {
+    // C++17 的 unordered_map 没有异构查找
+    return search_cached_unlocked(K(key), value);
+  }
+  if (filter_rejects_unlocked(key)) {
+    return false;
+  }
+  return search_element_unlocked(key, value);
+}
+
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::search_element(const K& key, V &value, const ReadPin &pin) {
+  OpTimer timer(op_histogram(&SkipListOpMetrics::get));
+  std::shared_lock<std::shared_mutex> lock(_mtx);
+  // 过滤器覆盖所有建过节点的 key (含 MVCC 墓碑)，对历史版本同样适用；缓存只有最新值
+  if (filter_rejects_unlocked(key)) {
+    return false;
+  }
+  return search_element_unlocked(key, value, pin.version());
+}
+
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::multi_get(const std::vector<K> &keys, std::vector<V> &values, std::vector<bool> &found) {
+  values.assign(keys.size(), V());
+  found.assign(keys.size(), false);
+  std::shared_lock<std::shared_mutex> lock(_mtx);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    found[i] = search_cached_unlocked(keys[i], values[i]);
+  }
+}
+
+/**
+ * \brief 开启 (或按新参数重建) 分块 bloom 过滤器，用现有的 key 建好，写锁下 O(n)
+ * \param expected_keys 预计的 key 数，0 表示关闭；add 过的 key 数达到容量后自动按两倍重建
+ */
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::enable_read_filter(size_t expected_keys, int bits_per_key) {
+  std::unique_lock<std::shared_mutex> lock(_mtx);
+  if (expected_keys == 0) {
+    _filter.reset();
+    _filter_keys = 0;
+    return;
+  }
+  _filter_bits_per_key = bits_per_key;
+  rebuild_filter_unlocked(std::max<size_t>(expected_keys, static_cast<size_t>(_element_count) * 2));
+}
+
+/**
+ * \brief 开启 (或替换) 热点 value 缓存，capacity 为 0 表示关闭
+ */
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::enable_value_cache(size_t capacity, size_t shards) {
+  std::unique_lock<std::shared_mutex> lock(_mtx);
+  _cache.reset(capacity == 0 ? nullptr : new ShardedClockCache<K, V>(capacity, shards));
+}
+
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::enable_op_metrics(const std::string &table) {
+  std::unique_lock<std::shared_mutex> lock(_mtx);
+  if (_op_metrics_storage) {
+    return;
+  }
+  MetricsRegistry &registry = MetricsRegistry::GetInstance();
+  const std::string name = "skiplist_op_latency_nanoseconds";
+  const std::string help = "SkipList operation latency including lock wait";
+  std::unique_ptr<SkipListOpMetrics> m(new SkipListOpMetrics());
+  m->get = registry.GetHistogram(name, {{"table", table}, {"op", "get"}}, help);
+  m->put = registry.GetHistogram(name, {{"table", table}, {"op", "put"}}, help);
+  m->remove = registry.GetHistogram(name, {{"table", table}, {"op", "delete"}}, help);
+  m->scan = registry.GetHistogram(name, {{"table", table}, {"op", "scan"}}, help);
+  _op_metrics.store(m.get(), std::memory_order_release);
+  _op_metrics_storage = std::move(m);
+}
+
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::rebuild_filter_unlocked(size_t expected_keys) {
+  std::unique_ptr<BlockedBloomFilter> filter(new BlockedBloomFilter(expected_keys, _filter_bits_per_key));
+  size_t keys = 0;
+  // MVCC 墓碑节点照样加入：pin 住的读者可能还看得到它们的旧版本
+  for (Node<K, V> *node = _header->forward[0]; node != nullptr; node = node->forward[0]) {
+    filter->add(key_hash(node->get_key()));
+    ++keys;
+  }
+  _filter = std::move(filter);
+  _filter_keys = keys;
+  ++_filter_rebuilds;
+}
+
+template <typename K, typename V, typename Compare>
+template <typename Q>
+uint64_t SkipList<K, V, Compare>::key_hash(const Q &key) {
+  return skiplist_mix_hash(static_cast<uint64_t>(SkipListKeyHash<K>{}(key)));
+}
+
+template <typename K, typename V, typename Compare>
+typename SkipList<K, V, Compare>::ReadCounters &SkipList<K, V, Compare>::read_counters(ReadCounters *stripes) {
+  static thread_local size_t stripe =
+      std::hash<std::thread::id>{}(std::this_thread::get_id()) % kReadCounterStripes;
+  return stripes[stripe];
+}
+
+// 调用方持有读锁或写锁
+template <typename K, typename V, typename Compare>
+template <typename Q>
+bool SkipList<K, V, Compare>::filter_rejects_unlocked(const Q &key) {
+  if (!_filter) {
+    return false;
+  }
+  ReadCounters &counters = read_counters(_read_counters);
+  counters.checks.fetch_add(1, std::memory_order_relaxed);
+  if (_filter->may_contain(key_hash(key))) {
+    return false;
+  }
+  counters.negatives.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+/**
+ * \brief 最新版本的点查：过滤器 -> 缓存 -> 跳表，找到的 value 回填缓存
+ * \details 调用方持有读锁：写方 (写锁) 在修改 key 之前 erase 缓存，不会与这里的回填交错，
+ * 缓存里因此不会留下被覆盖的旧值。
+ */
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::search_cached_unlocked(const K &key, V &value) {
+  if (filter_rejects_unlocked(key)) {
+    return false;
+  }
+  if (_cache && _cache->get(key, value)) {
+    return true;
+  }
+  if (search_element_unlocked(key, value)) {
+    if (_cache) {
+      _cache->put(key, value);
+    }
     return true;
   }
+  if (_filter) {
+    read_counters(_read_counters).false_positives.fetch_add(1, std::memory_order_relaxed);
+  }
+  return false;
+}
+
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::may_contain(const K &key) {
+  std::shared_lock<std::shared_mutex> lock(_mtx);
+  return !filter_rejects_unlocked(key);
+}
+
+template <typename K, typename V, typename Compare>
+SkipListReadStats SkipList<K, V, Compare>::read_stats() {
+  std::shared_lock<std::shared_mutex> lock(_mtx);
+  SkipListReadStats stats;
+  for (const ReadCounters &counters : _read_counters) {
+    stats.filter_checks += counters.checks.load(std::memory_order_relaxed);
+    stats.filter_negatives += counters.negatives.load(std::memory_order_relaxed);
+    stats.filter_false_positives += counters.false_positives.load(std::memory_order_relaxed);
+  }
+  stats.filter_rebuilds = _filter_rebuilds;
+  stats.filter_bytes = _filter ? _filter->memory_bytes() : 0;
+  if (_cache) {
+    stats.cache = _cache->stats();
+  }
+  return stats;
+}
 
+// 返回第一个 key >= 给定 key 的节点 (lower_bound)，不存在则返回 nullptr
+// 调用方负责持锁
+template <typename K, typename V, typename Compare>
+template <typename Q>
+Node<K, V> *SkipList<K, V, Compare>::find_greater_or_equal(const Q &key) const {
+  Node<K, V> *current = _header;
+  const uint32_t prefix = probe_prefix(key);
+  for (int i = _skip_list_level; i >= 0; i--) {
+    while (current->forward[i] && node_before(current->forward[i], key, prefix)) {
+      current = current->forward[i];
+    }
+  }
+  return current->forward[0];
+}
+
+template <typename K, typename V, typename Compare>
+template <typename Q>
+uint32_t SkipList<K, V, Compare>::probe_prefix(const Q &key) {
+  if constexpr (kKeyPrefix) {
+    return Compare::prefix(key);
+  } else {
+    return 0;
+  }
+}
+
+// 节点的 key 是否排在 key 之前；prefix 为 probe_prefix(key)，前缀不等时不做完整比较
+template <typename K, typename V, typename Compare>
+template <typename Q>
+bool SkipList<K, V, Compare>::node_before(const Node<K, V> *node, const Q &key, uint32_t prefix) const {
+  if constexpr (kKeyPrefix) {
+    if (node->key_prefix != prefix) {
+      return node->key_prefix < prefix;
+    }
+  }
+  return _compare(node->get_key(), key);
+}
+
+// node 是查找停下的位置 (第一个不小于 key 的节点)：只要 key 也不小于它，两者就相等
+template <typename K, typename V, typename Compare>
+template <typename Q>
+bool SkipList<K, V, Compare>::node_matches(const Node<K, V> *node, const Q &key, uint32_t prefix) const {
+  if constexpr (kKeyPrefix) {
+    if (node->key_prefix != prefix) {
+      return false;
+    }
+  }
+  return !_compare(key, node->get_key());
+}
+
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::scan_unlocked(const K &start_key, const K *end_key, int limit,
+                                   std::vector<std::pair<K, V>> &out, K *next_key, uint64_t read_version) {
+  Node<K, V> *node = find_greater_or_equal(start_key);
+  int count = 0;
+  V value;
+
+  while (node != nullptr) {
+    if (end_key != nullptr && !key_less(node->get_key(), *end_key)) {
+      return false;  // 越过右边界，扫描结束
+    }
+    if (!visible(node, read_version, &value)) {
+      node = node->forward[0];  // 该版本上不存在 (MVCC 墓碑 / 之后才插入)
+      continue;
+    }
+    if (limit > 0 && count >= limit) {
+      // 达到 limit 且区间内仍有数据：把下一个 key 作为续扫游标交给调用方
+      if (next_key != nullptr) {
+        *next_key = node->get_key();
+      }
+      return true;
+    }
+    out.emplace_back(node->get_key(), std::move(value));
+    ++count;
+    node = node->forward[0];
+  }
   return false;
 }
 
+/**
+ * \brief 范围扫描 [start_key, +inf)，对应 kv.proto 中 end_key 为空的 ScanRequest
+ * \param limit 最多返回的条数，<= 0 表示不限制
+ * \param out 结果按 key 升序追加到 out 末尾
+ * \param next_key 若返回 true，写入下一次扫描应使用的 start_key (续扫游标)
+ * \return has_more：区间内是否还有未返回的数据
+ * 复杂度 O(log n + k)，全程持有共享锁，不会像 dump_file 那样复制整张表。
+ */
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::scan(const K &start_key, int limit, std::vector<std::pair<K, V>> &out, K *next_key) {
+  OpTimer timer(op_histogram(&SkipListOpMetrics::scan));
+  std::shared_lock<std::shared_mutex> lock(_mtx);
+  return scan_unlocked(start_key, nullptr, limit, out, next_key);
+}
+
+/**
+ * \brief 范围扫描 [start_key, end_key)，语义与 kv.proto 的 ScanRequest 保持一致
+ */
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::scan(const K &start_key, const K &end_key, int limit, std::vector<std::pair<K, V>> &out,
+                          K *next_key) {
+  OpTimer timer(op_histogram(&SkipListOpMetrics::scan));
+  std::shared_lock<std::shared_mutex> lock(_mtx);
+  return scan_unlocked(start_key, &end_key, limit, out, next_key);
+}
+
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::scan(const ReadPin &pin, const K &start_key, int limit, std::vector<std::pair<K, V>> &out,
+                          K *next_key) {
+  OpTimer timer(op_histogram(&SkipListOpMetrics::scan));
+  std::shared_lock<std::shared_mutex> lock(_mtx);
+  return scan_unlocked(start_key, nullptr, limit, out, next_key, pin.version());
+}
+
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::scan(const ReadPin &pin, const K &start_key, const K &end_key, int limit,
+                          std::vector<std::pair<K, V>> &out, K *next_key) {
+  OpTimer timer(op_histogram(&SkipListOpMetrics::scan));
+  std::shared_lock<std::shared_mutex> lock(_mtx);
+  return scan_unlocked(start_key, &end_key, limit, out, next_key, pin.version());
+}
+
+/**
+ * \brief 流式范围扫描，按 options 切帧后逐帧交给 sink
+ * \details
+ * 每一帧单独获取一次共享锁：从游标 seek (O(log n))，沿第 0 层填满一帧后释放锁，
+ * 再调用 sink。sink 通常是阻塞在 HTTP/2 流控上的 ServerWriter::Write，在锁外调用
+ * 才不会因为慢客户端而长时间挡住写。代价是整个流不是一个时间点的快照：
+ * 帧与帧之间的写入可能被看到，与客户端按 has_more 分页续扫的语义相同。
+ * MVCC 模式下传入 pin 的版本 (read_version) 时，整个流都是该版本的一致切面。
+ * \return 扫描完成返回 true，sink 失败返回 false
+ */
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::scan_stream_impl(const K &start_key, const K *end_key, const ScanStreamOptions &options,
+                                      const ScanFrameSink &sink, uint64_t read_version) {
+  ScanFrame frame;
+  K cursor = start_key;
+  int total = 0;
+  V value;
+
+  while (true) {
+    frame.kvs.clear();
+    frame.last = true;
+    frame.has_more = false;
+    size_t bytes = 0;
+    {
+      std::shared_lock<std::shared_mutex> lock(_mtx);
+      for (Node<K, V> *node = find_greater_or_equal(cursor); node != nullptr; node = node->forward[0]) {
+        if (end_key != nullptr && !key_less(node->get_key(), *end_key)) {
+          break;  // 越过右边界
+        }
+        if (!visible(node, read_version, &value)) {
+          continue;
+        }
+        if (options.limit > 0 && total >= options.limit) {
+          frame.has_more = true;  // 被 limit 截断
+          frame.next_key = node->get_key();
+          break;
+        }
+        size_t entry = ScanByteSize<K>::of(node->get_key()) + ScanByteSize<V>::of(value);
+        bool frame_full = !frame.kvs.empty() &&
+                          (bytes + entry > options.frame_bytes ||
+                           (options.frame_keys > 0 && static_cast<int>(frame.kvs.size()) >= options.frame_keys));
+        if (frame_full) {
+          frame.last = false;
+          cursor = node->get_key();  // 下一帧从这里 seek
+          break;
+        }
+        frame.kvs.emplace_back(node->get_key(), std::move(value));
+        bytes += entry;
+        ++total;
+      }
+    }
+    if (!sink(frame)) {
+      return false;
+    }
+    if (frame.last) {
+      return true;
+    }
+  }
+}
+
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::scan_stream(const K &start_key, const ScanStreamOptions &options, const ScanFrameSink &sink) {
+  return scan_stream_impl(start_key, nullptr, options, sink);
+}
+
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::scan_stream(const K &start_key, const K &end_key, const ScanStreamOptions &options,
+                                 const ScanFrameSink &sink) {
+  return scan_stream_impl(start_key, &end_key, options, sink);
+}
+
+template <typename K, typename V, typename Compare>
+bool SkipList<K, V, Compare>::scan_stream(const ReadPin &pin, const K &start_key, const K &end_key,
+                                 const ScanStreamOptions &options, const ScanFrameSink &sink) {
+  return scan_stream_impl(start_key, &end_key, options, sink, pin.version());
+}
+
 template <typename K, typename V>
 void SkipListDump<K, V>::insert(const Node<K, V> &node) {
   keyDumpVt_.emplace_back(node.get_key());
@@ -536,50 +2066,70 @@ void SkipListDump<K, V>::insert(const Node<K, V> &node) {
 }
 
 // construct skip list
-template <typename K, typename V>
-SkipList<K, V>::SkipList(int max_level) 
+template <typename K, typename V, typename Compare>
+SkipList<K, V, Compare>::SkipList(int max_level, bool mvcc) 
     :_max_level(max_level),
     _skip_list_level(0),
-    _element_count(0) {
+    _element_count(0),
+    _free_nodes(max_level + 1, nullptr),
+    _mvcc(mvcc) {
 
     // 创建哨兵节点 (Header)
     // 注意：K() 和 V() 确保调用键值的默认构造函数
+    // header 不放在 arena 中，这样 clear() 可以直接整体释放 arena
     K k = K(); 
     V v = V();
-    this->_header = new Node<K, V>(k, v, _max_level);
+    void *mem = ::operator new(Node<K, V>::alloc_size(_max_level));
+    this->_header = new (mem) Node<K, V>(k, v, _max_level);
 }
 
 
-template <typename K, typename V>
-SkipList<K, V>::~SkipList() {
+template <typename K, typename V, typename Compare>
+SkipList<K, V, Compare>::~SkipList() {
   // 1. 文件流会自动关闭，无需手动 close
 
-  // 2. (改进 - 关键) 迭代删除所有节点，防止栈溢出
-  // 从 header 的第 0 层（最底层，包含所有节点）开始遍历
-  Node<K, V> *current = _header->forward[0];
-  
-  while (current != nullptr) {
-      Node<K, V> *next = current->forward[0]; // 先保存下一个节点
-      delete current;                         // 删除当前节点
-      current = next;                         // 移动指针
-  }
+  // 2. 析构所有节点的 key/value，节点内存随后由 _arena 析构时整体释放
+  clear(_header->forward[0]);
 
   // 3. 最后删除头节点
-  delete _header;
+  _header->~Node<K, V>();
+  ::operator delete(_header);
 }
 
 // 迭代版本的 clear，安全且高效，供析构函数和 load_file 复用。
-template <typename K, typename V>
-void SkipList<K, V>::clear(Node<K, V> * /*unused*/) {
+template <typename K, typename V, typename Compare>
+void SkipList<K, V, Compare>::clear(Node<K, V> * /*unused*/) {
     // 注意：这里的参数其实没用了，因为我们总是从 _header->forward[0] 开始删。
     // 为了接口兼容，或者你可以重构这个函数不带参数。
     
+    // 节点内存都在 arena 中：只需逐个调用析构释放 key/value 持有的资源，
+    // 平凡类型 (如 int) 连这一步都会被编译器优化掉
     Node<K, V> *current = _header->forward[0];
     while (current != nullptr) {
         Node<K, V> *next = current->forward[0];
-        delete current;
+        free_versions(current->older);  // MVCC 版本链在堆上
+        current->~Node<K, V>();
         current = next;
     }
+    _versioned_nodes.clear();
+
+    // 空闲链表上的节点已经析构过，随 arena 一起丢弃即可
+    std::fill(_free_nodes.begin(), _free_nodes.end(), nullptr);
+    if (_arena.use_count() == 1) {
+      _arena->reset();
+    } else {
+      // 分裂出去的表还有节点在这个 arena 中：交给它们，本表换一个新的
+      _arena = std::make_shared<Arena>();
+    }
+    _borrowed_arenas.clear();
+    reset_snapshots_unlocked();
+    if (_filter) {
+      _filter->clear();
+      _filter_keys = 0;
+    }
+    if (_cache) {
+      _cache->clear();
+    }
     
     // 重置 header 指针，防止悬空指针
     memset(_header->forward, 0, sizeof(Node<K, V> *) * (_max_level + 1));
@@ -587,10 +2137,10 @@ void SkipList<K, V>::clear(Node<K, V> * /*unused*/) {
     _skip_list_level = 0;
 }
 
-template <typename K, typename V>
+template <typename K, typename V, typename Compare>
 // 获取随机层高
 // 使用 std::mt19937（梅森旋转算法） 配合 thread_local 关键字，保证了每个线程拥有独立的随机数生成器
-int SkipList<K, V>::get_random_level() {
+int SkipList<K, V, Compare>::get_random_level() {
   static thread_local std::mt19937 generator(std::random_device{}());
   static thread_local std::uniform_int_distribution<int> distribution(0, 1);
 
@@ -0,0 +1,301 @@
+#ifndef SKIPLIST_SNAPSHOT_H
+#define SKIPLIST_SNAPSHOT_H
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <type_traits>
+
+/**
+ * @file snapshot.h
+ * @brief SkipList 流式快照格式
+ * @details
+ * 与 dump_file() 的 Boost 归档不同，这里的格式是按 key 升序逐条写出的长度前缀记录，
+ * 写端通过回调 (SnapshotSink) 以固定大小的 chunk 推送，读端通过 SnapshotSource 按需拉取，
+ * 整个过程中内存占用只有一个 chunk，不会把整张表复制成 string。
+ *
+ * 格式 (整数均为小端)：
+ *   header : magic "SLSN"(4B) | version u32 | entry_count u64
+ *   entry  : key_len u32 | key bytes | val_len u32 | val bytes      (重复 entry_count 次)
+ *   footer : 0xFFFFFFFF u32                                           (结束标记，用于识别截断)
+ *
+ * 增量快照 (只含上一次快照之后改动过的 key，按 key 升序)：
+ *   header : magic "SLSD"(4B) | version u32 | base_id u64 | id u64 | entry_count u64
+ *   entry  : op u8 (0 = put, 1 = delete) | key_len u32 | key bytes | [val_len u32 | val bytes]  (仅 put 有 value)
+ *   footer : 同上
+ * base_id / id 是 SkipList::Snapshot 的编号：增量只能叠加在编号为 base_id 的全量 (或增量) 之上。
+ */
+
+// 写端回调：返回 false 表示下游写失败，dump 立即中止
+using SnapshotSink = std::function<bool(const char *data, size_t len)>;
+// 读端回调：最多读 len 字节到 buf，返回实际读取字节数，0 表示 EOF，< 0 表示出错
+using SnapshotSource = std::function<ssize_t(char *buf, size_t len)>;
+
+constexpr char kSnapshotMagic[4] = {'S', 'L', 'S', 'N'};
+constexpr uint32_t kSnapshotVersion = 1;
+constexpr uint32_t kSnapshotFooter = 0xFFFFFFFFu;
+constexpr size_t kSnapshotChunkSize = 64 * 1024;
+constexpr char kDeltaSnapshotMagic[4] = {'S', 'L', 'S', 'D'};
+constexpr uint8_t kDeltaPut = 0;
+constexpr uint8_t kDeltaDelete = 1;
+// 写时复制快照每批遍历的 key 数：每批只持有一次共享锁，写方最多被挡住一批的时间
+constexpr size_t kSnapshotBatchKeys = 1024;
+
+inline void snapshot_put_u32(std::string &buf, uint32_t v) {
+  char b[4];
+  for (int i = 0; i < 4; ++i) b[i] = static_cast<char>((v >> (8 * i)) & 0xFF);
+  buf.append(b, 4);
+}
+
+inline void snapshot_put_u64(std::string &buf, uint64_t v) {
+  char b[8];
+  for (int i = 0; i < 8; ++i) b[i] = static_cast<char>((v >> (8 * i)) & 0xFF);
+  buf.append(b, 8);
+}
+
+inline uint32_t snapshot_get_u32(const char *p) {
+  uint32_t v = 0;
+  for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+  return v;
+}
+
+inline uint64_t snapshot_get_u64(const char *p) {
+  uint64_t v = 0;
+  for (int i = 0; i < 8; ++i) v |= static_cast<uint64_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+  return v;
+}
+
+/**
+ * @brief key/value 的二进制编解码
+ * 内置支持算术类型 (按主机字节序原样拷贝) 和 std::string；其他类型需要自行特化。
+ */
+template <typename T, typename Enable = void>
+struct SnapshotCodec;
+
+template <typename T>
+struct SnapshotCodec<T, typename std::enable_if<std::is_arithmetic<T>::value>::type> {
+  static void encode(const T &v, std::string &buf) { buf.append(reinterpret_cast<const char *>(&v), sizeof(T)); }
+  static bool decode(const char *data, size_t len, T &out) {
+    if (len != sizeof(T)) return false;
+    memcpy(&out, data, sizeof(T));
+    return true;
+  }
+};
+
+template <>
+struct SnapshotCodec<std::string> {
+  static void encode(const std::string &v, std::string &buf) { buf.append(v); }
+  static bool decode(const char *data, size_t len, std::string &out) {
+    out.assign(data, len);
+    return true;
+  }
+};
+
+/**
+ * @brief 写端缓冲：攒满一个 chunk 再交给 sink
+ */
+class SnapshotWriter {
+ public:
+  explicit SnapshotWriter(const SnapshotSink &sink, size_t chunk_size = kSnapshotChunkSize)
+      : sink_(sink), chunk_size_(chunk_size), ok_(true) {
+    buf_.reserve(chunk_size_ + 64);
+  }
+
+  void write_header(uint64_t count) {
+    buf_.append(kSnapshotMagic, sizeof(kSnapshotMagic));
+    snapshot_put_u32(buf_, kSnapshotVersion);
+    snapshot_put_u64(buf_, count);
+  }
+
+  void write_delta_header(uint64_t base_id, uint64_t id, uint64_t count) {
+    buf_.append(kDeltaSnapshotMagic, sizeof(kDeltaSnapshotMagic));
+    snapshot_put_u32(buf_, kSnapshotVersion);
+    snapshot_put_u64(buf_, base_id);
+    snapshot_put_u64(buf_, id);
+    snapshot_put_u64(buf_, count);
+  }
+
+  template <typename K, typename V>
+  bool write_entry(const K &key, const V &value) {
+    append_field<K>(key);
+    append_field<V>(value);
+    return buf_.size() < chunk_size_ || flush();
+  }
+
+  template <typename K, typename V>
+  bool write_put(const K &key, const V &value) {
+    buf_.push_back(static_cast<char>(kDeltaPut));
+    return write_entry(key, value);
+  }
+
+  template <typename K>
+  bool write_delete(const K &key) {
+    buf_.push_back(static_cast<char>(kDeltaDelete));
+    append_field<K>(key);
+    return buf_.size() < chunk_size_ || flush();
+  }
+
+  bool finish() {
+    snapshot_put_u32(buf_, kSnapshotFooter);
+    return flush();
+  }
+
+  bool ok() const { return ok_; }
+
+ private:
+  // 先占 4 字节长度位，编码后回填，避免为每个字段构造临时 string
+  template <typename T>
+  void append_field(const T &v) {
+    size_t len_pos = buf_.size();
+    buf_.append(4, '\0');
+    SnapshotCodec<T>::encode(v, buf_);
+    uint32_t len = static_cast<uint32_t>(buf_.size() - len_pos - 4);
+    for (int i = 0; i < 4; ++i) buf_[len_pos + i] = static_cast<char>((len >> (8 * i)) & 0xFF);
+  }
+
+  bool flush() {
+    if (ok_ && !buf_.empty()) {
+      ok_ = sink_(buf_.data(), buf_.size());
+    }
+    buf_.clear();
+    return ok_;
+  }
+
+  const SnapshotSink &sink_;
+  size_t chunk_size_;
+  std::string buf_;
+  bool ok_;
+};
+
+/**
+ * @brief 读端缓冲：从 source 按 chunk 拉取，向上层提供 "读 n 字节" 的接口
+ */
+class SnapshotReader {
+ public:
+  explicit SnapshotReader(const SnapshotSource &source, size_t chunk_size = kSnapshotChunkSize)
+      : source_(source), buf_(chunk_size, '\0'), pos_(0), end_(0) {}
+
+  // 读取恰好 n 字节；返回指向内部缓冲或 scratch 的指针，数据截断时返回 nullptr
+  const char *read(size_t n, std::string &scratch) {
+    if (end_ - pos_ >= n) {
+      const char *p = buf_.data() + pos_;
+      pos_ += n;
+      return p;
+    }
+    // 跨 chunk 或超过 chunk 大小的字段：拼到 scratch 里
+    scratch.assign(buf_.data() + pos_, end_ - pos_);
+    pos_ = end_;
+    while (scratch.size() < n) {
+      if (!fill()) return nullptr;
+      size_t take = std::min(n - scratch.size(), end_ - pos_);
+      scratch.append(buf_.data() + pos_, take);
+      pos_ += take;
+    }
+    return scratch.data();
+  }
+
+  bool read_u8(uint8_t &v) {
+    const char *p = read(1, scratch_);
+    if (p == nullptr) return false;
+    v = static_cast<uint8_t>(*p);
+    return true;
+  }
+
+  bool read_u32(uint32_t &v) {
+    const char *p = read(4, scratch_);
+    if (p == nullptr) return false;
+    v = snapshot_get_u32(p);
+    return true;
+  }
+
+  bool read_u64(uint64_t &v) {
+    const char *p = read(8, scratch_);
+    if (p == nullptr) return false;
+    v = snapshot_get_u64(p);
+    return true;
+  }
+
+  // 读取并校验 header，返回条目数
+  bool read_header(uint64_t &count) {
+    const char *p = read(sizeof(kSnapshotMagic), scratch_);
+    if (p == nullptr || memcmp(p, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0) return false;
+    uint32_t version = 0;
+    if (!read_u32(version) || version != kSnapshotVersion) return false;
+    return read_u64(count);
+  }
+
+  // 读取并校验增量快照的 header
+  bool read_delta_header(uint64_t &base_id, uint64_t &id, uint64_t &count) {
+    const char *p = read(sizeof(kDeltaSnapshotMagic), scratch_);
+    if (p == nullptr || memcmp(p, kDeltaSnapshotMagic, sizeof(kDeltaSnapshotMagic)) != 0) return false;
+    uint32_t version = 0;
+    if (!read_u32(version) || version != kSnapshotVersion) return false;
+    return read_u64(base_id) && read_u64(id) && read_u64(count);
+  }
+
+  // 读取一个长度前缀字段并解码
+  template <typename T>
+  bool read_field(T &out) {
+    uint32_t len = 0;
+    if (!read_u32(len)) return false;
+    const char *p = read(len, field_scratch_);
+    return p != nullptr && SnapshotCodec<T>::decode(p, len, out);
+  }
+
+ private:
+  bool fill() {
+    ssize_t n;
+    do {
+      n = source_(&buf_[0], buf_.size());
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) return false;
+    pos_ = 0;
+    end_ = static_cast<size_t>(n);
+    return true;
+  }
+
+  const SnapshotSource &source_;
+  std::string buf_;
+  size_t pos_;
+  size_t end_;
+  std::string scratch_;
+  std::string field_scratch_;
+};
+
+// 把 sink 绑定到文件描述符：循环 write 直到写完
+inline SnapshotSink make_fd_sink(int fd) {
+  return [fd](const char *data, size_t len) {
+    while (len > 0) {
+      ssize_t n = ::write(fd, data, len);
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        return false;
+      }
+      data += n;
+      len -= static_cast<size_t>(n);
+    }
+    return true;
+  };
+}
+
+inline SnapshotSource make_fd_source(int fd) {
+  return [fd](char *buf, size_t len) -> ssize_t { return ::read(fd, buf, len); };
+}
+
+// 从内存中的快照读取 (例如 Raft InstallSnapshot 收到的 data 字段)
+inline SnapshotSource make_string_source(const std::string &data) {
+  size_t offset = 0;
+  return [&data, offset](char *buf, size_t len) mutable -> ssize_t {
+    size_t n = std::min(len, data.size() - offset);
+    memcpy(buf, data.data() + offset, n);
+    offset += n;
+    return static_cast<ssize_t>(n);
+  };
+}
+
+#endif  // SKIPLIST_SNAPSHOT_H
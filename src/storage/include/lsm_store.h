@@ -0,0 +1,203 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "skipList.h"
+#include "sstable.h"
+
+namespace storage {
+
+// memtable 的跳表：透明比较器 + key 前缀，string_view 的点查 / Seek 不必先拷贝成 std::string
+using MemTableList = SkipList<std::string, std::string, StringKeyCompare>;
+
+struct LsmOptions {
+    std::string dir;                          // 数据目录 (不存在则创建)
+    size_t memtable_bytes = 4 * 1024 * 1024;  // memtable 写满后冻结，交给后台线程落盘
+    size_t max_immutable_memtables = 2;       // 等待落盘的 memtable 超过这个数时写入阻塞 (写停顿)
+    int l0_compaction_trigger = 4;            // L0 文件数达到后合并进 L1
+    uint64_t level1_bytes = 10 * 1024 * 1024; // L1 的目标大小，往下每层乘以 level_multiplier
+    int level_multiplier = 10;
+    uint64_t target_file_bytes = 2 * 1024 * 1024;  // compaction 输出文件的目标大小
+    int num_levels = 7;
+    bool sync = true;                         // false 时 SSTable / MANIFEST 不 fsync (仅用于测试)
+    TableOptions table;
+};
+
+struct LsmStats {
+    std::vector<size_t> level_files;
+    std::vector<uint64_t> level_bytes;
+    size_t immutable_memtables = 0;
+    uint64_t flushes = 0;
+    uint64_t compactions = 0;
+    uint64_t trivial_moves = 0;   // 只改 MANIFEST、不重写数据的下推
+    uint64_t write_stalls = 0;
+    uint64_t bloom_filtered = 0;  // 被 bloom 过滤器直接排除的 SSTable 查找
+};
+
+/**
+ * @brief 以 SkipList 为 memtable 的 LSM 存储引擎
+ * @details
+ * 1. 写入：Put / Delete 写进活跃 memtable (MemTableList，value 带类型标记，删除写墓碑)；
+ *    memtable 达到 memtable_bytes 后冻结成只读，后台线程按冻结顺序把它写成 L0 的 SSTable。
+ *    memtable 不写 WAL：每次写入带上 Raft 日志 index，MANIFEST 记录已落盘的最大 index (DurableIndex)，
+ *    重启后 Raft 从 DurableIndex + 1 重放日志即可补齐 memtable，而不用重读整份快照。
+ * 2. 读取：活跃 memtable -> 冻结的 memtable (新到旧) -> L0 (新到旧，文件区间可能重叠) -> L1.. (每层文件不重叠，二分定位)，
+ *    第一次命中 (包括墓碑) 即返回；每个 SSTable 先查 bloom 过滤器。
+ * 3. 分层 compaction (后台线程)：L0 文件数达到 l0_compaction_trigger，或 Ln 总大小超过目标大小时，
+ *    选一个 Ln 文件 (Ln 按 key 轮转) 与 Ln+1 中重叠的文件归并成新的 Ln+1 文件；
+ *    Ln+1 没有重叠时直接下推 (trivial move)。更深的层都不含这个 key 时墓碑在归并中被丢弃。
+ * 4. 版本：当前的文件列表 (Version) 不可变，flush / compaction 生成新版本后原子替换；
+ *    读者和快照持有旧版本的引用，被替换的文件在最后一个引用释放时才删除。
+ * 5. MANIFEST：整份重写 (tmp + fsync + rename)，记录每层的文件、下一个文件号与 DurableIndex；
+ *    Open 时删除 MANIFEST 之外的 .sst (flush / compaction 中途崩溃留下的)。
+ * 6. Raft 快照：Checkpoint 先把 memtable 落盘，再把当前版本的 SSTable 硬链接到快照目录并写一份 MANIFEST。
+ *    SSTable 不可变，快照不需要序列化任何数据；快照目录本身就是一个可以直接 Open 的数据目录。
+ *
+ * 所有方法线程安全；写入方法期望由单个 apply 线程按 index 顺序调用。
+ */
+class LsmStore {
+public:
+    explicit LsmStore(const LsmOptions& options);
+    ~LsmStore();
+
+    LsmStore(const LsmStore&) = delete;
+    LsmStore& operator=(const LsmStore&) = delete;
+
+    /**
+     * @brief 打开目录、加载 MANIFEST 中的 SSTable，并启动后台线程
+     * @return 失败时返回 false，原因写入 error
+     */
+    bool Open(std::string* error = nullptr);
+
+    /**
+     * @brief 把 memtable 落盘后停止后台线程 (析构时自动调用)
+     */
+    void Close();
+
+    // ========== 读写 ==========
+
+    /**
+     * @param index 这次写入对应的 Raft 日志 index (0 表示不推进)
+     * @return 存储已关闭或后台落盘失败时返回 false
+     */
+    bool Put(const std::string& key, const std::string& value, uint64_t index = 0);
+    bool Delete(const std::string& key, uint64_t index = 0);
+
+    /**
+     * @return 找到时返回 true；返回 false 且 error 非空表示读到了损坏的 SSTable
+     */
+    bool Get(const std::string& key, std::string* value, std::string* error = nullptr);
+
+    /**
+     * @brief 有序扫描 [start, end)，end 为空表示没有上界，最多返回 limit 条 (0 表示不限)
+     * @param next_key 还有更多数据时写入下一页的起始 key
+     * @return 还有更多数据时返回 true
+     */
+    bool Scan(const std::string& start, const std::string& end, size_t limit,
+              std::vector<std::pair<std::string, std::string>>* out, std::string* next_key = nullptr);
+
+    // ========== 持久化 / 快照 ==========
+
+    // 最后一次写入的 index
+    uint64_t AppliedIndex() const;
+    // 已写进 SSTable 并记入 MANIFEST 的最大 index：重启后从它的下一条开始重放 Raft 日志
+    uint64_t DurableIndex() const;
+
+    /**
+     * @brief 冻结当前 memtable 并等待它 (以及之前冻结的) 落盘
+     */
+    bool Flush(std::string* error = nullptr);
+
+    /**
+     * @brief 等待后台线程处理完所有待落盘的 memtable 与应做的 compaction
+     */
+    void WaitForIdle();
+
+    /**
+     * @brief 生成 Raft 快照：以硬链接引用当前的 SSTable，并写入对应的 MANIFEST
+     * @param dir 快照目录 (不存在则创建，不能已有数据)
+     * @param index 输出快照包含的最大日志 index
+     */
+    bool Checkpoint(const std::string& dir, uint64_t* index, std::string* error = nullptr);
+
+    LsmStats GetStats() const;
+
+private:
+    struct MemTable {
+        MemTable();
+        MemTableList list;
+        size_t bytes = 0;
+        uint64_t id = 0;
+        uint64_t last_index = 0;
+    };
+
+    struct FileMeta {
+        uint64_t number = 0;
+        uint64_t file_bytes = 0;
+        std::string smallest;
+        std::string largest;
+        std::shared_ptr<Table> table;
+    };
+
+    // 不可变的文件列表：L0 按新到旧排列，L1.. 按 smallest 升序且互不重叠
+    struct Version {
+        std::vector<std::vector<std::shared_ptr<FileMeta>>> levels;
+        uint64_t durable_index = 0;
+    };
+
+    struct Compaction {
+        int level = 0;
+        std::vector<std::shared_ptr<FileMeta>> inputs;   // level 层的输入
+        std::vector<std::shared_ptr<FileMeta>> overlaps; // level + 1 层与之重叠的文件
+    };
+
+    bool Write(const std::string& key, char tag, const std::string& value, uint64_t index);
+    void FreezeLocked();
+    void BackgroundLoop();
+    bool NeedsCompactionLocked() const;
+    bool FlushMemTable(const std::shared_ptr<MemTable>& mem);
+    bool PickCompactionLocked(Compaction* c);
+    bool RunCompaction(const Compaction& c);
+    bool IsBottommost(const Version& v, int output_level, std::string_view key) const;
+
+    std::string TablePath(const std::string& dir, uint64_t number) const;
+    bool WriteManifest(const std::string& dir, const Version& v, uint64_t next_file, std::string* error) const;
+    bool LoadManifest(std::string* error);
+    void RemoveOrphanTables();
+    uint64_t MaxBytesForLevel(int level) const;
+    static uint64_t LevelBytes(const std::vector<std::shared_ptr<FileMeta>>& files);
+    void FailLocked(const std::string& what);
+
+    LsmOptions options_;
+
+    std::mutex write_mu_;    // 串行化写入 / 冻结，先于 mu_ 加锁
+    mutable std::mutex mu_;  // 保护下面的状态；持有时间只有指针交换那么长
+    std::condition_variable bg_cv_;    // 唤醒后台线程
+    std::condition_variable done_cv_;  // flush / compaction 完成 (唤醒被停顿的写入、Flush、WaitForIdle)
+    std::shared_ptr<MemTable> mem_;
+    std::deque<std::shared_ptr<MemTable>> imm_;  // 队首最老
+    std::shared_ptr<const Version> current_;
+    uint64_t next_file_number_ = 1;
+    uint64_t next_mem_id_ = 1;
+    uint64_t flushed_mem_id_ = 0;  // 已落盘的最大 memtable id
+    uint64_t applied_index_ = 0;
+    std::vector<std::string> compact_pointer_;  // 每层下一次从哪个 key 之后选文件
+    bool compacting_ = false;
+    bool opened_ = false;
+    bool closing_ = false;
+    std::string bg_error_;
+    LsmStats stats_;
+    std::atomic<uint64_t> bloom_filtered_{0};
+    std::thread bg_thread_;
+};
+
+}  // namespace storage
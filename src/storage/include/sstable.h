@@ -0,0 +1,232 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace storage {
+
+/**
+ * @file sstable.h
+ * @brief 不可变的有序表文件 (SSTable)
+ * @details
+ * 1. 文件布局：data block* | filter block | index block | footer
+ *    footer (40B，小端)：filter offset u64 | filter size u64 | index offset u64 | index size u64 | magic u64
+ * 2. block：前缀压缩的有序记录，每 restart_interval 条放一个重启点 (完整 key)，块尾是重启点数组：
+ *      entry   : shared varint | non_shared varint | value_len varint | key 后缀 | value
+ *      trailer : restart u32 * n | n u32
+ *    落盘时每个 block 后跟 type u8 (0 = 原样, 1 = zlib) | crc32c u32 (覆盖 payload 与 type)；
+ *    zlib payload 以 varint 原始长度开头，压缩后没有省下 1/8 就原样存放。
+ * 3. 稀疏索引：index block 每个 data block 一条，key = 该块最后一个 key，value = varint offset | varint size，
+ *    打开表时整块读入内存，点查只读一个 data block。
+ * 4. filter block：整个文件的 bloom 过滤器 (bits | k u8)，点查不存在的 key 时大多不用碰磁盘。
+ * 5. value 的首字节是类型标记 (kTagValue / kTagDeletion)，删除标记在 compaction 到最底层之前一直保留。
+ */
+
+constexpr uint64_t kTableMagic = 0x4c534d5353544231ull;  // "1BTSSMSL"
+constexpr size_t kTableFooterSize = 40;
+constexpr size_t kBlockTrailerSize = 5;  // type u8 | crc32c u32
+constexpr uint8_t kBlockRaw = 0;
+constexpr uint8_t kBlockZlib = 1;
+
+// value 首字节：LSM 各层 (memtable / SSTable) 统一用 "标记 + 用户 value" 的编码
+constexpr char kTagDeletion = 0;
+constexpr char kTagValue = 1;
+
+struct TableOptions {
+    size_t block_size = 4096;   // data block 未压缩的目标大小
+    int restart_interval = 16;  // 每隔多少条记录放一个重启点
+    int bloom_bits_per_key = 10;  // 0 表示不生成过滤器；10 bit/key 时误判率约 1%
+    bool compress = true;       // data block 用 zlib 压缩
+};
+
+struct BlockHandle {
+    uint64_t offset = 0;
+    uint64_t size = 0;  // payload 长度 (不含 trailer)
+};
+
+// ========== bloom 过滤器 ==========
+
+// 稳定的 64 位 key 哈希 (落盘格式依赖它，不能用 std::hash)
+uint64_t BloomHash(std::string_view key);
+// 由 key 哈希构造过滤器
+std::string BuildBloomFilter(const std::vector<uint64_t>& hashes, int bits_per_key);
+// 过滤器为空或格式不认识时返回 true (不能据此排除)
+bool BloomMayContain(std::string_view filter, uint64_t hash);
+
+// ========== block ==========
+
+class BlockBuilder {
+public:
+    explicit BlockBuilder(int restart_interval);
+
+    // key 必须严格递增
+    void Add(std::string_view key, std::string_view value);
+    // 追加重启点数组，返回的视图在 Reset 前有效
+    std::string_view Finish();
+    void Reset();
+
+    size_t SizeEstimate() const { return buf_.size() + (restarts_.size() + 1) * 4; }
+    bool Empty() const { return buf_.empty(); }
+
+private:
+    int restart_interval_;
+    std::string buf_;
+    std::vector<uint32_t> restarts_;
+    int counter_ = 0;
+    std::string last_key_;
+};
+
+/**
+ * @brief 遍历一个已解码的 block
+ * @details contents 为共享所有权，迭代器存活期间 block 不会被释放。格式错误时 Valid() 变为 false 且 corrupted() 为 true。
+ */
+class BlockIter {
+public:
+    BlockIter() = default;
+    explicit BlockIter(std::shared_ptr<const std::string> contents);
+
+    bool Valid() const { return valid_; }
+    void SeekToFirst();
+    // 定位到第一个 >= target 的记录
+    void Seek(std::string_view target);
+    void Next();
+    std::string_view key() const { return key_; }
+    std::string_view value() const { return value_; }
+    bool corrupted() const { return corrupted_; }
+
+private:
+    bool ParseAt(size_t offset);
+    uint32_t RestartPoint(uint32_t i) const;
+    void Corrupt();
+
+    std::shared_ptr<const std::string> contents_;
+    uint32_t num_restarts_ = 0;
+    size_t restarts_offset_ = 0;
+    size_t next_ = 0;  // 下一条记录的偏移
+    std::string key_;
+    std::string_view value_;
+    bool valid_ = false;
+    bool corrupted_ = false;
+};
+
+// ========== 写 ==========
+
+/**
+ * @brief 顺序写出一个 SSTable
+ * @details Add 的 key 必须严格递增；Finish 之后 fdatasync 并关闭文件，失败时文件由调用方删除。
+ */
+class TableBuilder {
+public:
+    TableBuilder(const TableOptions& options, int fd);
+    ~TableBuilder();
+
+    TableBuilder(const TableBuilder&) = delete;
+    TableBuilder& operator=(const TableBuilder&) = delete;
+
+    bool Add(std::string_view key, std::string_view value);
+    bool Finish(bool sync, std::string* error = nullptr);
+
+    uint64_t NumEntries() const { return num_entries_; }
+    uint64_t FileSize() const { return offset_; }
+    const std::string& smallest() const { return smallest_; }
+    const std::string& largest() const { return last_key_; }
+
+private:
+    bool FlushDataBlock();
+    bool WriteBlock(std::string_view raw, bool compress, BlockHandle* handle);
+    bool WriteRaw(const char* data, size_t len);
+
+    TableOptions options_;
+    int fd_;
+    bool ok_ = true;
+    uint64_t offset_ = 0;
+    uint64_t num_entries_ = 0;
+    BlockBuilder data_block_;
+    BlockBuilder index_block_;
+    std::vector<uint64_t> key_hashes_;
+    std::string smallest_;
+    std::string last_key_;
+    std::string compressed_;
+};
+
+// ========== 读 ==========
+
+class KvIterator {
+public:
+    virtual ~KvIterator() = default;
+    virtual bool Valid() const = 0;
+    virtual void SeekToFirst() = 0;
+    virtual void Seek(std::string_view target) = 0;
+    virtual void Next() = 0;
+    virtual std::string_view key() const = 0;
+    virtual std::string_view value() const = 0;
+    // 遍历因数据损坏提前结束时为 true
+    virtual bool corrupted() const { return false; }
+};
+
+/**
+ * @brief 打开的只读 SSTable
+ * @details
+ * 索引与过滤器常驻内存，data block 按需用 pread 读取，多个线程可以同时 Get / 遍历。
+ * MarkObsolete 之后，最后一个引用释放时删除文件：compaction 替换掉的表在仍被读者或快照引用时继续可读。
+ */
+class Table : public std::enable_shared_from_this<Table> {
+public:
+    enum class Lookup { kFound, kNotFound, kFiltered, kCorruption };
+
+    static std::shared_ptr<Table> Open(const std::string& path, std::string* error = nullptr);
+    ~Table();
+
+    Table(const Table&) = delete;
+    Table& operator=(const Table&) = delete;
+
+    // 点查：kFound 时 value 为带类型标记的原始 value；kFiltered 表示被 bloom 过滤器直接排除
+    Lookup Get(std::string_view key, std::string* value) const;
+    std::unique_ptr<KvIterator> NewIterator() const;
+
+    const std::string& path() const { return path_; }
+    uint64_t file_size() const { return file_size_; }
+    void MarkObsolete() { obsolete_.store(true); }
+
+private:
+    class Iter;
+
+    Table() = default;
+    bool ReadBlock(const BlockHandle& handle, std::string* out) const;
+
+    std::string path_;
+    int fd_ = -1;
+    uint64_t file_size_ = 0;
+    std::shared_ptr<const std::string> index_;
+    std::string filter_;
+    std::atomic<bool> obsolete_{false};
+};
+
+/**
+ * @brief 多路归并：按 key 升序输出，同一个 key 只输出优先级最高的 (children 下标最小的) 那一条
+ * @details children 按新旧排列 (0 最新)，因此较新的写入 / 删除标记遮住旧层的同名 key。
+ */
+class MergingIterator : public KvIterator {
+public:
+    explicit MergingIterator(std::vector<std::unique_ptr<KvIterator>> children);
+
+    bool Valid() const override { return current_ >= 0; }
+    void SeekToFirst() override;
+    void Seek(std::string_view target) override;
+    void Next() override;
+    std::string_view key() const override { return children_[current_]->key(); }
+    std::string_view value() const override { return children_[current_]->value(); }
+    bool corrupted() const override;
+
+private:
+    void FindSmallest();
+
+    std::vector<std::unique_ptr<KvIterator>> children_;
+    int current_ = -1;
+};
+
+}  // namespace storage
@@ -0,0 +1,880 @@
+#include "lsm_store.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <set>
+
+#include "crc32c.h"
+#include "opCodec.h"
+
+namespace storage {
+
+namespace {
+
+constexpr int kMemTableMaxLevel = 16;     // 4MB memtable 约几万个 key，16 层足够
+constexpr size_t kMemEntryOverhead = 80;  // 节点 + 两个 std::string 头 + 平均两层指针的估算
+constexpr char kManifestFile[] = "MANIFEST";
+constexpr char kManifestTmpFile[] = "MANIFEST.tmp";
+constexpr uint32_t kManifestMagic = 0x4d4d534c;  // "LSMM"
+
+inline void PutU32(char* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<char>((v >> (8 * i)) & 0xFF);
+}
+
+inline uint32_t GetU32(const char* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+    return v;
+}
+
+bool SetError(std::string* error, const std::string& what) {
+    if (error) {
+        *error = what + ": " + strerror(errno);
+    }
+    return false;
+}
+
+bool WriteAll(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool ReadFile(const std::string& path, std::string* out) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    char buf[64 * 1024];
+    out->clear();
+    while (true) {
+        ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ::close(fd);
+            return false;
+        }
+        if (n == 0) break;
+        out->append(buf, static_cast<size_t>(n));
+    }
+    ::close(fd);
+    return true;
+}
+
+bool SyncDir(const std::string& dir) {
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return false;
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+// 跨文件系统无法硬链接时退化为拷贝
+bool LinkOrCopy(const std::string& src, const std::string& dst) {
+    if (::link(src.c_str(), dst.c_str()) == 0) return true;
+    if (errno != EXDEV) return false;
+    std::string data;
+    if (!ReadFile(src, &data)) return false;
+    int fd = ::open(dst.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    bool ok = WriteAll(fd, data.data(), data.size()) && ::fdatasync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+bool ParseTableName(const char* name, uint64_t* number) {
+    size_t len = strlen(name);
+    if (len <= 4 || strcmp(name + len - 4, ".sst") != 0) return false;
+    uint64_t v = 0;
+    for (size_t i = 0; i + 4 < len; ++i) {
+        if (name[i] < '0' || name[i] > '9') return false;
+        v = v * 10 + static_cast<uint64_t>(name[i] - '0');
+    }
+    *number = v;
+    return true;
+}
+
+inline bool IsLive(std::string_view raw) { return !raw.empty() && raw[0] == kTagValue; }
+
+// 带类型标记的 value：墓碑返回 false
+bool DecodeValue(const std::string& raw, std::string* value) {
+    if (!IsLive(raw)) return false;
+    value->assign(raw, 1, std::string::npos);
+    return true;
+}
+
+/**
+ * @brief memtable 的归并输入：SkipList::Iterator 在存活期间持有跳表的共享锁
+ * @details key() / value() 按值返回，这里缓存当前位置的一份拷贝供 string_view 引用。
+ */
+class MemIter : public KvIterator {
+public:
+    MemIter(std::shared_ptr<void> owner, MemTableList* list)
+        : owner_(std::move(owner)), it_(list) {}
+
+    bool Valid() const override { return it_.valid(); }
+    void SeekToFirst() override {
+        it_.seek_to_first();
+        Load();
+    }
+    void Seek(std::string_view target) override {
+        it_.seek(target);
+        Load();
+    }
+    void Next() override {
+        it_.next();
+        Load();
+    }
+    std::string_view key() const override { return key_; }
+    std::string_view value() const override { return value_; }
+
+private:
+    void Load() {
+        if (it_.valid()) {
+            key_ = it_.key();
+            value_ = it_.value();
+        }
+    }
+
+    std::shared_ptr<void> owner_;
+    MemTableList::Iterator it_;
+    std::string key_;
+    std::string value_;
+};
+
+}  // namespace
+
+LsmStore::MemTable::MemTable() : list(kMemTableMaxLevel) {}
+
+LsmStore::LsmStore(const LsmOptions& options) : options_(options) {
+    options_.num_levels = std::max(2, options_.num_levels);
+    options_.level_multiplier = std::max(2, options_.level_multiplier);
+    options_.l0_compaction_trigger = std::max(1, options_.l0_compaction_trigger);
+    options_.max_immutable_memtables = std::max<size_t>(1, options_.max_immutable_memtables);
+}
+
+LsmStore::~LsmStore() {
+    Close();
+}
+
+// ===================================================================================
+// PART 1: 打开 / 关闭 / MANIFEST
+// ===================================================================================
+
+bool LsmStore::Open(std::string* error) {
+    std::lock_guard<std::mutex> wlock(write_mu_);
+    if (opened_) {
+        if (error) *error = "already opened";
+        return false;
+    }
+    if (::mkdir(options_.dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        return SetError(error, "mkdir " + options_.dir);
+    }
+    if (!LoadManifest(error)) {
+        return false;
+    }
+    RemoveOrphanTables();
+
+    std::lock_guard<std::mutex> lock(mu_);
+    compact_pointer_.assign(options_.num_levels, std::string());
+    mem_ = std::make_shared<MemTable>();
+    mem_->id = next_mem_id_++;
+    applied_index_ = current_->durable_index;
+    mem_->last_index = applied_index_;
+    opened_ = true;
+    bg_thread_ = std::thread(&LsmStore::BackgroundLoop, this);
+    return true;
+}
+
+void LsmStore::Close() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (!opened_ || closing_) return;
+    }
+    std::string error;
+    if (!Flush(&error)) {
+        std::cerr << "[LsmStore] flush on close failed: " << error << std::endl;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        closing_ = true;
+    }
+    bg_cv_.notify_all();
+    done_cv_.notify_all();
+    if (bg_thread_.joinable()) bg_thread_.join();
+}
+
+std::string LsmStore::TablePath(const std::string& dir, uint64_t number) const {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%06llu.sst", static_cast<unsigned long long>(number));
+    return dir + "/" + buf;
+}
+
+/**
+ * MANIFEST 格式 (小端)：magic u32 | crc32c u32 | body
+ *   body : next_file varint | durable_index varint | num_levels varint |
+ *          每层 { count varint | 每个文件 { number varint | bytes varint | smallest 长度前缀 | largest 长度前缀 } }
+ */
+bool LsmStore::WriteManifest(const std::string& dir, const Version& v, uint64_t next_file, std::string* error) const {
+    std::string body;
+    PutVarint64(body, next_file);
+    PutVarint64(body, v.durable_index);
+    PutVarint64(body, v.levels.size());
+    for (const auto& files : v.levels) {
+        PutVarint64(body, files.size());
+        for (const auto& f : files) {
+            PutVarint64(body, f->number);
+            PutVarint64(body, f->file_bytes);
+            PutLengthPrefixed(body, f->smallest);
+            PutLengthPrefixed(body, f->largest);
+        }
+    }
+    char header[8];
+    PutU32(header, kManifestMagic);
+    PutU32(header + 4, Crc32c(body.data(), body.size()));
+
+    std::string tmp = dir + "/" + kManifestTmpFile;
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return SetError(error, "open " + tmp);
+    }
+    bool ok = WriteAll(fd, header, sizeof(header)) && WriteAll(fd, body.data(), body.size()) &&
+              (!options_.sync || ::fdatasync(fd) == 0);
+    ::close(fd);
+    if (!ok) {
+        SetError(error, "write " + tmp);
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    std::string path = dir + "/" + kManifestFile;
+    if (::rename(tmp.c_str(), path.c_str()) != 0) {
+        return SetError(error, "rename " + tmp);
+    }
+    if (options_.sync && !SyncDir(dir)) {
+        return SetError(error, "fsync " + dir);
+    }
+    return true;
+}
+
+bool LsmStore::LoadManifest(std::string* error) {
+    auto v = std::make_shared<Version>();
+    v->levels.resize(options_.num_levels);
+    std::string path = options_.dir + "/" + kManifestFile;
+    std::string data;
+    if (!ReadFile(path, &data)) {
+        if (errno != ENOENT) {
+            return SetError(error, "read " + path);
+        }
+        std::lock_guard<std::mutex> lock(mu_);
+        current_ = v;
+        return true;
+    }
+
+    auto corrupt = [&](const std::string& what) {
+        if (error) *error = "corrupted MANIFEST (" + what + "): " + path;
+        return false;
+    };
+    if (data.size() < 8 || GetU32(data.data()) != kManifestMagic ||
+        GetU32(data.data() + 4) != Crc32c(data.data() + 8, data.size() - 8)) {
+        return corrupt("checksum");
+    }
+    std::string_view in(data.data() + 8, data.size() - 8);
+    uint64_t next_file = 0, durable = 0, num_levels = 0;
+    if (!GetVarint64(in, &next_file) || !GetVarint64(in, &durable) || !GetVarint64(in, &num_levels)) {
+        return corrupt("header");
+    }
+    if (num_levels > static_cast<uint64_t>(options_.num_levels)) {
+        return corrupt("more levels than num_levels");
+    }
+    v->durable_index = durable;
+    for (uint64_t level = 0; level < num_levels; ++level) {
+        uint64_t count = 0;
+        if (!GetVarint64(in, &count)) return corrupt("level");
+        for (uint64_t i = 0; i < count; ++i) {
+            auto f = std::make_shared<FileMeta>();
+            std::string_view smallest, largest;
+            if (!GetVarint64(in, &f->number) || !GetVarint64(in, &f->file_bytes) ||
+                !GetLengthPrefixed(in, &smallest) || !GetLengthPrefixed(in, &largest)) {
+                return corrupt("file");
+            }
+            f->smallest.assign(smallest.data(), smallest.size());
+            f->largest.assign(largest.data(), largest.size());
+            f->table = Table::Open(TablePath(options_.dir, f->number), error);
+            if (!f->table) return false;
+            v->levels[level].push_back(std::move(f));
+        }
+    }
+    std::lock_guard<std::mutex> lock(mu_);
+    current_ = v;
+    next_file_number_ = std::max<uint64_t>(next_file, 1);
+    return true;
+}
+
+void LsmStore::RemoveOrphanTables() {
+    std::set<uint64_t> live;
+    for (const auto& files : current_->levels) {
+        for (const auto& f : files) live.insert(f->number);
+    }
+    DIR* d = ::opendir(options_.dir.c_str());
+    if (d == nullptr) return;
+    while (struct dirent* ent = ::readdir(d)) {
+        uint64_t number = 0;
+        if (ParseTableName(ent->d_name, &number) && live.count(number) == 0) {
+            ::unlink((options_.dir + "/" + ent->d_name).c_str());
+        }
+    }
+    ::closedir(d);
+    ::unlink((options_.dir + "/" + kManifestTmpFile).c_str());
+}
+
+// ===================================================================================
+// PART 2: 读写
+// ===================================================================================
+
+bool LsmStore::Put(const std::string& key, const std::string& value, uint64_t index) {
+    return Write(key, kTagValue, value, index);
+}
+
+bool LsmStore::Delete(const std::string& key, uint64_t index) {
+    return Write(key, kTagDeletion, std::string(), index);
+}
+
+bool LsmStore::Write(const std::string& key, char tag, const std::string& value, uint64_t index) {
+    std::string encoded;
+    encoded.reserve(value.size() + 1);
+    encoded.push_back(tag);
+    encoded.append(value);
+
+    // write_mu_ 串行化写入与冻结：持有它时 mem_ 不会被换掉，插入跳表时不必持有 mu_，读者不被挡住
+    std::lock_guard<std::mutex> wlock(write_mu_);
+    std::unique_lock<std::mutex> lock(mu_);
+    if (opened_ && !closing_ && bg_error_.empty() && imm_.size() >= options_.max_immutable_memtables) {
+        // 写停顿：落盘跟不上写入时，不让冻结的 memtable 无限堆积在内存里
+        stats_.write_stalls++;
+        done_cv_.wait(lock, [this] {
+            return closing_ || !bg_error_.empty() || imm_.size() < options_.max_immutable_memtables;
+        });
+    }
+    if (!opened_ || closing_ || !bg_error_.empty()) return false;
+    std::shared_ptr<MemTable> mem = mem_;
+    lock.unlock();
+
+    mem->list.insert_set_element(key, encoded);
+
+    lock.lock();
+    mem->bytes += key.size() + encoded.size() + kMemEntryOverhead;
+    if (index > applied_index_) applied_index_ = index;
+    mem->last_index = applied_index_;
+    if (mem->bytes >= options_.memtable_bytes) {
+        FreezeLocked();
+    }
+    return true;
+}
+
+void LsmStore::FreezeLocked() {
+    if (mem_->bytes == 0) return;
+    imm_.push_back(mem_);
+    mem_ = std::make_shared<MemTable>();
+    mem_->id = next_mem_id_++;
+    mem_->last_index = applied_index_;
+    bg_cv_.notify_one();
+}
+
+bool LsmStore::Get(const std::string& key, std::string* value, std::string* error) {
+    std::shared_ptr<MemTable> mem;
+    std::vector<std::shared_ptr<MemTable>> imm;
+    std::shared_ptr<const Version> v;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (!opened_) return false;
+        mem = mem_;
+        imm.assign(imm_.begin(), imm_.end());
+        v = current_;
+    }
+
+    std::string raw;
+    if (mem->list.search_element(key, raw)) return DecodeValue(raw, value);
+    for (auto it = imm.rbegin(); it != imm.rend(); ++it) {
+        if ((*it)->list.search_element(key, raw)) return DecodeValue(raw, value);
+    }
+
+    auto probe = [&](const FileMeta& f, bool* done) {
+        Table::Lookup r = f.table->Get(key, &raw);
+        if (r == Table::Lookup::kFiltered) {
+            bloom_filtered_.fetch_add(1, std::memory_order_relaxed);
+        } else if (r == Table::Lookup::kCorruption) {
+            if (error) *error = "corrupted sstable: " + f.table->path();
+            *done = true;
+            return false;
+        } else if (r == Table::Lookup::kFound) {
+            *done = true;
+            return DecodeValue(raw, value);
+        }
+        return false;
+    };
+    bool done = false;
+    // L0 的文件区间可能重叠：从新到旧逐个查
+    for (const auto& f : v->levels[0]) {
+        if (key < f->smallest || key > f->largest) continue;
+        bool found = probe(*f, &done);
+        if (done) return found;
+    }
+    // L1 起每层文件互不重叠：二分找到唯一可能包含 key 的文件
+    for (size_t level = 1; level < v->levels.size(); ++level) {
+        const auto& files = v->levels[level];
+        auto it = std::lower_bound(files.begin(), files.end(), key,
+                                   [](const std::shared_ptr<FileMeta>& f, const std::string& k) { return f->largest < k; });
+        if (it == files.end() || key < (*it)->smallest) continue;
+        bool found = probe(**it, &done);
+        if (done) return found;
+    }
+    return false;
+}
+
+bool LsmStore::Scan(const std::string& start, const std::string& end, size_t limit,
+                    std::vector<std::pair<std::string, std::string>>* out, std::string* next_key) {
+    std::shared_ptr<MemTable> mem;
+    std::vector<std::shared_ptr<MemTable>> imm;
+    std::shared_ptr<const Version> v;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (!opened_) return false;
+        mem = mem_;
+        imm.assign(imm_.begin(), imm_.end());
+        v = current_;
+    }
+
+    auto overlaps = [&](const FileMeta& f) { return !(f.largest < start) && (end.empty() || f.smallest < end); };
+    std::vector<std::unique_ptr<KvIterator>> children;
+    children.emplace_back(new MemIter(mem, &mem->list));
+    for (auto it = imm.rbegin(); it != imm.rend(); ++it) {
+        children.emplace_back(new MemIter(*it, &(*it)->list));
+    }
+    for (const auto& files : v->levels) {
+        for (const auto& f : files) {
+            if (overlaps(*f)) children.push_back(f->table->NewIterator());
+        }
+    }
+
+    MergingIterator merged(std::move(children));
+    auto in_range = [&] { return merged.Valid() && (end.empty() || merged.key() < end); };
+    // 跳过墓碑，停在下一条可见记录上
+    auto skip_deleted = [&] {
+        while (in_range() && !IsLive(merged.value())) merged.Next();
+    };
+    merged.Seek(start);
+    skip_deleted();
+    while (in_range()) {
+        if (limit > 0 && out->size() >= limit) {
+            if (next_key) next_key->assign(merged.key().data(), merged.key().size());
+            return true;
+        }
+        std::string_view raw = merged.value();
+        out->emplace_back(std::string(merged.key()), std::string(raw.substr(1)));
+        merged.Next();
+        skip_deleted();
+    }
+    if (merged.corrupted()) {
+        std::cerr << "[LsmStore] scan stopped at a corrupted sstable" << std::endl;
+    }
+    return false;
+}
+
+// ===================================================================================
+// PART 3: 后台 flush / compaction
+// ===================================================================================
+
+void LsmStore::FailLocked(const std::string& what) {
+    std::cerr << "[LsmStore] " << what << ", store is now read-only" << std::endl;
+    if (bg_error_.empty()) bg_error_ = what;
+    done_cv_.notify_all();
+}
+
+uint64_t LsmStore::MaxBytesForLevel(int level) const {
+    uint64_t bytes = options_.level1_bytes;
+    for (int i = 1; i < level; ++i) bytes *= static_cast<uint64_t>(options_.level_multiplier);
+    return bytes;
+}
+
+uint64_t LsmStore::LevelBytes(const std::vector<std::shared_ptr<FileMeta>>& files) {
+    uint64_t bytes = 0;
+    for (const auto& f : files) bytes += f->file_bytes;
+    return bytes;
+}
+
+bool LsmStore::NeedsCompactionLocked() const {
+    if (!bg_error_.empty() || !current_) return false;
+    if (current_->levels[0].size() >= static_cast<size_t>(options_.l0_compaction_trigger)) return true;
+    // 最后一层没有下一层可合并
+    for (int level = 1; level + 1 < options_.num_levels; ++level) {
+        if (LevelBytes(current_->levels[level]) > MaxBytesForLevel(level)) return true;
+    }
+    return false;
+}
+
+void LsmStore::BackgroundLoop() {
+    std::unique_lock<std::mutex> lock(mu_);
+    while (true) {
+        bg_cv_.wait(lock, [this] { return closing_ || !bg_error_.empty() || !imm_.empty() || NeedsCompactionLocked(); });
+        if (!bg_error_.empty()) break;
+        // 落盘优先于 compaction：冻结的 memtable 占着内存，还可能让写入停顿
+        if (!imm_.empty()) {
+            std::shared_ptr<MemTable> mem = imm_.front();
+            compacting_ = true;
+            lock.unlock();
+            bool ok = FlushMemTable(mem);
+            lock.lock();
+            compacting_ = false;
+            if (!ok) break;
+            continue;
+        }
+        if (closing_) break;
+        Compaction c;
+        if (!PickCompactionLocked(&c)) continue;
+        compacting_ = true;
+        lock.unlock();
+        RunCompaction(c);
+        lock.lock();
+        compacting_ = false;
+        done_cv_.notify_all();
+    }
+    compacting_ = false;
+    done_cv_.notify_all();
+}
+
+bool LsmStore::FlushMemTable(const std::shared_ptr<MemTable>& mem) {
+    uint64_t number;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        number = next_file_number_++;
+    }
+    std::string path = TablePath(options_.dir, number);
+    std::string error;
+    auto fail = [&](const std::string& what) {
+        ::unlink(path.c_str());
+        std::lock_guard<std::mutex> lock(mu_);
+        FailLocked(what);
+        return false;
+    };
+
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        SetError(&error, "open " + path);
+        return fail(error);
+    }
+    auto f = std::make_shared<FileMeta>();
+    f->number = number;
+    {
+        TableBuilder builder(options_.table, fd);
+        {
+            // 冻结的 memtable 不再有写入，共享锁不会挡住任何人
+            MemTableList::Iterator it(&mem->list);
+            for (it.seek_to_first(); it.valid(); it.next()) {
+                builder.Add(it.key(), it.value());
+            }
+        }
+        if (!builder.Finish(options_.sync, &error)) return fail(error);
+        f->file_bytes = builder.FileSize();
+        f->smallest = builder.smallest();
+        f->largest = builder.largest();
+    }
+    f->table = Table::Open(path, &error);
+    if (!f->table) return fail(error);
+
+    std::shared_ptr<Version> v;
+    uint64_t next_file;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        v = std::make_shared<Version>(*current_);
+        next_file = next_file_number_;
+    }
+    v->levels[0].insert(v->levels[0].begin(), f);
+    v->durable_index = std::max(v->durable_index, mem->last_index);
+    if (options_.sync && !SyncDir(options_.dir)) {
+        SetError(&error, "fsync " + options_.dir);
+        return fail(error);
+    }
+    if (!WriteManifest(options_.dir, *v, next_file, &error)) return fail(error);
+
+    std::lock_guard<std::mutex> lock(mu_);
+    current_ = v;
+    imm_.pop_front();
+    flushed_mem_id_ = mem->id;
+    stats_.flushes++;
+    done_cv_.notify_all();
+    return true;
+}
+
+bool LsmStore::PickCompactionLocked(Compaction* c) {
+    const Version& v = *current_;
+    // 打分：L0 按文件数 (每个 L0 文件都可能要被点查)，其余层按总大小
+    int best = -1;
+    double best_score = 1.0;
+    double score0 = static_cast<double>(v.levels[0].size()) / options_.l0_compaction_trigger;
+    if (score0 >= best_score) {
+        best = 0;
+        best_score = score0;
+    }
+    for (int level = 1; level + 1 < options_.num_levels; ++level) {
+        double score = static_cast<double>(LevelBytes(v.levels[level])) / MaxBytesForLevel(level);
+        if (score > best_score) {
+            best = level;
+            best_score = score;
+        }
+    }
+    if (best < 0) return false;
+
+    c->level = best;
+    c->inputs.clear();
+    c->overlaps.clear();
+    const auto& files = v.levels[best];
+    if (files.empty()) return false;
+    if (best == 0) {
+        c->inputs = files;  // L0 互相重叠，一次全部合并
+    } else {
+        // 按 key 轮转：从上次合并到的位置之后选一个文件，整层最终都会被轮到
+        const std::string& pointer = compact_pointer_[best];
+        auto it = std::find_if(files.begin(), files.end(),
+                               [&](const std::shared_ptr<FileMeta>& f) { return pointer.empty() || f->largest > pointer; });
+        c->inputs.push_back(it == files.end() ? files.front() : *it);
+    }
+    std::string smallest = c->inputs.front()->smallest;
+    std::string largest = c->inputs.front()->largest;
+    for (const auto& f : c->inputs) {
+        smallest = std::min(smallest, f->smallest);
+        largest = std::max(largest, f->largest);
+    }
+    for (const auto& f : v.levels[best + 1]) {
+        if (!(f->largest < smallest) && !(f->smallest > largest)) c->overlaps.push_back(f);
+    }
+    return true;
+}
+
+bool LsmStore::IsBottommost(const Version& v, int output_level, std::string_view key) const {
+    for (size_t level = output_level + 1; level < v.levels.size(); ++level) {
+        for (const auto& f : v.levels[level]) {
+            if (!(key < f->smallest) && !(key > f->largest)) return false;
+        }
+    }
+    return true;
+}
+
+bool LsmStore::RunCompaction(const Compaction& c) {
+    const int output_level = c.level + 1;
+    std::shared_ptr<const Version> base;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        base = current_;  // 只有后台线程修改版本，选取之后版本不会变
+    }
+    auto v = std::make_shared<Version>(*base);
+    auto remove = [](std::vector<std::shared_ptr<FileMeta>>* files, const std::vector<std::shared_ptr<FileMeta>>& gone) {
+        files->erase(std::remove_if(files->begin(), files->end(),
+                                    [&](const std::shared_ptr<FileMeta>& f) {
+                                        return std::find(gone.begin(), gone.end(), f) != gone.end();
+                                    }),
+                     files->end());
+    };
+    auto by_smallest = [](const std::shared_ptr<FileMeta>& a, const std::shared_ptr<FileMeta>& b) {
+        return a->smallest < b->smallest;
+    };
+    std::vector<std::shared_ptr<FileMeta>> outputs;
+    std::string error;
+    auto fail = [&](const std::string& what) {
+        for (const auto& f : outputs) {
+            if (f->table) {
+                f->table->MarkObsolete();
+            } else {
+                ::unlink(TablePath(options_.dir, f->number).c_str());
+            }
+        }
+        std::lock_guard<std::mutex> lock(mu_);
+        FailLocked(what);
+        return false;
+    };
+
+    bool trivial = c.level > 0 && c.inputs.size() == 1 && c.overlaps.empty();
+    if (!trivial) {
+        std::vector<std::unique_ptr<KvIterator>> children;
+        for (const auto& f : c.inputs) children.push_back(f->table->NewIterator());  // L0 已按新到旧排列
+        for (const auto& f : c.overlaps) children.push_back(f->table->NewIterator());
+        MergingIterator merged(std::move(children));
+
+        std::unique_ptr<TableBuilder> builder;
+        auto finish_output = [&]() {
+            std::shared_ptr<FileMeta> f = outputs.back();
+            bool ok = builder->Finish(options_.sync, &error);
+            if (ok) {
+                f->file_bytes = builder->FileSize();
+                f->smallest = builder->smallest();
+                f->largest = builder->largest();
+                f->table = Table::Open(TablePath(options_.dir, f->number), &error);
+                ok = f->table != nullptr;
+            }
+            builder.reset();
+            return ok;
+        };
+        for (merged.SeekToFirst(); merged.Valid(); merged.Next()) {
+            // 更深的层都没有这个 key：墓碑已经没有需要遮住的旧值
+            if (!IsLive(merged.value()) && IsBottommost(*base, output_level, merged.key())) continue;
+            if (!builder) {
+                uint64_t number;
+                {
+                    std::lock_guard<std::mutex> lock(mu_);
+                    number = next_file_number_++;
+                }
+                auto f = std::make_shared<FileMeta>();
+                f->number = number;
+                outputs.push_back(f);
+                std::string path = TablePath(options_.dir, number);
+                int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+                if (fd < 0) {
+                    SetError(&error, "open " + path);
+                    return fail(error);
+                }
+                builder.reset(new TableBuilder(options_.table, fd));
+            }
+            builder->Add(merged.key(), merged.value());
+            if (builder->FileSize() >= options_.target_file_bytes && !finish_output()) return fail(error);
+        }
+        if (merged.corrupted()) return fail("compaction read a corrupted sstable");
+        if (builder && !finish_output()) return fail(error);
+        if (options_.sync && !SyncDir(options_.dir)) {
+            SetError(&error, "fsync " + options_.dir);
+            return fail(error);
+        }
+    }
+
+    remove(&v->levels[c.level], c.inputs);
+    remove(&v->levels[output_level], c.overlaps);
+    auto& out_files = v->levels[output_level];
+    if (trivial) {
+        out_files.push_back(c.inputs.front());
+    } else {
+        out_files.insert(out_files.end(), outputs.begin(), outputs.end());
+    }
+    std::sort(out_files.begin(), out_files.end(), by_smallest);
+
+    uint64_t next_file;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        next_file = next_file_number_;
+    }
+    if (!WriteManifest(options_.dir, *v, next_file, &error)) return fail(error);
+
+    std::lock_guard<std::mutex> lock(mu_);
+    current_ = v;
+    if (!trivial) {
+        // 新 MANIFEST 已落盘：旧文件在最后一个读者 / 快照释放后删除
+        for (const auto& f : c.inputs) f->table->MarkObsolete();
+        for (const auto& f : c.overlaps) f->table->MarkObsolete();
+        stats_.compactions++;
+    } else {
+        stats_.trivial_moves++;
+    }
+    if (c.level > 0) {
+        compact_pointer_[c.level] = c.inputs.back()->largest;
+    }
+    return true;
+}
+
+// ===================================================================================
+// PART 4: 持久化 / 快照 / 统计
+// ===================================================================================
+
+uint64_t LsmStore::AppliedIndex() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return applied_index_;
+}
+
+uint64_t LsmStore::DurableIndex() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return current_ ? current_->durable_index : 0;
+}
+
+bool LsmStore::Flush(std::string* error) {
+    std::unique_lock<std::mutex> wlock(write_mu_);
+    std::unique_lock<std::mutex> lock(mu_);
+    if (!opened_ || closing_) {
+        if (error) *error = "store is not open";
+        return false;
+    }
+    FreezeLocked();
+    uint64_t target = imm_.empty() ? flushed_mem_id_ : imm_.back()->id;
+    wlock.unlock();
+    done_cv_.wait(lock, [&] { return !bg_error_.empty() || flushed_mem_id_ >= target; });
+    if (!bg_error_.empty()) {
+        if (error) *error = bg_error_;
+        return false;
+    }
+    return true;
+}
+
+void LsmStore::WaitForIdle() {
+    std::unique_lock<std::mutex> lock(mu_);
+    if (!opened_) return;
+    done_cv_.wait(lock, [this] {
+        return !bg_error_.empty() || closing_ || (imm_.empty() && !compacting_ && !NeedsCompactionLocked());
+    });
+}
+
+bool LsmStore::Checkpoint(const std::string& dir, uint64_t* index, std::string* error) {
+    if (!Flush(error)) return false;
+    std::shared_ptr<const Version> v;
+    uint64_t next_file;
+    {
+        // 持有版本引用：链接期间被 compaction 替换的文件也不会被删除
+        std::lock_guard<std::mutex> lock(mu_);
+        v = current_;
+        next_file = next_file_number_;
+    }
+    if (::mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        return SetError(error, "mkdir " + dir);
+    }
+    if (::access((dir + "/" + kManifestFile).c_str(), F_OK) == 0) {
+        if (error) *error = "checkpoint directory is not empty: " + dir;
+        return false;
+    }
+    for (const auto& files : v->levels) {
+        for (const auto& f : files) {
+            std::string dst = TablePath(dir, f->number);
+            if (!LinkOrCopy(f->table->path(), dst)) {
+                return SetError(error, "link " + dst);
+            }
+        }
+    }
+    if (options_.sync && !SyncDir(dir)) {
+        return SetError(error, "fsync " + dir);
+    }
+    if (!WriteManifest(dir, *v, next_file, error)) return false;
+    if (index) *index = v->durable_index;
+    return true;
+}
+
+LsmStats LsmStore::GetStats() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    LsmStats stats = stats_;
+    stats.bloom_filtered = bloom_filtered_.load(std::memory_order_relaxed);
+    stats.immutable_memtables = imm_.size();
+    if (current_) {
+        for (const auto& files : current_->levels) {
+            stats.level_files.push_back(files.size());
+            stats.level_bytes.push_back(LevelBytes(files));
+        }
+    }
+    return stats;
+}
+
+}  // namespace storage
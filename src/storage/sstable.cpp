@@ -0,0 +1,533 @@
+#include "sstable.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "crc32c.h"
+#include "opCodec.h"
+
+namespace storage {
+
+namespace {
+
+inline void PutU32(char* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<char>((v >> (8 * i)) & 0xFF);
+}
+
+inline void PutU64(char* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = static_cast<char>((v >> (8 * i)) & 0xFF);
+}
+
+inline uint32_t GetU32(const char* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+    return v;
+}
+
+inline uint64_t GetU64(const char* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= static_cast<uint64_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+    return v;
+}
+
+bool SetError(std::string* error, const std::string& what) {
+    if (error) {
+        *error = what + ": " + strerror(errno);
+    }
+    return false;
+}
+
+bool PReadAll(int fd, char* buf, size_t len, uint64_t offset) {
+    while (len > 0) {
+        ssize_t n = ::pread(fd, buf, len, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (n == 0) return false;  // 文件比 handle 描述的短
+        buf += n;
+        len -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+void EncodeHandle(const BlockHandle& h, std::string* dst) {
+    PutVarint64(*dst, h.offset);
+    PutVarint64(*dst, h.size);
+}
+
+bool DecodeHandle(std::string_view in, BlockHandle* h) {
+    return GetVarint64(in, &h->offset) && GetVarint64(in, &h->size);
+}
+
+}  // namespace
+
+// ========== bloom 过滤器 ==========
+
+uint64_t BloomHash(std::string_view key) {
+    // FNV-1a + murmur3 fmix64：短 key 也能把差异扩散到全部 64 位
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (char c : key) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 0x100000001b3ull;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+std::string BuildBloomFilter(const std::vector<uint64_t>& hashes, int bits_per_key) {
+    if (bits_per_key <= 0 || hashes.empty()) return std::string();
+    // k = bits_per_key * ln2 时误判率最低
+    int k = static_cast<int>(bits_per_key * 0.69);
+    k = std::max(1, std::min(k, 30));
+    size_t bits = std::max<size_t>(64, hashes.size() * static_cast<size_t>(bits_per_key));
+    size_t bytes = (bits + 7) / 8;
+    bits = bytes * 8;
+
+    std::string filter(bytes, '\0');
+    for (uint64_t h : hashes) {
+        // 双重哈希：h1 + i * h2 模拟 k 个独立哈希
+        uint32_t h1 = static_cast<uint32_t>(h);
+        uint32_t h2 = static_cast<uint32_t>(h >> 32) | 1;
+        for (int i = 0; i < k; ++i) {
+            size_t bit = (h1 + static_cast<uint64_t>(i) * h2) % bits;
+            filter[bit / 8] = static_cast<char>(filter[bit / 8] | (1 << (bit % 8)));
+        }
+    }
+    filter.push_back(static_cast<char>(k));
+    return filter;
+}
+
+bool BloomMayContain(std::string_view filter, uint64_t hash) {
+    if (filter.size() < 2) return true;
+    int k = static_cast<unsigned char>(filter.back());
+    if (k < 1 || k > 30) return true;
+    size_t bits = (filter.size() - 1) * 8;
+    uint32_t h1 = static_cast<uint32_t>(hash);
+    uint32_t h2 = static_cast<uint32_t>(hash >> 32) | 1;
+    for (int i = 0; i < k; ++i) {
+        size_t bit = (h1 + static_cast<uint64_t>(i) * h2) % bits;
+        if ((filter[bit / 8] & (1 << (bit % 8))) == 0) return false;
+    }
+    return true;
+}
+
+// ========== BlockBuilder ==========
+
+BlockBuilder::BlockBuilder(int restart_interval) : restart_interval_(std::max(1, restart_interval)) {
+    restarts_.push_back(0);
+}
+
+void BlockBuilder::Add(std::string_view key, std::string_view value) {
+    size_t shared = 0;
+    if (counter_ < restart_interval_) {
+        size_t limit = std::min(last_key_.size(), key.size());
+        while (shared < limit && last_key_[shared] == key[shared]) ++shared;
+    } else {
+        restarts_.push_back(static_cast<uint32_t>(buf_.size()));
+        counter_ = 0;
+    }
+    PutVarint64(buf_, shared);
+    PutVarint64(buf_, key.size() - shared);
+    PutVarint64(buf_, value.size());
+    buf_.append(key.data() + shared, key.size() - shared);
+    buf_.append(value.data(), value.size());
+    last_key_.assign(key.data(), key.size());
+    ++counter_;
+}
+
+std::string_view BlockBuilder::Finish() {
+    char b[4];
+    for (uint32_t r : restarts_) {
+        PutU32(b, r);
+        buf_.append(b, 4);
+    }
+    PutU32(b, static_cast<uint32_t>(restarts_.size()));
+    buf_.append(b, 4);
+    return buf_;
+}
+
+void BlockBuilder::Reset() {
+    buf_.clear();
+    restarts_.assign(1, 0);
+    counter_ = 0;
+    last_key_.clear();
+}
+
+// ========== BlockIter ==========
+
+BlockIter::BlockIter(std::shared_ptr<const std::string> contents) : contents_(std::move(contents)) {
+    const std::string& c = *contents_;
+    if (c.size() < 4) {
+        Corrupt();
+        return;
+    }
+    num_restarts_ = GetU32(c.data() + c.size() - 4);
+    if (num_restarts_ == 0 || num_restarts_ > (c.size() - 4) / 4) {
+        Corrupt();
+        return;
+    }
+    restarts_offset_ = c.size() - 4 - 4 * static_cast<size_t>(num_restarts_);
+}
+
+uint32_t BlockIter::RestartPoint(uint32_t i) const {
+    return GetU32(contents_->data() + restarts_offset_ + 4 * static_cast<size_t>(i));
+}
+
+void BlockIter::Corrupt() {
+    valid_ = false;
+    corrupted_ = true;
+    key_.clear();
+    value_ = std::string_view();
+}
+
+bool BlockIter::ParseAt(size_t offset) {
+    if (offset >= restarts_offset_) {
+        valid_ = false;
+        return false;
+    }
+    std::string_view in(contents_->data() + offset, restarts_offset_ - offset);
+    uint64_t shared = 0, non_shared = 0, value_len = 0;
+    if (!GetVarint64(in, &shared) || !GetVarint64(in, &non_shared) || !GetVarint64(in, &value_len) ||
+        shared > key_.size() || non_shared + value_len > in.size()) {
+        Corrupt();
+        return false;
+    }
+    key_.resize(shared);
+    key_.append(in.data(), non_shared);
+    value_ = in.substr(non_shared, value_len);
+    next_ = static_cast<size_t>(value_.data() + value_.size() - contents_->data());
+    valid_ = true;
+    return true;
+}
+
+void BlockIter::SeekToFirst() {
+    if (corrupted_ || !contents_) return;
+    key_.clear();
+    ParseAt(0);
+}
+
+void BlockIter::Seek(std::string_view target) {
+    if (corrupted_ || !contents_) return;
+    // 二分重启点：找到最后一个 key < target 的重启点，再顺序向后扫
+    uint32_t left = 0;
+    uint32_t right = num_restarts_ - 1;
+    while (left < right) {
+        uint32_t mid = (left + right + 1) / 2;
+        key_.clear();
+        if (!ParseAt(RestartPoint(mid))) {
+            if (!corrupted_) Corrupt();
+            return;
+        }
+        if (key() < target) {
+            left = mid;
+        } else {
+            right = mid - 1;
+        }
+    }
+    key_.clear();
+    if (!ParseAt(RestartPoint(left))) return;
+    while (valid_ && key() < target) Next();
+}
+
+void BlockIter::Next() {
+    if (!valid_) return;
+    ParseAt(next_);
+}
+
+// ========== TableBuilder ==========
+
+TableBuilder::TableBuilder(const TableOptions& options, int fd)
+    : options_(options),
+      fd_(fd),
+      data_block_(options.restart_interval),
+      index_block_(1) {}
+
+TableBuilder::~TableBuilder() {
+    if (fd_ >= 0) ::close(fd_);
+}
+
+bool TableBuilder::WriteRaw(const char* data, size_t len) {
+    while (ok_ && len > 0) {
+        ssize_t n = ::write(fd_, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ok_ = false;
+            break;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+        offset_ += static_cast<uint64_t>(n);
+    }
+    return ok_;
+}
+
+bool TableBuilder::WriteBlock(std::string_view raw, bool compress, BlockHandle* handle) {
+    std::string_view payload = raw;
+    uint8_t type = kBlockRaw;
+    if (compress && options_.compress) {
+        uLongf bound = compressBound(static_cast<uLong>(raw.size()));
+        compressed_.clear();
+        PutVarint64(compressed_, raw.size());
+        size_t prefix = compressed_.size();
+        compressed_.resize(prefix + bound);
+        // level 1：块很小，压缩率差别不大，速度优先 (flush / compaction 都在这条路径上)
+        if (compress2(reinterpret_cast<Bytef*>(&compressed_[prefix]), &bound,
+                      reinterpret_cast<const Bytef*>(raw.data()), static_cast<uLong>(raw.size()), 1) == Z_OK &&
+            prefix + bound < raw.size() - raw.size() / 8) {
+            compressed_.resize(prefix + bound);
+            payload = compressed_;
+            type = kBlockZlib;
+        }
+    }
+    handle->offset = offset_;
+    handle->size = payload.size();
+    char trailer[kBlockTrailerSize];
+    trailer[0] = static_cast<char>(type);
+    uint32_t crc = Crc32cExtend(Crc32c(payload.data(), payload.size()), trailer, 1);
+    PutU32(trailer + 1, crc);
+    return WriteRaw(payload.data(), payload.size()) && WriteRaw(trailer, sizeof(trailer));
+}
+
+bool TableBuilder::FlushDataBlock() {
+    if (data_block_.Empty()) return ok_;
+    BlockHandle handle;
+    if (!WriteBlock(data_block_.Finish(), true, &handle)) return false;
+    data_block_.Reset();
+    // 稀疏索引：块内最后一个 key -> 块位置
+    std::string encoded;
+    EncodeHandle(handle, &encoded);
+    index_block_.Add(last_key_, encoded);
+    return true;
+}
+
+bool TableBuilder::Add(std::string_view key, std::string_view value) {
+    if (!ok_) return false;
+    if (num_entries_ == 0) smallest_.assign(key.data(), key.size());
+    data_block_.Add(key, value);
+    last_key_.assign(key.data(), key.size());
+    if (options_.bloom_bits_per_key > 0) key_hashes_.push_back(BloomHash(key));
+    ++num_entries_;
+    if (data_block_.SizeEstimate() >= options_.block_size) {
+        return FlushDataBlock();
+    }
+    return true;
+}
+
+bool TableBuilder::Finish(bool sync, std::string* error) {
+    BlockHandle filter_handle, index_handle;
+    if (!FlushDataBlock() || !WriteBlock(BuildBloomFilter(key_hashes_, options_.bloom_bits_per_key), false,
+                                         &filter_handle) ||
+        !WriteBlock(index_block_.Finish(), false, &index_handle)) {
+        return SetError(error, "write sstable");
+    }
+    char footer[kTableFooterSize];
+    PutU64(footer, filter_handle.offset);
+    PutU64(footer + 8, filter_handle.size);
+    PutU64(footer + 16, index_handle.offset);
+    PutU64(footer + 24, index_handle.size);
+    PutU64(footer + 32, kTableMagic);
+    if (!WriteRaw(footer, sizeof(footer))) {
+        return SetError(error, "write sstable footer");
+    }
+    if (sync && ::fdatasync(fd_) != 0) {
+        return SetError(error, "fdatasync sstable");
+    }
+    ::close(fd_);
+    fd_ = -1;
+    return true;
+}
+
+// ========== Table ==========
+
+std::shared_ptr<Table> Table::Open(const std::string& path, std::string* error) {
+    std::shared_ptr<Table> table(new Table());
+    table->path_ = path;
+    table->fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (table->fd_ < 0) {
+        SetError(error, "open " + path);
+        return nullptr;
+    }
+    struct stat st;
+    if (::fstat(table->fd_, &st) != 0) {
+        SetError(error, "stat " + path);
+        return nullptr;
+    }
+    table->file_size_ = static_cast<uint64_t>(st.st_size);
+    char footer[kTableFooterSize];
+    if (table->file_size_ < kTableFooterSize ||
+        !PReadAll(table->fd_, footer, sizeof(footer), table->file_size_ - kTableFooterSize) ||
+        GetU64(footer + 32) != kTableMagic) {
+        if (error) *error = "bad sstable footer: " + path;
+        return nullptr;
+    }
+    BlockHandle filter_handle{GetU64(footer), GetU64(footer + 8)};
+    BlockHandle index_handle{GetU64(footer + 16), GetU64(footer + 24)};
+    std::string index;
+    if (!table->ReadBlock(index_handle, &index) || !table->ReadBlock(filter_handle, &table->filter_)) {
+        if (error) *error = "bad sstable index / filter: " + path;
+        return nullptr;
+    }
+    table->index_ = std::make_shared<const std::string>(std::move(index));
+    return table;
+}
+
+Table::~Table() {
+    if (fd_ >= 0) ::close(fd_);
+    if (obsolete_.load()) ::unlink(path_.c_str());
+}
+
+bool Table::ReadBlock(const BlockHandle& handle, std::string* out) const {
+    if (handle.offset + handle.size + kBlockTrailerSize > file_size_) return false;
+    std::string buf(handle.size + kBlockTrailerSize, '\0');
+    if (!PReadAll(fd_, &buf[0], buf.size(), handle.offset)) return false;
+    const char* trailer = buf.data() + handle.size;
+    if (Crc32c(buf.data(), handle.size + 1) != GetU32(trailer + 1)) return false;
+    uint8_t type = static_cast<uint8_t>(trailer[0]);
+    if (type == kBlockRaw) {
+        buf.resize(handle.size);
+        *out = std::move(buf);
+        return true;
+    }
+    if (type != kBlockZlib) return false;
+    std::string_view in(buf.data(), handle.size);
+    uint64_t raw_len = 0;
+    if (!GetVarint64(in, &raw_len) || raw_len > (1ull << 30)) return false;
+    out->resize(raw_len);
+    uLongf dest_len = static_cast<uLongf>(raw_len);
+    return uncompress(reinterpret_cast<Bytef*>(&(*out)[0]), &dest_len, reinterpret_cast<const Bytef*>(in.data()),
+                      static_cast<uLong>(in.size())) == Z_OK &&
+           dest_len == raw_len;
+}
+
+Table::Lookup Table::Get(std::string_view key, std::string* value) const {
+    if (!BloomMayContain(filter_, BloomHash(key))) return Lookup::kFiltered;
+    BlockIter index(index_);
+    index.Seek(key);
+    if (!index.Valid()) return index.corrupted() ? Lookup::kCorruption : Lookup::kNotFound;
+    BlockHandle handle;
+    std::string contents;
+    if (!DecodeHandle(index.value(), &handle) || !ReadBlock(handle, &contents)) return Lookup::kCorruption;
+    BlockIter block(std::make_shared<const std::string>(std::move(contents)));
+    block.Seek(key);
+    if (block.corrupted()) return Lookup::kCorruption;
+    if (!block.Valid() || block.key() != key) return Lookup::kNotFound;
+    value->assign(block.value().data(), block.value().size());
+    return Lookup::kFound;
+}
+
+/**
+ * @brief 两级迭代器：index block 定位 data block，data block 内顺序遍历
+ * @details 持有 Table 的 shared_ptr，遍历期间表即使被 compaction 替换也不会被删除。
+ */
+class Table::Iter : public KvIterator {
+public:
+    explicit Iter(std::shared_ptr<const Table> table) : table_(std::move(table)), index_(table_->index_) {}
+
+    bool Valid() const override { return data_.Valid(); }
+    void SeekToFirst() override {
+        index_.SeekToFirst();
+        LoadBlock();
+        data_.SeekToFirst();
+        SkipEmptyBlocks();
+    }
+    void Seek(std::string_view target) override {
+        index_.Seek(target);
+        LoadBlock();
+        data_.Seek(target);
+        SkipEmptyBlocks();
+    }
+    void Next() override {
+        data_.Next();
+        SkipEmptyBlocks();
+    }
+    std::string_view key() const override { return data_.key(); }
+    std::string_view value() const override { return data_.value(); }
+    bool corrupted() const override { return corrupted_ || index_.corrupted() || data_.corrupted(); }
+
+private:
+    void LoadBlock() {
+        data_ = BlockIter();
+        if (!index_.Valid()) return;
+        BlockHandle handle;
+        std::string contents;
+        if (!DecodeHandle(index_.value(), &handle) || !table_->ReadBlock(handle, &contents)) {
+            corrupted_ = true;
+            return;
+        }
+        data_ = BlockIter(std::make_shared<const std::string>(std::move(contents)));
+    }
+    // 当前块走完就换下一个块
+    void SkipEmptyBlocks() {
+        while (!data_.Valid() && !corrupted() && index_.Valid()) {
+            index_.Next();
+            LoadBlock();
+            data_.SeekToFirst();
+        }
+    }
+
+    std::shared_ptr<const Table> table_;
+    BlockIter index_;
+    BlockIter data_;
+    bool corrupted_ = false;
+};
+
+std::unique_ptr<KvIterator> Table::NewIterator() const {
+    return std::unique_ptr<KvIterator>(new Iter(shared_from_this()));
+}
+
+// ========== MergingIterator ==========
+
+MergingIterator::MergingIterator(std::vector<std::unique_ptr<KvIterator>> children)
+    : children_(std::move(children)) {}
+
+void MergingIterator::FindSmallest() {
+    // 来源很少 (memtable + 几个 L0 + 每层若干文件)，线性比较比堆更省
+    current_ = -1;
+    for (size_t i = 0; i < children_.size(); ++i) {
+        if (!children_[i]->Valid()) continue;
+        if (current_ < 0 || children_[i]->key() < children_[current_]->key()) {
+            current_ = static_cast<int>(i);
+        }
+    }
+}
+
+void MergingIterator::SeekToFirst() {
+    for (auto& child : children_) child->SeekToFirst();
+    FindSmallest();
+}
+
+void MergingIterator::Seek(std::string_view target) {
+    for (auto& child : children_) child->Seek(target);
+    FindSmallest();
+}
+
+void MergingIterator::Next() {
+    if (current_ < 0) return;
+    // 同一个 key 在所有来源里一起跳过：旧层的同名记录已经被 current_ 遮住
+    std::string key(children_[current_]->key());
+    for (auto& child : children_) {
+        if (child->Valid() && child->key() == key) child->Next();
+    }
+    FindSmallest();
+}
+
+bool MergingIterator::corrupted() const {
+    for (const auto& child : children_) {
+        if (child->corrupted()) return true;
+    }
+    return false;
+}
+
+}  // namespace storage
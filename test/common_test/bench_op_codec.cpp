@@ -0,0 +1,74 @@
+// bench_op_codec.cpp
+// Op 编解码微基准：boost text_oarchive (旧) vs 紧凑二进制编码 (新)
+#include "util.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+
+static const int kIterations = 200000;
+
+static Op make_op() {
+    Op op;
+    op.Operation = "Put";
+    op.Key = "user:00012345";
+    op.Value = std::string(64, 'v');
+    op.ClientId = "4242";
+    op.RequestId = 100;
+    return op;
+}
+
+template <typename F>
+static double time_ns_per_op(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        f(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / kIterations;
+}
+
+int main() {
+    Op op = make_op();
+    size_t sink = 0;  // 防止编译器把循环优化掉
+
+    std::string boost_payload = op.asBoostString();
+    std::string binary_payload = op.asString();
+
+    double boost_enc = time_ns_per_op([&](int i) {
+        op.RequestId = i;
+        sink += op.asBoostString().size();
+    });
+    double binary_enc = time_ns_per_op([&](int i) {
+        op.RequestId = i;
+        sink += op.asString().size();
+    });
+
+    Op out;
+    double boost_dec = time_ns_per_op([&](int) {
+        out.parseFromBoostString(boost_payload);
+        sink += out.Key.size();
+    });
+    double binary_dec = time_ns_per_op([&](int) {
+        out.parseFromString(binary_payload);
+        sink += out.Key.size();
+    });
+    double view_dec = time_ns_per_op([&](int) {
+        OpView view;
+        DecodeOpView(binary_payload, &view);
+        sink += view.Key.size();
+    });
+
+    std::cout << "----------------------------------" << std::endl;
+    std::cout << "Op codec benchmark (" << kIterations << " iterations)" << std::endl;
+    std::cout << "  payload size : boost " << boost_payload.size() << " B, binary " << binary_payload.size() << " B"
+              << std::endl;
+    std::cout << "  encode ns/op : boost " << boost_enc << ", binary " << binary_enc << std::endl;
+    std::cout << "  decode ns/op : boost " << boost_dec << ", binary " << binary_dec << ", view " << view_dec
+              << std::endl;
+    std::cout << "  (sink " << sink << ")" << std::endl;
+    std::cout << "----------------------------------" << std::endl;
+
+    // 基准同时作为回归检查：二进制编码必须更小、更快
+    bool ok = binary_payload.size() < boost_payload.size() && binary_enc < boost_enc && binary_dec < boost_dec;
+    return ok ? 0 : 1;
+}
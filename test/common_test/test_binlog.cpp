@@ -0,0 +1,251 @@
+// test_binlog.cpp
+// 二进制异步日志：{} 与 printf 两种格式串的延迟格式化、编译期与运行期级别过滤 (参数不求值)、
+// 多线程写入后按时间合并输出、缓冲区写满时丢弃而不阻塞、线程退出后缓冲区复用、DPrintf
+#define BINLOG_ACTIVE_LEVEL BINLOG_LEVEL_DEBUG  // 本文件里的 BLOG_TRACE 在编译期去掉
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "binlog.h"
+#include "util.h"
+
+// 收集 sink 收到的记录
+struct Captured {
+  std::mutex mutex;
+  std::vector<BinLogRecord> records;
+
+  void Install() {
+    Take();
+    BinLogger::GetInstance().SetSink([this](const BinLogRecord &r) {
+      std::lock_guard<std::mutex> lock(mutex);
+      records.push_back(r);
+    });
+  }
+  std::vector<BinLogRecord> Take() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<BinLogRecord> out;
+    out.swap(records);
+    return out;
+  }
+  std::string Last() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return records.empty() ? "" : records.back().message;
+  }
+};
+
+static Captured g_captured;
+
+static int g_evaluated = 0;
+static int Touch() { return ++g_evaluated; }
+
+enum class Color { kRed = 3 };
+
+static void TestBraceFormat() {
+  std::cout << "[Test] {} format... ";
+  g_captured.Install();
+  std::string name = "kv";
+  const char *null_str = nullptr;
+  int x = 7;
+  BLOG_INFO("plain");
+  assert(g_captured.Last() == "plain");
+  BLOG_INFO("{} + {} = {}", 1, -2, uint64_t{18446744073709551615ULL});
+  assert(g_captured.Last() == "1 + -2 = 18446744073709551615");
+  BLOG_INFO("{} {} {} {} {}", name, "lit", true, 'c', null_str);
+  assert(g_captured.Last() == "kv lit true c (null)");
+  BLOG_INFO("{:x} {:08d} {:.2f} {:>5} {:<4}|", 255, 42, 3.14159, "ab", 7);
+  assert(g_captured.Last() == "ff 00000042 3.14    ab 7   |");
+  BLOG_INFO("{} {}", 0.5, Color::kRed);
+  assert(g_captured.Last() == "0.5 3");
+  BLOG_INFO("{{}} {{{}}}", 9);
+  assert(g_captured.Last() == "{} {9}");
+  // 参数不够：原样保留占位符；多余的参数忽略
+  BLOG_INFO("{} {}", 1);
+  assert(g_captured.Last() == "1 {}");
+  BLOG_INFO("{}", 1, 2);
+  assert(g_captured.Last() == "1");
+  BLOG_INFO("p={}", static_cast<void *>(&x));
+  assert(g_captured.Last().compare(0, 4, "p=0x") == 0);
+  // 超长字符串截断到 kMaxStringArg
+  BLOG_INFO("{}", std::string(5000, 'z'));
+  assert(g_captured.Last() == std::string(binlog_detail::kMaxStringArg, 'z'));
+
+  std::vector<BinLogRecord> records = g_captured.Take();
+  assert(records.back().site->level == BinLogLevel::kInfo);
+  assert(std::string(records.back().site->file).find("test_binlog.cpp") != std::string::npos);
+  std::cout << "PASSED" << std::endl;
+}
+
+static void TestPrintfFormat() {
+  std::cout << "[Test] printf format (DPrintf)... ";
+  g_captured.Install();
+  long long big = -5000000000LL;
+  unsigned long ul = 12;
+  DPrintf("[term %d] %s -> %lu, %lld %5.1f%% %x %c", 3, "vote", ul, big, 99.44, 255, 'q');
+  assert(g_captured.Last() == "[term 3] vote -> 12, -5000000000  99.4% ff q");
+  DPrintf("no args");
+  assert(g_captured.Last() == "no args");
+  // 参数类型与转换字符不匹配：按参数自身类型输出，不读错内存
+  DPrintf("%d|%s|%d", "str", 5, 1);
+  assert(g_captured.Last() == "str|5|1");
+  DPrintf("%d %d", 1);
+  assert(g_captured.Last() == "1 %d");
+  assert(g_captured.Take().back().site->level == BinLogLevel::kDebug);
+  std::cout << "PASSED" << std::endl;
+}
+
+static void TestLevelGating() {
+  std::cout << "[Test] compile-time and runtime level gating... ";
+  BinLogger &logger = BinLogger::GetInstance();
+  g_captured.Install();
+  g_evaluated = 0;
+  logger.SetLevel(BinLogLevel::kTrace);
+  // 编译期：BINLOG_ACTIVE_LEVEL = DEBUG，BLOG_TRACE 不生成代码，参数不求值
+  BLOG_TRACE("trace {}", Touch());
+  assert(g_evaluated == 0 && g_captured.Take().empty());
+  BLOG_DEBUG("debug {}", Touch());
+  assert(g_evaluated == 1 && g_captured.Last() == "debug 1");
+
+  // 运行期：低于 SetLevel 的调用同样不求值参数
+  logger.SetLevel(BinLogLevel::kWarn);
+  assert(!logger.ShouldLog(BinLogLevel::kInfo) && logger.ShouldLog(BinLogLevel::kError));
+  BLOG_INFO("info {}", Touch());
+  DPrintf("dprintf %d", Touch());
+  assert(g_evaluated == 1);
+  BLOG_ERROR("error {}", Touch());
+  assert(g_evaluated == 2 && g_captured.Last() == "error 2");
+  logger.SetLevel(BinLogLevel::kTrace);
+  assert(logger.Level() == BinLogLevel::kTrace);
+  std::cout << "PASSED" << std::endl;
+}
+
+static void TestAsyncMultiThread() {
+  std::cout << "[Test] async capture from many threads... ";
+  BinLogger &logger = BinLogger::GetInstance();
+  g_captured.Install();
+  std::atomic<bool> started{false};
+  assert(logger.Start(1 << 20, std::chrono::milliseconds(5), [&]() { started = true; }));
+  assert(!logger.Start(1 << 20, std::chrono::milliseconds(5)));
+  assert(logger.Running());
+  uint64_t dropped_before = logger.Dropped();
+
+  const int kThreads = 4;
+  const int kPerThread = 2000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([t]() {
+      std::string tag = "worker-" + std::to_string(t);
+      for (int i = 0; i < kPerThread; ++i) BLOG_INFO("{} seq={} half={:.1f}", tag, i, i / 2.0);
+    });
+  }
+  for (auto &th : threads) th.join();
+  logger.Flush();
+  assert(started);
+
+  std::vector<BinLogRecord> records = g_captured.Take();
+  assert(logger.Dropped() == dropped_before);
+  assert(records.size() == static_cast<size_t>(kThreads * kPerThread));
+  std::map<std::string, int> next;  // 每个线程的记录按顺序到达
+  std::map<uint32_t, std::string> tid_tag;
+  for (const BinLogRecord &r : records) {
+    size_t sp = r.message.find(' ');
+    std::string tag = r.message.substr(0, sp);
+    int seq = next[tag]++;
+    std::string expect = tag + " seq=" + std::to_string(seq) + " half=";
+    assert(r.message.compare(0, expect.size(), expect) == 0);
+    // 同一线程号只对应一个写入线程
+    auto it = tid_tag.emplace(r.tid, tag).first;
+    assert(it->second == tag);
+  }
+  assert(next.size() == static_cast<size_t>(kThreads) && tid_tag.size() == static_cast<size_t>(kThreads));
+  for (auto &kv : next) assert(kv.second == kPerThread);
+
+  // 线程退出后缓冲区被新线程复用，已写入但还没取走的记录照常输出
+  std::thread([]() { BLOG_WARN("from a short-lived thread"); }).join();
+  std::thread([]() { BLOG_WARN("from its successor"); }).join();
+  logger.Flush();
+  records = g_captured.Take();
+  assert(records.size() == 2);
+  assert(records[0].message == "from a short-lived thread" && records[1].message == "from its successor");
+
+  logger.Stop();
+  assert(!logger.Running());
+  logger.Flush();  // 未启动：立即返回
+  // 停止后回到同步模式
+  BLOG_INFO("sync again {}", 1);
+  assert(g_captured.Last() == "sync again 1");
+  g_captured.Take();
+  std::cout << "PASSED" << std::endl;
+}
+
+static void TestDropWhenFull() {
+  std::cout << "[Test] full buffer drops instead of blocking... ";
+  BinLogger &logger = BinLogger::GetInstance();
+  // sink 卡住后台线程：调用线程必须照样很快返回
+  std::mutex gate;
+  std::atomic<int> delivered{0};
+  std::vector<std::string> warnings;
+  logger.SetSink([&](const BinLogRecord &r) {
+    std::lock_guard<std::mutex> lock(gate);
+    if (r.site->level == BinLogLevel::kWarn) warnings.push_back(r.message);
+    else ++delivered;
+  });
+  std::unique_lock<std::mutex> hold(gate);
+  assert(logger.Start(4096, std::chrono::milliseconds(1)));
+  uint64_t dropped_before = logger.Dropped();
+
+  // 另起一个线程写入 (可能复用前面线程留下的 1MB 缓冲区，也可能新建 4KB 的)
+  const int kTotal = 50000;  // 约 3.5MB：无论复用到哪个缓冲区都会写满
+  auto start = std::chrono::steady_clock::now();
+  std::thread([&]() {
+    for (int i = 0; i < kTotal; ++i) BLOG_INFO("record {} {}", i, "padding-padding-padding");
+  }).join();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  assert(elapsed < std::chrono::seconds(5));
+  uint64_t dropped = logger.Dropped() - dropped_before;
+  assert(dropped > 0);
+
+  hold.unlock();
+  logger.Flush();
+  logger.Flush();  // 头一轮 Drain 可能在放开 sink 之前就取走了一部分
+  {
+    std::lock_guard<std::mutex> lock(gate);
+    assert(static_cast<uint64_t>(delivered.load()) + dropped == static_cast<uint64_t>(kTotal));
+    assert(!warnings.empty() && warnings.back().find("messages dropped") != std::string::npos);
+  }
+  logger.Stop();
+  logger.SetSink(nullptr);
+  std::cout << "PASSED" << std::endl;
+}
+
+static void TestBinaryFormatDirect() {
+  std::cout << "[Test] Format decodes the raw argument block... ";
+  static constexpr BinLogSite site{BinLogLevel::kInfo, false, __FILE__, __LINE__, "{}-{}"};
+  char buf[64];
+  char *p = binlog_detail::ArgOf<int>::Encode(buf, 12);
+  p = binlog_detail::ArgOf<std::string>::Encode(p, std::string("ab"));
+  size_t len = static_cast<size_t>(p - buf);
+  assert(len == binlog_detail::ArgOf<int>::Size(12) + binlog_detail::ArgOf<std::string>::Size("ab"));
+  assert(BinLogger::Format(site, buf, len) == "12-ab");
+  // 截断的参数区不会越界读
+  assert(BinLogger::Format(site, buf, len - 1) == "12-{}");
+  assert(BinLogger::Format(site, buf, 0) == "{}-{}");
+  std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+  TestBraceFormat();
+  TestPrintfFormat();
+  TestLevelGating();
+  TestAsyncMultiThread();
+  TestDropWhenFull();
+  TestBinaryFormatDirect();
+  std::cout << "All binlog tests passed!" << std::endl;
+  return 0;
+}
@@ -0,0 +1,246 @@
+// test_cpu_topology.cpp
+// CPU / NUMA 放置：CPU 列表解析与格式化、从 sysfs 探测拓扑、默认布局下 Raft 与客户端 IO 不共享核、
+// 配置校验、线程绑定 (sched_getaffinity 验证)、本地 node 内存分配
+#include <pthread.h>
+#include <sched.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cpu_topology.h"
+
+using Nodes = std::vector<std::vector<int>>;
+
+static std::vector<int> Range(int lo, int hi) {
+  std::vector<int> out;
+  for (int i = lo; i <= hi; ++i) out.push_back(i);
+  return out;
+}
+
+static bool Disjoint(const std::vector<int> &a, const std::vector<int> &b) {
+  for (int x : a) {
+    if (std::find(b.begin(), b.end(), x) != b.end()) return false;
+  }
+  return true;
+}
+
+static void WriteFile(const std::string &path, const std::string &content) {
+  std::ofstream out(path);
+  out << content;
+}
+
+static void TestCpuList() {
+  std::cout << "[Test] cpu list parse / format... ";
+  std::vector<int> cpus;
+  assert(ParseCpuList("0-3,8,10-11", &cpus));
+  assert((cpus == std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+  assert(FormatCpuList(cpus) == "0-3,8,10-11");
+  assert(ParseCpuList(" 5,1,1-2\n", &cpus));
+  assert((cpus == std::vector<int>{1, 2, 5}));
+  assert(FormatCpuList({7, 3, 4, 3}) == "3-4,7");
+  assert(FormatCpuList({}).empty());
+  for (const char *bad : {"", "a", "1-", "-1", "3-1", "1,,2", "1,", "2x", "1-2-3"}) {
+    assert(!ParseCpuList(bad, &cpus));
+  }
+  std::cout << "PASSED" << std::endl;
+}
+
+static void TestDetect() {
+  std::cout << "[Test] detect topology from sysfs... ";
+  char tmpl[] = "/tmp/cpu_topology_XXXXXX";
+  std::string root = ::mkdtemp(tmpl);
+  ::mkdir((root + "/node").c_str(), 0755);
+  ::mkdir((root + "/node/node0").c_str(), 0755);
+  ::mkdir((root + "/node/node1").c_str(), 0755);
+  ::mkdir((root + "/node/node2").c_str(), 0755);  // 纯内存 node
+  ::mkdir((root + "/node/possible").c_str(), 0755);  // 不是 node<N>，忽略
+  WriteFile(root + "/node/node0/cpulist", "0-3,8-11\n");
+  WriteFile(root + "/node/node1/cpulist", "4-7,12-15\n");
+  WriteFile(root + "/node/node2/cpulist", "\n");
+
+  CpuTopology topo = CpuTopology::Detect(root);
+  assert(topo.NumNodes() == 3);
+  assert((topo.NodeCpus(0) == std::vector<int>{0, 1, 2, 3, 8, 9, 10, 11}));
+  assert(topo.NodeCpus(2).empty() && topo.NodeCpus(5).empty());
+  assert(topo.AllCpus() == Range(0, 15));
+  assert(topo.NodeOfCpu(12) == 1 && topo.NodeOfCpu(9) == 0 && topo.NodeOfCpu(16) == -1);
+
+  // 没有 node 目录：退回 cpu/online，视为一个 node
+  std::string flat = root + "/flat";
+  ::mkdir(flat.c_str(), 0755);
+  ::mkdir((flat + "/cpu").c_str(), 0755);
+  WriteFile(flat + "/cpu/online", "0-5\n");
+  CpuTopology single = CpuTopology::Detect(flat);
+  assert(single.NumNodes() == 1 && single.AllCpus() == Range(0, 5));
+
+  // 本机：至少一个 CPU，当前 CPU 在拓扑内
+  const CpuTopology &local = CpuTopology::GetInstance();
+  assert(!local.AllCpus().empty());
+  assert(local.NodeOfCpu(::sched_getcpu()) >= 0);
+  std::string cmd = "rm -rf " + root;
+  assert(std::system(cmd.c_str()) == 0);
+  std::cout << "PASSED" << std::endl;
+}
+
+static void TestAutoLayout() {
+  std::cout << "[Test] auto layout keeps raft off client IO cores... ";
+  auto check = [](const CpuTopology &topo, bool isolated) {
+    auto layout = ThreadPlacement::AutoLayout(topo);
+    for (const std::string &group : ThreadPlacement::Groups()) {
+      assert(!layout[group].empty());
+      for (int cpu : layout[group]) assert(topo.NodeOfCpu(cpu) >= 0);
+    }
+    bool disjoint = Disjoint(layout[kPlacementRaft], layout[kPlacementRpcIo]) &&
+                    Disjoint(layout[kPlacementRaft], layout[kPlacementRpcClient]) &&
+                    Disjoint(layout[kPlacementRaft], layout[kPlacementGrpc]);
+    assert(disjoint == isolated);
+    return layout;
+  };
+
+  check(CpuTopology(Nodes{{0}}), false);  // 一个核：只能共享
+  auto two = check(CpuTopology(Nodes{{0, 1}}), true);
+  assert(two[kPlacementRaft] == std::vector<int>{0} && two[kPlacementRpcIo] == std::vector<int>{1});
+
+  // 单 node 8 核：0-3 Raft 侧 (0-1 raft，2-3 apply / log)，4-7 IO 侧
+  auto eight = check(CpuTopology(Nodes{Range(0, 7)}), true);
+  assert(eight[kPlacementRaft] == Range(0, 1));
+  assert(eight[kPlacementApply] == Range(2, 3) && eight[kPlacementLog] == Range(2, 3));
+  assert(eight[kPlacementRpcIo] == Range(4, 5) && eight[kPlacementRpcWorker] == Range(6, 7));
+  assert(Disjoint(eight[kPlacementApply], eight[kPlacementRpcWorker]));
+
+  // 两个 node：node 0 给 Raft 侧，node 1 给 IO 侧
+  CpuTopology numa(Nodes{Range(0, 7), Range(8, 15)});
+  auto two_nodes = check(numa, true);
+  for (const char *g : {kPlacementRaft, kPlacementApply, kPlacementLog}) {
+    for (int cpu : two_nodes[g]) assert(numa.NodeOfCpu(cpu) == 0);
+  }
+  for (const char *g : {kPlacementRpcIo, kPlacementRpcClient, kPlacementGrpc, kPlacementRpcWorker, kPlacementRuntime}) {
+    for (int cpu : two_nodes[g]) assert(numa.NodeOfCpu(cpu) == 1);
+  }
+  // 第一个 node 没有 CPU 时跳过它
+  auto skip = check(CpuTopology(Nodes{{}, Range(0, 3), Range(4, 7)}), true);
+  assert(skip[kPlacementRaft] == Range(0, 1));
+  std::cout << "PASSED" << std::endl;
+}
+
+static void TestConfigure() {
+  std::cout << "[Test] configure from specs... ";
+  ThreadPlacement &placement = ThreadPlacement::GetInstance();
+  CpuTopology numa(Nodes{Range(0, 7), Range(8, 15)});
+  std::string error;
+
+  assert(!placement.Configure(numa, {{"nope", "0"}}, &error) && error.find("nope") != std::string::npos);
+  assert(!placement.Configure(numa, {{kPlacementRaft, "0-x"}}, &error));
+  assert(!placement.Configure(numa, {{kPlacementRaft, "node2"}}, &error));
+  assert(!placement.Configure(numa, {{kPlacementRaft, "nodeX"}}, &error));
+  assert(!placement.Configure(numa, {{kPlacementRaft, "16"}}, &error) && error.find("16") != std::string::npos);
+  // 失败不改变状态
+  assert(!placement.Enabled() && placement.Cpus(kPlacementRaft).empty());
+
+  assert(placement.Configure(numa, {{kPlacementRaft, "2-3"}, {kPlacementGrpc, "node1"}}, &error));
+  assert(placement.Enabled());
+  assert(placement.Cpus(kPlacementRaft) == Range(2, 3));
+  assert(placement.Cpus(kPlacementGrpc) == Range(8, 15));
+  assert(placement.Cpus(kPlacementRpcIo) == ThreadPlacement::AutoLayout(numa)[kPlacementRpcIo]);
+  assert(placement.Cpus("unknown").empty());
+  assert(placement.Isolated());
+  assert(placement.Describe().find("raft: 2-3 (node 0)") != std::string::npos);
+  assert(placement.Describe().find("grpc: 8-15 (node 1)") != std::string::npos);
+
+  // 手工把 Raft 放到 IO 核上：不再隔离
+  assert(placement.Configure(numa, {{kPlacementRaft, "8"}}, &error));
+  assert(!placement.Isolated());
+
+  placement.Disable();
+  assert(!placement.Enabled() && placement.Cpus(kPlacementRaft).empty() && placement.Describe().empty());
+  assert(!placement.PinCurrentThread(kPlacementRaft));
+  std::cout << "PASSED" << std::endl;
+}
+
+static std::vector<int> Affinity() {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  assert(::sched_getaffinity(0, sizeof(set), &set) == 0);
+  std::vector<int> out;
+  for (int i = 0; i < CPU_SETSIZE; ++i) {
+    if (CPU_ISSET(i, &set)) out.push_back(i);
+  }
+  return out;
+}
+
+static void TestPinCurrentThread() {
+  std::cout << "[Test] pin threads to their group... ";
+  ThreadPlacement &placement = ThreadPlacement::GetInstance();
+  // 只用本进程允许的 CPU (容器 / taskset 下可能不是全部在线 CPU)
+  std::vector<int> allowed = Affinity();
+  CpuTopology topo(Nodes{allowed});
+  std::string error;
+  std::string last = std::to_string(allowed.back());
+  assert(placement.Configure(topo, {{kPlacementRaft, FormatCpuList(allowed)}, {kPlacementApply, last}}, &error));
+
+  std::thread([&]() {
+    // 浮动：整组
+    assert(placement.PinCurrentThread(kPlacementRaft));
+    assert(Affinity() == allowed);
+    // 带 index：组内一个核，按组大小取模
+    assert(placement.PinCurrentThread(kPlacementRaft, static_cast<int>(allowed.size()) + 1));
+    assert(Affinity() == std::vector<int>{allowed[1 % allowed.size()]});
+    assert(placement.PinCurrentThread(kPlacementApply, 0));
+    assert(Affinity() == std::vector<int>{allowed.back()});
+    assert(::sched_getcpu() == allowed.back());
+  }).join();
+  // 其他线程不受影响
+  assert(Affinity() == allowed);
+  placement.Disable();
+  std::thread([&]() {
+    assert(!placement.PinCurrentThread(kPlacementRaft, 0));
+    assert(Affinity() == allowed);
+  }).join();
+  std::cout << "PASSED" << std::endl;
+}
+
+static void TestNodeMemory() {
+  std::cout << "[Test] node-local allocation... ";
+  const CpuTopology &topo = CpuTopology::GetInstance();
+  int node = CurrentNumaNode();
+  assert(node >= 0 && node < topo.NumNodes());
+
+  size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+  assert(AllocOnNode(0, node) == nullptr);
+  char *p = static_cast<char *>(AllocOnNode(100, node));
+  assert(p && reinterpret_cast<uintptr_t>(p) % page == 0);
+  for (size_t i = 0; i < page; ++i) assert(p[i] == 0);  // 整页可用且为 0
+  std::memset(p, 0x5a, page);
+  FreeOnNode(p, 100);
+
+  char *q = static_cast<char *>(AllocOnNode(3 * page, -1));
+  assert(q);
+  q[3 * page - 1] = 1;
+  // 单 node 的机器上绑定是空操作；非法 node 总是失败
+  assert(BindToNode(q, 3 * page, topo.NumNodes() + 1) == false);
+  assert(BindToNode(nullptr, page, 0) == false);
+  if (topo.NumNodes() == 1) assert(!BindToLocalNode(q, 3 * page));
+  FreeOnNode(q, 3 * page);
+  FreeOnNode(nullptr, page);
+  std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+  TestCpuList();
+  TestDetect();
+  TestAutoLayout();
+  TestConfigure();
+  TestPinCurrentThread();
+  TestNodeMemory();
+  std::cout << "All cpu topology tests passed!" << std::endl;
+  return 0;
+}
@@ -0,0 +1,137 @@
+// test_latency_tracker.cpp
+// LatencyTracker：分桶边界、分位数、EWMA、衰减跟随、由分布推导超时、并发记录
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "latency_tracker.h"
+
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+static void TestBuckets() {
+    std::cout << "[Test] bucket boundaries... ";
+    uint64_t prev_upper = 0;
+    for (size_t i = 0; i + 1 < LatencyTracker::kBuckets; ++i) {
+        uint64_t upper = LatencyTracker::BucketUpper(i);
+        assert(i == 0 || upper > prev_upper);
+        assert(LatencyTracker::BucketOf(upper) == i);
+        assert(LatencyTracker::BucketOf(upper + 1) == i + 1);
+        // 相对误差 < 25%
+        uint64_t lower = (i == 0) ? 0 : prev_upper + 1;
+        assert(upper - lower <= upper / 4 + 1);
+        prev_upper = upper;
+    }
+    assert(LatencyTracker::BucketOf(UINT64_MAX) == LatencyTracker::kBuckets - 1);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestPercentiles() {
+    std::cout << "[Test] percentiles and EWMA... ";
+    LatencyTracker tracker;
+    assert(tracker.PercentileMicros(0.99) == 0 && tracker.EwmaMicros() == 0);
+    // 1000 个样本：990 个 1ms，10 个 50ms
+    for (int i = 0; i < 990; ++i) {
+        tracker.Record(microseconds(1000));
+    }
+    for (int i = 0; i < 10; ++i) {
+        tracker.Record(microseconds(50000));
+    }
+    assert(tracker.Samples() == 1000 && tracker.TotalSamples() == 1000);
+    uint64_t p50 = tracker.PercentileMicros(0.5);
+    uint64_t p99 = tracker.PercentileMicros(0.99);
+    uint64_t p999 = tracker.PercentileMicros(0.999);
+    assert(p50 >= 1000 && p50 < 1250);
+    assert(p99 >= 1000 && p99 < 1250);  // 第 990 个样本仍是 1ms
+    assert(p999 >= 50000 && p999 < 62500);
+    // EWMA 被最近的 10 个慢样本拉高，但远小于 50ms
+    assert(tracker.EwmaMicros() > 1000 && tracker.EwmaMicros() < 50000);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestDecayFollowsRecentLatency() {
+    std::cout << "[Test] histogram decays toward recent samples... ";
+    LatencyTracker tracker;
+    for (uint64_t i = 0; i < LatencyTracker::kDecayEvery; ++i) {
+        tracker.Record(microseconds(500));
+    }
+    assert(tracker.Samples() == LatencyTracker::kDecayEvery / 2);  // 刚好衰减一次
+    assert(tracker.PercentileMicros(0.99) < 1000);
+
+    // 对端变慢：几轮衰减后 p95 反映新的延迟
+    for (uint64_t i = 0; i < 4 * LatencyTracker::kDecayEvery; ++i) {
+        tracker.Record(microseconds(20000));
+    }
+    assert(tracker.PercentileMicros(0.95) >= 20000);
+    assert(tracker.EwmaMicros() > 15000);
+    assert(tracker.Samples() < 2 * LatencyTracker::kDecayEvery);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestAdaptiveTimeout() {
+    std::cout << "[Test] timeout derived from p99... ";
+    AdaptiveTimeoutOptions options;
+    options.default_ms = 100;
+    options.min_ms = 20;
+    options.max_ms = 150;
+    options.multiplier = 3.0;
+    options.min_samples = 32;
+
+    LatencyTracker tracker;
+    for (int i = 0; i < 31; ++i) {
+        tracker.Record(microseconds(10000));
+    }
+    assert(tracker.Timeout(options) == milliseconds(100));  // 样本不足
+
+    tracker.Record(microseconds(10000));
+    milliseconds timeout = tracker.Timeout(options);
+    assert(timeout >= milliseconds(30) && timeout <= milliseconds(38));  // 3 * p99 (10ms 所在桶上界)
+
+    LatencyTracker fast;
+    for (int i = 0; i < 100; ++i) {
+        fast.Record(microseconds(200));
+    }
+    assert(fast.Timeout(options) == milliseconds(20));  // 下限
+
+    LatencyTracker slow;
+    for (int i = 0; i < 100; ++i) {
+        slow.Record(milliseconds(400));
+    }
+    assert(slow.Timeout(options) == milliseconds(150));  // 上限
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestConcurrentRecord() {
+    std::cout << "[Test] concurrent Record keeps every sample... ";
+    LatencyTracker tracker;
+    const int kThreads = 4;
+    const int kPerThread = 100000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&tracker, t] {
+            for (int i = 0; i < kPerThread; ++i) {
+                tracker.Record(microseconds(100 * (t + 1)));
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    assert(tracker.TotalSamples() == static_cast<uint64_t>(kThreads) * kPerThread);
+    assert(tracker.Samples() > 0 && tracker.Samples() <= 2 * LatencyTracker::kDecayEvery + kThreads);
+    uint64_t p99 = tracker.PercentileMicros(0.99);
+    assert(p99 >= 100 && p99 < 500);
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    TestBuckets();
+    TestPercentiles();
+    TestDecayFollowsRecentLatency();
+    TestAdaptiveTimeout();
+    TestConcurrentRecord();
+    std::cout << "All LatencyTracker tests passed!" << std::endl;
+    return 0;
+}
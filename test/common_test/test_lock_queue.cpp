@@ -293,10 +293,184 @@ bool test_stress_multi_producer_consumer() {
     return passed;
 }
 
+// ==========================================================
+// RingQueue (有界无锁环形队列)
+// ==========================================================
+
+/**
+ * @brief 测试用例 9: RingQueue 基本语义 (FIFO / 容量取整 / 满时 TryPush 失败 / 超时 Pop)
+ */
+bool test_ring_basic() {
+    const std::string test_name = "test_ring_basic";
+    std::cout << "Running: " << test_name << "..." << std::endl;
+    MpmcRingQueue<std::unique_ptr<int>> queue(3); // 向上取整为 4
+
+    bool passed = true;
+    passed &= check(queue.Capacity() == 4, test_name, "Capacity should round up to 4");
+    passed &= check(queue.Empty(), test_name, "New queue should be empty");
+    for (int i = 0; i < 4; ++i) {
+        passed &= check(queue.TryPush(std::make_unique<int>(i)), test_name, "TryPush should succeed");
+    }
+    passed &= check(queue.IsFull(), test_name, "Queue should be full");
+    auto extra = std::make_unique<int>(99);
+    passed &= check(!queue.TryPush(std::move(extra)), test_name, "TryPush on full queue should fail");
+    passed &= check(extra != nullptr, test_name, "Failed TryPush must not consume the item");
+    passed &= check(!queue.timeOutPush(std::move(extra), 20), test_name, "timeOutPush on full queue should time out");
+
+    std::unique_ptr<int> out;
+    for (int i = 0; i < 4; ++i) {
+        passed &= check(queue.Pop(out) && *out == i, test_name, "FIFO order failed");
+    }
+    passed &= check(queue.Empty(), test_name, "Queue should be empty");
+
+    auto start = std::chrono::steady_clock::now();
+    passed &= check(!queue.timeOutPop(30, out), test_name, "timeOutPop on empty queue should fail");
+    auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    passed &= check(waited >= 30, test_name, "timeOutPop returned too early");
+    return passed;
+}
+
+/**
+ * @brief 测试用例 10: RingQueue Shutdown 唤醒 park 的消费者，且残留数据仍可取出
+ */
+bool test_ring_shutdown() {
+    const std::string test_name = "test_ring_shutdown";
+    std::cout << "Running: " << test_name << "..." << std::endl;
+    SpscRingQueue<int> queue(8);
+    std::atomic<bool> pop_returned(false);
+    std::atomic<bool> pop_success(true);
+
+    std::thread consumer_thread([&]() {
+        int out;
+        pop_success = queue.Pop(out); // 自旋后 park
+        pop_returned = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    bool passed = true;
+    passed &= check(!pop_returned, test_name, "Pop() should be blocked");
+    queue.Shutdown();
+    consumer_thread.join();
+    passed &= check(!pop_success, test_name, "Pop() should return false when woken by Shutdown");
+    passed &= check(!queue.Push(1), test_name, "Push() after Shutdown should return false");
+
+    MpscRingQueue<int> drained(8);
+    drained.Push(7);
+    drained.Push(8);
+    drained.Shutdown();
+    std::vector<int> items;
+    passed &= check(drained.PopBatch(items, 10) == 2, test_name, "PopBatch should drain items pushed before Shutdown");
+    passed &= check(items.size() == 2 && items[0] == 7 && items[1] == 8, test_name, "Drained data mismatch");
+    int out;
+    passed &= check(!drained.Pop(out), test_name, "Pop() on drained shutdown queue should fail");
+    return passed;
+}
+
+// 通用的多生产者/多消费者完整性检查：每个值恰好被消费一次
+template <typename Queue>
+bool run_ring_stress(const std::string& test_name, int producers, int consumers, int items_per_producer) {
+    Queue queue(64); // 小容量，频繁触发满/空等待
+    std::vector<std::atomic<int>> seen(producers * items_per_producer);
+    for (auto& s : seen) s = 0;
+
+    std::vector<std::thread> threads;
+    for (int c = 0; c < consumers; ++c) {
+        threads.emplace_back([&]() {
+            int val;
+            while (queue.Pop(val)) {
+                seen[val]++;
+            }
+        });
+    }
+    std::vector<std::thread> producer_threads;
+    for (int p = 0; p < producers; ++p) {
+        producer_threads.emplace_back([&, p]() {
+            for (int j = 0; j < items_per_producer; ++j) {
+                queue.Push(p * items_per_producer + j);
+            }
+        });
+    }
+    for (auto& t : producer_threads) t.join();
+    queue.Shutdown();
+    for (auto& t : threads) t.join();
+
+    bool passed = true;
+    for (size_t i = 0; i < seen.size(); ++i) {
+        if (seen[i] != 1) {
+            passed &= check(false, test_name, "Item " + std::to_string(i) + " consumed " + std::to_string(seen[i]) + " times");
+            break;
+        }
+    }
+    return passed;
+}
+
+/**
+ * @brief 测试用例 11: RingQueue 压力测试 (MPMC / MPSC / SPSC 三种特化)
+ */
+bool test_ring_stress() {
+    const std::string test_name = "test_ring_stress";
+    std::cout << "Running: " << test_name << "..." << std::endl;
+    bool passed = true;
+    passed &= run_ring_stress<MpmcRingQueue<int>>(test_name + "/mpmc", 4, 4, 20000);
+    passed &= run_ring_stress<MpscRingQueue<int>>(test_name + "/mpsc", 4, 1, 20000);
+    passed &= run_ring_stress<SpscRingQueue<int>>(test_name + "/spsc", 1, 1, 80000);
+    return passed;
+}
+
+// 吞吐测试：producers 个线程各 Push items_per_producer 个，一个消费者全部 Pop 完
+template <typename Queue>
+double bench_queue_throughput(int producers, int items_per_producer) {
+    Queue queue(1024);
+    const long total = static_cast<long>(producers) * items_per_producer;
+    auto start = std::chrono::steady_clock::now();
+
+    std::thread consumer([&]() {
+        int val;
+        for (long n = 0; n < total; ++n) {
+            queue.Pop(val);
+        }
+    });
+    std::vector<std::thread> producer_threads;
+    for (int p = 0; p < producers; ++p) {
+        producer_threads.emplace_back([&]() {
+            for (int j = 0; j < items_per_producer; ++j) {
+                queue.Push(j);
+            }
+        });
+    }
+    for (auto& t : producer_threads) t.join();
+    consumer.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return total / seconds / 1e6; // 百万次/秒
+}
+
+/**
+ * @brief 测试用例 12: LockQueue vs RingQueue 吞吐对比 (只打印结果，不设阈值)
+ */
+bool test_queue_benchmark() {
+    const std::string test_name = "test_queue_benchmark";
+    std::cout << "Running: " << test_name << "..." << std::endl;
+    const int kItems = 200000;
+
+    double lock_spsc = bench_queue_throughput<LockQueue<int>>(1, kItems);
+    double ring_spsc = bench_queue_throughput<SpscRingQueue<int>>(1, kItems);
+    double lock_mpsc = bench_queue_throughput<LockQueue<int>>(4, kItems / 4);
+    double ring_mpsc = bench_queue_throughput<MpscRingQueue<int>>(4, kItems / 4);
+    double ring_mpmc = bench_queue_throughput<MpmcRingQueue<int>>(4, kItems / 4);
+
+    std::lock_guard<std::mutex> lock(g_print_mutex);
+    std::cout << "  [1P1C] LockQueue     : " << lock_spsc << " Mops/s" << std::endl;
+    std::cout << "  [1P1C] SpscRingQueue : " << ring_spsc << " Mops/s" << std::endl;
+    std::cout << "  [4P1C] LockQueue     : " << lock_mpsc << " Mops/s" << std::endl;
+    std::cout << "  [4P1C] MpscRingQueue : " << ring_mpsc << " Mops/s" << std::endl;
+    std::cout << "  [4P1C] MpmcRingQueue : " << ring_mpmc << " Mops/s" << std::endl;
+    return true;
+}
+
 
 int main() {
     int passed = 0;
-    const int total = 8;
+    const int total = 12;
 
     if (test_fifo_and_size()) passed++;
     if (test_move_semantics()) passed++;
@@ -306,6 +480,10 @@ int main() {
     if (test_shutdown_unblocks_push()) passed++;
     if (test_batch_operations()) passed++;
     if (test_stress_multi_producer_consumer()) passed++;
+    if (test_ring_basic()) passed++;
+    if (test_ring_shutdown()) passed++;
+    if (test_ring_stress()) passed++;
+    if (test_queue_benchmark()) passed++;
 
 
     std::cout << "----------------------------------" << std::endl;
@@ -0,0 +1,177 @@
+// test_metrics.cpp
+// 指标子系统：直方图分桶与分位数、分片计数的并发正确性、注册表去重与类型冲突、
+// Prometheus 文本格式、回调指标、HTTP 抓取端点 (/metrics 与 /trace)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "metrics.h"
+#include "metrics_server.h"
+
+static void TestBuckets() {
+    std::cout << "[Test] histogram buckets... ";
+    uint64_t prev_upper = 0;
+    for (size_t i = 0; i + 1 < MetricHistogram::kBuckets; ++i) {
+        uint64_t upper = MetricHistogram::BucketUpper(i);
+        assert(i == 0 || upper > prev_upper);
+        assert(MetricHistogram::BucketOf(upper) == i);
+        assert(MetricHistogram::BucketOf(upper + 1) == i + 1);
+        // 相对误差 < 12.5%
+        uint64_t lower = (i == 0) ? 0 : prev_upper + 1;
+        assert(upper - lower <= upper / 8 + 1);
+        prev_upper = upper;
+    }
+    assert(MetricHistogram::BucketUpper(MetricHistogram::kBuckets - 1) == (uint64_t{1} << 36) - 1);
+    assert(MetricHistogram::BucketOf(UINT64_MAX) == MetricHistogram::kBuckets - 1);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestPercentiles() {
+    std::cout << "[Test] histogram percentiles... ";
+    MetricHistogram h;
+    assert(h.Collect().Percentile(0.99) == 0);
+    // 1000 个样本：980 个 100us，20 个 20ms 的尾巴
+    for (int i = 0; i < 980; ++i) h.Record(100);
+    for (int i = 0; i < 20; ++i) h.Record(20000);
+    MetricHistogram::Snapshot snap = h.Collect();
+    assert(snap.count == 1000 && snap.sum == 980 * 100 + 20 * 20000);
+    uint64_t p50 = snap.Percentile(0.5);
+    uint64_t p99 = snap.Percentile(0.99);
+    assert(p50 >= 100 && p50 < 100 + 100 / 8);
+    assert(p99 >= 20000 && p99 < 20000 + 20000 / 8);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestConcurrentRecord() {
+    std::cout << "[Test] sharded counter / histogram under contention... ";
+    MetricCounter counter;
+    MetricHistogram h;
+    const int kThreads = 8;
+    const int kPerThread = 100000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < kPerThread; ++i) {
+                counter.Add();
+                h.Record(static_cast<uint64_t>(t * 1000 + i % 1000));
+            }
+        });
+    }
+    for (auto &th : threads) th.join();
+    assert(counter.Value() == static_cast<uint64_t>(kThreads) * kPerThread);
+    assert(h.Collect().count == static_cast<uint64_t>(kThreads) * kPerThread);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestRegistry() {
+    std::cout << "[Test] registry and exposition format... ";
+    MetricsRegistry &reg = MetricsRegistry::GetInstance();
+    MetricCounter *c1 = reg.GetCounter("test_requests_total", {{"method", "Get"}}, "Requests served");
+    MetricCounter *c2 = reg.GetCounter("test_requests_total", {{"method", "Get"}});
+    MetricCounter *c3 = reg.GetCounter("test_requests_total", {{"method", "Put"}});
+    assert(c1 && c1 == c2 && c1 != c3);
+    assert(reg.GetHistogram("test_requests_total") == nullptr);  // 同名不同类型
+    c1->Add(3);
+    c3->Add();
+
+    MetricHistogram *h = reg.GetHistogram("test_latency_microseconds", {{"peer", "n\"1"}});
+    h->Record(5);
+    h->Record(5);
+    h->Record(1000);
+
+    int pending = 7;
+    int id = reg.AddCallback("test_pending", {}, MetricsRegistry::Type::kGauge, [&pending] { return pending; });
+    assert(id > 0);
+
+    std::string text = reg.RenderPrometheus();
+    assert(text.find("# HELP test_requests_total Requests served\n") != std::string::npos);
+    assert(text.find("# TYPE test_requests_total counter\n") != std::string::npos);
+    assert(text.find("test_requests_total{method=\"Get\"} 3\n") != std::string::npos);
+    assert(text.find("test_requests_total{method=\"Put\"} 1\n") != std::string::npos);
+    assert(text.find("# TYPE test_latency_microseconds histogram\n") != std::string::npos);
+    assert(text.find("test_latency_microseconds_bucket{peer=\"n\\\"1\",le=\"5\"} 2\n") != std::string::npos);
+    assert(text.find("test_latency_microseconds_bucket{peer=\"n\\\"1\",le=\"+Inf\"} 3\n") != std::string::npos);
+    assert(text.find("test_latency_microseconds_sum{peer=\"n\\\"1\"} 1010\n") != std::string::npos);
+    assert(text.find("test_latency_microseconds_count{peer=\"n\\\"1\"} 3\n") != std::string::npos);
+    assert(text.find("test_pending 7\n") != std::string::npos);
+
+    // 注销之后不再读取 (被读取的对象可能已经析构)
+    reg.RemoveCallback(id);
+    text = reg.RenderPrometheus();
+    assert(text.find("test_pending 7") == std::string::npos);
+    std::cout << "PASSED" << std::endl;
+}
+
+static std::string HttpGet(uint16_t port, const std::string &path) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    assert(fd >= 0);
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    ::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    int rc = ::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+    assert(rc == 0);
+    (void)rc;
+    std::string req = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    ::send(fd, req.data(), req.size(), 0);
+    std::string resp;
+    char buf[4096];
+    ssize_t n;
+    while ((n = ::recv(fd, buf, sizeof(buf), 0)) > 0) {
+        resp.append(buf, static_cast<size_t>(n));
+    }
+    ::close(fd);
+    return resp;
+}
+
+static void TestServer() {
+    std::cout << "[Test] HTTP scrape endpoint... ";
+    MetricsRegistry::GetInstance().GetCounter("test_scrapes_total")->Add(42);
+    MetricsServer server("127.0.0.1", 0);
+    assert(server.Start());
+    assert(server.Port() != 0);
+
+    std::string resp = HttpGet(server.Port(), "/metrics");
+    assert(resp.compare(0, 15, "HTTP/1.1 200 OK") == 0);
+    assert(resp.find("Content-Type: text/plain; version=0.0.4") != std::string::npos);
+    assert(resp.find("test_scrapes_total 42\n") != std::string::npos);
+    size_t header_end = resp.find("\r\n\r\n");
+    size_t len_pos = resp.find("Content-Length: ");
+    assert(header_end != std::string::npos && len_pos != std::string::npos);
+    assert(std::stoul(resp.substr(len_pos + 16)) == resp.size() - header_end - 4);
+
+    resp = HttpGet(server.Port(), "/trace");
+    assert(resp.compare(0, 15, "HTTP/1.1 200 OK") == 0);
+    assert(resp.find("Content-Type: application/json") != std::string::npos);
+    assert(resp.find("{\"traceEvents\":[") != std::string::npos);
+    resp = HttpGet(server.Port(), "/trace?format=otlp");
+    assert(resp.find("{\"resourceSpans\":[") != std::string::npos);
+
+    resp = HttpGet(server.Port(), "/");
+    assert(resp.compare(0, 22, "HTTP/1.1 404 Not Found") == 0);
+
+    // 端口已被占用
+    MetricsServer dup("127.0.0.1", server.Port());
+    assert(!dup.Start());
+    server.Stop();
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    TestBuckets();
+    TestPercentiles();
+    TestConcurrentRecord();
+    TestRegistry();
+    TestServer();
+    std::cout << "All metrics tests passed!" << std::endl;
+    return 0;
+}
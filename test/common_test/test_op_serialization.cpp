@@ -2,6 +2,7 @@
 #include "util.h" // 包含 Op 类定义和序列化方法
 #include <iostream>
 #include <string>
+#include <vector>
 
 // 一个简单的测试报告辅助函数
 // 返回 true 表示通过，false 表示失败
@@ -104,15 +105,199 @@ bool test_parse_failure() {
     return check(success == false, test_name, "parseFromString() 应该在解析损坏数据时返回 false");
 }
 
+/**
+ * @brief 测试用例 4: 兼容旧格式
+ * @details 升级前写入的日志是 boost 文本归档，parseFromString 必须仍能解析。
+ */
+bool test_parse_legacy_boost() {
+    const std::string test_name = "test_parse_legacy_boost";
+    std::cout << "Running: " << test_name << "..." << std::endl;
+
+    Op op_in;
+    op_in.Operation = "Append";
+    op_in.Key = "k";
+    op_in.Value = "v";
+    op_in.ClientId = "client-legacy";
+    op_in.RequestId = 7;
+
+    Op op_out;
+    bool passed = check(op_out.parseFromString(op_in.asBoostString()), test_name, "旧格式应当可以解析");
+    passed &= check(op_out.Operation == "Append" && op_out.ClientId == "client-legacy" && op_out.RequestId == 7,
+                    test_name, "旧格式字段不匹配");
+    return passed;
+}
+
+/**
+ * @brief 测试用例 5: 二进制编码细节
+ * @details 数字 ClientId 按 varint 编码、负 RequestId、未知操作名、零拷贝视图、截断数据。
+ */
+bool test_binary_codec() {
+    const std::string test_name = "test_binary_codec";
+    std::cout << "Running: " << test_name << "..." << std::endl;
+
+    bool passed = true;
+
+    Op op_in;
+    op_in.Operation = "Put";
+    op_in.Key = "user:1001";
+    op_in.Value = std::string("bin\0ary", 7);
+    op_in.ClientId = "123456789";
+    op_in.RequestId = -1;
+
+    std::string payload = op_in.asString();
+    passed &= check(IsBinaryOp(payload), test_name, "asString 应输出二进制格式");
+    passed &= check(payload.size() < op_in.asBoostString().size(), test_name, "二进制编码应小于文本归档");
+
+    OpView view;
+    passed &= check(DecodeOpView(payload, &view), test_name, "DecodeOpView 应当成功");
+    passed &= check(view.type == OpType::kPut && view.ClientIsNumeric && view.ClientNum == 123456789,
+                    test_name, "opcode / 数字 ClientId 解码错误");
+    passed &= check(view.RequestId == -1, test_name, "负 RequestId 解码错误");
+    passed &= check(view.Value.data() >= payload.data() && view.Value.data() < payload.data() + payload.size(),
+                    test_name, "视图应指向原始缓冲区 (零拷贝)");
+
+    Op op_out;
+    passed &= check(op_out.parseFromString(payload), test_name, "parseFromString 应当成功");
+    passed &= check(op_out.Value == op_in.Value && op_out.ClientId == "123456789", test_name, "往返字段不匹配");
+
+    // 非纯数字 / 前导零的 ClientId 按字符串保留，保证往返完全一致
+    op_in.ClientId = "007";
+    op_in.Operation = "CAS";
+    passed &= check(op_out.parseFromString(op_in.asString()), test_name, "字符串 ClientId 解析失败");
+    passed &= check(op_out.ClientId == "007" && op_out.Operation == "CAS", test_name, "字符串 ClientId / 未知操作名不匹配");
+
+    // 截断的数据必须被拒绝
+    passed &= check(!op_out.parseFromString(payload.substr(0, payload.size() - 1)), test_name, "截断数据应解析失败");
+    return passed;
+}
+
+/**
+ * @brief 测试用例 6: 批量编码
+ * @details 多个子操作往返、整批共享 ClientId / RequestId、与单条格式互不混淆、损坏数据被拒绝。
+ */
+bool test_batch_codec() {
+    const std::string test_name = "test_batch_codec";
+    std::cout << "Running: " << test_name << "..." << std::endl;
+
+    bool passed = true;
+
+    OpBatch batch_in;
+    batch_in.ClientId = "42";
+    batch_in.RequestId = 17;
+    batch_in.add("Put", "k1", "v1");
+    batch_in.add("Delete", "k2");
+    batch_in.add("Append", "k3", std::string("a\0b", 3));
+    batch_in.add("CAS", "k4", "v4");
+
+    std::string payload = batch_in.asString();
+    passed &= check(IsBinaryOpBatch(payload) && !IsBinaryOp(payload), test_name, "批量格式应与单条格式可区分");
+
+    OpBatchView view;
+    passed &= check(DecodeOpBatchView(payload, &view), test_name, "DecodeOpBatchView 应当成功");
+    passed &= check(view.ClientIsNumeric && view.ClientNum == 42 && view.RequestId == 17, test_name, "幂等字段解码错误");
+    passed &= check(view.Ops.size() == 4, test_name, "子操作个数错误");
+    if (view.Ops.size() == 4) {
+        passed &= check(view.Ops[0].type == OpType::kPut && view.Ops[1].type == OpType::kDelete &&
+                            view.Ops[2].Value.size() == 3 && view.Ops[3].Operation == "CAS",
+                        test_name, "子操作内容错误");
+        passed &= check(view.Ops[3].ClientNum == 42 && view.Ops[3].RequestId == 17, test_name,
+                        "子操作应继承整批的 ClientId / RequestId");
+    }
+
+    OpBatch batch_out;
+    passed &= check(batch_out.parseFromString(payload), test_name, "parseFromString 应当成功");
+    passed &= check(batch_out.ClientId == "42" && batch_out.RequestId == 17 && batch_out.Ops.size() == 4 &&
+                        batch_out.Ops[1].Operation == "Delete" && batch_out.Ops[2].Value == std::string("a\0b", 3),
+                    test_name, "往返字段不匹配");
+
+    // 空批 + 字符串 ClientId
+    OpBatch empty;
+    empty.ClientId = "client-x";
+    passed &= check(batch_out.parseFromString(empty.asString()) && batch_out.Ops.empty() &&
+                        batch_out.ClientId == "client-x",
+                    test_name, "空批往返失败");
+
+    // 单条格式不能当作批量解析，反之亦然
+    Op op;
+    op.Operation = "Put";
+    op.Key = "k";
+    op.ClientId = "1";
+    passed &= check(!batch_out.parseFromString(op.asString()), test_name, "单条 Op 不应被解析为批量");
+    passed &= check(!op.parseFromString(payload), test_name, "批量不应被解析为单条 Op");
+
+    // 截断 / 夸大 count 的数据必须被拒绝
+    passed &= check(!batch_out.parseFromString(payload.substr(0, payload.size() - 1)), test_name, "截断数据应解析失败");
+    std::string forged = payload;
+    forged[4] = static_cast<char>(0x7f);  // count 字段 (magic|flags|client 42|req 34|count)
+    passed &= check(!batch_out.parseFromString(forged), test_name, "count 损坏应解析失败");
+    return passed;
+}
+
+/**
+ * @brief 测试用例 7: 合并提交 (多个客户端的命令打包进一条日志)
+ * @details 子命令原样往返、各自保留 ClientId / RequestId、与单条 / 批量格式可区分、损坏数据被拒绝。
+ */
+bool test_group_codec() {
+    const std::string test_name = "test_group_codec";
+    std::cout << "Running: " << test_name << "..." << std::endl;
+
+    bool passed = true;
+    std::vector<std::string> commands;
+    Op a;
+    a.Operation = "Put";
+    a.Key = "k1";
+    a.Value = "v1";
+    a.ClientId = "7";
+    a.RequestId = 1;
+    commands.push_back(a.asString());
+    OpBatch b;
+    b.ClientId = "client-b";
+    b.RequestId = 9;
+    b.add("Put", "k2", "v2");
+    b.add("Delete", "k3");
+    commands.push_back(b.asString());
+    Op c = a;
+    c.ClientId = "8";
+    c.RequestId = -2;
+    commands.push_back(c.asString());
+
+    std::string payload;
+    EncodeOpGroup(payload, commands);
+    passed &= check(IsOpGroup(payload) && !IsBinaryOp(payload) && !IsBinaryOpBatch(payload), test_name,
+                    "合并格式应与单条 / 批量格式可区分");
+
+    std::vector<std::string_view> views;
+    passed &= check(DecodeOpGroup(payload, &views) && views.size() == 3, test_name, "DecodeOpGroup 应当成功");
+    if (views.size() == 3) {
+        passed &= check(views[0] == commands[0] && views[1] == commands[1] && views[2] == commands[2], test_name,
+                        "子命令应原样往返");
+        OpView op;
+        passed &= check(DecodeOpView(views[2], &op) && op.ClientNum == 8 && op.RequestId == -2, test_name,
+                        "子命令保留各自的 ClientId / RequestId");
+        OpBatchView batch;
+        passed &= check(DecodeOpBatchView(views[1], &batch) && batch.Ops.size() == 2, test_name, "子命令可以是批量");
+    }
+
+    passed &= check(!DecodeOpGroup(payload.substr(0, payload.size() - 1), &views), test_name, "截断数据应解析失败");
+    std::string forged = payload;
+    forged[1] = static_cast<char>(0x7f);  // count
+    passed &= check(!DecodeOpGroup(forged, &views), test_name, "count 损坏应解析失败");
+    passed &= check(!DecodeOpGroup(commands[0], &views), test_name, "单条 Op 不应被解析为合并提交");
+    return passed;
+}
 
 int main() {
     int passed = 0;
-    const int total = 3;
+    const int total = 7;
 
 
     if (test_op_roundtrip_full()) passed++;
     if (test_op_roundtrip_empty_value()) passed++;
     if (test_parse_failure()) passed++;
+    if (test_parse_legacy_boost()) passed++;
+    if (test_binary_codec()) passed++;
+    if (test_batch_codec()) passed++;
+    if (test_group_codec()) passed++;
 
     std::cout << "----------------------------------" << std::endl;
     std::cout << "Test Summary: " << passed << " / " << total << " tests passed." << std::endl;
@@ -0,0 +1,227 @@
+// test_trace.cpp
+// 请求追踪：采样开关与采样率、上下文传递与父子关系、环形缓冲区覆盖、
+// 并发写入与导出 (seqlock 一致性)、线程退出后缓冲区复用、Chrome trace / OTLP 导出格式
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "trace.h"
+
+static std::vector<SpanRecord> SpansOf(uint64_t trace_id) {
+    std::vector<SpanRecord> out;
+    for (const SpanRecord &s : Tracer::GetInstance().Collect()) {
+        if (s.trace_id == trace_id) out.push_back(s);
+    }
+    return out;
+}
+
+static void TestSampling() {
+    std::cout << "[Test] sampling on / off... ";
+    Tracer &tracer = Tracer::GetInstance();
+    tracer.Clear();
+    tracer.SetSampleRate(0);
+    assert(tracer.SampleRate() == 0);
+    for (int i = 0; i < 1000; ++i) assert(!tracer.Sample().Sampled());
+    {
+        // 未采样的父上下文：span 是空操作
+        TraceSpan span("noop", tracer.CurrentOrSample());
+        assert(!span.Sampled() && !span.Context().Sampled());
+    }
+    assert(tracer.Collect().empty());
+
+    tracer.SetSampleRate(1);
+    assert(tracer.SampleRate() == 1.0);
+    for (int i = 0; i < 1000; ++i) assert(tracer.Sample().Sampled());
+
+    tracer.SetSampleRate(0.1);
+    int sampled = 0;
+    for (int i = 0; i < 100000; ++i) sampled += tracer.Sample().Sampled() ? 1 : 0;
+    assert(sampled > 8000 && sampled < 12000);
+    tracer.SetSampleRate(0);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestContextPropagation() {
+    std::cout << "[Test] context propagation and parent links... ";
+    Tracer &tracer = Tracer::GetInstance();
+    tracer.Clear();
+    tracer.SetSampleRate(1);
+
+    TraceContext root = tracer.CurrentOrSample();
+    assert(root.Sampled() && root.span_id == 0);
+    uint64_t outer_id = 0;
+    uint64_t inner_id = 0;
+    {
+        TraceSpan outer("outer", root);
+        outer.SetArg("index", 42);
+        outer_id = outer.Context().span_id;
+        ScopedTraceContext scope(outer.Context());
+        // 请求入口在已有 trace 中：沿用当前上下文而不是重新采样
+        TraceContext current = tracer.CurrentOrSample();
+        assert(current.trace_id == root.trace_id && current.span_id == outer_id);
+        {
+            TraceSpan inner("inner", Tracer::Current());
+            inner_id = inner.Context().span_id;
+        }
+    }
+    assert(!Tracer::Current().Sampled());  // 离开作用域后恢复
+    tracer.SetSampleRate(0);
+
+    std::vector<SpanRecord> spans = SpansOf(root.trace_id);
+    assert(spans.size() == 2);
+    const SpanRecord &outer = spans[0];  // 按开始时间排序
+    const SpanRecord &inner = spans[1];
+    assert(std::strcmp(outer.name, "outer") == 0 && outer.parent_id == 0 && outer.span_id == outer_id);
+    assert(std::strcmp(inner.name, "inner") == 0 && inner.parent_id == outer_id && inner.span_id == inner_id);
+    assert(outer.start_ns <= inner.start_ns && inner.end_ns <= outer.end_ns);
+    assert(std::strcmp(outer.arg_key, "index") == 0 && outer.arg_value == 42);
+    assert(inner.arg_key == nullptr);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestRingOverwrite() {
+    std::cout << "[Test] ring buffer keeps the newest spans... ";
+    Tracer &tracer = Tracer::GetInstance();
+    tracer.Clear();
+    const uint64_t kTrace = 0x7777;
+    const size_t kWritten = Tracer::kRingCapacity * 2 + 17;
+    std::thread writer([&] {
+        for (size_t i = 0; i < kWritten; ++i) {
+            SpanRecord span;
+            span.trace_id = kTrace;
+            span.span_id = i + 1;
+            span.name = "overwrite";
+            span.start_ns = i;
+            span.end_ns = i + 1;
+            tracer.Record(span);
+        }
+    });
+    writer.join();
+    std::vector<SpanRecord> spans = SpansOf(kTrace);
+    assert(spans.size() == Tracer::kRingCapacity);
+    for (size_t i = 0; i < spans.size(); ++i) {
+        assert(spans[i].span_id == kWritten - Tracer::kRingCapacity + i + 1);
+    }
+    tracer.Clear();
+    assert(SpansOf(kTrace).empty());
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestConcurrentRecordAndDump() {
+    std::cout << "[Test] concurrent writers with a concurrent reader... ";
+    Tracer &tracer = Tracer::GetInstance();
+    tracer.Clear();
+    const int kThreads = 4;
+    const uint64_t kPerThread = 50000;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> checked{0};
+
+    // 读者：导出的每个 span 的字段必须来自同一次写入
+    std::thread reader([&] {
+        while (!done.load()) {
+            for (const SpanRecord &s : tracer.Collect()) {
+                assert(s.span_id == (s.trace_id ^ 0xABCDEF));
+                assert(s.end_ns == s.start_ns + s.trace_id % 1000);
+                assert(s.arg_value == s.trace_id * 3);
+                checked.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    });
+    std::vector<std::thread> writers;
+    for (int t = 0; t < kThreads; ++t) {
+        writers.emplace_back([&, t] {
+            for (uint64_t i = 1; i <= kPerThread; ++i) {
+                SpanRecord span;
+                span.trace_id = (static_cast<uint64_t>(t) << 32) | i;
+                span.span_id = span.trace_id ^ 0xABCDEF;
+                span.name = "concurrent";
+                span.start_ns = i * 10;
+                span.end_ns = span.start_ns + span.trace_id % 1000;
+                span.arg_key = "x";
+                span.arg_value = span.trace_id * 3;
+                tracer.Record(span);
+            }
+        });
+    }
+    for (auto &th : writers) th.join();
+    done.store(true);
+    reader.join();
+    assert(tracer.Collect().size() <= static_cast<size_t>(kThreads) * Tracer::kRingCapacity);
+    (void)checked;
+    tracer.Clear();
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestRingReuse() {
+    std::cout << "[Test] exited thread's ring is reused... ";
+    Tracer &tracer = Tracer::GetInstance();
+    tracer.Clear();
+    tracer.SetSampleRate(1);
+    TraceContext first;
+    TraceContext second;
+    std::thread([&] {
+        first = tracer.Sample();
+        TraceSpan span("first", first);
+    }).join();
+    std::thread([&] {
+        second = tracer.Sample();
+        TraceSpan span("second", second);
+    }).join();
+    tracer.SetSampleRate(0);
+    std::vector<SpanRecord> a = SpansOf(first.trace_id);
+    std::vector<SpanRecord> b = SpansOf(second.trace_id);
+    assert(a.size() == 1 && b.size() == 1);
+    assert(a[0].tid == b[0].tid);
+    tracer.Clear();
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestDumpFormats() {
+    std::cout << "[Test] Chrome trace / OTLP export... ";
+    Tracer &tracer = Tracer::GetInstance();
+    tracer.Clear();
+    SpanRecord span;
+    span.trace_id = 0x1234;
+    span.span_id = 0x5678;
+    span.parent_id = 0x9abc;
+    span.name = "rpc.server.handler";
+    span.start_ns = TraceNowNanos();
+    span.end_ns = span.start_ns + 2500;
+    span.arg_key = "index";
+    span.arg_value = 7;
+    tracer.Record(span);
+
+    std::string chrome = tracer.DumpChromeTrace();
+    assert(chrome.compare(0, 15, "{\"traceEvents\":") == 0);
+    assert(chrome.find("\"name\":\"rpc.server.handler\"") != std::string::npos);
+    assert(chrome.find("\"ph\":\"X\"") != std::string::npos);
+    assert(chrome.find("\"dur\":2.500") != std::string::npos);
+    assert(chrome.find("\"trace_id\":\"0000000000001234\"") != std::string::npos);
+    assert(chrome.find("\"parent_id\":\"0000000000009abc\"") != std::string::npos);
+    assert(chrome.find("\"index\":7") != std::string::npos);
+
+    std::string otlp = tracer.DumpOtlpJson("kv-test");
+    assert(otlp.find("{\"stringValue\":\"kv-test\"}") != std::string::npos);
+    assert(otlp.find("\"traceId\":\"00000000000000000000000000001234\"") != std::string::npos);
+    assert(otlp.find("\"spanId\":\"0000000000005678\"") != std::string::npos);
+    assert(otlp.find("\"parentSpanId\":\"0000000000009abc\"") != std::string::npos);
+    assert(otlp.find("{\"key\":\"index\",\"value\":{\"intValue\":\"7\"}}") != std::string::npos);
+    tracer.Clear();
+    assert(tracer.DumpChromeTrace() == "{\"traceEvents\":[],\"displayTimeUnit\":\"ms\"}");
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    TestSampling();
+    TestContextPropagation();
+    TestRingOverwrite();
+    TestConcurrentRecordAndDump();
+    TestRingReuse();
+    TestDumpFormats();
+    std::cout << "All trace tests passed!" << std::endl;
+    return 0;
+}
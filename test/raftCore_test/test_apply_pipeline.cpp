@@ -0,0 +1,343 @@
+// test_apply_pipeline.cpp
+// ApplyPipeline：commit 立即唤醒 (不按 ApplyInterval 轮询)、积压时成批 apply、等待者批量完成、
+// apply 与下一次 OnCommit 重叠、领导人变更 / 快照覆盖 / 停止时的等待者
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "apply_pipeline.h"
+
+using raft::ApplyConfig;
+using raft::ApplyEntry;
+using raft::ApplyPipeline;
+using raft::ApplyResult;
+using Status = raft::ApplyPipeline::Status;
+
+// 内存日志：first_ 之前的已被快照压缩
+class FakeLog : public raft::ApplySource {
+public:
+    void Append(uint64_t term, const std::string& command) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        entries_.push_back(ApplyEntry{first_ + entries_.size(), term, command});
+    }
+    void Compact(uint64_t first) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        entries_.erase(entries_.begin(), entries_.begin() + static_cast<long>(first - first_));
+        first_ = first;
+    }
+    size_t CopyCommitted(uint64_t from, uint64_t to, size_t max_entries, size_t max_bytes,
+                         std::vector<ApplyEntry>* out) override {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (from < first_) {
+            return 0;
+        }
+        size_t n = 0;
+        size_t bytes = 0;
+        for (uint64_t i = from; i <= to && n < max_entries && i - first_ < entries_.size(); ++i) {
+            if (n > 0 && bytes >= max_bytes) {
+                break;
+            }
+            const ApplyEntry& e = entries_[i - first_];
+            if (out->size() <= n) {
+                out->emplace_back();
+            }
+            (*out)[n].index = e.index;
+            (*out)[n].term = e.term;
+            (*out)[n].command.assign(e.command);
+            bytes += e.command.size();
+            ++n;
+        }
+        out->resize(n);
+        return n;
+    }
+
+private:
+    std::mutex mtx_;
+    uint64_t first_ = 1;
+    std::vector<ApplyEntry> entries_;
+};
+
+// "key=value" 写入 map，结果为写入前的旧值；可以在 ApplyBatch 里挡住 apply 线程
+class FakeMachine : public raft::ApplyStateMachine {
+public:
+    void ApplyBatch(const std::vector<ApplyEntry>& entries, std::vector<ApplyResult>* results) override {
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            ++in_apply_;
+            cv_.notify_all();
+            cv_.wait(lock, [this] { return !blocked_; });
+            --in_apply_;
+            batch_sizes_.push_back(entries.size());
+        }
+        for (size_t i = 0; i < entries.size(); ++i) {
+            assert(entries[i].index == last_applied_ + 1);  // 按顺序、不重不漏
+            last_applied_ = entries[i].index;
+            const std::string& cmd = entries[i].command;
+            size_t eq = cmd.find('=');
+            std::string& slot = data_[cmd.substr(0, eq)];
+            (*results)[i].value = slot;
+            slot = cmd.substr(eq + 1);
+        }
+    }
+    void Block() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        blocked_ = true;
+    }
+    void Unblock() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        blocked_ = false;
+        cv_.notify_all();
+    }
+    void WaitInApply() {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait(lock, [this] { return in_apply_ > 0; });
+    }
+    std::vector<size_t> BatchSizes() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return batch_sizes_;
+    }
+
+    uint64_t last_applied_ = 0;  // 只由 apply 线程 (或无 apply 时的 install) 访问
+    std::map<std::string, std::string> data_;
+
+private:
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    bool blocked_ = false;
+    int in_apply_ = 0;
+    std::vector<size_t> batch_sizes_;
+};
+
+// 等待若干个回调
+class Latch {
+public:
+    explicit Latch(int n) : n_(n) {}
+    void CountDown() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (--n_ == 0) {
+            cv_.notify_all();
+        }
+    }
+    void Wait() {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait(lock, [this] { return n_ <= 0; });
+    }
+
+private:
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    int n_;
+};
+
+static void TestWakeOnCommit() {
+    std::cout << "[Test] commit wakes the applier immediately... ";
+    FakeLog log;
+    FakeMachine machine;
+    ApplyPipeline pipeline(&log, &machine);
+    pipeline.Start(0);
+    const int kRounds = 200;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 1; i <= kRounds; ++i) {
+        log.Append(1, "k=" + std::to_string(i));
+        Latch latch(1);
+        Status status = Status::kShutdown;
+        std::string previous;
+        pipeline.Wait(i, 1, [&](Status s, const ApplyResult& r) {
+            status = s;
+            previous = r.value;
+            latch.CountDown();
+        });
+        pipeline.OnCommit(i);
+        latch.Wait();
+        assert(status == Status::kApplied);
+        assert(previous == (i == 1 ? "" : std::to_string(i - 1)));
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin);
+    // 逐条提交、逐条等待：轮询的 apply 循环平均每条要等半个 ApplyInterval
+    assert(elapsed.count() < kRounds * ApplyInterval / 4);
+    assert(pipeline.AppliedIndex() == kRounds);
+    pipeline.Stop();
+    std::cout << "PASSED (" << elapsed.count() << "ms for " << kRounds << " round trips)" << std::endl;
+}
+
+static void TestBatchingAndOverlap() {
+    std::cout << "[Test] backlog is applied in batches, waiters complete in bulk... ";
+    FakeLog log;
+    FakeMachine machine;
+    ApplyConfig config;
+    config.max_batch_entries = 64;
+    ApplyPipeline pipeline(&log, &machine, config);
+    std::atomic<uint64_t> applied_hook{0};
+    pipeline.SetAppliedCallback([&](uint64_t index) { applied_hook.store(index); });
+    pipeline.Start(0);
+
+    // 第一条的 apply 被挡住：apply 线程卡在状态机里
+    machine.Block();
+    log.Append(1, "a=0");
+    pipeline.OnCommit(1);
+    machine.WaitInApply();
+
+    // 与此同时 "接收线程" 继续追加、提交、登记等待者：都不被正在进行的 apply 挡住
+    const int kEntries = 1000;
+    std::vector<Status> statuses(kEntries + 1, Status::kShutdown);
+    std::vector<std::string> values(kEntries + 1);
+    std::atomic<int> order_violations{0};
+    std::atomic<uint64_t> last_completed{0};
+    Latch latch(kEntries);
+    for (int i = 2; i <= kEntries + 1; ++i) {
+        log.Append(1, "a=" + std::to_string(i - 1));
+        pipeline.Wait(i, 1, [&, i](Status s, const ApplyResult& r) {
+            statuses[i - 1] = s;
+            values[i - 1] = r.value;
+            if (last_completed.exchange(i) > static_cast<uint64_t>(i)) {
+                ++order_violations;
+            }
+            latch.CountDown();
+        });
+        pipeline.OnCommit(i);
+    }
+    assert(pipeline.AppliedIndex() == 0);
+    machine.Unblock();
+    latch.Wait();
+
+    for (int i = 1; i <= kEntries; ++i) {
+        assert(statuses[i] == Status::kApplied);
+        assert(values[i] == std::to_string(i - 1));
+    }
+    assert(order_violations.load() == 0);
+    std::vector<size_t> sizes = machine.BatchSizes();
+    assert(sizes.front() == 1);
+    assert(sizes.size() <= 1 + (kEntries + 63) / 64);  // 积压的 1000 条最多 16 批
+    raft::ApplyStats stats = pipeline.Stats();
+    assert(stats.entries == kEntries + 1 && stats.max_batch == 64);
+    assert(stats.completed == kEntries && stats.lost == 0);
+    assert(applied_hook.load() == kEntries + 1);
+    assert(machine.data_["a"] == std::to_string(kEntries));
+    pipeline.Stop();
+    std::cout << "PASSED (" << sizes.size() << " batches)" << std::endl;
+}
+
+static void TestLostAndShutdown() {
+    std::cout << "[Test] overwritten entries and shutdown... ";
+    FakeLog log;
+    FakeMachine machine;
+    ApplyPipeline pipeline(&log, &machine);
+    pipeline.Start(0);
+    for (int i = 1; i <= 5; ++i) log.Append(i < 3 ? 1 : 2, "x=" + std::to_string(i));
+    Latch latch(2);
+    Status at2 = Status::kShutdown;
+    Status at3 = Status::kShutdown;
+    pipeline.Wait(2, 1, [&](Status s, const ApplyResult&) { at2 = s; latch.CountDown(); });
+    // 旧领导人在任期 1 提交到 3，新领导人 (任期 2) 覆盖了该位置
+    pipeline.Wait(3, 1, [&](Status s, const ApplyResult&) { at3 = s; latch.CountDown(); });
+    pipeline.OnCommit(5);
+    latch.Wait();
+    assert(at2 == Status::kApplied && at3 == Status::kLost);
+    assert(pipeline.Stats().lost == 1);
+
+    // 已经 apply 过的位置：任期无从核对
+    Status late = Status::kApplied;
+    pipeline.Wait(4, 2, [&](Status s, const ApplyResult&) { late = s; });
+    assert(late == Status::kLost);
+
+    // 停止：未完成的等待者、停止后登记的等待者都回调 kShutdown
+    log.Append(2, "x=6");
+    Status pending = Status::kApplied;
+    pipeline.Wait(6, 2, [&](Status s, const ApplyResult&) { pending = s; });
+    pipeline.Stop();
+    assert(pending == Status::kShutdown);
+    Status after = Status::kApplied;
+    pipeline.Wait(7, 2, [&](Status s, const ApplyResult&) { after = s; });
+    assert(after == Status::kShutdown);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestInstallSnapshot() {
+    std::cout << "[Test] compacted log stalls until a snapshot is installed... ";
+    FakeLog log;
+    FakeMachine machine;
+    ApplyPipeline pipeline(&log, &machine);
+    std::atomic<uint64_t> applied_hook{0};
+    std::atomic<bool> snapshot_reported{false};  // apply 线程的批从 101 开始，100 只可能来自快照
+    pipeline.SetAppliedCallback([&](uint64_t index) {
+        if (index == 100) {
+            snapshot_reported = true;
+        }
+        uint64_t cur = applied_hook.load();
+        while (index > cur && !applied_hook.compare_exchange_weak(cur, index)) {
+        }
+    });
+    for (int i = 1; i <= 150; ++i) log.Append(1, "s=" + std::to_string(i));
+    log.Compact(101);  // follower 落后太多：1..100 只能从快照获得
+
+    Status covered = Status::kApplied;
+    Latch tail(1);
+    pipeline.Start(0);
+    pipeline.Wait(50, 1, [&](Status s, const ApplyResult&) { covered = s; });
+    pipeline.Wait(150, 1, [&](Status s, const ApplyResult& r) {
+        assert(s == Status::kApplied && r.value == "149");
+        tail.CountDown();
+    });
+    pipeline.OnCommit(150);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    assert(pipeline.AppliedIndex() == 0);
+    assert(pipeline.Stats().batches == 0);
+
+    int installs = 0;
+    bool ok = pipeline.InstallSnapshot(100, [&] {
+        ++installs;
+        machine.data_["s"] = "100";
+        machine.last_applied_ = 100;
+    });
+    assert(ok && installs == 1);
+    assert(snapshot_reported);  // 返回前已通知：ReadIndex 等在快照覆盖的位置上的读可以继续
+    assert(covered == Status::kLost);  // 结果在快照里，但无从得知：客户端重试，由幂等表去重
+    tail.Wait();
+    assert(pipeline.AppliedIndex() == 150);
+    assert(applied_hook.load() == 150);
+    assert(machine.data_["s"] == "150");
+    // 不比已 apply 位置新的快照被忽略
+    assert(!pipeline.InstallSnapshot(120, [&] { ++installs; }));
+    assert(installs == 1);
+    pipeline.Stop();
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestByteLimit() {
+    std::cout << "[Test] batch byte limit... ";
+    FakeLog log;
+    FakeMachine machine;
+    ApplyConfig config;
+    config.max_batch_bytes = 1024;
+    ApplyPipeline pipeline(&log, &machine, config);
+    machine.Block();
+    pipeline.Start(0);
+    for (int i = 1; i <= 40; ++i) log.Append(1, "big=" + std::string(256, 'v'));
+    pipeline.OnCommit(40);
+    machine.Unblock();
+    Latch latch(1);
+    pipeline.Wait(40, 1, [&](Status, const ApplyResult&) { latch.CountDown(); });
+    latch.Wait();
+    for (size_t n : machine.BatchSizes()) {
+        assert(n <= 4);  // 每条 260 字节，超过 1KB 即截断
+    }
+    pipeline.Stop();
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    TestWakeOnCommit();
+    TestBatchingAndOverlap();
+    TestLostAndShutdown();
+    TestInstallSnapshot();
+    TestByteLimit();
+    std::cout << "All ApplyPipeline tests passed!" << std::endl;
+    return 0;
+}
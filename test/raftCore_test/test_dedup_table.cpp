@@ -0,0 +1,162 @@
+// test_dedup_table.cpp
+// DedupTable：重复请求识别、会话过期 (与回收时机无关)、backward-shift 删除、扩缩容、快照编解码
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#include "dedup_table.h"
+
+using raft::DedupClientKey;
+using raft::DedupOptions;
+using raft::DedupTable;
+
+static void TestCheck() {
+    std::cout << "[Test] duplicate detection per client... ";
+    DedupTable table;
+    assert(table.Check(7, 1, 1) == DedupTable::Result::kNew);
+    assert(table.Check(7, 1, 2) == DedupTable::Result::kDuplicate);  // 重试
+    assert(table.Check(7, 2, 3) == DedupTable::Result::kNew);
+    assert(table.Check(7, 1, 4) == DedupTable::Result::kDuplicate);  // 迟到的旧请求
+    assert(table.Check(8, 1, 5) == DedupTable::Result::kNew);        // 其他客户端互不影响
+    assert(table.Check(0, 5, 6) == DedupTable::Result::kNew);        // 0 号客户端不与空槽混淆
+    assert(table.Check(0, 5, 7) == DedupTable::Result::kDuplicate);
+    int64_t last = 0;
+    assert(table.LastRequest(7, 8, &last) && last == 2);
+    assert(table.LastRequest(0, 8, &last) && last == 5);
+    assert(!table.LastRequest(9, 8, &last));
+    assert(table.Size() == 3);
+
+    // 纯数字的 ClientId 直接用数值，字符串 ClientId 按固定哈希
+    assert(DedupClientKey("12345") == 12345);
+    assert(DedupClientKey("client-a") == DedupClientKey(std::string("client-a")));
+    assert(DedupClientKey("client-a") != DedupClientKey("client-b"));
+    assert(DedupClientKey("012") != 12);  // 有前导零的不是数字 id
+    OpView op;
+    op.ClientIsNumeric = true;
+    op.ClientNum = 42;
+    assert(DedupClientKey(op) == 42);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestExpiryIsDeterministic() {
+    std::cout << "[Test] expiry does not depend on when sessions are swept... ";
+    DedupOptions options;
+    options.session_ttl = 100;
+    options.initial_capacity = 16;
+    DedupTable lazy(options);    // 从不主动 Sweep，只在扩容时回收
+    DedupTable eager(options);   // 每条请求都顺带 Sweep
+    std::mt19937_64 rng(3);
+    std::unordered_map<uint64_t, std::pair<int64_t, uint64_t>> model;  // client -> (request, last_tick)
+    for (uint64_t tick = 1; tick <= 200000; ++tick) {
+        uint64_t client = rng() % 5000;
+        int64_t request = static_cast<int64_t>(rng() % 8);
+        DedupTable::Result expected = DedupTable::Result::kNew;
+        auto it = model.find(client);
+        if (it != model.end() && tick - it->second.second <= options.session_ttl &&
+            request <= it->second.first) {
+            expected = DedupTable::Result::kDuplicate;
+            it->second.second = tick;
+        } else {
+            model[client] = {request, tick};
+        }
+        assert(lazy.Check(client, request, tick) == expected);
+        assert(eager.Check(client, request, tick) == expected);
+        eager.Sweep(tick, 4);
+    }
+    // 闲置超过 ttl 的会话被回收，内存随活跃客户端数而不是历史客户端数增长
+    eager.Sweep(300000, eager.Capacity() * 2);
+    assert(eager.Size() == 0);
+    int64_t last = 0;
+    assert(!lazy.LastRequest(1, 300000, &last));
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestGrowShrinkAndErase() {
+    std::cout << "[Test] growth, backward-shift erase and shrink... ";
+    DedupOptions options;
+    options.session_ttl = 10;
+    options.initial_capacity = 16;
+    DedupTable table(options);
+    const uint64_t kClients = 200000;
+    for (uint64_t c = 0; c < kClients; ++c) {
+        assert(table.Check(c, 1, 1) == DedupTable::Result::kNew);
+    }
+    assert(table.Size() == kClients);
+    assert(table.Capacity() >= kClients * 4 / 3 && table.Capacity() <= kClients * 4);
+    assert(table.MemoryBytes() == table.Capacity() * 24);
+
+    // 一半客户端保持活跃，另一半过期后被逐步回收；回收过程中活跃的会话一直查得到
+    for (uint64_t c = 0; c < kClients; c += 2) {
+        assert(table.Check(c, 2, 50) == DedupTable::Result::kNew);
+    }
+    size_t freed = 0;
+    while (freed < kClients / 2) {
+        freed += table.Sweep(55, 997);
+        for (uint64_t c = 0; c < kClients; c += 4000) {
+            int64_t last = 0;
+            assert(table.LastRequest(c, 55, &last) && last == 2);
+        }
+    }
+    assert(table.Size() == kClients / 2);
+    for (uint64_t c = 0; c < kClients; ++c) {
+        int64_t last = 0;
+        assert(table.LastRequest(c, 55, &last) == (c % 2 == 0));
+    }
+
+    // 所有会话过期：回收之后缩回最小容量
+    size_t before = table.Capacity();
+    table.Sweep(1000, before * 2);
+    assert(table.Size() == 0 && table.Capacity() < before);
+    table.Clear();
+    assert(table.Capacity() == 16);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestSnapshot() {
+    std::cout << "[Test] compact, deterministic snapshot encoding... ";
+    DedupOptions options;
+    options.session_ttl = 1000;
+    DedupTable a(options);
+    DedupTable b(options);
+    // 同样的会话、不同的插入顺序 (不同的槽位布局)：编码字节相同
+    for (uint64_t c = 1; c <= 10000; ++c) a.Check(c, static_cast<int64_t>(c % 7), 500 + c % 100);
+    for (uint64_t c = 10000; c >= 1; --c) b.Check(c, static_cast<int64_t>(c % 7), 500 + c % 100);
+    a.Check(DedupClientKey("alice"), -3, 600);  // RequestId 可能为负
+    b.Check(DedupClientKey("alice"), -3, 600);
+    a.Check(77777, 1, 1);  // 编码时已过期，不写进快照
+    std::string encoded = a.Encode(1200);
+    assert(encoded == b.Encode(1200));
+    assert(encoded.size() < 10001 * 5);  // 连续的数字 id：每个会话约 3 字节
+
+    DedupTable restored(options);
+    std::string error;
+    assert(restored.Decode(encoded, &error));
+    assert(restored.Size() == 10001);
+    assert(restored.Encode(1200) == encoded);
+    int64_t last = 0;
+    assert(restored.LastRequest(1234, 1200, &last) && last == 1234 % 7);
+    assert(restored.LastRequest(DedupClientKey("alice"), 1200, &last) && last == -3);
+    assert(!restored.LastRequest(77777, 1200, &last));
+    assert(restored.Check(1234, 1234 % 7, 1201) == DedupTable::Result::kDuplicate);
+    // 恢复的会话保留闲置时长：到期时间与原表一致
+    assert(!restored.LastRequest(1, 500 + 1 + 1001, &last));
+
+    // 损坏的快照被拒绝，表保持原样
+    std::string bad = encoded;
+    bad[bad.size() / 2] ^= 0x40;
+    assert(!restored.Decode(bad, &error) && !error.empty());
+    assert(!restored.Decode(encoded.substr(0, encoded.size() - 1), &error));
+    assert(restored.Size() == 10001);
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    TestCheck();
+    TestExpiryIsDeterministic();
+    TestGrowShrinkAndErase();
+    TestSnapshot();
+    std::cout << "All DedupTable tests passed!" << std::endl;
+    return 0;
+}
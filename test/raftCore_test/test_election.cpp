@@ -0,0 +1,252 @@
+// test_election.cpp
+// PreVote 不抬高任期、CheckQuorum 的退位与 leader stickiness、领导权转移的 TimeoutNow 时机与超时放弃
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <unordered_map>
+
+#include "election.h"
+
+using raft::ElectionConfig;
+using raft::ElectionControl;
+using raft::LogPosition;
+using raft::VoteDecision;
+using raft::VoteRequest;
+using Clock = ElectionControl::Clock;
+using std::chrono::milliseconds;
+
+static ElectionConfig Config() {
+    ElectionConfig c;
+    c.election_timeout_min_ms = 300;
+    c.transfer_timeout_ms = 500;
+    return c;
+}
+
+static LogPosition Log(uint64_t index, uint64_t term) {
+    LogPosition p;
+    p.last_index = index;
+    p.last_term = term;
+    return p;
+}
+
+static VoteRequest Vote(uint64_t term, int32_t candidate, LogPosition log, bool pre_vote, bool transfer = false) {
+    VoteRequest r;
+    r.term = term;
+    r.candidate_id = candidate;
+    r.log = log;
+    r.pre_vote = pre_vote;
+    r.transfer = transfer;
+    return r;
+}
+
+static void TestLogUpToDate() {
+    std::cout << "[Test] log up-to-date... ";
+    assert(raft::LogUpToDate(Log(5, 3), Log(5, 3)));
+    assert(raft::LogUpToDate(Log(1, 4), Log(9, 3)));   // 任期大的更新
+    assert(!raft::LogUpToDate(Log(4, 3), Log(5, 3)));
+    assert(!raft::LogUpToDate(Log(9, 2), Log(1, 3)));
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestPreVote() {
+    std::cout << "[Test] pre-vote... ";
+    Clock::time_point t0 = Clock::now();
+    ElectionControl voter(2, {1, 3}, Config());
+
+    // 没有领导人：日志够新且任期更大时同意，但绝不更新任期
+    VoteDecision d = voter.HandleVote(Vote(6, 3, Log(10, 5), true), 5, -1, Log(10, 5), t0);
+    assert(d.grant && !d.update_term);
+    // 已经投给别人也不影响预投票
+    d = voter.HandleVote(Vote(6, 3, Log(10, 5), true), 5, 1, Log(10, 5), t0);
+    assert(d.grant);
+    // 日志落后 / 任期不大于本地：拒绝
+    assert(!voter.HandleVote(Vote(6, 3, Log(9, 5), true), 5, -1, Log(10, 5), t0).grant);
+    assert(!voter.HandleVote(Vote(5, 3, Log(10, 5), true), 5, -1, Log(10, 5), t0).grant);
+
+    // 领导人存活：被分区后回来的节点预投票失败，任期保持不变
+    voter.OnLeaderContact(1, t0);
+    d = voter.HandleVote(Vote(6, 3, Log(10, 5), true), 5, -1, Log(10, 5), t0 + milliseconds(100));
+    assert(!d.grant && !d.update_term);
+    // 一个最小选举超时没有领导人的消息后才同意
+    assert(!voter.LeaderAlive(t0 + milliseconds(300)));
+    assert(voter.HandleVote(Vote(6, 3, Log(10, 5), true), 5, -1, Log(10, 5), t0 + milliseconds(300)).grant);
+
+    assert(voter.UsePreVote(false));
+    assert(!voter.UsePreVote(true));  // TimeoutNow 触发的选举直接正式投票
+    ElectionConfig off = Config();
+    off.pre_vote = false;
+    assert(!ElectionControl(2, {1, 3}, off).UsePreVote(false));
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestVote() {
+    std::cout << "[Test] vote & stickiness... ";
+    Clock::time_point t0 = Clock::now();
+    ElectionControl voter(2, {1, 3}, Config());
+
+    VoteDecision d = voter.HandleVote(Vote(6, 3, Log(10, 5), false), 5, 1, Log(10, 5), t0);
+    assert(d.grant && d.update_term);  // 更高任期：旧的 votedFor 作废
+    d = voter.HandleVote(Vote(6, 3, Log(10, 5), false), 6, 1, Log(10, 5), t0);
+    assert(!d.grant && !d.update_term);  // 同任期已投给 1
+    assert(voter.HandleVote(Vote(6, 3, Log(10, 5), false), 6, 3, Log(10, 5), t0).grant);
+    // 日志落后：更新任期但不投票
+    d = voter.HandleVote(Vote(7, 3, Log(9, 5), false), 6, -1, Log(10, 5), t0);
+    assert(!d.grant && d.update_term);
+    assert(!voter.HandleVote(Vote(4, 3, Log(10, 5), false), 5, -1, Log(10, 5), t0).grant);
+
+    // stickiness：领导人存活时连任期都不更新；转移发起的选举例外
+    voter.OnLeaderContact(1, t0);
+    d = voter.HandleVote(Vote(8, 3, Log(10, 5), false), 6, -1, Log(10, 5), t0 + milliseconds(10));
+    assert(!d.grant && !d.update_term);
+    d = voter.HandleVote(Vote(8, 3, Log(10, 5), false, true), 6, -1, Log(10, 5), t0 + milliseconds(10));
+    assert(d.grant && d.update_term);
+
+    // 关闭 CheckQuorum 时没有 stickiness
+    ElectionConfig off = Config();
+    off.check_quorum = false;
+    ElectionControl loose(2, {1, 3}, off);
+    loose.OnLeaderContact(1, t0);
+    assert(loose.HandleVote(Vote(8, 3, Log(10, 5), false), 6, -1, Log(10, 5), t0).grant);
+
+    // 领导人自己同样坚持 (失去多数派时由 QuorumActive 先让它退位)
+    ElectionControl leader(1, {2, 3}, Config());
+    leader.BecomeLeader(t0);
+    assert(!leader.HandleVote(Vote(8, 3, Log(10, 5), false), 6, -1, Log(10, 5), t0 + milliseconds(1000)).grant);
+    leader.StepDown();
+    assert(leader.KnownLeader() == -1);
+    assert(leader.HandleVote(Vote(8, 3, Log(10, 5), false), 6, -1, Log(10, 5), t0 + milliseconds(1000)).grant);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestCheckQuorum() {
+    std::cout << "[Test] check quorum... ";
+    Clock::time_point t0 = Clock::now();
+    ElectionControl leader(1, {2, 3, 4, 5}, Config());
+    assert(leader.QuorumSize() == 3);
+    leader.BecomeLeader(t0);
+    // 刚当选有一个选举超时的宽限期
+    assert(leader.QuorumActive(t0 + milliseconds(299)));
+    assert(!leader.QuorumActive(t0 + milliseconds(300)));
+
+    leader.OnPeerAck(2, t0 + milliseconds(200));
+    assert(!leader.QuorumActive(t0 + milliseconds(400)));  // 自己 + 2，差一个
+    leader.OnPeerAck(5, t0 + milliseconds(250));
+    leader.OnPeerAck(9, t0 + milliseconds(250));            // 非成员的回复被忽略
+    assert(leader.QuorumActive(t0 + milliseconds(400)));
+    assert(!leader.QuorumActive(t0 + milliseconds(500)));
+
+    ElectionConfig off = Config();
+    off.check_quorum = false;
+    ElectionControl loose(1, {2, 3}, off);
+    loose.BecomeLeader(t0);
+    assert(loose.QuorumActive(t0 + milliseconds(10000)));
+
+    // 单节点组：自己就是多数派
+    ElectionControl single(1, {}, Config());
+    single.BecomeLeader(t0);
+    assert(single.QuorumSize() == 1 && single.QuorumActive(t0 + milliseconds(10000)));
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestTransfer() {
+    std::cout << "[Test] leadership transfer... ";
+    Clock::time_point t0 = Clock::now();
+    ElectionControl leader(1, {2, 3}, Config());
+    bool send = true;
+
+    assert(leader.BeginTransfer(2, 10, 10, &send, t0) == ElectionControl::TransferStatus::kNotLeader && !send);
+    leader.BecomeLeader(t0);
+    assert(leader.BeginTransfer(1, 10, 10, &send, t0) == ElectionControl::TransferStatus::kAlreadyLeader);
+    assert(leader.BeginTransfer(7, 10, 10, &send, t0) == ElectionControl::TransferStatus::kUnknownTarget);
+    assert(!leader.Transferring(t0));
+
+    // 目标落后：先补日志，追平时 (且只在第一次追平时) 发 TimeoutNow
+    assert(leader.BeginTransfer(2, 8, 10, &send, t0) == ElectionControl::TransferStatus::kStarted && !send);
+    assert(leader.Transferring(t0 + milliseconds(1)));
+    assert(leader.TransferTarget() == 2);
+    assert(leader.BeginTransfer(2, 8, 10, &send, t0) == ElectionControl::TransferStatus::kInProgress);
+    assert(!leader.OnMatchAdvanced(3, 10, 10));  // 不是目标
+    assert(!leader.OnMatchAdvanced(2, 9, 10));
+    assert(leader.OnMatchAdvanced(2, 10, 10));
+    assert(!leader.OnMatchAdvanced(2, 10, 10));
+
+    // 超时：放弃转移，恢复接受写
+    assert(leader.Transferring(t0 + milliseconds(499)));
+    assert(!leader.Transferring(t0 + milliseconds(500)));
+    assert(leader.TransferTarget() == -1);
+    assert(!leader.OnMatchAdvanced(2, 11, 11));
+
+    // 目标已追平：立即发送
+    Clock::time_point t1 = t0 + milliseconds(600);
+    assert(leader.BeginTransfer(3, 12, 12, &send, t1) == ElectionControl::TransferStatus::kStarted && send);
+    // 换目标：重新开始
+    assert(leader.BeginTransfer(2, 11, 12, &send, t1) == ElectionControl::TransferStatus::kStarted && !send);
+    assert(leader.TransferTarget() == 2);
+    assert(leader.OnMatchAdvanced(2, 12, 12));
+    // 新领导人出现：旧领导人退位，转移结束
+    leader.StepDown();
+    assert(!leader.Transferring(t1));
+
+    // 目标收到 TimeoutNow：只认本任期的已知领导人
+    ElectionControl target(2, {1, 3}, Config());
+    target.OnLeaderContact(1, t1);
+    assert(target.AcceptTimeoutNow(5, 1, 5));
+    assert(!target.AcceptTimeoutNow(4, 1, 5));
+    assert(!target.AcceptTimeoutNow(5, 3, 5));
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestPickTarget() {
+    std::cout << "[Test] pick transfer target... ";
+    Clock::time_point t0 = Clock::now();
+    ElectionControl leader(1, {2, 3, 4}, Config());
+    std::unordered_map<int32_t, uint64_t> match = {{2, 9}, {3, 10}, {4, 10}};
+    assert(leader.PickTransferTarget(match, t0) == -1);  // 还不是领导人：没有回复记录
+
+    leader.BecomeLeader(t0);
+    assert(leader.PickTransferTarget(match, t0) == 3);   // 日志最新，相同时取 id 小的
+    leader.OnPeerAck(2, t0 + milliseconds(250));
+    leader.OnPeerAck(4, t0 + milliseconds(250));
+    assert(leader.PickTransferTarget(match, t0 + milliseconds(400)) == 4);  // 3 很久没回复
+    match.erase(4);
+    assert(leader.PickTransferTarget(match, t0 + milliseconds(400)) == 2);
+    assert(leader.PickTransferTarget(match, t0 + milliseconds(1000)) == -1);
+    std::cout << "PASSED" << std::endl;
+}
+
+// 三节点：1 为领导人，3 被分区后反复超时，回来时不应打断 1 (有 PreVote 时任期不变)
+static void TestPartitionedNodeRejoins() {
+    std::cout << "[Test] partitioned node rejoins... ";
+    Clock::time_point t0 = Clock::now();
+    ElectionControl n2(2, {1, 3}, Config());
+    uint64_t n2_term = 5;
+    uint64_t n3_term = 5;
+
+    for (int round = 1; round <= 10; ++round) {
+        Clock::time_point now = t0 + milliseconds(round * 100);
+        n2.OnLeaderContact(1, now);  // 1 和 2 之间网络正常
+        // 3 收不到任何回复：预投票失败，任期保持不变
+        VoteDecision d = n2.HandleVote(Vote(n3_term + 1, 3, Log(10, 5), true), n2_term, 1, Log(12, 5), now);
+        assert(!d.grant && !d.update_term);
+    }
+    assert(n3_term == 5 && n2_term == 5);
+
+    // 领导人 1 失效：3 的日志落后，预投票失败；2 能赢得预投票
+    Clock::time_point later = t0 + milliseconds(1000 + 300);
+    assert(!n2.HandleVote(Vote(6, 3, Log(10, 5), true), n2_term, 1, Log(12, 5), later).grant);
+    ElectionControl n3(3, {1, 2}, Config());
+    assert(n3.HandleVote(Vote(6, 2, Log(12, 5), true), n3_term, -1, Log(10, 5), later).grant);
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    TestLogUpToDate();
+    TestPreVote();
+    TestVote();
+    TestCheckQuorum();
+    TestTransfer();
+    TestPickTarget();
+    TestPartitionedNodeRejoins();
+    std::cout << "All Election tests passed!" << std::endl;
+    return 0;
+}
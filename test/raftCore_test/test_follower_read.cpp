@@ -0,0 +1,152 @@
+// test_follower_read.cpp
+// FollowerRead：min_applied_index / max_staleness 约束、等待追上、回退到 ReadIndex
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "follower_read.h"
+
+using raft::FollowerRead;
+using raft::FollowerReadConfig;
+using raft::FollowerReadOptions;
+using Clock = std::chrono::steady_clock;
+
+static FollowerReadOptions Options(uint64_t min_applied, int max_staleness_ms) {
+    FollowerReadOptions o;
+    o.min_applied_index = min_applied;
+    o.max_staleness_ms = max_staleness_ms;
+    return o;
+}
+
+static void TestLocalReads() {
+    std::cout << "[Test] local reads within bounds... ";
+    std::atomic<int> fetches{0};
+    FollowerRead fr([&](int, uint64_t*) {
+        fetches.fetch_add(1);
+        return false;
+    });
+
+    // 没有任何约束：直接读本地
+    assert(fr.WaitReadable(Options(0, 0), 10) == FollowerRead::Status::kOk);
+    // 从未收到心跳：陈旧度未知
+    assert(fr.StalenessMs() == -1);
+
+    fr.OnLeaderContact(5);
+    assert(fr.StalenessMs() == -1);  // leaderCommit 5 还没 apply
+    fr.OnApplied(5);
+    assert(fr.StalenessMs() >= 0);
+
+    uint64_t applied = 0;
+    assert(fr.WaitReadable(Options(5, 100), 10, &applied) == FollowerRead::Status::kOk);
+    assert(applied == 5);
+    assert(fetches.load() == 0);
+    assert(fr.GetStats().local_reads == 2);  // 第一次无约束 + 这一次
+
+    // min_applied_index 在 catch-up 窗口内追上
+    std::thread applier([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        fr.OnApplied(8);
+    });
+    assert(fr.WaitReadable(Options(8, 0), 1000, &applied) == FollowerRead::Status::kOk);
+    assert(applied == 8);
+    applier.join();
+    assert(fetches.load() == 0);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestStalenessTracking() {
+    std::cout << "[Test] staleness follows applied leaderCommit... ";
+    FollowerRead fr([](int, uint64_t*) { return false; });
+    Clock::time_point t0 = Clock::now() - std::chrono::milliseconds(300);
+    Clock::time_point t1 = Clock::now() - std::chrono::milliseconds(200);
+    Clock::time_point t2 = Clock::now() - std::chrono::milliseconds(100);
+    fr.OnLeaderContact(10, t0);
+    fr.OnLeaderContact(20, t1);
+    fr.OnLeaderContact(30, t2);
+
+    fr.OnApplied(15);  // 只覆盖了 t0 那次心跳
+    assert(fr.StalenessMs() >= 300);
+    assert(fr.WaitReadable(Options(0, 250), 5) == FollowerRead::Status::kTimeout);
+
+    fr.OnApplied(30);  // 覆盖到 t2
+    int64_t s = fr.StalenessMs();
+    assert(s >= 100 && s < 200);
+    assert(fr.WaitReadable(Options(0, 250), 5) == FollowerRead::Status::kOk);
+
+    // 新心跳的 leaderCommit 已经被 apply：陈旧度立刻刷新
+    fr.OnLeaderContact(30);
+    assert(fr.StalenessMs() < 50);
+
+    // 领导人失联：陈旧度未知，带上限的读不能走本地
+    fr.OnLeaderLost();
+    assert(fr.StalenessMs() == -1);
+    assert(fr.WaitReadable(Options(0, 1000), 5) == FollowerRead::Status::kTimeout);
+    assert(fr.WaitReadable(Options(0, 0), 5) == FollowerRead::Status::kOk);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestFallbackToReadIndex() {
+    std::cout << "[Test] fallback to leader ReadIndex... ";
+    FollowerReadConfig config;
+    config.catch_up_wait_ms = 5;
+    std::atomic<int> fetches{0};
+    FollowerRead* self = nullptr;
+    std::vector<std::thread> appliers;  // fetcher 在读线程中调用，只有本线程访问
+    FollowerRead fr(
+        [&](int timeout_ms, uint64_t* read_index) {
+            assert(timeout_ms > 0);
+            fetches.fetch_add(1);
+            *read_index = 42;
+            // 领导人给出 read index 后，本地 apply 随后追上
+            appliers.emplace_back([self]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                self->OnApplied(42);
+            });
+            return true;
+        },
+        config);
+    self = &fr;
+    fr.OnApplied(3);
+
+    uint64_t applied = 0;
+    assert(fr.WaitReadable(Options(0, 10), 1000, &applied) == FollowerRead::Status::kOk);
+    assert(applied == 42);
+    assert(fetches.load() == 1);
+    assert(fr.GetStats().fallback_reads == 1);
+
+    // read index 已经被本地覆盖：回退后立即返回
+    assert(fr.WaitReadable(Options(40, 10), 1000, &applied) == FollowerRead::Status::kOk);
+    assert(fetches.load() == 2);
+    for (auto& t : appliers) t.join();
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestFallbackFailure() {
+    std::cout << "[Test] fallback failure times out... ";
+    FollowerReadConfig config;
+    config.catch_up_wait_ms = 5;
+    FollowerRead fr([](int, uint64_t*) { return false; }, config);
+    auto start = Clock::now();
+    assert(fr.WaitReadable(Options(100, 0), 50) == FollowerRead::Status::kTimeout);
+    assert(Clock::now() - start < std::chrono::milliseconds(50));  // fetcher 失败后不再空等
+
+    // fetcher 成功但本地一直追不上：deadline 到期
+    FollowerRead slow([](int, uint64_t* ri) {
+        *ri = 1000;
+        return true;
+    }, config);
+    assert(slow.WaitReadable(Options(1, 0), 30) == FollowerRead::Status::kTimeout);
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    TestLocalReads();
+    TestStalenessTracking();
+    TestFallbackToReadIndex();
+    TestFallbackFailure();
+    std::cout << "All FollowerRead tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,96 @@
+// test_heartbeat_coalescer.cpp
+// HeartbeatCoalescer：按对端合并、同组去重、Flush 之间互不干扰、并发 Enqueue
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "heartbeat_coalescer.h"
+
+using raft::GroupHeartbeatInfo;
+using raft::HeartbeatCoalescer;
+
+static GroupHeartbeatInfo Hb(uint64_t group, uint64_t term, uint64_t commit) {
+    GroupHeartbeatInfo hb;
+    hb.group_id = group;
+    hb.term = term;
+    hb.leader_id = 1;
+    hb.commit = commit;
+    return hb;
+}
+
+static void TestCoalescePerPeer() {
+    std::cout << "[Test] one rpc per peer per flush... ";
+    std::map<int32_t, std::vector<GroupHeartbeatInfo>> sent;
+    int rpcs = 0;
+    HeartbeatCoalescer coalescer([&](int32_t peer, std::vector<GroupHeartbeatInfo>& batch) {
+        ++rpcs;
+        sent[peer] = batch;
+    });
+
+    // 1000 个组，每组 2 个 follower (节点 2、3)
+    for (uint64_t g = 1; g <= 1000; ++g) {
+        coalescer.Enqueue(2, Hb(g, 5, g));
+        coalescer.Enqueue(3, Hb(g, 5, g));
+    }
+    // 同一周期同组重复：只保留最后一次
+    coalescer.Enqueue(2, Hb(7, 5, 700));
+
+    assert(coalescer.Flush() == 2);
+    assert(rpcs == 2);
+    assert(sent[2].size() == 1000 && sent[3].size() == 1000);
+    for (const auto& hb : sent[2]) {
+        if (hb.group_id == 7) assert(hb.commit == 700);
+    }
+    assert(coalescer.GetStats().heartbeats == 2000);
+    assert(coalescer.GetStats().rpcs == 2);
+
+    // 空周期不发 RPC
+    assert(coalescer.Flush() == 0);
+    coalescer.Enqueue(3, Hb(1, 6, 10));
+    assert(coalescer.Flush() == 1);
+    assert(sent[3].size() == 1 && sent[3][0].term == 6);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestConcurrentEnqueue() {
+    std::cout << "[Test] concurrent enqueue and flush... ";
+    std::atomic<uint64_t> delivered{0};
+    HeartbeatCoalescer coalescer([&](int32_t, std::vector<GroupHeartbeatInfo>& batch) {
+        delivered.fetch_add(batch.size());
+    });
+
+    const int kGroups = 8;
+    const int kTicks = 2000;
+    std::vector<std::thread> groups;
+    for (int g = 0; g < kGroups; ++g) {
+        groups.emplace_back([&, g]() {
+            for (int t = 0; t < kTicks; ++t) {
+                coalescer.Enqueue(t % 3, Hb(g, 1, t));
+            }
+        });
+    }
+    std::atomic<bool> done{false};
+    std::thread ticker([&]() {
+        while (!done.load()) coalescer.Flush();
+    });
+    for (auto& t : groups) t.join();
+    done = true;
+    ticker.join();
+    coalescer.Flush();
+
+    // 去重之后的每个心跳恰好被送达一次
+    assert(delivered.load() == coalescer.GetStats().heartbeats);
+    assert(delivered.load() <= static_cast<uint64_t>(kGroups) * kTicks);
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    TestCoalescePerPeer();
+    TestConcurrentEnqueue();
+    std::cout << "All HeartbeatCoalescer tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,201 @@
+// test_membership.cpp
+// Membership：learner 不影响提交、追上才可提升、单步变更与 joint consensus、截断回退、配置编码
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+#include "membership.h"
+#include "opCodec.h"
+
+using raft::MemberChange;
+using raft::MemberChangeType;
+using raft::Membership;
+using raft::MembershipConfig;
+using ChangeStatus = raft::Membership::ChangeStatus;
+
+static MembershipConfig Config(std::vector<int32_t> voters, std::vector<int32_t> learners = {}) {
+    MembershipConfig config;
+    config.voters = std::move(voters);
+    config.learners = std::move(learners);
+    return config;
+}
+
+static void TestLearnersDoNotCountTowardQuorum() {
+    std::cout << "[Test] learners receive the log but never hold back commit... ";
+    Membership membership(Config({1, 2, 3}, {4, 5}));
+    std::unordered_map<int32_t, uint64_t> match = {{1, 100}, {2, 90}, {3, 10}, {4, 0}, {5, 0}};
+    auto lookup = [&](int32_t node) { return match[node]; };
+    assert(membership.QuorumMatch(lookup) == 90);  // learner 还在装快照，提交不受影响
+
+    std::unordered_map<int32_t, bool> acked = {{1, true}, {4, true}, {5, true}};
+    auto ack = [&](int32_t node) { return acked[node]; };
+    assert(!membership.HasQuorum(ack));  // 两个 learner 的回复不构成多数派
+    acked[2] = true;
+    assert(membership.HasQuorum(ack));
+
+    assert(membership.Current().Replicas() == std::vector<int32_t>({1, 2, 3, 4, 5}));
+    assert(membership.CanCampaign(3) && !membership.CanCampaign(4));
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestAddLearnerThenPromote() {
+    std::cout << "[Test] single-step change: add learner, promote once caught up... ";
+    Membership membership(Config({1, 2, 3}));
+    std::unordered_map<int32_t, uint64_t> match = {{1, 1000}, {2, 1000}, {3, 1000}};
+    auto lookup = [&](int32_t node) { return match[node]; };
+
+    MembershipConfig next;
+    std::string error;
+    assert(membership.Prepare({{MemberChangeType::kAddLearner, 4}}, lookup, 1000, true, &next, &error) ==
+           ChangeStatus::kOk);
+    assert(next.voters == std::vector<int32_t>({1, 2, 3}) && next.learners == std::vector<int32_t>({4}));
+    assert(!next.Joint());
+    membership.OnAppend(1001, next);  // 追加即生效：领导人开始向 4 复制
+    assert(membership.Current().IsLearner(4) && membership.ChangePending());
+    assert(membership.Prepare({{MemberChangeType::kPromote, 4}}, lookup, 1001, true, &next, &error) ==
+           ChangeStatus::kPending);
+    assert(!membership.OnCommit(1001));
+    assert(!membership.ChangePending() && membership.Committed().IsLearner(4));
+
+    // 还在追日志：不能提升
+    match[4] = 200;
+    assert(membership.Prepare({{MemberChangeType::kPromote, 4}}, lookup, 1001, true, &next, &error) ==
+           ChangeStatus::kNotCaughtUp);
+    assert(!error.empty());
+    match[4] = 1001 - RAFT_LEARNER_CATCHUP_ENTRIES;
+    assert(membership.Prepare({{MemberChangeType::kPromote, 4}}, lookup, 1001, true, &next, &error) ==
+           ChangeStatus::kOk);
+    assert(next.voters == std::vector<int32_t>({1, 2, 3, 4}) && next.learners.empty() && !next.Joint());
+    membership.OnAppend(1002, next);
+    membership.OnCommit(1002);
+    assert(membership.Committed().IsVoter(4) && membership.CanCampaign(4));
+
+    // 不合法的变更
+    assert(membership.Prepare({{MemberChangeType::kAddLearner, 2}}, lookup, 1002, true, &next, &error) ==
+           ChangeStatus::kInvalid);
+    assert(membership.Prepare({{MemberChangeType::kPromote, 2}}, lookup, 1002, true, &next, &error) ==
+           ChangeStatus::kInvalid);
+    assert(membership.Prepare({{MemberChangeType::kRemove, 9}}, lookup, 1002, true, &next, &error) ==
+           ChangeStatus::kInvalid);
+    assert(membership.Prepare({}, lookup, 1002, true, &next, &error) == ChangeStatus::kInvalid);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestWaitForLeaderTermCommit() {
+    std::cout << "[Test] a new leader changes membership only after committing in its term... ";
+    // 任期 1 的领导人提议 {1,2,3,4} -> {1,2,3,4,5}，只复制到了少数派就宕机；任期 2 的领导人 1 没有收到这条配置
+    Membership membership(Config({1, 2, 3, 4}, {5}));
+    std::unordered_map<int32_t, uint64_t> match = {{1, 30}, {2, 30}, {3, 30}, {4, 30}, {5, 30}};
+    auto lookup = [&](int32_t node) { return match[node]; };
+
+    // 此时移除 4 得到 {1,2,3}：它的多数派 {1,2} 与 {1,2,3,4,5} 的多数派 {3,4,5} 不相交，同一任期可能出现两个领导人
+    MembershipConfig next;
+    std::string error;
+    assert(membership.Prepare({{MemberChangeType::kRemove, 4}}, lookup, 31, false, &next, &error) ==
+           ChangeStatus::kPending);
+    assert(!error.empty());
+    assert(membership.Prepare({{MemberChangeType::kAddLearner, 6}}, lookup, 31, false, &next, &error) ==
+           ChangeStatus::kPending);
+
+    // 本任期的 no-op (index 31) 提交之后，任期 1 的那条配置已不可能再被提交
+    error.clear();
+    assert(membership.Prepare({{MemberChangeType::kRemove, 4}}, lookup, 31, true, &next, &error) ==
+           ChangeStatus::kOk);
+    assert(error.empty());
+    assert(next.voters == std::vector<int32_t>({1, 2, 3}) && !next.Joint());
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestJointConsensus() {
+    std::cout << "[Test] replacing several voters goes through C_old,new... ";
+    Membership membership(Config({1, 2, 3}, {4, 5}));
+    std::unordered_map<int32_t, uint64_t> match = {{1, 50}, {2, 50}, {3, 50}, {4, 50}, {5, 50}};
+    auto lookup = [&](int32_t node) { return match[node]; };
+
+    MembershipConfig joint;
+    std::vector<MemberChange> changes = {{MemberChangeType::kPromote, 4},
+                                         {MemberChangeType::kPromote, 5},
+                                         {MemberChangeType::kRemove, 2},
+                                         {MemberChangeType::kRemove, 3}};
+    assert(membership.Prepare(changes, lookup, 50, true, &joint) == ChangeStatus::kOk);
+    assert(joint.Joint());
+    assert(joint.voters == std::vector<int32_t>({1, 4, 5}) && joint.outgoing == std::vector<int32_t>({1, 2, 3}));
+    membership.OnAppend(51, joint);
+
+    // 新旧两组各自过半才算多数派 / 才能提交
+    std::unordered_map<int32_t, bool> acked = {{1, true}, {4, true}, {5, true}};
+    auto ack = [&](int32_t node) { return acked[node]; };
+    assert(!membership.HasQuorum(ack));  // 旧组只有 1
+    acked[2] = true;
+    assert(membership.HasQuorum(ack));
+    match = {{1, 51}, {2, 40}, {3, 40}, {4, 51}, {5, 51}};
+    assert(membership.QuorumMatch(lookup) == 40);  // 新组已到 51，旧组多数派只到 40
+    match[2] = 51;
+    assert(membership.QuorumMatch(lookup) == 51);
+
+    // joint 提交后领导人提议 C_new；joint 期间不接受其他变更
+    assert(membership.Prepare({{MemberChangeType::kAddLearner, 9}}, lookup, 51, true, &joint) ==
+           ChangeStatus::kPending);
+    assert(membership.OnCommit(51));
+    MembershipConfig final_config = membership.LeaveJoint();
+    assert(final_config.voters == std::vector<int32_t>({1, 4, 5}) && !final_config.Joint());
+    membership.OnAppend(52, final_config);
+    assert(!membership.OnCommit(51));  // C_new 已在日志中，不再重复提议
+    assert(!membership.OnCommit(52));
+    assert(membership.Committed() == final_config);
+    assert(membership.ShouldStepDown(2) && !membership.ShouldStepDown(4));
+    assert(!membership.CanCampaign(3));
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestTruncateAndRestore() {
+    std::cout << "[Test] truncated config entries roll back, snapshots restore... ";
+    Membership membership(Config({1, 2, 3}));
+    membership.OnAppend(10, Config({1, 2, 3}, {4}));
+    membership.OnAppend(12, Config({1, 2, 3, 4}));
+    assert(membership.Current().IsVoter(4));
+    membership.OnTruncate(11);  // 新领导人的日志在 12 处与本地冲突
+    assert(membership.Current().IsLearner(4) && membership.CurrentIndex() == 10);
+    membership.OnAppend(10, Config({1, 2, 3}, {7}));  // 同一位置被覆盖
+    assert(membership.Current().IsLearner(7) && !membership.Current().Contains(4));
+    membership.OnCommit(10);
+    membership.OnTruncate(5);  // 已提交的配置不会回退
+    assert(membership.Current().IsLearner(7));
+
+    membership.Restore(200, Config({5, 6, 7}));
+    assert(membership.Committed().voters == std::vector<int32_t>({5, 6, 7}) && !membership.ChangePending());
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestEncoding() {
+    std::cout << "[Test] config entry encoding... ";
+    MembershipConfig config = Config({1, 4, 5}, {9, 300});
+    config.outgoing = {1, 2, 3};
+    std::string encoded = raft::EncodeMembership(config);
+    assert(raft::IsMembershipEntry(encoded));
+    assert(!IsBinaryOp(encoded) && !IsBinaryOpBatch(encoded) && !IsOpGroup(encoded));  // 状态机据此跳过
+    MembershipConfig decoded;
+    std::string error;
+    assert(raft::DecodeMembership(encoded, &decoded, &error));
+    assert(decoded == config);
+
+    assert(!raft::DecodeMembership(encoded.substr(0, encoded.size() - 1), &decoded, &error));
+    assert(!raft::DecodeMembership(encoded + "x", &decoded, &error));
+    assert(!raft::DecodeMembership(raft::EncodeMembership(Config({})), &decoded, &error));  // 没有 voter
+    assert(!raft::DecodeMembership(raft::EncodeMembership(Config({1, 2}, {2})), &decoded, &error));
+    assert(!raft::DecodeMembership(raft::EncodeMembership(Config({2, 1})), &decoded, &error));  // 未排序
+    assert(!error.empty());
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    TestLearnersDoNotCountTowardQuorum();
+    TestAddLearnerThenPromote();
+    TestWaitForLeaderTermCommit();
+    TestJointConsensus();
+    TestTruncateAndRestore();
+    TestEncoding();
+    std::cout << "All Membership tests passed!" << std::endl;
+    return 0;
+}
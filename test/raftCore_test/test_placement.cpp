@@ -0,0 +1,148 @@
+// test_placement.cpp
+// 负载报告 / 调度指令编解码，PlanRebalance 的领导权均衡与副本均衡
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "placement.h"
+
+using raft::GroupLoad;
+using raft::NodeLoadReport;
+using raft::PlacementConfig;
+using raft::PlacementMove;
+using raft::RangeDescriptor;
+
+static RangeDescriptor Range(uint64_t group, std::vector<int32_t> replicas) {
+    RangeDescriptor d;
+    d.group_id = group;
+    d.start_key = "k" + std::to_string(group);
+    d.end_key = "k" + std::to_string(group + 1);
+    d.epoch = 1;
+    d.replicas = std::move(replicas);
+    return d;
+}
+
+static GroupLoad Load(uint64_t group, bool leader, double qps, uint64_t bytes) {
+    GroupLoad g;
+    g.group_id = group;
+    g.leader = leader;
+    g.qps = qps;
+    g.bytes = bytes;
+    return g;
+}
+
+static void TestCodec() {
+    std::cout << "[Test] report / move codec... ";
+    NodeLoadReport report;
+    report.node_id = 3;
+    report.groups = {Load(1, true, 1234.5, 1 << 20), Load(7, false, 0, 42)};
+    NodeLoadReport decoded;
+    assert(raft::DecodeNodeLoadReport(raft::EncodeNodeLoadReport(report), &decoded));
+    assert(decoded.node_id == 3 && decoded.groups.size() == 2);
+    assert(decoded.groups[0].group_id == 1 && decoded.groups[0].leader);
+    assert(decoded.groups[0].qps == 1234.5 && decoded.groups[0].bytes == (1u << 20));
+    assert(decoded.groups[1].group_id == 7 && !decoded.groups[1].leader && decoded.groups[1].bytes == 42);
+
+    std::string data = raft::EncodeNodeLoadReport(report);
+    assert(!raft::DecodeNodeLoadReport(data.substr(0, data.size() - 1), &decoded));
+    assert(!raft::DecodeNodeLoadReport(data + "x", &decoded));
+    assert(!raft::DecodeNodeLoadReport("", &decoded));
+
+    PlacementMove move{PlacementMove::Type::kMoveReplica, 9, 1, 4};
+    PlacementMove out;
+    assert(raft::DecodePlacementMove(raft::EncodePlacementMove(move), &out));
+    assert(out.type == PlacementMove::Type::kMoveReplica && out.group_id == 9 && out.from_node == 1 && out.to_node == 4);
+    data = raft::EncodePlacementMove(move);
+    data[1] = 5;  // 未知类型
+    assert(!raft::DecodePlacementMove(data, &out));
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestTransferLeader() {
+    std::cout << "[Test] leader rebalance... ";
+    // 三个组的领导人都在节点 1 上，副本都在 1/2/3
+    std::vector<RangeDescriptor> ranges = {Range(1, {1, 2, 3}), Range(2, {1, 2, 3}), Range(3, {1, 2, 3})};
+    std::vector<NodeLoadReport> reports(3);
+    for (int n = 0; n < 3; ++n) {
+        reports[n].node_id = n + 1;
+        for (uint64_t g = 1; g <= 3; ++g) {
+            reports[n].groups.push_back(Load(g, n == 0, n == 0 ? 100.0 * g : 0, 1000));
+        }
+    }
+
+    std::vector<PlacementMove> moves = raft::PlanRebalance(reports, ranges);
+    assert(moves.size() == 2);
+    for (const PlacementMove& m : moves) {
+        assert(m.type == PlacementMove::Type::kTransferLeader && m.from_node == 1);
+    }
+    // 最热的组 (300) 先交给空闲节点，再把 200 交给另一个空闲节点
+    assert(moves[0].group_id == 3 && moves[1].group_id == 2);
+    assert(moves[0].to_node != moves[1].to_node);
+
+    // 正在迁移的组跳过；max_moves 限制每轮数量
+    moves = raft::PlanRebalance(reports, ranges, {3});
+    assert(!moves.empty() && moves[0].group_id == 2);
+    PlacementConfig one;
+    one.max_moves = 1;
+    assert(raft::PlanRebalance(reports, ranges, {}, one).size() == 1);
+
+    // 已经均衡：不生成指令
+    for (int n = 0; n < 3; ++n) {
+        for (GroupLoad& g : reports[n].groups) {
+            g.leader = (g.group_id == static_cast<uint64_t>(n + 1));
+            g.qps = g.leader ? 100 : 0;
+        }
+    }
+    assert(raft::PlanRebalance(reports, ranges).empty());
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestNoPingPong() {
+    std::cout << "[Test] single hot group is not moved back and forth... ";
+    // 只有一个热组：交给别人只会让别人变成热点，差距不缩小
+    std::vector<RangeDescriptor> ranges = {Range(1, {1, 2, 3})};
+    std::vector<NodeLoadReport> reports(3);
+    for (int n = 0; n < 3; ++n) {
+        reports[n].node_id = n + 1;
+        reports[n].groups.push_back(Load(1, n == 0, n == 0 ? 1000 : 0, 0));
+    }
+    assert(raft::PlanRebalance(reports, ranges).empty());
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestMoveReplica() {
+    std::cout << "[Test] replica rebalance... ";
+    // 节点 4 刚加入，没有副本；领导权已均衡 (都为 0)
+    std::vector<RangeDescriptor> ranges = {Range(1, {1, 2, 3}), Range(2, {1, 2, 3}), Range(3, {1, 2, 3})};
+    std::vector<NodeLoadReport> reports(4);
+    for (int n = 0; n < 4; ++n) {
+        reports[n].node_id = n + 1;
+        if (n == 3) continue;
+        for (uint64_t g = 1; g <= 3; ++g) {
+            reports[n].groups.push_back(Load(g, false, 0, g << 20));
+        }
+    }
+    std::vector<PlacementMove> moves = raft::PlanRebalance(reports, ranges);
+    assert(!moves.empty());
+    assert(moves[0].type == PlacementMove::Type::kMoveReplica);
+    assert(moves[0].to_node == 4 && moves[0].group_id == 3);  // 最大的组先搬
+    for (size_t i = 0; i < moves.size(); ++i) {
+        assert(moves[i].to_node == 4);
+        for (size_t j = 0; j < i; ++j) assert(moves[i].group_id != moves[j].group_id);
+    }
+
+    // 没有上报的节点不作为目标
+    reports.pop_back();
+    assert(raft::PlanRebalance(reports, ranges).empty());
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    TestCodec();
+    TestTransferLeader();
+    TestNoPingPong();
+    TestMoveReplica();
+    std::cout << "All Placement tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,406 @@
+// test_proposal_batcher.cpp
+// ProposalBatcher + ApplyPipeline：低负载不凑批 (linger 为 0)、高负载合并成 OpGroup 日志、
+// 结果按命令扇出、批大小上限、非领导人拒绝、停止时未提交的命令、追踪上下文随日志传到 apply
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "apply_pipeline.h"
+#include "opCodec.h"
+#include "proposal_batcher.h"
+#include "trace.h"
+
+using raft::ApplyEntry;
+using raft::ApplyPipeline;
+using raft::ApplyResult;
+using raft::ProposalBatcher;
+using raft::ProposalBatcherConfig;
+using Status = raft::ApplyPipeline::Status;
+
+static std::string PutCommand(const std::string& client, int request, const std::string& key,
+                              const std::string& value) {
+    std::string out;
+    EncodeOp(out, "Put", key, value, client, request);
+    return out;
+}
+
+// 单节点 "Raft"：Propose 追加日志、登记等待者并立即提交；状态机执行 Put，结果为写入的 value
+class FakeRaft : public raft::ProposalSink, public raft::ApplySource, public raft::ApplyStateMachine {
+public:
+    FakeRaft() : pipeline_(this, this) { pipeline_.Start(0); }
+    ~FakeRaft() override { pipeline_.Stop(); }
+
+    bool Propose(const std::string& command, ApplyPipeline::WaitCallback done) override {
+        {
+            std::unique_lock<std::mutex> lock(gate_mtx_);
+            ++in_propose_;
+            gate_cv_.notify_all();
+            gate_cv_.wait(lock, [this] { return !blocked_; });
+            --in_propose_;
+        }
+        if (!leader_.load()) {
+            return false;
+        }
+        if (propose_delay_us_ > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(propose_delay_us_));  // 模拟追加 WAL
+        }
+        uint64_t index = 0;
+        {
+            std::lock_guard<std::mutex> lock(log_mtx_);
+            log_.push_back(command);
+            traces_.push_back(Tracer::Current());  // Raft 核心把它写进 LogEntry.traceId / spanId
+            index = log_.size();
+            if (IsOpGroup(command)) {
+                ++groups_;
+            }
+            pipeline_.Wait(index, 1, std::move(done));  // 与追加在同一把锁内
+        }
+        pipeline_.OnCommit(index);
+        return true;
+    }
+
+    size_t CopyCommitted(uint64_t from, uint64_t to, size_t max_entries, size_t,
+                         std::vector<ApplyEntry>* out) override {
+        std::lock_guard<std::mutex> lock(log_mtx_);
+        size_t n = 0;
+        for (uint64_t i = from; i <= to && n < max_entries; ++i, ++n) {
+            if (out->size() <= n) {
+                out->emplace_back();
+            }
+            (*out)[n].index = i;
+            (*out)[n].term = 1;
+            (*out)[n].command.assign(log_[i - 1]);
+            (*out)[n].trace_id = traces_[i - 1].trace_id;
+            (*out)[n].span_id = traces_[i - 1].span_id;
+        }
+        out->resize(n);
+        return n;
+    }
+
+    void ApplyBatch(const std::vector<ApplyEntry>& entries, std::vector<ApplyResult>* results) override {
+        std::vector<std::string_view> commands;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const std::string& cmd = entries[i].command;
+            if (IsOpGroup(cmd)) {
+                assert(DecodeOpGroup(cmd, &commands));
+                (*results)[i].ops.resize(commands.size());
+                for (size_t j = 0; j < commands.size(); ++j) {
+                    ApplyOne(commands[j], &(*results)[i].ops[j]);
+                }
+            } else {
+                ApplyOne(cmd, &(*results)[i]);
+            }
+        }
+    }
+
+    void Block() {
+        std::lock_guard<std::mutex> lock(gate_mtx_);
+        blocked_ = true;
+    }
+    void Unblock() {
+        std::lock_guard<std::mutex> lock(gate_mtx_);
+        blocked_ = false;
+        gate_cv_.notify_all();
+    }
+    void WaitInPropose() {
+        std::unique_lock<std::mutex> lock(gate_mtx_);
+        gate_cv_.wait(lock, [this] { return in_propose_ > 0; });
+    }
+    size_t Groups() {
+        std::lock_guard<std::mutex> lock(log_mtx_);
+        return groups_;
+    }
+    TraceContext TraceAt(uint64_t index) {
+        std::lock_guard<std::mutex> lock(log_mtx_);
+        return traces_[index - 1];
+    }
+
+    std::atomic<bool> leader_{true};
+    int propose_delay_us_ = 0;
+    std::map<std::string, std::string> data_;  // 只由 apply 线程访问
+
+private:
+    void ApplyOne(std::string_view cmd, ApplyResult* result) {
+        OpView op;
+        assert(DecodeOpView(cmd, &op));
+        data_[std::string(op.Key)] = std::string(op.Value);
+        result->value.assign(op.Value.data(), op.Value.size());
+    }
+
+    std::mutex log_mtx_;
+    std::vector<std::string> log_;
+    std::vector<TraceContext> traces_;
+    size_t groups_ = 0;
+    std::mutex gate_mtx_;
+    std::condition_variable gate_cv_;
+    bool blocked_ = false;
+    int in_propose_ = 0;
+    ApplyPipeline pipeline_;
+};
+
+class Latch {
+public:
+    explicit Latch(int n) : n_(n) {}
+    void CountDown() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (--n_ == 0) {
+            cv_.notify_all();
+        }
+    }
+    void Wait() {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait(lock, [this] { return n_ <= 0; });
+    }
+
+private:
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    int n_;
+};
+
+static void TestLowLoadDoesNotLinger() {
+    std::cout << "[Test] sequential clients are proposed one by one without lingering... ";
+    FakeRaft raft;
+    ProposalBatcher batcher(&raft);
+    batcher.Start();
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < 200; ++i) {
+        Latch latch(1);
+        batcher.Submit(PutCommand("1", i, "k", "v" + std::to_string(i)), [&](Status s, const ApplyResult& r) {
+            assert(s == Status::kApplied && r.value == "v" + std::to_string(i));
+            latch.CountDown();
+        });
+        latch.Wait();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin);
+    raft::ProposalBatcherStats stats = batcher.Stats();
+    assert(stats.proposals == 200 && stats.ops == 200 && stats.max_ops == 1);
+    assert(stats.linger_us == 0);
+    assert(raft.Groups() == 0);  // 单条命令原样提交，不加 OpGroup 框
+    assert(elapsed.count() < 200 * PROPOSAL_MAX_LINGER_US / 1000);
+    batcher.Stop();
+    std::cout << "PASSED (" << elapsed.count() << "ms)" << std::endl;
+}
+
+static void TestConcurrentWritesAreCoalesced() {
+    std::cout << "[Test] concurrent clients are coalesced, results fan out... ";
+    FakeRaft raft;
+    raft.propose_delay_us_ = 200;
+    ProposalBatcherConfig config;
+    config.max_ops = 32;
+    ProposalBatcher batcher(&raft, config);
+    batcher.Start();
+
+    const int kClients = 32;
+    const int kRequests = 100;
+    std::atomic<int> wrong{0};
+    std::atomic<bool> done{false};
+    std::atomic<int64_t> max_linger{0};
+    std::thread sampler([&] {
+        while (!done.load()) {
+            max_linger.store(std::max(max_linger.load(), batcher.Stats().linger_us));
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+    std::vector<std::thread> clients;
+    for (int c = 0; c < kClients; ++c) {
+        clients.emplace_back([&, c] {
+            for (int i = 0; i < kRequests; ++i) {
+                std::string value = std::to_string(c) + ":" + std::to_string(i);
+                Latch latch(1);
+                batcher.Submit(PutCommand(std::to_string(c), i, "key" + std::to_string(c), value),
+                               [&](Status s, const ApplyResult& r) {
+                                   if (s != Status::kApplied || r.value != value) {
+                                       ++wrong;
+                                   }
+                                   latch.CountDown();
+                               });
+                latch.Wait();
+            }
+        });
+    }
+    for (auto& t : clients) {
+        t.join();
+    }
+    done.store(true);
+    sampler.join();
+
+    raft::ProposalBatcherStats stats = batcher.Stats();
+    assert(wrong.load() == 0);  // 每个客户端拿到的是自己那条命令的结果
+    assert(stats.ops == kClients * kRequests);
+    assert(stats.proposals * 4 < stats.ops);  // 至少平均 4 条命令一条日志
+    assert(stats.max_ops <= config.max_ops && stats.max_ops > 1);
+    assert(raft.Groups() > 0);
+    assert(max_linger.load() > 0 && max_linger.load() <= config.max_linger_us);
+    batcher.Stop();
+    std::cout << "PASSED (" << stats.ops << " ops in " << stats.proposals << " entries)" << std::endl;
+}
+
+static void TestBatchLimits() {
+    std::cout << "[Test] op-count and byte limits... ";
+    FakeRaft raft;
+    ProposalBatcherConfig config;
+    config.max_ops = 8;
+    config.max_bytes = 4096;
+    ProposalBatcher batcher(&raft, config);
+    batcher.Start();
+
+    // 第一条卡在 Propose 里，后面的命令在 pending 里攒起来
+    raft.Block();
+    Latch latch(1 + 40 + 10);
+    batcher.Submit(PutCommand("1", 0, "first", "v"), [&](Status, const ApplyResult&) { latch.CountDown(); });
+    raft.WaitInPropose();
+    for (int i = 0; i < 40; ++i) {
+        batcher.Submit(PutCommand("2", i, "small", "v"), [&](Status s, const ApplyResult&) {
+            assert(s == Status::kApplied);
+            latch.CountDown();
+        });
+    }
+    std::string big(1500, 'x');
+    for (int i = 0; i < 10; ++i) {
+        batcher.Submit(PutCommand("3", i, "big", big), [&](Status s, const ApplyResult& r) {
+            assert(s == Status::kApplied && r.value.size() == 1500);
+            latch.CountDown();
+        });
+    }
+    raft.Unblock();
+    latch.Wait();
+    raft::ProposalBatcherStats stats = batcher.Stats();
+    assert(stats.max_ops == 8);
+    // 40 条小命令至少 5 条日志，10 条 1.5KB 的命令每条日志最多 2 条
+    assert(stats.proposals >= 1 + 5 + 5);
+    batcher.Stop();
+    std::cout << "PASSED (" << stats.proposals << " entries)" << std::endl;
+}
+
+static void TestNotLeaderAndStop() {
+    std::cout << "[Test] rejected proposals and shutdown... ";
+    FakeRaft raft;
+    ProposalBatcher batcher(&raft);
+    batcher.Start();
+
+    raft.leader_.store(false);
+    Latch rejected(5);
+    raft.Block();
+    batcher.Submit(PutCommand("1", 0, "k", "v"), [&](Status s, const ApplyResult&) {
+        assert(s == Status::kLost);
+        rejected.CountDown();
+    });
+    raft.WaitInPropose();
+    for (int i = 1; i < 5; ++i) {
+        batcher.Submit(PutCommand("1", i, "k", "v"), [&](Status s, const ApplyResult&) {
+            assert(s == Status::kLost);  // 整批一起被拒绝
+            rejected.CountDown();
+        });
+    }
+    raft.Unblock();
+    rejected.Wait();
+    assert(batcher.Stats().rejected == 5 && batcher.Stats().proposals == 0);
+
+    // 停止：已交给 Raft 的命令照常完成，还在队列里的回调 kShutdown
+    raft.leader_.store(true);
+    raft.Block();
+    std::atomic<int> applied{0};
+    std::atomic<int> shutdown{0};
+    auto count = [&](Status s, const ApplyResult&) {
+        if (s == Status::kApplied) ++applied;
+        if (s == Status::kShutdown) ++shutdown;
+    };
+    batcher.Submit(PutCommand("2", 0, "k", "inflight"), count);
+    raft.WaitInPropose();
+    for (int i = 1; i <= 5; ++i) {
+        batcher.Submit(PutCommand("2", i, "k", "queued"), count);
+    }
+    std::thread stopper([&] { batcher.Stop(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));  // 等 Stop 置位，flusher 仍卡在 Propose 里
+    raft.Unblock();
+    stopper.join();
+    assert(shutdown.load() == 5);
+    batcher.Submit(PutCommand("2", 6, "k", "late"), count);
+    assert(shutdown.load() == 6);
+    std::cout << "PASSED" << std::endl;
+}
+
+static const SpanRecord* FindSpan(const std::vector<SpanRecord>& spans, const char* name) {
+    for (const SpanRecord& s : spans) {
+        if (std::strcmp(s.name, name) == 0) {
+            return &s;
+        }
+    }
+    return nullptr;
+}
+
+static void TestTracePropagation() {
+    std::cout << "[Test] sampled commands carry their trace into the entry and apply... ";
+    Tracer& tracer = Tracer::GetInstance();
+    tracer.Clear();
+    tracer.SetSampleRate(1);
+    FakeRaft raft;
+    ProposalBatcher batcher(&raft);
+    batcher.Start();
+
+    // 未采样的命令：日志不带追踪信息
+    {
+        Latch latch(1);
+        batcher.Submit(PutCommand("1", 0, "k", "v0"), [&](Status, const ApplyResult&) { latch.CountDown(); });
+        latch.Wait();
+    }
+    assert(!raft.TraceAt(1).Sampled());
+
+    TraceContext root = tracer.Sample();
+    uint64_t handler_span = 0;
+    {
+        TraceSpan handler("rpc.server.handler", root);
+        handler_span = handler.Context().span_id;
+        Latch latch(1);
+        {
+            ScopedTraceContext scope(handler.Context());
+            batcher.Submit(PutCommand("1", 1, "k", "v1"), [&](Status s, const ApplyResult&) {
+                assert(s == Status::kApplied);
+                latch.CountDown();
+            });
+        }
+        latch.Wait();
+    }
+    batcher.Stop();
+    tracer.SetSampleRate(0);
+
+    std::vector<SpanRecord> spans;
+    for (const SpanRecord& s : tracer.Collect()) {
+        if (s.trace_id == root.trace_id) {
+            spans.push_back(s);
+        }
+    }
+    const SpanRecord* wait = FindSpan(spans, "raft.batch.wait");
+    const SpanRecord* propose = FindSpan(spans, "raft.propose");
+    const SpanRecord* apply = FindSpan(spans, "raft.apply");
+    assert(spans.size() == 4 && wait && propose && apply);
+    assert(wait->parent_id == handler_span && propose->parent_id == handler_span);
+    assert(wait->end_ns <= propose->start_ns);
+    assert(apply->parent_id == propose->span_id);
+    assert(propose->start_ns <= apply->start_ns && apply->end_ns <= propose->end_ns);
+    assert(propose->arg_value == static_cast<uint64_t>(Status::kApplied));
+    // 日志携带的是 raft.propose span
+    TraceContext entry = raft.TraceAt(2);
+    assert(entry.trace_id == root.trace_id && entry.span_id == propose->span_id);
+    tracer.Clear();
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    TestLowLoadDoesNotLinger();
+    TestConcurrentWritesAreCoalesced();
+    TestBatchLimits();
+    TestNotLeaderAndStop();
+    TestTracePropagation();
+    std::cout << "All ProposalBatcher tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,134 @@
+// test_range_load.cpp
+// RangeLoadTracker 滑动平均、分裂判定、分裂后的区间描述
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "range_load.h"
+
+using raft::RangeDescriptor;
+using raft::RangeLoadTracker;
+using raft::SplitPolicy;
+using raft::SplitReason;
+using Clock = RangeLoadTracker::Clock;
+
+static bool Near(double a, double b) { return std::fabs(a - b) < 1e-6 * std::max(1.0, std::fabs(b)); }
+
+static void TestEwma() {
+    std::cout << "[Test] load tracker EWMA... ";
+    Clock::time_point t0 = Clock::now();
+    RangeLoadTracker tracker(1000, t0);
+
+    // 首次采样直接取速率
+    tracker.RecordRead(500);
+    tracker.RecordWrite(4096, 100);
+    RangeLoadTracker::Snapshot s = tracker.Sample(t0 + std::chrono::milliseconds(1000));
+    assert(Near(s.read_qps, 500));
+    assert(Near(s.write_qps, 100));
+    assert(Near(s.write_bytes_per_sec, 4096));
+    assert(Near(s.Qps(), 600));
+
+    // 经过一个半衰期、速率为 0：旧值权重剩一半
+    s = tracker.Sample(t0 + std::chrono::milliseconds(2000));
+    assert(Near(s.read_qps, 250));
+    assert(Near(s.write_qps, 50));
+
+    // 时间没有前进：不更新
+    tracker.RecordRead(1000000);
+    s = tracker.Sample(t0 + std::chrono::milliseconds(2000));
+    assert(Near(s.read_qps, 250));
+
+    // 计数没有丢：下一次采样计入
+    s = tracker.Sample(t0 + std::chrono::milliseconds(3000));
+    assert(Near(s.read_qps, 125 + 0.5 * 1000000));
+
+    tracker.Halve();
+    assert(Near(tracker.Current().read_qps, s.read_qps / 2));
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestConcurrentRecord() {
+    std::cout << "[Test] concurrent record and sample... ";
+    Clock::time_point t0 = Clock::now();
+    // 半衰期远小于采样间隔：滑动平均等于本段速率，间隔 1s 时即为本段计数
+    RangeLoadTracker tracker(1, t0);
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; ++t) {
+        writers.emplace_back([&]() {
+            for (int i = 0; i < 10000; ++i) {
+                tracker.RecordRead();
+                tracker.RecordWrite(10);
+            }
+        });
+    }
+    double reads = 0;
+    for (int i = 1; i <= 50; ++i) {
+        reads += tracker.Sample(t0 + std::chrono::seconds(i)).read_qps;
+    }
+    for (auto& w : writers) w.join();
+    reads += tracker.Sample(t0 + std::chrono::seconds(51)).read_qps;
+    assert(Near(reads, 40000));  // 与采样交错的计数不丢也不重复
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestShouldSplit() {
+    std::cout << "[Test] split policy... ";
+    SplitPolicy policy;
+    policy.max_bytes = 1 << 20;
+    policy.max_qps = 1000;
+    policy.min_interval_ms = 60000;
+    policy.min_keys = 16;
+
+    assert(raft::ShouldSplit(policy, 100, 100, 10, 1 << 30) == SplitReason::kNone);
+    assert(raft::ShouldSplit(policy, 2 << 20, 100, 10, 1 << 30) == SplitReason::kSize);
+    assert(raft::ShouldSplit(policy, 100, 100, 5000, 1 << 30) == SplitReason::kLoad);
+    assert(raft::ShouldSplit(policy, 2 << 20, 100, 5000, 1 << 30) == SplitReason::kSize);  // 大小优先
+    // 刚分裂过 / key 太少
+    assert(raft::ShouldSplit(policy, 2 << 20, 100, 5000, 1000) == SplitReason::kNone);
+    assert(raft::ShouldSplit(policy, 2 << 20, 8, 5000, 1 << 30) == SplitReason::kNone);
+    // 阈值为 0 表示关闭该项
+    policy.max_qps = 0;
+    assert(raft::ShouldSplit(policy, 100, 100, 1e9, 1 << 30) == SplitReason::kNone);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestSplitDescriptor() {
+    std::cout << "[Test] split descriptor... ";
+    RangeDescriptor range;
+    range.group_id = 1;
+    range.start_key = "b";
+    range.end_key = "m";
+    range.epoch = 7;
+    range.replicas = {1, 2, 3};
+
+    RangeDescriptor left, right;
+    assert(raft::SplitDescriptor(range, "g", 9, &left, &right));
+    assert(left.group_id == 1 && left.start_key == "b" && left.end_key == "g" && left.epoch == 8);
+    assert(right.group_id == 9 && right.start_key == "g" && right.end_key == "m" && right.epoch == 8);
+    assert(left.replicas == range.replicas && right.replicas == range.replicas);
+
+    // 右边界无穷大
+    range.end_key = "";
+    assert(raft::SplitDescriptor(range, "zz", 9, &left, &right));
+    assert(right.end_key.empty() && left.end_key == "zz");
+
+    // 分裂点必须在区间内部、新组不能与原组相同
+    assert(!raft::SplitDescriptor(range, "b", 9, &left, &right));
+    assert(!raft::SplitDescriptor(range, "a", 9, &left, &right));
+    assert(!raft::SplitDescriptor(range, "g", 1, &left, &right));
+    range.end_key = "m";
+    assert(!raft::SplitDescriptor(range, "m", 9, &left, &right));
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    TestEwma();
+    TestConcurrentRecord();
+    TestShouldSplit();
+    TestSplitDescriptor();
+    std::cout << "All RangeLoad tests passed!" << std::endl;
+    return 0;
+}
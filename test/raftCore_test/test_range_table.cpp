@@ -0,0 +1,138 @@
+// test_range_table.cpp
+// RangeTable：定位、按 epoch 更新、分裂时的覆盖、全量重载、描述编解码
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "range_table.h"
+
+using raft::RangeDescriptor;
+using raft::RangeTable;
+
+static RangeDescriptor Range(uint64_t group, const std::string& start, const std::string& end, uint64_t epoch) {
+    RangeDescriptor d;
+    d.group_id = group;
+    d.start_key = start;
+    d.end_key = end;
+    d.epoch = epoch;
+    d.replicas = {1, 2, 3};
+    return d;
+}
+
+static uint64_t GroupOf(const RangeTable& table, const std::string& key) {
+    RangeDescriptor d;
+    return table.Locate(key, &d) ? d.group_id : 0;
+}
+
+static void TestLocate() {
+    std::cout << "[Test] locate key ranges... ";
+    RangeTable table;
+    assert(GroupOf(table, "a") == 0);
+    assert(table.Update(Range(1, "", "g", 1)) == RangeTable::Status::kOk);
+    assert(table.Update(Range(2, "g", "p", 1)) == RangeTable::Status::kOk);
+    assert(table.Update(Range(3, "p", "", 1)) == RangeTable::Status::kOk);
+
+    assert(GroupOf(table, "") == 1);
+    assert(GroupOf(table, "apple") == 1);
+    assert(GroupOf(table, "g") == 2);          // start 闭区间
+    assert(GroupOf(table, "olive") == 2);
+    assert(GroupOf(table, "p") == 3);          // end 开区间
+    assert(GroupOf(table, "zzzz") == 3);       // 空 end 表示 +inf
+    assert(table.Size() == 3);
+
+    assert(table.Update(Range(4, "m", "k", 1)) == RangeTable::Status::kInvalid);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestSplitAndStale() {
+    std::cout << "[Test] split / stale epoch / out-of-order updates... ";
+    RangeTable table;
+    table.Update(Range(1, "a", "z", 1));
+
+    // 旧 epoch 的描述被拒绝
+    assert(table.Update(Range(1, "a", "q", 1)) == RangeTable::Status::kStale);
+
+    // 分裂：先收到新组 (与原组重叠)，原组被移除，原组缩小后的描述到来后恢复
+    assert(table.Update(Range(2, "m", "z", 1)) == RangeTable::Status::kOk);
+    assert(GroupOf(table, "n") == 2);
+    assert(GroupOf(table, "b") == 0);          // 查不到：调用方回源
+    assert(table.Update(Range(1, "a", "m", 2)) == RangeTable::Status::kOk);
+    assert(GroupOf(table, "b") == 1);
+    assert(GroupOf(table, "m") == 2);
+
+    // 合并：组 1 吸收组 2
+    assert(table.Update(Range(1, "a", "z", 3)) == RangeTable::Status::kOk);
+    assert(GroupOf(table, "n") == 1);
+    RangeDescriptor d;
+    assert(!table.Get(2, &d));
+    assert(table.Size() == 1);
+
+    table.Remove(1);
+    assert(table.Size() == 0 && GroupOf(table, "b") == 0);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestReset() {
+    std::cout << "[Test] full reload... ";
+    RangeTable table;
+    table.Update(Range(9, "", "", 1));
+    assert(table.Reset({Range(1, "", "k", 2), Range(2, "k", "", 1)}));
+    assert(GroupOf(table, "a") == 1 && GroupOf(table, "x") == 2);
+    RangeDescriptor d;
+    assert(!table.Get(9, &d));
+
+    // 重叠 / 重复组的列表被拒绝，表保持不变
+    assert(!table.Reset({Range(1, "", "m", 3), Range(2, "k", "", 1)}));
+    assert(!table.Reset({Range(1, "", "c", 3), Range(1, "c", "", 3)}));
+    assert(GroupOf(table, "l") == 2);
+    assert(table.All().size() == 2 && table.All()[0].group_id == 1);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestCodec() {
+    std::cout << "[Test] descriptor codec... ";
+    RangeDescriptor in = Range(123456789, std::string("a\0b", 3), "", 42);
+    in.replicas = {1, 7, 2147483647};
+    std::string data = raft::EncodeRangeDescriptor(in);
+
+    RangeDescriptor out;
+    assert(raft::DecodeRangeDescriptor(data, &out));
+    assert(out.group_id == in.group_id && out.epoch == 42);
+    assert(out.start_key == in.start_key && out.end_key.empty());
+    assert(out.replicas == in.replicas);
+
+    assert(!raft::DecodeRangeDescriptor(data.substr(0, data.size() - 1), &out));
+    assert(!raft::DecodeRangeDescriptor(data + "x", &out));
+    assert(!raft::DecodeRangeDescriptor("", &out));
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestConcurrentLocate() {
+    std::cout << "[Test] concurrent locate during updates... ";
+    RangeTable table;
+    table.Update(Range(1, "", "", 1));
+    bool bad = false;
+    std::thread reader([&]() {
+        for (int i = 0; i < 20000; ++i) {
+            if (GroupOf(table, "k" + std::to_string(i % 100)) == 99) bad = true;
+        }
+    });
+    for (uint64_t epoch = 2; epoch < 2000; ++epoch) {
+        table.Update(Range(1, "", "", epoch));
+    }
+    reader.join();
+    assert(!bad);
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    TestLocate();
+    TestSplitAndStale();
+    TestReset();
+    TestCodec();
+    TestConcurrentLocate();
+    std::cout << "All RangeTable tests passed!" << std::endl;
+    return 0;
+}
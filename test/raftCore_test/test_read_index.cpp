@@ -0,0 +1,245 @@
+// test_read_index.cpp
+// ReadIndex：领导权确认、批量共享心跳、等待 apply、租约、退位、超时
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "read_index.h"
+
+using raft::ReadIndex;
+using raft::ReadIndexConfig;
+using Clock = std::chrono::steady_clock;
+
+// 模拟 Raft 核心：每次 BroadcastHeartbeat 在 delay 之后由 "多数派" 确认 (delay < 0 表示永不确认)
+class FakeHost : public raft::ReadIndexHost {
+public:
+    void BroadcastHeartbeat() override {
+        broadcasts.fetch_add(1);
+        Clock::time_point sent_at = Clock::now();
+        int delay = delay_ms.load();
+        if (delay < 0) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mtx);
+        acks.emplace_back([this, sent_at, delay]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+            ri->OnQuorumAck(term, sent_at);
+        });
+    }
+
+    // 测试结束前等所有确认线程退出 (它们持有 ri)
+    void Join() {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (auto& t : acks) t.join();
+        acks.clear();
+    }
+
+    ReadIndex* ri = nullptr;
+    std::atomic<uint64_t> term{1};
+    std::atomic<int> delay_ms{5};
+    std::atomic<int> broadcasts{0};
+    std::mutex mtx;
+    std::vector<std::thread> acks;
+};
+
+static void BecomeReadyLeader(ReadIndex* ri, uint64_t term, uint64_t commit) {
+    ri->BecomeLeader(term);
+    ri->OnCommit(commit, term);
+    ri->OnApplied(commit);
+}
+
+static void TestNotLeaderAndTermCommit() {
+    std::cout << "[Test] not leader / wait for term commit... ";
+    FakeHost host;
+    ReadIndex ri(&host);
+    host.ri = &ri;
+    assert(ri.WaitReadable(50) == ReadIndex::Status::kNotLeader);
+
+    // 当选但本任期还没有提交日志：之前任期的 commit_index 不可信，读必须等待
+    ri.OnCommit(5, 1);
+    ri.OnApplied(5);
+    ri.BecomeLeader(2);
+    host.term = 2;
+    assert(!ri.TermCommitted());
+    assert(ri.WaitReadable(30) == ReadIndex::Status::kTimeout);
+    assert(host.broadcasts.load() == 0);
+
+    std::thread committer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ri.OnCommit(6, 2);  // no-op 提交
+        ri.OnApplied(6);
+    });
+    uint64_t index = 0;
+    assert(ri.WaitReadable(1000, &index) == ReadIndex::Status::kOk);
+    assert(index == 6);
+    assert(ri.TermCommitted());
+    committer.join();
+    ri.StepDown();
+    assert(!ri.TermCommitted());
+    host.Join();
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestBatchSharesRound() {
+    std::cout << "[Test] concurrent reads share heartbeat rounds... ";
+    FakeHost host;
+    host.delay_ms = 20;
+    ReadIndex ri(&host);
+    host.ri = &ri;
+    BecomeReadyLeader(&ri, 1, 10);
+
+    const int kReaders = 64;
+    std::atomic<int> ok{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < kReaders; ++i) {
+        readers.emplace_back([&]() {
+            if (ri.WaitReadable(2000) == ReadIndex::Status::kOk) ok.fetch_add(1);
+        });
+    }
+    for (auto& t : readers) t.join();
+    assert(ok.load() == kReaders);
+    // 每轮确认期间到达的读共享下一轮：轮数远少于读的个数
+    assert(host.broadcasts.load() <= kReaders / 8);
+    assert(ri.GetStats().rounds == static_cast<uint64_t>(host.broadcasts.load()));
+    assert(ri.GetStats().reads == static_cast<uint64_t>(kReaders));
+    host.Join();
+    std::cout << "PASSED (" << kReaders << " reads / " << host.broadcasts.load() << " rounds)" << std::endl;
+}
+
+static void TestStaleAckDoesNotConfirm() {
+    std::cout << "[Test] heartbeat sent before the read does not confirm it... ";
+    FakeHost host;
+    host.delay_ms = -1;
+    ReadIndex ri(&host);
+    host.ri = &ri;
+    BecomeReadyLeader(&ri, 1, 3);
+
+    Clock::time_point old_sent = Clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    std::thread late_ack([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ri.OnQuorumAck(1, old_sent);  // 读之前发出的心跳
+    });
+    assert(ri.WaitReadable(40) == ReadIndex::Status::kTimeout);
+    late_ack.join();
+
+    // 旧任期的确认被忽略
+    std::thread wrong_term([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ri.OnQuorumAck(0, Clock::now());
+    });
+    assert(ri.WaitReadable(40) == ReadIndex::Status::kTimeout);
+    wrong_term.join();
+    host.Join();
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestWaitForApply() {
+    std::cout << "[Test] read waits until applied >= read index... ";
+    FakeHost host;
+    ReadIndex ri(&host);
+    host.ri = &ri;
+    BecomeReadyLeader(&ri, 1, 10);
+    ri.OnCommit(20, 1);  // 已提交但尚未 apply
+
+    // 为 follower 确认 read index：不等领导人自己的 apply
+    uint64_t remote = 0;
+    assert(ri.ConfirmReadIndex(1000, &remote) == ReadIndex::Status::kOk);
+    assert(remote == 20);
+    assert(ri.GetStats().remote_reads == 1);
+
+    std::atomic<bool> applied{false};
+    std::thread applier([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        applied = true;
+        ri.OnApplied(20);
+    });
+    uint64_t index = 0;
+    assert(ri.WaitReadable(1000, &index) == ReadIndex::Status::kOk);
+    assert(applied.load());
+    assert(index == 20);
+    applier.join();
+    host.Join();
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestLease() {
+    std::cout << "[Test] lease reads skip the heartbeat round... ";
+    FakeHost host;
+    ReadIndexConfig config;
+    config.lease_read = true;
+    config.election_timeout_min_ms = 100;
+    config.clock_drift_ms = 20;  // 租约 80ms
+    ReadIndex ri(&host, config);
+    host.ri = &ri;
+    BecomeReadyLeader(&ri, 1, 1);
+    assert(!ri.LeaseValid());
+
+    assert(ri.WaitReadable(1000) == ReadIndex::Status::kOk);  // 第一次：心跳确认并获得租约
+    assert(host.broadcasts.load() == 1);
+    assert(ri.LeaseValid());
+    for (int i = 0; i < 100; ++i) {
+        assert(ri.WaitReadable(1000) == ReadIndex::Status::kOk);
+    }
+    assert(host.broadcasts.load() == 1);
+    assert(ri.GetStats().lease_reads == 100);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(120));  // 租约过期
+    assert(!ri.LeaseValid());
+    assert(ri.WaitReadable(1000) == ReadIndex::Status::kOk);
+    assert(host.broadcasts.load() == 2);
+
+    ri.StepDown();
+    assert(!ri.LeaseValid());
+    assert(ri.WaitReadable(50) == ReadIndex::Status::kNotLeader);
+    host.Join();
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestStepDownAbortsAndRetry() {
+    std::cout << "[Test] step down aborts waiting reads / lost rounds are retried... ";
+    FakeHost host;
+    host.delay_ms = -1;
+    ReadIndexConfig config;
+    config.round_retry_ms = 10;
+    ReadIndex ri(&host, config);
+    host.ri = &ri;
+    BecomeReadyLeader(&ri, 1, 1);
+
+    std::thread stepper([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        ri.StepDown();
+    });
+    assert(ri.WaitReadable(2000) == ReadIndex::Status::kNotLeader);
+    stepper.join();
+    assert(host.broadcasts.load() >= 3);  // 确认收不齐时按 round_retry_ms 重发
+
+    // 重新当选后，丢失的轮次重发后恢复
+    BecomeReadyLeader(&ri, 2, 2);
+    host.term = 2;
+    host.broadcasts = 0;
+    std::thread healer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(25));
+        host.delay_ms = 1;
+    });
+    assert(ri.WaitReadable(2000) == ReadIndex::Status::kOk);
+    assert(host.broadcasts.load() >= 2);
+    healer.join();
+    host.Join();
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    TestNotLeaderAndTermCommit();
+    TestBatchSharesRound();
+    TestStaleAckDoesNotConfirm();
+    TestWaitForApply();
+    TestLease();
+    TestStepDownAbortsAndRetry();
+    std::cout << "All ReadIndex tests passed!" << std::endl;
+    return 0;
+}
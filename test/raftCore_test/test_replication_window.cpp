@@ -0,0 +1,271 @@
+// test_replication_window.cpp
+// ReplicationWindow (ReplicationPipeline 的状态机)：linger 与满批、探测 / 流水线下的在途上限、
+// 回退后旧 generation 的乱序回复、拒绝后按 conflictTerm / conflictIndex 回退 next_index、
+// CopyEntries 一条也没拷出来时不空转、快照暂停
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+
+#include "replication_window.h"
+
+using raft::ReplicationReply;
+using raft::ReplicationWindow;
+using raft::ReplicationWindowConfig;
+using Action = raft::ReplicationWindow::Action;
+using ReplyResult = raft::ReplicationWindow::ReplyResult;
+using Clock = raft::ReplicationWindow::Clock;
+
+static const uint64_t kTerm = 5;
+
+static ReplicationWindowConfig MakeConfig(size_t batch, size_t inflight, int linger_us) {
+    ReplicationWindowConfig config;
+    config.max_batch_entries = batch;
+    config.max_inflight = inflight;
+    config.linger_us = linger_us;
+    return config;
+}
+
+static ReplicationReply Accept() {
+    ReplicationReply r;
+    r.ok = true;
+    r.success = true;
+    r.term = kTerm;
+    return r;
+}
+
+static ReplicationReply Reject(uint64_t conflict_term, uint64_t conflict_index) {
+    ReplicationReply r;
+    r.ok = true;
+    r.success = false;
+    r.term = kTerm;
+    r.conflict_term = conflict_term;
+    r.conflict_index = conflict_index;
+    return r;
+}
+
+// 领导人日志中各任期的最后一条索引
+static ReplicationWindow::LastIndexOfTerm LeaderTerms(std::map<uint64_t, uint64_t> terms) {
+    return [terms](uint64_t term) -> uint64_t {
+        auto it = terms.find(term);
+        return it == terms.end() ? 0 : it->second;
+    };
+}
+
+static ReplyResult Reply(ReplicationWindow& w, const ReplicationWindow::Batch& b, const ReplicationReply& r) {
+    return w.OnReply(b.generation, b.last_index, r, kTerm, LeaderTerms({}));
+}
+
+void TestLingerAndFullBatch() {
+    std::cout << "[Test] linger and full batch... ";
+    ReplicationWindow w(MakeConfig(4, 2, 1000));
+    Clock::time_point t0 = Clock::now();
+    w.Restart(1);
+
+    // Restart 后立即探测，不等 linger
+    assert(w.Next(t0, 1, 1).action == Action::kSend);
+    ReplicationWindow::Batch b = w.OnSent(1);
+    assert(b.prev_index == 0 && b.last_index == 1 && w.NextIndex() == 2);
+    assert(Reply(w, b, Accept()) == ReplyResult::kMatchAdvanced);
+    assert(w.MatchIndex() == 1 && !w.Probing());
+
+    // 没有新日志：无事可做
+    assert(w.Next(t0, 1, 1).action == Action::kIdle);
+
+    // 不满一批：等到 linger 到期
+    w.MarkPending(t0);
+    ReplicationWindow::Decision d = w.Next(t0, 1, 2);
+    assert(d.action == Action::kWaitUntil);
+    assert(d.deadline == t0 + std::chrono::microseconds(1000));
+    assert(w.Next(t0 + std::chrono::microseconds(999), 1, 2).action == Action::kWaitUntil);
+    assert(w.Next(d.deadline, 1, 2).action == Action::kSend);
+    w.OnSent(1);
+
+    // 攒满一批：不等 linger
+    w.MarkPending(t0);
+    assert(w.Next(t0, 1, 6).action == Action::kSend);
+    b = w.OnSent(4);
+    assert(b.prev_index == 2 && b.last_index == 6 && w.NextIndex() == 7);
+    std::cout << "PASSED" << std::endl;
+}
+
+void TestInflightLimits() {
+    std::cout << "[Test] in-flight limits... ";
+    ReplicationWindow w(MakeConfig(2, 3, 0));
+    Clock::time_point now = Clock::now();
+    w.Restart(1);
+
+    // 探测模式：最多 1 个在途
+    assert(w.Probing() && w.Window() == 1);
+    assert(w.Next(now, 1, 100).action == Action::kSend);
+    ReplicationWindow::Batch probe = w.OnSent(2);
+    assert(w.InflightCount() == 1);
+    assert(w.Next(now, 1, 100).action == Action::kIdle);
+
+    // 探测成功：窗口恢复为 max_inflight
+    assert(Reply(w, probe, Accept()) == ReplyResult::kMatchAdvanced);
+    assert(!w.Probing() && w.Window() == 3 && w.InflightCount() == 0);
+
+    ReplicationWindow::Batch batches[3];
+    for (int i = 0; i < 3; ++i) {
+        assert(w.Next(now, 1, 100).action == Action::kSend);
+        batches[i] = w.OnSent(2);
+    }
+    assert(w.InflightCount() == 3 && w.NextIndex() == 9);
+    assert(w.Next(now, 1, 100).action == Action::kIdle);  // 窗口已满
+
+    // 确认按累计语义弹出：后一个批次的确认同时确认前面的
+    assert(Reply(w, batches[1], Accept()) == ReplyResult::kMatchAdvanced);
+    assert(w.MatchIndex() == 6 && w.InflightCount() == 1);
+    assert(Reply(w, batches[0], Accept()) == ReplyResult::kAcked);  // 迟到的确认不回退 match
+    assert(w.MatchIndex() == 6 && w.InflightCount() == 1);
+    assert(w.Next(now, 1, 100).action == Action::kSend);
+
+    // max_inflight = 0 按 1 处理
+    ReplicationWindow clamped(MakeConfig(0, 0, 0));
+    clamped.Restart(1);
+    assert(clamped.Next(now, 1, 10).action == Action::kSend);
+    ReplicationWindow::Batch b = clamped.OnSent(1);
+    Reply(clamped, b, Accept());
+    assert(clamped.Window() == 1);
+    std::cout << "PASSED" << std::endl;
+}
+
+void TestOutOfOrderReplyAfterReset() {
+    std::cout << "[Test] out-of-order replies after a reset... ";
+    ReplicationWindow w(MakeConfig(2, 4, 0));
+    Clock::time_point now = Clock::now();
+    w.Restart(1);
+    ReplicationWindow::Batch probe = w.OnSent(2);
+    Reply(w, probe, Accept());
+
+    ReplicationWindow::Batch a = w.OnSent(2);  // 3..4
+    ReplicationWindow::Batch b = w.OnSent(2);  // 5..6
+    ReplicationWindow::Batch c = w.OnSent(2);  // 7..8
+    uint64_t old_generation = w.Generation();
+
+    // a 被拒绝 (follower 日志只到 2)：回退并进入新 generation
+    assert(w.OnReply(a.generation, a.last_index, Reject(0, 3), kTerm, LeaderTerms({})) == ReplyResult::kRewound);
+    assert(w.Generation() == old_generation + 1);
+    assert(w.NextIndex() == 3 && w.InflightCount() == 0 && w.Probing());
+    assert(w.Next(now, 1, 8).action == Action::kSend);  // 回退后立即重发
+    ReplicationWindow::Batch retry = w.OnSent(2);
+    assert(retry.generation == w.Generation() && retry.prev_index == 2);
+
+    // 旧 generation 的失败乱序到达：忽略，不再回退
+    assert(Reply(w, c, Reject(0, 3)) == ReplyResult::kStale);
+    ReplicationReply timeout;
+    assert(Reply(w, b, timeout) == ReplyResult::kStale);
+    assert(w.NextIndex() == 5 && w.InflightCount() == 1 && w.Probing());
+
+    // 旧 generation 的成功：follower 确实持有这些日志，match 前进，但不结束新 generation 的探测
+    assert(Reply(w, b, Accept()) == ReplyResult::kMatchAdvanced);
+    assert(w.MatchIndex() == 6 && w.Probing());
+    assert(w.InflightCount() == 0);  // retry (3..4) 已被 match 覆盖
+
+    // 更高任期：在途回复全部失效
+    w.OnSent(2);
+    ReplicationReply higher = Accept();
+    higher.term = kTerm + 1;
+    uint64_t gen = w.Generation();
+    assert(w.OnReply(gen, 8, higher, kTerm, LeaderTerms({})) == ReplyResult::kHigherTerm);
+    assert(w.Generation() == gen + 1 && w.InflightCount() == 0);
+    std::cout << "PASSED" << std::endl;
+}
+
+void TestRejectRewindsNextIndex() {
+    std::cout << "[Test] reject rewinds next_index... ";
+    Clock::time_point now = Clock::now();
+    // 领导人日志：1..3 任期 1，4..7 任期 3，8..10 任期 5
+    ReplicationWindow::LastIndexOfTerm leader = LeaderTerms({{1, 3}, {3, 7}, {5, 10}});
+
+    // follower 在冲突处的任期领导人也有：跳到领导人该任期最后一条之后
+    ReplicationWindow w(MakeConfig(16, 4, 0));
+    w.Restart(10);
+    ReplicationWindow::Batch b = w.OnSent(1);
+    assert(b.prev_index == 9 && b.last_index == 10);
+    assert(w.OnReply(b.generation, b.last_index, Reject(3, 5), kTerm, leader) == ReplyResult::kRewound);
+    assert(w.NextIndex() == 8 && w.Probing());
+    assert(w.Next(now, 1, 10).action == Action::kSend);
+
+    // 领导人没有该任期：跳到 follower 该任期的第一条
+    b = w.OnSent(3);
+    assert(w.OnReply(b.generation, b.last_index, Reject(2, 4), kTerm, leader) == ReplyResult::kRewound);
+    assert(w.NextIndex() == 4);
+
+    // follower 日志太短：跳到它的日志末尾之后
+    b = w.OnSent(7);
+    assert(w.OnReply(b.generation, b.last_index, Reject(0, 2), kTerm, leader) == ReplyResult::kRewound);
+    assert(w.NextIndex() == 2);
+
+    // 探测成功后 RPC 失败：回到 match + 1
+    b = w.OnSent(3);
+    assert(w.OnReply(b.generation, b.last_index, Accept(), kTerm, leader) == ReplyResult::kMatchAdvanced);
+    assert(w.MatchIndex() == 4 && !w.Probing());
+    b = w.OnSent(4);
+    w.OnSent(2);
+    ReplicationReply timeout;
+    assert(w.OnReply(b.generation, b.last_index, timeout, kTerm, leader) == ReplyResult::kRewound);
+    assert(w.NextIndex() == 5 && w.Probing() && w.InflightCount() == 0);
+
+    // 回退永远不低于 match + 1 (不重发已确认的日志)
+    b = w.OnSent(2);
+    assert(w.OnReply(b.generation, b.last_index, Reject(0, 1), kTerm, leader) == ReplyResult::kRewound);
+    assert(w.NextIndex() == 5);
+    std::cout << "PASSED" << std::endl;
+}
+
+void TestEmptyCopyDoesNotSpin() {
+    std::cout << "[Test] CopyEntries returning 0 does not spin... ";
+    ReplicationWindow w(MakeConfig(8, 4, 100));
+    Clock::time_point t0 = Clock::now();
+    w.Restart(1);
+    ReplicationWindow::Batch b = w.OnSent(1);
+    Reply(w, b, Accept());
+
+    // LastIndex 显示有新日志，但 CopyEntries 一条也没拷出来
+    w.MarkPending(t0);
+    Clock::time_point later = t0 + std::chrono::microseconds(100);
+    assert(w.Next(later, 1, 3).action == Action::kSend);
+    w.OnEmptyCopy();
+
+    // 之后无论过去多久都不再按 linger 重试，直到下一次 MarkPending
+    assert(w.Next(later, 1, 3).action == Action::kIdle);
+    assert(w.Next(later + std::chrono::microseconds(100), 1, 3).action == Action::kIdle);
+    assert(w.Next(later + std::chrono::seconds(10), 1, 3).action == Action::kIdle);
+    assert(w.NextIndex() == 2 && w.InflightCount() == 0);
+
+    // 日志被压缩导致的空复制：仍然要发现需要快照
+    ReplicationWindow::Decision d = w.Next(later, 5, 7);
+    assert(d.action == Action::kNeedSnapshot && w.PausedForSnapshot());
+    assert(w.Next(later, 5, 7).action == Action::kIdle);  // 快照期间暂停
+    w.ResetAfterSnapshot(4);
+    assert(!w.PausedForSnapshot() && w.MatchIndex() == 4 && w.NextIndex() == 5);
+    assert(w.Next(later, 5, 7).action == Action::kSend);
+    w.OnEmptyCopy();
+    assert(w.Next(later + std::chrono::seconds(1), 5, 7).action == Action::kIdle);
+
+    // 新日志到来：恢复
+    w.MarkPending(later);
+    assert(w.Next(later, 5, 8).action == Action::kWaitUntil);
+    assert(w.Next(later + std::chrono::microseconds(100), 5, 8).action == Action::kSend);
+    b = w.OnSent(4);
+    assert(b.prev_index == 4 && b.last_index == 8);
+
+    // Reset (例如回复触发的回退) 同样解除
+    w.OnEmptyCopy();
+    w.Reset(5);
+    assert(w.Next(later, 5, 8).action == Action::kSend);
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    TestLingerAndFullBatch();
+    TestInflightLimits();
+    TestOutOfOrderReplyAfterReset();
+    TestRejectRewindsNextIndex();
+    TestEmptyCopyDoesNotSpin();
+    std::cout << "All ReplicationWindow tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include "conn_balancer.h"
+
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using Clock = PoolSizer::Clock;
+using std::chrono::milliseconds;
+
+// P2C 永远不会选中两个候选里更重的那个：最重的连接永远不会被选中，最轻的被选中的概率约 2/n
+void test_pick_avoids_loaded() {
+    std::cout << "Test 1: P2C avoids the loaded connection... ";
+    std::vector<ConnectionLoad> loads(4);
+    loads[0].requests = 100;   // 卡住的连接：发送缓冲区满，请求越积越多
+    loads[1].requests = 3;
+    loads[2].requests = 3;
+    loads[3].requests = 0;
+    std::vector<int> picked(loads.size(), 0);
+    const int kRounds = 40000;
+    for (int i = 0; i < kRounds; ++i) {
+        ++picked[PickPowerOfTwo(loads.size(), [&](size_t idx) { return loads[idx]; })];
+    }
+    assert(picked[0] == 0);
+    // 最轻的连接只要被抽中就会胜出：P = 1 - C(3,2)/C(4,2) = 1/2
+    assert(picked[3] > kRounds * 45 / 100 && picked[3] < kRounds * 55 / 100);
+    assert(picked[1] > 0 && picked[2] > 0);   // 不是“全局最小”：其他连接也分到请求
+    std::cout << "PASS" << std::endl;
+}
+
+// 负载相同比字节数；断开的连接排在最后；单个连接直接返回
+void test_pick_tie_break() {
+    std::cout << "Test 2: Tie-break by bytes, disconnected last... ";
+    std::vector<ConnectionLoad> loads(2);
+    loads[0].requests = 2;
+    loads[0].bytes = 1 << 20;   // 两个大 Put 还没写完
+    loads[1].requests = 2;
+    loads[1].bytes = 256;
+    for (int i = 0; i < 1000; ++i) {
+        assert(PickPowerOfTwo(2, [&](size_t idx) { return loads[idx]; }) == 1);
+    }
+    loads[1].connected = false;
+    for (int i = 0; i < 1000; ++i) {
+        assert(PickPowerOfTwo(2, [&](size_t idx) { return loads[idx]; }) == 0);
+    }
+    assert(PickPowerOfTwo(1, [&](size_t idx) { return loads[idx]; }) == 0);
+    std::cout << "PASS" << std::endl;
+}
+
+// 多线程选路：线程局部随机数，无共享状态
+void test_pick_concurrent() {
+    std::cout << "Test 3: Concurrent picks stay in range... ";
+    std::vector<ConnectionLoad> loads(7);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 100000; ++i) {
+                size_t idx = PickPowerOfTwo(loads.size(), [&](size_t k) { return loads[k]; });
+                assert(idx < loads.size());
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    std::cout << "PASS" << std::endl;
+}
+
+// 并发度上升时逐个扩容到上限；下降后要持续 shrink_delay 才逐个缩容到下限
+void test_sizer() {
+    std::cout << "Test 4: Pool grows with concurrency, shrinks after a delay... ";
+    PoolSizer::Options options;
+    options.min_size = 2;
+    options.max_size = 6;
+    options.target_inflight = 8;
+    options.shrink_delay = milliseconds(1000);
+    PoolSizer sizer(options);
+    Clock::time_point now = Clock::now();
+
+    size_t size = 2;
+    for (int i = 0; i < 3; ++i) {
+        size = sizer.Observe(4, size, now);   // 并发度 4：2 个连接足够
+    }
+    assert(size == 2);
+
+    // 100 个并发调用：期望 ceil(100 / 8) = 13，受上限限制为 6，每次采样加一个
+    std::vector<size_t> steps;
+    for (int i = 0; i < 20; ++i) {
+        size_t next = sizer.Observe(100, size, now);
+        assert(next == size || next == size + 1);
+        size = next;
+        steps.push_back(size);
+    }
+    assert(size == 6 && steps.front() == 3);
+
+    // 负载回落：shrink_delay 之内不缩容
+    for (int i = 0; i < 20; ++i) {
+        size = sizer.Observe(1, size, now + milliseconds(10 * i));
+    }
+    assert(size == 6);
+    size = sizer.Observe(1, size, now + milliseconds(1200));
+    assert(size == 5);
+    size = sizer.Observe(1, size, now + milliseconds(1300));
+    assert(size == 5);   // 缩一个之后重新计时
+    for (int i = 2; i < 10; ++i) {
+        size = sizer.Observe(1, size, now + milliseconds(1200 * i));
+    }
+    assert(size == 2);   // 不低于下限
+
+    // 低于期望期间出现一次负载回升：计时作废
+    size = 4;
+    PoolSizer bursty(options);
+    for (int i = 0; i < 30; ++i) bursty.Observe(32, size, now);   // 并发度稳定在 32 附近 -> 期望 4
+    size = bursty.Observe(8, size, now);                          // 开始低于期望
+    size = bursty.Observe(64, size, now + milliseconds(500));     // 回升
+    size = bursty.Observe(8, size, now + milliseconds(1100));
+    assert(size >= 4);
+    std::cout << "PASS" << std::endl;
+}
+
+int main() {
+    test_pick_avoids_loaded();
+    test_pick_tie_break();
+    test_pick_concurrent();
+    test_sizer();
+    std::cout << "All ConnectionBalancer tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include "kv_router.h"
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// 不发请求的假连接：只记录自己属于哪个地址
+class FakeChannel : public google::protobuf::RpcChannel {
+public:
+    explicit FakeChannel(std::string addr) : addr(std::move(addr)) {}
+    void CallMethod(const google::protobuf::MethodDescriptor*, google::protobuf::RpcController*,
+                    const google::protobuf::Message*, google::protobuf::Message*,
+                    google::protobuf::Closure*) override {}
+    std::string addr;
+};
+
+static std::atomic<int> g_channels_created{0};
+
+static KvRouter::Options MakeOptions(int nodes) {
+    KvRouter::Options options;
+    for (int id = 1; id <= nodes; ++id) {
+        options.nodes[id] = "127.0.0.1:" + std::to_string(9000 + id);
+    }
+    options.channel_factory = [](const std::string& ip, uint16_t port) {
+        g_channels_created++;
+        return std::make_shared<FakeChannel>(ip + ":" + std::to_string(port));
+    };
+    return options;
+}
+
+static std::string AddrOf(const KvRouter::Route& route) {
+    return static_cast<FakeChannel*>(route.channel.get())->addr;
+}
+
+// 单组：领导人未知时选第一个副本，之后按 hint / 失败更新
+void test_leader_hint() {
+    std::cout << "Test 1: Leader hint & failover... ";
+    KvRouter router(MakeOptions(3));
+    KvRouter::Route route;
+    assert(router.Locate("k1", &route));
+    assert(route.group_id == 0 && route.node_id == 1 && AddrOf(route) == "127.0.0.1:9001");
+    assert(router.CachedLeader(0) == 1);
+
+    // NOT_LEADER 带回真正的领导人：下一次直接发过去，不再跳转
+    router.OnNotLeader(route, 3);
+    assert(router.Locate("k2", &route) && route.node_id == 3);
+
+    // 过期的 NOT_LEADER (针对节点 1 的旧请求) 不能覆盖新的缓存
+    KvRouter::Route stale = route;
+    stale.node_id = 1;
+    router.OnNotLeader(stale, 2);
+    assert(router.CachedLeader(0) == 3);
+
+    // 领导人不可达：轮到下一个副本 (回绕)
+    router.OnUnreachable(route);
+    assert(router.Locate("k3", &route) && route.node_id == 1);
+
+    // hint 为 0 (服务端也不知道) 或不是副本：换下一个
+    router.OnNotLeader(route, 0);
+    assert(router.CachedLeader(0) == 2);
+    assert(router.Locate("k4", &route));
+    router.OnNotLeader(route, 42);
+    assert(router.CachedLeader(0) == 3);
+    std::cout << "PASSED" << std::endl;
+}
+
+// 多组：按区间表路由，各组独立缓存领导人
+void test_range_routing() {
+    std::cout << "Test 2: Range routing... ";
+    raft::RangeTable table;
+    raft::RangeDescriptor left, right;
+    left.group_id = 1;
+    left.end_key = "m";
+    left.epoch = 3;
+    left.replicas = {1, 2, 3};
+    right.group_id = 2;
+    right.start_key = "m";
+    right.epoch = 5;
+    right.replicas = {3, 4, 5};
+    assert(table.Update(left) == raft::RangeTable::Status::kOk);
+    assert(table.Update(right) == raft::RangeTable::Status::kOk);
+
+    KvRouter router(MakeOptions(5), &table);
+    KvRouter::Route route;
+    assert(router.Locate("apple", &route) && route.group_id == 1 && route.epoch == 3 && route.node_id == 1);
+    assert(router.Locate("zebra", &route) && route.group_id == 2 && route.epoch == 5 && route.node_id == 3);
+
+    router.OnNotLeader(route, 5);
+    assert(router.CachedLeader(2) == 5 && router.CachedLeader(1) == 1);
+    // 不属于该组副本的 hint 不采用 (节点 1 不在 group 2 中)
+    assert(router.LocateGroup(2, &route));
+    router.OnNotLeader(route, 1);
+    assert(router.CachedLeader(2) == 3);
+
+    assert(!router.LocateGroup(9, &route));
+    std::cout << "PASSED" << std::endl;
+}
+
+// 在线节点变化：下线节点的连接与领导人缓存被丢弃，已有连接复用
+void test_live_endpoints() {
+    std::cout << "Test 3: Live endpoint updates... ";
+    g_channels_created = 0;
+    KvRouter router(MakeOptions(3));
+    assert(g_channels_created == 3);
+    KvRouter::Route route;
+    router.Locate("k", &route);
+    router.OnNotLeader(route, 2);
+    assert(router.CachedLeader(0) == 2);
+    std::shared_ptr<google::protobuf::RpcChannel> ch1 = route.channel;
+
+    router.UpdateLiveEndpoints({"127.0.0.1:9001", "127.0.0.1:9003", "10.0.0.1:1"});
+    assert(router.CachedLeader(0) == -1);
+    assert(g_channels_created == 3);  // 没有新建连接
+    assert(router.Locate("k", &route) && route.node_id == 1 && route.channel == ch1);
+
+    router.UpdateLiveEndpoints({"127.0.0.1:9002"});
+    assert(g_channels_created == 4);  // 节点 2 重新上线，新建连接
+    assert(router.Locate("k", &route) && route.node_id == 2);
+    router.OnUnreachable(route);
+    assert(router.Locate("k", &route) && route.node_id == 2);  // 唯一在线的副本，只能再试它
+
+    router.UpdateLiveEndpoints({"10.0.0.1:1"});
+    assert(!router.Locate("k", &route));  // 没有在线副本
+    std::cout << "PASSED" << std::endl;
+}
+
+// 并发：查找与更新交错，路由始终指向在线的副本
+void test_concurrent() {
+    std::cout << "Test 4: Concurrent locate & update... ";
+    KvRouter router(MakeOptions(3));
+    std::atomic<bool> stop{false};
+    std::atomic<bool> bad{false};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&]() {
+            while (!stop) {
+                KvRouter::Route route;
+                if (router.Locate("k", &route)) {
+                    if (!route.channel || route.node_id < 1 || route.node_id > 3) bad = true;
+                    if (route.node_id == 3) router.OnNotLeader(route, 1);
+                }
+            }
+        });
+    }
+    for (int i = 0; i < 2000; ++i) {
+        if (i % 2) {
+            router.UpdateLiveEndpoints({"127.0.0.1:9002", "127.0.0.1:9003"});
+        } else {
+            router.UpdateLiveEndpoints({"127.0.0.1:9001", "127.0.0.1:9002", "127.0.0.1:9003"});
+        }
+    }
+    stop = true;
+    for (auto& t : readers) t.join();
+    assert(!bad);
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    test_leader_hint();
+    test_range_routing();
+    test_live_endpoints();
+    test_concurrent();
+    std::cout << "All KvRouter tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "rpcclient.h"
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// 在途请求表：插入 / 取出 / 超时收集的基本语义
+void test_insert_take() {
+    std::cout << "Test 1: Insert & Take... ";
+    PendingRequestTable table;
+    for (uint64_t id = 1; id <= 200; ++id) {
+        auto ctx = std::make_shared<PendingRpcContext>();
+        ctx->request_id = id;
+        table.Insert(id, ctx);
+    }
+    assert(table.Size() == 200);
+
+    auto ctx = table.Take(42);
+    assert(ctx && ctx->request_id == 42);
+    // 同一个请求只能被取走一次 (响应 / 超时 / 发送失败三条路径靠这个互斥)
+    assert(table.Take(42) == nullptr);
+    assert(table.Take(1000) == nullptr);
+    assert(table.Size() == 199);
+    std::cout << "PASS" << std::endl;
+}
+
+void test_collect_expired() {
+    std::cout << "Test 2: Collect Expired... ";
+    PendingRequestTable table;
+    auto now = std::chrono::steady_clock::now();
+    for (uint64_t id = 1; id <= 100; ++id) {
+        auto ctx = std::make_shared<PendingRpcContext>();
+        ctx->request_id = id;
+        // 偶数已过期，奇数还有 1 分钟
+        ctx->deadline = (id % 2 == 0) ? now - std::chrono::milliseconds(1) : now + std::chrono::minutes(1);
+        table.Insert(id, ctx);
+    }
+
+    std::vector<uint64_t> expired;
+    table.CollectExpired(now, &expired);
+    assert(expired.size() == 50);
+    for (uint64_t id : expired) {
+        assert(id % 2 == 0);
+    }
+    // 收集不移除
+    assert(table.Size() == 100);
+    std::cout << "PASS" << std::endl;
+}
+
+// 多个线程同时竞争同一批请求，每个请求恰好被一个线程取走
+void test_concurrent_take_once() {
+    std::cout << "Test 3: Concurrent Take Exactly Once... ";
+    const uint64_t kRequests = 20000;
+    const int kThreads = 4;
+    PendingRequestTable table;
+    for (uint64_t id = 1; id <= kRequests; ++id) {
+        auto ctx = std::make_shared<PendingRpcContext>();
+        ctx->request_id = id;
+        table.Insert(id, ctx);
+    }
+
+    std::atomic<uint64_t> taken{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&]() {
+            for (uint64_t id = 1; id <= kRequests; ++id) {
+                if (table.Take(id)) {
+                    taken.fetch_add(1);
+                }
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    assert(taken.load() == kRequests);
+    assert(table.Size() == 0);
+    std::cout << "PASS" << std::endl;
+}
+
+int main() {
+    test_insert_take();
+    test_collect_expired();
+    test_concurrent_take_once();
+    std::cout << "All pending table tests passed!" << std::endl;
+    return 0;
+}
@@ -9,6 +9,8 @@
 // 辅助类：暴露 protected/private 方法
 class RpcProviderTester : public RpcProvider {
 public:
+    using RequestFrame = RpcProvider::RequestFrame;
+
     RpcProviderTester(const Config& c) : RpcProvider(c) {}
 
     // 公开 TryParseMessage 用于测试
@@ -17,7 +19,13 @@ public:
                                std::string& service_name,
                                std::string& method_name,
                                std::string& args_str) {
-        return TryParseMessage(buffer, header_size, service_name, method_name, args_str);
+        uint64_t request_id = 0;
+        return TryParseMessage(buffer, header_size, service_name, method_name, args_str, request_id);
+    }
+
+    // 公开零拷贝的 PeekRequest
+    bool PublicPeekRequest(muduo::net::Buffer* buffer, RequestFrame& frame) {
+        return PeekRequest(buffer, frame);
     }
 };
 
@@ -136,9 +144,42 @@ void test_sticky_packets() {
     std::cout << "PASS" << std::endl;
 }
 
+// 零拷贝视图：PeekRequest 不消费数据，args 直接指向 Buffer 内部
+void test_peek_zero_copy() {
+    std::cout << "Test 4: Peek Without Copy... ";
+    RpcProvider::Config config; config.port = 1234;
+    RpcProviderTester tester(config);
+    muduo::net::Buffer buffer;
+
+    AppendRpcRequestToBuffer(&buffer, "ServiceA", "MethodA", "ArgsA");
+    AppendRpcRequestToBuffer(&buffer, "ServiceB", "MethodB", "ArgsB");
+    size_t total = buffer.readableBytes();
+
+    RpcProviderTester::RequestFrame frame;
+    assert(tester.PublicPeekRequest(&buffer, frame));
+    assert(frame.header.service_name() == "ServiceA");
+    assert(std::string(frame.args_data, frame.args_size) == "ArgsA");
+    // 指向 Buffer 内部，且没有移动读指针
+    assert(frame.args_data == buffer.peek() + frame.frame_size - frame.args_size);
+    assert(buffer.readableBytes() == total);
+
+    // 调用方消费掉第一帧后，同一个 frame 复用于第二帧
+    buffer.retrieve(frame.frame_size);
+    assert(tester.PublicPeekRequest(&buffer, frame));
+    assert(frame.header.method_name() == "MethodB");
+    assert(std::string(frame.args_data, frame.args_size) == "ArgsB");
+    buffer.retrieve(frame.frame_size);
+    assert(buffer.readableBytes() == 0);
+
+    // 半包：不解析出视图
+    assert(!tester.PublicPeekRequest(&buffer, frame));
+    std::cout << "PASS" << std::endl;
+}
+
 int main() {
     test_normal_packet();
     test_partial_packet();
     test_sticky_packets();
+    test_peek_zero_copy();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "service_cache.h"
+
+#include "epoch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using Result = ServiceDiscoveryCache::Result;
+using Clock = ServiceDiscoveryCache::Clock;
+
+// 正缓存 / 负缓存 / 过期的基本语义
+void test_lookup() {
+    std::cout << "Test 1: Hit / negative / expiry... ";
+    ServiceDiscoveryCache cache;
+    std::vector<std::string> eps;
+    assert(cache.Lookup("kv", &eps) == Result::kMiss);
+
+    cache.Update("kv", {"127.0.0.1:8001", "127.0.0.1:8002"});
+    assert(cache.Lookup("kv", &eps) == Result::kHit);
+    assert(eps.size() == 2 && eps[0] == "127.0.0.1:8001");
+
+    // 服务存在但没有实例：仍是正缓存 (由 Watch 刷新，不过期)
+    cache.Update("empty", {});
+    eps = {"stale"};
+    assert(cache.Lookup("empty", &eps) == Result::kHit && eps.empty());
+
+    // 负缓存在 until 之前命中，之后视为未命中
+    Clock::time_point now = Clock::now();
+    cache.MarkMissing("ghost", now + std::chrono::milliseconds(100));
+    assert(cache.Lookup("ghost", &eps, now) == Result::kNegative);
+    assert(cache.Lookup("ghost", &eps, now + std::chrono::milliseconds(99)) == Result::kNegative);
+    assert(cache.Lookup("ghost", &eps, now + std::chrono::milliseconds(100)) == Result::kMiss);
+
+    // 查询失败不覆盖已有的正缓存
+    cache.MarkMissing("kv", now + std::chrono::seconds(10));
+    assert(cache.Lookup("kv", &eps, now) == Result::kHit && eps.size() == 2);
+
+    // 负缓存被新的正结果替换
+    cache.Update("ghost", {"10.0.0.1:9000"});
+    assert(cache.Lookup("ghost", &eps, now) == Result::kHit && eps.size() == 1);
+    std::cout << "PASSED" << std::endl;
+}
+
+void test_services_and_erase() {
+    std::cout << "Test 2: Services & Erase... ";
+    ServiceDiscoveryCache cache;
+    cache.Update("a", {"x:1"});
+    cache.Update("b", {"y:1"});
+    cache.MarkMissing("c", Clock::now() + std::chrono::seconds(1));
+    std::vector<std::string> services = cache.Services();
+    std::sort(services.begin(), services.end());
+    assert((services == std::vector<std::string>{"a", "b", "c"}));
+
+    cache.Erase("b");
+    cache.Erase("not-there");
+    std::vector<std::string> eps;
+    assert(cache.Lookup("b", &eps) == Result::kMiss);
+    assert(cache.Services().size() == 2);
+    std::cout << "PASSED" << std::endl;
+}
+
+// 并发：读方始终看到某一次完整写入的列表 (不会读到半更新的状态或已释放的快照)
+void test_concurrent() {
+    std::cout << "Test 3: Concurrent readers & writer... ";
+    ServiceDiscoveryCache cache;
+    cache.Update("kv", {"n:0", "n:0", "n:0"});
+    std::atomic<bool> stop{false};
+    std::atomic<bool> bad{false};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&]() {
+            std::vector<std::string> eps;
+            while (!stop) {
+                if (cache.Lookup("kv", &eps) != Result::kHit || eps.size() != 3 ||
+                    eps[0] != eps[1] || eps[1] != eps[2]) {
+                    bad = true;
+                }
+                cache.Services();
+            }
+        });
+    }
+    for (int i = 1; i <= 5000; ++i) {
+        std::string ep = "n:" + std::to_string(i);
+        cache.Update("kv", {ep, ep, ep});
+        cache.MarkMissing("other" + std::to_string(i % 7), Clock::now());
+    }
+    stop = true;
+    for (auto& t : readers) t.join();
+    assert(!bad);
+    EpochManager::GetInstance().flush();
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    test_lookup();
+    test_services_and_erase();
+    test_concurrent();
+    std::cout << "All ServiceDiscoveryCache tests passed!" << std::endl;
+    return 0;
+}
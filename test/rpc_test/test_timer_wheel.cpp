@@ -0,0 +1,140 @@
+#include "timer_wheel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <vector>
+
+using Clock = TimerWheel::Clock;
+using std::chrono::milliseconds;
+
+static std::set<uint64_t> Ids(const std::vector<TimerWheel::Timer>& timers) {
+    std::set<uint64_t> ids;
+    for (const auto& t : timers) {
+        ids.insert(t.id);
+    }
+    return ids;
+}
+
+// 不早于 deadline 触发，最多晚一个 tick
+void test_fire_order() {
+    std::cout << "Test 1: Fires at deadline, never early... ";
+    Clock::time_point origin = Clock::now();
+    TimerWheel wheel(milliseconds(5), 64, origin);
+    wheel.Schedule(1, 0, origin + milliseconds(12));
+    wheel.Schedule(2, 7, origin + milliseconds(15));
+    wheel.Schedule(3, 0, origin + milliseconds(100));
+    assert(wheel.Size() == 3);
+
+    std::vector<TimerWheel::Timer> expired;
+    assert(wheel.Advance(origin + milliseconds(11), &expired) && expired.empty());
+    wheel.Advance(origin + milliseconds(14), &expired);
+    assert(expired.empty());  // 12ms 向上取整到第 3 个 tick (15ms)
+    wheel.Advance(origin + milliseconds(15), &expired);
+    assert(Ids(expired) == std::set<uint64_t>({1, 2}));
+    for (const auto& t : expired) {
+        assert(t.tag == (t.id == 2 ? 7u : 0u));
+    }
+    expired.clear();
+    wheel.Advance(origin + milliseconds(99), &expired);
+    assert(expired.empty() && wheel.Size() == 1);
+    wheel.Advance(origin + milliseconds(100), &expired);
+    assert(Ids(expired) == std::set<uint64_t>({3}) && wheel.Size() == 0);
+    std::cout << "PASS" << std::endl;
+}
+
+// 超过一圈的定时器按圈数保留；已经过期的 deadline 在下一个 tick 触发
+void test_rounds_and_late() {
+    std::cout << "Test 2: Multi-round timers and past deadlines... ";
+    Clock::time_point origin = Clock::now();
+    TimerWheel wheel(milliseconds(1), 16, origin);  // 一圈 16ms
+    wheel.Schedule(1, 0, origin + milliseconds(5));
+    wheel.Schedule(2, 0, origin + milliseconds(5 + 16));
+    wheel.Schedule(3, 0, origin + milliseconds(5 + 64));
+
+    std::vector<TimerWheel::Timer> expired;
+    wheel.Advance(origin + milliseconds(5), &expired);
+    assert(Ids(expired) == std::set<uint64_t>({1}));
+    expired.clear();
+    wheel.Advance(origin + milliseconds(20), &expired);
+    assert(expired.empty());
+    wheel.Advance(origin + milliseconds(21), &expired);
+    assert(Ids(expired) == std::set<uint64_t>({2}));
+    expired.clear();
+
+    wheel.Schedule(4, 0, origin);  // 发起时就已经过期
+    wheel.Advance(origin + milliseconds(22), &expired);
+    assert(Ids(expired) == std::set<uint64_t>({4}));
+    expired.clear();
+
+    // 检查线程停顿了好几圈：一次推进取出所有到期的
+    wheel.Schedule(5, 0, origin + milliseconds(30));
+    wheel.Advance(origin + milliseconds(200), &expired);
+    assert(Ids(expired) == std::set<uint64_t>({3, 5}) && wheel.Size() == 0);
+    std::cout << "PASS" << std::endl;
+}
+
+// 多个线程一边 Schedule，检查线程一边推进：每个定时器恰好触发一次且不早于 deadline
+void test_concurrent() {
+    std::cout << "Test 3: Concurrent schedule / advance... ";
+    TimerWheel wheel(milliseconds(1), 32);
+    const int kThreads = 4;
+    const uint64_t kPerThread = 5000;
+    std::vector<Clock::time_point> deadlines(kThreads * kPerThread + 1);
+    std::atomic<int> producers{kThreads};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            for (uint64_t i = 0; i < kPerThread; ++i) {
+                uint64_t id = t * kPerThread + i + 1;
+                deadlines[id] = Clock::now() + milliseconds(i % 50);
+                wheel.Schedule(id, 0, deadlines[id]);
+            }
+            producers.fetch_sub(1);
+        });
+    }
+
+    std::vector<int> fired(deadlines.size(), 0);
+    std::atomic<bool> early{false};
+    std::vector<TimerWheel::Timer> expired;
+    while (producers.load() > 0 || wheel.Size() > 0) {
+        std::this_thread::sleep_for(milliseconds(1));
+        Clock::time_point now = Clock::now();
+        expired.clear();
+        wheel.Advance(now, &expired);
+        for (const auto& timer : expired) {
+            ++fired[timer.id];
+            if (deadlines[timer.id] > now) {
+                early = true;
+            }
+        }
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    assert(!early);
+    for (size_t id = 1; id < fired.size(); ++id) {
+        assert(fired[id] == 1);
+    }
+
+    // 推进互斥：另一个线程在推进时直接返回
+    std::vector<TimerWheel::Timer> a, b;
+    std::thread other([&] {
+        for (int i = 0; i < 1000; ++i) wheel.Advance(Clock::now(), &a);
+    });
+    for (int i = 0; i < 1000; ++i) wheel.Advance(Clock::now(), &b);
+    other.join();
+    assert(a.empty() && b.empty());
+    std::cout << "PASS" << std::endl;
+}
+
+int main() {
+    test_fire_order();
+    test_rounds_and_late();
+    test_concurrent();
+    std::cout << "All TimerWheel tests passed!" << std::endl;
+    return 0;
+}
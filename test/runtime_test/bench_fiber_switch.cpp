@@ -0,0 +1,39 @@
+// bench_fiber_switch.cpp
+// 协程切换延迟微基准：单线程内 resume / yield 往返，比较汇编后端与 ucontext 后端
+// (编译时加 -DMONSOON_FIBER_UCONTEXT 得到 ucontext 对照组)
+#include "fiber.h"
+
+#include <chrono>
+#include <iostream>
+
+static const int kRounds = 5000000;
+
+int main() {
+    monsoon::Fiber::GetThis(); // 初始化线程主协程
+
+    long counter = 0;
+    // run_in_scheduler = false：直接与线程主协程互相切换，不依赖调度器
+    monsoon::Fiber::ptr fiber(new monsoon::Fiber([&counter]() {
+        while (true) {
+            ++counter;
+            monsoon::Fiber::GetThis()->yield();
+        }
+    }, 0, false));
+
+    // 预热：触发栈的缺页
+    for (int i = 0; i < 1000; ++i) {
+        fiber->resume();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRounds; ++i) {
+        fiber->resume();
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    // 每轮 resume + yield 是两次切换
+    std::cout << "Fiber switch benchmark (backend: " << monsoon::Fiber::ContextBackend() << ")" << std::endl;
+    std::cout << "  rounds          : " << kRounds << " (counter=" << counter << ")" << std::endl;
+    std::cout << "  per switch      : " << ns / (kRounds * 2.0) << " ns" << std::endl;
+    return 0;
+}
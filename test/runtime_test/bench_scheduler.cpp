@@ -0,0 +1,69 @@
+// bench_scheduler.cpp
+// 调度器微基准：一百万个短协程任务 (外部提交 / 调度线程内派生两种负载)
+#include "fiber.h"
+#include "scheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+static const int kTasks = 1000000;
+static const int kThreads = 4;
+
+static void wait_done(const std::atomic<int>& done, int expected) {
+    while (done.load(std::memory_order_acquire) < expected) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// 负载 1：调度器外的线程提交全部任务 (走信箱，Round-Robin 分散到各线程)
+static double bench_external_submit() {
+    monsoon::Scheduler sc(kThreads, false, "bench_external");
+    sc.start();
+    std::atomic<int> done{0};
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kTasks; ++i) {
+        sc.schedule([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+    }
+    wait_done(done, kTasks);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    sc.stop();
+    return kTasks / seconds / 1e6;
+}
+
+// 负载 2：一个根任务在调度线程内派生全部子任务 (全部进入同一个窃取队列，其余线程靠窃取分担)
+static double bench_spawn_and_steal() {
+    monsoon::Scheduler sc(kThreads, false, "bench_steal");
+    sc.start();
+    std::atomic<int> done{0};
+
+    auto start = std::chrono::steady_clock::now();
+    sc.schedule([&done]() {
+        monsoon::Scheduler* self = monsoon::Scheduler::GetThisScheduler();
+        for (int i = 0; i < kTasks; ++i) {
+            self->schedule([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+        }
+    });
+    wait_done(done, kTasks);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    sc.stop();
+    return kTasks / seconds / 1e6;
+}
+
+int main() {
+    double external = bench_external_submit();
+    double spawn = bench_spawn_and_steal();
+
+    std::cout << "Scheduler benchmark (" << kTasks << " short tasks, " << kThreads << " threads)" << std::endl;
+    std::cout << "  external submit : " << external << " Mtasks/s" << std::endl;
+    std::cout << "  spawn + steal   : " << spawn << " Mtasks/s" << std::endl;
+
+    monsoon::Fiber::PoolStats stats = monsoon::Fiber::GetPoolStats();
+    std::cout << "  fiber pool      : hits=" << stats.fiber_hits << " misses=" << stats.fiber_misses
+              << ", stack hits=" << stats.stack_hits << " misses=" << stats.stack_misses << std::endl;
+    return 0;
+}
@@ -0,0 +1,156 @@
+// test_fd_table.cpp
+// FdTable：段边界 (63/64、191/192、INT_MAX) 的定位、段分配之前 get() 为空、
+// 多线程同时 getOrCreate 同一个新段时只发布一份、元素地址稳定、init 只在发布的那份上运行
+#include <atomic>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "fd_table.h"
+
+using monsoon::FdTable;
+
+struct Slot {
+    int fd = -1;
+    int inits = 0;
+    std::atomic<int> value{0};
+};
+
+static void check_locate(size_t idx, size_t want_seg, size_t want_off) {
+    size_t seg = 0, off = 0;
+    FdTable<Slot>::locate(idx, seg, off);
+    assert(seg == want_seg);
+    assert(off == want_off);
+    assert(seg < FdTable<Slot>::kMaxSegments);
+    assert(off < FdTable<Slot>::segmentSize(seg));
+    assert(FdTable<Slot>::segmentStart(seg) + off == idx);
+}
+
+static void test_locate_boundaries() {
+    std::cout << "[Test] locate at segment boundaries... ";
+    check_locate(0, 0, 0);
+    check_locate(63, 0, 63);
+    check_locate(64, 1, 0);
+    check_locate(191, 1, 127);
+    check_locate(192, 2, 0);
+    check_locate(447, 2, 255);
+    check_locate(448, 3, 0);
+
+    // 最后一段：起点 64 * (2^25 - 1) = 2^31 - 64，INT_MAX 是其中第 63 个槽
+    check_locate((size_t)INT_MAX, FdTable<Slot>::kMaxSegments - 1, 63);
+    assert(FdTable<Slot>::segmentStart(FdTable<Slot>::kMaxSegments - 1) == (size_t)INT_MAX - 63);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void test_get_before_create() {
+    std::cout << "[Test] get() before the segment exists... ";
+    FdTable<Slot> table;
+    assert(table.get(-1) == nullptr);
+    assert(table.getOrCreate(-1) == nullptr);
+    assert(table.get(0) == nullptr);
+    assert(table.get(INT_MAX) == nullptr);  // 只定位不分配
+
+    Slot *s63 = table.getOrCreate(63, [](Slot &s, int fd) { s.fd = fd; });
+    assert(s63 && s63->fd == 63);
+    assert(table.get(0) == s63 - 63);  // 同一段
+    assert(table.get(0)->fd == 0);
+    assert(table.get(64) == nullptr);  // 下一段仍未分配
+
+    Slot *s64 = table.getOrCreate(64, [](Slot &s, int fd) { s.fd = fd; });
+    assert(s64 && s64->fd == 64);
+    assert(table.get(191) == s64 + 127 && table.get(191)->fd == 191);
+    assert(table.get(192) == nullptr);
+
+    // 已分配的段不再调用 init
+    Slot *again = table.getOrCreate(100, [](Slot &s, int) { ++s.inits; });
+    assert(again == table.get(100));
+    assert(again->inits == 0 && again->fd == 100);
+
+    // forEach 只访问已分配的两段
+    size_t visited = 0;
+    table.forEach([&visited](Slot &s, int fd) {
+        assert(s.fd == fd);
+        ++visited;
+    });
+    assert(visited == FdTable<Slot>::segmentSize(0) + FdTable<Slot>::segmentSize(1));
+    std::cout << "PASSED" << std::endl;
+}
+
+static void test_concurrent_create() {
+    std::cout << "[Test] concurrent getOrCreate on a fresh segment... ";
+    const int kThreads = 8;
+    const int kFd = 300;  // 第 2 段 [192, 448)
+    const size_t kSegSize = FdTable<Slot>::segmentSize(2);
+    const int kFirst = (int)FdTable<Slot>::segmentStart(2);
+
+    for (int round = 0; round < 200; ++round) {
+        FdTable<Slot> table;
+        std::atomic<int> ready{0};
+        std::atomic<bool> go{false};
+        std::mutex init_mutex;
+        std::vector<Slot *> inited;  // 所有被 init 过的元素地址
+        std::vector<Slot *> got(kThreads, nullptr);
+
+        std::vector<std::thread> workers;
+        for (int t = 0; t < kThreads; ++t) {
+            workers.emplace_back([&, t]() {
+                ++ready;
+                while (!go.load(std::memory_order_acquire)) {
+                }
+                // 每个线程取段里不同的槽，init 记录下它碰过的地址
+                int fd = kFd + t;
+                got[t] = table.getOrCreate(fd, [&](Slot &s, int slot_fd) {
+                    s.fd = slot_fd;
+                    ++s.inits;
+                    {
+                        std::lock_guard<std::mutex> lock(init_mutex);
+                        inited.push_back(&s);
+                    }
+                    // 拉长初始化窗口：其他线程在段发布之前到达
+                    std::this_thread::yield();
+                });
+                got[t]->value.fetch_add(1);
+            });
+        }
+        while (ready.load() != kThreads) {
+        }
+        go.store(true, std::memory_order_release);
+        for (auto &w : workers) w.join();
+
+        // 只发布了一份：所有线程拿到的槽都在同一段里，与 get() 一致
+        Slot *base = table.get(kFirst);
+        assert(base != nullptr);
+        for (int t = 0; t < kThreads; ++t) {
+            assert(got[t] == base + (kFd + t - kFirst));
+            assert(table.get(kFd + t) == got[t]);
+            assert(got[t]->fd == kFd + t && got[t]->value.load() == 1);
+        }
+
+        // init 恰好在发布的那份上把每个元素跑了一次
+        assert(inited.size() == kSegSize);
+        for (Slot *s : inited) {
+            assert(s >= base && s < base + kSegSize);
+            assert(s->inits == 1);
+        }
+
+        // 其他段增长之后，已返回的地址不变
+        Slot *far = table.getOrCreate(5000);
+        assert(far != nullptr);
+        for (int t = 0; t < kThreads; ++t) {
+            assert(table.get(kFd + t) == got[t]);
+        }
+    }
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    test_locate_boundaries();
+    test_get_before_create();
+    test_concurrent_create();
+    std::cout << "All FdTable tests passed." << std::endl;
+    return 0;
+}
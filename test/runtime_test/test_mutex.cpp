@@ -0,0 +1,176 @@
+// test_mutex.cpp
+// 锁原语：AdaptiveMutex / CASLock 的互斥性与 try_lock、SeqLock 读到的快照总是来自同一次写入、
+// FiberMutex 在调度器协程与普通线程混用时的互斥与 FIFO 移交
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "fiber.h"
+#include "mutex.h"
+#include "scheduler.h"
+
+// threads 个线程各加 iters 次；inside 检查同一时刻只有一个持有者
+template <class MutexT>
+static void check_exclusive(MutexT &mutex, int threads, int iters) {
+    int64_t counter = 0;
+    std::atomic<int> inside{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            for (int i = 0; i < iters; ++i) {
+                typename MutexT::Lock lock(mutex);
+                assert(inside.fetch_add(1) == 0);
+                ++counter;
+                inside.fetch_sub(1);
+            }
+        });
+    }
+    for (auto &w : workers) w.join();
+    assert(counter == static_cast<int64_t>(threads) * iters);
+}
+
+static void test_adaptive_mutex() {
+    std::cout << "[Test] AdaptiveMutex... ";
+    monsoon::AdaptiveMutex mutex;
+    assert(mutex.try_lock());
+    assert(!mutex.try_lock());
+    mutex.unlock();
+    check_exclusive(mutex, 8, 20000);
+
+    // 长临界区：等待者放弃自旋、在 futex 上睡眠，unlock 后被唤醒
+    std::atomic<bool> acquired{false};
+    mutex.lock();
+    std::thread waiter([&]() {
+        monsoon::AdaptiveMutex::Lock lock(mutex);
+        acquired = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    assert(!acquired);
+    mutex.unlock();
+    waiter.join();
+    assert(acquired);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void test_cas_lock() {
+    std::cout << "[Test] CASLock with backoff... ";
+    monsoon::CASLock lock;
+    check_exclusive(lock, 4, 20000);
+    std::cout << "PASSED" << std::endl;
+}
+
+struct Meta {
+    uint64_t term;
+    int32_t leader_id;
+    uint64_t check;  // = term * 31 + leader_id，读者据此判断是否读到撕裂的值
+};
+
+static void test_seqlock() {
+    std::cout << "[Test] SeqLock... ";
+    monsoon::SeqLock<Meta> meta(Meta{1, 2, 1 * 31 + 2});
+    Meta m = meta.load();
+    assert(m.term == 1 && m.leader_id == 2 && meta.version() == 0);
+    meta.store(Meta{3, 4, 3 * 31 + 4});
+    assert(meta.load().term == 3 && meta.version() == 1);
+
+    // 两个写者用 update 递增 term，四个读者持续检查快照的一致性与单调性
+    const int kWrites = 20000;
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; ++r) {
+        readers.emplace_back([&]() {
+            uint64_t last = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                Meta v = meta.load();
+                assert(v.check == v.term * 31 + static_cast<uint64_t>(v.leader_id));
+                assert(v.term >= last);
+                last = v.term;
+            }
+        });
+    }
+    std::vector<std::thread> writers;
+    for (int w = 0; w < 2; ++w) {
+        writers.emplace_back([&, w]() {
+            for (int i = 0; i < kWrites; ++i) {
+                meta.update([w](Meta &v) {
+                    v.term += 1;
+                    v.leader_id = w;
+                    v.check = v.term * 31 + static_cast<uint64_t>(v.leader_id);
+                });
+            }
+        });
+    }
+    for (auto &t : writers) t.join();
+    stop = true;
+    for (auto &t : readers) t.join();
+    assert(meta.load().term == 3 + 2 * kWrites);
+    assert(meta.version() == 1 + 2 * kWrites);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void test_fiber_mutex() {
+    std::cout << "[Test] FiberMutex in scheduler fibers and plain threads... ";
+    const int kFibers = 200;
+    const int kIters = 200;
+    monsoon::FiberMutex mutex;
+    int64_t counter = 0;
+    std::atomic<int> inside{0};
+    std::atomic<int> done{0};
+    auto critical = [&]() {
+        monsoon::FiberMutex::Lock lock(mutex);
+        assert(inside.fetch_add(1) == 0);
+        ++counter;
+        for (int spin = 0; spin < 50; ++spin) monsoon::CpuRelax();  // 拉长临界区，制造竞争
+        inside.fetch_sub(1);
+    };
+
+    monsoon::Scheduler sc(4, false, "test_fiber_mutex");
+    sc.start();
+    for (int f = 0; f < kFibers; ++f) {
+        sc.schedule([&]() {
+            for (int i = 0; i < kIters; ++i) critical();
+            done.fetch_add(1);
+        });
+    }
+    // 调度器外的线程同时争用：在信号量上等待，不影响协程
+    std::thread outsider([&]() {
+        for (int i = 0; i < kIters * 10; ++i) critical();
+    });
+    outsider.join();
+    while (done.load() < kFibers) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    sc.stop();
+    assert(counter == static_cast<int64_t>(kFibers) * kIters + kIters * 10);
+
+    // 持锁期间同一调度线程上的其他协程照常运行 (Mutex 会把整个线程卡住)
+    monsoon::Scheduler single(1, false, "test_fiber_mutex_yield");
+    single.start();
+    std::atomic<bool> other_ran{false};
+    std::atomic<bool> got_lock{false};
+    mutex.lock();  // 调度器外的线程持有
+    single.schedule([&]() {
+        monsoon::FiberMutex::Lock lock(mutex);  // 挂起协程，让出调度线程
+        got_lock = true;
+    });
+    single.schedule([&]() { other_ran = true; });
+    while (!other_ran) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    assert(!got_lock);
+    mutex.unlock();  // 移交给等待的协程
+    while (!got_lock) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    single.stop();
+    assert(mutex.try_lock());
+    mutex.unlock();
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    test_adaptive_mutex();
+    test_cas_lock();
+    test_seqlock();
+    test_fiber_mutex();
+    std::cout << "All mutex tests passed!" << std::endl;
+    return 0;
+}
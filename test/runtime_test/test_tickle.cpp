@@ -0,0 +1,109 @@
+// test_tickle.cpp
+// 唤醒握手：调度器外的线程向全部 idle 的多线程 IOManager 连续投递任务 (含指定线程的信箱任务，
+// 依赖 hasMailForOthers 的唤醒转发)，每个任务都必须在有界延迟内执行，不能等到 idle 超时兜底；
+// 空闲时 idle 线程阻塞而不空转，stop() 能把全部阻塞的线程唤醒并及时返回。epoll / io_uring 两种后端各跑一遍
+#include <time.h>
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <thread>
+
+#include "iomanager.h"
+
+using monsoon::IOBackend;
+using monsoon::IOManager;
+
+static const size_t kThreads = 4;
+// 丢失唤醒时任务要等 idle 超时 (这里调到 10s) 才会执行；正常路径的延迟远小于这个上限
+static const int kIdleTimeoutMs = 10000;
+static const int64_t kMaxDelayMs = 1000;
+
+static int64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static int64_t process_cpu_us() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void run_backend(IOBackend backend, const char *name) {
+    IOManager iom(kThreads, false, name, 0, backend);
+    if (iom.backend() != backend) {
+        std::cout << "[Test] " << name << " backend unavailable: SKIPPED" << std::endl;
+        return;
+    }
+    iom.setMaxIdleTimeout(kIdleTimeoutMs);
+
+    std::cout << "[Test] " << name << ": foreign-thread schedule into idle workers... ";
+    std::atomic<int64_t> max_delay_us{0};
+    std::atomic<int> done{0};
+    std::mt19937 rng(20261014);
+    int scheduled = 0;
+
+    for (int round = 0; round < 3000; ++round) {
+        // 一批 1~8 个任务紧挨着投递：一半不指定线程 (轮询信箱)，一半指定线程
+        int burst = 1 + (int)(rng() % 8);
+        for (int i = 0; i < burst; ++i) {
+            int thread = (i % 2 == 0) ? -1 : (int)((round + i) % kThreads);
+            int64_t t0 = now_us();
+            iom.schedule(
+                [t0, &max_delay_us, &done]() {
+                    int64_t delay = now_us() - t0;
+                    int64_t cur = max_delay_us.load();
+                    while (delay > cur && !max_delay_us.compare_exchange_weak(cur, delay)) {
+                    }
+                    ++done;
+                },
+                thread);
+            ++scheduled;
+        }
+
+        // 等这一批全部执行完；超过上限说明某个唤醒丢了
+        int64_t deadline = now_us() + kMaxDelayMs * 1000;
+        while (done.load() != scheduled) {
+            assert(now_us() < deadline);
+            std::this_thread::yield();
+        }
+
+        // 随机停顿：让 worker 有时来不及、有时刚好进入 epoll_wait / io_uring_enter，覆盖登记与复查的各种交错
+        uint32_t pause = rng() % 4;
+        if (pause == 1) {
+            std::this_thread::sleep_for(std::chrono::microseconds(rng() % 200));
+        } else if (pause == 2) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    assert(done.load() == scheduled);
+    assert(max_delay_us.load() < kMaxDelayMs * 1000);
+    std::cout << "PASSED (" << scheduled << " tasks, max delay " << max_delay_us.load() << "us)" << std::endl;
+
+    std::cout << "[Test] " << name << ": idle threads park, stop() wakes them all... ";
+    // 所有线程空闲：阻塞在内核里，200ms 内几乎不占 CPU (空转的话 4 个线程会吃满)
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    int64_t cpu0 = process_cpu_us();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    int64_t cpu_used = process_cpu_us() - cpu0;
+    assert(cpu_used < 50 * 1000);
+
+    // stop 的多次 tickle 可能被合并，退出的线程要把唤醒接力给下一个；任何一个没被叫醒 stop 都要等到 idle 超时
+    int64_t t0 = now_us();
+    iom.stop();
+    int64_t stop_ms = (now_us() - t0) / 1000;
+    assert(stop_ms < kMaxDelayMs);
+    std::cout << "PASSED (stop " << stop_ms << "ms)" << std::endl;
+}
+
+int main() {
+    run_backend(IOBackend::EPOLL, "epoll");
+    run_backend(IOBackend::IO_URING, "io_uring");
+    std::cout << "All tickle tests passed." << std::endl;
+    return 0;
+}
@@ -0,0 +1,305 @@
+// test_timer.cpp
+// 分层时间轮 (TimerManager)：用手动推进的时钟直接驱动，逐毫秒检查跨 256ms (第 0 -> 1 层) 与
+// 16s (第 1 -> 2 层) 下放边界的到期时刻与顺序、超出最高层范围的延迟 (约 49 天) 的截断、
+// 待插入 / 已挂链 / 已过期三种状态下的 cancel / refresh / reset、循环定时器、长时间空闲后的 getNextTimer
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "timer.h"
+#include "utils.h"
+
+using monsoon::Timer;
+
+class ManualTimerManager : public monsoon::TimerManager {
+public:
+    // 从真实时钟的当前值起步 (TimerManager 构造时的 base_ 不会晚于它)
+    ManualTimerManager() : now_(monsoon::GetElapsedMS()) {}
+
+    uint64_t now() const { return now_; }
+    // 只拨动时钟，不收集到期定时器 (模拟线程阻塞在 epoll_wait 中)
+    void setNow(uint64_t ms) { now_ = ms; }
+
+    // 拨到 ms 并收集、执行到期回调
+    void jumpTo(uint64_t ms) {
+        now_ = ms;
+        std::vector<std::function<void()>> cbs;
+        listExpiredCb(cbs);
+        for (auto &cb : cbs) cb();
+    }
+
+    // 逐毫秒推进到 ms，每一毫秒都收集一次
+    void stepTo(uint64_t ms) {
+        while (now_ < ms) jumpTo(now_ + 1);
+    }
+
+    int front_inserts = 0;
+
+protected:
+    void OnTimerInsertedAtFront() override { ++front_inserts; }
+    uint64_t getNowMS() override { return now_; }
+
+private:
+    std::atomic<uint64_t> now_;
+};
+
+// 回调触发时刻的记录：id -> 每次触发时的时钟
+struct FireLog {
+    std::map<int, std::vector<uint64_t>> fires;
+    std::vector<int> order;
+
+    std::function<void()> cb(ManualTimerManager &mgr, int id) {
+        return [this, &mgr, id]() {
+            fires[id].push_back(mgr.now());
+            order.push_back(id);
+        };
+    }
+    bool fired(int id) const { return fires.count(id) != 0; }
+    uint64_t at(int id) const {
+        auto it = fires.find(id);
+        assert(it != fires.end() && it->second.size() == 1);
+        return it->second[0];
+    }
+};
+
+// 像 IOManager::idle 一样按 getNextTimer 睡眠、醒来收集，直到 id 触发；
+// 每次等待都不为 0 (不空转) 且不晚于 deadline，第 0 层跨圈时最多为下放多醒一次
+static void sleep_until_fired(ManualTimerManager &mgr, FireLog &log, int id, uint64_t deadline) {
+    int wakeups = 0;
+    while (!log.fired(id)) {
+        uint64_t wait = mgr.getNextTimer();
+        assert(wait > 0 && wait <= deadline - mgr.now());
+        mgr.jumpTo(mgr.now() + wait);
+        assert(++wakeups <= 2);
+    }
+    assert(log.at(id) == deadline);
+}
+
+static void test_cascade_boundaries() {
+    std::cout << "[Test] expiry order across the 256ms / 16s cascade boundaries... ";
+    ManualTimerManager mgr;
+    FireLog log;
+    const uint64_t start = mgr.now();
+
+    // 第 0 层 / 第 1 层 / 第 2 层的边界两侧
+    const std::vector<uint64_t> delays = {1,    100,   255,   256,   257,   511,   512,  1000,
+                                          4095, 16383, 16384, 16385, 16800, 20000, 33000};
+    std::map<int, uint64_t> expect;
+    int id = 0;
+    for (uint64_t d : delays) {
+        mgr.addTimer(d, log.cb(mgr, id));
+        expect[id++] = start + d;
+    }
+
+    // 时间轮转了一段之后 (base_ 不在圈的起点) 再加一批，跨边界的距离从当前时刻起算
+    mgr.stepTo(start + 300);
+    const uint64_t mid = mgr.now();
+    for (uint64_t d : {200ull, 256ull, 16383ull, 16384ull, 16500ull}) {
+        mgr.addTimer(d, log.cb(mgr, id));
+        expect[id++] = mid + d;
+    }
+
+    mgr.stepTo(start + 40000);
+    for (auto &kv : expect) {
+        assert(log.at(kv.first) == kv.second);  // 恰好在到期的那一毫秒触发，不早不晚
+    }
+    for (size_t i = 1; i < log.order.size(); ++i) {
+        assert(expect[log.order[i - 1]] <= expect[log.order[i]]);
+    }
+    assert(log.order.size() == expect.size());
+    assert(!mgr.hasTimer());
+
+    // 收集停在圈首 (这一圈还没下放)：第 1 层里 3ms 后到期的定时器不能等到圈末才被发现
+    // (keeper 让时间轮非空，新定时器按推进中的 base_ 挂到第 1 层)
+    Timer::ptr keeper = mgr.addTimer(100000, log.cb(mgr, 101));
+    mgr.getNextTimer();
+    const uint64_t round = ((mgr.now() + 512) | 255) + 1;
+    mgr.addTimer(round + 3 - mgr.now(), log.cb(mgr, 100));
+    mgr.jumpTo(round - 1);
+    sleep_until_fired(mgr, log, 100, round + 3);
+    assert(keeper->cancel());
+    std::cout << "PASSED" << std::endl;
+}
+
+static void test_clamp_beyond_top_level() {
+    std::cout << "[Test] delays beyond the top level are clamped, then re-cascaded... ";
+    ManualTimerManager mgr;
+    FireLog log;
+    const uint64_t start = mgr.now();
+    const uint64_t kMaxDelta = (1ull << 32) - 1;        // 8 + 4 * 6 位，约 49.7 天
+    const uint64_t kDay = 24ull * 60 * 60 * 1000;
+
+    mgr.addTimer(60 * kDay, log.cb(mgr, 0));            // 超出最高层：按最远距离挂链
+    mgr.addTimer(kMaxDelta - 1000, log.cb(mgr, 1));     // 最高层之内
+    mgr.addTimer(kMaxDelta + 5000, log.cb(mgr, 2));
+
+    mgr.jumpTo(start + 30 * kDay);
+    assert(log.fires.empty());
+    mgr.jumpTo(start + kMaxDelta - 1001);
+    assert(log.fires.empty());
+    mgr.jumpTo(start + kMaxDelta - 1000);
+    assert(log.at(1) == start + kMaxDelta - 1000);
+
+    // 截断点到了也不能提前触发：下放时按真实的 next_ 重新挂链
+    mgr.jumpTo(start + kMaxDelta);
+    assert(!log.fired(0) && !log.fired(2));
+    mgr.stepTo(start + kMaxDelta + 4999);
+    assert(!log.fired(2));
+    mgr.jumpTo(start + kMaxDelta + 5000);
+    assert(log.at(2) == start + kMaxDelta + 5000);
+
+    mgr.jumpTo(start + 60 * kDay - 1);
+    assert(!log.fired(0));
+    assert(mgr.getNextTimer() == 1);
+    mgr.jumpTo(start + 60 * kDay);
+    assert(log.at(0) == start + 60 * kDay);
+    assert(!mgr.hasTimer());
+    std::cout << "PASSED" << std::endl;
+}
+
+static void test_cancel_refresh_reset() {
+    std::cout << "[Test] cancel / refresh / reset on pending, linked and due timers... ";
+    ManualTimerManager mgr;
+    FireLog log;
+    uint64_t s = mgr.now();
+
+    // --- cancel ---
+    Timer::ptr pending = mgr.addTimer(10, log.cb(mgr, 0));  // 仍在无锁待插入栈中
+    assert(pending->cancel());
+    assert(!pending->cancel());
+
+    Timer::ptr linked = mgr.addTimer(10, log.cb(mgr, 1));
+    uint64_t wait = mgr.getNextTimer();                   // getNextTimer 把它搬进时间轮
+    assert(wait > 0 && wait <= 10);                       // 跨圈时先在圈末醒来下放
+    assert(linked->cancel());
+
+    mgr.jumpTo(s);                                        // 时间轮已处理到 s，新的 0ms 定时器直接进入过期链
+    Timer::ptr due = mgr.addTimer(0, log.cb(mgr, 2));
+    assert(mgr.getNextTimer() == 0);
+    assert(due->cancel());
+
+    mgr.stepTo(s + 50);
+    assert(log.fires.empty());
+    assert(!mgr.hasTimer());
+
+    // --- refresh：到期时刻改为 now + ms ---
+    s = mgr.now();
+    Timer::ptr r_pending = mgr.addTimer(50, log.cb(mgr, 10));
+    Timer::ptr r_linked = mgr.addTimer(50, log.cb(mgr, 11));
+    mgr.getNextTimer();
+    Timer::ptr r_pending2 = mgr.addTimer(50, log.cb(mgr, 12));
+    mgr.setNow(s + 30);
+    assert(r_pending2->refresh());  // 待插入
+    assert(r_linked->refresh());    // 已挂链
+    mgr.stepTo(s + 79);
+    assert(log.at(10) == s + 50);
+    assert(!log.fired(11) && !log.fired(12));
+    mgr.stepTo(s + 80);
+    assert(log.at(11) == s + 80 && log.at(12) == s + 80);
+    assert(!r_pending->refresh() && !r_pending->cancel());  // 一次性定时器触发后失效
+    assert(!r_pending->reset(10, true));
+
+    // --- reset ---
+    s = mgr.now();
+    Timer::ptr a = mgr.addTimer(100, log.cb(mgr, 20));
+    a->reset(20, true);                          // 待插入：从现在起 20ms
+    Timer::ptr b = mgr.addTimer(100, log.cb(mgr, 21));
+    Timer::ptr c = mgr.addTimer(100, log.cb(mgr, 22));
+    mgr.stepTo(s + 10);
+    assert(b->reset(50, true));                  // 已挂链，从现在起：s + 60
+    assert(c->reset(40, false));                 // 已挂链，从上次的起点：s + 40
+    mgr.stepTo(s + 100);
+    assert(log.at(20) == s + 20);
+    assert(log.at(21) == s + 60);
+    assert(log.at(22) == s + 40);
+
+    // 已过期 (reset 到过去) 的定时器：再 refresh / reset 后按新时刻触发
+    s = mgr.now();
+    Timer::ptr d1 = mgr.addTimer(100, log.cb(mgr, 30));
+    Timer::ptr d2 = mgr.addTimer(100, log.cb(mgr, 31));
+    Timer::ptr d3 = mgr.addTimer(100, log.cb(mgr, 32));
+    mgr.stepTo(s + 50);
+    assert(d1->reset(10, false) && d2->reset(10, false) && d3->reset(10, false));  // s + 10 < now：进入过期链
+    assert(mgr.getNextTimer() == 0);
+    assert(d2->refresh());                       // now + 10
+    assert(d3->reset(30, true));                 // now + 30
+    mgr.jumpTo(s + 50);
+    assert(log.at(30) == s + 50);                // 过期链在下一次收集时立即触发
+    assert(!log.fired(31) && !log.fired(32));
+    mgr.stepTo(s + 80);
+    assert(log.at(31) == s + 60);
+    assert(log.at(32) == s + 80);
+    assert(!mgr.hasTimer());
+    std::cout << "PASSED" << std::endl;
+}
+
+static void test_recurring() {
+    std::cout << "[Test] recurring timers... ";
+    ManualTimerManager mgr;
+    FireLog log;
+    const uint64_t s = mgr.now();
+
+    Timer::ptr every100 = mgr.addTimer(100, log.cb(mgr, 0), true);
+    Timer::ptr every300 = mgr.addTimer(300, log.cb(mgr, 1), true);  // 跨第 0 层的圈
+    mgr.stepTo(s + 1000);
+    assert(log.fires[0].size() == 10);
+    for (size_t i = 0; i < log.fires[0].size(); ++i) {
+        assert(log.fires[0][i] == s + 100 * (i + 1));
+    }
+    assert(log.fires[1].size() == 3 && log.fires[1][2] == s + 900);
+
+    // 调整周期：下一次从上次的起点算
+    assert(every300->reset(150, false));
+    mgr.stepTo(s + 1200);
+    assert(log.fires[1].size() == 5 && log.fires[1][3] == s + 1050 && log.fires[1][4] == s + 1200);
+
+    assert(every100->cancel());
+    assert(every300->cancel());
+    mgr.stepTo(s + 2000);
+    assert(log.fires[0].size() == 12 && log.fires[1].size() == 5);
+    assert(!mgr.hasTimer());
+    std::cout << "PASSED" << std::endl;
+}
+
+static void test_next_timer_after_idle_gap() {
+    std::cout << "[Test] getNextTimer after a long idle gap... ";
+    ManualTimerManager mgr;
+    FireLog log;
+    const uint64_t hour = 60ull * 60 * 1000;
+    uint64_t s = mgr.now();
+    assert(mgr.getNextTimer() == ~0ull);
+
+    // 没有定时器时线程在 epoll_wait 中无限期阻塞，期间时间轮不推进；一小时后加一个 10ms 的定时器
+    mgr.setNow(s + hour);
+    Timer::ptr t = mgr.addTimer(10, log.cb(mgr, 0));
+    assert(mgr.front_inserts == 1);
+    sleep_until_fired(mgr, log, 0, s + hour + 10);
+
+    // 只有一个很远的定时器时长时间不收集：补收集一次之后，新定时器的等待时间是准确的
+    s = mgr.now();
+    mgr.addTimer(10 * hour, log.cb(mgr, 1));
+    assert(mgr.getNextTimer() > 0);
+    mgr.setNow(s + 5 * hour);
+    mgr.addTimer(10, log.cb(mgr, 2));
+    mgr.jumpTo(s + 5 * hour);
+    assert(log.fires.size() == 1);
+    sleep_until_fired(mgr, log, 2, s + 5 * hour + 10);
+    mgr.jumpTo(s + 10 * hour);
+    assert(log.at(1) == s + 10 * hour);
+    assert(mgr.getNextTimer() == ~0ull);
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    test_cascade_boundaries();
+    test_clamp_beyond_top_level();
+    test_cancel_refresh_reset();
+    test_recurring();
+    test_next_timer_after_idle_gap();
+    std::cout << "All timer tests passed!" << std::endl;
+    return 0;
+}
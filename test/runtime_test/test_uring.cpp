@@ -0,0 +1,182 @@
+// test_uring.cpp
+// io_uring 后端：hook 的 accept/connect/send/recv 经 submitIo 在环上完成、SO_RCVTIMEO 走内核 LINK_TIMEOUT
+// 转成 ETIMEDOUT、delEvent + addEvent 替换 poll 后旧代数的完成事件被丢弃
+// 内核不支持 io_uring (IOManager 回退到 epoll) 时整体跳过
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "hook.h"
+#include "iomanager.h"
+
+using monsoon::IOBackend;
+using monsoon::IOManager;
+
+// 在主线程 (非调度线程) 上等待条件成立，超时返回 false
+static bool wait_until(const std::function<bool()> &pred, int timeout_ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+static int64_t elapsed_ms(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - since).count();
+}
+
+// 监听 127.0.0.1 的临时端口，返回监听 fd，端口写入 addr
+static int listen_loopback(sockaddr_in *addr) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    assert(fd >= 0);
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr->sin_port = 0;
+    assert(::bind(fd, (sockaddr *)addr, sizeof(*addr)) == 0);
+    assert(::listen(fd, 16) == 0);
+    socklen_t len = sizeof(*addr);
+    assert(::getsockname(fd, (sockaddr *)addr, &len) == 0);
+    return fd;
+}
+
+static void test_loopback_echo(IOManager &iom) {
+    std::cout << "[Test] accept/connect/send/recv over loopback... ";
+    sockaddr_in addr;
+    std::atomic<int> listen_fd{-1};
+    std::atomic<bool> server_done{false};
+    std::atomic<bool> client_done{false};
+    std::string echoed;
+
+    // 服务端先挂在 accept 上 (没有待处理连接 -> EAGAIN -> IORING_OP_ACCEPT)
+    iom.schedule([&]() {
+        listen_fd = listen_loopback(&addr);
+        sockaddr_in peer;
+        socklen_t peer_len = sizeof(peer);
+        int conn = ::accept(listen_fd, (sockaddr *)&peer, &peer_len);
+        assert(conn >= 0);
+        assert(peer_len == sizeof(peer) && peer.sin_family == AF_INET);
+
+        char buf[64];
+        ssize_t n = ::recv(conn, buf, sizeof(buf), 0);
+        assert(n == 4);
+        assert(::send(conn, buf, n, 0) == n);
+        ::close(conn);
+        server_done = true;
+    });
+    assert(wait_until([&]() { return listen_fd.load() >= 0; }, 2000));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    iom.schedule([&]() {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        assert(fd >= 0);
+        assert(::connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0);
+        // 服务端回显之前 recv 必然先 EAGAIN，经 IORING_OP_RECV 完成
+        assert(::send(fd, "ping", 4, 0) == 4);
+        char buf[64];
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        assert(n == 4);
+        echoed.assign(buf, n);
+        // 对端已关闭：再读得到 EOF
+        assert(::recv(fd, buf, sizeof(buf), 0) == 0);
+        ::close(fd);
+        client_done = true;
+    });
+
+    assert(wait_until([&]() { return server_done && client_done; }, 5000));
+    assert(echoed == "ping");
+    ::close(listen_fd);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void test_link_timeout(IOManager &iom) {
+    std::cout << "[Test] SO_RCVTIMEO -> LINK_TIMEOUT -> ETIMEDOUT... ";
+    std::atomic<bool> done{false};
+    iom.schedule([&]() {
+        sockaddr_in addr;
+        int lfd = listen_loopback(&addr);
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        assert(::connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0);
+
+        timeval tv{0, 50 * 1000};
+        assert(::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == 0);
+
+        // 对端从不发送：recv 提交到环上，由链在后面的 LINK_TIMEOUT 取消
+        char buf[16];
+        auto start = std::chrono::steady_clock::now();
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        int err = errno;
+        int64_t waited = elapsed_ms(start);
+        assert(n == -1 && err == ETIMEDOUT);
+        assert(waited >= 40 && waited < 2000);
+
+        ::close(fd);
+        ::close(lfd);
+        done = true;
+    });
+    assert(wait_until([&]() { return done.load(); }, 5000));
+    std::cout << "PASSED" << std::endl;
+}
+
+static void test_replaced_poll(IOManager &iom) {
+    std::cout << "[Test] delEvent + addEvent drops stale poll completion... ";
+    int sv[2];
+    assert(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    fcntl(sv[0], F_SETFL, fcntl(sv[0], F_GETFL) | O_NONBLOCK);
+
+    std::atomic<int> old_fired{0};
+    std::atomic<int> new_fired{0};
+    std::atomic<bool> armed{false};
+    iom.schedule([&]() {
+        assert(iom.addEvent(sv[0], monsoon::READ, [&]() { ++old_fired; }) == 0);
+        assert(iom.delEvent(sv[0], monsoon::READ));
+        // 旧 poll 被 POLL_REMOVE 取消，它的 -ECANCELED 完成事件带着旧代数，
+        // 此时 fd 上已经注册了新的 READ：只认代数的话才不会把新回调误唤醒
+        assert(iom.addEvent(sv[0], monsoon::READ, [&]() { ++new_fired; }) == 0);
+        armed = true;
+    });
+    assert(wait_until([&]() { return armed.load(); }, 2000));
+
+    // fd 不可读：给旧完成事件足够的时间到达并被处理
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    assert(old_fired == 0);
+    assert(new_fired == 0);
+
+    assert(::write(sv[1], "x", 1) == 1);
+    assert(wait_until([&]() { return new_fired.load() == 1; }, 2000));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    assert(old_fired == 0);
+    assert(new_fired == 1);
+
+    ::close(sv[0]);
+    ::close(sv[1]);
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    IOManager iom(2, false, "uring_test", 0, IOBackend::IO_URING);
+    if (iom.backend() != IOBackend::IO_URING) {
+        std::cout << "[Test] io_uring unavailable, fell back to epoll: SKIPPED" << std::endl;
+        return 0;
+    }
+    test_loopback_echo(iom);
+    test_link_timeout(iom);
+    test_replaced_poll(iom);
+    std::cout << "All io_uring backend tests passed." << std::endl;
+    return 0;
+}
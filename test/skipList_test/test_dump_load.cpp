@@ -4,6 +4,7 @@
 #include <vector>
 #include <chrono>
 #include <map>
+#include <cstdio>
 #include "skipList.h" 
 
 // 简单的测试辅助宏
@@ -142,12 +143,80 @@ void TestPerformanceAndIntegrity() {
     std::cout << "[Test 3] PASSED" << std::endl;
 }
 
+// 验证流式快照：分 chunk 推送、写入 fd、截断检测，以及 O(n) 批量构建后的结构正确性
+void TestStreamingSnapshot() {
+    std::cout << "[Test 4] Streaming Snapshot (Sink/Source + Bulk Load)... " << std::endl;
+
+    int element_count = 100000;
+    SkipList<int, std::string> src(18);
+    for (int i = 0; i < element_count; ++i) {
+        src.insert_element(i, "v" + std::to_string(i));
+    }
+
+    // 1. 写到内存 sink：chunk 大小有上界，不会一次性拼出整份快照
+    std::string image;
+    size_t max_chunk = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    ASSERT_TRUE(src.dump_snapshot([&](const char *data, size_t len) {
+        max_chunk = std::max(max_chunk, len);
+        image.append(data, len);
+        return true;
+    }));
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = end - start;
+    std::cout << "    -> Stream Dump: " << elapsed.count() << "s" << std::endl;
+    ASSERT_TRUE(max_chunk <= kSnapshotChunkSize + 64);
+
+    // 2. 批量构建加载，替换旧数据
+    SkipList<int, std::string> dst(18);
+    dst.insert_element(-1, "dirty");
+    start = std::chrono::high_resolution_clock::now();
+    ASSERT_TRUE(dst.load_snapshot(make_string_source(image)));
+    end = std::chrono::high_resolution_clock::now();
+    elapsed = end - start;
+    std::cout << "    -> Stream Load (Bulk Build): " << elapsed.count() << "s" << std::endl;
+
+    ASSERT_EQ(dst.size(), element_count);
+    std::string val;
+    ASSERT_TRUE(!dst.search_element(-1, val));
+    ASSERT_TRUE(dst.search_element(77777, val));
+    ASSERT_EQ(val, "v77777");
+    // 批量构建出的高层索引必须可用于后续的查找/插入/删除
+    dst.delete_element(500);
+    ASSERT_TRUE(!dst.search_element(500, val));
+    ASSERT_EQ(dst.insert_element(500, "back"), 0);
+    std::vector<std::pair<int, std::string>> out;
+    dst.scan(499, 502, 0, out);
+    ASSERT_EQ(out.size(), 3u);
+    ASSERT_EQ(out[1].second, "back");
+
+    // 3. 通过文件描述符读写
+    FILE *tmp = tmpfile();
+    ASSERT_TRUE(tmp != nullptr);
+    int fd = fileno(tmp);
+    ASSERT_TRUE(src.dump_snapshot_to_fd(fd));
+    lseek(fd, 0, SEEK_SET);
+    SkipList<int, std::string> from_fd(18);
+    ASSERT_TRUE(from_fd.load_snapshot_from_fd(fd));
+    ASSERT_EQ(from_fd.size(), element_count);
+    fclose(tmp);
+
+    // 4. 截断的快照必须被拒绝，并且不留下半份状态
+    std::string truncated = image.substr(0, image.size() / 2);
+    SkipList<int, std::string> bad(18);
+    ASSERT_TRUE(!bad.load_snapshot(make_string_source(truncated)));
+    ASSERT_EQ(bad.size(), 0);
+
+    std::cout << "[Test 4] PASSED" << std::endl;
+}
+
 int main() {
     std::cout << "=== Starting SkipList Dump/Load Tests ===" << std::endl;
     
     TestBasicRoundTrip();
     TestStateReplacement();
     TestPerformanceAndIntegrity();
+    TestStreamingSnapshot();
 
     std::cout << "=== All Tests Passed ===" << std::endl;
     return 0;
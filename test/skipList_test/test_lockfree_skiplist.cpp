@@ -0,0 +1,193 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include "lockFreeSkipList.h"
+
+// 辅助宏：用于断言测试结果
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "[FAILED] " << msg << " at line " << __LINE__ << std::endl; \
+        std::exit(1); \
+    }
+
+#define ASSERT_EQ(val1, val2, msg) \
+    if ((val1) != (val2)) { \
+        std::cerr << "[FAILED] " << msg << ": " << (val1) << " != " << (val2) << " at line " << __LINE__ << std::endl; \
+        std::exit(1); \
+    }
+
+// ----------------------------------------------------------------
+// 1. 基础增删查 + Upsert (与 SkipList 接口语义一致)
+// ----------------------------------------------------------------
+void TestBasicOperations() {
+    std::cout << "[Test 1] Basic Operations (Insert/Search/Delete/Upsert)... ";
+
+    LockFreeSkipList<int, std::string> list(6);
+    std::string val;
+
+    ASSERT_EQ(list.insert_element(1, "one"), 0, "Insert key 1 should succeed");
+    ASSERT_EQ(list.insert_element(2, "two"), 0, "Insert key 2 should succeed");
+    ASSERT_EQ(list.insert_element(1, "one_again"), 1, "Insert duplicate key 1 should return 1");
+
+    ASSERT_TRUE(list.search_element(1, val), "Search key 1 failed");
+    ASSERT_EQ(val, "one", "insert_element must not overwrite");
+
+    list.insert_set_element(1, "uno");
+    ASSERT_TRUE(list.search_element(1, val), "Search key 1 failed");
+    ASSERT_EQ(val, "uno", "insert_set_element should overwrite");
+
+    list.delete_element(1);
+    ASSERT_TRUE(!list.search_element(1, val), "Key 1 should be deleted");
+    ASSERT_EQ(list.size(), 1, "Size should be 1 after deletion");
+
+    list.delete_element(3);
+    ASSERT_EQ(list.size(), 1, "Size should not change deleting non-existent key");
+
+    // 删除后可以重新插入同一个 key
+    ASSERT_EQ(list.insert_element(1, "again"), 0, "Re-insert after delete should succeed");
+    ASSERT_TRUE(list.search_element(1, val) && val == "again", "Re-inserted value mismatch");
+
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 2. 快照与 SkipList 互通
+// ----------------------------------------------------------------
+void TestDumpCompatibility() {
+    std::cout << "[Test 2] Dump/Load Compatibility With SkipList... ";
+
+    LockFreeSkipList<std::string, std::string> lf(8);
+    for (int i = 0; i < 200; ++i) {
+        lf.insert_element("key" + std::to_string(i), "val" + std::to_string(i));
+    }
+    lf.delete_element("key7");
+
+    SkipList<std::string, std::string> locked(8);
+    locked.load_file(lf.dump_file());
+    ASSERT_EQ(locked.size(), 199, "SkipList should load LockFreeSkipList dump");
+
+    LockFreeSkipList<std::string, std::string> back(8);
+    back.insert_element("stale", "x");
+    back.load_file(locked.dump_file());
+    ASSERT_EQ(back.size(), 199, "load_file should replace old content");
+
+    std::string val;
+    ASSERT_TRUE(!back.search_element("stale", val), "Old key should be cleared");
+    ASSERT_TRUE(!back.search_element("key7", val), "Deleted key should not reappear");
+    ASSERT_TRUE(back.search_element("key42", val) && val == "val42", "Value mismatch after round trip");
+
+    std::vector<std::pair<std::string, std::string>> out;
+    back.scan("key1", "key2", 0, out);
+    for (size_t i = 1; i < out.size(); ++i) {
+        ASSERT_TRUE(out[i - 1].first < out[i].first, "Scan result must be ascending");
+    }
+    ASSERT_EQ(out.size(), 111u, "key1, key10..key19, key100..key199");
+
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 3. 并发插入：不同线程写不相交的 key，最终全部可见
+// ----------------------------------------------------------------
+void TestConcurrentInsert() {
+    std::cout << "[Test 3] Concurrent Disjoint Inserts... ";
+
+    LockFreeSkipList<int, int> list(16);
+    const int kThreads = 4;
+    const int kPerThread = 5000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&list, t]() {
+            for (int i = 0; i < kPerThread; ++i) {
+                list.insert_element(i * kThreads + t, t);
+            }
+        });
+    }
+    for (auto &th : threads) th.join();
+
+    ASSERT_EQ(list.size(), kThreads * kPerThread, "Size mismatch after concurrent inserts");
+    int v = -1;
+    for (int k = 0; k < kThreads * kPerThread; ++k) {
+        ASSERT_TRUE(list.search_element(k, v), "Inserted key missing");
+        ASSERT_EQ(v, k % kThreads, "Value mismatch");
+    }
+
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 4. 读写混合压力：读线程与插入/删除/更新线程并发，不崩溃且最终状态正确
+// ----------------------------------------------------------------
+void TestMixedStress() {
+    std::cout << "[Test 4] Mixed Read/Write Stress... ";
+
+    LockFreeSkipList<int, std::string> list(16);
+    const int kKeys = 512;
+    std::atomic<bool> stop(false);
+
+    // 偶数 key 永远存在，读线程必须总能读到
+    for (int k = 0; k < kKeys; k += 2) {
+        list.insert_element(k, "stable");
+    }
+
+    std::vector<std::thread> readers;
+    std::atomic<int> missing(0);
+    for (int r = 0; r < 2; ++r) {
+        readers.emplace_back([&]() {
+            std::string val;
+            while (!stop.load()) {
+                for (int k = 0; k < kKeys; k += 2) {
+                    if (!list.search_element(k, val)) missing++;
+                }
+                std::vector<std::pair<int, std::string>> out;
+                list.scan(0, 64, out);
+                for (size_t i = 1; i < out.size(); ++i) {
+                    if (!(out[i - 1].first < out[i].first)) missing++;
+                }
+            }
+        });
+    }
+
+    std::vector<std::thread> writers;
+    for (int w = 0; w < 2; ++w) {
+        writers.emplace_back([&list, w]() {
+            for (int round = 0; round < 200; ++round) {
+                for (int k = 1; k < kKeys; k += 2) {
+                    if ((round + w) % 2 == 0) {
+                        list.insert_set_element(k, "odd");
+                    } else {
+                        list.delete_element(k);
+                    }
+                }
+            }
+        });
+    }
+    for (auto &th : writers) th.join();
+    stop.store(true);
+    for (auto &th : readers) th.join();
+
+    ASSERT_EQ(missing.load(), 0, "Stable keys must stay visible during concurrent writes");
+
+    // 收尾：删除所有奇数 key，计数应回到偶数 key 的数量
+    for (int k = 1; k < kKeys; k += 2) {
+        list.delete_element(k);
+    }
+    ASSERT_EQ(list.size(), kKeys / 2, "Final size mismatch");
+
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    std::cout << "=== Starting LockFreeSkipList Tests ===" << std::endl;
+
+    TestBasicOperations();
+    TestDumpCompatibility();
+    TestConcurrentInsert();
+    TestMixedStress();
+
+    std::cout << "=== All Tests Passed ===" << std::endl;
+    return 0;
+}
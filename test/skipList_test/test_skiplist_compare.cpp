@@ -0,0 +1,195 @@
+// test_skiplist_compare.cpp
+// Compare 模板参数：自定义顺序、std::string_view 异构查找、key 前缀缓存与完整比较的一致性
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "skipList.h"
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "[FAILED] " << msg << " at line " << __LINE__ << std::endl; \
+        std::exit(1); \
+    }
+
+#define ASSERT_EQ(val1, val2, msg) \
+    if ((val1) != (val2)) { \
+        std::cerr << "[FAILED] " << msg << ": " << (val1) << " != " << (val2) << " at line " << __LINE__ << std::endl; \
+        std::exit(1); \
+    }
+
+using StringList = SkipList<std::string, std::string, StringKeyCompare>;
+
+// 统计完整比较次数的比较器；CountingPrefixCompare 额外提供前缀
+static size_t g_full_compares = 0;
+
+struct CountingCompare {
+    using is_transparent = void;
+    bool operator()(std::string_view a, std::string_view b) const {
+        ++g_full_compares;
+        return a < b;
+    }
+};
+
+struct CountingPrefixCompare : CountingCompare {
+    static uint32_t prefix(std::string_view key) { return StringKeyCompare::prefix(key); }
+};
+
+// ----------------------------------------------------------------
+// 1. 自定义顺序：插入 / 查找 / 删除 / 扫描 / 迭代器都按 Compare 排序
+// ----------------------------------------------------------------
+void TestCustomOrder() {
+    std::cout << "[Test 1] Descending comparator... ";
+    SkipList<int, std::string, std::greater<int>> list(8);
+    for (int i = 0; i < 100; ++i) list.insert_element(i, "v" + std::to_string(i));
+    ASSERT_EQ(list.insert_element(42, "dup"), 1, "duplicate detected through Compare");
+    list.delete_element(50);
+    std::string value;
+    ASSERT_TRUE(list.search_element(42, value) && value == "v42", "point lookup");
+    ASSERT_TRUE(!list.search_element(50, value), "deleted");
+
+    std::vector<std::pair<int, std::string>> out;
+    int next = 0;
+    ASSERT_TRUE(list.scan(60, 5, out, &next), "limited scan");
+    ASSERT_EQ(out.size(), 5u, "page size");
+    ASSERT_EQ(out.front().first, 60, "scan starts at the first key not before 60");
+    ASSERT_EQ(out.back().first, 56, "descending");
+    ASSERT_EQ(next, 55, "cursor");
+    out.clear();
+    list.scan(52, 47, 0, out);
+    ASSERT_EQ(out.size(), 4u, "[52, 47) in descending order skips the deleted 50");
+
+    SkipList<int, std::string, std::greater<int>>::Iterator it(&list);
+    int expected = 99;
+    for (it.seek_to_first(); it.valid(); it.next()) {
+        if (expected == 50) --expected;
+        ASSERT_EQ(it.key(), expected, "iterator order");
+        --expected;
+    }
+    ASSERT_EQ(expected, -1, "iterated everything");
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 2. string_view 异构点查 / seek，带与不带 value 缓存、bloom 过滤器
+// ----------------------------------------------------------------
+void TestHeterogeneousLookup() {
+    std::cout << "[Test 2] string_view lookups... ";
+    StringList list(12);
+    for (int i = 0; i < 1000; ++i) list.insert_element("key" + std::to_string(i), "v" + std::to_string(i));
+    std::string buffer = "key123-and-some-trailing-bytes";
+    std::string_view probe(buffer.data(), 6);
+    std::string value;
+    ASSERT_TRUE(list.search_element(probe, value) && value == "v123", "string_view lookup");
+    ASSERT_TRUE(!list.search_element(std::string_view(buffer.data(), 7), value), "absent string_view");
+    ASSERT_TRUE(list.search_element("key7", value) && value == "v7", "string literal lookup");
+
+    list.enable_read_filter(2000);
+    ASSERT_TRUE(list.search_element(probe, value) && value == "v123", "filter hashes string_view like string");
+    int rejected = 0;
+    for (int i = 1000; i < 2000; ++i) {
+        std::string absent = "key" + std::to_string(i);
+        ASSERT_TRUE(!list.search_element(std::string_view(absent), value), "absent");
+    }
+    rejected = static_cast<int>(list.read_stats().filter_negatives);
+    ASSERT_TRUE(rejected > 950, "string_view probes use the filter");
+
+    list.enable_value_cache(64);
+    ASSERT_TRUE(list.search_element(probe, value) && value == "v123", "lookup through the cache");
+    list.insert_set_element("key123", "updated");
+    ASSERT_TRUE(list.search_element(probe, value) && value == "updated", "cache invalidated");
+
+    StringList::Iterator it(&list);
+    it.seek(std::string_view("key1235"));
+    ASSERT_TRUE(it.valid() && it.key() == "key124", "heterogeneous seek");
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 3. 前缀与完整比较一致：短 key、\0、高位字节、共享长前缀，对照 std::map
+// ----------------------------------------------------------------
+void TestPrefixMatchesFullOrder() {
+    std::cout << "[Test 3] Prefix order agrees with full comparison... ";
+    std::vector<std::string> keys = {"", "a", std::string("a\0", 2), std::string("a\0\x01", 3), "ab", "abc",
+                                     "abcd", "abcde", "abce", "b", "\xff", "\xff\xff\xff\xff\xff", "\x7f\x80"};
+    for (size_t i = 0; i < keys.size(); ++i) {
+        for (size_t j = 0; j < keys.size(); ++j) {
+            uint32_t pi = StringKeyCompare::prefix(keys[i]);
+            uint32_t pj = StringKeyCompare::prefix(keys[j]);
+            if (pi < pj) ASSERT_TRUE(keys[i] < keys[j], "prefix order implies full order");
+        }
+    }
+
+    StringList list(12);
+    std::map<std::string, std::string> model;
+    std::mt19937 rng(5);
+    const char alphabet[] = {'\0', 'a', 'b', '\x7f', '\x80', '\xff'};
+    for (int round = 0; round < 20000; ++round) {
+        std::string key(rng() % 7, 'a');
+        for (char &c : key) c = alphabet[rng() % sizeof(alphabet)];
+        if (rng() % 4 == 0) {
+            list.delete_element(key);
+            model.erase(key);
+        } else {
+            list.insert_set_element(key, std::to_string(round));
+            model[key] = std::to_string(round);
+        }
+    }
+    ASSERT_EQ(static_cast<size_t>(list.size()), model.size(), "size");
+    StringList::Iterator it(&list);
+    auto expected = model.begin();
+    for (it.seek_to_first(); it.valid(); it.next(), ++expected) {
+        ASSERT_TRUE(expected != model.end() && it.key() == expected->first, "order matches std::map");
+        ASSERT_TRUE(it.value() == expected->second, "value");
+    }
+    ASSERT_TRUE(expected == model.end(), "same number of keys");
+    std::string value;
+    for (const auto &kv : model) ASSERT_TRUE(list.search_element(kv.first, value) && value == kv.second, "lookup");
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 4. 前缀有区分度时，查找路径上的完整比较大幅减少；节点大小不变
+// ----------------------------------------------------------------
+void TestPrefixSavesComparisons() {
+    std::cout << "[Test 4] Key prefix resolves most comparisons... ";
+    std::vector<std::string> keys;
+    std::mt19937 rng(11);
+    for (int i = 0; i < 5000; ++i) {
+        std::string key(16, ' ');
+        for (char &c : key) c = static_cast<char>('a' + rng() % 26);
+        keys.push_back(key);
+    }
+    SkipList<std::string, std::string, CountingCompare> plain(12);
+    SkipList<std::string, std::string, CountingPrefixCompare> prefixed(12);
+    for (const auto &k : keys) {
+        plain.insert_element(k, "v");
+        prefixed.insert_element(k, "v");
+    }
+    std::string value;
+    g_full_compares = 0;
+    for (const auto &k : keys) ASSERT_TRUE(plain.search_element(std::string_view(k), value), "plain lookup");
+    size_t plain_compares = g_full_compares;
+    g_full_compares = 0;
+    for (const auto &k : keys) ASSERT_TRUE(prefixed.search_element(std::string_view(k), value), "prefixed lookup");
+    size_t prefixed_compares = g_full_compares;
+    ASSERT_TRUE(prefixed_compares * 5 < plain_compares, "prefix avoids most full comparisons");
+
+    // 前缀放在 node_level / deleted 之后的对齐空隙里，节点没有变大
+    ASSERT_EQ(sizeof(Node<std::string, std::string>), 8 + 2 * sizeof(std::string) + 3 * sizeof(void *),
+              "node layout");
+    std::cout << "PASSED (" << plain_compares << " -> " << prefixed_compares << " full compares)" << std::endl;
+}
+
+int main() {
+    TestCustomOrder();
+    TestHeterogeneousLookup();
+    TestPrefixMatchesFullOrder();
+    TestPrefixSavesComparisons();
+    std::cout << "All comparator tests passed!" << std::endl;
+    return 0;
+}
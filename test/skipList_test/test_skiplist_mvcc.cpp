@@ -0,0 +1,272 @@
+// test_skiplist_mvcc.cpp
+// MVCC 模式：pin 版本后的分页 Scan / 点查看到同一个时间点，墓碑与版本链在最老的 pin 释放后回收
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "skipList.h"
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "[FAILED] " << msg << " at line " << __LINE__ << std::endl; \
+        std::exit(1); \
+    }
+
+#define ASSERT_EQ(val1, val2, msg) \
+    if ((val1) != (val2)) { \
+        std::cerr << "[FAILED] " << msg << ": " << (val1) << " != " << (val2) << " at line " << __LINE__ << std::endl; \
+        std::exit(1); \
+    }
+
+using List = SkipList<int, std::string>;
+
+// ----------------------------------------------------------------
+// 1. 分页 Scan：页与页之间的写入对 pin 住的读者不可见
+// ----------------------------------------------------------------
+void TestPaginatedScan() {
+    std::cout << "[Test 1] Paginated scan on a pinned version... ";
+    List list(10, true);
+    std::map<int, std::string> expected;
+    std::vector<List::WriteOp> load;
+    for (int i = 0; i < 500; ++i) {
+        load.push_back({false, i, "v" + std::to_string(i)});
+        expected[i] = "v" + std::to_string(i);
+    }
+    list.apply_batch(load, 10);
+    ASSERT_EQ(list.applied_version(), 10u, "batch version");
+
+    std::unique_ptr<List::ReadPin> pin = list.pin_version();
+    ASSERT_TRUE(pin != nullptr, "MVCC list should hand out pins");
+    ASSERT_EQ(pin->version(), 10u, "pin at applied version");
+
+    std::map<int, std::string> seen;
+    int cursor = 0;
+    bool has_more = true;
+    uint64_t version = 11;
+    while (has_more) {
+        std::vector<std::pair<int, std::string>> page;
+        has_more = list.scan(*pin, cursor, 37, page, &cursor);
+        for (auto &kv : page) seen.insert(kv);
+        // 每页之后：更新前面和后面的 key、删除、插入新 key
+        list.insert_set_element(static_cast<int>(version % 500), "new", version);
+        list.delete_element(static_cast<int>((version * 7) % 500), version + 1);
+        list.insert_set_element(1000 + static_cast<int>(version), "fresh", version + 1);
+        version += 2;
+    }
+    ASSERT_TRUE(seen == expected, "pinned scan must see the image at version 10");
+
+    std::string v;
+    ASSERT_TRUE(list.search_element(11, v, *pin) && v == "v11", "point read at the pin");
+    ASSERT_TRUE(list.search_element(11, v) && v == "new", "latest read sees the update");
+    ASSERT_TRUE(!list.search_element(1011, v, *pin), "keys inserted later are invisible to the pin");
+
+    // 流式扫描同样按 pin 的版本
+    ScanStreamOptions options;
+    options.frame_keys = 50;
+    size_t streamed = 0;
+    ASSERT_TRUE(list.scan_stream(*pin, 0, 100000, options, [&](List::ScanFrame &frame) {
+        for (auto &kv : frame.kvs) {
+            ASSERT_TRUE(expected.at(kv.first) == kv.second, "stream frame value");
+        }
+        streamed += frame.kvs.size();
+        list.delete_element(static_cast<int>(streamed % 500));  // 帧之间删除
+        return true;
+    }), "scan_stream");
+    ASSERT_EQ(streamed, expected.size(), "stream count");
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 2. 墓碑与回收
+// ----------------------------------------------------------------
+void TestTombstonesAndGc() {
+    std::cout << "[Test 2] Tombstones and version GC... ";
+    List list(6, true);
+    list.insert_set_element(1, "a", 1);
+    list.insert_set_element(2, "b", 1);
+
+    // 没有 pin：原地覆盖 / 直接摘除，不产生历史
+    list.insert_set_element(1, "a2", 2);
+    list.delete_element(2, 2);
+    ASSERT_EQ(list.collect_versions(), 0u, "no history without readers");
+    ASSERT_EQ(list.size(), 1, "live count");
+
+    std::unique_ptr<List::ReadPin> pin = list.pin_version();
+    list.insert_set_element(1, "a3", 3);
+    list.insert_set_element(1, "a4", 4);
+    list.delete_element(1, 5);
+    ASSERT_EQ(list.size(), 0, "tombstone does not count");
+    std::string v;
+    ASSERT_TRUE(!list.search_element(1, v), "latest read skips the tombstone");
+    ASSERT_TRUE(list.search_element(1, v, *pin) && v == "a2", "pin still sees the old value");
+    std::vector<std::pair<int, std::string>> out;
+    list.scan(0, 0, out);
+    ASSERT_EQ(out.size(), 0u, "latest scan skips the tombstone");
+    {
+        List::Iterator it(&list);
+        it.seek_to_first();
+        ASSERT_TRUE(!it.valid(), "iterator skips the tombstone");
+    }
+
+    // 墓碑复活：对 pin 仍然是旧值
+    list.insert_element(1, "back");
+    ASSERT_TRUE(list.search_element(1, v) && v == "back", "revived");
+    ASSERT_TRUE(list.search_element(1, v, *pin) && v == "a2", "pin unaffected by revival");
+    ASSERT_EQ(list.size(), 1, "revived count");
+    list.delete_element(1);
+
+    // 最老的 pin 释放后自动回收：墓碑摘除，之后没有可回收的东西
+    pin.reset();
+    ASSERT_EQ(list.collect_versions(), 0u, "unpin collected everything");
+    ASSERT_TRUE(!list.search_element(1, v), "still deleted");
+    list.insert_set_element(1, "again");
+    ASSERT_TRUE(list.search_element(1, v) && v == "again", "reinsert after GC");
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 3. 同一批次内先更新再删除：更老的读者仍能读到批次之前的值
+// ----------------------------------------------------------------
+void TestSameBatchUpdateDelete() {
+    std::cout << "[Test 3] Update + delete in one batch... ";
+    List list(6, true);
+    list.insert_set_element(7, "old", 1);
+    std::unique_ptr<List::ReadPin> pin = list.pin_version();
+    list.apply_batch({{false, 7, "mid"}, {true, 7, ""}}, 2);
+    std::string v;
+    ASSERT_TRUE(!list.search_element(7, v), "deleted at version 2");
+    ASSERT_TRUE(list.search_element(7, v, *pin) && v == "old", "version 1 preserved");
+
+    // 批次内的中间状态对任何版本都不可见
+    std::unique_ptr<List::ReadPin> at2 = list.pin_version(2);
+    ASSERT_TRUE(at2 != nullptr && !list.search_element(7, v, *at2), "version 2 sees the delete");
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 4. pin 指定版本的范围；非 MVCC 模式不提供 pin
+// ----------------------------------------------------------------
+void TestPinBounds() {
+    std::cout << "[Test 4] Pin bounds... ";
+    List list(6, true);
+    list.insert_set_element(1, "a", 5);
+    ASSERT_TRUE(list.pin_version(4) == nullptr, "history below applied is not kept without pins");
+    ASSERT_TRUE(list.pin_version(6) == nullptr, "future version");
+    std::unique_ptr<List::ReadPin> p5 = list.pin_version(5);
+    ASSERT_TRUE(p5 != nullptr, "pin applied version");
+    list.insert_set_element(1, "b", 8);
+    list.insert_set_element(1, "c", 9);
+    std::unique_ptr<List::ReadPin> p8 = list.pin_version(8);
+    ASSERT_TRUE(p8 != nullptr, "versions after the oldest pin are retained");
+    std::string v;
+    ASSERT_TRUE(list.search_element(1, v, *p8) && v == "b", "value at 8");
+    ASSERT_TRUE(list.search_element(1, v, *p5) && v == "a", "value at 5");
+    ASSERT_TRUE(list.pin_version(4) == nullptr, "below the oldest pin");
+
+    // 版本号不回退：更小的版本号按 applied 处理
+    list.insert_set_element(2, "x", 3);
+    ASSERT_EQ(list.applied_version(), 9u, "applied does not go back");
+    ASSERT_TRUE(!list.search_element(2, v, *p8), "write with a stale version is still newer than the pins");
+
+    List plain(6);
+    ASSERT_TRUE(plain.pin_version() == nullptr, "non-MVCC list has no pins");
+    plain.insert_set_element(1, "a", 100);
+    ASSERT_EQ(plain.applied_version(), 0u, "non-MVCC list ignores versions");
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 5. split_off 与写时复制快照在 MVCC 模式下的行为
+// ----------------------------------------------------------------
+void TestSplitAndSnapshot() {
+    std::cout << "[Test 5] Split / snapshot with MVCC... ";
+    List list(6, true);
+    for (int i = 0; i < 100; ++i) list.insert_set_element(i, "v", 1);
+    std::unique_ptr<List::ReadPin> pin = list.pin_version();
+    for (int i = 0; i < 100; i += 3) list.delete_element(i, 2);
+
+    // 写时复制快照跳过墓碑，导出最新内容
+    std::string image;
+    ASSERT_TRUE(list.dump_snapshot([&](const char *data, size_t len) {
+        image.append(data, len);
+        return true;
+    }), "dump");
+    List restored(6);
+    ASSERT_TRUE(restored.load_snapshot(make_string_source(image)), "load");
+    ASSERT_EQ(restored.size(), list.size(), "snapshot has live keys only");
+
+    List right(6, true);
+    ASSERT_TRUE(!list.split_off(50, right), "split refused while readers pin old versions");
+    pin.reset();
+    ASSERT_TRUE(list.split_off(50, right), "split after readers are gone");
+    ASSERT_EQ(list.size() + right.size(), restored.size(), "no tombstones moved");
+    ASSERT_EQ(right.applied_version(), list.applied_version(), "right inherits the version");
+    List plain_right(6);
+    ASSERT_TRUE(!list.split_off(10, plain_right), "mode must match");
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 6. 并发：每个批次把所有 key 写成批次号，pin 住的读者多页扫描看到的值必须一致
+// ----------------------------------------------------------------
+void TestConcurrentConsistentCut() {
+    std::cout << "[Test 6] Concurrent writers and pinned readers... ";
+    SkipList<int, int> list(10, true);
+    const int kKeys = 200;
+    std::vector<SkipList<int, int>::WriteOp> init;
+    for (int i = 0; i < kKeys; ++i) init.push_back({false, i, 1});
+    list.apply_batch(init, 1);
+
+    std::atomic<bool> stop{false};
+    std::thread writer([&]() {
+        for (int version = 2; !stop.load(); ++version) {
+            std::vector<SkipList<int, int>::WriteOp> batch;
+            for (int i = 0; i < kKeys; ++i) batch.push_back({false, i, version});
+            list.apply_batch(batch, static_cast<uint64_t>(version));
+        }
+    });
+    std::vector<std::thread> readers;
+    std::atomic<int> checked{0};
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&]() {
+            for (int round = 0; round < 200; ++round) {
+                auto pin = list.pin_version();
+                int expected = static_cast<int>(pin->version());
+                int cursor = 0;
+                int total = 0;
+                bool has_more = true;
+                while (has_more) {
+                    std::vector<std::pair<int, int>> page;
+                    has_more = list.scan(*pin, cursor, 16, page, &cursor);
+                    for (auto &kv : page) {
+                        ASSERT_EQ(kv.second, expected, "torn read across pages");
+                    }
+                    total += static_cast<int>(page.size());
+                }
+                ASSERT_EQ(total, kKeys, "all keys visible");
+                checked++;
+            }
+        });
+    }
+    for (auto &t : readers) t.join();
+    stop = true;
+    writer.join();
+    ASSERT_EQ(checked.load(), 600, "rounds");
+    ASSERT_EQ(list.collect_versions(), 0u, "history collected once readers are gone");
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    std::cout << "=== Starting SkipList MVCC Tests ===" << std::endl;
+    TestPaginatedScan();
+    TestTombstonesAndGc();
+    TestSameBatchUpdateDelete();
+    TestPinBounds();
+    TestSplitAndSnapshot();
+    TestConcurrentConsistentCut();
+    std::cout << "=== All Tests Passed ===" << std::endl;
+    return 0;
+}
@@ -140,12 +140,207 @@ void TestConcurrency() {
     std::cout << "PASSED" << std::endl;
 }
 
+// ----------------------------------------------------------------
+// 4. Arena 节点内存：删除后空间复用，clear 后整体释放
+// ----------------------------------------------------------------
+void TestArenaReuse() {
+    std::cout << "[Test 4] Arena Node Reuse And Bulk Release... ";
+
+    SkipList<int, std::string> list(12);
+    for (int i = 0; i < 10000; ++i) {
+        list.insert_element(i, "value_" + std::to_string(i));
+    }
+    size_t filled = list.mem_usage();
+    ASSERT_TRUE(filled > 0, "Arena should hold node memory");
+
+    // 反复删除再插入同一批 key：同层高的空闲节点被复用，arena 增长应当很小
+    for (int round = 0; round < 5; ++round) {
+        for (int i = 0; i < 10000; ++i) list.delete_element(i);
+        ASSERT_EQ(list.size(), 0, "All keys should be deleted");
+        for (int i = 0; i < 10000; ++i) list.insert_element(i, "again_" + std::to_string(i));
+    }
+    ASSERT_TRUE(list.mem_usage() < filled * 2, "Deleted node space should be reused");
+
+    std::string val;
+    ASSERT_TRUE(list.search_element(4242, val) && val == "again_4242", "Value mismatch after reuse");
+
+    // load_file 的替换语义：旧节点全部析构，arena 重新计数
+    SkipList<int, std::string> small(12);
+    small.insert_element(1, "one");
+    list.load_file(small.dump_file());
+    ASSERT_EQ(list.size(), 1, "load_file should replace content");
+    ASSERT_TRUE(list.mem_usage() < filled, "clear should release arena blocks");
+
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 5. 批量写 / 批量读
+// ----------------------------------------------------------------
+void TestBatch() {
+    std::cout << "[Test 5] Batch Apply And Multi Get... ";
+
+    SkipList<int, std::string> list(12);
+    list.insert_element(1, "old");
+
+    std::vector<SkipList<int, std::string>::WriteOp> ops;
+    for (int i = 0; i < 100; ++i) {
+        ops.push_back({false, i, "v" + std::to_string(i)});
+    }
+    ops.push_back({true, 50, ""});
+    ops.push_back({false, 1, "new"});   // 同一 key 以最后一次为准
+    ops.push_back({true, 1000, ""});    // 删除不存在的 key 无副作用
+    list.apply_batch(ops);
+    ASSERT_EQ(list.size(), 99, "Size after batch");
+
+    std::vector<int> keys = {0, 1, 50, 99, 1000};
+    std::vector<std::string> values;
+    std::vector<bool> found;
+    list.multi_get(keys, values, found);
+    ASSERT_EQ(values.size(), keys.size(), "multi_get result size");
+    ASSERT_TRUE(found[0] && values[0] == "v0", "key 0");
+    ASSERT_TRUE(found[1] && values[1] == "new", "key 1 upserted by the last op");
+    ASSERT_TRUE(!found[2] && values[2].empty(), "key 50 deleted in batch");
+    ASSERT_TRUE(found[3] && values[3] == "v99", "key 99");
+    ASSERT_TRUE(!found[4], "key 1000 never existed");
+
+    // 并发：读者在一次 multi_get 中看到的要么是整批之前、要么是整批之后
+    SkipList<int, int> atomic_list(12);
+    std::vector<SkipList<int, int>::WriteOp> init;
+    for (int i = 0; i < 64; ++i) init.push_back({false, i, 0});
+    atomic_list.apply_batch(init);
+    std::vector<int> all_keys(64);
+    for (int i = 0; i < 64; ++i) all_keys[i] = i;
+
+    std::atomic<bool> done{false};
+    std::atomic<bool> torn{false};
+    std::thread reader([&]() {
+        std::vector<int> vals;
+        std::vector<bool> hit;
+        while (!done.load()) {
+            atomic_list.multi_get(all_keys, vals, hit);
+            for (int i = 1; i < 64; ++i) {
+                if (vals[i] != vals[0]) torn = true;
+            }
+        }
+    });
+    for (int round = 1; round <= 200; ++round) {
+        std::vector<SkipList<int, int>::WriteOp> batch;
+        for (int i = 0; i < 64; ++i) batch.push_back({false, i, round});
+        atomic_list.apply_batch(batch);
+    }
+    done = true;
+    reader.join();
+    ASSERT_TRUE(!torn.load(), "multi_get observed a partially applied batch");
+
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 6. 区间分裂：中位 key + 不拷贝数据的 split_off
+// ----------------------------------------------------------------
+void TestSplit() {
+    std::cout << "[Test 6] Median Key And Split Off... ";
+
+    SkipList<int, std::string> left(16);
+    int median = 0;
+    ASSERT_TRUE(!left.approximate_median_key(&median), "Empty list has no split point");
+    for (int i = 0; i < 20000; ++i) {
+        left.insert_element(i, "value_" + std::to_string(i));
+    }
+    ASSERT_TRUE(left.approximate_median_key(&median), "Median should exist");
+    ASSERT_TRUE(median > 20000 / 4 && median < 20000 * 3 / 4, "Median should be near the middle");
+
+    SkipList<int, std::string> right(16);
+    SkipList<int, std::string> wrong_level(8);
+    ASSERT_TRUE(!left.split_off(median, wrong_level), "Max level mismatch should be rejected");
+    ASSERT_TRUE(left.split_off(median, right), "Split should succeed");
+    ASSERT_EQ(left.size(), median, "Left keeps [0, median)");
+    ASSERT_EQ(right.size(), 20000 - median, "Right gets [median, +inf)");
+    {
+        SkipList<int, std::string>::Iterator it(&right);
+        it.seek_to_first();
+        ASSERT_EQ(it.key(), median, "Right starts at the split key");
+    }
+    ASSERT_EQ(right.mem_usage(), 0u, "Nodes are moved, not copied into right's arena");
+    std::string v;
+    ASSERT_TRUE(left.search_element(median - 1, v) && !left.search_element(median, v), "Left boundary");
+    ASSERT_TRUE(right.search_element(19999, v) && v == "value_19999", "Right content");
+    ASSERT_TRUE(!left.split_off(0, right), "Non-empty target should be rejected");
+
+    // 分裂后两边独立读写；左表 clear 之后右表的节点仍然有效 (共享 arena)
+    left.insert_element(median + 100000, "x");
+    right.delete_element(median);
+    right.insert_element(-1, "y");
+    left.clear(nullptr);
+    ASSERT_EQ(left.size(), 0, "Left cleared");
+    ASSERT_TRUE(right.search_element(19999, v) && v == "value_19999", "Right survives left clear");
+    ASSERT_TRUE(right.search_element(-1, v) && v == "y", "Right insert after split");
+
+    // 空区间分裂：right 保持为空
+    SkipList<int, std::string> small(16), empty(16);
+    small.insert_element(1, "a");
+    ASSERT_TRUE(!small.approximate_median_key(&median), "Single element cannot split");
+    ASSERT_TRUE(small.split_off(100, empty) && empty.size() == 0 && small.size() == 1, "Split beyond max key");
+
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 7. 操作耗时导出 (enable_op_metrics)
+// ----------------------------------------------------------------
+void TestOpMetrics() {
+    std::cout << "[Test 7] Op Latency Metrics... ";
+
+    SkipList<int, std::string> list(12);
+    list.insert_element(1, "before");  // 未开启：不记录
+    list.enable_op_metrics("ops_test");
+    list.enable_op_metrics("ignored");  // 只能开启一次
+
+    MetricsRegistry &registry = MetricsRegistry::GetInstance();
+    MetricHistogram *get = registry.GetHistogram("skiplist_op_latency_nanoseconds", {{"table", "ops_test"}, {"op", "get"}});
+    MetricHistogram *put = registry.GetHistogram("skiplist_op_latency_nanoseconds", {{"table", "ops_test"}, {"op", "put"}});
+    MetricHistogram *del = registry.GetHistogram("skiplist_op_latency_nanoseconds", {{"table", "ops_test"}, {"op", "delete"}});
+    MetricHistogram *scan = registry.GetHistogram("skiplist_op_latency_nanoseconds", {{"table", "ops_test"}, {"op", "scan"}});
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&list, t] {
+            std::string v;
+            for (int i = 0; i < 1000; ++i) {
+                list.insert_set_element(t * 1000 + i, "v");
+                list.search_element(t * 1000 + i, v);
+            }
+        });
+    }
+    for (auto &th : threads) th.join();
+    list.delete_element(1);
+    std::vector<std::pair<int, std::string>> out;
+    list.scan(0, 10, out);
+
+    ASSERT_EQ(put->Collect().count, 4000u, "Every put recorded once");
+    ASSERT_EQ(get->Collect().count, 4000u, "Every get recorded once");
+    ASSERT_EQ(del->Collect().count, 1u, "Delete recorded");
+    ASSERT_EQ(scan->Collect().count, 1u, "Scan recorded");
+    ASSERT_TRUE(get->Collect().Percentile(0.5) > 0, "Latency in nanoseconds is non-zero");
+    std::string text = registry.RenderPrometheus();
+    ASSERT_TRUE(text.find("skiplist_op_latency_nanoseconds_count{table=\"ops_test\",op=\"put\"} 4000") != std::string::npos,
+                "Exported in Prometheus format");
+    ASSERT_TRUE(text.find("table=\"ignored\"") == std::string::npos, "Second enable ignored");
+
+    std::cout << "PASSED" << std::endl;
+}
+
 int main() {
     std::cout << "=== Starting SkipList Operations Tests ===" << std::endl;
 
     TestBasicOperations();
     TestUpsert();
     TestConcurrency();
+    TestArenaReuse();
+    TestBatch();
+    TestSplit();
+    TestOpMetrics();
 
     std::cout << "=== All Tests Passed ===" << std::endl;
     return 0;
@@ -0,0 +1,258 @@
+// test_skiplist_read_cache.cpp
+// 读路径加速：bloom 过滤器挡掉不存在的 key、热点 value 缓存命中，写入 / 删除 / 批量写 / 清空 / 分裂后不返回旧值
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "skipList.h"
+
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "[FAILED] " << msg << " at line " << __LINE__ << std::endl; \
+        std::exit(1); \
+    }
+
+#define ASSERT_EQ(val1, val2, msg) \
+    if ((val1) != (val2)) { \
+        std::cerr << "[FAILED] " << msg << ": " << (val1) << " != " << (val2) << " at line " << __LINE__ << std::endl; \
+        std::exit(1); \
+    }
+
+using List = SkipList<int, std::string>;
+
+// ----------------------------------------------------------------
+// 1. 分块 bloom 过滤器：没有假阴性，误判率在设计范围内
+// ----------------------------------------------------------------
+void TestBlockedBloomFilter() {
+    std::cout << "[Test 1] Blocked bloom filter false positive rate... ";
+    BlockedBloomFilter filter(10000);
+    for (uint64_t i = 0; i < 10000; ++i) filter.add(skiplist_mix_hash(i));
+    for (uint64_t i = 0; i < 10000; ++i) {
+        ASSERT_TRUE(filter.may_contain(skiplist_mix_hash(i)), "no false negatives");
+    }
+    int false_positives = 0;
+    for (uint64_t i = 10000; i < 110000; ++i) {
+        if (filter.may_contain(skiplist_mix_hash(i))) ++false_positives;
+    }
+    ASSERT_TRUE(false_positives < 3000, "10 bits/key should stay under ~3% false positives");
+    ASSERT_EQ(filter.memory_bytes() % 64, 0u, "whole cache lines");
+    filter.clear();
+    ASSERT_TRUE(!filter.may_contain(skiplist_mix_hash(1)), "cleared");
+    std::cout << "PASSED (" << false_positives / 1000.0 << "% fp)" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 2. CLOCK 缓存：最近访问过的条目躲过淘汰，erase / clear 生效
+// ----------------------------------------------------------------
+void TestClockCache() {
+    std::cout << "[Test 2] Sharded CLOCK cache eviction... ";
+    ShardedClockCache<int, std::string> cache(4, 1);
+    for (int i = 0; i < 4; ++i) cache.put(i, "v" + std::to_string(i));
+    std::string value;
+    ASSERT_TRUE(cache.get(0, value) && value == "v0", "hit");
+    ASSERT_TRUE(cache.get(2, value), "hit");
+    // 满了：0 和 2 刚被访问，淘汰从 1 开始
+    cache.put(10, "v10");
+    cache.put(11, "v11");
+    ASSERT_TRUE(cache.get(0, value) && cache.get(2, value), "referenced entries survive");
+    ASSERT_TRUE(!cache.get(1, value) && !cache.get(3, value), "unreferenced entries evicted");
+    ASSERT_TRUE(cache.get(10, value) && value == "v10", "new entry");
+
+    cache.put(10, "updated");
+    ASSERT_TRUE(cache.get(10, value) && value == "updated", "put overwrites");
+    cache.erase(10);
+    ASSERT_TRUE(!cache.get(10, value), "erased");
+    ReadCacheStats stats = cache.stats();
+    ASSERT_EQ(stats.evictions, 2u, "evictions");
+    ASSERT_EQ(stats.entries, 3u, "entries");
+    cache.clear();
+    ASSERT_EQ(cache.stats().entries, 0u, "cleared");
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 3. 不存在的 key 大多数被过滤器直接挡掉，热点 key 命中缓存
+// ----------------------------------------------------------------
+void TestFilterAndCacheOnList() {
+    std::cout << "[Test 3] Negative lookups filtered, hot keys cached... ";
+    List list(12);
+    for (int i = 0; i < 2000; i += 2) list.insert_element(i, "v" + std::to_string(i));
+    list.enable_read_filter(1000);
+    list.enable_value_cache(256);
+
+    std::string value;
+    for (int i = 1; i < 2000; i += 2) ASSERT_TRUE(!list.search_element(i, value), "odd keys do not exist");
+    SkipListReadStats stats = list.read_stats();
+    ASSERT_EQ(stats.filter_checks, 1000u, "every lookup consults the filter");
+    ASSERT_TRUE(stats.filter_negatives > 950, "most absent keys never reach the list");
+    ASSERT_EQ(stats.filter_negatives + stats.filter_false_positives, 1000u, "the rest are false positives");
+    ASSERT_TRUE(stats.filter_bytes > 0, "filter memory");
+    int rejected = 0;
+    for (int i = 1; i < 2000; i += 2) rejected += list.may_contain(i) ? 0 : 1;
+    ASSERT_TRUE(rejected > 950, "may_contain agrees with search_element");
+    for (int i = 0; i < 2000; i += 2) ASSERT_TRUE(list.may_contain(i), "no false negatives");
+
+    for (int round = 0; round < 10; ++round) {
+        for (int i = 0; i < 20; i += 2) {
+            ASSERT_TRUE(list.search_element(i, value) && value == "v" + std::to_string(i), "hot key");
+        }
+    }
+    stats = list.read_stats();
+    ASSERT_EQ(stats.cache.inserts, 10u, "each hot key is filled once");
+    ASSERT_EQ(stats.cache.hits, 90u, "the rest are hits");
+
+    std::vector<int> keys = {0, 1, 2, 3};
+    std::vector<std::string> values;
+    std::vector<bool> found;
+    list.multi_get(keys, values, found);
+    ASSERT_TRUE(found[0] && !found[1] && found[2] && !found[3], "multi_get");
+    ASSERT_TRUE(values[2] == "v2", "multi_get value");
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 4. 所有写路径都让缓存失效，新插入的 key 立即可见
+// ----------------------------------------------------------------
+void TestInvalidation() {
+    std::cout << "[Test 4] Writes invalidate the cache... ";
+    List list(12);
+    list.enable_read_filter(16);
+    list.enable_value_cache(64);
+    list.insert_element(1, "a");
+    list.insert_element(2, "b");
+    std::string value;
+    ASSERT_TRUE(list.search_element(1, value) && value == "a", "filled");
+    ASSERT_TRUE(list.search_element(2, value) && value == "b", "filled");
+
+    list.insert_set_element(1, "a2");
+    ASSERT_TRUE(list.search_element(1, value) && value == "a2", "upsert");
+    list.delete_element(2);
+    ASSERT_TRUE(!list.search_element(2, value), "delete");
+
+    std::vector<List::WriteOp> batch = {{false, 1, "a3"}, {false, 2, "b3"}, {true, 1, ""}, {false, 3, "c3"}};
+    ASSERT_TRUE(list.search_element(1, value), "fill before batch");
+    list.apply_batch(batch);
+    ASSERT_TRUE(!list.search_element(1, value), "batch delete");
+    ASSERT_TRUE(list.search_element(2, value) && value == "b3", "batch re-insert");
+    ASSERT_TRUE(list.search_element(3, value) && value == "c3", "batch insert");
+
+    // 超过过滤器容量：自动按两倍重建，新旧 key 都不会被误挡
+    for (int i = 100; i < 1100; ++i) list.insert_element(i, "x");
+    for (int i = 100; i < 1100; ++i) ASSERT_TRUE(list.may_contain(i), "growth keeps all keys");
+    ASSERT_TRUE(list.read_stats().filter_rebuilds >= 5, "filter rebuilt while growing");
+
+    std::string dump = list.dump_file();
+    list.clear(nullptr);
+    ASSERT_TRUE(!list.search_element(3, value), "cleared list has no cached values");
+    list.load_file(dump);
+    ASSERT_TRUE(list.search_element(3, value) && value == "c3", "reloaded keys pass the filter");
+    ASSERT_TRUE(list.search_element(500, value), "reloaded");
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 5. MVCC：pin 读也经过过滤器，缓存只服务最新版本
+// ----------------------------------------------------------------
+void TestMvccPinnedReads() {
+    std::cout << "[Test 5] Pinned reads bypass the cache... ";
+    List list(12, true);
+    list.enable_read_filter(64);
+    list.enable_value_cache(64);
+    list.insert_set_element(1, "old", 1);
+    std::unique_ptr<List::ReadPin> pin = list.pin_version();
+    std::string value;
+    ASSERT_TRUE(list.search_element(1, value) && value == "old", "latest");
+    list.insert_set_element(1, "new", 2);
+    list.delete_element(1, 3);
+    ASSERT_TRUE(!list.search_element(1, value), "latest is deleted");
+    ASSERT_TRUE(list.search_element(1, value, *pin) && value == "old", "pinned reader sees its version");
+    ASSERT_TRUE(!list.search_element(42, value, *pin), "absent key");
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 6. split_off：右半边重建过滤器，两边缓存里都不留下移走的 key
+// ----------------------------------------------------------------
+void TestSplitOff() {
+    std::cout << "[Test 6] split_off keeps filter and cache coherent... ";
+    List left(12);
+    List right(12);
+    left.enable_read_filter(1000);
+    left.enable_value_cache(1000);
+    right.enable_read_filter(1000);
+    right.enable_value_cache(1000);
+    for (int i = 0; i < 1000; ++i) left.insert_element(i, "v" + std::to_string(i));
+    std::string value;
+    for (int i = 0; i < 1000; ++i) ASSERT_TRUE(left.search_element(i, value), "fill cache");
+
+    ASSERT_TRUE(left.split_off(500, right), "split");
+    for (int i = 0; i < 500; ++i) {
+        ASSERT_TRUE(left.search_element(i, value) && value == "v" + std::to_string(i), "left keeps lower half");
+        ASSERT_TRUE(!right.search_element(i, value), "right has no lower half");
+    }
+    for (int i = 500; i < 1000; ++i) {
+        ASSERT_TRUE(!left.search_element(i, value), "moved keys are not served from the cache");
+        ASSERT_TRUE(right.search_element(i, value) && value == "v" + std::to_string(i), "right passes the filter");
+    }
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 7. 并发：读者不会在写入之后读到被覆盖的旧值
+// ----------------------------------------------------------------
+void TestConcurrentReadersAndWriter() {
+    std::cout << "[Test 7] Concurrent readers never see stale cached values... ";
+    List list(12);
+    list.enable_read_filter(256);
+    list.enable_value_cache(64);
+    const int kKeys = 128;
+    for (int i = 0; i < kKeys; ++i) list.insert_element(i, "0");
+
+    // 每个 key 的值只会变大：读者读到的值不能比它上一次读到的更小
+    std::atomic<bool> stop{false};
+    std::thread writer([&]() {
+        for (int round = 1; round <= 50; ++round) {
+            for (int i = 0; i < kKeys; ++i) list.insert_set_element(i, std::to_string(round));
+            list.insert_element(kKeys + round, "new");  // 触发过滤器扩容
+        }
+        stop = true;
+    });
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&, r]() {
+            std::vector<int> last(kKeys, 0);
+            unsigned seed = 17 + r;
+            std::string value;
+            while (!stop.load()) {
+                seed = seed * 1103515245 + 12345;
+                int k = static_cast<int>((seed >> 8) % kKeys);
+                ASSERT_TRUE(list.search_element(k, value), "key exists");
+                int v = std::stoi(value);
+                ASSERT_TRUE(v >= last[k], "value went backwards");
+                last[k] = v;
+                list.may_contain(k + 10000);
+                std::this_thread::yield();  // 读锁偏向读者：给写者留出空隙
+            }
+        });
+    }
+    writer.join();
+    for (auto &t : readers) t.join();
+    std::string value;
+    for (int i = 0; i < kKeys; ++i) ASSERT_TRUE(list.search_element(i, value) && value == "50", "final value");
+    for (int i = 1; i <= 50; ++i) ASSERT_TRUE(list.search_element(kKeys + i, value), "inserted while reading");
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    TestBlockedBloomFilter();
+    TestClockCache();
+    TestFilterAndCacheOnList();
+    TestInvalidation();
+    TestMvccPinnedReads();
+    TestSplitOff();
+    TestConcurrentReadersAndWriter();
+    std::cout << "All read cache tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,251 @@
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include "skipList.h"
+
+// 辅助宏：用于断言测试结果
+#define ASSERT_TRUE(condition, msg) \
+    if (!(condition)) { \
+        std::cerr << "[FAILED] " << msg << " at line " << __LINE__ << std::endl; \
+        std::exit(1); \
+    }
+
+#define ASSERT_EQ(val1, val2, msg) \
+    if ((val1) != (val2)) { \
+        std::cerr << "[FAILED] " << msg << ": " << (val1) << " != " << (val2) << " at line " << __LINE__ << std::endl; \
+        std::exit(1); \
+    }
+
+// ----------------------------------------------------------------
+// 1. 半开区间 [start, end) 扫描
+// ----------------------------------------------------------------
+void TestRangeScan() {
+    std::cout << "[Test 1] Range Scan [start, end)... ";
+
+    SkipList<int, std::string> list(6);
+    for (int i = 0; i < 100; i += 2) {
+        list.insert_element(i, "v" + std::to_string(i));
+    }
+
+    std::vector<std::pair<int, std::string>> out;
+    bool has_more = list.scan(11, 21, 0, out);
+
+    ASSERT_TRUE(!has_more, "Unlimited scan should not report has_more");
+    ASSERT_EQ(out.size(), 5u, "Keys 12..20 expected");
+    ASSERT_EQ(out.front().first, 12, "Start key should seek to lower_bound");
+    ASSERT_EQ(out.back().first, 20, "End key is exclusive");
+    ASSERT_EQ(out[2].second, "v16", "Value mismatch");
+
+    // 空区间
+    out.clear();
+    list.scan(200, 300, 0, out);
+    ASSERT_EQ(out.size(), 0u, "Scan beyond max key should be empty");
+
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 2. limit + 续扫游标 (分页)
+// ----------------------------------------------------------------
+void TestLimitAndResume() {
+    std::cout << "[Test 2] Limit And Resume Cursor... ";
+
+    SkipList<int, int> list(8);
+    for (int i = 0; i < 1000; ++i) {
+        list.insert_element(i, i * 10);
+    }
+
+    int cursor = 0;
+    int pages = 0;
+    int expected = 0;
+    bool has_more = true;
+    while (has_more) {
+        std::vector<std::pair<int, int>> page;
+        int next = -1;
+        has_more = list.scan(cursor, 1000, 64, page, &next);
+        for (auto &kv : page) {
+            ASSERT_EQ(kv.first, expected, "Pages must be contiguous and ordered");
+            ASSERT_EQ(kv.second, expected * 10, "Value mismatch");
+            ++expected;
+        }
+        if (has_more) {
+            ASSERT_EQ(next, expected, "Cursor should point to the next unreturned key");
+            cursor = next;
+        }
+        ++pages;
+    }
+    ASSERT_EQ(expected, 1000, "All keys should be visited exactly once");
+    ASSERT_EQ(pages, 16, "1000 keys / 64 per page = 16 pages");
+
+    // limit 恰好等于剩余条数时不应误报 has_more
+    std::vector<std::pair<int, int>> tail;
+    ASSERT_TRUE(!list.scan(990, 10, tail), "Exact limit should not report has_more");
+    ASSERT_EQ(tail.size(), 10u, "Tail size mismatch");
+
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 3. Iterator seek / next
+// ----------------------------------------------------------------
+void TestIterator() {
+    std::cout << "[Test 3] Iterator Seek/Next... ";
+
+    SkipList<std::string, std::string> list(6);
+    list.insert_element("apple", "1");
+    list.insert_element("banana", "2");
+    list.insert_element("cherry", "3");
+
+    {
+        SkipList<std::string, std::string>::Iterator it(&list);
+        it.seek("b");
+        ASSERT_TRUE(it.valid(), "Seek should land on banana");
+        ASSERT_EQ(it.key(), "banana", "Seek lower_bound mismatch");
+        it.next();
+        ASSERT_EQ(it.value(), "3", "Next should reach cherry");
+        it.next();
+        ASSERT_TRUE(!it.valid(), "Iterator should be exhausted");
+
+        int n = 0;
+        for (it.seek_to_first(); it.valid(); it.next()) ++n;
+        ASSERT_EQ(n, 3, "Full iteration count mismatch");
+    }
+
+    // 迭代器析构后读锁释放，写操作可以继续
+    list.delete_element("banana");
+    ASSERT_EQ(list.size(), 2, "Delete after iterator released should succeed");
+
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 4. 并发读写下扫描结果保持有序
+// ----------------------------------------------------------------
+void TestConcurrentScan() {
+    std::cout << "[Test 4] Concurrent Scan With Writers... ";
+
+    SkipList<int, int> list(12);
+    std::thread writer([&list]() {
+        for (int i = 0; i < 5000; ++i) {
+            list.insert_set_element(i, i);
+        }
+    });
+
+    for (int round = 0; round < 200; ++round) {
+        std::vector<std::pair<int, int>> out;
+        list.scan(0, 128, out);
+        for (size_t i = 1; i < out.size(); ++i) {
+            ASSERT_TRUE(out[i - 1].first < out[i].first, "Scan result must be strictly ascending");
+        }
+    }
+    writer.join();
+
+    std::cout << "PASSED" << std::endl;
+}
+
+// ----------------------------------------------------------------
+// 5. 流式扫描：按字节 / 条数切帧，limit 截断，sink 中止，帧之间不持锁
+// ----------------------------------------------------------------
+void TestScanStream() {
+    std::cout << "[Test 5] Streaming Scan Frames... ";
+
+    SkipList<std::string, std::string> list(12);
+    for (int i = 0; i < 1000; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "k%04d", i);
+        list.insert_element(key, std::string(100, 'v'));  // 每条 5 + 100 字节
+    }
+
+    // 只按字节切帧：1050 字节 / 105 = 每帧 10 条
+    ScanStreamOptions options;
+    options.frame_bytes = 1050;
+    int frames = 0;
+    int expected = 0;
+    bool ok = list.scan_stream("k0100", "k0300", options,
+                               [&](SkipList<std::string, std::string>::ScanFrame &frame) {
+        ASSERT_TRUE(frame.kvs.size() <= 10u, "Frame exceeds byte budget");
+        for (auto &kv : frame.kvs) {
+            char key[16];
+            snprintf(key, sizeof(key), "k%04d", 100 + expected);
+            ASSERT_EQ(kv.first, key, "Frames must be contiguous and ordered");
+            ++expected;
+        }
+        ++frames;
+        ASSERT_TRUE(!frame.has_more, "No limit, no has_more");
+        return true;
+    });
+    ASSERT_TRUE(ok, "Stream should complete");
+    ASSERT_EQ(expected, 200, "All keys in [k0100, k0300) should be streamed exactly once");
+    ASSERT_EQ(frames, 20, "200 keys / 10 per frame");
+
+    // 单条超过预算也要发出去 (每帧至少一条)；条数上限；limit 截断给出续扫游标
+    options.frame_bytes = 1;
+    options.frame_keys = 0;
+    frames = 0;
+    list.scan_stream("k0990", options, [&](SkipList<std::string, std::string>::ScanFrame &frame) {
+        ASSERT_EQ(frame.kvs.size(), 1u, "Oversized entry gets its own frame");
+        ++frames;
+        return true;
+    });
+    ASSERT_EQ(frames, 10, "k0990..k0999 one per frame");
+
+    options.frame_bytes = kScanFrameBytes;
+    options.frame_keys = 64;
+    options.limit = 150;
+    int total = 0;
+    bool saw_last = false;
+    list.scan_stream("k0000", options, [&](SkipList<std::string, std::string>::ScanFrame &frame) {
+        ASSERT_TRUE(frame.kvs.size() <= 64u, "Frame exceeds key budget");
+        total += static_cast<int>(frame.kvs.size());
+        if (frame.last) {
+            saw_last = true;
+            ASSERT_TRUE(frame.has_more, "Limit should report has_more");
+            ASSERT_EQ(frame.next_key, "k0150", "Cursor should point to the next unreturned key");
+        }
+        return true;
+    });
+    ASSERT_TRUE(saw_last && total == 150, "Limit should cap the whole stream");
+
+    // sink 失败：立即中止
+    frames = 0;
+    options.limit = 0;
+    ok = list.scan_stream("k0000", options, [&](SkipList<std::string, std::string>::ScanFrame &) {
+        return ++frames < 3;
+    });
+    ASSERT_TRUE(!ok && frames == 3, "Stream should abort when sink fails");
+
+    // 空区间也会收到一个 last 帧
+    frames = 0;
+    list.scan_stream("z", options, [&](SkipList<std::string, std::string>::ScanFrame &frame) {
+        ASSERT_TRUE(frame.last && frame.kvs.empty(), "Empty range yields one empty last frame");
+        ++frames;
+        return true;
+    });
+    ASSERT_EQ(frames, 1, "Empty range frame count");
+
+    // sink 在锁外调用：sink 中写同一张表不会死锁
+    options.frame_keys = 100;
+    list.scan_stream("k0000", options, [&](SkipList<std::string, std::string>::ScanFrame &frame) {
+        if (!frame.kvs.empty()) list.insert_set_element(frame.kvs.back().first, "touched");
+        return true;
+    });
+    std::string v;
+    ASSERT_TRUE(list.search_element("k0099", v) && v == "touched", "Write from sink should succeed");
+
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    std::cout << "=== Starting SkipList Scan Tests ===" << std::endl;
+
+    TestRangeScan();
+    TestLimitAndResume();
+    TestIterator();
+    TestConcurrentScan();
+    TestScanStream();
+
+    std::cout << "=== All Tests Passed ===" << std::endl;
+    return 0;
+}
@@ -0,0 +1,266 @@
+// test_snapshot_cow.cpp
+// 写时复制快照：导出期间并发写入不影响镜像、不被阻塞；增量快照的链式叠加、未持久化回退与失效
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "skipList.h"
+
+#define ASSERT_EQ(val1, val2) \
+    if ((val1) != (val2)) { \
+        std::cerr << "Assertion failed at line " << __LINE__ << ": " \
+                  << (val1) << " != " << (val2) << std::endl; \
+        std::exit(1); \
+    }
+
+#define ASSERT_TRUE(condition) \
+    if (!(condition)) { \
+        std::cerr << "Assertion failed at line " << __LINE__ << ": " \
+                  << #condition << " is false" << std::endl; \
+        std::exit(1); \
+    }
+
+using List = SkipList<int, std::string>;
+
+static std::map<int, std::string> Contents(List &list) {
+    std::map<int, std::string> out;
+    std::vector<std::pair<int, std::string>> kvs;
+    list.scan(INT32_MIN, 0, kvs);
+    for (auto &kv : kvs) out.emplace(kv.first, kv.second);
+    return out;
+}
+
+static void AssertContents(List &list, const std::map<int, std::string> &expected) {
+    std::map<int, std::string> actual = Contents(list);
+    ASSERT_EQ(actual.size(), expected.size());
+    ASSERT_TRUE(actual == expected);
+}
+
+static SnapshotSink StringSink(std::string *out) {
+    return [out](const char *data, size_t len) {
+        out->append(data, len);
+        return true;
+    };
+}
+
+// sink 在锁外调用：在 sink 里直接写跳表不会死锁，写入也不会出现在镜像中
+void TestWritesDuringDump() {
+    std::cout << "[Test 1] Writes during dump see a point-in-time image... ";
+    List list(12);
+    std::map<int, std::string> expected;
+    for (int i = 0; i < 20000; i += 2) {
+        list.insert_element(i, "v" + std::to_string(i));
+        expected[i] = "v" + std::to_string(i);
+    }
+
+    std::unique_ptr<List::Snapshot> snap = list.begin_snapshot();
+    ASSERT_TRUE(snap != nullptr);
+    ASSERT_EQ(snap->size(), 10000);
+    ASSERT_EQ(snap->base_id(), 0u);
+
+    std::string image;
+    int chunks = 0;
+    int round = 0;
+    ASSERT_TRUE(list.dump_snapshot(*snap, [&](const char *data, size_t len) {
+        image.append(data, len);
+        ++chunks;
+        // 每个 chunk 之间：更新、删除、插入，分别落在已导出和尚未导出的区间
+        for (int k = 0; k < 50; ++k) {
+            int key = (round * 397 + k * 211) % 20000;
+            list.insert_set_element(key, "new");
+            list.delete_element((key + 1000) % 20000);
+            list.insert_element(key | 1, "odd");
+        }
+        ++round;
+        return true;
+    }));
+    ASSERT_TRUE(chunks > 2);
+
+    List restored(12);
+    ASSERT_TRUE(restored.load_snapshot(make_string_source(image)));
+    AssertContents(restored, expected);
+    std::cout << "PASSED" << std::endl;
+}
+
+// 多个写线程与导出并发 (TSan 下检查数据竞争)
+void TestConcurrentWriters() {
+    std::cout << "[Test 2] Concurrent writers... ";
+    List list(12);
+    std::map<int, std::string> expected;
+    for (int i = 0; i < 30000; ++i) {
+        list.insert_element(i, std::to_string(i));
+        expected[i] = std::to_string(i);
+    }
+    std::unique_ptr<List::Snapshot> snap = list.begin_snapshot();
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 3; ++t) {
+        writers.emplace_back([&list, &stop, t]() {
+            unsigned seed = 17 + t;
+            while (!stop.load()) {
+                seed = seed * 1103515245 + 12345;
+                int key = static_cast<int>((seed >> 8) % 40000);
+                if (seed & 1) {
+                    list.insert_set_element(key, "w");
+                } else {
+                    list.delete_element(key);
+                }
+            }
+        });
+    }
+    std::string image;
+    ASSERT_TRUE(list.dump_snapshot(*snap, StringSink(&image)));
+    // dump_file 走同样的写时复制路径
+    std::string archive = list.dump_file();
+    stop = true;
+    for (auto &w : writers) w.join();
+
+    List restored(12);
+    ASSERT_TRUE(restored.load_snapshot(make_string_source(image)));
+    AssertContents(restored, expected);
+    ASSERT_TRUE(!archive.empty());
+    std::cout << "PASSED" << std::endl;
+}
+
+// 全量 + 增量 + 增量 = 最新快照时刻的内容
+void TestIncrementalChain() {
+    std::cout << "[Test 3] Incremental chain... ";
+    List primary(10);
+    for (int i = 0; i < 1000; ++i) primary.insert_element(i, "a");
+
+    std::unique_ptr<List::Snapshot> s1 = primary.begin_snapshot();
+    ASSERT_TRUE(primary.begin_snapshot() == nullptr);  // 同一时刻只能有一个
+    std::string full;
+    ASSERT_TRUE(primary.dump_snapshot(*s1, StringSink(&full)));
+    std::string no_base;
+    ASSERT_TRUE(!primary.dump_delta_snapshot(*s1, StringSink(&no_base)));  // 链的第一个没有基准
+    s1->mark_persisted();
+    uint64_t id1 = s1->id();
+    s1.reset();
+
+    primary.insert_set_element(5, "b");
+    primary.delete_element(6);
+    primary.insert_element(2000, "c");
+    primary.insert_element(3000, "tmp");
+    primary.delete_element(3000);  // 两个快照之间插入又删除：增量里是一个删除标记
+    std::unique_ptr<List::Snapshot> s2 = primary.begin_snapshot();
+    ASSERT_EQ(s2->base_id(), id1);
+    primary.insert_set_element(7, "after-s2");  // 不属于 s2
+    std::string delta1;
+    ASSERT_TRUE(primary.dump_delta_snapshot(*s2, StringSink(&delta1)));
+    ASSERT_TRUE(delta1.size() < full.size() / 10);
+    s2->mark_persisted();
+    uint64_t id2 = s2->id();
+    s2.reset();
+
+    primary.delete_element(1);
+    std::unique_ptr<List::Snapshot> s3 = primary.begin_snapshot();
+    ASSERT_EQ(s3->base_id(), id2);
+    std::string delta2;
+    ASSERT_TRUE(primary.dump_delta_snapshot(*s3, StringSink(&delta2)));
+    s3->mark_persisted();
+    s3.reset();
+
+    List replica(10);
+    ASSERT_TRUE(replica.load_snapshot(make_string_source(full)));
+    uint64_t base = 0, id = 0;
+    ASSERT_TRUE(replica.load_delta_snapshot(make_string_source(delta1), &base, &id));
+    ASSERT_EQ(base, id1);
+    ASSERT_EQ(id, id2);
+    std::string v;
+    ASSERT_TRUE(replica.search_element(5, v) && v == "b");
+    ASSERT_TRUE(!replica.search_element(6, v));
+    ASSERT_TRUE(!replica.search_element(3000, v));
+    ASSERT_TRUE(replica.search_element(7, v) && v == "a");
+    ASSERT_TRUE(replica.load_delta_snapshot(make_string_source(delta2)));
+    AssertContents(replica, Contents(primary));
+
+    // 截断 / 非增量格式被拒绝，内容不变
+    ASSERT_TRUE(!replica.load_delta_snapshot(make_string_source(delta2.substr(0, delta2.size() - 2))));
+    ASSERT_TRUE(!replica.load_delta_snapshot(make_string_source(full)));
+    // 头部的条目数被改坏 (magic | version u32 | base u64 | id u64 | count u64)：按流的实际内容失败，不会按 count 预分配
+    std::string huge_count = delta2;
+    memset(&huge_count[24], 0xff, sizeof(uint64_t));
+    ASSERT_TRUE(!replica.load_delta_snapshot(make_string_source(huge_count)));
+    AssertContents(replica, Contents(primary));
+    std::cout << "PASSED" << std::endl;
+}
+
+// 没有 mark_persisted 就释放：改动并入下一个增量，基准退回上一个持久化的快照
+void TestUnpersistedRollsBack() {
+    std::cout << "[Test 4] Unpersisted snapshot rolls back... ";
+    List list(8);
+    for (int i = 0; i < 100; ++i) list.insert_element(i, "a");
+    std::unique_ptr<List::Snapshot> s1 = list.begin_snapshot();
+    std::string full;
+    ASSERT_TRUE(list.dump_snapshot(*s1, StringSink(&full)));
+    s1->mark_persisted();
+    uint64_t id1 = s1->id();
+    s1.reset();
+
+    list.insert_set_element(1, "x");
+    std::unique_ptr<List::Snapshot> failed = list.begin_snapshot();
+    ASSERT_TRUE(!list.dump_delta_snapshot(*failed, [](const char *, size_t) { return false; }));
+    failed.reset();  // 落盘失败
+
+    list.insert_set_element(2, "y");
+    std::unique_ptr<List::Snapshot> s3 = list.begin_snapshot();
+    ASSERT_EQ(s3->base_id(), id1);
+    std::string delta;
+    ASSERT_TRUE(list.dump_delta_snapshot(*s3, StringSink(&delta)));
+
+    List replica(8);
+    ASSERT_TRUE(replica.load_snapshot(make_string_source(full)));
+    ASSERT_TRUE(replica.load_delta_snapshot(make_string_source(delta)));
+    AssertContents(replica, Contents(list));
+    std::cout << "PASSED" << std::endl;
+}
+
+// 整表替换 / 分裂使进行中的快照失效，增量链重新开始
+void TestInvalidation() {
+    std::cout << "[Test 5] Load / split invalidate snapshots... ";
+    List list(8);
+    for (int i = 0; i < 100; ++i) list.insert_element(i, "a");
+    std::unique_ptr<List::Snapshot> s1 = list.begin_snapshot();
+    std::string full;
+    ASSERT_TRUE(list.dump_snapshot(*s1, StringSink(&full)));
+    s1->mark_persisted();
+    s1.reset();
+
+    std::unique_ptr<List::Snapshot> s2 = list.begin_snapshot();
+    ASSERT_TRUE(list.load_snapshot(make_string_source(full)));
+    std::string out;
+    ASSERT_TRUE(!list.dump_snapshot(*s2, StringSink(&out)));
+    ASSERT_TRUE(!list.dump_delta_snapshot(*s2, StringSink(&out)));
+    s2.reset();
+    std::unique_ptr<List::Snapshot> s3 = list.begin_snapshot();
+    ASSERT_EQ(s3->base_id(), 0u);
+    s3->mark_persisted();
+    s3.reset();
+
+    std::unique_ptr<List::Snapshot> s4 = list.begin_snapshot();
+    ASSERT_TRUE(s4->base_id() != 0);
+    List right(8);
+    ASSERT_TRUE(list.split_off(50, right));
+    ASSERT_TRUE(!list.dump_snapshot(*s4, StringSink(&out)));
+    s4.reset();
+    ASSERT_EQ(list.begin_snapshot()->base_id(), 0u);
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    std::cout << "=== Starting SkipList COW Snapshot Tests ===" << std::endl;
+    TestWritesDuringDump();
+    TestConcurrentWriters();
+    TestIncrementalChain();
+    TestUnpersistedRollsBack();
+    TestInvalidation();
+    std::cout << "=== All Tests Passed ===" << std::endl;
+    return 0;
+}
@@ -0,0 +1,312 @@
+// test_lsm_store.cpp
+// LsmStore：跨 memtable / L0 / Ln 的读写与删除、分层 compaction、重启恢复 (DurableIndex)、硬链接快照、并发读写
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lsm_store.h"
+
+using storage::LsmOptions;
+using storage::LsmStats;
+using storage::LsmStore;
+
+static std::string MakeTempDir() {
+    char tmpl[] = "/tmp/lsm_store_test_XXXXXX";
+    char* dir = mkdtemp(tmpl);
+    assert(dir != nullptr);
+    return dir;
+}
+
+static void RemoveDir(const std::string& dir) {
+    if (DIR* d = opendir(dir.c_str())) {
+        while (struct dirent* ent = readdir(d)) {
+            std::string name = ent->d_name;
+            if (name != "." && name != "..") {
+                unlink((dir + "/" + name).c_str());
+            }
+        }
+        closedir(d);
+    }
+    rmdir(dir.c_str());
+}
+
+static std::string Key(int i) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "key%06d", i);
+    return buf;
+}
+
+// 小 memtable / 小层级：几千次写入就能走完 flush -> L0 -> L1 -> L2
+static LsmOptions SmallOptions(const std::string& dir) {
+    LsmOptions options;
+    options.dir = dir;
+    options.memtable_bytes = 16 * 1024;
+    options.l0_compaction_trigger = 2;
+    options.level1_bytes = 32 * 1024;
+    options.level_multiplier = 4;
+    options.target_file_bytes = 8 * 1024;
+    options.num_levels = 4;
+    options.sync = false;
+    options.table.block_size = 512;
+    return options;
+}
+
+static void CheckContents(LsmStore& store, const std::map<std::string, std::string>& model, int key_space) {
+    std::string value;
+    for (int i = 0; i < key_space; ++i) {
+        auto it = model.find(Key(i));
+        bool found = store.Get(Key(i), &value);
+        assert(found == (it != model.end()));
+        if (found) assert(value == it->second);
+    }
+    std::vector<std::pair<std::string, std::string>> all;
+    assert(!store.Scan("", "", 0, &all));
+    assert(all.size() == model.size());
+    size_t n = 0;
+    for (const auto& kv : model) {
+        assert(all[n].first == kv.first && all[n].second == kv.second);
+        ++n;
+    }
+}
+
+static void TestReadWriteAcrossLevels() {
+    std::cout << "[Test] random workload across memtable / L0 / Ln... ";
+    std::string dir = MakeTempDir();
+    LsmStore store(SmallOptions(dir));
+    assert(store.Open());
+
+    std::map<std::string, std::string> model;
+    const int kKeys = 3000;
+    unsigned seed = 7;
+    uint64_t index = 0;
+    for (int round = 0; round < 20000; ++round) {
+        seed = seed * 1103515245 + 12345;
+        int k = static_cast<int>((seed >> 8) % kKeys);
+        if ((seed >> 4) % 5 == 0) {
+            assert(store.Delete(Key(k), ++index));
+            model.erase(Key(k));
+        } else {
+            std::string v = "v" + std::to_string(round) + std::string(round % 50, 'x');
+            assert(store.Put(Key(k), v, ++index));
+            model[Key(k)] = v;
+        }
+    }
+    assert(store.AppliedIndex() == index);
+    CheckContents(store, model, kKeys);  // 读的同时后台还在 compaction
+    store.WaitForIdle();
+    CheckContents(store, model, kKeys);
+
+    LsmStats stats = store.GetStats();
+    assert(stats.flushes > 10);
+    assert(stats.compactions > 0);
+    assert(stats.level_files[0] < 2);  // L0 已经合并下去
+    size_t deep_files = 0;
+    for (size_t level = 1; level < stats.level_files.size(); ++level) deep_files += stats.level_files[level];
+    assert(deep_files > 0);
+    assert(stats.bloom_filtered > 0);
+
+    // 分页扫描：区间 + limit，墓碑不出现在结果里
+    std::vector<std::pair<std::string, std::string>> page, all;
+    std::string cursor = Key(100);
+    bool more = true;
+    while (more) {
+        page.clear();
+        more = store.Scan(cursor, Key(2000), 37, &page, &cursor);
+        assert(page.size() <= 37);
+        all.insert(all.end(), page.begin(), page.end());
+    }
+    auto lo = model.lower_bound(Key(100));
+    auto hi = model.lower_bound(Key(2000));
+    assert(all.size() == static_cast<size_t>(std::distance(lo, hi)));
+    for (const auto& kv : all) assert(model.at(kv.first) == kv.second);
+    store.Close();
+    RemoveDir(dir);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestTombstonesDropped() {
+    std::cout << "[Test] tombstones are dropped at the bottom level... ";
+    std::string dir = MakeTempDir();
+    LsmOptions options = SmallOptions(dir);
+    LsmStore store(options);
+    assert(store.Open());
+    for (int i = 0; i < 2000; ++i) assert(store.Put(Key(i), std::string(64, 'v')));
+    assert(store.Flush());
+    for (int i = 0; i < 2000; ++i) assert(store.Delete(Key(i)));
+    assert(store.Flush());
+    store.WaitForIdle();
+
+    std::string value;
+    for (int i = 0; i < 2000; i += 97) assert(!store.Get(Key(i), &value));
+    std::vector<std::pair<std::string, std::string>> out;
+    assert(!store.Scan("", "", 10, &out) && out.empty());
+    // 删除标记与被删的数据都已回收，剩下的文件很小
+    LsmStats stats = store.GetStats();
+    uint64_t bytes = 0;
+    for (uint64_t b : stats.level_bytes) bytes += b;
+    assert(bytes < 16 * 1024);
+    store.Close();
+    RemoveDir(dir);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestRecoveryAndDurableIndex() {
+    std::cout << "[Test] restart keeps SSTables, DurableIndex tells Raft where to replay... ";
+    std::string dir = MakeTempDir();
+    LsmOptions options = SmallOptions(dir);
+    {
+        LsmStore store(options);
+        assert(store.Open());
+        for (int i = 1; i <= 1000; ++i) assert(store.Put(Key(i), "v" + std::to_string(i), i));
+        assert(store.Flush());
+        assert(store.DurableIndex() == 1000);
+        for (int i = 1001; i <= 1010; ++i) assert(store.Put(Key(i), "late", i));
+        assert(store.DurableIndex() == 1000);  // 还在 memtable 里
+    }  // Close 会把 memtable 落盘
+    {
+        LsmStore store(options);
+        assert(store.Open());
+        assert(store.DurableIndex() == 1010);
+        assert(store.AppliedIndex() == 1010);
+        std::string value;
+        assert(store.Get(Key(1), &value) && value == "v1");
+        assert(store.Get(Key(1005), &value) && value == "late");
+        assert(store.Put(Key(1), "again", 1011));
+    }
+    // 留下一个不在 MANIFEST 里的 .sst (例如 compaction 中途崩溃)：Open 时清理
+    std::string orphan = dir + "/999999.sst";
+    FILE* f = fopen(orphan.c_str(), "w");
+    fputs("garbage", f);
+    fclose(f);
+    {
+        LsmStore store(options);
+        assert(store.Open());
+        assert(access(orphan.c_str(), F_OK) != 0);
+        std::string value;
+        assert(store.Get(Key(1), &value) && value == "again");
+    }
+    RemoveDir(dir);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestCheckpoint() {
+    std::cout << "[Test] checkpoint references SSTables by hard link... ";
+    std::string dir = MakeTempDir();
+    std::string snap = MakeTempDir() + "/snap";
+    LsmOptions options = SmallOptions(dir);
+    std::map<std::string, std::string> at_snapshot;
+    {
+        LsmStore store(options);
+        assert(store.Open());
+        for (int i = 0; i < 3000; ++i) {
+            assert(store.Put(Key(i), "v" + std::to_string(i), i + 1));
+            at_snapshot[Key(i)] = "v" + std::to_string(i);
+        }
+        uint64_t index = 0;
+        std::string error;
+        assert(store.Checkpoint(snap, &index, &error));
+        assert(index == 3000);
+        assert(!store.Checkpoint(snap, &index, &error));  // 目录里已经有快照
+
+        // 快照之后继续写入、compaction 替换掉旧文件：快照不受影响
+        for (int i = 0; i < 3000; ++i) assert(store.Put(Key(i), "after", 3001 + i));
+        store.WaitForIdle();
+
+        // 快照目录里是 SSTable 文件本身 (硬链接)，原文件被 compaction 删除后仍然可读
+        struct stat st;
+        size_t linked = 0;
+        if (DIR* d = opendir(snap.c_str())) {
+            while (struct dirent* ent = readdir(d)) {
+                std::string name = ent->d_name;
+                if (name.size() > 4 && name.compare(name.size() - 4, 4, ".sst") == 0) {
+                    assert(stat((snap + "/" + name).c_str(), &st) == 0);
+                    ++linked;
+                }
+            }
+            closedir(d);
+        }
+        assert(linked > 0);
+    }
+    {
+        LsmOptions snap_options = options;
+        snap_options.dir = snap;
+        LsmStore restored(snap_options);
+        assert(restored.Open());
+        assert(restored.DurableIndex() == 3000);
+        CheckContents(restored, at_snapshot, 3000);
+    }
+    RemoveDir(snap);
+    rmdir(snap.substr(0, snap.size() - 5).c_str());
+    RemoveDir(dir);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestConcurrentReaders() {
+    std::cout << "[Test] concurrent readers during flush / compaction... ";
+    std::string dir = MakeTempDir();
+    LsmStore store(SmallOptions(dir));
+    assert(store.Open());
+    // 每个 key 的 value 只会变大：读者读到的值不能比它上一次读到的更小
+    const int kKeys = 500;
+    for (int i = 0; i < kKeys; ++i) assert(store.Put(Key(i), "0"));
+
+    std::atomic<bool> stop{false};
+    std::thread writer([&]() {
+        for (int round = 1; round <= 60; ++round) {
+            for (int i = 0; i < kKeys; ++i) assert(store.Put(Key(i), std::to_string(round)));
+        }
+        stop = true;
+    });
+    std::vector<std::thread> readers;
+    std::atomic<int> scans{0};
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&, r]() {
+            std::vector<int> last(kKeys, 0);
+            unsigned seed = 31 + r;
+            while (!stop.load()) {
+                seed = seed * 1103515245 + 12345;
+                int k = static_cast<int>((seed >> 8) % kKeys);
+                std::string value;
+                std::string error;
+                assert(store.Get(Key(k), &value, &error));
+                int v = std::stoi(value);
+                assert(v >= last[k]);
+                last[k] = v;
+                if (seed % 16 == 0) {
+                    std::vector<std::pair<std::string, std::string>> out;
+                    store.Scan(Key(k), "", 50, &out);
+                    assert(!out.empty() && out.front().first == Key(k));
+                    scans++;
+                }
+            }
+        });
+    }
+    writer.join();
+    for (auto& t : readers) t.join();
+    store.WaitForIdle();
+    std::string value;
+    for (int i = 0; i < kKeys; ++i) assert(store.Get(Key(i), &value) && value == "60");
+    store.Close();
+    RemoveDir(dir);
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    TestReadWriteAcrossLevels();
+    TestTombstonesDropped();
+    TestRecoveryAndDurableIndex();
+    TestCheckpoint();
+    TestConcurrentReaders();
+    std::cout << "All LsmStore tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,229 @@
+// test_sstable.cpp
+// SSTable：前缀压缩 block / 稀疏索引点查 / zlib 压缩 / bloom 过滤器 / 校验和检测损坏 / 多路归并
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "sstable.h"
+
+using storage::BlockBuilder;
+using storage::BlockIter;
+using storage::KvIterator;
+using storage::MergingIterator;
+using storage::Table;
+using storage::TableBuilder;
+using storage::TableOptions;
+
+static std::string MakeTempDir() {
+    char tmpl[] = "/tmp/sstable_test_XXXXXX";
+    char* dir = mkdtemp(tmpl);
+    assert(dir != nullptr);
+    return dir;
+}
+
+static void RemoveDir(const std::string& dir) {
+    if (DIR* d = opendir(dir.c_str())) {
+        while (struct dirent* ent = readdir(d)) {
+            std::string name = ent->d_name;
+            if (name != "." && name != "..") {
+                unlink((dir + "/" + name).c_str());
+            }
+        }
+        closedir(d);
+    }
+    rmdir(dir.c_str());
+}
+
+static std::string Key(int i) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "user%08d", i);
+    return buf;
+}
+
+static std::string Value(int i) {
+    return std::string(1, storage::kTagValue) + "value-" + std::to_string(i) + std::string(40, 'a' + i % 26);
+}
+
+// 写一个包含 Key(0..n) 中偶数 key 的表
+static std::shared_ptr<Table> BuildTable(const std::string& path, int n, const TableOptions& options) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    assert(fd >= 0);
+    TableBuilder builder(options, fd);
+    for (int i = 0; i < n; i += 2) assert(builder.Add(Key(i), Value(i)));
+    assert(builder.smallest() == Key(0));
+    assert(builder.NumEntries() == static_cast<uint64_t>((n + 1) / 2));
+    std::string error;
+    assert(builder.Finish(false, &error));
+    std::shared_ptr<Table> table = Table::Open(path, &error);
+    assert(table != nullptr);
+    return table;
+}
+
+static void TestBlock() {
+    std::cout << "[Test] block prefix encoding / seek... ";
+    BlockBuilder builder(4);
+    std::vector<std::string> keys;
+    for (int i = 0; i < 100; ++i) keys.push_back(Key(i * 3));
+    for (const auto& k : keys) builder.Add(k, "v" + k);
+    // 有共享前缀的 key：编码后远小于原始长度之和
+    std::string contents(builder.Finish());
+    assert(contents.size() < keys.size() * (keys[0].size() + 14));
+
+    BlockIter it(std::make_shared<const std::string>(contents));
+    size_t n = 0;
+    for (it.SeekToFirst(); it.Valid(); it.Next()) {
+        assert(it.key() == keys[n]);
+        assert(it.value() == "v" + keys[n]);
+        ++n;
+    }
+    assert(n == keys.size());
+    it.Seek(Key(31));  // 不存在：落到下一个 key
+    assert(it.Valid() && it.key() == Key(33));
+    it.Seek(Key(0));
+    assert(it.Valid() && it.key() == Key(0));
+    it.Seek(Key(297));
+    assert(it.Valid() && it.key() == Key(297));
+    it.Seek(Key(298));
+    assert(!it.Valid() && !it.corrupted());
+
+    // 截断的 block 被识别为损坏，而不是越界读
+    BlockIter bad(std::make_shared<const std::string>(contents.substr(0, 3)));
+    bad.SeekToFirst();
+    assert(!bad.Valid() && bad.corrupted());
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestTableGetAndIterate() {
+    std::cout << "[Test] table point lookups / iteration / compression... ";
+    std::string dir = MakeTempDir();
+    TableOptions options;
+    options.block_size = 1024;
+    std::shared_ptr<Table> table = BuildTable(dir + "/1.sst", 20000, options);
+
+    std::string value;
+    for (int i = 0; i < 20000; i += 2) {
+        assert(table->Get(Key(i), &value) == Table::Lookup::kFound);
+        assert(value == Value(i));
+    }
+    // 奇数 key 不存在：大多数被 bloom 过滤器直接排除
+    int filtered = 0;
+    for (int i = 1; i < 20000; i += 2) {
+        Table::Lookup r = table->Get(Key(i), &value);
+        assert(r == Table::Lookup::kFiltered || r == Table::Lookup::kNotFound);
+        if (r == Table::Lookup::kFiltered) ++filtered;
+    }
+    assert(filtered > 9800);  // 10 bit/key：误判率约 1%
+    assert(table->Get("zzz", &value) != Table::Lookup::kFound);
+
+    std::unique_ptr<KvIterator> it = table->NewIterator();
+    int expected = 0;
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        assert(it->key() == Key(expected));
+        expected += 2;
+    }
+    assert(expected == 20000 && !it->corrupted());
+    it->Seek(Key(10001));
+    assert(it->Valid() && it->key() == Key(10002));
+    it->Seek(Key(19999));
+    assert(!it->Valid());
+
+    // 同样的数据不压缩：压缩版明显更小 (value 里有大段重复字符)
+    TableOptions raw = options;
+    raw.compress = false;
+    std::shared_ptr<Table> uncompressed = BuildTable(dir + "/2.sst", 20000, raw);
+    assert(table->file_size() * 2 < uncompressed->file_size());
+    assert(uncompressed->Get(Key(500), &value) == Table::Lookup::kFound && value == Value(500));
+    RemoveDir(dir);
+    std::cout << "PASSED" << std::endl;
+}
+
+static void TestCorruption() {
+    std::cout << "[Test] checksum detects corruption... ";
+    std::string dir = MakeTempDir();
+    std::string path = dir + "/1.sst";
+    TableOptions options;
+    BuildTable(path, 2000, options);
+
+    // 改写第一个 data block 的一个字节
+    int fd = open(path.c_str(), O_RDWR);
+    assert(fd >= 0);
+    char c;
+    assert(pread(fd, &c, 1, 10) == 1);
+    c = static_cast<char>(c ^ 0x5A);
+    assert(pwrite(fd, &c, 1, 10) == 1);
+    close(fd);
+
+    std::shared_ptr<Table> table = Table::Open(path);
+    assert(table != nullptr);  // 索引与过滤器完好
+    std::string value;
+    assert(table->Get(Key(0), &value) == Table::Lookup::kCorruption);
+    std::unique_ptr<KvIterator> it = table->NewIterator();
+    it->SeekToFirst();
+    assert(!it->Valid() && it->corrupted());
+
+    // footer 损坏：打不开
+    fd = open(path.c_str(), O_RDWR);
+    struct stat st;
+    fstat(fd, &st);
+    assert(pwrite(fd, "XXXX", 4, st.st_size - 4) == 4);
+    close(fd);
+    std::string error;
+    assert(Table::Open(path, &error) == nullptr && !error.empty());
+    RemoveDir(dir);
+    std::cout << "PASSED" << std::endl;
+}
+
+// 测试用的内存迭代器
+class VectorIter : public KvIterator {
+public:
+    explicit VectorIter(std::map<std::string, std::string> kvs) : kvs_(std::move(kvs)), it_(kvs_.end()) {}
+    bool Valid() const override { return it_ != kvs_.end(); }
+    void SeekToFirst() override { it_ = kvs_.begin(); }
+    void Seek(std::string_view target) override { it_ = kvs_.lower_bound(std::string(target)); }
+    void Next() override { ++it_; }
+    std::string_view key() const override { return it_->first; }
+    std::string_view value() const override { return it_->second; }
+
+private:
+    std::map<std::string, std::string> kvs_;
+    std::map<std::string, std::string>::const_iterator it_;
+};
+
+static void TestMergingIterator() {
+    std::cout << "[Test] merging iterator precedence... ";
+    std::vector<std::unique_ptr<KvIterator>> children;
+    children.emplace_back(new VectorIter({{"b", "new-b"}, {"d", "new-d"}}));
+    children.emplace_back(new VectorIter({{"a", "old-a"}, {"b", "old-b"}, {"c", "old-c"}, {"d", "old-d"}}));
+    children.emplace_back(new VectorIter({}));
+    MergingIterator merged(std::move(children));
+
+    std::vector<std::pair<std::string, std::string>> out;
+    for (merged.SeekToFirst(); merged.Valid(); merged.Next()) {
+        out.emplace_back(std::string(merged.key()), std::string(merged.value()));
+    }
+    std::vector<std::pair<std::string, std::string>> expected = {
+        {"a", "old-a"}, {"b", "new-b"}, {"c", "old-c"}, {"d", "new-d"}};
+    assert(out == expected);
+    merged.Seek("bb");
+    assert(merged.Valid() && merged.key() == "c");
+    std::cout << "PASSED" << std::endl;
+}
+
+int main() {
+    TestBlock();
+    TestTableGetAndIterate();
+    TestCorruption();
+    TestMergingIterator();
+    std::cout << "All SSTable tests passed!" << std::endl;
+    return 0;
+}